@@ -0,0 +1,434 @@
+#include "BenchmarkSuite.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+// Distance between the roots of neighbouring parent chains
+#define BENCHMARK_ENTITY_SPACING 3.0f
+// Simulated seconds per frame, so poses don't depend on real time
+#define BENCHMARK_FRAME_TIME (1.0f / 60.0f)
+
+namespace {
+	const float PI = 3.14159265359f;
+
+	//Quotes a string for JSON
+	std::string JsonString(const std::string& value) {
+		std::string quoted = "\"";
+		for (char c : value) {
+			if (c == '"' || c == '\\') quoted += '\\';
+			quoted += c;
+		}
+		return quoted + "\"";
+	}
+
+	//Value at a fraction of the way through sorted values
+	float Percentile(const std::vector<float>& sorted, float fraction) {
+		if (sorted.empty()) return 0.0f;
+		size_t index = (size_t)std::ceil(fraction * sorted.size());
+		return sorted[(std::min)((std::max)(index, (size_t)1), sorted.size()) - 1];
+	}
+}
+
+BenchmarkSuite::BenchmarkSuite() :
+	sceneIndex(-1),
+	frame(0),
+	sceneLoaded(false) {
+}
+
+BenchmarkSuite::~BenchmarkSuite() {
+}
+
+void BenchmarkSuite::AddScene(const BenchmarkSceneDesc& scene) {
+	scenes.push_back(scene);
+}
+
+// --------------------------------------------------------
+// One scene per thing that tends to get slow: draw count,
+// material changes, lights, hierarchy depth and vertex count
+// --------------------------------------------------------
+void BenchmarkSuite::AddDefaultScenes() {
+	BenchmarkSceneDesc scene;
+
+	scene.Name = "Baseline";
+	AddScene(scene);
+
+	scene = BenchmarkSceneDesc();
+	scene.Name = "Many Entities";
+	scene.EntityCount = 2000;
+	scene.MeshCount = 4;
+	scene.MaterialCount = 4;
+	AddScene(scene);
+
+	scene = BenchmarkSceneDesc();
+	scene.Name = "Many Materials";
+	scene.EntityCount = 500;
+	scene.MeshCount = 4;
+	scene.MaterialCount = 64;
+	AddScene(scene);
+
+	scene = BenchmarkSceneDesc();
+	scene.Name = "Many Lights";
+	scene.EntityCount = 300;
+	scene.MeshCount = 2;
+	scene.MaterialCount = 2;
+	scene.LightCount = 1024;
+	AddScene(scene);
+
+	scene = BenchmarkSceneDesc();
+	scene.Name = "Deep Hierarchy";
+	scene.EntityCount = 1024;
+	scene.HierarchyDepth = 32;
+	AddScene(scene);
+
+	scene = BenchmarkSceneDesc();
+	scene.Name = "Large Meshes";
+	scene.EntityCount = 16;
+	scene.MeshCount = 2;
+	scene.MeshDetail = 256;
+	AddScene(scene);
+}
+
+void BenchmarkSuite::ClearScenes() {
+	Stop();
+	scenes.clear();
+}
+
+const std::vector<BenchmarkSceneDesc>& BenchmarkSuite::GetScenes() {
+	return scenes;
+}
+
+void BenchmarkSuite::Start() {
+	results.clear();
+	sceneIndex = scenes.empty() ? -1 : 0;
+	frame = 0;
+	sceneLoaded = false;
+}
+
+void BenchmarkSuite::Stop() {
+	//Keep what a scene cut short managed to measure
+	if (IsRunning() && frame > 0 && !results.empty()) Summarize(results.back());
+
+	sceneIndex = -1;
+	frame = 0;
+}
+
+bool BenchmarkSuite::IsRunning() {
+	return sceneIndex >= 0;
+}
+
+const BenchmarkSceneDesc* BenchmarkSuite::GetCurrentScene() {
+	return IsRunning() ? &scenes[sceneIndex] : 0;
+}
+
+bool BenchmarkSuite::IsSceneLoaded() {
+	return sceneLoaded;
+}
+
+int BenchmarkSuite::GetCurrentFrame() {
+	return frame;
+}
+
+bool BenchmarkSuite::IsWarmingUp() {
+	return IsRunning() && frame < scenes[sceneIndex].WarmupFrames;
+}
+
+void BenchmarkSuite::LoadScene(BenchmarkSceneData& data) {
+	const BenchmarkSceneDesc* scene = GetCurrentScene();
+	if (!scene) return;
+
+	int meshCount = (std::max)(scene->MeshCount, 1);
+	int materialCount = (std::max)(scene->MaterialCount, 1);
+
+	//Meshes step up in detail, so they aren't all the same size
+	data.Meshes.resize(meshCount);
+	for (int i = 0; i < meshCount; i++) {
+		int rings = (std::max)(scene->MeshDetail + i * scene->MeshDetail / 2, 3);
+		CreateSphere(rings, rings * 2, data.Meshes[i]);
+	}
+
+	//Materials only differ in their values, like a real scene's would
+	std::mt19937 random(5678);
+	std::uniform_real_distribution<float> color(0.3f, 1.0f);
+	std::uniform_real_distribution<float> roughness(0.05f, 1.0f);
+
+	data.Materials.resize(materialCount);
+	for (BenchmarkMaterialDesc& material : data.Materials) {
+		for (int c = 0; c < 3; c++) material.Color[c] = color(random);
+		material.Color[3] = 1.0f;
+		material.Roughness = roughness(random);
+	}
+
+	data.EntityMeshes.resize(scene->EntityCount);
+	data.EntityMaterials.resize(scene->EntityCount);
+	for (int i = 0; i < scene->EntityCount; i++) {
+		data.EntityMeshes[i] = i % meshCount;
+		data.EntityMaterials[i] = i % materialCount;
+	}
+
+	sceneLoaded = true;
+}
+
+void BenchmarkSuite::UnloadScene() {
+	sceneLoaded = false;
+}
+
+// --------------------------------------------------------
+// Orbits the middle of the scene once over the measured
+// frames, bobbing up and down
+// --------------------------------------------------------
+BenchmarkCameraPose BenchmarkSuite::PoseCamera() {
+	BenchmarkCameraPose pose = {};
+	const BenchmarkSceneDesc* scene = GetCurrentScene();
+	if (!scene) return pose;
+
+	int chains = (scene->EntityCount + (std::max)(scene->HierarchyDepth, 1) - 1) / (std::max)(scene->HierarchyDepth, 1);
+	float extent = std::ceil(std::sqrt((float)chains)) * BENCHMARK_ENTITY_SPACING * 0.5f;
+	float radius = extent + 6.0f;
+
+	float progress = (float)frame / (std::max)(scene->WarmupFrames + scene->FrameCount, 1);
+	float angle = progress * 2.0f * PI;
+
+	pose.Position[0] = std::sin(angle) * radius;
+	pose.Position[1] = radius * 0.4f + std::sin(angle * 3.0f) * radius * 0.1f;
+	pose.Position[2] = -std::cos(angle) * radius;
+
+	//Look at the middle of the scene
+	float direction[3] = { -pose.Position[0], 1.0f - pose.Position[1], -pose.Position[2] };
+	float length = std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+	pose.Pitch = -std::asin(direction[1] / length);
+	pose.Yaw = std::atan2(direction[0], direction[2]);
+	return pose;
+}
+
+// --------------------------------------------------------
+// Lays the chains' roots out on a grid, then walks down each
+// chain with every child orbiting its parent
+// --------------------------------------------------------
+void BenchmarkSuite::PoseEntities(std::vector<BenchmarkEntityPose>& poses) {
+	const BenchmarkSceneDesc* scene = GetCurrentScene();
+	if (!scene) return;
+
+	//Same size every frame, so only the first allocates
+	poses.resize(scene->EntityCount);
+
+	int depth = (std::max)(scene->HierarchyDepth, 1);
+	int chains = ((int)poses.size() + depth - 1) / depth;
+	int gridSize = (std::max)((int)std::ceil(std::sqrt((float)chains)), 1);
+	float time = frame * BENCHMARK_FRAME_TIME;
+
+	for (int chain = 0; chain < chains; chain++) {
+		float position[3] = {
+			(chain % gridSize - (gridSize - 1) * 0.5f) * BENCHMARK_ENTITY_SPACING,
+			0.5f,
+			(chain / gridSize - (gridSize - 1) * 0.5f) * BENCHMARK_ENTITY_SPACING };
+		float yaw = time + chain * 0.1f;
+		float scale = 1.0f;
+
+		for (int link = 0; link < depth; link++) {
+			size_t index = (size_t)chain * depth + link;
+			if (index >= poses.size()) break;
+
+			//Children sit on a shrinking orbit around their parent
+			if (link > 0) {
+				float orbit = scale * 1.2f;
+				scale *= 0.9f;
+				yaw += time * 0.5f + 0.3f;
+				position[0] += std::sin(yaw) * orbit;
+				position[1] += scale * 0.5f;
+				position[2] += std::cos(yaw) * orbit;
+			}
+
+			BenchmarkEntityPose& pose = poses[index];
+			for (int c = 0; c < 3; c++) pose.Position[c] = position[c];
+			pose.Yaw = yaw;
+			pose.Scale = scale;
+		}
+	}
+}
+
+bool BenchmarkSuite::EndFrame(const BenchmarkFrameSample& sample) {
+	const BenchmarkSceneDesc* scene = GetCurrentScene();
+	if (!scene) return false;
+
+	if (frame == 0) {
+		BenchmarkSceneResult result;
+		result.Scene = *scene;
+		results.push_back(result);
+	}
+
+	BenchmarkSceneResult& result = results.back();
+	if (frame >= scene->WarmupFrames) {
+		result.Samples.push_back(sample);
+		result.Samples.back().Frame = frame - scene->WarmupFrames;
+	}
+
+	frame++;
+	if (frame < scene->WarmupFrames + scene->FrameCount) return false;
+
+	//Scene's done, so on to the next one
+	Summarize(result);
+	frame = 0;
+	sceneLoaded = false;
+	sceneIndex++;
+	if (sceneIndex >= (int)scenes.size()) sceneIndex = -1;
+	return true;
+}
+
+void BenchmarkSuite::Summarize(BenchmarkSceneResult& result) {
+	if (result.Samples.empty()) return;
+
+	std::vector<float> frameTimes;
+	double frameTotal = 0.0, updateTotal = 0.0, drawTotal = 0.0;
+	double drawCalls = 0.0, stateChanges = 0.0;
+
+	for (const BenchmarkFrameSample& sample : result.Samples) {
+		frameTimes.push_back(sample.FrameMilliseconds);
+		frameTotal += sample.FrameMilliseconds;
+		updateTotal += sample.UpdateMilliseconds;
+		drawTotal += sample.DrawMilliseconds;
+		drawCalls += sample.Device.DrawCalls;
+		stateChanges += sample.Device.StateChanges;
+		result.PeakWorkingSetBytes = (std::max)(result.PeakWorkingSetBytes, sample.WorkingSetBytes);
+	}
+
+	std::sort(frameTimes.begin(), frameTimes.end());
+
+	double count = (double)result.Samples.size();
+	result.AverageFrameMilliseconds = (float)(frameTotal / count);
+	result.MedianFrameMilliseconds = Percentile(frameTimes, 0.5f);
+	result.P95FrameMilliseconds = Percentile(frameTimes, 0.95f);
+	result.P99FrameMilliseconds = Percentile(frameTimes, 0.99f);
+	result.MaxFrameMilliseconds = frameTimes.back();
+	result.AverageUpdateMilliseconds = (float)(updateTotal / count);
+	result.AverageDrawMilliseconds = (float)(drawTotal / count);
+	result.AverageDrawCalls = drawCalls / count;
+	result.AverageStateChanges = stateChanges / count;
+}
+
+const std::vector<BenchmarkSceneResult>& BenchmarkSuite::GetResults() {
+	return results;
+}
+
+// --------------------------------------------------------
+// Writes each scene's settings, summary and samples
+// --------------------------------------------------------
+bool BenchmarkSuite::WriteJson(std::ostream& file) {
+	file << "{\n  \"scenes\": [";
+	for (size_t i = 0; i < results.size(); i++) {
+		const BenchmarkSceneResult& result = results[i];
+		const BenchmarkSceneDesc& scene = result.Scene;
+
+		file << (i ? "," : "") << "\n    {\n";
+		file << "      \"name\": " << JsonString(scene.Name) << ",\n";
+		file << "      \"entities\": " << scene.EntityCount << ",\n";
+		file << "      \"meshes\": " << scene.MeshCount << ",\n";
+		file << "      \"materials\": " << scene.MaterialCount << ",\n";
+		file << "      \"lights\": " << scene.LightCount << ",\n";
+		file << "      \"hierarchyDepth\": " << scene.HierarchyDepth << ",\n";
+		file << "      \"meshDetail\": " << scene.MeshDetail << ",\n";
+		file << "      \"frames\": " << result.Samples.size() << ",\n";
+		file << "      \"summary\": {\n";
+		file << "        \"averageFrameMs\": " << result.AverageFrameMilliseconds << ",\n";
+		file << "        \"medianFrameMs\": " << result.MedianFrameMilliseconds << ",\n";
+		file << "        \"p95FrameMs\": " << result.P95FrameMilliseconds << ",\n";
+		file << "        \"p99FrameMs\": " << result.P99FrameMilliseconds << ",\n";
+		file << "        \"maxFrameMs\": " << result.MaxFrameMilliseconds << ",\n";
+		file << "        \"averageUpdateMs\": " << result.AverageUpdateMilliseconds << ",\n";
+		file << "        \"averageDrawMs\": " << result.AverageDrawMilliseconds << ",\n";
+		file << "        \"averageDrawCalls\": " << result.AverageDrawCalls << ",\n";
+		file << "        \"averageStateChanges\": " << result.AverageStateChanges << ",\n";
+		file << "        \"peakWorkingSetBytes\": " << result.PeakWorkingSetBytes << "\n";
+		file << "      },\n";
+		file << "      \"samples\": [";
+
+		for (size_t s = 0; s < result.Samples.size(); s++) {
+			const BenchmarkFrameSample& sample = result.Samples[s];
+			file << (s ? "," : "") << "\n        { "
+				<< "\"frame\": " << sample.Frame
+				<< ", \"frameMs\": " << sample.FrameMilliseconds
+				<< ", \"updateMs\": " << sample.UpdateMilliseconds
+				<< ", \"drawMs\": " << sample.DrawMilliseconds
+				<< ", \"drawCalls\": " << sample.Device.DrawCalls
+				<< ", \"primitives\": " << sample.Device.Primitives
+				<< ", \"stateChanges\": " << sample.Device.StateChanges
+				<< ", \"redundantStateChanges\": " << sample.Device.RedundantStateChanges
+				<< ", \"bufferUpdates\": " << sample.Device.BufferUpdates
+				<< ", \"bytesUploaded\": " << sample.Device.BytesUploaded
+				<< ", \"workingSetBytes\": " << sample.WorkingSetBytes
+				<< " }";
+		}
+
+		file << "\n      ]\n    }";
+	}
+	file << "\n  ]\n}\n";
+
+	return file.good();
+}
+
+// --------------------------------------------------------
+// Writes one row per measured frame, for spreadsheets
+// --------------------------------------------------------
+bool BenchmarkSuite::WriteCsv(std::ostream& file) {
+	file << "scene,frame,frame_ms,update_ms,draw_ms,draw_calls,primitives,state_changes,"
+		"redundant_state_changes,buffer_updates,bytes_uploaded,working_set_bytes\n";
+
+	for (const BenchmarkSceneResult& result : results) {
+		for (const BenchmarkFrameSample& sample : result.Samples) {
+			file << JsonString(result.Scene.Name) << ","
+				<< sample.Frame << ","
+				<< sample.FrameMilliseconds << ","
+				<< sample.UpdateMilliseconds << ","
+				<< sample.DrawMilliseconds << ","
+				<< sample.Device.DrawCalls << ","
+				<< sample.Device.Primitives << ","
+				<< sample.Device.StateChanges << ","
+				<< sample.Device.RedundantStateChanges << ","
+				<< sample.Device.BufferUpdates << ","
+				<< sample.Device.BytesUploaded << ","
+				<< sample.WorkingSetBytes << "\n";
+		}
+	}
+
+	return file.good();
+}
+
+void BenchmarkSuite::CreateSphere(int rings, int segments, BenchmarkMeshData& data) {
+	data.Positions.clear();
+	data.Normals.clear();
+	data.UVs.clear();
+	data.Indices.clear();
+
+	//A seam of duplicate vertices, so the UVs wrap cleanly
+	for (int ring = 0; ring <= rings; ring++) {
+		float theta = PI * ring / rings;
+		for (int segment = 0; segment <= segments; segment++) {
+			float phi = 2.0f * PI * segment / segments;
+
+			float normal[3] = { std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) };
+			for (int c = 0; c < 3; c++) {
+				data.Positions.push_back(normal[c] * 0.5f);
+				data.Normals.push_back(normal[c]);
+			}
+			data.UVs.push_back((float)segment / segments);
+			data.UVs.push_back((float)ring / rings);
+		}
+	}
+
+	//Clockwise from outside, to match the loaded meshes
+	unsigned int rowLength = segments + 1;
+	for (int ring = 0; ring < rings; ring++) {
+		for (int segment = 0; segment < segments; segment++) {
+			unsigned int topLeft = ring * rowLength + segment;
+			unsigned int bottomLeft = topLeft + rowLength;
+
+			data.Indices.push_back(topLeft);
+			data.Indices.push_back(topLeft + 1);
+			data.Indices.push_back(bottomLeft);
+
+			data.Indices.push_back(topLeft + 1);
+			data.Indices.push_back(bottomLeft + 1);
+			data.Indices.push_back(bottomLeft);
+		}
+	}
+}
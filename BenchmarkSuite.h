@@ -0,0 +1,174 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "RenderDevice.h"
+
+// --------------------------------------------------------
+// One procedurally generated benchmark scene
+// --------------------------------------------------------
+struct BenchmarkSceneDesc {
+	std::string Name;
+	int EntityCount = 100;
+	int MeshCount = 1;
+	int MaterialCount = 1;
+	int LightCount = 0;		// Random point and spot lights
+	int HierarchyDepth = 1;	// Entities in each parent chain, 1 for none
+	int MeshDetail = 16;	// Rings in each generated sphere
+	int WarmupFrames = 30;	// Run, but not measured
+	int FrameCount = 300;
+};
+
+// --------------------------------------------------------
+// Everything measured over one frame
+// --------------------------------------------------------
+struct BenchmarkFrameSample {
+	unsigned int Frame = 0;
+	float FrameMilliseconds = 0.0f;	// Start of one frame to the next
+	float UpdateMilliseconds = 0.0f;
+	float DrawMilliseconds = 0.0f;	// Includes the present
+	RenderDeviceStats Device;
+	uint64_t WorkingSetBytes = 0;
+};
+
+// --------------------------------------------------------
+// A scene's samples, and the summary of them
+// --------------------------------------------------------
+struct BenchmarkSceneResult {
+	BenchmarkSceneDesc Scene;
+	std::vector<BenchmarkFrameSample> Samples;
+	float AverageFrameMilliseconds = 0.0f;
+	float MedianFrameMilliseconds = 0.0f;
+	float P95FrameMilliseconds = 0.0f;
+	float P99FrameMilliseconds = 0.0f;
+	float MaxFrameMilliseconds = 0.0f;
+	float AverageUpdateMilliseconds = 0.0f;
+	float AverageDrawMilliseconds = 0.0f;
+	double AverageDrawCalls = 0.0;
+	double AverageStateChanges = 0.0;
+	uint64_t PeakWorkingSetBytes = 0;
+};
+
+// --------------------------------------------------------
+// Where one entity sits this frame
+// --------------------------------------------------------
+struct BenchmarkEntityPose {
+	float Position[3];
+	float Yaw;		// Radians around y
+	float Scale;	// Same on every axis
+};
+
+// --------------------------------------------------------
+// Where the camera sits this frame, looking at the scene
+// --------------------------------------------------------
+struct BenchmarkCameraPose {
+	float Position[3];
+	float Pitch;
+	float Yaw;
+};
+
+// --------------------------------------------------------
+// Vertices of a generated mesh as separate float streams,
+// three floats per position and normal and two per UV
+// --------------------------------------------------------
+struct BenchmarkMeshData {
+	std::vector<float> Positions;
+	std::vector<float> Normals;
+	std::vector<float> UVs;
+	std::vector<unsigned int> Indices;
+};
+
+// --------------------------------------------------------
+// Values for one copy of the template material
+// --------------------------------------------------------
+struct BenchmarkMaterialDesc {
+	float Color[4];
+	float Roughness;
+};
+
+// --------------------------------------------------------
+// Everything a scene's resources are built from
+// - Entity i uses mesh EntityMeshes[i] and material
+//    EntityMaterials[i]
+// --------------------------------------------------------
+struct BenchmarkSceneData {
+	std::vector<BenchmarkMeshData> Meshes;
+	std::vector<BenchmarkMaterialDesc> Materials;
+	std::vector<unsigned int> EntityMeshes;
+	std::vector<unsigned int> EntityMaterials;
+};
+
+// --------------------------------------------------------
+// Runs a list of generated scenes for a fixed number of
+// frames each, and writes what it measured as JSON and CSV
+//
+// - The game drives it: it builds each scene the suite asks
+//    for from the generated data, poses the camera and
+//    entities from the scripted path every frame, and hands
+//    back a sample per frame
+// - Knows nothing of the device, meshes or DirectXMath, so
+//    the same scenes run headless in the benchmark target
+// - Scenes are N entities over M sphere meshes and K copies
+//    of a template material, with lights, parent chains and
+//    mesh detail as knobs, all generated from fixed seeds so
+//    every run draws exactly the same thing
+// - Parent chains are posed each frame by walking down
+//    them, each child orbiting its parent, so deep chains
+//    cost what a hierarchy update would
+// --------------------------------------------------------
+class BenchmarkSuite {
+private:
+	std::vector<BenchmarkSceneDesc> scenes;
+	std::vector<BenchmarkSceneResult> results;
+
+	int sceneIndex;	// -1 when not running
+	int frame;		// Within the scene, including warmup
+	bool sceneLoaded;
+
+	static void Summarize(BenchmarkSceneResult& result);
+
+public:
+	BenchmarkSuite();
+	~BenchmarkSuite();
+
+	void AddScene(const BenchmarkSceneDesc& scene);
+	void AddDefaultScenes();
+	void ClearScenes();
+	const std::vector<BenchmarkSceneDesc>& GetScenes();
+
+	void Start();
+	void Stop();
+	bool IsRunning();
+
+	//The scene that should be showing, and whether it's been loaded
+	const BenchmarkSceneDesc* GetCurrentScene();
+	bool IsSceneLoaded();
+	int GetCurrentFrame();
+	bool IsWarmingUp();
+
+	//Generates the current scene's meshes, materials and
+	// entities, and marks it loaded
+	void LoadScene(BenchmarkSceneData& data);
+	void UnloadScene();
+
+	//Poses the camera and the scene's entities for the current frame
+	// - One pose per entity, parents before their children
+	BenchmarkCameraPose PoseCamera();
+	void PoseEntities(std::vector<BenchmarkEntityPose>& poses);
+
+	//Adds a sample for the current frame and moves on
+	// - Returns true when that finished the scene, which the
+	//    caller should then unload
+	bool EndFrame(const BenchmarkFrameSample& sample);
+
+	const std::vector<BenchmarkSceneResult>& GetResults();
+
+	bool WriteJson(std::ostream& stream);
+	bool WriteCsv(std::ostream& stream);
+
+	//UV sphere with the given number of rings and segments
+	static void CreateSphere(int rings, int segments, BenchmarkMeshData& data);
+};
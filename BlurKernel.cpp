@@ -0,0 +1,147 @@
+#include "BlurKernel.h"
+
+#include <cmath>
+
+BlurKernel::BlurKernel(BlurType type, int radius) : type(type), linearTapCount(0) {
+	//Clamp the radius to what the shaders can handle
+	this->radius = radius < 0 ? 0 : (radius > MAX_BLUR_RADIUS ? MAX_BLUR_RADIUS : radius);
+
+	CalculateWeights();
+	CalculateLinearTaps();
+}
+
+BlurKernel::~BlurKernel() {
+}
+
+// --------------------------------------------------------
+// Calculates the normalized weight of each pixel from the
+// center out to the radius
+// --------------------------------------------------------
+void BlurKernel::CalculateWeights() {
+	for (int i = 0; i <= MAX_BLUR_RADIUS; i++) {
+		weights[i] = 0.0f;
+	}
+
+	//Gaussian sigma chosen so the kernel fades out near the radius
+	float sigma = radius / 2.0f;
+	if (sigma < 0.5f) {
+		sigma = 0.5f;
+	}
+
+	float total = 0.0f;
+	for (int i = 0; i <= radius; i++) {
+		weights[i] = (type == BlurType::Box) ? 1.0f : expf(-(float)(i * i) / (2.0f * sigma * sigma));
+
+		//Every weight except the center is used on both sides
+		total += (i == 0) ? weights[i] : 2.0f * weights[i];
+	}
+
+	for (int i = 0; i <= radius; i++) {
+		weights[i] /= total;
+	}
+}
+
+// --------------------------------------------------------
+// Merges pairs of pixels into single bilinear taps
+//  - Two pixels at offsets i and i + 1 with weights w1 and w2
+//    are sampled once at the weighted average of the offsets
+//    with weight w1 + w2, letting the texture unit blend them
+//  - An odd pixel left at the end is sampled on its own
+// --------------------------------------------------------
+void BlurKernel::CalculateLinearTaps() {
+	linearTapCount = 0;
+
+	for (int i = 1; i <= radius; i += 2) {
+		float w1 = weights[i];
+		float w2 = (i + 1 <= radius) ? weights[i + 1] : 0.0f;
+		float weight = w1 + w2;
+
+		float offset = (weight > 0.0f) ? (i * w1 + (i + 1) * w2) / weight : (float)i;
+
+		linearTaps[linearTapCount][0] = offset;
+		linearTaps[linearTapCount][1] = weight;
+		linearTaps[linearTapCount][2] = 0.0f;
+		linearTaps[linearTapCount][3] = 0.0f;
+		linearTapCount++;
+	}
+
+	for (int i = linearTapCount; i < MAX_BLUR_TAPS; i++) {
+		for (int c = 0; c < 4; c++) {
+			linearTaps[i][c] = 0.0f;
+		}
+	}
+}
+
+BlurType BlurKernel::GetType() {
+	return type;
+}
+
+int BlurKernel::GetRadius() {
+	return radius;
+}
+
+// --------------------------------------------------------
+// Copies the discrete weights into the x component of a
+// float4 array, matching the constant buffer array layout
+// --------------------------------------------------------
+void BlurKernel::GetWeights(float* out) {
+	for (int i = 0; i <= MAX_BLUR_RADIUS; i++) {
+		out[i * 4 + 0] = weights[i];
+		out[i * 4 + 1] = 0.0f;
+		out[i * 4 + 2] = 0.0f;
+		out[i * 4 + 3] = 0.0f;
+	}
+}
+
+// --------------------------------------------------------
+// Weight of one pixel at that distance from the center,
+// on either side, or 0 beyond the radius
+// --------------------------------------------------------
+float BlurKernel::GetWeight(int distance) {
+	if (distance < 0) distance = -distance;
+	return distance <= radius ? weights[distance] : 0.0f;
+}
+
+float BlurKernel::GetCenterWeight() {
+	return weights[0];
+}
+
+int BlurKernel::GetLinearTapCount() {
+	return linearTapCount;
+}
+
+const float* BlurKernel::GetLinearTaps() {
+	return &linearTaps[0][0];
+}
+
+// --------------------------------------------------------
+// Declares what each blur pass reads and writes
+//  - The graph works out which intermediate targets can
+//    share a texture, so nothing here owns one
+// --------------------------------------------------------
+std::vector<PostProcessPassDesc> BlurKernel::DeclarePasses(bool compute) {
+	std::vector<PostProcessPassDesc> passes(compute ? 3 : 2);
+
+	//Horizontal pass into an intermediate target
+	passes[0].Name = BLUR_PASS_HORIZONTAL;
+	passes[0].Inputs = { POST_PROCESS_SCENE };
+	passes[0].Output = "BlurHorizontal";
+	passes[0].OutputDesc.UnorderedAccess = compute;
+	passes[0].Compute = compute;
+
+	//Vertical pass, into the back buffer when it can
+	passes[1].Name = BLUR_PASS_VERTICAL;
+	passes[1].Inputs = { "BlurHorizontal" };
+	passes[1].Output = compute ? "BlurVertical" : POST_PROCESS_BACK_BUFFER;
+	passes[1].OutputDesc.UnorderedAccess = compute;
+	passes[1].Compute = compute;
+
+	//Copy to the screen with an empty kernel
+	if (compute) {
+		passes[2].Name = BLUR_PASS_COPY;
+		passes[2].Inputs = { "BlurVertical" };
+		passes[2].Output = POST_PROCESS_BACK_BUFFER;
+	}
+
+	return passes;
+}
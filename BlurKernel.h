@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vector>
+
+#include "PostProcessSchedule.h"
+
+
+// Largest radius exposed in the inspector
+// - Must match MAX_BLUR_RADIUS in the blur shaders
+#define MAX_BLUR_RADIUS 10
+
+// Bilinear taps needed for the largest radius
+// - Must match MAX_BLUR_TAPS in PostProcessBlurPS.hlsl
+#define MAX_BLUR_TAPS ((MAX_BLUR_RADIUS + 1) / 2)
+
+// Names of the blur's passes in the post process graph
+#define BLUR_PASS_HORIZONTAL "Blur Horizontal"
+#define BLUR_PASS_VERTICAL "Blur Vertical"
+#define BLUR_PASS_COPY "Copy To Screen"
+
+enum class BlurType {
+	Box,
+	Gaussian
+};
+
+// --------------------------------------------------------
+// Weights for one direction of a separable blur
+//
+// - The discrete weights hold one weight per pixel from the
+//    center (index 0) out to the radius, and are used by the
+//    compute path, which reads texels from groupshared memory
+// - The linear taps merge each pair of neighbouring pixels
+//    into a single bilinear fetch between them, so the pixel
+//    shader path needs roughly half as many samples
+// - Everything is plain floats laid out like the constant
+//    buffers, so it builds without DirectXMath and can be
+//    checked against BlurReference anywhere
+// --------------------------------------------------------
+class BlurKernel {
+private:
+	BlurType type;
+	int radius;
+
+	float weights[MAX_BLUR_RADIUS + 1];
+
+	//Bilinear taps: x = offset in pixels, y = weight (z, w unused)
+	float linearTaps[MAX_BLUR_TAPS][4];
+	int linearTapCount;
+
+	void CalculateWeights();
+	void CalculateLinearTaps();
+
+public:
+	BlurKernel(BlurType type, int radius);
+	~BlurKernel();
+
+	BlurType GetType();
+	int GetRadius();
+
+	//Discrete weights, padded to float4s for a constant buffer,
+	//so out needs room for (MAX_BLUR_RADIUS + 1) * 4 floats
+	void GetWeights(float* out);
+	float GetWeight(int distance);
+
+	float GetCenterWeight();
+	int GetLinearTapCount();
+
+	//MAX_BLUR_TAPS float4s, with unused taps zeroed
+	const float* GetLinearTaps();
+
+	//The passes a blur of the scene into the back buffer runs
+	// - The compute path can't write to the back buffer, so it
+	//    blurs into textures and finishes with a copy pass
+	static std::vector<PostProcessPassDesc> DeclarePasses(bool compute);
+};
@@ -0,0 +1,121 @@
+#include "BlurReference.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Must match GROUP_SIZE in PostProcessBlurCS.hlsl
+#define BLUR_GROUP_SIZE 256
+
+// --------------------------------------------------------
+// Reads a pixel, clamping the coordinates to the image like
+// a clamp sampler or the compute shader's tile loads do
+// --------------------------------------------------------
+static float Load(const std::vector<float>& pixels, int width, int height, int x, int y) {
+	x = (std::min)((std::max)(x, 0), width - 1);
+	y = (std::min)((std::max)(y, 0), height - 1);
+	return pixels[y * width + x];
+}
+
+void BlurReference::Filter(BlurType type, int radius, const std::vector<float>& pixels, int width, int height, std::vector<float>& out) {
+	radius = (std::min)((std::max)(radius, 0), MAX_BLUR_RADIUS);
+
+	//Same sigma as BlurKernel, so the kernel fades out near the radius
+	float sigma = (std::max)(radius / 2.0f, 0.5f);
+
+	//Unnormalized weight of every pixel in the square
+	int size = 2 * radius + 1;
+	std::vector<double> weights(size * size);
+	double total = 0.0;
+	for (int y = -radius; y <= radius; y++) {
+		for (int x = -radius; x <= radius; x++) {
+			double weight = (type == BlurType::Box) ? 1.0 : std::exp(-(double)(x * x + y * y) / (2.0 * sigma * sigma));
+			weights[(y + radius) * size + x + radius] = weight;
+			total += weight;
+		}
+	}
+
+	out.resize(pixels.size());
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			double sum = 0.0;
+			for (int dy = -radius; dy <= radius; dy++) {
+				for (int dx = -radius; dx <= radius; dx++) {
+					sum += weights[(dy + radius) * size + dx + radius] * Load(pixels, width, height, x + dx, y + dy);
+				}
+			}
+			out[y * width + x] = (float)(sum / total);
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Bilinear fetch along one row or column, at a position in
+// pixels where whole numbers are pixel centers
+// --------------------------------------------------------
+static float SampleLinear(const std::vector<float>& pixels, int width, int height, int x, int y, bool horizontal, float offset) {
+	float position = (float)(horizontal ? x : y) + offset;
+	float base = std::floor(position);
+	float blend = position - base;
+
+	int first = (int)base;
+	float a = horizontal ? Load(pixels, width, height, first, y) : Load(pixels, width, height, x, first);
+	float b = horizontal ? Load(pixels, width, height, first + 1, y) : Load(pixels, width, height, x, first + 1);
+	return a + (b - a) * blend;
+}
+
+void BlurReference::PixelShaderPass(BlurKernel& kernel, const std::vector<float>& pixels, int width, int height, bool horizontal, std::vector<float>& out) {
+	const float* taps = kernel.GetLinearTaps();
+	int tapCount = kernel.GetLinearTapCount();
+	float centerWeight = kernel.GetCenterWeight();
+
+	out.resize(pixels.size());
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			float total = pixels[y * width + x] * centerWeight;
+
+			for (int i = 0; i < tapCount; i++) {
+				float offset = taps[i * 4 + 0];
+				float weight = taps[i * 4 + 1];
+
+				total += SampleLinear(pixels, width, height, x, y, horizontal, offset) * weight;
+				total += SampleLinear(pixels, width, height, x, y, horizontal, -offset) * weight;
+			}
+
+			out[y * width + x] = total;
+		}
+	}
+}
+
+void BlurReference::ComputePass(BlurKernel& kernel, const std::vector<float>& pixels, int width, int height, bool horizontal, std::vector<float>& out) {
+	float weights[(MAX_BLUR_RADIUS + 1) * 4];
+	kernel.GetWeights(weights);
+	int radius = kernel.GetRadius();
+
+	int lineLength = horizontal ? width : height;
+	int lineCount = horizontal ? height : width;
+	std::vector<float> tile(BLUR_GROUP_SIZE + 2 * MAX_BLUR_RADIUS);
+
+	out.resize(pixels.size());
+	for (int line = 0; line < lineCount; line++) {
+		for (int start = 0; start < lineLength; start += BLUR_GROUP_SIZE) {
+			//Load the tile, clamping at the edges of the texture
+			for (int i = 0; i < BLUR_GROUP_SIZE + 2 * radius; i++) {
+				int p = (std::min)((std::max)(start + i - radius, 0), lineLength - 1);
+				tile[i] = horizontal ? pixels[line * width + p] : pixels[p * width + line];
+			}
+
+			for (int thread = 0; thread < BLUR_GROUP_SIZE; thread++) {
+				int pixel = start + thread;
+				if (pixel >= lineLength) break;
+
+				int center = thread + radius;
+				float total = tile[center] * weights[0];
+				for (int r = 1; r <= radius; r++) {
+					total += (tile[center - r] + tile[center + r]) * weights[r * 4];
+				}
+
+				out[horizontal ? line * width + pixel : pixel * width + line] = total;
+			}
+		}
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+
+#include "BlurKernel.h"
+
+// --------------------------------------------------------
+// Plain C++ versions of the blurs, for checking the shaders'
+// kernels on the CPU
+//
+// - Images are one float per pixel, row by row, as the blur
+//    treats every channel the same way
+// - Filter() is the slow, obvious 2D filter, working the
+//    weights out itself, so it shares nothing with BlurKernel
+// - The pass functions do what PostProcessBlurPS.hlsl and
+//    PostProcessBlurCS.hlsl do with a BlurKernel, including
+//    the clamp sampler and the groupshared tile, so running
+//    a horizontal then a vertical pass should match Filter()
+// --------------------------------------------------------
+class BlurReference {
+public:
+	//Full (2r+1)^2 filter, clamping at the edges
+	static void Filter(BlurType type, int radius, const std::vector<float>& pixels, int width, int height, std::vector<float>& out);
+
+	//One direction of the pixel shader path, with bilinear taps
+	static void PixelShaderPass(BlurKernel& kernel, const std::vector<float>& pixels, int width, int height, bool horizontal, std::vector<float>& out);
+
+	//One direction of the compute path, a tile at a time
+	static void ComputePass(BlurKernel& kernel, const std::vector<float>& pixels, int width, int height, bool horizontal, std::vector<float>& out);
+};
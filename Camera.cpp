@@ -9,9 +9,11 @@ Camera::Camera(
 	float aspectRatio) : 
 	moveSpeed(moveSpeed),
 	rotationSpeed(rotationSpeed),
-	fieldOfView(fieldOfView) {
+	fieldOfView(fieldOfView),
+	nearPlane(0.01f),
+	farPlane(1000.0f) {
 
-	transform = std::make_shared<Transform>();
+	transform = Transform::GetPool().Create();
 
 	transform->SetPosition(x, y, z);
 	UpdateViewMatrix();
@@ -60,6 +62,20 @@ float Camera::GetFieldOfView() {
 	return fieldOfView;
 }
 
+// --------------------------------------------------------
+// Get the distance to the near clip plane
+// --------------------------------------------------------
+float Camera::GetNearPlane() {
+	return nearPlane;
+}
+
+// --------------------------------------------------------
+// Get the distance to the far clip plane
+// --------------------------------------------------------
+float Camera::GetFarPlane() {
+	return farPlane;
+}
+
 // --------------------------------------------------------
 // Update the camera
 // --------------------------------------------------------
@@ -111,6 +127,27 @@ void Camera::Update(float dt) {
 
 }
 
+// --------------------------------------------------------
+// Unprojects a screen point onto the near and far planes,
+// and gives the ray between them
+//  - The ray starts on the near plane, so nothing between it
+//     and the camera can be picked, same as it can't be seen
+// --------------------------------------------------------
+void Camera::GetRay(float screenX, float screenY, float screenWidth, float screenHeight, DirectX::XMFLOAT3& origin, DirectX::XMFLOAT3& direction) {
+	//Pixels to normalized device coordinates, with y up
+	float x = screenX / screenWidth * 2.0f - 1.0f;
+	float y = 1.0f - screenY / screenHeight * 2.0f;
+
+	DirectX::XMMATRIX viewProjection = DirectX::XMMatrixMultiply(DirectX::XMLoadFloat4x4(&viewMatrix), DirectX::XMLoadFloat4x4(&projectionMatrix));
+	DirectX::XMMATRIX inverse = DirectX::XMMatrixInverse(nullptr, viewProjection);
+
+	DirectX::XMVECTOR nearPoint = DirectX::XMVector3TransformCoord(DirectX::XMVectorSet(x, y, 0.0f, 1.0f), inverse);
+	DirectX::XMVECTOR farPoint = DirectX::XMVector3TransformCoord(DirectX::XMVectorSet(x, y, 1.0f, 1.0f), inverse);
+
+	DirectX::XMStoreFloat3(&origin, nearPoint);
+	DirectX::XMStoreFloat3(&direction, DirectX::XMVector3Normalize(DirectX::XMVectorSubtract(farPoint, nearPoint)));
+}
+
 // --------------------------------------------------------
 // Updates the View Matrix
 // --------------------------------------------------------
@@ -137,8 +174,8 @@ void Camera::UpdateProjectionMatrix(float aspectRatio) {
 	DirectX::XMMATRIX proj = DirectX::XMMatrixPerspectiveFovLH(
 		fieldOfView,
 		aspectRatio,
-		0.01f, //near plane
-		1000.0f); //far plane
+		nearPlane,
+		farPlane);
 
 	DirectX::XMStoreFloat4x4(&projectionMatrix, proj);
 
@@ -14,6 +14,8 @@ private:
 	float moveSpeed;
 	float rotationSpeed;
 	float fieldOfView;
+	float nearPlane;
+	float farPlane;
 
 public:
 	Camera(
@@ -29,6 +31,12 @@ public:
 	float GetMoveSpeed();
 	float GetRotationSpeed();
 	float GetFieldOfView();
+	float GetNearPlane();
+	float GetFarPlane();
+
+	//World space ray from the camera through a point on the
+	//screen, in pixels from its top left
+	void GetRay(float screenX, float screenY, float screenWidth, float screenHeight, DirectX::XMFLOAT3& origin, DirectX::XMFLOAT3& direction);
 
 	void Update(float dt);
 	void UpdateViewMatrix();
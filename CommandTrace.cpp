@@ -0,0 +1,118 @@
+#include "CommandTrace.h"
+
+#include <codecvt>
+#include <cstring>
+#include <locale>
+
+// Longest run EncodeDelta writes, in words
+#define COMMAND_TRACE_MAX_RUN 0xFFFF
+
+const char* CommandTrace::GetRecordName(RecordType type) {
+	switch (type) {
+	case RecordType::CreateBuffer: return "CreateBuffer";
+	case RecordType::CreateTexture: return "CreateTexture";
+	case RecordType::CreateShader: return "CreateShader";
+	case RecordType::CreateSampler: return "CreateSampler";
+	case RecordType::CreateRasterizerState: return "CreateRasterizerState";
+	case RecordType::CreateDepthStencilState: return "CreateDepthStencilState";
+	case RecordType::DestroyBuffer: return "DestroyBuffer";
+	case RecordType::DestroyTexture: return "DestroyTexture";
+	case RecordType::Command: return "Command";
+	case RecordType::InvalidateState: return "InvalidateState";
+	case RecordType::SimpleShader: return "SimpleShader";
+	case RecordType::SetSimpleShader: return "SetSimpleShader";
+	case RecordType::CopySimpleBuffer: return "CopySimpleBuffer";
+	case RecordType::FrameBegin: return "FrameBegin";
+	default: return "Unknown";
+	}
+}
+
+void CommandTrace::EncodeDelta(const uint8_t* previous, const uint8_t* current, uint32_t size, std::vector<uint8_t>& output) {
+	uint32_t words = size / 4;
+	uint32_t word = 0;
+
+	while (word < words) {
+		//Skip what hasn't changed
+		while (word < words && memcmp(previous + word * 4, current + word * 4, 4) == 0) word++;
+		if (word == words) break;
+
+		//Extend the run over what has
+		uint32_t start = word;
+		while (word < words && word - start < COMMAND_TRACE_MAX_RUN && memcmp(previous + word * 4, current + word * 4, 4) != 0) word++;
+
+		uint16_t header[2] = { (uint16_t)start, (uint16_t)(word - start) };
+		output.insert(output.end(), (const uint8_t*)header, (const uint8_t*)header + sizeof(header));
+		output.insert(output.end(), current + start * 4, current + word * 4);
+	}
+}
+
+bool CommandTrace::ApplyDelta(const uint8_t* encoded, size_t encodedSize, uint8_t* contents, uint32_t size) {
+	size_t read = 0;
+	while (read < encodedSize) {
+		if (encodedSize - read < 4) return false;
+
+		uint16_t header[2];
+		memcpy(header, encoded + read, sizeof(header));
+		read += sizeof(header);
+
+		size_t offset = (size_t)header[0] * 4;
+		size_t count = (size_t)header[1] * 4;
+		if (offset + count > size || encodedSize - read < count) return false;
+
+		memcpy(contents + offset, encoded + read, count);
+		read += count;
+	}
+
+	return true;
+}
+
+CommandTrace::BufferEncoding CommandTrace::EncodeBufferCopy(const std::vector<uint8_t>& last, const uint8_t* current, uint32_t size, std::vector<uint8_t>& output) {
+	size_t encodingOffset = output.size();
+	output.push_back((uint8_t)BufferEncoding::Delta);
+
+	size_t headerSize = output.size();
+	if (last.size() == size) {
+		EncodeDelta(last.data(), current, size, output);
+		if (output.size() - headerSize < size) return BufferEncoding::Delta;
+	}
+
+	//First copy, new size, or a delta that's no smaller
+	output.resize(headerSize);
+	output[encodingOffset] = (uint8_t)BufferEncoding::Full;
+	output.insert(output.end(), current, current + size);
+	return BufferEncoding::Full;
+}
+
+bool CommandTrace::DecodeBufferCopy(const uint8_t* encoded, size_t encodedSize, std::vector<uint8_t>& contents) {
+	if (encodedSize < 1) return false;
+
+	switch ((BufferEncoding)encoded[0]) {
+	case BufferEncoding::Full:
+		contents.assign(encoded + 1, encoded + encodedSize);
+		return true;
+	case BufferEncoding::Delta:
+		return !contents.empty() && ApplyDelta(encoded + 1, encodedSize - 1, contents.data(), (uint32_t)contents.size());
+	default:
+		return false;
+	}
+}
+
+#ifdef _MSC_VER
+void CommandTrace::OpenFile(std::ofstream& file, const std::wstring& path) {
+	file.open(path, std::ios::binary | std::ios::trunc);
+}
+
+void CommandTrace::OpenFile(std::ifstream& file, const std::wstring& path) {
+	file.open(path, std::ios::binary);
+}
+#else
+void CommandTrace::OpenFile(std::ofstream& file, const std::wstring& path) {
+	std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
+	file.open(converter.to_bytes(path), std::ios::binary | std::ios::trunc);
+}
+
+void CommandTrace::OpenFile(std::ifstream& file, const std::wstring& path) {
+	std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
+	file.open(converter.to_bytes(path), std::ios::binary);
+}
+#endif
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "RenderDevice.h"
+
+// "DXTR", the first four bytes of every trace
+#define COMMAND_TRACE_MAGIC 0x52545844
+// Bumped whenever a record's layout changes
+#define COMMAND_TRACE_VERSION 1
+
+// --------------------------------------------------------
+// Binary command trace format
+//
+// - A trace is the magic and version, then a stream of
+//    records: a type byte, a 32 bit payload size, and the
+//    payload, all little endian
+// - Descs and commands are written as their raw structs, so
+//    traces only replay on the build that wrote them
+// - Resource Ids are the capturing device's, and the
+//    replayer maps them to whatever its device hands out
+// --------------------------------------------------------
+namespace CommandTrace {
+	enum class RecordType : uint8_t {
+		//Creation records are all the Id, the desc's size, the
+		//desc, then the initial data's size and the data
+		CreateBuffer,			// BufferDesc
+		CreateTexture,			// TextureRecordDesc
+		CreateShader,			// ShaderStage, with the bytecode as data
+		CreateSampler,			// SamplerDesc
+		CreateRasterizerState,	// RasterizerDesc
+		CreateDepthStencilState,// DepthStencilDesc
+		DestroyBuffer,			// Id
+		DestroyTexture,			// Id
+		Command,				// RenderCommand, then the data for UpdateBuffer
+		InvalidateState,		// Nothing
+		SimpleShader,			// Id, stage, bytecode size, bytecode, buffer count, then size and slot per buffer
+		SetSimpleShader,		// Id
+		CopySimpleBuffer,		// Id, buffer index, encoding, encoded contents
+		FrameBegin,				// Frame number
+		Count
+	};
+
+	//Desc of a CreateTexture record
+	struct TextureRecordDesc {
+		TextureDesc Desc;
+		uint32_t RowPitch;
+	};
+
+	//How a constant buffer's contents were written
+	enum class BufferEncoding : uint8_t {
+		Full,	// Every byte
+		Delta	// Runs of changed words against the last copy
+	};
+
+	//Size of the type byte and payload size before each payload
+	const size_t RecordHeaderSize = 5;
+
+	const char* GetRecordName(RecordType type);
+
+	//Appends the changes from previous to current as runs of
+	//changed 32 bit words: a word offset, a word count, then
+	//the words, each count and offset as 16 bits
+	// - Size must be a multiple of 4, which cbuffers always are
+	void EncodeDelta(const uint8_t* previous, const uint8_t* current, uint32_t size, std::vector<uint8_t>& output);
+
+	//Applies runs from EncodeDelta on top of contents
+	// - Returns false if a run doesn't fit in size
+	bool ApplyDelta(const uint8_t* encoded, size_t encodedSize, uint8_t* contents, uint32_t size);
+
+	//Appends a constant buffer copy as its encoding byte and
+	//encoded contents, against the last copy of it
+	// - Full when there's no last copy, its size changed, or a
+	//    delta wouldn't be any smaller
+	BufferEncoding EncodeBufferCopy(const std::vector<uint8_t>& last, const uint8_t* current, uint32_t size, std::vector<uint8_t>& output);
+
+	//Turns what EncodeBufferCopy wrote back into the buffer's
+	//contents, on top of the last copy
+	// - Full copies take on their own size
+	// - Returns false for a damaged copy, or a delta with
+	//    nothing to apply to
+	bool DecodeBufferCopy(const uint8_t* encoded, size_t encodedSize, std::vector<uint8_t>& contents);
+
+	//Opens a trace file from a wide path
+	// - Only MSVC's streams take wide paths, so elsewhere it's
+	//    converted to UTF-8 first
+	void OpenFile(std::ofstream& file, const std::wstring& path);
+	void OpenFile(std::ifstream& file, const std::wstring& path);
+}
@@ -0,0 +1,234 @@
+#include "CommandTraceCapture.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace CommandTrace;
+
+CommandTraceCapture::CommandTraceCapture() :
+	nextShaderId(1),
+	pending(false),
+	capturing(false),
+	frameCount(0) {
+}
+
+CommandTraceCapture::~CommandTraceCapture() {
+	Stop();
+}
+
+uint64_t CommandTraceCapture::ResourceKey(RecordType type, uint32_t id) {
+	return (uint64_t)type << 32 | id;
+}
+
+// --------------------------------------------------------
+// Opens the file and writes the header, but records nothing
+// until the next frame begins, so the trace holds whole frames
+// --------------------------------------------------------
+bool CommandTraceCapture::Start(const std::wstring& path, int frameCount) {
+	Stop();
+
+	if (!writer.Open(path)) return false;
+
+	uint32_t header[2] = { COMMAND_TRACE_MAGIC, COMMAND_TRACE_VERSION };
+	writer.Write(header, sizeof(header));
+
+	this->frameCount = (std::max)(frameCount, 1);
+	captureThread = std::this_thread::get_id();
+	pending = true;
+	capturing = false;
+	stats = CommandTraceStats();
+
+	//Shaders are described again in every trace
+	shaders.clear();
+	nextShaderId = 1;
+
+	return true;
+}
+
+void CommandTraceCapture::Stop() {
+	pending = false;
+	capturing = false;
+	writer.Close();
+}
+
+bool CommandTraceCapture::IsCapturing() {
+	return capturing;
+}
+
+bool CommandTraceCapture::IsPending() {
+	return pending;
+}
+
+const CommandTraceStats& CommandTraceCapture::GetStats() {
+	return stats;
+}
+
+uint64_t CommandTraceCapture::GetBytesWritten() {
+	return writer.GetBytesWritten();
+}
+
+size_t CommandTraceCapture::GetPeakQueuedBlocks() {
+	return writer.GetPeakQueuedBlocks();
+}
+
+void CommandTraceCapture::WriteRecord(RecordType type, const void* data, size_t size) {
+	uint8_t header[RecordHeaderSize];
+	uint32_t payloadSize = (uint32_t)size;
+	header[0] = (uint8_t)type;
+	memcpy(header + 1, &payloadSize, sizeof(payloadSize));
+
+	writer.Write(header, sizeof(header));
+	writer.Write(data, size);
+	stats.Records++;
+}
+
+// --------------------------------------------------------
+// Finds a shader's trace entry, describing the shader in the
+// trace the first time it's seen
+// --------------------------------------------------------
+CommandTraceCapture::TracedShader* CommandTraceCapture::FindShader(ISimpleShader* shader) {
+	auto found = shaders.find(shader);
+	if (found != shaders.end()) return &found->second;
+
+	//Only the stages the render device has
+	ShaderStage stage;
+	if (dynamic_cast<SimpleVertexShader*>(shader)) stage = ShaderStage::Vertex;
+	else if (dynamic_cast<SimplePixelShader*>(shader)) stage = ShaderStage::Pixel;
+	else if (dynamic_cast<SimpleComputeShader*>(shader)) stage = ShaderStage::Compute;
+	else return 0;
+
+	TracedShader& traced = shaders[shader];
+	traced.Id = nextShaderId++;
+	traced.Stage = stage;
+	traced.LastContents.resize(shader->GetBufferCount());
+
+	Microsoft::WRL::ComPtr<ID3DBlob> blob = shader->GetShaderBlob();
+	uint32_t values[3] = { traced.Id, (uint32_t)stage, (uint32_t)blob->GetBufferSize() };
+
+	payload.clear();
+	payload.insert(payload.end(), (const uint8_t*)values, (const uint8_t*)values + sizeof(values));
+	payload.insert(payload.end(), (const uint8_t*)blob->GetBufferPointer(), (const uint8_t*)blob->GetBufferPointer() + blob->GetBufferSize());
+
+	uint32_t bufferCount = shader->GetBufferCount();
+	payload.insert(payload.end(), (const uint8_t*)&bufferCount, (const uint8_t*)&bufferCount + sizeof(bufferCount));
+	for (unsigned int i = 0; i < bufferCount; i++) {
+		const SimpleConstantBuffer* buffer = shader->GetBufferInfo(i);
+		uint32_t layout[2] = { buffer->Size, buffer->BindIndex };
+		payload.insert(payload.end(), (const uint8_t*)layout, (const uint8_t*)layout + sizeof(layout));
+	}
+
+	WriteRecord(RecordType::SimpleShader, payload.data(), payload.size());
+	return &traced;
+}
+
+void CommandTraceCapture::OnResourceCreated(RecordType type, uint32_t id, const void* desc, size_t descSize, const void* data, size_t dataSize) {
+	if (id == 0) return;
+
+	LiveResource& resource = liveResources[ResourceKey(type, id)];
+	resource.Type = type;
+
+	uint32_t descBytes = (uint32_t)descSize;
+	uint32_t dataBytes = data ? (uint32_t)dataSize : 0;
+
+	std::vector<uint8_t>& bytes = resource.Payload;
+	bytes.clear();
+	bytes.insert(bytes.end(), (const uint8_t*)&id, (const uint8_t*)&id + sizeof(id));
+	bytes.insert(bytes.end(), (const uint8_t*)&descBytes, (const uint8_t*)&descBytes + sizeof(descBytes));
+	bytes.insert(bytes.end(), (const uint8_t*)desc, (const uint8_t*)desc + descSize);
+	bytes.insert(bytes.end(), (const uint8_t*)&dataBytes, (const uint8_t*)&dataBytes + sizeof(dataBytes));
+	if (dataBytes) bytes.insert(bytes.end(), (const uint8_t*)data, (const uint8_t*)data + dataBytes);
+
+	if (capturing) WriteRecord(type, bytes.data(), bytes.size());
+}
+
+void CommandTraceCapture::OnResourceDestroyed(RecordType type, uint32_t id) {
+	RecordType createType = type == RecordType::DestroyTexture ? RecordType::CreateTexture : RecordType::CreateBuffer;
+	liveResources.erase(ResourceKey(createType, id));
+
+	if (capturing) WriteRecord(type, &id, sizeof(id));
+}
+
+void CommandTraceCapture::OnCommand(const RenderCommand& command, const void* data) {
+	if (!capturing) return;
+
+	payload.clear();
+	payload.insert(payload.end(), (const uint8_t*)&command, (const uint8_t*)&command + sizeof(command));
+	if (command.Type == RenderCommandType::UpdateBuffer && data) {
+		payload.insert(payload.end(), (const uint8_t*)data, (const uint8_t*)data + command.Count);
+	}
+
+	WriteRecord(RecordType::Command, payload.data(), payload.size());
+	stats.Commands++;
+}
+
+void CommandTraceCapture::OnInvalidateState() {
+	if (capturing) WriteRecord(RecordType::InvalidateState, 0, 0);
+}
+
+// --------------------------------------------------------
+// Frames are the unit of capture, so starting and stopping
+// both happen here
+// --------------------------------------------------------
+void CommandTraceCapture::OnFrameBegin() {
+	if (pending) {
+		pending = false;
+		capturing = true;
+
+		//Everything the frame's commands might refer to
+		for (auto& resource : liveResources) {
+			WriteRecord(resource.second.Type, resource.second.Payload.data(), resource.second.Payload.size());
+		}
+	}
+	else if (capturing && (int)stats.Frames >= frameCount) {
+		Stop();
+		return;
+	}
+
+	if (!capturing) return;
+
+	uint32_t frame = stats.Frames++;
+	WriteRecord(RecordType::FrameBegin, &frame, sizeof(frame));
+
+	//Keep the writer thread busy between big blocks
+	writer.Flush();
+}
+
+void CommandTraceCapture::OnShaderSet(ISimpleShader* shader) {
+	if (!capturing || std::this_thread::get_id() != captureThread) return;
+
+	TracedShader* traced = FindShader(shader);
+	if (traced) WriteRecord(RecordType::SetSimpleShader, &traced->Id, sizeof(traced->Id));
+}
+
+// --------------------------------------------------------
+// Writes a constant buffer copy, as a delta against the last
+// one when that's smaller
+// --------------------------------------------------------
+void CommandTraceCapture::OnBufferCopied(ISimpleShader* shader, unsigned int index) {
+	if (!capturing || std::this_thread::get_id() != captureThread) return;
+
+	TracedShader* traced = FindShader(shader);
+	if (!traced || index >= traced->LastContents.size()) return;
+
+	const SimpleConstantBuffer* buffer = shader->GetBufferInfo(index);
+	const uint8_t* contents = buffer->LocalDataBuffer;
+	std::vector<uint8_t>& last = traced->LastContents[index];
+
+	uint32_t values[2] = { traced->Id, index };
+	payload.clear();
+	payload.insert(payload.end(), (const uint8_t*)values, (const uint8_t*)values + sizeof(values));
+
+	//Everything after the encoding byte is the contents
+	size_t headerSize = payload.size() + 1;
+	if (EncodeBufferCopy(last, contents, buffer->Size, payload) == BufferEncoding::Delta) {
+		stats.DeltaBufferCopies++;
+		if (payload.size() == headerSize) stats.UnchangedBufferCopies++;
+	}
+
+	last.assign(contents, contents + buffer->Size);
+
+	WriteRecord(RecordType::CopySimpleBuffer, payload.data(), payload.size());
+	stats.BufferCopies++;
+	stats.BufferBytesRaw += buffer->Size;
+	stats.BufferBytesWritten += payload.size() - headerSize;
+}
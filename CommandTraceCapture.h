@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "CommandTrace.h"
+#include "TraceWriter.h"
+#include "RecordingRenderDevice.h"
+#include "SimpleShader.h"
+
+// --------------------------------------------------------
+// What a capture has written so far
+// --------------------------------------------------------
+struct CommandTraceStats {
+	unsigned int Frames = 0;
+	unsigned int Records = 0;
+	unsigned int Commands = 0;
+	unsigned int BufferCopies = 0;
+	unsigned int DeltaBufferCopies = 0;		// Copies written as deltas
+	unsigned int UnchangedBufferCopies = 0;	// Deltas with nothing in them
+	uint64_t BufferBytesRaw = 0;			// What full copies would have taken
+	uint64_t BufferBytesWritten = 0;
+};
+
+// --------------------------------------------------------
+// Captures everything a frame submits into a binary trace
+//
+// - Attached to the recording device, which reports each
+//    command, resource creation and destruction, and to
+//    SimpleShader, which reports shader sets and constant
+//    buffer copies
+// - Copies of every live resource's creation data are kept
+//    even when not capturing, so a trace started mid-run
+//    begins with everything its commands refer to
+// - Constant buffers are written as deltas against their
+//    last copy in the trace, which is usually a few words
+// - Records are streamed through a TraceWriter, so the disk
+//    is never waited on
+// - Only the thread that started the capture is recorded,
+//    so deferred draws on workers aren't in the trace
+// --------------------------------------------------------
+class CommandTraceCapture : public IRenderDeviceObserver, public ISimpleShaderObserver {
+private:
+	//Creation record of a resource that hasn't been destroyed
+	struct LiveResource {
+		CommandTrace::RecordType Type;
+		std::vector<uint8_t> Payload;
+	};
+
+	//A SimpleShader as the trace knows it
+	struct TracedShader {
+		uint32_t Id;
+		ShaderStage Stage;
+		std::vector<std::vector<uint8_t>> LastContents; // Per buffer, empty until first copied
+	};
+
+	std::unordered_map<uint64_t, LiveResource> liveResources; // Keyed by type and Id
+	std::unordered_map<ISimpleShader*, TracedShader> shaders;
+	uint32_t nextShaderId;
+
+	TraceWriter writer;
+	std::thread::id captureThread;
+	bool pending;		// Starts at the next frame
+	bool capturing;
+	int frameCount;
+
+	CommandTraceStats stats;
+
+	//Scratch space, kept to avoid allocating per record
+	std::vector<uint8_t> payload;
+
+	static uint64_t ResourceKey(CommandTrace::RecordType type, uint32_t id);
+
+	void WriteRecord(CommandTrace::RecordType type, const void* data, size_t size);
+	TracedShader* FindShader(ISimpleShader* shader);
+
+public:
+	CommandTraceCapture();
+	~CommandTraceCapture();
+
+	//Starts writing a trace at the next frame, for a number of frames
+	bool Start(const std::wstring& path, int frameCount);
+
+	//Stops early, closing the file
+	void Stop();
+
+	bool IsCapturing();
+	bool IsPending();
+	const CommandTraceStats& GetStats();
+	uint64_t GetBytesWritten();
+	size_t GetPeakQueuedBlocks();
+
+	//From the recording device
+	void OnResourceCreated(CommandTrace::RecordType type, uint32_t id, const void* desc, size_t descSize, const void* data, size_t dataSize) override;
+	void OnResourceDestroyed(CommandTrace::RecordType type, uint32_t id) override;
+	void OnCommand(const RenderCommand& command, const void* data) override;
+	void OnInvalidateState() override;
+	void OnFrameBegin() override;
+
+	//From SimpleShader
+	void OnShaderSet(ISimpleShader* shader) override;
+	void OnBufferCopied(ISimpleShader* shader, unsigned int index) override;
+};
@@ -0,0 +1,57 @@
+#include "D3D11GpuQueryBackend.h"
+
+D3D11GpuQueryBackend::D3D11GpuQueryBackend(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context) :
+	device(device),
+	context(context) {
+}
+
+D3D11GpuQueryBackend::~D3D11GpuQueryBackend() {
+}
+
+ID3D11Query* D3D11GpuQueryBackend::GetQuery(GpuQueryHandle query) {
+	Microsoft::WRL::ComPtr<ID3D11Query>* item = queries.Get(query.Id);
+	return item ? item->Get() : 0;
+}
+
+GpuQueryHandle D3D11GpuQueryBackend::CreateQuery(GpuQueryType type) {
+	D3D11_QUERY_DESC desc = {};
+	desc.Query = type == GpuQueryType::TimestampDisjoint ? D3D11_QUERY_TIMESTAMP_DISJOINT : D3D11_QUERY_TIMESTAMP;
+
+	Microsoft::WRL::ComPtr<ID3D11Query> query;
+	GpuQueryHandle handle;
+	if (SUCCEEDED(device->CreateQuery(&desc, query.GetAddressOf()))) {
+		handle.Id = queries.Add(query);
+	}
+	return handle;
+}
+
+void D3D11GpuQueryBackend::Begin(GpuQueryHandle query) {
+	if (ID3D11Query* q = GetQuery(query)) context->Begin(q);
+}
+
+void D3D11GpuQueryBackend::End(GpuQueryHandle query) {
+	if (ID3D11Query* q = GetQuery(query)) context->End(q);
+}
+
+bool D3D11GpuQueryBackend::GetTimestamp(GpuQueryHandle query, uint64_t& ticks) {
+	ID3D11Query* q = GetQuery(query);
+	UINT64 data = 0;
+	if (!q || context->GetData(q, &data, sizeof(data), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) {
+		return false;
+	}
+
+	ticks = data;
+	return true;
+}
+
+bool D3D11GpuQueryBackend::GetDisjoint(GpuQueryHandle query, uint64_t& frequency, bool& disjoint) {
+	ID3D11Query* q = GetQuery(query);
+	D3D11_QUERY_DATA_TIMESTAMP_DISJOINT data = {};
+	if (!q || context->GetData(q, &data, sizeof(data), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) {
+		return false;
+	}
+
+	frequency = data.Frequency;
+	disjoint = data.Disjoint != FALSE;
+	return true;
+}
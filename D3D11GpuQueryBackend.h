@@ -0,0 +1,33 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h> // Used for ComPtr - a smart pointer for COM objects
+
+#include "D3D11RenderDevice.h"
+#include "GpuQueryBackend.h"
+
+// --------------------------------------------------------
+// GPU queries on a D3D11 immediate context
+//  - Reads pass D3D11_ASYNC_GETDATA_DONOTFLUSH, so checking
+//     on a query never stalls or flushes the pipeline
+// --------------------------------------------------------
+class D3D11GpuQueryBackend : public GpuQueryBackend {
+private:
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+
+	D3D11HandleTable<Microsoft::WRL::ComPtr<ID3D11Query>> queries;
+
+	ID3D11Query* GetQuery(GpuQueryHandle query);
+
+public:
+	D3D11GpuQueryBackend(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context);
+	~D3D11GpuQueryBackend();
+
+	GpuQueryHandle CreateQuery(GpuQueryType type) override;
+	void Begin(GpuQueryHandle query) override;
+	void End(GpuQueryHandle query) override;
+
+	bool GetTimestamp(GpuQueryHandle query, uint64_t& ticks) override;
+	bool GetDisjoint(GpuQueryHandle query, uint64_t& frequency, bool& disjoint) override;
+};
@@ -0,0 +1,335 @@
+#include "D3D11RenderDevice.h"
+#include "Vertex.h"
+
+#include <cstring>
+
+using namespace Microsoft::WRL;
+
+// --------------------------------------------------------
+// Helpers for turning the device's enums into D3D11's
+// --------------------------------------------------------
+namespace {
+	DXGI_FORMAT ToDXGIFormat(TextureFormat format) {
+		switch (format) {
+		case TextureFormat::RGBA16F: return DXGI_FORMAT_R16G16B16A16_FLOAT;
+		case TextureFormat::R32F: return DXGI_FORMAT_R32_FLOAT;
+		default: return DXGI_FORMAT_R8G8B8A8_UNORM;
+		}
+	}
+
+	D3D11_COMPARISON_FUNC ToComparisonFunc(CompareFunc func) {
+		switch (func) {
+		case CompareFunc::Never: return D3D11_COMPARISON_NEVER;
+		case CompareFunc::Less: return D3D11_COMPARISON_LESS;
+		case CompareFunc::LessEqual: return D3D11_COMPARISON_LESS_EQUAL;
+		case CompareFunc::Equal: return D3D11_COMPARISON_EQUAL;
+		case CompareFunc::Greater: return D3D11_COMPARISON_GREATER;
+		default: return D3D11_COMPARISON_ALWAYS;
+		}
+	}
+
+	D3D11_PRIMITIVE_TOPOLOGY ToD3DTopology(PrimitiveTopology topology) {
+		switch (topology) {
+		case PrimitiveTopology::TriangleStrip: return D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP;
+		case PrimitiveTopology::LineList: return D3D11_PRIMITIVE_TOPOLOGY_LINELIST;
+		case PrimitiveTopology::PointList: return D3D11_PRIMITIVE_TOPOLOGY_POINTLIST;
+		default: return D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+		}
+	}
+}
+
+D3D11RenderDevice::D3D11RenderDevice(ComPtr<ID3D11Device> device, ComPtr<ID3D11DeviceContext> context) :
+	D3D11RenderDevice(device, context, std::make_shared<Resources>()) {
+}
+
+D3D11RenderDevice::D3D11RenderDevice(ComPtr<ID3D11Device> device, ComPtr<ID3D11DeviceContext> context, std::shared_ptr<Resources> resources) :
+	device(device),
+	context(context),
+	resources(resources) {
+}
+
+D3D11RenderDevice::~D3D11RenderDevice() {
+}
+
+// --------------------------------------------------------
+// Creates a vertex, index or constant buffer
+//  - Dynamic buffers can be written with UpdateBuffer()
+// --------------------------------------------------------
+BufferHandle D3D11RenderDevice::CreateBuffer(const BufferDesc& desc, const void* initialData) {
+	D3D11_BUFFER_DESC bufferDesc = {};
+	bufferDesc.ByteWidth = desc.ByteWidth;
+
+	switch (desc.Type) {
+	case BufferType::Vertex: bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER; break;
+	case BufferType::Index: bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER; break;
+	case BufferType::Constant:
+		bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		bufferDesc.ByteWidth = (desc.ByteWidth + 15) / 16 * 16; // Must be a multiple of 16
+		break;
+	}
+
+	if (desc.Usage == BufferUsage::Dynamic) {
+		bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+		bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	}
+	else {
+		bufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+	}
+
+	D3D11_SUBRESOURCE_DATA data = {};
+	data.pSysMem = initialData;
+
+	ComPtr<ID3D11Buffer> buffer;
+	device->CreateBuffer(&bufferDesc, initialData ? &data : 0, buffer.GetAddressOf());
+
+	BufferHandle handle;
+	if (buffer) handle.Id = resources->Buffers.Add(buffer);
+	return handle;
+}
+
+// --------------------------------------------------------
+// Creates a single mip texture that shaders can sample
+// --------------------------------------------------------
+TextureHandle D3D11RenderDevice::CreateTexture(const TextureDesc& desc, const void* initialData, unsigned int rowPitch) {
+	D3D11_TEXTURE2D_DESC textureDesc = {};
+	textureDesc.Width = desc.Width;
+	textureDesc.Height = desc.Height;
+	textureDesc.MipLevels = 1;
+	textureDesc.ArraySize = 1;
+	textureDesc.Format = ToDXGIFormat(desc.Format);
+	textureDesc.SampleDesc.Count = 1;
+	textureDesc.Usage = initialData ? D3D11_USAGE_IMMUTABLE : D3D11_USAGE_DEFAULT;
+	textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+	D3D11_SUBRESOURCE_DATA data = {};
+	data.pSysMem = initialData;
+	data.SysMemPitch = rowPitch;
+
+	ComPtr<ID3D11Texture2D> texture;
+	device->CreateTexture2D(&textureDesc, initialData ? &data : 0, texture.GetAddressOf());
+	if (!texture) return TextureHandle();
+
+	ComPtr<ID3D11ShaderResourceView> srv;
+	device->CreateShaderResourceView(texture.Get(), 0, srv.GetAddressOf());
+	return RegisterTexture(srv);
+}
+
+ShaderHandle D3D11RenderDevice::CreateShader(ShaderStage stage, const void* bytecode, size_t byteCount) {
+	D3D11Shader shader = {};
+	shader.Stage = stage;
+
+	HRESULT hr = E_FAIL;
+	switch (stage) {
+	case ShaderStage::Vertex:
+		hr = device->CreateVertexShader(bytecode, byteCount, 0, shader.VertexShader.GetAddressOf());
+		if (SUCCEEDED(hr)) {
+			//Shaders that don't read vertices (like full screen triangles)
+			//fail to match the layout, and just go without one
+			D3D11_INPUT_ELEMENT_DESC inputDesc[] = {
+				{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(Vertex, Position), D3D11_INPUT_PER_VERTEX_DATA, 0 },
+				{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(Vertex, Normal), D3D11_INPUT_PER_VERTEX_DATA, 0 },
+				{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, offsetof(Vertex, UV), D3D11_INPUT_PER_VERTEX_DATA, 0 },
+				{ "TANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(Vertex, Tangent), D3D11_INPUT_PER_VERTEX_DATA, 0 },
+			};
+			device->CreateInputLayout(inputDesc, ARRAYSIZE(inputDesc), bytecode, byteCount, shader.InputLayout.GetAddressOf());
+		}
+		break;
+	case ShaderStage::Pixel:
+		hr = device->CreatePixelShader(bytecode, byteCount, 0, shader.PixelShader.GetAddressOf());
+		break;
+	case ShaderStage::Compute:
+		hr = device->CreateComputeShader(bytecode, byteCount, 0, shader.ComputeShader.GetAddressOf());
+		break;
+	default:
+		break;
+	}
+
+	ShaderHandle handle;
+	if (SUCCEEDED(hr)) handle.Id = resources->Shaders.Add(shader);
+	return handle;
+}
+
+SamplerHandle D3D11RenderDevice::CreateSampler(const SamplerDesc& desc) {
+	D3D11_SAMPLER_DESC samplerDesc = {};
+	switch (desc.Filter) {
+	case FilterMode::Point: samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_POINT; break;
+	case FilterMode::Linear: samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR; break;
+	case FilterMode::Anisotropic: samplerDesc.Filter = D3D11_FILTER_ANISOTROPIC; break;
+	}
+
+	D3D11_TEXTURE_ADDRESS_MODE address = desc.Address == AddressMode::Clamp ? D3D11_TEXTURE_ADDRESS_CLAMP : D3D11_TEXTURE_ADDRESS_WRAP;
+	samplerDesc.AddressU = address;
+	samplerDesc.AddressV = address;
+	samplerDesc.AddressW = address;
+	samplerDesc.MaxAnisotropy = desc.MaxAnisotropy;
+	samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+
+	ComPtr<ID3D11SamplerState> sampler;
+	device->CreateSamplerState(&samplerDesc, sampler.GetAddressOf());
+	return RegisterSampler(sampler);
+}
+
+RasterizerHandle D3D11RenderDevice::CreateRasterizerState(const RasterizerDesc& desc) {
+	D3D11_RASTERIZER_DESC rasterizerDesc = {};
+	rasterizerDesc.FillMode = D3D11_FILL_SOLID;
+	switch (desc.Cull) {
+	case CullMode::None: rasterizerDesc.CullMode = D3D11_CULL_NONE; break;
+	case CullMode::Front: rasterizerDesc.CullMode = D3D11_CULL_FRONT; break;
+	case CullMode::Back: rasterizerDesc.CullMode = D3D11_CULL_BACK; break;
+	}
+	rasterizerDesc.DepthBias = desc.DepthBias;
+	rasterizerDesc.SlopeScaledDepthBias = desc.SlopeScaledDepthBias;
+	rasterizerDesc.DepthClipEnable = true;
+
+	ComPtr<ID3D11RasterizerState> state;
+	device->CreateRasterizerState(&rasterizerDesc, state.GetAddressOf());
+
+	RasterizerHandle handle;
+	if (state) handle.Id = resources->RasterizerStates.Add(state);
+	return handle;
+}
+
+DepthStencilHandle D3D11RenderDevice::CreateDepthStencilState(const DepthStencilDesc& desc) {
+	D3D11_DEPTH_STENCIL_DESC depthDesc = {};
+	depthDesc.DepthEnable = desc.DepthEnable;
+	depthDesc.DepthWriteMask = desc.DepthWrite ? D3D11_DEPTH_WRITE_MASK_ALL : D3D11_DEPTH_WRITE_MASK_ZERO;
+	depthDesc.DepthFunc = ToComparisonFunc(desc.Func);
+
+	ComPtr<ID3D11DepthStencilState> state;
+	device->CreateDepthStencilState(&depthDesc, state.GetAddressOf());
+
+	DepthStencilHandle handle;
+	if (state) handle.Id = resources->DepthStencilStates.Add(state);
+	return handle;
+}
+
+void D3D11RenderDevice::DestroyBuffer(BufferHandle buffer) {
+	resources->Buffers.Remove(buffer.Id);
+}
+
+void D3D11RenderDevice::DestroyTexture(TextureHandle texture) {
+	resources->Textures.Remove(texture.Id);
+}
+
+std::shared_ptr<D3D11RenderDevice> D3D11RenderDevice::CreateDeferred(ComPtr<ID3D11DeviceContext> deferredContext) {
+	return std::shared_ptr<D3D11RenderDevice>(new D3D11RenderDevice(device, deferredContext, resources));
+}
+
+TextureHandle D3D11RenderDevice::RegisterTexture(ComPtr<ID3D11ShaderResourceView> srv) {
+	TextureHandle handle;
+	if (srv) handle.Id = resources->Textures.Add(srv);
+	return handle;
+}
+
+SamplerHandle D3D11RenderDevice::RegisterSampler(ComPtr<ID3D11SamplerState> sampler) {
+	SamplerHandle handle;
+	if (sampler) handle.Id = resources->Samplers.Add(sampler);
+	return handle;
+}
+
+ID3D11Buffer* D3D11RenderDevice::GetBuffer(BufferHandle buffer) {
+	ComPtr<ID3D11Buffer>* found = resources->Buffers.Get(buffer.Id);
+	return found ? found->Get() : 0;
+}
+
+ID3D11ShaderResourceView* D3D11RenderDevice::GetTexture(TextureHandle texture) {
+	ComPtr<ID3D11ShaderResourceView>* found = resources->Textures.Get(texture.Id);
+	return found ? found->Get() : 0;
+}
+
+ComPtr<ID3D11DeviceContext> D3D11RenderDevice::GetContext() {
+	return context;
+}
+
+void D3D11RenderDevice::ApplyVertexBuffer(BufferHandle buffer, unsigned int stride) {
+	ID3D11Buffer* vertexBuffer = GetBuffer(buffer);
+	UINT offset = 0;
+	context->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
+}
+
+void D3D11RenderDevice::ApplyIndexBuffer(BufferHandle buffer) {
+	context->IASetIndexBuffer(GetBuffer(buffer), DXGI_FORMAT_R32_UINT, 0);
+}
+
+void D3D11RenderDevice::ApplyConstantBuffer(ShaderStage stage, unsigned int slot, BufferHandle buffer) {
+	ID3D11Buffer* constantBuffer = GetBuffer(buffer);
+	switch (stage) {
+	case ShaderStage::Vertex: context->VSSetConstantBuffers(slot, 1, &constantBuffer); break;
+	case ShaderStage::Pixel: context->PSSetConstantBuffers(slot, 1, &constantBuffer); break;
+	case ShaderStage::Compute: context->CSSetConstantBuffers(slot, 1, &constantBuffer); break;
+	default: break;
+	}
+}
+
+void D3D11RenderDevice::ApplyShader(ShaderStage stage, ShaderHandle shader) {
+	D3D11Shader* found = resources->Shaders.Get(shader.Id);
+
+	switch (stage) {
+	case ShaderStage::Vertex:
+		context->VSSetShader(found ? found->VertexShader.Get() : 0, 0, 0);
+		context->IASetInputLayout(found ? found->InputLayout.Get() : 0);
+		break;
+	case ShaderStage::Pixel:
+		context->PSSetShader(found ? found->PixelShader.Get() : 0, 0, 0);
+		break;
+	case ShaderStage::Compute:
+		context->CSSetShader(found ? found->ComputeShader.Get() : 0, 0, 0);
+		break;
+	default:
+		break;
+	}
+}
+
+void D3D11RenderDevice::ApplyTexture(ShaderStage stage, unsigned int slot, TextureHandle texture) {
+	ID3D11ShaderResourceView* srv = GetTexture(texture);
+	switch (stage) {
+	case ShaderStage::Vertex: context->VSSetShaderResources(slot, 1, &srv); break;
+	case ShaderStage::Pixel: context->PSSetShaderResources(slot, 1, &srv); break;
+	case ShaderStage::Compute: context->CSSetShaderResources(slot, 1, &srv); break;
+	default: break;
+	}
+}
+
+void D3D11RenderDevice::ApplySampler(ShaderStage stage, unsigned int slot, SamplerHandle sampler) {
+	ComPtr<ID3D11SamplerState>* found = resources->Samplers.Get(sampler.Id);
+	ID3D11SamplerState* samplerState = found ? found->Get() : 0;
+	switch (stage) {
+	case ShaderStage::Vertex: context->VSSetSamplers(slot, 1, &samplerState); break;
+	case ShaderStage::Pixel: context->PSSetSamplers(slot, 1, &samplerState); break;
+	case ShaderStage::Compute: context->CSSetSamplers(slot, 1, &samplerState); break;
+	default: break;
+	}
+}
+
+void D3D11RenderDevice::ApplyRasterizerState(RasterizerHandle state) {
+	ComPtr<ID3D11RasterizerState>* found = resources->RasterizerStates.Get(state.Id);
+	context->RSSetState(found ? found->Get() : 0);
+}
+
+void D3D11RenderDevice::ApplyDepthStencilState(DepthStencilHandle state) {
+	ComPtr<ID3D11DepthStencilState>* found = resources->DepthStencilStates.Get(state.Id);
+	context->OMSetDepthStencilState(found ? found->Get() : 0, 0);
+}
+
+void D3D11RenderDevice::ApplyTopology(PrimitiveTopology topology) {
+	context->IASetPrimitiveTopology(ToD3DTopology(topology));
+}
+
+void D3D11RenderDevice::ApplyUpdateBuffer(BufferHandle buffer, const void* data, unsigned int byteWidth) {
+	ID3D11Buffer* target = GetBuffer(buffer);
+	if (!target) return;
+
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	if (SUCCEEDED(context->Map(target, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+		memcpy(mapped.pData, data, byteWidth);
+		context->Unmap(target, 0);
+	}
+}
+
+void D3D11RenderDevice::ApplyDraw(unsigned int vertexCount, unsigned int startVertex) {
+	context->Draw(vertexCount, startVertex);
+}
+
+void D3D11RenderDevice::ApplyDrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex) {
+	context->DrawIndexed(indexCount, startIndex, baseVertex);
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h> // Used for ComPtr - a smart pointer for COM objects
+
+#include <memory>
+#include <vector>
+
+#include "RenderDevice.h"
+
+// --------------------------------------------------------
+// Maps handle Ids to API objects
+//  - Ids start at 1, and freed Ids are reused
+// --------------------------------------------------------
+template<typename T>
+class D3D11HandleTable {
+private:
+	std::vector<T> items;
+	std::vector<uint32_t> freeIds;
+
+public:
+	uint32_t Add(const T& item) {
+		if (!freeIds.empty()) {
+			uint32_t id = freeIds.back();
+			freeIds.pop_back();
+			items[id - 1] = item;
+			return id;
+		}
+
+		items.push_back(item);
+		return (uint32_t)items.size();
+	}
+
+	T* Get(uint32_t id) {
+		if (id == 0 || id > items.size()) return 0;
+		return &items[id - 1];
+	}
+
+	void Remove(uint32_t id) {
+		if (id == 0 || id > items.size()) return;
+		items[id - 1] = T();
+		freeIds.push_back(id);
+	}
+};
+
+// --------------------------------------------------------
+// Render device backed by a D3D11 device and context
+//
+// - Deferred devices made with CreateDeferred() share this
+//    device's resources, and record into their own context
+// - Vertex shaders get an input layout for the engine's
+//    Vertex struct
+// - Existing API objects can be registered to get handles,
+//    and handles can be turned back into API objects, for
+//    code that still talks to D3D11 directly
+// --------------------------------------------------------
+class D3D11RenderDevice : public RenderDevice {
+private:
+	struct D3D11Shader {
+		ShaderStage Stage;
+		Microsoft::WRL::ComPtr<ID3D11VertexShader> VertexShader;
+		Microsoft::WRL::ComPtr<ID3D11PixelShader> PixelShader;
+		Microsoft::WRL::ComPtr<ID3D11ComputeShader> ComputeShader;
+		Microsoft::WRL::ComPtr<ID3D11InputLayout> InputLayout;
+	};
+
+	//Shared between a device and its deferred devices
+	struct Resources {
+		D3D11HandleTable<Microsoft::WRL::ComPtr<ID3D11Buffer>> Buffers;
+		D3D11HandleTable<Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> Textures;
+		D3D11HandleTable<D3D11Shader> Shaders;
+		D3D11HandleTable<Microsoft::WRL::ComPtr<ID3D11SamplerState>> Samplers;
+		D3D11HandleTable<Microsoft::WRL::ComPtr<ID3D11RasterizerState>> RasterizerStates;
+		D3D11HandleTable<Microsoft::WRL::ComPtr<ID3D11DepthStencilState>> DepthStencilStates;
+	};
+
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+	std::shared_ptr<Resources> resources;
+
+	D3D11RenderDevice(
+		Microsoft::WRL::ComPtr<ID3D11Device> device,
+		Microsoft::WRL::ComPtr<ID3D11DeviceContext> context,
+		std::shared_ptr<Resources> resources);
+
+protected:
+	void ApplyVertexBuffer(BufferHandle buffer, unsigned int stride) override;
+	void ApplyIndexBuffer(BufferHandle buffer) override;
+	void ApplyConstantBuffer(ShaderStage stage, unsigned int slot, BufferHandle buffer) override;
+	void ApplyShader(ShaderStage stage, ShaderHandle shader) override;
+	void ApplyTexture(ShaderStage stage, unsigned int slot, TextureHandle texture) override;
+	void ApplySampler(ShaderStage stage, unsigned int slot, SamplerHandle sampler) override;
+	void ApplyRasterizerState(RasterizerHandle state) override;
+	void ApplyDepthStencilState(DepthStencilHandle state) override;
+	void ApplyTopology(PrimitiveTopology topology) override;
+	void ApplyUpdateBuffer(BufferHandle buffer, const void* data, unsigned int byteWidth) override;
+	void ApplyDraw(unsigned int vertexCount, unsigned int startVertex) override;
+	void ApplyDrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex) override;
+
+public:
+	D3D11RenderDevice(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context);
+	~D3D11RenderDevice();
+
+	//Resources
+	BufferHandle CreateBuffer(const BufferDesc& desc, const void* initialData) override;
+	TextureHandle CreateTexture(const TextureDesc& desc, const void* initialData, unsigned int rowPitch) override;
+	ShaderHandle CreateShader(ShaderStage stage, const void* bytecode, size_t byteCount) override;
+	SamplerHandle CreateSampler(const SamplerDesc& desc) override;
+	RasterizerHandle CreateRasterizerState(const RasterizerDesc& desc) override;
+	DepthStencilHandle CreateDepthStencilState(const DepthStencilDesc& desc) override;
+	void DestroyBuffer(BufferHandle buffer) override;
+	void DestroyTexture(TextureHandle texture) override;
+
+	//Makes a device that records into the given deferred context,
+	//sharing this device's resources
+	std::shared_ptr<D3D11RenderDevice> CreateDeferred(Microsoft::WRL::ComPtr<ID3D11DeviceContext> deferredContext);
+
+	//Interop with code that uses D3D11 directly
+	TextureHandle RegisterTexture(Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
+	SamplerHandle RegisterSampler(Microsoft::WRL::ComPtr<ID3D11SamplerState> sampler);
+	ID3D11Buffer* GetBuffer(BufferHandle buffer);
+	ID3D11ShaderResourceView* GetTexture(TextureHandle texture);
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> GetContext();
+};
@@ -1,5 +1,9 @@
 #include "DXCore.h"
 #include "Input.h"
+#include "Profiler.h"
+#include "JobSystem.h"
+#include "FrameArena.h"
+#include "MemoryTracker.h"
 
 #include <dxgi1_5.h>
 #include <WindowsX.h>
@@ -49,6 +53,11 @@ DXCore::DXCore(
 	vsync(vsync),
 	isFullscreen(false),
 	deviceSupportsTearing(false),
+	swapChainFlags(0),
+	framePacer(&frameClock),
+	frameLatencyWaitable(0),
+	waitForFrameLatency(true),
+	maxFrameLatency(2),
 	titleBarStats(debugTitleBarStats),
 	dxFeatureLevel(D3D_FEATURE_LEVEL_11_0),
 	fpsTimeElapsed(0),
@@ -85,6 +94,15 @@ DXCore::~DXCore()
 
 	// Delete input manager singleton
 	delete& Input::GetInstance();
+
+	// Stop the job system's workers
+	delete& JobSystem::GetInstance();
+
+	// Free the frame arena's block
+	delete& FrameArena::GetInstance();
+
+	if (frameLatencyWaitable)
+		CloseHandle(frameLatencyWaitable);
 }
 
 // --------------------------------------------------------
@@ -202,6 +220,11 @@ HRESULT DXCore::InitDirect3D()
 		deviceSupportsTearing = SUCCEEDED(featureCheck) && tearingSupported;
 	}
 
+	// The latency waitable object needs the flip model, which we always use
+	swapChainFlags = DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
+	if (deviceSupportsTearing)
+		swapChainFlags |= DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING;
+
 	// Create a description of how our swap
 	// chain should work
 	DXGI_SWAP_CHAIN_DESC swapDesc = {};
@@ -214,7 +237,7 @@ HRESULT DXCore::InitDirect3D()
 	swapDesc.BufferDesc.ScanlineOrdering = DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED;
 	swapDesc.BufferDesc.Scaling = DXGI_MODE_SCALING_UNSPECIFIED;
 	swapDesc.BufferUsage		= DXGI_USAGE_RENDER_TARGET_OUTPUT;
-	swapDesc.Flags				= deviceSupportsTearing ? DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING : 0;
+	swapDesc.Flags				= swapChainFlags;
 	swapDesc.OutputWindow		= hWnd;
 	swapDesc.SampleDesc.Count	= 1;
 	swapDesc.SampleDesc.Quality = 0;
@@ -240,6 +263,17 @@ HRESULT DXCore::InitDirect3D()
 		context.GetAddressOf());	// Pointer to our Device Context pointer
 	if (FAILED(hr)) return hr;
 
+	// Grab the frame latency waitable object and apply the latency cap
+	{
+		Microsoft::WRL::ComPtr<IDXGISwapChain2> swapChain2;
+		if (SUCCEEDED(swapChain.As(&swapChain2)))
+		{
+			frameLatencyWaitable = swapChain2->GetFrameLatencyWaitableObject();
+		}
+
+		SetMaximumFrameLatency(maxFrameLatency);
+	}
+
 	// Create the Render Target View for the back buffer render target
 	{
 		// The above function created the back buffer texture for us
@@ -333,7 +367,7 @@ void DXCore::OnResize()
 			windowWidth,
 			windowHeight,
 			DXGI_FORMAT_R8G8B8A8_UNORM,
-			deviceSupportsTearing ? DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING : 0);
+			swapChainFlags);
 	}
 
 	// A new back buffer requires a new Render Target View
@@ -412,6 +446,14 @@ HRESULT DXCore::Run()
 	currentTime = now;
 	previousTime = now;
 
+	// The main thread gets the first profiler timeline
+	Profiler& profiler = Profiler::GetInstance();
+	profiler.SetThreadName("Main Thread");
+
+	// Start the job system's workers, with this as the main thread
+	JobSystem& jobSystem = JobSystem::GetInstance();
+	jobSystem.Initialize();
+
 	// Give subclass a chance to initialize
 	Init();
 
@@ -429,6 +471,18 @@ HRESULT DXCore::Run()
 		}
 		else
 		{
+			profiler.BeginFrame();
+
+			// Hold the frame back to the frame rate limit, then until
+			// the swap chain has room for it
+			{
+				PROFILE_SCOPE("Frame Pacing");
+				framePacer.Wait();
+
+				if (waitForFrameLatency && frameLatencyWaitable)
+					WaitForSingleObjectEx(frameLatencyWaitable, 1000, TRUE);
+			}
+
 			// Update timer and title bar (if necessary)
 			UpdateTimer();
 			if(titleBarStats)
@@ -437,12 +491,32 @@ HRESULT DXCore::Run()
 			// Update the input manager
 			Input::GetInstance().Update();
 
+			// Run anything workers handed back to the main thread
+			jobSystem.RunMainThreadJobs();
+
+			// Catch the simulation up in fixed steps
+			unsigned int fixedSteps = fixedTimestep.Advance(deltaTime);
+			for (unsigned int i = 0; i < fixedSteps; i++)
+			{
+				float stepSeconds = (float)fixedTimestep.GetStepSeconds();
+				FixedUpdate(stepSeconds, (float)fixedTimestep.GetSimulationTime() + stepSeconds);
+				fixedTimestep.StepFinished();
+			}
+
 			// The game loop
 			Update(deltaTime, totalTime);
 			Draw(deltaTime, totalTime);
 
 			// Frame is over, notify the input manager
 			Input::GetInstance().EndOfFrame();
+
+			// Gather this frame's profiler zones from every thread
+			profiler.EndFrame();
+
+			// Nothing uses the frame's scratch memory any more, so
+			// free it and close out the frame's allocation counts
+			FrameArena::GetInstance().Reset();
+			MemoryTracker::EndFrame();
 		}
 	}
 
@@ -452,6 +526,40 @@ HRESULT DXCore::Run()
 }
 
 
+// --------------------------------------------------------
+// Sets how many frames can be queued up for the GPU at once
+//  - Lower means less input latency, but less overlap between
+//    the CPU and GPU
+// --------------------------------------------------------
+void DXCore::SetMaximumFrameLatency(unsigned int frameLatency)
+{
+	// DXGI allows 1 to 16
+	maxFrameLatency = max(1u, min(frameLatency, 16u));
+
+	// Waitable swap chains take the cap from the swap chain itself,
+	// and ignore the device's setting
+	Microsoft::WRL::ComPtr<IDXGISwapChain2> swapChain2;
+	if (frameLatencyWaitable && SUCCEEDED(swapChain.As(&swapChain2)))
+	{
+		swapChain2->SetMaximumFrameLatency(maxFrameLatency);
+		return;
+	}
+
+	Microsoft::WRL::ComPtr<IDXGIDevice1> dxgiDevice;
+	if (SUCCEEDED(device.As(&dxgiDevice)))
+		dxgiDevice->SetMaximumFrameLatency(maxFrameLatency);
+}
+
+
+// --------------------------------------------------------
+// Does nothing by default, for games that don't need a
+// fixed simulation rate
+// --------------------------------------------------------
+void DXCore::FixedUpdate(float deltaTime, float totalTime)
+{
+}
+
+
 // --------------------------------------------------------
 // Sends an OS-level window close message to our process, which
 // will be handled by our message processing function
@@ -506,6 +614,7 @@ void DXCore::UpdateTitleBarStats()
 	float mspf = 1000.0f / (float)fpsFrameCount;
 
 	// Quick and dirty title bar text (mostly for debugging)
+	MEMORY_TAG_SCOPE(MemoryTag::Tools);
 	std::wostringstream output;
 	output.precision(6);
 	output << titleBarText <<
@@ -5,6 +5,10 @@
 #include <string>
 #include <wrl/client.h> // Used for ComPtr - a smart pointer for COM objects
 
+#include "FixedTimestep.h"
+#include "FramePacer.h"
+#include "WaitableTimerClock.h"
+
 // We can include the correct library files here
 // instead of in Visual Studio settings if we want
 #pragma comment(lib, "d3d11.lib")
@@ -41,11 +45,18 @@ public:
 	void Quit();
 	virtual void OnResize();
 
+	// Caps how many frames the CPU can queue ahead of the GPU
+	void SetMaximumFrameLatency(unsigned int frameLatency);
+
 	// Pure virtual methods for setup and game functionality
 	virtual void Init() = 0;
 	virtual void Update(float deltaTime, float totalTime) = 0;
 	virtual void Draw(float deltaTime, float totalTime) = 0;
 
+	// Called with a constant delta time, as many times per frame
+	// as the fixed timestep needs (possibly zero)
+	virtual void FixedUpdate(float deltaTime, float totalTime);
+
 protected:
 	HINSTANCE		hInstance;		// The handle to the application
 	HWND			hWnd;			// The handle to the window itself
@@ -65,6 +76,7 @@ protected:
 	bool vsync;
 	bool deviceSupportsTearing;
 	BOOL isFullscreen; // Due to alt+enter key combination (must be BOOL typedef)
+	UINT swapChainFlags; // Must match between creation and every resize
 
 	// DirectX related objects and variables
 	D3D_FEATURE_LEVEL		dxFeatureLevel;
@@ -75,6 +87,20 @@ protected:
 	Microsoft::WRL::ComPtr<ID3D11RenderTargetView> backBufferRTV;
 	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> depthBufferDSV;
 
+	// Splits each frame's time into fixed simulation steps
+	FixedTimestep fixedTimestep;
+
+	// Frame rate limiter (the clock must be declared first)
+	WaitableTimerClock frameClock;
+	FramePacer framePacer;
+
+	// Signaled by the swap chain when it can take another frame
+	//  - Waiting on it before the frame starts (instead of blocking
+	//    in Present) keeps input sampled as late as possible
+	HANDLE frameLatencyWaitable;
+	bool waitForFrameLatency;
+	unsigned int maxFrameLatency;
+
 	// Helper function for allocating a console window
 	void CreateConsoleWindow(int bufferLines, int bufferColumns, int windowLines, int windowColumns);
 
@@ -0,0 +1,25 @@
+#include "DrawPartition.h"
+
+#include <algorithm>
+
+// --------------------------------------------------------
+// Splits the draws into even contiguous ranges
+//  - Earlier ranges take the remainder, one draw each
+// --------------------------------------------------------
+void DrawPartition::Split(size_t drawCount, unsigned int rangeCount, std::vector<DrawRange>& ranges, size_t minDraws) {
+	ranges.clear();
+	if (drawCount == 0 || rangeCount == 0) {
+		return;
+	}
+
+	size_t count = (std::min)((size_t)rangeCount, (std::max)(drawCount / (std::max)(minDraws, (size_t)1), (size_t)1));
+	size_t perRange = drawCount / count;
+	size_t remainder = drawCount % count;
+
+	size_t begin = 0;
+	for (size_t i = 0; i < count; i++) {
+		size_t end = begin + perRange + (i < remainder ? 1 : 0);
+		ranges.push_back({ begin, end });
+		begin = end;
+	}
+}
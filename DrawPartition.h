@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Fewest draws worth giving a deferred context of its own
+#define PARALLEL_DRAW_MIN_DRAWS 16
+
+// A contiguous run of draws, [Begin, End)
+struct DrawRange {
+	size_t Begin;
+	size_t End;
+};
+
+// --------------------------------------------------------
+// Splits a frame's draw list into ranges for recording on
+// several threads at once
+//  - Fills a vector the caller keeps, so once it's grown to
+//     the most ranges a frame needs it never allocates
+//  - Doesn't need a device, so it can be tested anywhere
+// --------------------------------------------------------
+class DrawPartition {
+public:
+	//Splits drawCount draws into at most rangeCount contiguous
+	//ranges of at least minDraws each (except when there are
+	//fewer draws than that in total)
+	static void Split(size_t drawCount, unsigned int rangeCount, std::vector<DrawRange>& ranges, size_t minDraws = PARALLEL_DRAW_MIN_DRAWS);
+};
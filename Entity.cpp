@@ -1,12 +1,20 @@
 #include "Entity.h"
 
 Entity::Entity(std::shared_ptr<Mesh> mesh, std::shared_ptr<Material> mat) : mesh(mesh), material(mat) {
-    transform = std::make_shared<Transform>();
+    transform = Transform::GetPool().Create();
 }
 
 Entity::~Entity() {
 }
 
+// --------------------------------------------------------
+// Gets the pool entities are created from
+// --------------------------------------------------------
+ObjectPool<Entity>& Entity::GetPool() {
+	static ObjectPool<Entity> pool(MemoryTag::Entities);
+	return pool;
+}
+
 // --------------------------------------------------------
 // Update the Constant Buffer
 // --------------------------------------------------------
@@ -19,16 +27,15 @@ void Entity::UpdateConstantBuffer(
 	std::shared_ptr<SimpleVertexShader> vs = material->GetVertexShader();
 
 	//vs->SetFloat4("colorTint", material->GetColorTint());
-	vs->SetMatrix4x4("world", transform->GetWorldMatrix());
+	vs->SetMatrix4x4("world", transform->GetRenderWorldMatrix());
 	vs->SetMatrix4x4("view", camera->GetView());
 	vs->SetMatrix4x4("projection", camera->GetProjection());
-	vs->SetMatrix4x4("worldInvTranspose", transform->GetWorldInverseTransposeMatrix());
+	vs->SetMatrix4x4("worldInvTranspose", transform->GetRenderWorldInverseTransposeMatrix());
 
 	std::shared_ptr<SimplePixelShader> ps = material->GetPixelShader();
 
-	ps->SetFloat4("colorTint", material->GetColorTint());
+	//Tint and roughness are already in, from PrepareMaterial()
 	ps->SetFloat("time", totalTime);
-	ps->SetFloat("roughness", material->GetRoughness());
 	ps->SetFloat3("cameraPosition", camera->GetTransform()->GetPosition());
 
 	//Write data to constant buffer
@@ -64,6 +71,30 @@ void Entity::SetMaterial(std::shared_ptr<Material> mat) {
 	material = mat;
 }
 
+// --------------------------------------------------------
+// Gets the mesh's bounds transformed into world space
+//  - Uses the interpolated matrix, so it matches what's drawn
+// --------------------------------------------------------
+DirectX::BoundingBox Entity::GetWorldBounds() {
+	DirectX::XMFLOAT4X4 world = transform->GetRenderWorldMatrix();
+
+	DirectX::BoundingBox worldBounds;
+	mesh->GetBounds().Transform(worldBounds, DirectX::XMLoadFloat4x4(&world));
+	return worldBounds;
+}
+
+// --------------------------------------------------------
+// Whether the entity is static lives on its transform, which
+// counts any changes made to it while it is
+// --------------------------------------------------------
+bool Entity::IsStatic() {
+	return transform->IsStatic();
+}
+
+void Entity::SetStatic(bool isStatic) {
+	transform->SetStatic(isStatic);
+}
+
 // --------------------------------------------------------
 // Updates the constant buffer and then draws the mesh
 // --------------------------------------------------------
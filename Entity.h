@@ -7,6 +7,7 @@
 #include "Mesh.h"
 #include "Camera.h"
 #include "Material.h"
+#include "ObjectPool.h"
 
 class Entity {
 private:
@@ -26,13 +27,19 @@ public:
 	Entity(std::shared_ptr<Mesh> mesh, std::shared_ptr<Material> mat);
 	~Entity();
 
+	//Pool every entity should be created from
+	static ObjectPool<Entity>& GetPool();
+
 	//Getters
 	std::shared_ptr<Mesh> GetMesh();
 	std::shared_ptr<Transform> GetTransform();
 	std::shared_ptr<Material> GetMaterial();
+	DirectX::BoundingBox GetWorldBounds();
+	bool IsStatic(); // Static entities shouldn't move, so their shadows can be cached
 
 	//Setters
 	void SetMaterial(std::shared_ptr<Material> mat);
+	void SetStatic(bool isStatic);
 
 	//Draw
 	void Draw(
@@ -0,0 +1,77 @@
+#include "FixedTimestep.h"
+
+#include <algorithm>
+#include <cmath>
+
+FixedTimestep::FixedTimestep(double stepSeconds, unsigned int maxSteps) :
+	accumulator(0.0),
+	simulationTime(0.0),
+	lastStepCount(0),
+	droppedSeconds(0.0) {
+	//Through the setters, so they're clamped the same way
+	SetStepSeconds(stepSeconds);
+	SetMaxSteps(maxSteps);
+}
+
+FixedTimestep::~FixedTimestep() {
+}
+
+// --------------------------------------------------------
+// Banks the frame's time and works out the steps it covers
+//  - Anything past maxSteps is thrown away, keeping only
+//    the partial step so interpolation stays smooth
+// --------------------------------------------------------
+unsigned int FixedTimestep::Advance(double deltaSeconds) {
+	accumulator += (std::max)(deltaSeconds, 0.0);
+
+	unsigned int steps = (unsigned int)std::floor(accumulator / stepSeconds);
+
+	if (steps > maxSteps) {
+		double excess = accumulator - maxSteps * stepSeconds;
+		double kept = std::fmod(excess, stepSeconds);
+
+		droppedSeconds += excess - kept;
+		accumulator = maxSteps * stepSeconds + kept;
+		steps = maxSteps;
+	}
+
+	lastStepCount = steps;
+	return steps;
+}
+
+void FixedTimestep::StepFinished() {
+	accumulator -= stepSeconds;
+	simulationTime += stepSeconds;
+}
+
+float FixedTimestep::GetAlpha() {
+	return (float)(std::min)((std::max)(accumulator / stepSeconds, 0.0), 1.0);
+}
+
+double FixedTimestep::GetStepSeconds() {
+	return stepSeconds;
+}
+
+void FixedTimestep::SetStepSeconds(double stepSeconds) {
+	this->stepSeconds = (std::max)(stepSeconds, 0.0001);
+}
+
+unsigned int FixedTimestep::GetMaxSteps() {
+	return maxSteps;
+}
+
+void FixedTimestep::SetMaxSteps(unsigned int maxSteps) {
+	this->maxSteps = (std::max)(maxSteps, 1u);
+}
+
+double FixedTimestep::GetSimulationTime() {
+	return simulationTime;
+}
+
+unsigned int FixedTimestep::GetLastStepCount() {
+	return lastStepCount;
+}
+
+double FixedTimestep::GetDroppedSeconds() {
+	return droppedSeconds;
+}
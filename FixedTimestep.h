@@ -0,0 +1,51 @@
+#pragma once
+
+// --------------------------------------------------------
+// Turns variable frame times into a whole number of fixed
+// simulation steps
+//
+// - Leftover time carries over in an accumulator, and the
+//    fraction of a step left over is the alpha used to
+//    interpolate between the last two simulation states
+// - After a long hitch, only maxSteps are run and the rest
+//    of the time is dropped, so a slow step can't snowball
+//    into ever more steps per frame
+// - Only does arithmetic on the times it's given, so it can
+//    be driven by any clock
+// --------------------------------------------------------
+class FixedTimestep {
+private:
+	double stepSeconds;
+	unsigned int maxSteps;
+	double accumulator;
+	double simulationTime;
+
+	//Stats
+	unsigned int lastStepCount;
+	double droppedSeconds;
+
+public:
+	FixedTimestep(double stepSeconds = 1.0 / 60.0, unsigned int maxSteps = 5);
+	~FixedTimestep();
+
+	//Adds a frame's time and returns how many steps to run
+	unsigned int Advance(double deltaSeconds);
+
+	//Call after running each step
+	void StepFinished();
+
+	//How far between the previous and latest step the frame is, 0 to 1
+	float GetAlpha();
+
+	double GetStepSeconds();
+	void SetStepSeconds(double stepSeconds);
+	unsigned int GetMaxSteps();
+	void SetMaxSteps(unsigned int maxSteps);
+
+	//Total time simulated so far
+	double GetSimulationTime();
+
+	//Stats
+	unsigned int GetLastStepCount();
+	double GetDroppedSeconds();
+};
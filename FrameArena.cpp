@@ -0,0 +1,101 @@
+#include "FrameArena.h"
+#include "MemoryTracker.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+// Singleton requirement
+FrameArena* FrameArena::instance;
+
+FrameArena::FrameArena() :
+	capacity(FRAME_ARENA_INITIAL_CAPACITY),
+	offset(0),
+	overflowBytes(0),
+	lastFrameBytes(0),
+	peakBytes(0),
+	growCount(0) {
+	MEMORY_TAG_SCOPE(MemoryTag::Frame);
+	memory = (uint8_t*)MemoryTracker::Allocate(capacity);
+	overflow.reserve(64);
+}
+
+FrameArena::~FrameArena() {
+	Reset();
+	MemoryTracker::Free(memory);
+}
+
+// --------------------------------------------------------
+// Bumps the offset past the allocation
+//  - Alignment must be a power of 2
+// --------------------------------------------------------
+void* FrameArena::Allocate(size_t size, size_t alignment) {
+	size = (std::max)(size, (size_t)1);
+
+	//Claim enough for the worst case padding, so the claim
+	//is a single atomic add
+	size_t claimed = size + alignment - 1;
+	size_t start = offset.fetch_add(claimed, std::memory_order_relaxed);
+
+	if (start + claimed <= capacity) {
+		uintptr_t address = (uintptr_t)(memory + start);
+		return (void*)((address + alignment - 1) & ~(uintptr_t)(alignment - 1));
+	}
+
+	//Out of room, so this one comes from the heap
+	MEMORY_TAG_SCOPE(MemoryTag::Frame);
+	uint8_t* spilled = (uint8_t*)MemoryTracker::Allocate(claimed);
+
+	std::lock_guard<std::mutex> lock(overflowMutex);
+	overflow.push_back(spilled);
+	overflowBytes += claimed;
+
+	uintptr_t address = (uintptr_t)spilled;
+	return (void*)((address + alignment - 1) & ~(uintptr_t)(alignment - 1));
+}
+
+// --------------------------------------------------------
+// Frees the frame's memory, and grows the block if the frame
+// needed more than it had
+// --------------------------------------------------------
+void FrameArena::Reset() {
+	size_t used = (std::min)(offset.load(std::memory_order_relaxed), capacity);
+	lastFrameBytes = used + overflowBytes;
+	peakBytes = (std::max)(peakBytes, lastFrameBytes);
+
+	if (!overflow.empty()) {
+		for (void* spilled : overflow) {
+			MemoryTracker::Free(spilled);
+		}
+		overflow.clear();
+
+		//Room for the whole frame next time, with some to spare
+		MEMORY_TAG_SCOPE(MemoryTag::Frame);
+		MemoryTracker::Free(memory);
+		capacity = lastFrameBytes + lastFrameBytes / 2;
+		memory = (uint8_t*)MemoryTracker::Allocate(capacity);
+		growCount++;
+	}
+
+	overflowBytes = 0;
+	offset.store(0, std::memory_order_relaxed);
+}
+
+size_t FrameArena::GetCapacity() {
+	return capacity;
+}
+
+size_t FrameArena::GetUsedBytes() {
+	return (std::min)(offset.load(std::memory_order_relaxed), capacity) + overflowBytes;
+}
+
+size_t FrameArena::GetLastFrameBytes() {
+	return lastFrameBytes;
+}
+
+size_t FrameArena::GetPeakBytes() {
+	return peakBytes;
+}
+
+unsigned int FrameArena::GetGrowCount() {
+	return growCount;
+}
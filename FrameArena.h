@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// Size of the arena's block before it has to grow
+#define FRAME_ARENA_INITIAL_CAPACITY (1 << 20)
+
+// --------------------------------------------------------
+// Linear allocator for memory that only lives for a frame
+//
+// - Allocating bumps an offset, and Reset() at the end of
+//    the frame frees everything at once, so scratch arrays
+//    never touch the heap
+// - Safe to allocate from any thread, but only reset when
+//    nothing is using the frame's memory any more
+// - A frame that runs out spills onto the heap, and the
+//    next reset grows the block to fit, so the arena only
+//    allocates until it's seen the biggest frame
+// --------------------------------------------------------
+class FrameArena
+{
+#pragma region Singleton
+public:
+	// Gets the one and only instance of this class
+	static FrameArena& GetInstance()
+	{
+		if (!instance)
+		{
+			instance = new FrameArena();
+		}
+
+		return *instance;
+	}
+
+	// Remove these functions (C++ 11 version)
+	FrameArena(FrameArena const&) = delete;
+	void operator=(FrameArena const&) = delete;
+
+private:
+	static FrameArena* instance;
+	FrameArena();
+#pragma endregion
+
+private:
+	uint8_t* memory;
+	size_t capacity;
+	std::atomic<size_t> offset;
+
+	//Allocations that didn't fit, freed at the next reset
+	std::mutex overflowMutex;
+	std::vector<void*> overflow;
+	size_t overflowBytes;
+
+	//Stats
+	size_t lastFrameBytes;
+	size_t peakBytes;
+	unsigned int growCount;
+
+public:
+	~FrameArena();
+
+	//Memory for the rest of the frame, never null
+	void* Allocate(size_t size, size_t alignment = 16);
+
+	//Uninitialized array of count Ts
+	template<typename T>
+	T* Allocate(size_t count) {
+		return (T*)Allocate(sizeof(T) * count, alignof(T));
+	}
+
+	//Frees everything allocated this frame
+	// - Called once per frame by the game loop
+	void Reset();
+
+	size_t GetCapacity();
+	size_t GetUsedBytes();
+	size_t GetLastFrameBytes();
+	size_t GetPeakBytes();
+	unsigned int GetGrowCount();
+};
+
+// --------------------------------------------------------
+// Standard library allocator on top of the frame arena
+//  - Frees do nothing, so reserve up front rather than
+//    letting a container grow a step at a time
+// --------------------------------------------------------
+template<typename T>
+struct FrameAllocator {
+	typedef T value_type;
+
+	FrameAllocator() {}
+
+	template<typename U>
+	FrameAllocator(const FrameAllocator<U>&) {}
+
+	T* allocate(size_t count) {
+		return FrameArena::GetInstance().Allocate<T>(count);
+	}
+
+	void deallocate(T*, size_t) {
+	}
+};
+
+template<typename T, typename U>
+bool operator==(const FrameAllocator<T>&, const FrameAllocator<U>&) { return true; }
+
+template<typename T, typename U>
+bool operator!=(const FrameAllocator<T>&, const FrameAllocator<U>&) { return false; }
+
+// A vector whose memory only lasts until the end of the frame
+template<typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
@@ -0,0 +1,141 @@
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <cmath>
+
+FramePacer::FramePacer(FrameClock* clock, double spinSeconds) :
+	clock(clock),
+	targetSeconds(0.0),
+	spinSeconds(spinSeconds),
+	nextDeadline(0.0),
+	lastFrameStart(-1.0),
+	frameTimes(FRAME_PACER_HISTORY, 0.0f),
+	historyOffset(0),
+	historyCount(0),
+	missedDeadlines(0),
+	averageWakeError(0.0) {
+}
+
+FramePacer::~FramePacer() {
+}
+
+// --------------------------------------------------------
+// Sleeps, then spins, until the next frame's deadline
+// --------------------------------------------------------
+void FramePacer::Wait() {
+	if (targetSeconds <= 0.0) {
+		RecordFrame(clock->Now());
+		return;
+	}
+
+	double now = clock->Now();
+	nextDeadline += targetSeconds;
+
+	if (now > nextDeadline && lastFrameStart >= 0.0) {
+		missedDeadlines++;
+	}
+
+	//More than a frame behind (or the first frame), so start over
+	//from now instead of rushing frames out to catch up
+	if (now > nextDeadline + targetSeconds || lastFrameStart < 0.0) {
+		nextDeadline = now;
+	}
+
+	//Sleep through most of the wait
+	double remaining = nextDeadline - now;
+	if (remaining > spinSeconds) {
+		clock->Sleep(remaining - spinSeconds);
+	}
+
+	//Spin the rest, as the sleep can't be trusted to wake on time
+	now = clock->Now();
+	while (now < nextDeadline) {
+		clock->Spin();
+		now = clock->Now();
+	}
+
+	averageWakeError += ((now - nextDeadline) - averageWakeError) * 0.05;
+	RecordFrame(now);
+}
+
+void FramePacer::RecordFrame(double frameStart) {
+	if (lastFrameStart >= 0.0) {
+		frameTimes[historyOffset] = (float)((frameStart - lastFrameStart) * 1000.0);
+		historyOffset = (historyOffset + 1) % FRAME_PACER_HISTORY;
+		historyCount = (std::min)(historyCount + 1, FRAME_PACER_HISTORY);
+	}
+
+	lastFrameStart = frameStart;
+}
+
+void FramePacer::SetTargetFrameRate(double framesPerSecond) {
+	targetSeconds = framesPerSecond > 0.0 ? 1.0 / framesPerSecond : 0.0;
+	nextDeadline = clock->Now();
+}
+
+double FramePacer::GetTargetFrameRate() {
+	return targetSeconds > 0.0 ? 1.0 / targetSeconds : 0.0;
+}
+
+void FramePacer::SetSpinSeconds(double spinSeconds) {
+	this->spinSeconds = (std::max)(spinSeconds, 0.0);
+}
+
+double FramePacer::GetSpinSeconds() {
+	return spinSeconds;
+}
+
+float FramePacer::GetAverageFrameTime() {
+	if (historyCount == 0) return 0.0f;
+
+	double total = 0.0;
+	for (int i = 0; i < historyCount; i++) {
+		total += frameTimes[i];
+	}
+
+	return (float)(total / historyCount);
+}
+
+float FramePacer::GetJitter() {
+	if (historyCount < 2) return 0.0f;
+
+	double mean = GetAverageFrameTime();
+	double sumSquares = 0.0;
+	for (int i = 0; i < historyCount; i++) {
+		double difference = frameTimes[i] - mean;
+		sumSquares += difference * difference;
+	}
+
+	return (float)std::sqrt(sumSquares / (historyCount - 1));
+}
+
+float FramePacer::GetMaxDeviation() {
+	double expected = targetSeconds > 0.0 ? targetSeconds * 1000.0 : GetAverageFrameTime();
+
+	double maxDeviation = 0.0;
+	for (int i = 0; i < historyCount; i++) {
+		maxDeviation = (std::max)(maxDeviation, std::abs(frameTimes[i] - expected));
+	}
+
+	return (float)maxDeviation;
+}
+
+float FramePacer::GetAverageWakeError() {
+	return (float)(averageWakeError * 1000.0);
+}
+
+unsigned int FramePacer::GetMissedDeadlines() {
+	return missedDeadlines;
+}
+
+const std::vector<float>& FramePacer::GetFrameTimeHistory() {
+	return frameTimes;
+}
+
+int FramePacer::GetHistoryOffset() {
+	return historyCount < FRAME_PACER_HISTORY ? 0 : historyOffset;
+}
+
+int FramePacer::GetHistoryCount() {
+	return historyCount;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+
+// Number of frame intervals kept for the jitter stats
+#define FRAME_PACER_HISTORY 240
+
+// --------------------------------------------------------
+// The time source a FramePacer waits on
+//  - Lets the pacing be driven by a fake clock, away from
+//    the OS timers
+// --------------------------------------------------------
+class FrameClock {
+public:
+	virtual ~FrameClock() {}
+
+	//Seconds since some fixed point
+	virtual double Now() = 0;
+
+	//Blocks for about the given time, and is allowed to wake late
+	virtual void Sleep(double seconds) = 0;
+
+	//Called over and over while busy waiting
+	virtual void Spin() {}
+};
+
+// --------------------------------------------------------
+// Caps the frame rate by waiting out the rest of each frame
+//
+// - Sleeps until shortly before the deadline, then spins for
+//    the tail, since OS sleeps can wake late
+// - Deadlines step by exactly one frame, so an early or late
+//    frame doesn't shift the ones after it, unless the frame
+//    is more than a whole frame late
+// - Tracks how far each frame interval strays from the
+//    target (or from the average, when unlimited)
+// --------------------------------------------------------
+class FramePacer {
+private:
+	FrameClock* clock;
+	double targetSeconds;
+	double spinSeconds;
+	double nextDeadline;
+	double lastFrameStart;
+
+	//Stats
+	std::vector<float> frameTimes;
+	int historyOffset;
+	int historyCount;
+	unsigned int missedDeadlines;
+	double averageWakeError;
+
+	void RecordFrame(double frameStart);
+
+public:
+	FramePacer(FrameClock* clock, double spinSeconds = 0.002);
+	~FramePacer();
+
+	//Waits until the next frame should start
+	// - Returns right away when there's no limit
+	void Wait();
+
+	//Zero or less removes the limit
+	void SetTargetFrameRate(double framesPerSecond);
+	double GetTargetFrameRate();
+
+	//How long before each deadline the pacer stops sleeping and spins
+	void SetSpinSeconds(double spinSeconds);
+	double GetSpinSeconds();
+
+	//Stats, in milliseconds
+	float GetAverageFrameTime();
+	float GetJitter();			// Standard deviation of the frame interval
+	float GetMaxDeviation();	// Furthest any interval strayed from the target
+	float GetAverageWakeError();// How late the waits return, on average
+	unsigned int GetMissedDeadlines();
+
+	//Ring of the latest frame intervals in ms, oldest at the offset
+	const std::vector<float>& GetFrameTimeHistory();
+	int GetHistoryOffset();
+	int GetHistoryCount();
+};
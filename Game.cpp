@@ -2,6 +2,12 @@
 #include "Vertex.h"
 #include "Input.h"
 #include "Helpers.h"
+#include "Profiler.h"
+#include "JobSystem.h"
+#include "FrameArena.h"
+#include "MemoryTracker.h"
+#include "ShaderVariantBuilder.h"
+#include "ShaderStructGenerator.h"
 
 //ImGui imports
 #include "ImGui/imgui.h"
@@ -14,9 +20,30 @@
 
 #include "WICTextureLoader.h"
 
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <psapi.h>
+#include <random>
+
 // For the DirectX Math library
 using namespace DirectX;
 
+// ImGui allocates through the memory tracker, as a tool
+static void* ImGuiAllocate(size_t size, void* userData) {
+	MEMORY_TAG_SCOPE(MemoryTag::Tools);
+	return MemoryTracker::Allocate(size);
+}
+
+static void ImGuiFree(void* memory, void* userData) {
+	MemoryTracker::Free(memory);
+}
+
 // --------------------------------------------------------
 // Constructor
 //
@@ -43,23 +70,80 @@ Game::Game(HINSTANCE hInstance)
 	//Set initial selected camera
 	selectedCameraIndex = 0;
 
+	//Scene state
+	sceneEntitiesLoaded = 0;
+	sceneLoadMilliseconds = 0.0f;
+	sceneLoadMeasured = false;
+
+	//Shader variants are used whenever a manifest has been built
+	useShaderVariants = true;
+	materialsOnVariants = 0;
+
 	//Pink ambient color
 	//ambientColor = DirectX::XMFLOAT3(0.03f, 0.015f, 0.03f);
 	ambientColor = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
 
 	//Set initial light variables
-	directionalLight1 = {};
-	directionalLight2 = {};
-	directionalLight3 = {};
-	pointLight1 = {};
-	pointLight2 = {};
+	baseLightCount = 0;
+	randomLightCount = 0;
+	cullEntityLights = true;
+	entityLightCullMilliseconds = 0.0f;
+	interpolateMilliseconds = 0.0f;
+	bvhMeasureSize = 2;
+
+	//Nothing's picked until the scene's clicked on
+	selectedEntityIndex = -1;
+	revealSelection = false;
+	pickPressX = 0;
+	pickPressY = 0;
+	pickDistance = 0.0f;
+	pickMicroseconds = 0.0f;
+	rayMeasureSize = 1;
+
+	useParallelDraws = false;
+	captureRenderFrame = false;
+
+	//Command trace state
+	traceFrameCount = 1;
+	traceReplayTarget = 0;
+
+	//Benchmark state
+	benchmarkNullDevice = false;
+	benchmarkQuitWhenDone = false;
+	savedTargetFrameRate = 0.0;
+	benchmarkResultsWritten = false;
+
+	//Software renderer state
+	softwareResolutionScale = 0.5f;
+	softwareBenchmarkIterations = 10;
+	softwareImageSaved = false;
+
+	//Profiler window state
+	profilerFramesAgo = 0;
+	profilerZoneOverhead = 0.0;
 
 	//Set initial shadow map variables
 	shadowMapResolution = 1024;
+	lightProjectionSize = 15.0f; // Tweak for your scene!
+	lightNearPlane = 1.0f;
+	lightFarPlane = 100.0f;
 	lightProjectionMatrix = XMFLOAT4X4();
 	lightViewMatrix = XMFLOAT4X4();
 
+	//Set initial shadow cache variables
+	cachedLightViewMatrix = XMFLOAT4X4();
+	cachedStaticChangeCount = 0;
+	staticShadowsDirty = true;
+	staticShadowCasterCount = 0;
+	shadowCastersCulled = 0;
+	shadowCastersDrawn = 0;
+	staticShadowRendersSkipped = 0;
+
 	blurRadius = 1;
+	blurType = (int)BlurType::Gaussian;
+	useComputeBlur = false;
+	postProcessGraphUsesCompute = false;
+	postProcessPeakBytes = 0;
 }
 
 // --------------------------------------------------------
@@ -75,6 +159,16 @@ Game::~Game() {
 	// Call Release() on any Direct3D objects made within this class
 	// - Note: this is unnecessary for D3D objects stored in ComPtrs
 
+	//Shaders outlive the game, so stop them reporting to the trace
+	ISimpleShader::Observer = 0;
+
+	//Stop the job system's workers before the device and everything
+	//made with it are released, as jobs may still be using them
+	// - The tree waits for its rebuild job, so it goes first, while
+	//   there are still workers to finish it
+	entityBvh.reset();
+	JobSystem::GetInstance().ShutDown();
+
 	//ImGui clean up
 	ImGui_ImplDX11_Shutdown();
 	ImGui_ImplWin32_Shutdown();
@@ -86,43 +180,46 @@ Game::~Game() {
 // are initialized but before the game loop.
 // --------------------------------------------------------
 void Game::Init() {
-	// Helper methods for loading shaders, creating some basic
-	// geometry to draw and some simple camera matrices.
-	//  - You'll be expanding and/or replacing these later
+	//Geometry is created and drawn through the render device
+	d3d11Device = std::make_shared<D3D11RenderDevice>(device, context);
+	renderRecorder = std::make_shared<RecordingRenderDevice>(d3d11Device);
+	renderRecorder->SetRecording(false);
+	renderDevice = renderRecorder;
+
+	//Trace capture watches resources from the start, so it's attached
+	//before anything is created
+	commandTrace = std::make_shared<CommandTraceCapture>();
+	renderRecorder->SetObserver(commandTrace);
+	ISimpleShader::Observer = commandTrace.get();
+	traceReplayer = std::make_shared<TraceReplayer>();
+
+	benchmarkSuite = std::make_shared<BenchmarkSuite>();
+	benchmarkSuite->AddDefaultScenes();
+
+	// Helper methods for loading shaders and the scene's content
 	LoadShaders();
-
-	CreateMaterials();
-
-	CreateGeometry();
-
-	CreateSky();
+	LoadShaderVariants();
 
 	CreateShadowMap();
 
-	//ambientColor = DirectX::XMFLOAT3(0.1f, 0.1f, 0.25f);
-	//ambientColor = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+	//Bins the point and spot lights for clustered shading
+	lightClusters = std::make_shared<LightClusterGrid>(device, context);
 
-	CreateLights();
+	//Answers what's near something without checking every entity
+	entityBvh = std::make_shared<SceneBvh>();
 
-	CreatePostProcessResources();
+	//Meshes, materials, lights, cameras and the sky all come from the
+	//scene, and the first load creates every entity up front
+	LoadScene(FixPath(L"../../Assets/Scenes/Default.scene"));
+	while (StreamSceneChunk());
 
+	CreatePostProcessResources();
 
-	//Create cameras
-	cameras.push_back(std::make_shared<Camera>(
-		0.0f, 1.0f, -8.0f,
-		5.0f,
-		0.01f,
-		DirectX::XM_PI / 4.0f,
-		(float)this->windowWidth / this->windowHeight
-	));
+	//Times each section of Draw() on the GPU
+	gpuProfiler = std::make_shared<GpuProfiler>(std::make_shared<D3D11GpuQueryBackend>(device, context));
 
-	cameras.push_back(std::make_shared<Camera>(
-		3.0f, 10.0f, -12.0f,
-		5.0f,
-		0.01f,
-		DirectX::XM_PI / 2.0f,
-		(float)this->windowWidth / this->windowHeight
-	));
+	//Records entity draws on worker threads when enabled
+	drawSubmitter = std::make_shared<ParallelDrawSubmitter>(device, context, d3d11Device);
 
 	// Set initial graphics API state
 	//  - These settings persist until we change them
@@ -148,6 +245,7 @@ void Game::Init() {
 
 	// Initialize ImGui itself & platform/renderer backends
 	IMGUI_CHECKVERSION();
+	ImGui::SetAllocatorFunctions(ImGuiAllocate, ImGuiFree);
 	ImGui::CreateContext();
 	ImGui_ImplWin32_Init(hWnd);
 	ImGui_ImplDX11_Init(device.Get(), context.Get());
@@ -156,6 +254,29 @@ void Game::Init() {
 	ImGui::StyleColorsDark();
 	//ImGui::StyleColorsLight();
 	//ImGui::StyleColorsClassic();
+
+	//Unattended benchmark runs, for automation
+	// - "-benchmark" runs the suite and quits when it's done
+	// - "-nulldevice" keeps the scenes' meshes off the GPU
+	// - "-buildshaders" compiles every shader variant and quits
+	// - "-generatestructs" writes ShaderStructs.h from the shaders and quits
+	// - The BVH, ray casting and scene load timings are in
+	//   DX11StarterBenchmarks, next to the tests, as they don't
+	//   need a window or a device
+	const wchar_t* commandLine = GetCommandLineW();
+	if (wcsstr(commandLine, L"-benchmark")) {
+		benchmarkNullDevice = wcsstr(commandLine, L"-nulldevice") != 0;
+		benchmarkQuitWhenDone = true;
+		StartBenchmark();
+	}
+	else if (wcsstr(commandLine, L"-buildshaders")) {
+		BuildShaderVariants();
+		Quit();
+	}
+	else if (wcsstr(commandLine, L"-generatestructs")) {
+		GenerateShaderStructs();
+		Quit();
+	}
 }
 
 // --------------------------------------------------------
@@ -202,511 +323,545 @@ void Game::LoadShaders() {
 		FixPath(L"PostProcessBlurPS.cso").c_str()));
 
 	ppPS = pixelShaders[3];
+
+	blurCS = std::make_shared<SimpleComputeShader>(device, context,
+		FixPath(L"PostProcessBlurCS.cso").c_str());
+
+	//Scene materials name the shaders they use by file
+	vertexShaderFiles["VertexShader.cso"] = vertexShaders[0];
+	pixelShaderFiles["PixelShader.cso"] = pixelShaders[0];
+	pixelShaderFiles["CustomPS.cso"] = pixelShaders[1];
+
+	//Every shader rebuilds from its source when that's edited
+	shaderHotReload = std::make_shared<ShaderHotReload>(FixPath(L"../../"));
+	shaderHotReload->Watch(vertexShaders[0], "VertexShader.hlsl", "vs_5_0");
+	shaderHotReload->Watch(vertexShaders[1], "SkyVertexShader.hlsl", "vs_5_0");
+	shaderHotReload->Watch(vertexShaders[2], "ShadowMapVS.hlsl", "vs_5_0");
+	shaderHotReload->Watch(vertexShaders[3], "PostProcessVS.hlsl", "vs_5_0");
+	shaderHotReload->Watch(pixelShaders[0], "PixelShader.hlsl", "ps_5_0");
+	shaderHotReload->Watch(pixelShaders[1], "CustomPS.hlsl", "ps_5_0");
+	shaderHotReload->Watch(pixelShaders[2], "SkyPixelShader.hlsl", "ps_5_0");
+	shaderHotReload->Watch(pixelShaders[3], "PostProcessBlurPS.hlsl", "ps_5_0");
+	shaderHotReload->Watch(blurCS, "PostProcessBlurCS.hlsl", "cs_5_0");
+
+	CheckShaderLayouts();
 }
 
-//Loads textures and creates materials
-void Game::CreateMaterials() {
-	//Load Textures
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> flatMapSRV;
-	CreateWICTextureFromFile(
-		device.Get(),
-		context.Get(),
-		FixPath(L"../../Assets/Textures/flat_normals.png").c_str(),
-		0,
-		flatMapSRV.GetAddressOf()
-	);
-
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> defaultSpecularSRV;
-	CreateWICTextureFromFile(
-		device.Get(),
-		context.Get(),
-		FixPath(L"../../Assets/Textures/default_specular.png").c_str(),
-		0,
-		defaultSpecularSRV.GetAddressOf()
-	);
-
-	//COBBLESTONE PBR SRVs
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> cobbleAlbedoSRV;
-	CreateWICTextureFromFile(
-		device.Get(),
-		context.Get(),
-		FixPath(L"../../Assets/Textures/PBR/cobblestone_albedo.png").c_str(),
-		0,
-		cobbleAlbedoSRV.GetAddressOf()
-	);
-
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> cobbleMetalSRV;
-	CreateWICTextureFromFile(
-		device.Get(),
-		context.Get(),
-		FixPath(L"../../Assets/Textures/PBR/cobblestone_metal.png").c_str(),
-		0,
-		cobbleMetalSRV.GetAddressOf()
-	);
-
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> cobbleNormalSRV;
-	CreateWICTextureFromFile(
-		device.Get(),
-		context.Get(),
-		FixPath(L"../../Assets/Textures/PBR/cobblestone_normals.png").c_str(),
-		0,
-		cobbleNormalSRV.GetAddressOf()
-	);
-
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> cobbleRoughnessSRV;
-	CreateWICTextureFromFile(
-		device.Get(),
-		context.Get(),
-		FixPath(L"../../Assets/Textures/PBR/cobblestone_roughness.png").c_str(),
-		0,
-		cobbleRoughnessSRV.GetAddressOf()
-	);
-
-	/*//BRONZE PBR SRVs
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> bronzeAlbedoSRV;
-	CreateWICTextureFromFile(
-		device.Get(),
-		context.Get(),
-		FixPath(L"../../Assets/Textures/PBR/bronze_albedo.png").c_str(),
-		0,
-		bronzeAlbedoSRV.GetAddressOf()
-	);
-
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> bronzeMetalSRV;
-	CreateWICTextureFromFile(
-		device.Get(),
-		context.Get(),
-		FixPath(L"../../Assets/Textures/PBR/bronze_metal.png").c_str(),
-		0,
-		bronzeMetalSRV.GetAddressOf()
-	);
-
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> bronzeNormalSRV;
-	CreateWICTextureFromFile(
-		device.Get(),
-		context.Get(),
-		FixPath(L"../../Assets/Textures/PBR/bronze_normals.png").c_str(),
-		0,
-		bronzeNormalSRV.GetAddressOf()
-	);
-
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> bronzeRoughnessSRV;
-	CreateWICTextureFromFile(
-		device.Get(),
-		context.Get(),
-		FixPath(L"../../Assets/Textures/PBR/bronze_roughness.png").c_str(),
-		0,
-		bronzeRoughnessSRV.GetAddressOf()
-	);
-
-	//FLOOR PBR SRVs
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> floorAlbedoSRV;
-	CreateWICTextureFromFile(
-		device.Get(),
-		context.Get(),
-		FixPath(L"../../Assets/Textures/PBR/floor_albedo.png").c_str(),
-		0,
-		floorAlbedoSRV.GetAddressOf()
-	);
-
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> floorMetalSRV;
-	CreateWICTextureFromFile(
-		device.Get(),
-		context.Get(),
-		FixPath(L"../../Assets/Textures/PBR/floor_metal.png").c_str(),
-		0,
-		floorMetalSRV.GetAddressOf()
-	);
-
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> floorNormalSRV;
-	CreateWICTextureFromFile(
-		device.Get(),
-		context.Get(),
-		FixPath(L"../../Assets/Textures/PBR/floor_normals.png").c_str(),
-		0,
-		floorNormalSRV.GetAddressOf()
-	);
-
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> floorRoughnessSRV;
-	CreateWICTextureFromFile(
-		device.Get(),
-		context.Get(),
-		FixPath(L"../../Assets/Textures/PBR/floor_roughness.png").c_str(),
-		0,
-		floorRoughnessSRV.GetAddressOf()
-	);
-
-	//PAINT PBR SRVs
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> paintAlbedoSRV;
-	CreateWICTextureFromFile(
-		device.Get(),
-		context.Get(),
-		FixPath(L"../../Assets/Textures/PBR/paint_albedo.png").c_str(),
-		0,
-		paintAlbedoSRV.GetAddressOf()
-	);
-
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> paintMetalSRV;
-	CreateWICTextureFromFile(
-		device.Get(),
-		context.Get(),
-		FixPath(L"../../Assets/Textures/PBR/paint_metal.png").c_str(),
-		0,
-		paintMetalSRV.GetAddressOf()
-	);
-
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> paintNormalSRV;
-	CreateWICTextureFromFile(
-		device.Get(),
-		context.Get(),
-		FixPath(L"../../Assets/Textures/PBR/paint_normals.png").c_str(),
-		0,
-		paintNormalSRV.GetAddressOf()
-	);
-
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> paintRoughnessSRV;
-	CreateWICTextureFromFile(
-		device.Get(),
-		context.Get(),
-		FixPath(L"../../Assets/Textures/PBR/paint_roughness.png").c_str(),
-		0,
-		paintRoughnessSRV.GetAddressOf()
-	);
-
-	//ROUGH PBR SRVs
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> roughAlbedoSRV;
-	CreateWICTextureFromFile(
-		device.Get(),
-		context.Get(),
-		FixPath(L"../../Assets/Textures/PBR/rough_albedo.png").c_str(),
-		0,
-		roughAlbedoSRV.GetAddressOf()
-	);
-
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> roughMetalSRV;
-	CreateWICTextureFromFile(
-		device.Get(),
-		context.Get(),
-		FixPath(L"../../Assets/Textures/PBR/rough_metal.png").c_str(),
-		0,
-		roughMetalSRV.GetAddressOf()
-	);
-
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> roughNormalSRV;
-	CreateWICTextureFromFile(
-		device.Get(),
-		context.Get(),
-		FixPath(L"../../Assets/Textures/PBR/rough_normals.png").c_str(),
-		0,
-		roughNormalSRV.GetAddressOf()
-	);
-
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> roughRoughnessSRV;
-	CreateWICTextureFromFile(
-		device.Get(),
-		context.Get(),
-		FixPath(L"../../Assets/Textures/PBR/rough_roughness.png").c_str(),
-		0,
-		roughRoughnessSRV.GetAddressOf()
-	);
-
-	//SCRATCHED PBR SRVs
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> scratchedAlbedoSRV;
-	CreateWICTextureFromFile(
-		device.Get(),
-		context.Get(),
-		FixPath(L"../../Assets/Textures/PBR/scratched_albedo.png").c_str(),
-		0,
-		scratchedAlbedoSRV.GetAddressOf()
-	);
-
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> scratchedMetalSRV;
-	CreateWICTextureFromFile(
-		device.Get(),
-		context.Get(),
-		FixPath(L"../../Assets/Textures/PBR/scratched_metal.png").c_str(),
-		0,
-		scratchedMetalSRV.GetAddressOf()
-	);
-
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> scratchedNormalSRV;
-	CreateWICTextureFromFile(
-		device.Get(),
-		context.Get(),
-		FixPath(L"../../Assets/Textures/PBR/scratched_normals.png").c_str(),
-		0,
-		scratchedNormalSRV.GetAddressOf()
-	);
-
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> scratchedRoughnessSRV;
-	CreateWICTextureFromFile(
-		device.Get(),
-		context.Get(),
-		FixPath(L"../../Assets/Textures/PBR/scratched_roughness.png").c_str(),
-		0,
-		scratchedRoughnessSRV.GetAddressOf()
-	);
-
-	//WOOD PBR SRVs
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> woodAlbedoSRV;
-	CreateWICTextureFromFile(
-		device.Get(),
-		context.Get(),
-		FixPath(L"../../Assets/Textures/PBR/wood_albedo.png").c_str(),
-		0,
-		woodAlbedoSRV.GetAddressOf()
-	);
-
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> woodMetalSRV;
-	CreateWICTextureFromFile(
-		device.Get(),
-		context.Get(),
-		FixPath(L"../../Assets/Textures/PBR/wood_metal.png").c_str(),
-		0,
-		woodMetalSRV.GetAddressOf()
-	);
-
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> woodNormalSRV;
-	CreateWICTextureFromFile(
-		device.Get(),
-		context.Get(),
-		FixPath(L"../../Assets/Textures/PBR/wood_normals.png").c_str(),
-		0,
-		woodNormalSRV.GetAddressOf()
-	);
-
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> woodRoughnessSRV;
-	CreateWICTextureFromFile(
-		device.Get(),
-		context.Get(),
-		FixPath(L"../../Assets/Textures/PBR/wood_roughness.png").c_str(),
-		0,
-		woodRoughnessSRV.GetAddressOf()
-	);
-	*/
-
-	Microsoft::WRL::ComPtr<ID3D11SamplerState> defaultSampler;
-
-	D3D11_SAMPLER_DESC samplerDesc = {};
-	samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
-	samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
-	samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
-	samplerDesc.Filter = D3D11_FILTER_ANISOTROPIC;
-	samplerDesc.MaxAnisotropy = 16;
-	samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
-
-	device->CreateSamplerState(&samplerDesc, defaultSampler.GetAddressOf());
-
-	//(0) Create Bronze PBR Material
-	//materials.push_back(std::make_shared<Material>(DirectX::XMFLOAT4(1, 1, 1, 1), 0.1f, vertexShaders[0], pixelShaders[0]));
-	//materials[0]->AddTextureSRV("Albedo", bronzeAlbedoSRV);
-	//materials[0]->AddTextureSRV("NormalMap", bronzeNormalSRV);
-	//materials[0]->AddTextureSRV("RoughnessMap", bronzeRoughnessSRV);
-	//materials[0]->AddTextureSRV("MetalnessMap", bronzeMetalSRV);
-	//materials[0]->AddSampler("BasicSampler", defaultSampler);
-
-	//(1) Create Cobblestone PBR Material
-	materials.push_back(std::make_shared<Material>(DirectX::XMFLOAT4(1, 1, 1, 1), 0.1f, vertexShaders[0], pixelShaders[0]));
-	materials[0]->AddTextureSRV("Albedo", cobbleAlbedoSRV);
-	materials[0]->AddTextureSRV("NormalMap", cobbleNormalSRV);
-	materials[0]->AddTextureSRV("RoughnessMap", cobbleRoughnessSRV);
-	materials[0]->AddTextureSRV("MetalnessMap", cobbleMetalSRV);
-	materials[0]->AddSampler("BasicSampler", defaultSampler);
-
-	//(2) Create Floor PBR Material
-	//materials.push_back(std::make_shared<Material>(DirectX::XMFLOAT4(1, 1, 1, 1), 0.1f, vertexShaders[0], pixelShaders[0]));
-	//materials[2]->AddTextureSRV("Albedo", floorAlbedoSRV);
-	//materials[2]->AddTextureSRV("NormalMap", floorNormalSRV);
-	//materials[2]->AddTextureSRV("RoughnessMap", floorRoughnessSRV);
-	//materials[2]->AddTextureSRV("MetalnessMap", floorMetalSRV);
-	//materials[2]->AddSampler("BasicSampler", defaultSampler);
-
-	//(3) Create Paint PBR Material
-	/*materials.push_back(std::make_shared<Material>(DirectX::XMFLOAT4(1, 1, 1, 1), 0.1f, vertexShaders[0], pixelShaders[0]));
-	materials[0]->AddTextureSRV("Albedo", paintAlbedoSRV);
-	materials[0]->AddTextureSRV("NormalMap", paintNormalSRV);
-	materials[0]->AddTextureSRV("RoughnessMap", paintRoughnessSRV);
-	materials[0]->AddTextureSRV("MetalnessMap", paintMetalSRV);
-	materials[0]->AddSampler("BasicSampler", defaultSampler);*/
-
-	//(4) Create Rough PBR Material
-	/*materials.push_back(std::make_shared<Material>(DirectX::XMFLOAT4(1, 1, 1, 1), 0.1f, vertexShaders[0], pixelShaders[0]));
-	materials[1]->AddTextureSRV("Albedo", roughAlbedoSRV);
-	materials[1]->AddTextureSRV("NormalMap", roughNormalSRV);
-	materials[1]->AddTextureSRV("RoughnessMap", roughRoughnessSRV);
-	materials[1]->AddTextureSRV("MetalnessMap", roughMetalSRV);
-	materials[1]->AddSampler("BasicSampler", defaultSampler);*/
-
-	//(5) Create Scratched PBR Material
-	/*materials.push_back(std::make_shared<Material>(DirectX::XMFLOAT4(1, 1, 1, 1), 0.1f, vertexShaders[0], pixelShaders[0]));
-	materials[2]->AddTextureSRV("Albedo", scratchedAlbedoSRV);
-	materials[2]->AddTextureSRV("NormalMap", scratchedNormalSRV);
-	materials[2]->AddTextureSRV("RoughnessMap", scratchedRoughnessSRV);
-	materials[2]->AddTextureSRV("MetalnessMap", scratchedMetalSRV);
-	materials[2]->AddSampler("BasicSampler", defaultSampler);*/
-
-	//(6) Create Wood PBR Material
-	/*materials.push_back(std::make_shared<Material>(DirectX::XMFLOAT4(1, 1, 1, 1), 0.1f, vertexShaders[0], pixelShaders[0]));
-	materials[3]->AddTextureSRV("Albedo", woodAlbedoSRV);
-	materials[3]->AddTextureSRV("NormalMap", woodNormalSRV);
-	materials[3]->AddTextureSRV("RoughnessMap", woodRoughnessSRV);
-	materials[3]->AddTextureSRV("MetalnessMap", woodMetalSRV);
-	materials[3]->AddSampler("BasicSampler", defaultSampler);*/
+// --------------------------------------------------------
+// Writes ShaderStructs.h next to the shader sources, with a
+// C++ struct for each block the game fills in from C++
+//  - Only written when it changes, so it doesn't trigger a
+//     rebuild otherwise
+// --------------------------------------------------------
+bool Game::GenerateShaderStructs() {
+	const ShaderStructSchema schemas[] = {
+		{ "ShaderIncludes.hlsli", "Light", ShaderPacking::Structured, "Light" },
+		{ "VertexShader.hlsl", "ExternalData", ShaderPacking::ConstantBuffer, "VertexShaderConstants" },
+		{ "PixelShader.hlsl", "ExternalData", ShaderPacking::ConstantBuffer, "PixelShaderConstants" },
+		{ "CustomPS.hlsl", "ExternalData", ShaderPacking::ConstantBuffer, "CustomPSConstants" },
+		{ "SkyVertexShader.hlsl", "ExternalData", ShaderPacking::ConstantBuffer, "SkyVSConstants" },
+		{ "ShadowMapVS.hlsl", "externalData", ShaderPacking::ConstantBuffer, "ShadowMapVSConstants" },
+		{ "PostProcessBlurPS.hlsl", "externalData", ShaderPacking::ConstantBuffer, "BlurPSConstants" },
+		{ "PostProcessBlurCS.hlsl", "externalData", ShaderPacking::ConstantBuffer, "BlurCSConstants" },
+	};
+
+	std::wstring sourceDirectory = FixPath(L"../../");
+	std::vector<std::string> structs;
+	for (const ShaderStructSchema& schema : schemas) {
+		std::ifstream source(sourceDirectory + NarrowToWide(schema.Source), std::ios::binary);
+		std::string text((std::istreambuf_iterator<char>(source)), std::istreambuf_iterator<char>());
+
+		ShaderStruct layout;
+		std::string code;
+		std::string error;
+		if (!ShaderStructGenerator::Parse(text.data(), text.size(), schema.Block, schema.Packing, layout, error) ||
+			!ShaderStructGenerator::GenerateStruct(layout, schema, code, error)) {
+			shaderStructStatus = schema.Source + ": " + error;
+			return false;
+		}
+
+		structs.push_back(code);
+	}
+
+	std::string header = ShaderStructGenerator::GenerateHeader(structs);
+	std::wstring headerPath = sourceDirectory + NarrowToWide(SHADER_STRUCTS_FILE);
+
+	std::ifstream existing(headerPath, std::ios::binary);
+	std::string existingHeader((std::istreambuf_iterator<char>(existing)), std::istreambuf_iterator<char>());
+	existing.close();
+
+	if (existingHeader == header) {
+		shaderStructStatus = SHADER_STRUCTS_FILE " is up to date";
+		return true;
+	}
+
+	std::ofstream output(headerPath, std::ios::binary);
+	output << header;
+	shaderStructStatus = output ? "Wrote " SHADER_STRUCTS_FILE ", rebuild to use it" : "Couldn't write " SHADER_STRUCTS_FILE;
+	return (bool)output;
 }
 
-void Game::CreateSky() {
-	//Create the sample state
-	Microsoft::WRL::ComPtr<ID3D11SamplerState> defaultSampler;
-
-	D3D11_SAMPLER_DESC samplerDesc = {};
-	samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
-	samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
-	samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
-	samplerDesc.Filter = D3D11_FILTER_ANISOTROPIC;
-	samplerDesc.MaxAnisotropy = 16;
-	samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
-
-	device->CreateSamplerState(&samplerDesc, defaultSampler.GetAddressOf());
-
-	//Create the Cube map
-	std::vector<std::wstring> skyCubeMap;
-
-	//CubeMap MUST be loaded in the following order:
-	//right, left, up, down, front, back
-	skyCubeMap.push_back(FixPath(L"../../Assets/Skies/Clouds Pink/right.png"));
-	skyCubeMap.push_back(FixPath(L"../../Assets/Skies/Clouds Pink/left.png"));
-	skyCubeMap.push_back(FixPath(L"../../Assets/Skies/Clouds Pink/up.png"));
-	skyCubeMap.push_back(FixPath(L"../../Assets/Skies/Clouds Pink/down.png"));
-	skyCubeMap.push_back(FixPath(L"../../Assets/Skies/Clouds Pink/front.png"));
-	skyCubeMap.push_back(FixPath(L"../../Assets/Skies/Clouds Pink/back.png"));
-
-	sky = std::make_shared<Sky>(
-		meshes[0],			//Cube Mesh
-		defaultSampler,		//Sampler State
-		device,				//Device
-		context,			//Context
-		vertexShaders[1],	//SkyVertexShader
-		pixelShaders[2],	//SkyPixelShader
-		skyCubeMap			//List of Sky Cube Map images
-	);
+// --------------------------------------------------------
+// Compares one shader's block with its generated struct
+//  - Reflection is the truth, so this catches a shader
+//     changed since ShaderStructs.h was generated, which
+//     the static_asserts can't
+// --------------------------------------------------------
+template<typename T>
+static void CheckShaderLayout(ISimpleShader* shader, const std::string& name, std::vector<std::string>& errors) {
+	if (!shader->IsShaderValid()) return;
+
+	const SimpleConstantBuffer* buffer = shader->GetBufferInfo(T::GetBlockName());
+	if (!buffer) {
+		errors.push_back(name + ": no cbuffer " + T::GetBlockName());
+		return;
+	}
+
+	unsigned int bufferIndex = 0;
+	while (shader->GetBufferInfo(bufferIndex) != buffer) bufferIndex++;
+
+	std::vector<ShaderFieldOffset> reflected;
+	for (auto& variable : shader->GetVariableTable()) {
+		if (variable.second.ConstantBufferIndex != bufferIndex) continue;
+
+		ShaderFieldOffset field = { variable.first.c_str(), variable.second.ByteOffset, variable.second.Size };
+		reflected.push_back(field);
+	}
+
+	unsigned int count = 0;
+	const ShaderFieldOffset* fields = T::GetFields(count);
+
+	std::string error;
+	if (!ShaderStructGenerator::Validate(fields, count, reflected, error)) {
+		errors.push_back(name + ":\n" + error);
+	}
 }
 
-//Creates Lights
-void Game::CreateLights() {
-	//Directional light pointing right
-	directionalLight1 = {};
-	directionalLight1.Type = LIGHT_TYPE_DIRECTIONAL;
-	//directionalLight1.Direction = DirectX::XMFLOAT3(0.6f, -1.0f, 1.15f);
-	directionalLight1.Direction = DirectX::XMFLOAT3(1.0f, 0.0f, 0.0f);
-	directionalLight1.Color = DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f);
-	directionalLight1.Intensity = 0.5f;
-
-	//Directional light pointing down
-	directionalLight2 = {};
-	directionalLight2.Type = LIGHT_TYPE_DIRECTIONAL;
-	directionalLight2.Direction = DirectX::XMFLOAT3(-1.0f, -0.25f, 0.15f);
-	directionalLight2.Color = DirectX::XMFLOAT3(1.0f, 0.0f, 0.0f);
-	directionalLight2.Intensity = 0.5f;
-
-	//Purple point light
-	//pointLight1 = {};
-	//pointLight1.Type = LIGHT_TYPE_POINT;
-	//pointLight1.Range = 10.0f;
-	//pointLight1.Position = DirectX::XMFLOAT3(0.0f, 1.0f, 0.0f);
-	//pointLight1.Color = DirectX::XMFLOAT3(1.0f, 0.0f, 1.0f);
-	////directionalLight1.Color = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
-	//pointLight1.Intensity = 1.0f;
-
-	//Add lights to lights vector
-	lights.push_back(&directionalLight1);
-	lights.push_back(&directionalLight2);
-	lights.push_back(&directionalLight3);
-	lights.push_back(&pointLight1);
-	lights.push_back(&pointLight2);
+void Game::CheckShaderLayouts() {
+	shaderLayoutErrors.clear();
 
-	XMMATRIX lightView = XMMatrixLookToLH(
-		-DirectX::XMLoadFloat3(&directionalLight1.Direction) * 20,	// Position: "Backing up" 20 units from origin
-		DirectX::XMLoadFloat3(&directionalLight1.Direction),		// Direction: light's direction
-		XMVectorSet(0, 1, 0, 0));									// Up: World up vector (Y axis)
+	CheckShaderLayout<VertexShaderConstants>(vertexShaders[0].get(), "VertexShader", shaderLayoutErrors);
+	CheckShaderLayout<SkyVSConstants>(vertexShaders[1].get(), "SkyVertexShader", shaderLayoutErrors);
+	CheckShaderLayout<ShadowMapVSConstants>(vertexShaders[2].get(), "ShadowMapVS", shaderLayoutErrors);
+	CheckShaderLayout<PixelShaderConstants>(pixelShaders[0].get(), "PixelShader", shaderLayoutErrors);
+	CheckShaderLayout<CustomPSConstants>(pixelShaders[1].get(), "CustomPS", shaderLayoutErrors);
+	CheckShaderLayout<BlurPSConstants>(ppPS.get(), "PostProcessBlurPS", shaderLayoutErrors);
+	CheckShaderLayout<BlurCSConstants>(blurCS.get(), "PostProcessBlurCS", shaderLayoutErrors);
 
-	float lightProjectionSize = 15.0f; // Tweak for your scene!
-	XMMATRIX lightProjection = XMMatrixOrthographicLH(
-		lightProjectionSize,
-		lightProjectionSize,
-		1.0f,
-		100.0f);
+	for (auto& variant : shaderVariants) {
+		CheckShaderLayout<PixelShaderConstants>(variant.second.get(), variant.first, shaderLayoutErrors);
+	}
+}
 
-	DirectX::XMStoreFloat4x4(&lightViewMatrix, lightView);
-	DirectX::XMStoreFloat4x4(&lightProjectionMatrix, lightProjection);
+// --------------------------------------------------------
+// Reads the manifest -buildshaders wrote, if there is one
+//  - Without it every material keeps its default shader
+// --------------------------------------------------------
+void Game::LoadShaderVariants() {
+	shaderManifest.Clear();
+	shaderVariants.clear();
+
+	std::ifstream file(FixPath(NarrowToWide(SHADER_MANIFEST_FILE)), std::ios::binary);
+	if (!file) {
+		shaderVariantStatus = "No " SHADER_MANIFEST_FILE ", run with -buildshaders";
+		return;
+	}
 
-	//Send the texture data to all materials
-	for (std::shared_ptr<Material> material : materials) {
-		material->AddTextureSRV("ShadowMap", shadowSRV);
-		material->AddSampler("ShadowSampler", shadowSampler);
+	std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	std::string error;
+	if (!shaderManifest.Parse(text.data(), text.size(), error)) {
+		shaderManifest.Clear();
+		shaderVariantStatus = SHADER_MANIFEST_FILE ": " + error;
+		return;
 	}
+
+	shaderVariantStatus.clear();
 }
 
+// --------------------------------------------------------
+// Compiles every variant of the shaders with keywords, from
+// their sources, then switches the materials over to them
+// --------------------------------------------------------
+bool Game::BuildShaderVariants() {
+	std::vector<ShaderPermutationSet> shaders(1);
+	shaders[0].Shader = "PixelShader";
+	shaders[0].Source = "PixelShader.hlsl";
+	shaders[0].Profile = "ps_5_0";
+
+	ShaderManifest manifest;
+	std::string error;
+	if (!ShaderVariantBuilder::Build(FixPath(L"../../"), FixPath(L""), shaders, manifest, error)) {
+		shaderVariantStatus = error;
+		return false;
+	}
 
+	LoadShaderVariants();
+	SelectShaderVariants();
+	return true;
+}
 
 // --------------------------------------------------------
-// Creates the geometry we're going to draw - a single triangle for now
+// Moves each material to the cheapest variant of its pixel
+// shader that handles both its textures and the lights
+//  - Called whenever the lights change, since the variants
+//     only loop over as many light types and counts as the
+//     scene needs
+//  - Changing shaders moves the material to another
+//     template, so the shared resources are set here too
 // --------------------------------------------------------
-void Game::CreateGeometry() {
-	// Create some temporary variables to represent colors
-	// - Not necessary, just makes things more readable
+void Game::SelectShaderVariants() {
+	ShaderFeatureRequest features;
+	int directionalLights = 0;
+	int localLights = 0;
+	int spotLights = 0;
+	for (const Light& light : lights) {
+		if (light.Type == LIGHT_TYPE_DIRECTIONAL) directionalLights++;
+		else localLights++;
+
+		if (light.Type == LIGHT_TYPE_SPOT) spotLights++;
+	}
 
-	// Set up the vertices of the triangle we would like to draw
-	// - We're going to copy this array, exactly as it exists in CPU memory
-	//    over to a Direct3D-controlled data structure on the GPU (the vertex buffer)
-	// - Note: Since we don't have a camera or really any concept of
-	//    a "3d world" yet, we're simply describing positions within the
-	//    bounds of how the rasterizer sees our screen: [-1 to +1] on X and Y
-	// - This means (0,0) is at the very center of the screen.
-	// - These are known as "Normalized Device Coordinates" or "Homogeneous 
-	//    Screen Coords", which are ways to describe a position without
-	//    knowing the exact size (in pixels) of the image/window/etc.  
-	// - Long story short: Resizing the window also resizes the triangle,
-	//    since we're describing the triangle in terms of the window itself
-	
-	//Add meshes from file into meshes vector
-	//(0) Cube Mesh
-	meshes.push_back(std::make_shared<Mesh>(FixPath(L"../../Assets/Models/cube.obj").c_str(), device, context));
+	//The first directional light is the one that casts shadows
+	features.Values["SHADOWS"] = directionalLights > 0 ? 1 : 0;
+	features.Values["SPOT_LIGHTS"] = spotLights > 0 ? 1 : 0;
+	features.Values["MAX_LOCAL_LIGHTS"] = localLights;
+
+	materialsOnVariants = 0;
+	for (size_t i = 0; i < materials.size() && i < materialShaderNames.size(); i++) {
+		std::shared_ptr<Material> material = materials[i];
+		const std::string& shader = materialShaderNames[i];
+
+		auto original = pixelShaderFiles.find(shader + ".cso");
+		std::shared_ptr<SimplePixelShader> ps = original == pixelShaderFiles.end() ? pixelShaders[0] : original->second;
+
+		const ShaderVariant* variant = useShaderVariants ? material->SelectVariant(shaderManifest, shader, features) : 0;
+		if (variant) {
+			auto loaded = shaderVariants.find(variant->File);
+			if (loaded == shaderVariants.end()) {
+				std::shared_ptr<SimplePixelShader> variantPS = std::make_shared<SimplePixelShader>(device, context,
+					FixPath(NarrowToWide(variant->File)).c_str());
+				loaded = shaderVariants.insert(std::make_pair(variant->File, variantPS)).first;
+
+				//Variants rebuild with their own defines
+				const ShaderPermutationSet* set = shaderManifest.FindShader(shader);
+				if (set && variantPS->IsShaderValid()) {
+					shaderHotReload->Watch(variantPS, set->Source, set->Profile, set->GetDefines(variant->Key));
+				}
+
+				CheckShaderLayout<PixelShaderConstants>(variantPS.get(), variant->File, shaderLayoutErrors);
+			}
+
+			//A missing file just leaves the default in place
+			if (loaded->second->IsShaderValid()) {
+				ps = loaded->second;
+				materialsOnVariants++;
+			}
+		}
+
+		if (ps != material->GetPixelShader()) material->SetPixelShader(ps);
+
+		//Shared by every material, so they go on the template
+		std::shared_ptr<MaterialTemplate> materialTemplate = material->GetTemplate();
+		materialTemplate->SetSampler("BasicSampler", sceneSampler);
+		materialTemplate->SetTexture("ShadowMap", shadowSRV);
+		materialTemplate->SetSampler("ShadowSampler", shadowSampler);
+	}
+}
+
+// --------------------------------------------------------
+// Creates a range of a scene's entities and adds them to a list
+//  - Reads straight through the transform and renderable
+//    arrays, so a mapped scene pages in front to back
+//  - Entities whose mesh or material is missing are skipped
+// --------------------------------------------------------
+static void CreateSceneEntities(
+	const SceneFile& scene,
+	size_t first,
+	size_t count,
+	const std::vector<std::shared_ptr<Mesh>>& meshes,
+	const std::vector<std::shared_ptr<Material>>& materials,
+	std::vector<std::shared_ptr<Entity>>& entities) {
+	SceneArray<SceneTransform> transforms = scene.GetTransforms();
+	SceneArray<SceneRenderable> renderables = scene.GetRenderables();
+
+	for (size_t i = first; i < first + count; i++) {
+		const SceneRenderable& renderable = renderables[i];
+		if (renderable.Mesh >= meshes.size() || renderable.Material >= materials.size()) continue;
+
+		std::shared_ptr<Entity> entity = Entity::GetPool().Create(meshes[renderable.Mesh], materials[renderable.Material]);
+		entity->SetStatic((renderable.Flags & SCENE_ENTITY_STATIC) != 0);
+
+		std::shared_ptr<Transform> transform = entity->GetTransform();
+		transform->SetPosition(XMFLOAT3(transforms[i].Position));
+		transform->SetRotation(XMFLOAT3(transforms[i].Rotation));
+		transform->SetScale(XMFLOAT3(transforms[i].Scale));
+
+		entities.push_back(entity);
+	}
+}
+
+// --------------------------------------------------------
+// Replaces the scene with one from a file
+//  - Meshes, textures, materials, lights, cameras and the sky
+//     are created here, and StreamSceneChunk() creates the
+//     entities afterwards
+//  - Textures are kept by path, so reloading doesn't read
+//     them again
+// --------------------------------------------------------
+bool Game::LoadScene(const std::wstring& path) {
+	if (benchmarkSuite->IsRunning()) return false;
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	std::shared_ptr<SceneFile> file = std::make_shared<SceneFile>();
+	if (!file->Load(path)) {
+		sceneError = file->GetError();
+		return false;
+	}
+
+	scene = file;
+	scenePath = path;
+	sceneError.clear();
+
+	//Shared by the materials and the sky
+	if (!sceneSampler) {
+		D3D11_SAMPLER_DESC samplerDesc = {};
+		samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
+		samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
+		samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
+		samplerDesc.Filter = D3D11_FILTER_ANISOTROPIC;
+		samplerDesc.MaxAnisotropy = 16;
+		samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
+
+		device->CreateSamplerState(&samplerDesc, sceneSampler.GetAddressOf());
+	}
+
+	meshes.clear();
+	for (const SceneAsset& asset : scene->GetMeshes()) {
+		meshes.push_back(std::make_shared<Mesh>(FixPath(NarrowToWide(scene->GetString(asset.Path))).c_str(), renderDevice));
+	}
+
+	std::vector<Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> textures;
+	for (const SceneAsset& asset : scene->GetTextures()) {
+		std::string texturePath = scene->GetString(asset.Path);
+
+		auto cached = sceneTextures.find(texturePath);
+		if (cached == sceneTextures.end()) {
+			Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv;
+			CreateWICTextureFromFile(
+				device.Get(),
+				context.Get(),
+				FixPath(NarrowToWide(texturePath)).c_str(),
+				0,
+				srv.GetAddressOf());
+
+			cached = sceneTextures.insert(std::make_pair(texturePath, srv)).first;
+		}
+
+		textures.push_back(cached->second);
+	}
+
+	SceneArray<SceneMaterialTexture> materialTextures = scene->GetMaterialTextures();
+	materials.clear();
+	materialShaderNames.clear();
+	for (const SceneMaterial& desc : scene->GetMaterials()) {
+		//Shaders the game didn't load fall back to the standard pair
+		auto vs = vertexShaderFiles.find(scene->GetString(desc.VertexShader));
+		auto ps = pixelShaderFiles.find(scene->GetString(desc.PixelShader));
+
+		std::shared_ptr<Material> material = Material::GetPool().Create(
+			XMFLOAT4(desc.Tint),
+			desc.Roughness,
+			vs == vertexShaderFiles.end() ? vertexShaders[0] : vs->second,
+			ps == pixelShaderFiles.end() ? pixelShaders[0] : ps->second);
+
+		for (uint32_t i = 0; i < desc.TextureCount; i++) {
+			const SceneMaterialTexture& map = materialTextures[desc.FirstTexture + i];
+			material->AddTextureSRV(scene->GetString(map.Slot), textures[map.Texture]);
+		}
+
+		//Variants are looked up by the shader's name, without ".cso"
+		std::string pixelShaderFile = ps == pixelShaderFiles.end() ? "PixelShader.cso" : ps->first;
+		materialShaderNames.push_back(pixelShaderFile.substr(0, pixelShaderFile.rfind('.')));
+		materials.push_back(material);
+	}
+
+	const SceneEnvironment& environment = scene->GetEnvironment();
+	ambientColor = XMFLOAT3(environment.AmbientColor);
+
+	sky = 0;
+	if (environment.SkyMesh != SCENE_NONE) {
+		//Faces are already in the order the cube map needs:
+		//right, left, up, down, front, back
+		std::vector<std::wstring> skyCubeMap;
+		for (uint32_t face : environment.SkyFaces) {
+			skyCubeMap.push_back(FixPath(NarrowToWide(scene->GetString(face))));
+		}
 
-	////(1) Cylinder Mesh
-	//meshes.push_back(std::make_shared<Mesh>(FixPath(L"../../Assets/Models/cylinder.obj").c_str(), device, context));
+		sky = std::make_shared<Sky>(
+			meshes[environment.SkyMesh],
+			sceneSampler,
+			device,
+			context,
+			vertexShaders[1],	//SkyVertexShader
+			pixelShaders[2],	//SkyPixelShader
+			skyCubeMap
+		);
+	}
+
+	//The first light casts the shadows
+	// - Scene lights are laid out like the shaders' lights
+	static_assert(sizeof(SceneLight) == sizeof(Light), "SceneLight has to match Light");
+	static_assert(SCENE_LIGHT_SPOT == LIGHT_TYPE_SPOT && SCENE_LIGHT_POINT == LIGHT_TYPE_POINT, "Light types have to match");
+	SceneArray<SceneLight> sceneLights = scene->GetLights();
+	lights.resize(sceneLights.Count);
+	if (!sceneLights.empty()) memcpy(lights.data(), sceneLights.Data, sceneLights.Count * sizeof(Light));
+	baseLightCount = (unsigned int)lights.size();
+	CreateRandomLights(randomLightCount);
+	UpdateLightMatrices();
+
+	float aspectRatio = (float)this->windowWidth / this->windowHeight;
+	cameras.clear();
+	for (const SceneCamera& desc : scene->GetCameras()) {
+		std::shared_ptr<Camera> camera = std::make_shared<Camera>(
+			desc.Position[0], desc.Position[1], desc.Position[2],
+			desc.MoveSpeed,
+			desc.RotationSpeed,
+			desc.FieldOfView,
+			aspectRatio);
+
+		camera->GetTransform()->SetRotation(XMFLOAT3(desc.Rotation));
+		camera->UpdateViewMatrix();
+		cameras.push_back(camera);
+	}
+
+	//There has to be something to look through
+	if (cameras.empty()) {
+		cameras.push_back(std::make_shared<Camera>(0.0f, 0.0f, -5.0f, 5.0f, 0.01f, DirectX::XM_PI / 4.0f, aspectRatio));
+	}
+	selectedCameraIndex = 0;
+	selectedEntityIndex = -1;
+
+	entities.clear();
+	entities.reserve(scene->GetEntityCount());
+	sceneEntitiesLoaded = 0;
+	scene->Prefetch(0, SCENE_STREAM_CHUNK_SIZE);
+	staticShadowsDirty = true;
+
+	sceneLoadMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	return true;
+}
+
+// --------------------------------------------------------
+// Creates the next chunk of the scene's entities
+//  - Returns true while there are more to come
+// --------------------------------------------------------
+bool Game::StreamSceneChunk() {
+	if (!scene || sceneEntitiesLoaded >= scene->GetEntityCount()) return false;
+
+	PROFILE_SCOPE("Scene Streaming");
+
+	size_t count = (std::min)((size_t)SCENE_STREAM_CHUNK_SIZE, scene->GetEntityCount() - sceneEntitiesLoaded);
+
+	//Start paging in the next chunk while this one's created
+	scene->Prefetch(sceneEntitiesLoaded + count, SCENE_STREAM_CHUNK_SIZE);
+	CreateSceneEntities(*scene, sceneEntitiesLoaded, count, meshes, materials, entities);
+
+	sceneEntitiesLoaded += count;
+	staticShadowsDirty = true;
+	return sceneEntitiesLoaded < scene->GetEntityCount();
+}
+
+// --------------------------------------------------------
+// Selects whatever entity is under a point on the screen
+//  - The ray goes from the camera through the point, and
+//     hits the entities where they were last drawn
+//  - Missing everything clears the selection
+// --------------------------------------------------------
+void Game::PickEntity(int screenX, int screenY) {
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	std::shared_ptr<Camera> camera = cameras[selectedCameraIndex];
+
+	//Aim through the middle of the pixel
+	DirectX::XMFLOAT3 origin, direction;
+	camera->GetRay(screenX + 0.5f, screenY + 0.5f, (float)windowWidth, (float)windowHeight, origin, direction);
+	SceneBvhRay ray = { { origin.x, origin.y, origin.z }, { direction.x, direction.y, direction.z }, camera->GetFarPlane() };
+
+	pickInstances.resize(entities.size());
+	for (size_t i = 0; i < entities.size(); i++) {
+		pickInstances[i] = RayCastInstance{ entities[i]->GetMesh()->GetBvh().get(), &renderWorlds[i]._11 };
+	}
 
-	//(2) Helix Mesh
-	//meshes.push_back(std::make_shared<Mesh>(FixPath(L"../../Assets/Models/helix.obj").c_str(), device, context));
+	RayCastHit hit;
+	selectedEntityIndex = -1;
+	if (!entities.empty() && RayCaster::Cast(*entityBvh, pickInstances.data(), ray, hit)) {
+		selectedEntityIndex = (int)hit.Instance;
+		pickDistance = hit.Distance;
+	}
+	revealSelection = selectedEntityIndex >= 0;
 
-	////(3) Quad Mesh
-	//meshes.push_back(std::make_shared<Mesh>(FixPath(L"../../Assets/Models/quad.obj").c_str(), device, context));
+	pickMicroseconds = std::chrono::duration<float, std::micro>(std::chrono::high_resolution_clock::now() - start).count();
+}
 
-	////(4) Double Sided Quad Mesh
-	//meshes.push_back(std::make_shared<Mesh>(FixPath(L"../../Assets/Models/quad_double_sided.obj").c_str(), device, context));
+// --------------------------------------------------------
+// Points the shadow map's view down the first light
+// --------------------------------------------------------
+void Game::UpdateLightMatrices() {
+	if (lights.empty()) return;
 
-	//(5) Sphere Mesh
-	meshes.push_back(std::make_shared<Mesh>(FixPath(L"../../Assets/Models/sphere.obj").c_str(), device, context));
+	XMMATRIX lightView = XMMatrixLookToLH(
+		-DirectX::XMLoadFloat3(&lights[0].Direction) * 20,	// Position: "Backing up" 20 units from origin
+		DirectX::XMLoadFloat3(&lights[0].Direction),		// Direction: light's direction
+		XMVectorSet(0, 1, 0, 0));							// Up: World up vector (Y axis)
 
-	////(6) Torus Mesh
-	//meshes.push_back(std::make_shared<Mesh>(FixPath(L"../../Assets/Models/torus.obj").c_str(), device, context));
+	XMMATRIX lightProjection = XMMatrixOrthographicLH(
+		lightProjectionSize,
+		lightProjectionSize,
+		lightNearPlane,
+		lightFarPlane);
 
-	//Create entities using the meshes and materials
-	//Floor
-	//entities.push_back(std::make_shared<Entity>(meshes[0], materials[3]));
-	//entities[0]->GetTransform()->SetPosition(0.0f, 0.0f, 0.0f);
-	//entities[0]->GetTransform()->SetScale(25.0f, 0.01f, 25.0f);
+	DirectX::XMStoreFloat4x4(&lightViewMatrix, lightView);
+	DirectX::XMStoreFloat4x4(&lightProjectionMatrix, lightProjection);
+}
 
-	//Sphere Entity
-	entities.push_back(std::make_shared<Entity>(meshes[1], materials[0]));
-	entities[0]->GetTransform()->SetPosition(-0.0f, 1.25f, 0.0f);
+// --------------------------------------------------------
+// Replaces any random lights with a new set of point and
+// spot lights scattered around the scene, for testing many
+// lights
+//  - Every third light is a spot light pointing down
+//  - The materials' shader variants depend on the lights, so
+//     they're picked again afterwards
+// --------------------------------------------------------
+void Game::CreateRandomLights(int count) {
+	lights.resize(baseLightCount);
+
+	//Fixed seed so the same count always gives the same lights
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> horizontal(-20.0f, 20.0f);
+	std::uniform_real_distribution<float> vertical(-2.0f, 4.0f);
+	std::uniform_real_distribution<float> range(1.0f, 4.0f);
+	std::uniform_real_distribution<float> color(0.2f, 1.0f);
+	std::uniform_real_distribution<float> falloff(4.0f, 32.0f);
+
+	for (int i = 0; i < count; i++) {
+		Light light = {};
+		light.Type = LIGHT_TYPE_POINT;
+		light.Position = DirectX::XMFLOAT3(horizontal(random), vertical(random), horizontal(random));
+		light.Range = range(random);
+		light.Color = DirectX::XMFLOAT3(color(random), color(random), color(random));
+		light.Intensity = 1.0f;
+
+		if (i % 3 == 2) {
+			light.Type = LIGHT_TYPE_SPOT;
+			light.Direction = DirectX::XMFLOAT3(0.0f, -1.0f, 0.0f);
+			light.Range *= 2.0f;
+			light.SpotFalloff = falloff(random);
+		}
 
-	//Helix Entity
-	//entities.push_back(std::make_shared<Entity>(meshes[1], materials[0]));
-	//entities[2]->GetTransform()->SetPosition(0.0f, 1.25f, 0.0f);
+		lights.push_back(light);
+	}
 
-	//Cube Entity
-	//entities.push_back(std::make_shared<Entity>(meshes[0], materials[1]));
-	//entities[3]->GetTransform()->SetPosition(5.0f, 1.25f, 0.0f);
+	SelectShaderVariants();
 }
 
 void Game::CreateShadowMap() {
@@ -723,9 +878,13 @@ void Game::CreateShadowMap() {
 	shadowDesc.SampleDesc.Count = 1;
 	shadowDesc.SampleDesc.Quality = 0;
 	shadowDesc.Usage = D3D11_USAGE_DEFAULT;
-	Microsoft::WRL::ComPtr<ID3D11Texture2D> shadowTexture;
 	device->CreateTexture2D(&shadowDesc, 0, shadowTexture.GetAddressOf());
 
+	// Create the static caster cache with a matching description,
+	// so it can be copied directly into the shadow map each frame
+	shadowDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
+	device->CreateTexture2D(&shadowDesc, 0, staticShadowTexture.GetAddressOf());
+
 	// Create the depth/stencil view
 	D3D11_DEPTH_STENCIL_VIEW_DESC shadowDSDesc = {};
 	shadowDSDesc.Format = DXGI_FORMAT_D32_FLOAT;
@@ -735,6 +894,10 @@ void Game::CreateShadowMap() {
 		shadowTexture.Get(),
 		&shadowDSDesc,
 		shadowDSV.GetAddressOf());
+	device->CreateDepthStencilView(
+		staticShadowTexture.Get(),
+		&shadowDSDesc,
+		staticShadowDSV.GetAddressOf());
 
 	// Create the SRV for the shadow map
 	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
@@ -767,198 +930,993 @@ void Game::CreateShadowMap() {
 	device->CreateSamplerState(&shadowSampDesc, &shadowSampler);
 }
 
-void Game::CreatePostProcessResources() {
-	// Sampler state for post processing
-	D3D11_SAMPLER_DESC ppSampDesc = {};
-	ppSampDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
-	ppSampDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
-	ppSampDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
-	ppSampDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
-	ppSampDesc.MaxLOD = D3D11_FLOAT32_MAX;
-	device->CreateSamplerState(&ppSampDesc, ppSampler.GetAddressOf());
+// --------------------------------------------------------
+// Records the entities on several threads with deferred
+// contexts, then plays them back in order
+//  - Per frame values go on each shader once up front, and
+//    the submitter's contexts copy them from there
+// --------------------------------------------------------
+void Game::DrawEntitiesParallel(float totalTime, const D3D11_VIEWPORT& viewport) {
+	std::shared_ptr<Camera> camera = cameras[selectedCameraIndex];
+
+	drawItems.resize(entities.size());
+	for (size_t i = 0; i < entities.size(); i++) {
+		std::shared_ptr<Entity> entity = entities[i];
+		std::shared_ptr<Material> material = entity->GetMaterial();
+
+		material->GetVertexShader()->SetMatrix4x4("lightView", lightViewMatrix);
+		material->GetVertexShader()->SetMatrix4x4("lightProjection", lightProjectionMatrix);
+		material->GetPixelShader()->SetFloat3("ambient", ambientColor);
+		lightClusters->SetShaderData(material->GetPixelShader(), windowWidth, windowHeight);
+
+		DrawItem& item = drawItems[i];
+		item.World = entity->GetTransform()->GetRenderWorldMatrix();
+		item.WorldInvTranspose = entity->GetTransform()->GetRenderWorldInverseTransposeMatrix();
+		item.DrawMaterial = material.get();
+		item.Bindings = &material->GetBindings();
+		item.DrawMesh = entity->GetMesh().get();
+		item.Lights = entityLightRanges[i];
+	}
 
-	CreatePostProcessTexture();
-}
+	drawSubmitter->SetFrameShaderResource("Lights", lightClusters->GetLightSRV());
+	drawSubmitter->SetFrameShaderResource("ClusterRanges", lightClusters->GetClusterRangeSRV());
+	drawSubmitter->SetFrameShaderResource("LightIndices", lightClusters->GetLightIndexSRV());
 
-void Game::CreatePostProcessTexture() {
-	// Describe the texture we're creating
-	D3D11_TEXTURE2D_DESC textureDesc = {};
-	textureDesc.Width = windowWidth;
-	textureDesc.Height = windowHeight;
-	textureDesc.ArraySize = 1;
-	textureDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
-	textureDesc.CPUAccessFlags = 0;
-	textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-	textureDesc.MipLevels = 1;
-	textureDesc.MiscFlags = 0;
-	textureDesc.SampleDesc.Count = 1;
-	textureDesc.SampleDesc.Quality = 0;
-	textureDesc.Usage = D3D11_USAGE_DEFAULT;
-
-	// Create the resource (no need to track it after the views are created below)
-	Microsoft::WRL::ComPtr<ID3D11Texture2D> ppTexture;
-	device->CreateTexture2D(&textureDesc, 0, ppTexture.GetAddressOf());
-
-	// Create the Render Target View
-	D3D11_RENDER_TARGET_VIEW_DESC rtvDesc = {};
-	rtvDesc.Format = textureDesc.Format;
-	rtvDesc.Texture2D.MipSlice = 0;
-	rtvDesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
-	device->CreateRenderTargetView(
-		ppTexture.Get(),
-		&rtvDesc,
-		ppRTV.ReleaseAndGetAddressOf());
-
-	// Create the Shader Resource View
-	// By passing it a null description for the SRV, we
-	// get a "default" SRV that has access to the entire resource
-	device->CreateShaderResourceView(
-		ppTexture.Get(),
-		0,
-		ppSRV.ReleaseAndGetAddressOf());
-}
+	DrawFrame frame = {};
+	frame.View = camera->GetView();
+	frame.Projection = camera->GetProjection();
+	frame.CameraPosition = camera->GetTransform()->GetPosition();
+	frame.TotalTime = totalTime;
+	frame.RenderTarget = sceneTarget->RTV.Get();
+	frame.DepthStencil = depthBufferDSV.Get();
+	frame.Viewport = viewport;
 
+	drawSubmitter->Submit(drawItems, frame);
+
+	//Executing the command lists cleared the immediate context's state
+	renderDevice->InvalidateState();
+}
 
 // --------------------------------------------------------
-// Handle resizing to match the new window size.
-//  - DXCore needs to resize the back buffer
-//  - Eventually, we'll want to update our 3D camera
+// Renders the scene on the CPU and copies the result into a
+// texture the inspector can show
+//  - Uses the render transforms, so the image matches the
+//     frame the GPU just drew
+//  - With iterations above zero the frame is benchmarked
 // --------------------------------------------------------
-void Game::OnResize() {
-	// Handle base-level DX resize stuff
-	DXCore::OnResize();
+void Game::RenderSoftwareFrame(int benchmarkIterations) {
+	std::shared_ptr<Camera> camera = cameras[selectedCameraIndex];
+
+	int width = (std::max)((int)(windowWidth * softwareResolutionScale), 1);
+	int height = (std::max)((int)(windowHeight * softwareResolutionScale), 1);
+
+	if (!softwareRasterizer) {
+		softwareRasterizer = std::make_shared<SoftwareRasterizer>(width, height);
+	}
+	else if (softwareRasterizer->GetWidth() != width || softwareRasterizer->GetHeight() != height) {
+		softwareRasterizer->Resize(width, height);
+	}
 
-	//Reset Screen Sized Render Targets
-	ppSRV.Reset();
-	ppRTV.Reset();
+	std::vector<SoftwareDrawItem> items(entities.size());
+	for (size_t i = 0; i < entities.size(); i++) {
+		std::shared_ptr<Entity> entity = entities[i];
 
-	//Recreate the post process texture, RTV, and SRV using new screen sizes
-	CreatePostProcessTexture();
+		SoftwareDrawItem& item = items[i];
+		item.DrawMesh = entity->GetMesh().get();
+		item.World = entity->GetTransform()->GetRenderWorldMatrix();
+		item.WorldInvTranspose = entity->GetTransform()->GetRenderWorldInverseTransposeMatrix();
+		item.ColorTint = entity->GetMaterial()->GetColorTint();
+		item.Roughness = entity->GetMaterial()->GetRoughness();
+	}
 
-	//Update all camera projection matrices
-	for (std::shared_ptr<Camera> camera : cameras) {
-		camera->UpdateProjectionMatrix((float)this->windowWidth / this->windowHeight);
+	SoftwareFrame frame = {};
+	frame.View = camera->GetView();
+	frame.Projection = camera->GetProjection();
+	frame.CameraPosition = camera->GetTransform()->GetPosition();
+	frame.Ambient = ambientColor;
+	frame.ClearColor = XMFLOAT3(0.4f, 0.6f, 0.75f); // Same as the GPU clear
+	frame.Lights = lights;
+
+	if (benchmarkIterations > 0) softwareRasterizer->Benchmark(items, frame, benchmarkIterations);
+	else softwareRasterizer->Render(items, frame);
+
+	//Recreate the texture whenever the size changes
+	D3D11_TEXTURE2D_DESC existing = {};
+	if (softwareTexture) softwareTexture->GetDesc(&existing);
+	if (!softwareTexture || existing.Width != (UINT)width || existing.Height != (UINT)height) {
+		D3D11_TEXTURE2D_DESC desc = {};
+		desc.Width = width;
+		desc.Height = height;
+		desc.MipLevels = 1;
+		desc.ArraySize = 1;
+		desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		desc.SampleDesc.Count = 1;
+		desc.Usage = D3D11_USAGE_DEFAULT;
+		desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+		softwareTexture.Reset();
+		softwareSRV.Reset();
+		device->CreateTexture2D(&desc, 0, softwareTexture.GetAddressOf());
+		device->CreateShaderResourceView(softwareTexture.Get(), 0, softwareSRV.GetAddressOf());
 	}
+
+	std::vector<uint32_t> image = softwareRasterizer->GetImage();
+	context->UpdateSubresource(softwareTexture.Get(), 0, 0, image.data(), width * sizeof(uint32_t), 0);
+
+	softwareImageSaved = false;
 }
 
 // --------------------------------------------------------
-// Update your game here - user input, move objects, AI, etc.
+// Swaps the game's scene out for the benchmark's, and runs
+// unpaced so frame times are what the engine can do
 // --------------------------------------------------------
-void Game::Update(float deltaTime, float totalTime) {
-	//Update ImGui
-	UpdateGui(deltaTime);
-
-	//Create the ImGui windows
-	CreateWindowInfoGui();
-	CreateInspectorGui();
-
-	//Apply transformations to entities
-	//entities[0]->GetTransform()->SetScale((sin(totalTime) + 2.0f) / 2.0f, (sin(totalTime) + 2.0f) / 2.0f, 0.0f);
-	entities[0]->GetTransform()->Rotate(0.0f, 1.0f * deltaTime, 0.0f);
+void Game::StartBenchmark() {
+	//The scene's first material is the template for the benchmark's
+	if (benchmarkSuite->IsRunning() || materials.empty()) return;
+
+	//The null backend only counts, so the GPU doesn't set the pace
+	if (benchmarkNullDevice) {
+		std::shared_ptr<RecordingRenderDevice> nullDevice = std::make_shared<RecordingRenderDevice>();
+		nullDevice->SetRecording(false);
+		benchmarkDevice = nullDevice;
+	}
+	else {
+		benchmarkDevice = renderDevice;
+	}
 
-	//Update the selected camera
-	cameras[selectedCameraIndex]->Update(deltaTime);
+	savedEntities = entities;
+	savedTargetFrameRate = framePacer.GetTargetFrameRate();
+	framePacer.SetTargetFrameRate(0.0);
+	benchmarkResultsWritten = false;
 
-	// Example input checking: Quit if the escape key is pressed
-	if (Input::GetInstance().KeyDown(VK_ESCAPE))
-		Quit();
+	benchmarkSuite->Start();
+	benchmarkFrameStart = std::chrono::high_resolution_clock::now();
 }
 
 // --------------------------------------------------------
-// Update ImGui
+// Builds the suite's generated scene on the benchmark device
+//  - Materials are instances of the first material's template,
+//     with its textures and samplers, and the generated values
 // --------------------------------------------------------
-void Game::UpdateGui(float deltaTime) {
-	// Feed fresh input data to ImGui
-	ImGuiIO& io = ImGui::GetIO();
-	io.DeltaTime = deltaTime;
-	io.DisplaySize.x = (float)this->windowWidth;
-	io.DisplaySize.y = (float)this->windowHeight;
+void Game::LoadBenchmarkScene() {
+	UnloadBenchmarkScene();
+
+	BenchmarkSceneData data;
+	benchmarkSuite->LoadScene(data);
+
+	for (const BenchmarkMeshData& meshData : data.Meshes) {
+		std::vector<Vertex> vertices(meshData.Positions.size() / 3);
+		for (size_t i = 0; i < vertices.size(); i++) {
+			vertices[i] = {};
+			vertices[i].Position = XMFLOAT3(&meshData.Positions[i * 3]);
+			vertices[i].Normal = XMFLOAT3(&meshData.Normals[i * 3]);
+			vertices[i].UV = XMFLOAT2(&meshData.UVs[i * 2]);
+		}
 
-	// Reset the frame
-	ImGui_ImplDX11_NewFrame();
-	ImGui_ImplWin32_NewFrame();
-	ImGui::NewFrame();
+		std::vector<unsigned int> indices = meshData.Indices;
+		benchmarkMeshes.push_back(std::make_shared<Mesh>(
+			vertices.data(), (int)vertices.size(), indices.data(), (int)indices.size(), benchmarkDevice));
+	}
 
-	// Determine new input capture
-	Input& input = Input::GetInstance();
-	input.SetKeyboardCapture(io.WantCaptureKeyboard);
-	input.SetMouseCapture(io.WantCaptureMouse);
+	std::shared_ptr<Material> templateMaterial = materials[0];
+	for (const BenchmarkMaterialDesc& desc : data.Materials) {
+		std::shared_ptr<Material> material = Material::GetPool().Create(
+			templateMaterial->GetTemplate(), XMFLOAT4(desc.Color), desc.Roughness);
 
-	// Show the demo window
-	//ImGui::ShowDemoWindow();
+		for (auto& texture : templateMaterial->GetTextureSRVs()) material->AddTextureSRV(texture.first, texture.second);
+		for (auto& sampler : templateMaterial->GetSamplers()) material->AddSampler(sampler.first, sampler.second);
+
+		benchmarkMaterials.push_back(material);
+	}
+
+	entities.clear();
+	for (size_t i = 0; i < data.EntityMeshes.size(); i++) {
+		entities.push_back(Entity::GetPool().Create(
+			benchmarkMeshes[data.EntityMeshes[i]],
+			benchmarkMaterials[data.EntityMaterials[i]]));
+	}
+}
+
+void Game::UnloadBenchmarkScene() {
+	benchmarkSuite->UnloadScene();
+	benchmarkMeshes.clear();
+	benchmarkMaterials.clear();
 }
 
 // --------------------------------------------------------
-// Create Window Information Gui
+// Loads the suite's scene when it changes, and poses the
+// camera and entities for this frame
 // --------------------------------------------------------
-void Game::CreateWindowInfoGui() {
-	ImGui::Begin("Program Information");
+void Game::UpdateBenchmark() {
+	PROFILE_SCOPE("Benchmark");
+
+	if (!benchmarkSuite->IsSceneLoaded()) {
+		//Lights first, so the scene's materials copy the right variant
+		CreateRandomLights(benchmarkSuite->GetCurrentScene()->LightCount);
+		LoadBenchmarkScene();
+		staticShadowsDirty = true;
+	}
 
-	//Display window dimensions
-	ImGui::Text("Window Dimensions: %ux%u", windowWidth, windowHeight);
+	benchmarkSuite->PoseEntities(benchmarkPoses);
+	for (size_t i = 0; i < benchmarkPoses.size() && i < entities.size(); i++) {
+		const BenchmarkEntityPose& pose = benchmarkPoses[i];
+		std::shared_ptr<Transform> transform = entities[i]->GetTransform();
+		transform->SetPosition(XMFLOAT3(pose.Position));
+		transform->SetRotation(0.0f, pose.Yaw, 0.0f);
+		transform->SetScale(pose.Scale, pose.Scale, pose.Scale);
+	}
 
-	//Display FPS
-	ImGui::Text("FPS: %u", ImGui::GetIO().Framerate);
+	BenchmarkCameraPose cameraPose = benchmarkSuite->PoseCamera();
+	std::shared_ptr<Camera> camera = cameras[selectedCameraIndex];
+	camera->GetTransform()->SetPosition(XMFLOAT3(cameraPose.Position));
+	camera->GetTransform()->SetRotation(cameraPose.Pitch, cameraPose.Yaw, 0.0f);
+	camera->UpdateViewMatrix();
+}
 
-	//List of items in dropdown.
-	//Cannot be deleted or manipulated, and will not cause memory leak
-	//(https://stackoverflow.com/questions/2001286/const-char-s-in-c#:~:text=It%20cannot%20be%20deleted%2C%20and%20should%20not%20be%20manipulated.)
+// --------------------------------------------------------
+// Hands the suite this frame's sample, and puts the game
+// back when the last scene is done
+// --------------------------------------------------------
+void Game::EndBenchmarkFrame() {
+	auto now = std::chrono::high_resolution_clock::now();
 
-	//Deciding against this dropdown for now, will revisit later
-	/*
-	const char* items[] = { "Unlimited", "30", "60", "120", "144" };
+	benchmarkSample.FrameMilliseconds = std::chrono::duration<float, std::milli>(now - benchmarkFrameStart).count();
+	benchmarkSample.DrawMilliseconds = std::chrono::duration<float, std::milli>(now - benchmarkDrawStart).count();
+	benchmarkSample.Device = benchmarkDevice->GetStats();
+	benchmarkFrameStart = now;
 
-	static int currentItem = 0;
+	PROCESS_MEMORY_COUNTERS memory = {};
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &memory, sizeof(memory))) {
+		benchmarkSample.WorkingSetBytes = memory.WorkingSetSize;
+	}
 
-	ImGui::Combo("FPS Limit", &currentItem, items, IM_ARRAYSIZE(items));
-	*/
+	if (benchmarkSuite->EndFrame(benchmarkSample)) {
+		UnloadBenchmarkScene();
 
-	//Create VSync Checkbox
-	ImGui::Checkbox("VSync", &vsync);
+		//Next scene loads in the next update, and until then the
+		//entities still hold the last scene's meshes
+		if (!benchmarkSuite->IsRunning()) FinishBenchmark();
+	}
+}
 
-	//Create Title Bar Stats Update Checkbox
-	ImGui::Checkbox("Update Title Bar Stats", &titleBarStats);
+void Game::FinishBenchmark() {
+	benchmarkSuite->Stop();
+	UnloadBenchmarkScene();
 
-	ImGui::End();
+	entities = savedEntities;
+	savedEntities.clear();
+	CreateRandomLights(randomLightCount);
+	staticShadowsDirty = true;
+	framePacer.SetTargetFrameRate(savedTargetFrameRate);
+	benchmarkDevice = 0;
+
+	std::ofstream json(FixPath(L"BenchmarkResults.json"));
+	std::ofstream csv(FixPath(L"BenchmarkResults.csv"));
+	benchmarkResultsWritten =
+		json.is_open() && benchmarkSuite->WriteJson(json) &&
+		csv.is_open() && benchmarkSuite->WriteCsv(csv);
+
+	if (benchmarkQuitWhenDone) Quit();
 }
 
 // --------------------------------------------------------
-// Create Mesh Gui
+// Renders the shadow map for the first directional light
+//  - Static casters are only re-rendered into their cached
+//    map when the light moves or a static entity is edited
+//  - Dynamic casters are drawn on top of a copy of the cache
 // --------------------------------------------------------
-void Game::CreateInspectorGui() {
-	ImGui::Begin("Game Inspector");
+void Game::DrawShadowMap() {
+	PROFILE_SCOPE("Shadow Map");
+	GPU_PROFILE_SCOPE(gpuProfiler, "Shadow Map");
 
-	//Create the root node for entities
-	if (ImGui::TreeNode("Entities")) {
-		int index = 0;
-		//Loop through each mesh and make a node for it with child properties
-		for (std::shared_ptr<Entity> entity : entities) {
-			if (ImGui::TreeNode((void*)(intptr_t)index, "Entity %d (%d indices)", index, entity->GetMesh()->GetIndexCount())) {
-				auto entityTint = entity->GetMaterial()->GetColorTint();
-				auto entityPosition = entity->GetTransform()->GetPosition();
-				auto entityRotation = entity->GetTransform()->GetPitchYawRoll();
-				auto entityScale = entity->GetTransform()->GetScale();
+	shadowCastersCulled = 0;
+	shadowCastersDrawn = 0;
 
-				//Mesh Color
-				if (ImGui::ColorEdit4("Tint", &entityTint.x)) {
-					entity->GetMaterial()->SetColorTint(entityTint);
-				}
+	//Any change to the light's view invalidates the static cache
+	if (memcmp(&cachedLightViewMatrix, &lightViewMatrix, sizeof(XMFLOAT4X4)) != 0) {
+		cachedLightViewMatrix = lightViewMatrix;
+		staticShadowsDirty = true;
+	}
 
-				//Entity Position
-				if (ImGui::DragFloat3("Position", &entityPosition.x, 0.005f)) {
-					entity->GetTransform()->SetPosition(entityPosition);
-				}
+	//So does moving a static caster, from anywhere
+	unsigned int staticChangeCount = Transform::GetStaticChangeCount();
+	if (staticChangeCount != cachedStaticChangeCount) {
+		cachedStaticChangeCount = staticChangeCount;
+		staticShadowsDirty = true;
+	}
 
-				//Entity Rotation
-				if (ImGui::DragFloat3("Rotation", &entityRotation.x, 0.005f)) {
-					entity->GetTransform()->SetRotation(entityRotation);
-				}
+	//Casters are culled to the light's ortho volume
+	shadowCasterCuller.SetLightVolume(&lightViewMatrix._11, lightProjectionSize, lightNearPlane, lightFarPlane);
+
+	//Dynamic ones also to the camera frustum, which receives the shadows
+	std::shared_ptr<Camera> camera = cameras[selectedCameraIndex];
+	XMFLOAT4X4 cameraView = camera->GetView();
+	XMFLOAT4X4 cameraProjection = camera->GetProjection();
+
+	XMFLOAT4X4 cameraViewProjection;
+	XMStoreFloat4x4(&cameraViewProjection, XMLoadFloat4x4(&cameraView) * XMLoadFloat4x4(&cameraProjection));
+	SceneBvhFrustum receiverFrustum = SceneBvh::GetFrustum(&cameraViewProjection._11);
+
+	XMFLOAT3 lightDirection;
+	XMStoreFloat3(&lightDirection, XMVector3Normalize(XMLoadFloat3(&lights[0].Direction)));
+
+	//Ask the tree which entities reach the light's volume, once for both passes
+	// - Sorted, so casters draw in the same order as the entities
+	XMFLOAT4X4 lightViewProjection;
+	XMStoreFloat4x4(&lightViewProjection, XMLoadFloat4x4(&lightViewMatrix) * XMLoadFloat4x4(&lightProjectionMatrix));
+	shadowCasterCandidates.clear();
+	entityBvh->QueryFrustum(SceneBvh::GetFrustum(&lightViewProjection._11), shadowCasterCandidates);
+	std::sort(shadowCasterCandidates.begin(), shadowCasterCandidates.end());
+
+	//Set up the shared pipeline state for both depth passes
+	ID3D11RenderTargetView* nullRTV{};
+	context->PSSetShader(0, 0, 0);
+
+	D3D11_VIEWPORT viewport = {};
+	viewport.Width = (float)shadowMapResolution;
+	viewport.Height = (float)shadowMapResolution;
+	viewport.MaxDepth = 1.0f;
+	context->RSSetViewports(1, &viewport);
+	context->RSSetState(shadowRasterizer.Get());
+
+	vertexShaders[2]->SetShader();
+	vertexShaders[2]->SetMatrix4x4("view", lightViewMatrix);
+	vertexShaders[2]->SetMatrix4x4("projection", lightProjectionMatrix);
+
+	//Re-render the static casters only when the cache is stale
+	// - The cache must stay valid as the camera moves, so static
+	//   casters are only culled against the light's volume here
+	// - Anything that changes which entities are static also
+	//   dirties the cache, so they only need counting here
+	if (staticShadowsDirty) {
+		staticShadowCasterCount = 0;
+		for (std::shared_ptr<Entity>& e : entities) {
+			if (e->IsStatic()) staticShadowCasterCount++;
+		}
+
+		context->ClearDepthStencilView(staticShadowDSV.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
+		context->OMSetRenderTargets(1, &nullRTV, staticShadowDSV.Get());
+		shadowCasterCuller.ClearReceivers();
+		int drawn = DrawShadowCasters(true);
+		shadowCastersDrawn += drawn;
+		shadowCastersCulled += staticShadowCasterCount - drawn;
+		staticShadowsDirty = false;
+	} else {
+		staticShadowRendersSkipped++;
+	}
+
+	//Start this frame's shadow map from the cached static depth
+	context->OMSetRenderTargets(1, &nullRTV, 0);
+	context->CopyResource(shadowTexture.Get(), staticShadowTexture.Get());
+
+	//Draw the dynamic casters on top of the static ones
+	// - Culled counts every caster that wasn't drawn, whether
+	//   the tree or the culler ruled it out
+	context->OMSetRenderTargets(1, &nullRTV, shadowDSV.Get());
+	shadowCasterCuller.SetReceivers(receiverFrustum, &lightDirection.x, lightFarPlane - lightNearPlane);
+	int drawn = DrawShadowCasters(false);
+	shadowCastersDrawn += drawn;
+	shadowCastersCulled += (int)entities.size() - staticShadowCasterCount - drawn;
+
+	//Disable shadow map rasterizer state
+	context->RSSetState(0);
+}
+
+// --------------------------------------------------------
+// Draws the static or dynamic shadow casters into the bound
+// depth buffer, skipping any that cannot cast a visible shadow
+//  - Only the BVH's candidates are looked at, and the tree
+//    only tests boxes against the volume's planes, so they
+//    still go through the culler's exact test
+//  - Returns how many were drawn
+// --------------------------------------------------------
+int Game::DrawShadowCasters(bool drawStatic) {
+	int drawn = 0;
+
+	for (uint32_t i : shadowCasterCandidates) {
+		std::shared_ptr<Entity>& e = entities[i];
+		if (e->IsStatic() != drawStatic) {
+			continue;
+		}
+
+		BoundingBox bounds = GetEntityWorldBounds(i);
+		if (!shadowCasterCuller.IsVisible(&bounds.Center.x, &bounds.Extents.x)) {
+			continue;
+		}
+
+		vertexShaders[2]->SetMatrix4x4("world", e->GetTransform()->GetRenderWorldMatrix());
+		vertexShaders[2]->CopyAllBufferData();
+
+		// Draw the mesh directly to avoid the entity's material
+		e->GetMesh()->Draw();
+		drawn++;
+	}
+
+	return drawn;
+}
+
+void Game::CreatePostProcessResources() {
+	// Sampler state for post processing
+	D3D11_SAMPLER_DESC ppSampDesc = {};
+	ppSampDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+	ppSampDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+	ppSampDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+	ppSampDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+	ppSampDesc.MaxLOD = D3D11_FLOAT32_MAX;
+	device->CreateSamplerState(&ppSampDesc, ppSampler.GetAddressOf());
+
+	//Screen sized targets are pooled and handed out by the graph
+	renderTargetPool = std::make_shared<RenderTargetPool>(device, windowWidth, windowHeight);
+	postProcessGraph = std::make_shared<PostProcessGraph>(context, renderTargetPool);
+	BuildPostProcessGraph();
+}
+
+// --------------------------------------------------------
+// Builds the graph from the blur's passes, giving each one
+// the code that draws it
+// --------------------------------------------------------
+void Game::BuildPostProcessGraph() {
+	postProcessGraph->Clear();
+	postProcessGraphUsesCompute = useComputeBlur;
+
+	for (const PostProcessPassDesc& desc : BlurKernel::DeclarePasses(useComputeBlur)) {
+		PostProcessPass pass(desc);
+		bool horizontal = desc.Name == BLUR_PASS_HORIZONTAL;
+
+		if (desc.Name == BLUR_PASS_COPY) {
+			pass.Execute = [this](PostProcessPassResources& r) {
+				BlurKernel copyKernel(BlurType::Box, 0);
+				DrawBlurPass(r.Inputs[0]->SRV, copyKernel, 0.0f, 0.0f);
+			};
+		} else if (desc.Compute) {
+			pass.Execute = [this, horizontal](PostProcessPassResources& r) {
+				BlurKernel kernel((BlurType)blurType, blurRadius);
+				blurCS->SetShader();
+				DispatchBlurPass(r.Inputs[0]->SRV, r.Output->UAV, kernel, horizontal, r.OutputWidth, r.OutputHeight);
+			};
+		} else {
+			pass.Execute = [this, horizontal](PostProcessPassResources& r) {
+				BlurKernel kernel((BlurType)blurType, blurRadius);
+				if (horizontal) {
+					DrawBlurPass(r.Inputs[0]->SRV, kernel, 1.0f / r.OutputWidth, 0.0f);
+				} else {
+					DrawBlurPass(r.Inputs[0]->SRV, kernel, 0.0f, 1.0f / r.OutputHeight);
+				}
+			};
+		}
+
+		postProcessGraph->AddPass(pass);
+	}
+
+	postProcessGraph->Compile();
+	postProcessPeakBytes = postProcessGraph->CalculatePeakTransientBytes(windowWidth, windowHeight);
+}
+
+// --------------------------------------------------------
+// Blurs the scene into the back buffer
+//  - The blur is separable, so it runs as a horizontal pass
+//    followed by a vertical pass instead of one 2D box
+//  - The passes themselves live in the post process graph
+// --------------------------------------------------------
+void Game::DrawPostProcess() {
+	PROFILE_SCOPE("Post Process");
+	GPU_PROFILE_SCOPE(gpuProfiler, "Post Process");
+
+	if (useComputeBlur != postProcessGraphUsesCompute) {
+		BuildPostProcessGraph();
+	}
+
+	postProcessGraph->Execute(sceneTarget, backBufferRTV);
+}
+
+// --------------------------------------------------------
+// Draws one direction of the blur with a full screen triangle
+// into whichever render target is currently bound
+//  - stepX/stepY is the size of one pixel along the blur
+//    direction in UV space
+// --------------------------------------------------------
+void Game::DrawBlurPass(Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> input, BlurKernel& kernel, float stepX, float stepY) {
+	static_assert(sizeof(BlurPSConstants::taps) == sizeof(XMFLOAT4) * MAX_BLUR_TAPS, "MAX_BLUR_TAPS doesn't match PostProcessBlurPS.hlsl");
+
+	BlurPSConstants constants = {};
+	constants.pixelStep = XMFLOAT2(stepX, stepY);
+	constants.tapCount = kernel.GetLinearTapCount();
+	constants.centerWeight = kernel.GetCenterWeight();
+	memcpy(constants.taps, kernel.GetLinearTaps(), sizeof(constants.taps));
+
+	ppVS->SetShader();
+	ppPS->SetShader();
+	ppPS->SetBufferData(BlurPSConstants::GetBlockName(), &constants, sizeof(constants));
+	ppPS->SetShaderResourceView("Pixels", input);
+	ppPS->SetSamplerState("ClampSampler", ppSampler);
+	ppPS->CopyAllBufferData();
+
+	context->Draw(3, 0); // Draw exactly 3 vertices (one triangle)
+}
+
+// --------------------------------------------------------
+// Runs one direction of the blur with the compute shader
+//  - Each thread group blurs a 256 pixel segment of one
+//    row (or column), so there is one group row per line
+// --------------------------------------------------------
+void Game::DispatchBlurPass(
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> input,
+	Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> output,
+	BlurKernel& kernel,
+	bool horizontal,
+	unsigned int width,
+	unsigned int height) {
+	const unsigned int groupSize = 256;
+
+	static_assert(sizeof(BlurCSConstants::weights) == sizeof(XMFLOAT4) * (MAX_BLUR_RADIUS + 1), "MAX_BLUR_RADIUS doesn't match PostProcessBlurCS.hlsl");
+
+	BlurCSConstants constants = {};
+	constants.blurRadius = kernel.GetRadius();
+	constants.horizontal = horizontal ? 1 : 0;
+	constants.textureSize = XMINT2((int)width, (int)height);
+	kernel.GetWeights(&constants.weights[0].x);
+
+	blurCS->SetBufferData(BlurCSConstants::GetBlockName(), &constants, sizeof(constants));
+	blurCS->SetShaderResourceView("Pixels", input);
+	blurCS->SetUnorderedAccessView("Output", output);
+	blurCS->CopyAllBufferData();
+
+	unsigned int lineLength = horizontal ? width : height;
+	unsigned int lineCount = horizontal ? height : width;
+	blurCS->DispatchByGroups((lineLength + groupSize - 1) / groupSize, lineCount, 1);
+
+	//Unbind the compute resources so they can be read afterwards
+	ID3D11ShaderResourceView* nullSRV[1] = {};
+	ID3D11UnorderedAccessView* nullUAV[1] = {};
+	context->CSSetShaderResources(0, 1, nullSRV);
+	context->CSSetUnorderedAccessViews(0, 1, nullUAV, 0);
+}
+
+
+// --------------------------------------------------------
+// Handle resizing to match the new window size.
+//  - DXCore needs to resize the back buffer
+//  - Eventually, we'll want to update our 3D camera
+// --------------------------------------------------------
+void Game::OnResize() {
+	// Handle base-level DX resize stuff
+	DXCore::OnResize();
+
+	//Pooled targets are reallocated lazily at the new size, and
+	//the old ones are freed once they stop being used
+	if (renderTargetPool) {
+		renderTargetPool->SetScreenSize(windowWidth, windowHeight);
+		postProcessPeakBytes = postProcessGraph->CalculatePeakTransientBytes(windowWidth, windowHeight);
+	}
+
+	//Update all camera projection matrices
+	for (auto& camera : cameras) {
+		camera->UpdateProjectionMatrix((float)this->windowWidth / this->windowHeight);
+	}
+}
+
+// --------------------------------------------------------
+// Update your game here - user input, move objects, AI, etc.
+// --------------------------------------------------------
+void Game::Update(float deltaTime, float totalTime) {
+	PROFILE_SCOPE("Update");
+	benchmarkUpdateStart = std::chrono::high_resolution_clock::now();
+
+	//Shaders recompiled since last frame are swapped in before anything uses them
+	std::vector<ISimpleShader*> reloadedShaders = shaderHotReload->ApplyPending();
+	for (ISimpleShader* shader : reloadedShaders) {
+		MaterialTemplate::RefreshLayouts(shader);
+	}
+	if (!reloadedShaders.empty()) {
+		drawSubmitter->InvalidateShaders();
+		CheckShaderLayouts();
+	}
+
+	//Update ImGui
+	UpdateGui(deltaTime);
+
+	//Create the ImGui windows
+	{
+		PROFILE_SCOPE("ImGui Windows");
+		MEMORY_TAG_SCOPE(MemoryTag::Tools);
+		CreateWindowInfoGui();
+		CreateInspectorGui();
+		CreateProfilerGui();
+	}
+
+	//Scripted poses replace the simulation while benchmarking, and
+	//otherwise a newly loaded scene's entities arrive a chunk a frame
+	if (benchmarkSuite->IsRunning()) UpdateBenchmark();
+	else StreamSceneChunk();
+
+	//Blend the entities between their last two fixed steps
+	{
+		PROFILE_SCOPE("Interpolate Transforms");
+		InterpolateTransforms(fixedTimestep.GetAlpha());
+	}
+
+	//Refit the tree to where everything ended up
+	{
+		PROFILE_SCOPE("Entity BVH");
+		entityBvh->Update(entityWorldBounds);
+	}
+
+	//A click that doesn't drag the camera around picks an entity
+	Input& input = Input::GetInstance();
+	if (input.MouseLeftPress()) {
+		pickPressX = input.GetMouseX();
+		pickPressY = input.GetMouseY();
+	}
+	if (input.MouseLeftRelease() && std::abs(input.GetMouseX() - pickPressX) + std::abs(input.GetMouseY() - pickPressY) <= 3) {
+		PROFILE_SCOPE("Pick Entity");
+		PickEntity(input.GetMouseX(), input.GetMouseY());
+	}
+
+	//Update the selected camera
+	if (!benchmarkSuite->IsRunning()) cameras[selectedCameraIndex]->Update(deltaTime);
+
+	benchmarkSample.UpdateMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - benchmarkUpdateStart).count();
+
+	// Example input checking: Quit if the escape key is pressed
+	if (Input::GetInstance().KeyDown(VK_ESCAPE))
+		Quit();
+}
+
+// --------------------------------------------------------
+// Blends every entity between its last two fixed steps
+//  - The states are gathered into streams, then blended and
+//     turned into matrices and world bounds in SIMD batches
+//     spread over the job system
+// --------------------------------------------------------
+void Game::InterpolateTransforms(float alpha) {
+	auto start = std::chrono::high_resolution_clock::now();
+
+	size_t count = entities.size();
+	previousTransforms.Resize(count);
+	currentTransforms.Resize(count);
+	renderTransforms.Resize(count);
+	entityLocalBounds.Resize(count);
+	entityWorldBounds.Resize(count);
+	renderWorlds.resize(count);
+	renderWorldInverseTransposes.resize(count);
+	if (count == 0) return;
+
+	for (size_t i = 0; i < count; i++) {
+		XMFLOAT3 position, scale;
+		XMFLOAT4 rotation;
+		std::shared_ptr<Transform> transform = entities[i]->GetTransform();
+
+		transform->GetPreviousState(position, rotation, scale);
+		previousTransforms.Set(i, &position.x, &rotation.x, &scale.x);
+
+		transform->GetState(position, rotation, scale);
+		currentTransforms.Set(i, &position.x, &rotation.x, &scale.x);
+
+		BoundingBox bounds = entities[i]->GetMesh()->GetBounds();
+		entityLocalBounds.Set(i, &bounds.Center.x, &bounds.Extents.x);
+	}
+
+	TransformBatchInput input = { &renderTransforms, &entityLocalBounds, 0 };
+	TransformBatchOutput output = { &renderWorlds[0]._11, &renderWorldInverseTransposes[0]._11, &entityWorldBounds };
+	JobSystem::GetInstance().ParallelFor(count, TRANSFORM_BATCH_GRAIN, [&](size_t begin, size_t end) {
+		TransformBatch::Blend(previousTransforms, currentTransforms, alpha, renderTransforms, begin, end - begin);
+		TransformBatch::Compute(input, output, begin, end - begin);
+	});
+
+	for (size_t i = 0; i < count; i++) {
+		entities[i]->GetTransform()->SetRenderMatrices(renderWorlds[i], renderWorldInverseTransposes[i]);
+	}
+
+	interpolateMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// --------------------------------------------------------
+// Gets an entity's world bounds from this frame's batch
+//  - Entities added since then work them out themselves
+// --------------------------------------------------------
+BoundingBox Game::GetEntityWorldBounds(size_t index) {
+	if (index >= entityWorldBounds.GetCount()) return entities[index]->GetWorldBounds();
+
+	return BoundingBox(
+		XMFLOAT3(entityWorldBounds.CenterX[index], entityWorldBounds.CenterY[index], entityWorldBounds.CenterZ[index]),
+		XMFLOAT3(entityWorldBounds.ExtentX[index], entityWorldBounds.ExtentY[index], entityWorldBounds.ExtentZ[index]));
+}
+
+// --------------------------------------------------------
+// Moves the simulation forward by exactly one fixed step
+//  - Runs zero or more times a frame, before Update()
+// --------------------------------------------------------
+void Game::FixedUpdate(float deltaTime, float totalTime) {
+	PROFILE_SCOPE("Fixed Update");
+
+	//Keep where everything was, to interpolate from
+	for (auto& entity : entities) {
+		entity->GetTransform()->SavePreviousState();
+	}
+
+	//Apply transformations to entities
+	//entities[0]->GetTransform()->SetScale((sin(totalTime) + 2.0f) / 2.0f, (sin(totalTime) + 2.0f) / 2.0f, 0.0f);
+	if (!benchmarkSuite->IsRunning() && !entities.empty()) entities[0]->GetTransform()->Rotate(0.0f, 1.0f * deltaTime, 0.0f);
+}
+
+// --------------------------------------------------------
+// Update ImGui
+// --------------------------------------------------------
+void Game::UpdateGui(float deltaTime) {
+	PROFILE_SCOPE("ImGui Update");
+
+	// Feed fresh input data to ImGui
+	ImGuiIO& io = ImGui::GetIO();
+	io.DeltaTime = deltaTime;
+	io.DisplaySize.x = (float)this->windowWidth;
+	io.DisplaySize.y = (float)this->windowHeight;
+
+	// Reset the frame
+	ImGui_ImplDX11_NewFrame();
+	ImGui_ImplWin32_NewFrame();
+	ImGui::NewFrame();
+
+	// Determine new input capture
+	Input& input = Input::GetInstance();
+	input.SetKeyboardCapture(io.WantCaptureKeyboard);
+	input.SetMouseCapture(io.WantCaptureMouse);
+
+	// Show the demo window
+	//ImGui::ShowDemoWindow();
+}
+
+// --------------------------------------------------------
+// Create Window Information Gui
+// --------------------------------------------------------
+void Game::CreateWindowInfoGui() {
+	ImGui::Begin("Program Information");
+
+	//Display window dimensions
+	ImGui::Text("Window Dimensions: %ux%u", windowWidth, windowHeight);
+
+	//Display FPS
+	ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
+
+	//List of items in dropdown.
+	//Cannot be deleted or manipulated, and will not cause memory leak
+	//(https://stackoverflow.com/questions/2001286/const-char-s-in-c#:~:text=It%20cannot%20be%20deleted%2C%20and%20should%20not%20be%20manipulated.)
+	const char* items[] = { "Unlimited", "30", "60", "120", "144" };
+	const double limits[] = { 0.0, 30.0, 60.0, 120.0, 144.0 };
+
+	int currentItem = 0;
+	for (int i = 0; i < IM_ARRAYSIZE(limits); i++) {
+		if (framePacer.GetTargetFrameRate() == limits[i]) currentItem = i;
+	}
+
+	if (ImGui::Combo("FPS Limit", &currentItem, items, IM_ARRAYSIZE(items))) {
+		framePacer.SetTargetFrameRate(limits[currentItem]);
+	}
+
+	//Create VSync Checkbox
+	ImGui::Checkbox("VSync", &vsync);
+
+	//Create Title Bar Stats Update Checkbox
+	ImGui::Checkbox("Update Title Bar Stats", &titleBarStats);
+
+	//Frame limiter and latency settings
+	if (ImGui::TreeNode("Frame Pacing")) {
+		float spinMs = (float)(framePacer.GetSpinSeconds() * 1000.0);
+		if (ImGui::SliderFloat("Spin Tail (ms)", &spinMs, 0.0f, 5.0f, "%.2f")) {
+			framePacer.SetSpinSeconds(spinMs / 1000.0);
+		}
+
+		ImGui::Checkbox("Wait On Swap Chain", &waitForFrameLatency);
+
+		int frameLatency = (int)maxFrameLatency;
+		if (ImGui::SliderInt("Max Frame Latency", &frameLatency, 1, 16)) {
+			SetMaximumFrameLatency((unsigned int)frameLatency);
+		}
+
+		const std::vector<float>& frameTimes = framePacer.GetFrameTimeHistory();
+		ImGui::PlotLines("Frame Interval (ms)", frameTimes.data(), framePacer.GetHistoryCount(), framePacer.GetHistoryOffset(), 0, 0.0f, FLT_MAX, ImVec2(0, 60));
+
+		ImGui::Text("High Resolution Timer: %s", frameClock.IsHighResolution() ? "Yes" : "No");
+		ImGui::Text("Average Interval: %.3f ms", framePacer.GetAverageFrameTime());
+		ImGui::Text("Jitter (Std Dev): %.3f ms", framePacer.GetJitter());
+		ImGui::Text("Max Deviation: %.3f ms", framePacer.GetMaxDeviation());
+		ImGui::Text("Average Wake Error: %.3f ms", framePacer.GetAverageWakeError());
+		ImGui::Text("Missed Deadlines: %u", framePacer.GetMissedDeadlines());
+		ImGui::TreePop();
+	}
+
+	//Fixed timestep settings
+	if (ImGui::TreeNode("Simulation")) {
+		int stepRate = (int)(1.0 / fixedTimestep.GetStepSeconds() + 0.5);
+		if (ImGui::SliderInt("Step Rate (Hz)", &stepRate, 10, 240)) {
+			fixedTimestep.SetStepSeconds(1.0 / stepRate);
+		}
+
+		int maxSteps = (int)fixedTimestep.GetMaxSteps();
+		if (ImGui::SliderInt("Max Steps Per Frame", &maxSteps, 1, 20)) {
+			fixedTimestep.SetMaxSteps((unsigned int)maxSteps);
+		}
+
+		ImGui::Text("Steps Last Frame: %u", fixedTimestep.GetLastStepCount());
+		ImGui::Text("Interpolation Alpha: %.2f", fixedTimestep.GetAlpha());
+		ImGui::Text("Time Dropped: %.3f s", fixedTimestep.GetDroppedSeconds());
+
+		//Batched interpolation
+		int mathPath = (int)TransformBatch::GetPath();
+		const char* mathPaths[(int)MathPath::Count];
+		for (int i = 0; i < (int)MathPath::Count; i++) {
+			mathPaths[i] = TransformBatch::IsPathAvailable((MathPath)i) ? TransformBatch::GetPathName((MathPath)i) : "(Not Available)";
+		}
+		if (ImGui::Combo("Math Path", &mathPath, mathPaths, IM_ARRAYSIZE(mathPaths))) {
+			TransformBatch::SetPath((MathPath)mathPath);
+		}
+		ImGui::Text("Best Path For This CPU: %s", TransformBatch::GetPathName(TransformBatch::GetBestPath()));
+		ImGui::Text("Interpolate: %.3f ms for %u entities", interpolateMilliseconds, (unsigned int)entities.size());
+
+		//Quaternion rotations against the old Euler angles
+		if (ImGui::Button("Measure Rotations")) {
+			rotationMeasurement = Transform::MeasureRotations(100000);
+		}
+		if (rotationMeasurement.Rotations > 0) {
+			ImGui::Text("Rotate + Move: %.1f ns quaternion, %.1f ns Euler",
+				rotationMeasurement.QuaternionNanoseconds,
+				rotationMeasurement.EulerNanoseconds);
+			ImGui::Text("Drift over %u turns: norm %.2e, basis %.2e, from Euler %.2e",
+				rotationMeasurement.Rotations,
+				rotationMeasurement.MaxNormError,
+				rotationMeasurement.MaxBasisError,
+				rotationMeasurement.MaxEulerDifference);
+		}
+		ImGui::TreePop();
+	}
+
+	ImGui::End();
+}
+
+// --------------------------------------------------------
+// Create Mesh Gui
+// --------------------------------------------------------
+void Game::CreateInspectorGui() {
+	ImGui::Begin("Game Inspector");
+
+	//Scene file, its compiled form, and the load time test
+	if (ImGui::TreeNode("Scene")) {
+		//The text and binary forms sit side by side
+		std::wstring sceneBasePath = scenePath.substr(0, scenePath.rfind(L'.'));
+		std::wstring sceneTextPath = sceneBasePath + L".scene";
+		std::wstring sceneBinaryPath = sceneBasePath + L".scenebin";
+
+		ImGui::Text("File: %s", WideToNarrow(scenePath).c_str());
+		if (scene) {
+			ImGui::Text("Form: %s (%.2f MB)", scene->IsMapped() ? "Binary, mapped" : "Text", scene->GetByteSize() / (1024.0f * 1024.0f));
+			ImGui::Text("Entities: %u / %u", (unsigned int)sceneEntitiesLoaded, (unsigned int)scene->GetEntityCount());
+		}
+		ImGui::Text("Load: %.3f ms, then a chunk of %d entities per frame", sceneLoadMilliseconds, SCENE_STREAM_CHUNK_SIZE);
+
+		bool running = benchmarkSuite->IsRunning();
+		if (running) ImGui::BeginDisabled();
+		if (ImGui::Button("Load Text")) LoadScene(sceneTextPath);
+		ImGui::SameLine();
+		if (ImGui::Button("Load Binary")) LoadScene(sceneBinaryPath);
+		ImGui::SameLine();
+		if (ImGui::Button("Compile Binary") && scene && !scene->WriteBinary(sceneBinaryPath)) {
+			sceneError = "Couldn't write " + WideToNarrow(sceneBinaryPath);
+		}
+		if (running) ImGui::EndDisabled();
+
+		if (!sceneError.empty()) {
+			ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", sceneError.c_str());
+		}
+
+		if (ImGui::Button("Measure 100k Entity Load")) {
+			sceneLoadTimings = SceneFile::Measure(100000, FixPath(L"SceneLoadTest.scene"), FixPath(L"SceneLoadTest.scenebin"));
+			sceneLoadMeasured = sceneLoadTimings.Error.empty();
+			if (!sceneLoadMeasured) sceneError = sceneLoadTimings.Error;
+		}
+
+		if (sceneLoadMeasured) {
+			const SceneLoadTimings& timings = sceneLoadTimings;
+			ImGui::Text("Entities: %u", (unsigned int)timings.EntityCount);
+			ImGui::Text("Text: %.2f MB, parsed in %.2f ms", timings.TextBytes / (1024.0f * 1024.0f), timings.TextParseMilliseconds);
+			ImGui::Text("Binary: %.2f MB, mapped in %.3f ms", timings.BinaryBytes / (1024.0f * 1024.0f), timings.BinaryMapMilliseconds);
+			ImGui::Text("Stream: %.2f ms over %u chunks (longest %.3f ms)",
+				timings.StreamMilliseconds, timings.ChunkCount, timings.LongestChunkMilliseconds);
+		}
+
+		ImGui::TreePop();
+	}
+
+	//Create the root node for shader variants
+	if (ImGui::TreeNode("Shader Variants")) {
+		ImGui::Text("Manifest: %u shaders, %u variants", (unsigned int)shaderManifest.GetShaderCount(), (unsigned int)shaderManifest.GetVariantCount());
+		ImGui::Text("Loaded: %u, used by %u of %u materials",
+			(unsigned int)shaderVariants.size(), (unsigned int)materialsOnVariants, (unsigned int)materials.size());
+
+		if (ImGui::Checkbox("Use Shader Variants", &useShaderVariants)) SelectShaderVariants();
+		if (ImGui::Button("Build Shader Variants")) BuildShaderVariants();
+
+		if (!shaderVariantStatus.empty()) {
+			ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", shaderVariantStatus.c_str());
+		}
+
+		ImGui::TreePop();
+	}
+
+	//Create the root node for shader layouts
+	if (ImGui::TreeNode("Shader Layouts")) {
+		if (shaderLayoutErrors.empty()) {
+			ImGui::Text("Every shader matches " SHADER_STRUCTS_FILE);
+		}
+
+		for (const std::string& error : shaderLayoutErrors) {
+			ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", error.c_str());
+		}
+
+		if (ImGui::Button("Generate Shader Structs")) GenerateShaderStructs();
+		if (!shaderStructStatus.empty()) ImGui::Text("%s", shaderStructStatus.c_str());
+
+		ImGui::TreePop();
+	}
+
+	//Create the root node for shader hot reload
+	if (ImGui::TreeNode("Shader Hot Reload")) {
+		ImGui::Text("Watching %u shaders, %u files",
+			(unsigned int)shaderHotReload->GetWatchedCount(), (unsigned int)shaderHotReload->GetFileCount());
+		ImGui::Text("Compiles: %u, reloads: %u", shaderHotReload->GetCompileCount(), shaderHotReload->GetReloadCount());
+
+		std::string reloadError = shaderHotReload->GetLastError();
+		if (!reloadError.empty()) {
+			ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", reloadError.c_str());
+		}
+
+		ImGui::TreePop();
+	}
+
+	//Create the root node for entities, opening it and the picked
+	//entity's node when something's just been clicked on
+	if (revealSelection) ImGui::SetNextItemOpen(true);
+	if (ImGui::TreeNode("Entities")) {
+		int index = 0;
+		//Loop through each mesh and make a node for it with child properties
+		for (auto& entity : entities) {
+			bool selected = index == selectedEntityIndex;
+			if (selected && revealSelection) ImGui::SetNextItemOpen(true);
+
+			bool open = ImGui::TreeNodeEx((void*)(intptr_t)index, selected ? ImGuiTreeNodeFlags_Selected : 0, "Entity %d (%d indices)", index, entity->GetMesh()->GetIndexCount());
+			if (selected && revealSelection) ImGui::SetScrollHereY();
+
+			if (open) {
+				auto entityTint = entity->GetMaterial()->GetColorTint();
+				auto entityPosition = entity->GetTransform()->GetPosition();
+				auto entityRotation = entity->GetTransform()->GetPitchYawRoll();
+				auto entityScale = entity->GetTransform()->GetScale();
+
+				//Mesh Color
+				if (ImGui::ColorEdit4("Tint", &entityTint.x)) {
+					entity->GetMaterial()->SetColorTint(entityTint);
+				}
+
+				//Entity Position
+				if (ImGui::DragFloat3("Position", &entityPosition.x, 0.005f)) {
+					entity->GetTransform()->SetPosition(entityPosition);
+				}
+
+				//Entity Rotation
+				if (ImGui::DragFloat3("Rotation", &entityRotation.x, 0.005f)) {
+					entity->GetTransform()->SetRotation(entityRotation);
+				}
 
 				//Entity Scale
 				if (ImGui::DragFloat3("Scale", &entityScale.x, 0.005f)) {
 					entity->GetTransform()->SetScale(entityScale);
 				}
 
+				//Static entities have their shadows cached
+				bool entityStatic = entity->IsStatic();
+				if (ImGui::Checkbox("Static", &entityStatic)) {
+					entity->SetStatic(entityStatic);
+					staticShadowsDirty = true;
+				}
+
 				ImGui::TreePop();
 			}
 
@@ -966,6 +1924,7 @@ void Game::CreateInspectorGui() {
 		}
 		ImGui::TreePop();
 	}
+	revealSelection = false;
 
 	//Create the root node for cameras
 	if (ImGui::TreeNode("Cameras")) {
@@ -996,7 +1955,7 @@ void Game::CreateInspectorGui() {
 		int index = 0;
 
 		//Loop through each camera and make a node for it with child properties
-		for (std::shared_ptr<Camera> camera : cameras) {
+		for (auto& camera : cameras) {
 			if (ImGui::TreeNode((void*)(intptr_t)index, "Camera %d %s", index, (selectedCameraIndex == index ? "(Selected)" : ""))) {
 				auto cameraPosition = camera->GetTransform()->GetPosition();
 				auto cameraRotation = camera->GetTransform()->GetPitchYawRoll();
@@ -1041,10 +2000,28 @@ void Game::CreateInspectorGui() {
 	if (ImGui::TreeNode("Lights")) {
 		ImGui::ColorEdit3("Ambient Light", &ambientColor.x);
 
+		if (ImGui::DragInt("Random Lights", &randomLightCount, 1.0f, 0, 4096)) {
+			CreateRandomLights(randomLightCount);
+		}
+
+		//Clustered lighting stats
+		ImGui::Text("Clustered Lights: %u of %u", lightClusters->GetBinnedLightCount(), lightClusters->GetLightCount());
+		ImGui::Text("Cluster Light Indices: %u", lightClusters->GetLightIndexCount());
+		ImGui::Text("Max Lights Per Cluster: %u", lightClusters->GetMaxLightsPerCluster());
+		ImGui::Text("Binning: %.3f ms (%u threads)", lightClusters->GetBuildMilliseconds(), lightClusters->GetThreadCount());
+
+		//Per entity culling stats
+		ImGui::Checkbox("Per-Entity Light Culling", &cullEntityLights);
+		ImGui::Text("Entity Light Tests: %u (%u culled)", lightClusters->GetEntityLightTests(), lightClusters->GetEntityLightsCulled());
+		ImGui::Text("Entity Culling: %.3f ms", entityLightCullMilliseconds);
+
 		int index = 0;
 
 		//Loop through each light and make a node for it with child properties
-		for (Light* light : lights) {
+		//  - Random lights are left out so thousands of them don't flood the list
+		for (unsigned int i = 0; i < baseLightCount; i++) {
+			Light* light = &lights[i];
+
 			if (ImGui::TreeNode((void*)(intptr_t)index, "Light %d", index)) {
 				ImGui::Text("Type: %s", (light->Type == 0 ? "Directional" : (light->Type == 1 ? "Point" : "Spot")));
 				if (ImGui::DragFloat3("Direction", &light->Direction.x, 0.005f)) {
@@ -1072,60 +2049,559 @@ void Game::CreateInspectorGui() {
 
 	//Create the root node for post processing
 	if (ImGui::TreeNode("Post Processing")) {
-		ImGui::DragInt("Blur Radius", &blurRadius, 1.0f, 0, 10);
+		const char* blurTypes[] = { "Box", "Gaussian" };
+
+		ImGui::DragInt("Blur Radius", &blurRadius, 1.0f, 0, MAX_BLUR_RADIUS);
+		ImGui::Combo("Blur Type", &blurType, blurTypes, IM_ARRAYSIZE(blurTypes));
+		ImGui::Checkbox("Compute Shader Blur", &useComputeBlur);
+
+		if (ImGui::TreeNode("Render Targets")) {
+			ImGui::Text("Passes: %u of %u executed", postProcessGraph->GetExecutedPassCount(), postProcessGraph->GetPassCount());
+			ImGui::Text("Pooled Textures: %u (%u created)", renderTargetPool->GetTextureCount(), renderTargetPool->GetTexturesCreated());
+			ImGui::Text("Pool Memory: %.2f MB", renderTargetPool->GetAllocatedBytes() / (1024.0f * 1024.0f));
+			ImGui::Text("Pool Peak Memory: %.2f MB", renderTargetPool->GetPeakAllocatedBytes() / (1024.0f * 1024.0f));
+			ImGui::Text("Graph Peak Transient Memory: %.2f MB", postProcessPeakBytes / (1024.0f * 1024.0f));
+			ImGui::TreePop();
+		}
+
 		ImGui::TreePop();
 	}
 
 	//Shadow Map Inspector
+	if (ImGui::TreeNode("Shadows")) {
+		ImGui::Text("Casters Drawn: %d", shadowCastersDrawn);
+		ImGui::Text("Casters Culled: %d", shadowCastersCulled);
+		ImGui::Text("BVH Candidates: %u of %u entities", (unsigned int)shadowCasterCandidates.size(), (unsigned int)entities.size());
+		ImGui::Text("Static Re-renders Skipped: %u", staticShadowRendersSkipped);
+		ImGui::TreePop();
+	}
+
+	//Entity bounds tree, and its benchmark
+	if (ImGui::TreeNode("Scene BVH")) {
+		ImGui::Text("Entities: %u (%u waiting for a rebuild)", (unsigned int)entityBvh->GetItemCount(), (unsigned int)entityBvh->GetUnindexedCount());
+		ImGui::Text("Nodes: %u (%u leaves)", (unsigned int)entityBvh->GetNodeCount(), (unsigned int)entityBvh->GetLeafCount());
+		ImGui::Text("SAH Cost: %.2fx built", entityBvh->GetCostRatio());
+		ImGui::Text("Refit: %.3f ms", entityBvh->GetRefitMilliseconds());
+		ImGui::Text("Last Build: %.3f ms", entityBvh->GetBuildMilliseconds());
+		ImGui::Text("Rebuilds: %u%s", entityBvh->GetRebuildCount(), entityBvh->IsRebuilding() ? " (one running)" : "");
+
+		const char* sizes[] = { "10k", "100k", "1M" };
+		const size_t sizeCounts[] = { 10000, 100000, 1000000 };
+		ImGui::Combo("Benchmark Entities", &bvhMeasureSize, sizes, IM_ARRAYSIZE(sizes));
+		if (ImGui::Button("Run BVH Benchmark")) {
+			bvhMeasurement = SceneBvh::Measure(sizeCounts[bvhMeasureSize], 10000);
+		}
+
+		if (bvhMeasurement.Items > 0) {
+			ImGui::Text("Build: %.1f ms, refit: %.2f ms (cost %.2fx)", bvhMeasurement.BuildMilliseconds, bvhMeasurement.RefitMilliseconds, bvhMeasurement.RefitCostRatio);
+			ImGui::Text("Frustums: %.0f / s", bvhMeasurement.FrustumQueriesPerSecond);
+			ImGui::Text("Spheres: %.0f / s (%.1f / s checking every entity)", bvhMeasurement.SphereQueriesPerSecond, bvhMeasurement.BruteForceQueriesPerSecond);
+			ImGui::Text("Rays: %.0f / s", bvhMeasurement.RayQueriesPerSecond);
+			if (bvhMeasurement.Mismatches > 0) {
+				ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%u queries didn't match checking every entity", bvhMeasurement.Mismatches);
+			}
+		}
+
+		ImGui::TreePop();
+	}
+
+	//Picking, and the ray caster's benchmark
+	if (ImGui::TreeNode("Ray Casting")) {
+		if (selectedEntityIndex >= 0) {
+			ImGui::Text("Picked: Entity %d, %.2f units away", selectedEntityIndex, pickDistance);
+			if (ImGui::Button("Clear Selection")) selectedEntityIndex = -1;
+		}
+		else {
+			ImGui::Text("Picked: Nothing (click the scene)");
+		}
+		ImGui::Text("Pick Time: %.1f us", pickMicroseconds);
+
+		const char* sizes[] = { "10k", "100k", "1M" };
+		const size_t sizeCounts[] = { 10000, 100000, 1000000 };
+		ImGui::Combo("Benchmark Instances", &rayMeasureSize, sizes, IM_ARRAYSIZE(sizes));
+		if (ImGui::Button("Run Ray Benchmark")) {
+			std::vector<std::shared_ptr<MeshBvh>> meshBvhs;
+			for (auto& mesh : meshes) meshBvhs.push_back(mesh->GetBvh());
+			rayMeasurement = RayCaster::Measure(meshBvhs, sizeCounts[rayMeasureSize], 100000);
+		}
+
+		if (rayMeasurement.Instances > 0) {
+			ImGui::Text("%u rays, %u triangles", rayMeasurement.Rays, (unsigned int)rayMeasurement.Triangles);
+			ImGui::Text("Batched: %.0f rays / s (%s, %u threads)", rayMeasurement.RaysPerSecond, rayMeasurement.Path, JobSystem::GetInstance().GetThreadCount());
+			ImGui::Text("One Thread: %.0f rays / s", rayMeasurement.SingleThreadRaysPerSecond);
+			ImGui::Text("Scalar: %.0f rays / s", rayMeasurement.ScalarRaysPerSecond);
+			ImGui::Text("Every Triangle: %.2f rays / s", rayMeasurement.BruteForceRaysPerSecond);
+			ImGui::Text("Hits: %u", rayMeasurement.Hits);
+			if (rayMeasurement.Mismatches > 0) {
+				ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%u rays didn't match the scalar kernel or every triangle", rayMeasurement.Mismatches);
+			}
+		}
+
+		ImGui::TreePop();
+	}
+
+	//Deferred context submission
+	if (ImGui::TreeNode("Draw Submission")) {
+		ImGui::Checkbox("Parallel Submission", &useParallelDraws);
+		ImGui::Text("Threads: %u", drawSubmitter->GetThreadCount());
+		ImGui::Text("Driver Command Lists: %s", drawSubmitter->HasDriverCommandLists() ? "Yes" : "No (emulated)");
+
+		if (useParallelDraws) {
+			ImGui::Text("Command Lists: %u", drawSubmitter->GetCommandListCount());
+			ImGui::Text("Record: %.3f ms", drawSubmitter->GetRecordMilliseconds());
+			ImGui::Text("Execute: %.3f ms", drawSubmitter->GetExecuteMilliseconds());
+		}
+
+		ImGui::TreePop();
+	}
+
+	//Commands that went through the render device
+	if (ImGui::TreeNode("Render Device")) {
+		const RenderDeviceStats& stats = renderDevice->GetLastFrameStats();
+		ImGui::Text("Draw Calls: %u", stats.DrawCalls);
+		ImGui::Text("Primitives: %u", stats.Primitives);
+		ImGui::Text("State Changes: %u", stats.StateChanges);
+		ImGui::Text("Redundant Binds Skipped: %u", stats.RedundantStateChanges);
+		ImGui::Text("Buffer Updates: %u (%llu bytes)", stats.BufferUpdates, (unsigned long long)stats.BytesUploaded);
+
+		//Parallel draws record into deferred devices, so they aren't captured
+		if (ImGui::Button("Capture Frame")) {
+			captureRenderFrame = true;
+		}
+
+		const std::vector<RenderCommand>& commands = renderRecorder->GetCommands();
+		ImGui::Text("Captured Commands: %zu", commands.size());
+
+		if (!commands.empty() && ImGui::BeginChild("RenderCommands", ImVec2(0, 200), true)) {
+			ImGuiListClipper clipper;
+			clipper.Begin((int)commands.size());
+			while (clipper.Step()) {
+				for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+					const RenderCommand& command = commands[i];
+					ImGui::Text("%5d  %-20s  slot %u  id %u  count %u",
+						i,
+						RecordingRenderDevice::GetCommandName(command.Type),
+						command.Slot,
+						command.Handle,
+						command.Count);
+				}
+			}
+		}
+		if (!commands.empty()) ImGui::EndChild();
+
+		ImGui::TreePop();
+	}
+
+	//Streams frames to a binary trace, and replays them
+	if (ImGui::TreeNode("Command Trace")) {
+		ImGui::SliderInt("Frames", &traceFrameCount, 1, 120);
+
+		bool busy = commandTrace->IsPending() || commandTrace->IsCapturing();
+		if (busy) ImGui::BeginDisabled();
+		if (ImGui::Button("Capture")) {
+			commandTrace->Start(FixPath(L"Capture.dxtrace"), traceFrameCount);
+		}
+		if (busy) ImGui::EndDisabled();
+
+		ImGui::SameLine();
+		if (ImGui::Button("Replay (Null)") && traceReplayer->Load(FixPath(L"Capture.dxtrace"))) {
+			RecordingRenderDevice nullDevice;
+			nullDevice.SetRecording(false);
+			traceReplayStats = traceReplayer->Replay(nullDevice);
+			traceReplayTarget = "Null";
+		}
+
+		//Replays onto its own device, so its resources go with it
+		ImGui::SameLine();
+		if (ImGui::Button("Replay (D3D11)") && traceReplayer->Load(FixPath(L"Capture.dxtrace"))) {
+			D3D11RenderDevice replayDevice(device, context);
+			traceReplayStats = traceReplayer->Replay(replayDevice);
+			traceReplayTarget = "D3D11";
+			renderDevice->InvalidateState();
+		}
+
+		const CommandTraceStats& stats = commandTrace->GetStats();
+		ImGui::Text("Status: %s", commandTrace->IsCapturing() ? "Capturing" : busy ? "Waiting for frame" : "Idle");
+		ImGui::Text("Frames: %u  Records: %u  Commands: %u", stats.Frames, stats.Records, stats.Commands);
+		ImGui::Text("Buffer Copies: %u (%u deltas, %u unchanged)", stats.BufferCopies, stats.DeltaBufferCopies, stats.UnchangedBufferCopies);
+		ImGui::Text("Buffer Bytes: %llu raw, %llu written",
+			(unsigned long long)stats.BufferBytesRaw,
+			(unsigned long long)stats.BufferBytesWritten);
+		ImGui::Text("File: %llu bytes, peak %zu blocks queued",
+			(unsigned long long)commandTrace->GetBytesWritten(),
+			commandTrace->GetPeakQueuedBlocks());
+
+		if (!traceReplayer->GetError().empty()) {
+			ImGui::Text("Replay Error: %s", traceReplayer->GetError().c_str());
+		}
+
+		if (traceReplayTarget) {
+			ImGui::Separator();
+			ImGui::Text("Last Replay: %s device", traceReplayTarget);
+			ImGui::Text("Frames: %u  Records: %u  Commands: %u", traceReplayStats.Frames, traceReplayStats.Records, traceReplayStats.Commands);
+			ImGui::Text("Resources Created: %u  Unresolved: %u", traceReplayStats.ResourcesCreated, traceReplayStats.UnresolvedHandles);
+			ImGui::Text("Total: %.3f ms  Frame: %.3f ms avg, %.3f ms max",
+				traceReplayStats.TotalMilliseconds,
+				traceReplayStats.AverageFrameMilliseconds,
+				traceReplayStats.MaxFrameMilliseconds);
+			ImGui::Text("Draw Calls: %u  State Changes: %u  Buffer Updates: %u",
+				traceReplayStats.DeviceTotals.DrawCalls,
+				traceReplayStats.DeviceTotals.StateChanges,
+				traceReplayStats.DeviceTotals.BufferUpdates);
+		}
+
+		ImGui::TreePop();
+	}
+
+	//Generated scenes, measured frame by frame
+	if (ImGui::TreeNode("Benchmark")) {
+		bool running = benchmarkSuite->IsRunning();
+
+		if (running) ImGui::BeginDisabled();
+		ImGui::Checkbox("Null Device", &benchmarkNullDevice);
+		if (ImGui::Button("Run Suite")) StartBenchmark();
+		if (running) ImGui::EndDisabled();
+
+		if (running) {
+			ImGui::SameLine();
+			if (ImGui::Button("Stop")) FinishBenchmark();
+
+			const BenchmarkSceneDesc* scene = benchmarkSuite->GetCurrentScene();
+			if (scene) {
+				ImGui::Text("Scene: %s", scene->Name.c_str());
+				ImGui::Text("Frame: %d / %d%s",
+					benchmarkSuite->GetCurrentFrame(),
+					scene->WarmupFrames + scene->FrameCount,
+					benchmarkSuite->IsWarmingUp() ? " (warming up)" : "");
+			}
+		}
+		else if (benchmarkResultsWritten) {
+			ImGui::Text("Wrote BenchmarkResults.json and BenchmarkResults.csv");
+		}
+
+		const std::vector<BenchmarkSceneResult>& results = benchmarkSuite->GetResults();
+		if (!results.empty() && ImGui::BeginTable("BenchmarkResults", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+			ImGui::TableSetupColumn("Scene");
+			ImGui::TableSetupColumn("Avg ms");
+			ImGui::TableSetupColumn("P95 ms");
+			ImGui::TableSetupColumn("P99 ms");
+			ImGui::TableSetupColumn("Draws");
+			ImGui::TableSetupColumn("Peak MB");
+			ImGui::TableHeadersRow();
+
+			for (const BenchmarkSceneResult& result : results) {
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn(); ImGui::Text("%s", result.Scene.Name.c_str());
+				ImGui::TableNextColumn(); ImGui::Text("%.3f", result.AverageFrameMilliseconds);
+				ImGui::TableNextColumn(); ImGui::Text("%.3f", result.P95FrameMilliseconds);
+				ImGui::TableNextColumn(); ImGui::Text("%.3f", result.P99FrameMilliseconds);
+				ImGui::TableNextColumn(); ImGui::Text("%.0f", result.AverageDrawCalls);
+				ImGui::TableNextColumn(); ImGui::Text("%.1f", result.PeakWorkingSetBytes / (1024.0 * 1024.0));
+			}
+
+			ImGui::EndTable();
+		}
+
+		ImGui::TreePop();
+	}
+
+	//CPU reference render of the current view
+	if (ImGui::TreeNode("Software Renderer")) {
+		ImGui::SliderFloat("Resolution Scale", &softwareResolutionScale, 0.1f, 1.0f);
+		ImGui::SliderInt("Benchmark Iterations", &softwareBenchmarkIterations, 1, 100);
+
+		if (ImGui::Button("Render")) RenderSoftwareFrame(0);
+		ImGui::SameLine();
+		if (ImGui::Button("Benchmark")) RenderSoftwareFrame(softwareBenchmarkIterations);
+
+		if (softwareRasterizer) {
+			ImGui::SameLine();
+			if (ImGui::Button("Save Image")) {
+				softwareImageSaved = softwareRasterizer->SaveImage(FixPath(L"SoftwareRender.bmp"));
+			}
+
+			//Keep an image to diff later renders against
+			ImGui::SameLine();
+			if (ImGui::Button("Set As Reference")) {
+				softwareReferenceImage = softwareRasterizer->GetImage();
+				softwareImageDiff = SoftwareImageDiff();
+			}
+
+			if (!softwareReferenceImage.empty()) {
+				ImGui::SameLine();
+				if (ImGui::Button("Compare")) {
+					softwareImageDiff = SoftwareRasterizer::Compare(softwareRasterizer->GetImage(), softwareReferenceImage, 2);
+				}
+			}
+
+			if (softwareImageSaved) ImGui::Text("Saved SoftwareRender.bmp");
+
+			const SoftwareRasterStats& stats = softwareRasterizer->GetStats();
+			ImGui::Text("Resolution: %d x %d", softwareRasterizer->GetWidth(), softwareRasterizer->GetHeight());
+			ImGui::Text("Triangles: %u in, %u culled, %u clipped", stats.TrianglesIn, stats.TrianglesCulled, stats.TrianglesClipped);
+			ImGui::Text("Tile Bin Entries: %u", stats.TileBins);
+			ImGui::Text("Pixels: %llu tested, %llu shaded", (unsigned long long)stats.PixelsTested, (unsigned long long)stats.PixelsShaded);
+			ImGui::Text("Blocks Skipped By Depth: %llu", (unsigned long long)stats.BlocksSkipped);
+			ImGui::Text("Vertex: %.3f ms  Bin: %.3f ms  Raster: %.3f ms", stats.VertexMilliseconds, stats.BinMilliseconds, stats.RasterMilliseconds);
+			ImGui::Text("Total: %.3f ms", stats.TotalMilliseconds);
+			ImGui::Text("Triangles/sec: %.2f M", stats.TrianglesPerSecond / 1000000.0);
+			ImGui::Text("Pixels/sec: %.2f M", stats.PixelsPerSecond / 1000000.0);
+
+			if (softwareImageDiff.SizesMatch) {
+				ImGui::Text("Diff: max %d, mean %.3f, %u pixels over tolerance",
+					softwareImageDiff.MaxError,
+					softwareImageDiff.MeanError,
+					softwareImageDiff.PixelsOverTolerance);
+			}
+
+			if (softwareSRV) {
+				float imageWidth = 512.0f;
+				float imageHeight = imageWidth * softwareRasterizer->GetHeight() / softwareRasterizer->GetWidth();
+				ImGui::Image(softwareSRV.Get(), ImVec2(imageWidth, imageHeight));
+			}
+		}
+
+		ImGui::TreePop();
+	}
+
 	ImGui::Image(shadowSRV.Get(), ImVec2(512, 512));
 
 	ImGui::End();
 }
 
 // --------------------------------------------------------
-// Clear the screen, redraw everything, present to the user
+// Create Profiler Gui
+//  - Flame graph of one frame, with a timeline per thread
+//  - Per zone percentiles across the frame history
 // --------------------------------------------------------
-void Game::Draw(float deltaTime, float totalTime) {
+void Game::CreateProfilerGui() {
+	Profiler& profiler = Profiler::GetInstance();
 
-	//Clear the shadow map
-	context->ClearDepthStencilView(shadowDSV.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
+	ImGui::Begin("Profiler");
 
-	//Set up output merger stage
-	ID3D11RenderTargetView* nullRTV{};
-	context->OMSetRenderTargets(1, &nullRTV, shadowDSV.Get());
+	bool paused = profiler.IsPaused();
+	if (ImGui::Checkbox("Pause", &paused)) {
+		profiler.SetPaused(paused);
+	}
 
-	//Deactivate pixel shader
-	context->PSSetShader(0, 0, 0);
+	ImGui::SameLine();
+	if (ImGui::Button("Export Chrome Trace")) {
+		profiler.ExportChromeTrace("ChromeTrace.json");
+	}
 
-	//Change viewport
-	D3D11_VIEWPORT viewport = {};
-	viewport.Width = (float)shadowMapResolution;
-	viewport.Height = (float)shadowMapResolution;
-	viewport.MaxDepth = 1.0f;
-	context->RSSetViewports(1, &viewport);
+	ImGui::SameLine();
+	if (ImGui::Button("Measure Zone Overhead")) {
+		profilerZoneOverhead = profiler.MeasureZoneOverhead(1000000);
+	}
 
-	//Before rendering shadow map, enable rasterizer state
-	context->RSSetState(shadowRasterizer.Get());
+	if (profilerZoneOverhead > 0.0) {
+		ImGui::Text("Zone Overhead: %.1f ns", profilerZoneOverhead);
+	}
 
-	//Entity render loop
-	vertexShaders[2]->SetShader();
-	vertexShaders[2]->SetMatrix4x4("view", lightViewMatrix);
-	vertexShaders[2]->SetMatrix4x4("projection", lightProjectionMatrix);
+	ImGui::Text("Dropped Zones: %u", profiler.GetDroppedZones());
+	ImGui::Text("GPU Frame: %.3f ms (%u frames skipped)", gpuProfiler->GetFrameMilliseconds(), gpuProfiler->GetFramesSkipped());
 
-	// Loop and draw all entities
-	for (auto& e : entities) {
-		vertexShaders[2]->SetMatrix4x4("world", e->GetTransform()->GetWorldMatrix());
-		vertexShaders[2]->CopyAllBufferData();
+	JobSystem& jobSystem = JobSystem::GetInstance();
+	ImGui::Text("Job Threads: %u", jobSystem.GetThreadCount());
+	ImGui::Text("Jobs Run: %u (%u stolen)", jobSystem.GetJobsRun(), jobSystem.GetJobsStolen());
 
-		// Draw the mesh directly to avoid the entity's material
-		// Note: Your code may differ significantly here!
-		e->GetMesh()->Draw();
+	unsigned int frameCount = profiler.GetFrameCount();
+	if (frameCount == 0) {
+		ImGui::End();
+		return;
 	}
 
-	//Disable shadow map rasterizer state
-	context->RSSetState(0);
+	//Frame time graph, oldest first
+	float frameTimes[PROFILER_HISTORY_FRAMES] = {};
+	for (unsigned int i = 0; i < frameCount; i++) {
+		const ProfileFrame& frame = profiler.GetFrame(frameCount - 1 - i);
+		frameTimes[i] = (frame.End - frame.Start) / 1000000.0f;
+	}
+	ImGui::PlotLines("Frame Times (ms)", frameTimes, (int)frameCount, 0, 0, 0.0f, FLT_MAX, ImVec2(0, 60));
+
+	//Pick which frame the flame graph shows
+	profilerFramesAgo = (std::min)(profilerFramesAgo, (int)frameCount - 1);
+	ImGui::SliderInt("Frames Ago", &profilerFramesAgo, 0, (int)frameCount - 1);
+
+	const ProfileFrame& frame = profiler.GetFrame(profilerFramesAgo);
+	float frameMilliseconds = (frame.End - frame.Start) / 1000000.0f;
+	ImGui::Text("Frame Time: %.3f ms", frameMilliseconds);
+
+	//Flame graph
+	if (ImGui::TreeNodeEx("Flame Graph", ImGuiTreeNodeFlags_DefaultOpen)) {
+		const float rowHeight = ImGui::GetTextLineHeight() + 4.0f;
+		float width = ImGui::GetContentRegionAvail().x;
+		double nanosecondsToPixels = width / (double)(frame.End - frame.Start);
+
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+		std::vector<std::string> threadNames = profiler.GetThreadNames();
+
+		for (unsigned int thread = 0; thread < threadNames.size(); thread++) {
+			//Only show timelines with something to show
+			//  - Timelines read back late (like the GPU's) hold an
+			//    earlier frame, so they're drawn from their first zone
+			unsigned int rows = 0;
+			uint64_t timelineStart = frame.Start;
+			for (const ProfileEvent& event : frame.Events) {
+				if (event.Thread == thread) {
+					rows = (std::max)(rows, event.Depth + 1);
+					timelineStart = (std::min)(timelineStart, event.Start);
+				}
+			}
+
+			if (rows == 0) {
+				continue;
+			}
+
+			ImGui::TextUnformatted(threadNames[thread].c_str());
+			ImVec2 origin = ImGui::GetCursorScreenPos();
+
+			for (const ProfileEvent& event : frame.Events) {
+				if (event.Thread != thread) {
+					continue;
+				}
+
+				//Zones from other threads can finish a little after the frame
+				float x0 = origin.x + (float)((event.Start - timelineStart) * nanosecondsToPixels);
+				float x1 = origin.x + (float)((event.End - timelineStart) * nanosecondsToPixels);
+				x0 = (std::min)(x0, origin.x + width - 1.0f);
+				x1 = (std::min)((std::max)(x1, x0 + 1.0f), origin.x + width);
+
+				ImVec2 min(x0, origin.y + event.Depth * rowHeight);
+				ImVec2 max(x1, min.y + rowHeight - 1.0f);
+
+				//Color by name, so a zone keeps its color between frames
+				unsigned int hash = 2166136261u;
+				for (const char* c = event.Name; *c; c++) {
+					hash = (hash ^ (unsigned char)*c) * 16777619u;
+				}
+				ImU32 color = IM_COL32(100 + hash % 120, 100 + (hash >> 8) % 120, 100 + (hash >> 16) % 120, 255);
+
+				drawList->AddRectFilled(min, max, color);
+				drawList->PushClipRect(min, max, true);
+				drawList->AddText(ImVec2(min.x + 2.0f, min.y + 2.0f), IM_COL32_BLACK, event.Name);
+				drawList->PopClipRect();
+
+				if (ImGui::IsMouseHoveringRect(min, max)) {
+					ImGui::SetTooltip("%s\n%.3f ms", event.Name, (event.End - event.Start) / 1000000.0f);
+				}
+			}
+
+			ImGui::Dummy(ImVec2(width, rows * rowHeight));
+		}
+
+		ImGui::TreePop();
+	}
+
+	//Zone stats across the history
+	if (ImGui::TreeNodeEx("Zones", ImGuiTreeNodeFlags_DefaultOpen)) {
+		if (ImGui::BeginTable("ProfilerZones", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+			ImGui::TableSetupColumn("Zone");
+			ImGui::TableSetupColumn("Latest");
+			ImGui::TableSetupColumn("Average");
+			ImGui::TableSetupColumn("P50");
+			ImGui::TableSetupColumn("P95");
+			ImGui::TableSetupColumn("P99");
+			ImGui::TableHeadersRow();
+
+			for (const ProfileZoneStats& zone : profiler.GetZoneStats()) {
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::Text("%*s%s", zone.Depth * 2, "", zone.Name);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", zone.Latest);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", zone.Average);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", zone.Percentile50);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", zone.Percentile95);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", zone.Percentile99);
+			}
+
+			ImGui::EndTable();
+		}
+
+		ImGui::TreePop();
+	}
+
+	//Heap allocations by tag, and the allocators that avoid them
+	if (ImGui::TreeNode("Memory")) {
+		ImGui::Text("Engine Allocations Last Frame: %llu", (unsigned long long)MemoryTracker::GetFrameAllocations());
+		ImGui::Text("Frames Without Allocations: %u (Longest %u)", MemoryTracker::GetFramesWithoutAllocations(), MemoryTracker::GetLongestRunWithoutAllocations());
+		ImGui::Text("Live Heap: %.2f MB", MemoryTracker::GetLiveBytes() / (1024.0f * 1024.0f));
+
+		if (ImGui::BeginTable("MemoryTags", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+			ImGui::TableSetupColumn("Tag");
+			ImGui::TableSetupColumn("Allocations");
+			ImGui::TableSetupColumn("Frees");
+			ImGui::TableSetupColumn("Bytes");
+			ImGui::TableSetupColumn("Live (KB)");
+			ImGui::TableHeadersRow();
+
+			for (int i = 0; i < (int)MemoryTag::Count; i++) {
+				const MemoryTagStats& stats = MemoryTracker::GetFrameStats((MemoryTag)i);
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::Text("%s", MemoryTracker::GetTagName((MemoryTag)i));
+				ImGui::TableNextColumn();
+				ImGui::Text("%llu", (unsigned long long)stats.Allocations);
+				ImGui::TableNextColumn();
+				ImGui::Text("%llu", (unsigned long long)stats.Frees);
+				ImGui::TableNextColumn();
+				ImGui::Text("%llu", (unsigned long long)stats.AllocatedBytes);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.1f", stats.LiveBytes / 1024.0f);
+			}
+
+			ImGui::EndTable();
+		}
+
+		FrameArena& arena = FrameArena::GetInstance();
+		ImGui::Text("Frame Arena: %.1f / %.1f KB (Peak %.1f KB, Grown %u Times)",
+			arena.GetLastFrameBytes() / 1024.0f,
+			arena.GetCapacity() / 1024.0f,
+			arena.GetPeakBytes() / 1024.0f,
+			arena.GetGrowCount());
+
+		ImGui::Text("Entity Pool: %zu / %zu", Entity::GetPool().GetLiveCount(), Entity::GetPool().GetCapacity());
+		ImGui::Text("Transform Pool: %zu / %zu", Transform::GetPool().GetLiveCount(), Transform::GetPool().GetCapacity());
+		ImGui::Text("Material Pool: %zu / %zu", Material::GetPool().GetLiveCount(), Material::GetPool().GetCapacity());
+
+		ImGui::TreePop();
+	}
+
+	ImGui::End();
+}
+
+// --------------------------------------------------------
+// Clear the screen, redraw everything, present to the user
+// --------------------------------------------------------
+void Game::Draw(float deltaTime, float totalTime) {
+	PROFILE_SCOPE("Draw");
+	benchmarkDrawStart = std::chrono::high_resolution_clock::now();
+
+	//Read back an older frame's GPU times and start timing this one
+	gpuProfiler->BeginFrame();
+
+	//ImGui and others bound state behind the render device's back
+	//last frame, so it starts over, and captures if asked to
+	renderDevice->BeginFrame();
+	if (benchmarkDevice && benchmarkDevice != renderDevice) benchmarkDevice->BeginFrame();
+	if (captureRenderFrame) {
+		renderRecorder->ClearCommands();
+		renderRecorder->SetRecording(true);
+	}
+
+	//Render the shadow map (culled, with static casters cached)
+	// - The first light casts the shadows, so a scene without
+	//    lights has none
+	if (!lights.empty()) DrawShadowMap();
 
 	//Reset the pipeline
+	D3D11_VIEWPORT viewport = {};
+	viewport.MaxDepth = 1.0f;
 	viewport.Width = (float)this->windowWidth;
 	viewport.Height = (float)this->windowHeight;
 	context->RSSetViewports(1, &viewport);
@@ -1138,6 +2614,8 @@ void Game::Draw(float deltaTime, float totalTime) {
 	// - These things should happen ONCE PER FRAME
 	// - At the beginning of Game::Draw() before drawing *anything*
 	{
+		GPU_PROFILE_SCOPE(gpuProfiler, "Clear");
+
 		// Clear the back buffer (erases what's on the screen)
 		const float bgColor[4] = { 0.4f, 0.6f, 0.75f, 1.0f }; // Cornflower Blue
 		context->ClearRenderTargetView(backBufferRTV.Get(), bgColor);
@@ -1145,57 +2623,112 @@ void Game::Draw(float deltaTime, float totalTime) {
 		// Clear the depth buffer (resets per-pixel occlusion information)
 		context->ClearDepthStencilView(depthBufferDSV.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
 
-		//Clear extra render targets
-		context->ClearRenderTargetView(ppRTV.Get(), bgColor);
+		//Grab this frame's scene target from the pool and clear it
+		sceneTarget = renderTargetPool->Acquire(RenderTargetDesc());
+		context->ClearRenderTargetView(sceneTarget->RTV.Get(), bgColor);
 	}
 
 	//Set render targets for post processing
-	context->OMSetRenderTargets(1, ppRTV.GetAddressOf(), depthBufferDSV.Get());
+	context->OMSetRenderTargets(1, sceneTarget->RTV.GetAddressOf(), depthBufferDSV.Get());
+
+	//Bin the lights for the current camera
+	{
+		PROFILE_SCOPE("Light Binning");
+		std::shared_ptr<Camera>& camera = cameras[selectedCameraIndex];
+		lightClusters->Build(lights, camera->GetView(), camera->GetProjection(), camera->GetNearPlane(), camera->GetFarPlane());
+	}
+
+	//Cull the lights against each entity, so small entities in busy
+	//clusters can loop over fewer lights
+	//  - Without culling, the count is too high to ever be used
+	{
+		PROFILE_SCOPE("Entity Light Culling");
+		auto cullStart = std::chrono::high_resolution_clock::now();
+		entityLightRanges.resize(entities.size());
+		for (size_t i = 0; i < entities.size(); i++) {
+			if (cullEntityLights) {
+				entityLightRanges[i] = lightClusters->CullEntityLights(GetEntityWorldBounds(i));
+			} else {
+				entityLightRanges[i] = { 0, UINT_MAX };
+			}
+		}
+		auto cullEnd = std::chrono::high_resolution_clock::now();
+		entityLightCullMilliseconds = std::chrono::duration<float, std::milli>(cullEnd - cullStart).count();
+	}
+
+	//Send the lights and their lists to the GPU
+	{
+		PROFILE_SCOPE("Light Upload");
+		lightClusters->Upload();
+	}
 
 	//Loop through the entity vector and draw the entities
-	for (std::shared_ptr<Entity> entity : entities) {
-		entity->GetMaterial()->GetVertexShader()->SetMatrix4x4("lightView", lightViewMatrix);
-		entity->GetMaterial()->GetVertexShader()->SetMatrix4x4("lightProjection", lightProjectionMatrix);
+	{
+		PROFILE_SCOPE("Entities");
+		GPU_PROFILE_SCOPE(gpuProfiler, "Entities");
+
+		if (useParallelDraws) {
+			DrawEntitiesParallel(totalTime, viewport);
+		} else {
+			for (size_t i = 0; i < entities.size(); i++) {
+				Entity* entity = entities[i].get();
+
+				entity->GetMaterial()->GetVertexShader()->SetMatrix4x4("lightView", lightViewMatrix);
+				entity->GetMaterial()->GetVertexShader()->SetMatrix4x4("lightProjection", lightProjectionMatrix);
 
-		entity->GetMaterial()->GetPixelShader()->SetFloat3("ambient", ambientColor);
+				entity->GetMaterial()->GetPixelShader()->SetFloat3("ambient", ambientColor);
 
-		entity->GetMaterial()->GetPixelShader()->SetData("lights", lights[0], sizeof(Light) * (int)lights.size());
+				lightClusters->SetShaderData(entity->GetMaterial()->GetPixelShader(), windowWidth, windowHeight);
+				lightClusters->SetEntityLights(entity->GetMaterial()->GetPixelShader(), entityLightRanges[i]);
 
-		/*entity->GetMaterial()->GetPixelShader()->SetShaderResourceView("SurfaceTexture", textureSRV);
-		entity->GetMaterial()->GetPixelShader()->SetSamplerState("BasicSampler", samplerOptions);*/
-		//entity->GetMaterial()->PrepareMaterial(textureSRVs, samplerOptions);
-		entity->GetMaterial()->PrepareMaterial();
+				/*entity->GetMaterial()->GetPixelShader()->SetShaderResourceView("SurfaceTexture", textureSRV);
+				entity->GetMaterial()->GetPixelShader()->SetSamplerState("BasicSampler", samplerOptions);*/
+				//entity->GetMaterial()->PrepareMaterial(textureSRVs, samplerOptions);
+				entity->GetMaterial()->PrepareMaterial(context.Get());
 
-		entity->Draw(context, cameras[selectedCameraIndex], totalTime);
-		
+				entity->Draw(context, cameras[selectedCameraIndex], totalTime);
+
+			}
+		}
 	}
 
 	//Draw the sky AFTER drawing the entities
-	sky->Draw(cameras[selectedCameraIndex]);
+	{
+		PROFILE_SCOPE("Sky");
+		GPU_PROFILE_SCOPE(gpuProfiler, "Sky");
+		if (sky) sky->Draw(cameras[selectedCameraIndex]);
+	}
 
-	//Restore back buffer for post processing
-	context->OMSetRenderTargets(1, backBufferRTV.GetAddressOf(), 0);
+	//Only the one frame is captured
+	if (captureRenderFrame) {
+		renderRecorder->SetRecording(false);
+		captureRenderFrame = false;
+	}
 
-	// Activate shaders and bind resources
-	ppVS->SetShader();
-	ppPS->SetShader();
-	ppPS->SetInt("blurRadius", blurRadius);
-	ppPS->SetFloat("pixelWidth", 1.0f / windowWidth);
-	ppPS->SetFloat("pixelHeight", 1.0f / windowHeight);
-	ppPS->SetShaderResourceView("Pixels", ppSRV.Get());
-	ppPS->SetSamplerState("ClampSampler", ppSampler.Get());
-	ppPS->CopyAllBufferData();
+	//Blur the scene into the back buffer
+	DrawPostProcess();
 
-	context->Draw(3, 0); // Draw exactly 3 vertices (one triangle)
+	//Hand the scene target back and age out unused targets
+	renderTargetPool->Release(sceneTarget);
+	sceneTarget = 0;
+	renderTargetPool->EndFrame();
 
 	//Prepare ImGui buffers
-	ImGui::Render();
-	ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
+	{
+		PROFILE_SCOPE("ImGui Render");
+		GPU_PROFILE_SCOPE(gpuProfiler, "ImGui");
+		ImGui::Render();
+		ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
+	}
+
+	gpuProfiler->EndFrame();
 
 	// Frame END
 	// - These should happen exactly ONCE PER FRAME
 	// - At the very end of the frame (after drawing *everything*)
 	{
+		PROFILE_SCOPE("Present");
+
 		// Present the back buffer to the user
 		//  - Puts the results of what we've drawn onto the window
 		//  - Without this, the user never sees anything
@@ -1211,4 +2744,6 @@ void Game::Draw(float deltaTime, float totalTime) {
 	//Unbind SRVs (prevents shadow map SRV/Depth Buffer issue)
 	ID3D11ShaderResourceView* nullSRVs[128] = {};
 	context->PSSetShaderResources(0, 128, nullSRVs);
+
+	if (benchmarkSuite->IsRunning()) EndBenchmarkFrame();
 }
\ No newline at end of file
@@ -2,10 +2,13 @@
 
 #include "DXCore.h"
 #include <DirectXMath.h>
+#include <DirectXCollision.h>
 #include <wrl/client.h> // Used for ComPtr - a smart pointer for COM objects
 
 #include <vector>
 #include <memory>
+#include <string>
+#include <unordered_map>
 
 #include "Entity.h"
 #include "Mesh.h"
@@ -16,6 +19,28 @@
 #include "Material.h"
 
 #include "Lights.h"
+#include "LightClusterGrid.h"
+#include "BlurKernel.h"
+#include "RenderTargetPool.h"
+#include "PostProcessGraph.h"
+#include "GpuProfiler.h"
+#include "D3D11GpuQueryBackend.h"
+#include "ParallelDrawSubmitter.h"
+#include "D3D11RenderDevice.h"
+#include "RecordingRenderDevice.h"
+#include "SoftwareRasterizer.h"
+#include "CommandTraceCapture.h"
+#include "TraceReplayer.h"
+#include "BenchmarkSuite.h"
+#include "SceneFile.h"
+#include "ShaderPermutation.h"
+#include "ShaderHotReload.h"
+#include "TransformBatch.h"
+#include "SceneBvh.h"
+#include "ShadowCasterCuller.h"
+#include "RayCaster.h"
+
+#include <chrono>
 
 class Game 
 	: public DXCore
@@ -29,6 +54,7 @@ public:
 	// will be called automatically
 	void Init();
 	void OnResize();
+	void FixedUpdate(float deltaTime, float totalTime);
 	void Update(float deltaTime, float totalTime);
 	void Draw(float deltaTime, float totalTime);
 
@@ -36,18 +62,46 @@ private:
 
 	// Initialization helper methods - feel free to customize, combine, remove, etc.
 	void LoadShaders(); 
-	void CreateMaterials();
-	void CreateSky();
-	void CreateLights();
-	void CreateGeometry();
+	void LoadShaderVariants();
+	bool BuildShaderVariants();
+	void SelectShaderVariants();
+	bool GenerateShaderStructs();
+	void CheckShaderLayouts();
+	bool LoadScene(const std::wstring& path);
+	bool StreamSceneChunk();
+	void UpdateLightMatrices();
+	void CreateRandomLights(int count);
 	void CreateShadowMap();
+	void DrawShadowMap();
+	void DrawEntitiesParallel(float totalTime, const D3D11_VIEWPORT& viewport);
+	void RenderSoftwareFrame(int benchmarkIterations);
+	void StartBenchmark();
+	void LoadBenchmarkScene();
+	void UnloadBenchmarkScene();
+	void UpdateBenchmark();
+	void EndBenchmarkFrame();
+	void FinishBenchmark();
+	void InterpolateTransforms(float alpha);
+	DirectX::BoundingBox GetEntityWorldBounds(size_t index);
+	void PickEntity(int screenX, int screenY);
+	int DrawShadowCasters(bool drawStatic);
 	void CreatePostProcessResources();
-	void CreatePostProcessTexture();
+	void BuildPostProcessGraph();
+	void DrawPostProcess();
+	void DrawBlurPass(Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> input, BlurKernel& kernel, float stepX, float stepY);
+	void DispatchBlurPass(
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> input,
+		Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> output,
+		BlurKernel& kernel,
+		bool horizontal,
+		unsigned int width,
+		unsigned int height);
 	void UpdateGui(float deltaTime);
 
 	//ImGui Window Creation Methods
 	void CreateWindowInfoGui();
 	void CreateInspectorGui();
+	void CreateProfilerGui();
 
 	// Note the usage of ComPtr below
 	//  - This is a smart pointer for objects that abide by the
@@ -75,18 +129,149 @@ private:
 
 	//Light fields
 	DirectX::XMFLOAT3 ambientColor;
-	std::vector<Light*> lights;
-	Light directionalLight1;
-	Light directionalLight2;
-	Light directionalLight3;
-	Light pointLight1;
-	Light pointLight2;
+	std::vector<Light> lights;
+	unsigned int baseLightCount; // Lights before the random ones
+	int randomLightCount;
+	std::shared_ptr<LightClusterGrid> lightClusters;
+	bool cullEntityLights;
+	std::vector<ClusterRange> entityLightRanges; // Matches the entities vector
+	float entityLightCullMilliseconds;
+
+	//Batched transform fields
+	// Every entity's states, blended and turned into render matrices
+	// and world bounds a SIMD batch at a time
+	TransformStreams previousTransforms;
+	TransformStreams currentTransforms;
+	TransformStreams renderTransforms;
+	BoundsStreams entityLocalBounds;
+	BoundsStreams entityWorldBounds; // Matches the entities vector
+	std::vector<DirectX::XMFLOAT4X4> renderWorlds;
+	std::vector<DirectX::XMFLOAT4X4> renderWorldInverseTransposes;
+	float interpolateMilliseconds;
+	RotationMeasurement rotationMeasurement; // Empty until measured from the inspector
+
+	//Scene BVH fields
+	// The entities' world bounds in a tree, refitted every frame, so
+	// queries don't have to check every entity
+	std::shared_ptr<SceneBvh> entityBvh;
+	std::vector<uint32_t> shadowCasterCandidates; // Entities reaching the light's volume
+	SceneBvhMeasurement bvhMeasurement;
+	int bvhMeasureSize;
+
+	//Picking fields
+	// Clicking the scene casts a ray from the camera through the mouse,
+	// against the entity BVH and then the meshes' triangles
+	std::vector<RayCastInstance> pickInstances; // Matches the entities vector
+	int selectedEntityIndex; // -1 when nothing's selected
+	bool revealSelection;	 // Opens the selected entity's inspector node once
+	int pickPressX;
+	int pickPressY;
+	float pickDistance;
+	float pickMicroseconds;
+	RayCastMeasurement rayMeasurement;
+	int rayMeasureSize;
+
+	//Render device fields
+	// Meshes draw through the recorder, which passes everything
+	// on to the D3D11 device and can capture a frame's commands
+	std::shared_ptr<D3D11RenderDevice> d3d11Device;
+	std::shared_ptr<RecordingRenderDevice> renderRecorder;
+	std::shared_ptr<RenderDevice> renderDevice;
+	bool captureRenderFrame;
+
+	//Command trace fields
+	// The capture sees the recorder's commands and every SimpleShader,
+	// and the replayer plays traces back on a null or D3D11 device
+	std::shared_ptr<CommandTraceCapture> commandTrace;
+	std::shared_ptr<TraceReplayer> traceReplayer;
+	int traceFrameCount;
+	TraceReplayStats traceReplayStats;
+	const char* traceReplayTarget; // Null until something's replayed
+
+	//Benchmark fields
+	// Generated scenes stand in for the game's entities and lights
+	// while the suite runs, with results written as JSON and CSV
+	std::shared_ptr<BenchmarkSuite> benchmarkSuite;
+	std::shared_ptr<RenderDevice> benchmarkDevice; // Owns the scenes' meshes
+	bool benchmarkNullDevice;	// Meshes only count their draws
+	bool benchmarkQuitWhenDone;	// Started from the command line
+	std::vector<std::shared_ptr<Mesh>> benchmarkMeshes;
+	std::vector<std::shared_ptr<Material>> benchmarkMaterials;
+	std::vector<BenchmarkEntityPose> benchmarkPoses;
+	std::vector<std::shared_ptr<Entity>> savedEntities;
+	double savedTargetFrameRate;
+	BenchmarkFrameSample benchmarkSample;
+	std::chrono::high_resolution_clock::time_point benchmarkFrameStart;
+	std::chrono::high_resolution_clock::time_point benchmarkUpdateStart;
+	std::chrono::high_resolution_clock::time_point benchmarkDrawStart;
+	bool benchmarkResultsWritten;
+
+	//Software renderer fields
+	// CPU reference for the scene, shown and diffed in the inspector
+	std::shared_ptr<SoftwareRasterizer> softwareRasterizer;
+	float softwareResolutionScale;
+	int softwareBenchmarkIterations;
+	std::vector<uint32_t> softwareReferenceImage;
+	SoftwareImageDiff softwareImageDiff;
+	bool softwareImageSaved;
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> softwareTexture;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> softwareSRV;
+
+	//Parallel submission fields
+	std::shared_ptr<ParallelDrawSubmitter> drawSubmitter;
+	std::vector<DrawItem> drawItems; // Matches the entities vector
+	bool useParallelDraws;
 
 	//Sky fields
 	std::shared_ptr<Sky> sky;
 
+	//Scene fields
+	// Content comes from a scene file, and after the first load its
+	// entities are streamed in a chunk per frame
+	std::shared_ptr<SceneFile> scene;
+	std::wstring scenePath;
+	size_t sceneEntitiesLoaded;
+	float sceneLoadMilliseconds;
+	std::string sceneError;
+	std::unordered_map<std::string, std::shared_ptr<SimpleVertexShader>> vertexShaderFiles;
+	std::unordered_map<std::string, std::shared_ptr<SimplePixelShader>> pixelShaderFiles;
+	std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> sceneTextures; // By path, kept across loads
+	Microsoft::WRL::ComPtr<ID3D11SamplerState> sceneSampler;
+	SceneLoadTimings sceneLoadTimings;
+	bool sceneLoadMeasured;
+
+	//Shader variant fields
+	// Specialized builds of the scene's pixel shaders, picked for each
+	// material from what it binds and which lights the scene has
+	ShaderManifest shaderManifest;
+	std::unordered_map<std::string, std::shared_ptr<SimplePixelShader>> shaderVariants; // By file, loaded on first use
+	std::vector<std::string> materialShaderNames; // Each material's pixel shader, before picking a variant
+	bool useShaderVariants;
+	size_t materialsOnVariants;
+	std::string shaderVariantStatus;
+
+	//Hot reload fields
+	// Rebuilds shaders from their .hlsl when it, or anything it
+	// includes, is saved, and swaps them in between frames
+	std::shared_ptr<ShaderHotReload> shaderHotReload;
+
+	//Shader layout fields
+	// The generated structs in ShaderStructs.h, checked against each
+	// loaded shader's reflection
+	std::vector<std::string> shaderLayoutErrors;
+	std::string shaderStructStatus;
+
+	//Profiler window fields
+	std::shared_ptr<GpuProfiler> gpuProfiler;
+	int profilerFramesAgo;
+	double profilerZoneOverhead; // Nanoseconds per zone, once measured
+
 	//Shadow fields
 	int shadowMapResolution;
+	float lightProjectionSize;
+	float lightNearPlane;
+	float lightFarPlane;
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> shadowTexture;
 	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> shadowDSV;
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shadowSRV;
 	Microsoft::WRL::ComPtr<ID3D11RasterizerState> shadowRasterizer;
@@ -94,16 +279,40 @@ private:
 	DirectX::XMFLOAT4X4 lightViewMatrix;
 	DirectX::XMFLOAT4X4 lightProjectionMatrix;
 
+	//Static shadow cache fields
+	// Static casters are rendered once into this map, which is then
+	// copied into the shadow map before the dynamic casters each frame
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> staticShadowTexture;
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> staticShadowDSV;
+	DirectX::XMFLOAT4X4 cachedLightViewMatrix;
+	unsigned int cachedStaticChangeCount; // Transform::GetStaticChangeCount() when last drawn
+	bool staticShadowsDirty;
+	int staticShadowCasterCount; // Counted whenever the cache is redrawn
+	ShadowCasterCuller shadowCasterCuller;
+
+	//Shadow stats
+	int shadowCastersCulled;
+	int shadowCastersDrawn;
+	unsigned int staticShadowRendersSkipped;
+
 	//Post Processing fields
 	// Resources that are shared among all post processes
 	Microsoft::WRL::ComPtr<ID3D11SamplerState> ppSampler;
 	std::shared_ptr<SimpleVertexShader> ppVS;
 	// Resources that are tied to a particular post process
 	std::shared_ptr<SimplePixelShader> ppPS;
-	Microsoft::WRL::ComPtr<ID3D11RenderTargetView> ppRTV; // For rendering
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> ppSRV; // For sampling
+	// Screen sized targets come from the pool, and the graph decides
+	// when each one is needed so passes that don't overlap share them
+	std::shared_ptr<RenderTargetPool> renderTargetPool;
+	std::shared_ptr<PostProcessGraph> postProcessGraph;
+	std::shared_ptr<PooledRenderTarget> sceneTarget; // The scene renders here
+	bool postProcessGraphUsesCompute; // Rebuild the graph when this changes
+	size_t postProcessPeakBytes;
 
 	//Blur Fields
 	int blurRadius;
+	int blurType;
+	bool useComputeBlur;
+	std::shared_ptr<SimpleComputeShader> blurCS;
 };
 
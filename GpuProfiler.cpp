@@ -0,0 +1,150 @@
+#include "GpuProfiler.h"
+#include "FrameArena.h"
+
+GpuProfiler::GpuProfiler(std::shared_ptr<GpuQueryBackend> backend) :
+	backend(backend),
+	frameIndex(0),
+	inFrame(false),
+	depth(0),
+	frameMilliseconds(0.0f),
+	framesSkipped(0) {
+	for (Frame& frame : frames) {
+		frame.Disjoint = backend->CreateQuery(GpuQueryType::TimestampDisjoint);
+		frame.Begin = backend->CreateQuery(GpuQueryType::Timestamp);
+		frame.End = backend->CreateQuery(GpuQueryType::Timestamp);
+		frame.ScopeCount = 0;
+		frame.CpuStart = 0;
+		frame.Pending = false;
+	}
+}
+
+GpuProfiler::~GpuProfiler() {
+}
+
+// --------------------------------------------------------
+// Starts a frame, after reading back the frame that last
+// used the same queries
+// --------------------------------------------------------
+void GpuProfiler::BeginFrame() {
+	Frame& frame = frames[frameIndex % GPU_PROFILER_FRAME_LATENCY];
+
+	if (frame.Pending) {
+		if (!ReadFrame(frame)) {
+			framesSkipped++;
+		}
+		frame.Pending = false;
+	}
+
+	frame.ScopeCount = 0;
+	frame.CpuStart = Profiler::Now();
+	backend->Begin(frame.Disjoint);
+	backend->End(frame.Begin);
+
+	inFrame = true;
+	depth = 0;
+}
+
+void GpuProfiler::EndFrame() {
+	Frame& frame = frames[frameIndex % GPU_PROFILER_FRAME_LATENCY];
+
+	backend->End(frame.End);
+	backend->End(frame.Disjoint);
+	frame.Pending = true;
+
+	frameIndex++;
+	inFrame = false;
+}
+
+int GpuProfiler::BeginScope(const char* name) {
+	Frame& frame = frames[frameIndex % GPU_PROFILER_FRAME_LATENCY];
+	if (!inFrame || frame.ScopeCount >= GPU_PROFILER_MAX_SCOPES) {
+		return -1;
+	}
+
+	//Queries are only created the first time a scope slot is used
+	if (frame.ScopeCount == frame.Scopes.size()) {
+		Scope scope = {};
+		scope.Begin = backend->CreateQuery(GpuQueryType::Timestamp);
+		scope.End = backend->CreateQuery(GpuQueryType::Timestamp);
+		frame.Scopes.push_back(scope);
+	}
+
+	Scope& scope = frame.Scopes[frame.ScopeCount];
+	scope.Name = name;
+	scope.Depth = depth++;
+	backend->End(scope.Begin);
+
+	return (int)frame.ScopeCount++;
+}
+
+void GpuProfiler::EndScope(int scope) {
+	if (scope < 0) {
+		return;
+	}
+
+	depth--;
+	backend->End(frames[frameIndex % GPU_PROFILER_FRAME_LATENCY].Scopes[scope].End);
+}
+
+// --------------------------------------------------------
+// Reads a finished frame's timestamps without waiting
+//  - Returns false if anything isn't ready yet, or if the
+//    GPU's clock changed partway through the frame
+// --------------------------------------------------------
+bool GpuProfiler::ReadFrame(Frame& frame) {
+	uint64_t frequency = 0;
+	bool disjoint = true;
+	if (!backend->GetDisjoint(frame.Disjoint, frequency, disjoint) || disjoint || frequency == 0) {
+		return false;
+	}
+
+	uint64_t frameBegin = 0;
+	uint64_t frameEnd = 0;
+	if (!backend->GetTimestamp(frame.Begin, frameBegin) || !backend->GetTimestamp(frame.End, frameEnd)) {
+		return false;
+	}
+
+	//Read every scope before touching the results, so a
+	//skipped frame leaves the last good one in place
+	FrameVector<uint64_t> timestamps(frame.ScopeCount * 2);
+	for (unsigned int i = 0; i < frame.ScopeCount; i++) {
+		if (!backend->GetTimestamp(frame.Scopes[i].Begin, timestamps[i * 2]) ||
+			!backend->GetTimestamp(frame.Scopes[i].End, timestamps[i * 2 + 1])) {
+			return false;
+		}
+	}
+
+	//Line the GPU ticks up with the CPU time the frame began
+	double ticksToNanoseconds = 1000000000.0 / frequency;
+	auto toProfilerTime = [&](uint64_t timestamp) {
+		return frame.CpuStart + (uint64_t)((double)(timestamp - frameBegin) * ticksToNanoseconds);
+	};
+
+	Profiler& profiler = Profiler::GetInstance();
+	profiler.RecordZone("GPU Frame", toProfilerTime(frameBegin), toProfilerTime(frameEnd), 0, "GPU");
+	frameMilliseconds = (float)((frameEnd - frameBegin) * ticksToNanoseconds / 1000000.0);
+
+	results.clear();
+	for (unsigned int i = 0; i < frame.ScopeCount; i++) {
+		const Scope& scope = frame.Scopes[i];
+		uint64_t begin = timestamps[i * 2];
+		uint64_t end = timestamps[i * 2 + 1];
+
+		results.push_back({ scope.Name, scope.Depth, (float)((end - begin) * ticksToNanoseconds / 1000000.0) });
+		profiler.RecordZone(scope.Name, toProfilerTime(begin), toProfilerTime(end), scope.Depth + 1, "GPU");
+	}
+
+	return true;
+}
+
+const std::vector<GpuScopeResult>& GpuProfiler::GetResults() {
+	return results;
+}
+
+float GpuProfiler::GetFrameMilliseconds() {
+	return frameMilliseconds;
+}
+
+unsigned int GpuProfiler::GetFramesSkipped() {
+	return framesSkipped;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "GpuQueryBackend.h"
+#include "Profiler.h"
+
+// Times the rest of the enclosing scope on the GPU
+//  - The name must outlive the profiler (a string literal)
+#define GPU_PROFILE_SCOPE(profiler, name) GpuProfileScope PROFILER_CONCAT(gpuProfileScope, __LINE__)(profiler, name)
+
+// How many frames of queries are in flight before they are read back
+#define GPU_PROFILER_FRAME_LATENCY 4
+// Scopes per frame, past which scopes are silently skipped
+#define GPU_PROFILER_MAX_SCOPES 64
+
+// --------------------------------------------------------
+// One finished GPU scope, read back from an earlier frame
+// --------------------------------------------------------
+struct GpuScopeResult {
+	const char* Name;
+	uint32_t Depth;
+	float Milliseconds;
+};
+
+// --------------------------------------------------------
+// Times sections of a frame on the GPU with timestamp queries
+//
+// - Each frame gets its own set of queries, and a frame is
+//    only read back GPU_PROFILER_FRAME_LATENCY frames later,
+//    so GetData() never has to wait on the GPU
+// - A frame whose queries still aren't ready (or whose clock
+//    was disjoint) is skipped instead of stalling
+// - Results go into the CPU profiler's "GPU" timeline, lined
+//    up with the CPU time their frame began
+// - The queries themselves come from a GpuQueryBackend, so
+//    the ring and readback run the same against a fake GPU
+// --------------------------------------------------------
+class GpuProfiler {
+private:
+	std::shared_ptr<GpuQueryBackend> backend;
+
+	struct Scope {
+		const char* Name;
+		uint32_t Depth;
+		GpuQueryHandle Begin;
+		GpuQueryHandle End;
+	};
+
+	struct Frame {
+		GpuQueryHandle Disjoint;
+		GpuQueryHandle Begin;
+		GpuQueryHandle End;
+		std::vector<Scope> Scopes; // Grows up to GPU_PROFILER_MAX_SCOPES
+		unsigned int ScopeCount;
+		uint64_t CpuStart; // Profiler::Now() when the frame began
+		bool Pending; // Issued, but not read back yet
+	};
+
+	Frame frames[GPU_PROFILER_FRAME_LATENCY];
+	unsigned int frameIndex;
+	bool inFrame;
+	uint32_t depth;
+
+	//Results of the last frame read back
+	std::vector<GpuScopeResult> results;
+	float frameMilliseconds;
+	unsigned int framesSkipped;
+
+	bool ReadFrame(Frame& frame);
+
+public:
+	GpuProfiler(std::shared_ptr<GpuQueryBackend> backend);
+	~GpuProfiler();
+
+	//Wraps everything drawn in a frame
+	// - BeginFrame() also reads back the oldest frame in flight
+	void BeginFrame();
+	void EndFrame();
+
+	//Returns the scope's index, or -1 if there was no room
+	int BeginScope(const char* name);
+	void EndScope(int scope);
+
+	//Stats, from the last frame read back
+	const std::vector<GpuScopeResult>& GetResults();
+	float GetFrameMilliseconds();
+	unsigned int GetFramesSkipped();
+};
+
+// --------------------------------------------------------
+// Times its own lifetime on the GPU
+// --------------------------------------------------------
+class GpuProfileScope
+{
+private:
+	GpuProfiler* profiler;
+	int scope;
+
+public:
+	GpuProfileScope(const std::shared_ptr<GpuProfiler>& profiler, const char* name) :
+		profiler(profiler.get())
+	{
+		scope = this->profiler->BeginScope(name);
+	}
+
+	~GpuProfileScope()
+	{
+		profiler->EndScope(scope);
+	}
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+#include "RenderDevice.h"
+
+RENDER_HANDLE(GpuQueryHandle);
+
+enum class GpuQueryType {
+	Timestamp,			// One GPU tick count, written by End()
+	TimestampDisjoint	// Brackets timestamps with Begin() and End()
+};
+
+// --------------------------------------------------------
+// What the GPU profiler needs from a graphics API's queries
+//
+// - Reads never wait: they return false until the GPU has
+//    written the result, and must not flush the pipeline to
+//    get there
+// - Ending a query that was already read reuses it
+// - The D3D11 version is D3D11GpuQueryBackend, and the tests
+//    drive the profiler with a fake GPU instead
+// --------------------------------------------------------
+class GpuQueryBackend {
+public:
+	virtual ~GpuQueryBackend() {}
+
+	virtual GpuQueryHandle CreateQuery(GpuQueryType type) = 0;
+	virtual void Begin(GpuQueryHandle query) = 0;
+	virtual void End(GpuQueryHandle query) = 0;
+
+	virtual bool GetTimestamp(GpuQueryHandle query, uint64_t& ticks) = 0;
+
+	//Ticks per second, and whether that held for the whole bracket
+	virtual bool GetDisjoint(GpuQueryHandle query, uint64_t& frequency, bool& disjoint) = 0;
+};
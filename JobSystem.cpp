@@ -0,0 +1,334 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <algorithm>
+
+// Singleton requirement
+JobSystem* JobSystem::instance;
+
+// Which deque the calling thread owns, or -1 outside the job system
+static thread_local int threadIndex = -1;
+
+// --------------------------------------------------------
+// Adds a job to the bottom of the deque
+//  - Returns false if the deque is full
+// --------------------------------------------------------
+bool JobDeque::Push(Job* job) {
+	int64_t b = bottom.load(std::memory_order_relaxed);
+	int64_t t = top.load(std::memory_order_acquire);
+
+	if (b - t >= JOB_DEQUE_CAPACITY) {
+		return false;
+	}
+
+	//Publishing bottom releases the job to thieves
+	jobs[b & (JOB_DEQUE_CAPACITY - 1)].store(job, std::memory_order_relaxed);
+	bottom.store(b + 1, std::memory_order_release);
+	return true;
+}
+
+// --------------------------------------------------------
+// Takes the newest job from the bottom of the deque
+//  - Only the last job can race with a thief, which is
+//    settled by whoever moves top first
+// --------------------------------------------------------
+Job* JobDeque::Pop() {
+	//Claiming bottom has to be seen before top is read, or a
+	//thief could take the same job
+	int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+	bottom.store(b, std::memory_order_seq_cst);
+	int64_t t = top.load(std::memory_order_seq_cst);
+
+	if (t > b) {
+		//Already empty
+		bottom.store(b + 1, std::memory_order_relaxed);
+		return 0;
+	}
+
+	Job* job = jobs[b & (JOB_DEQUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+
+	if (t == b) {
+		if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+			job = 0;
+		}
+		bottom.store(b + 1, std::memory_order_relaxed);
+	}
+
+	return job;
+}
+
+// --------------------------------------------------------
+// Takes the oldest job from the top of the deque
+//  - Returns null if it's empty or another thread won
+// --------------------------------------------------------
+Job* JobDeque::Steal() {
+	int64_t t = top.load(std::memory_order_seq_cst);
+	int64_t b = bottom.load(std::memory_order_seq_cst);
+
+	if (t >= b) {
+		return 0;
+	}
+
+	Job* job = jobs[t & (JOB_DEQUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+	if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+		return 0;
+	}
+
+	return job;
+}
+
+JobSystem::JobSystem() :
+	queuedJobs(0),
+	sleepingWorkers(0),
+	shuttingDown(false),
+	jobsRun(0),
+	jobsStolen(0),
+	jobBlocks(MemoryTag::Jobs, sizeof(Job), 256) {
+}
+
+JobSystem::~JobSystem() {
+	ShutDown();
+}
+
+void JobSystem::Initialize(int threadCount) {
+	mainThreadId = std::this_thread::get_id();
+	threadIndex = 0;
+	shuttingDown = false;
+
+	//The main thread runs jobs while it waits, so it counts as one of the threads
+	if (threadCount < 0) {
+		threadCount = (int)std::thread::hardware_concurrency() - 1;
+	}
+	threadCount = (std::max)(threadCount, 0);
+
+	for (int i = 0; i <= threadCount; i++) {
+		deques.push_back(std::make_unique<JobDeque>());
+	}
+
+	//Workers name themselves in the profiler as they start, so it
+	//has to exist before they race to create it
+	Profiler::GetInstance();
+
+	for (int i = 1; i <= threadCount; i++) {
+		workers.push_back(std::thread(&JobSystem::WorkerLoop, this, i));
+	}
+}
+
+void JobSystem::ShutDown() {
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		shuttingDown = true;
+	}
+	jobQueued.notify_all();
+
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+
+	workers.clear();
+	deques.clear();
+}
+
+Job* JobSystem::CreateJob(std::function<void()>& function, JobCounter* counter) {
+	return new (jobBlocks.Allocate()) Job{ std::move(function), counter };
+}
+
+void JobSystem::Run(std::function<void()> function, JobCounter* counter) {
+	Job* job = CreateJob(function, counter);
+
+	if (counter) {
+		counter->Remaining.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	//Threads without a deque (or a full deque) just run it now
+	if (threadIndex < 0 || threadIndex >= (int)deques.size()) {
+		Execute(job);
+		return;
+	}
+
+	queuedJobs.fetch_add(1);
+	if (!deques[threadIndex]->Push(job)) {
+		queuedJobs.fetch_sub(1);
+		Execute(job);
+		return;
+	}
+
+	WakeWorker();
+}
+
+void JobSystem::RunOnMainThread(std::function<void()> function, JobCounter* counter) {
+	Job* job = CreateJob(function, counter);
+
+	if (counter) {
+		counter->Remaining.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	std::lock_guard<std::mutex> lock(mainThreadMutex);
+	mainThreadJobs.push_back(job);
+}
+
+// --------------------------------------------------------
+// Helps out until the counter's jobs are done
+//  - The main thread also runs main thread jobs, so jobs
+//    waiting on those can't deadlock it
+// --------------------------------------------------------
+void JobSystem::Wait(JobCounter& counter) {
+	while (!counter.IsDone()) {
+		Job* job = 0;
+
+		if (threadIndex == 0) {
+			job = TakeMainThreadJob();
+		}
+
+		if (!job && threadIndex >= 0 && threadIndex < (int)deques.size()) {
+			job = FindJob(threadIndex);
+		}
+
+		if (job) {
+			Execute(job);
+		} else {
+			std::this_thread::yield();
+		}
+	}
+}
+
+void JobSystem::ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& body) {
+	if (count == 0) {
+		return;
+	}
+
+	if (grainSize == 0) {
+		grainSize = (std::max)(count / (GetThreadCount() * 4), (size_t)1);
+	}
+
+	//Each job only captures the loop and where its chunk starts,
+	//which is small enough for std::function to hold without
+	//allocating on any of the standard libraries
+	struct Loop {
+		const std::function<void(size_t begin, size_t end)>* Body;
+		size_t Count;
+		size_t GrainSize;
+	} loop = { &body, count, grainSize };
+
+	JobCounter counter;
+	for (size_t begin = 0; begin < count; begin += grainSize) {
+		Run([&loop, begin]() { (*loop.Body)(begin, (std::min)(begin + loop.GrainSize, loop.Count)); }, &counter);
+	}
+
+	Wait(counter);
+}
+
+void JobSystem::RunMainThreadJobs() {
+	Job* job;
+	while ((job = TakeMainThreadJob()) != 0) {
+		Execute(job);
+	}
+}
+
+// --------------------------------------------------------
+// Runs jobs until shut down, sleeping when there's nothing
+// to steal
+// --------------------------------------------------------
+void JobSystem::WorkerLoop(unsigned int index) {
+	threadIndex = (int)index;
+	Profiler::GetInstance().SetThreadName("Job Worker");
+
+	while (true) {
+		Job* job = FindJob(index);
+
+		//Spin briefly before sleeping, as jobs tend to come in bursts
+		for (int i = 0; !job && i < 64; i++) {
+			std::this_thread::yield();
+			job = FindJob(index);
+		}
+
+		if (job) {
+			Execute(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleepingWorkers.fetch_add(1);
+		jobQueued.wait(lock, [this] { return shuttingDown || queuedJobs.load() > 0; });
+		sleepingWorkers.fetch_sub(1);
+
+		if (shuttingDown) {
+			return;
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Takes a job from this thread's deque, or steals one,
+// trying the other deques in turn
+// --------------------------------------------------------
+Job* JobSystem::FindJob(unsigned int index) {
+	Job* job = deques[index]->Pop();
+
+	for (size_t i = 1; !job && i < deques.size(); i++) {
+		job = deques[(index + i) % deques.size()]->Steal();
+
+		if (job) {
+			jobsStolen.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	if (job) {
+		queuedJobs.fetch_sub(1);
+	}
+
+	return job;
+}
+
+Job* JobSystem::TakeMainThreadJob() {
+	std::lock_guard<std::mutex> lock(mainThreadMutex);
+	if (mainThreadJobs.empty()) {
+		return 0;
+	}
+
+	Job* job = mainThreadJobs.front();
+	mainThreadJobs.pop_front();
+	return job;
+}
+
+void JobSystem::Execute(Job* job) {
+	job->Function();
+
+	if (job->Counter) {
+		job->Counter->Remaining.fetch_sub(1, std::memory_order_release);
+	}
+
+	job->~Job();
+	jobBlocks.Free(job);
+	jobsRun.fetch_add(1, std::memory_order_relaxed);
+}
+
+// --------------------------------------------------------
+// Wakes a sleeping worker for a newly queued job
+//  - Taking the lock first means a worker can't miss the
+//    job between checking for work and going to sleep
+// --------------------------------------------------------
+void JobSystem::WakeWorker() {
+	if (sleepingWorkers.load() > 0) {
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+		}
+		jobQueued.notify_one();
+	}
+}
+
+bool JobSystem::IsMainThread() {
+	return std::this_thread::get_id() == mainThreadId;
+}
+
+unsigned int JobSystem::GetThreadCount() {
+	return (unsigned int)(std::max)(deques.size(), (size_t)1);
+}
+
+unsigned int JobSystem::GetJobsRun() {
+	return jobsRun.load(std::memory_order_relaxed);
+}
+
+unsigned int JobSystem::GetJobsStolen() {
+	return jobsStolen.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ObjectPool.h"
+
+// Jobs each worker can have queued before new ones run inline
+//  - Must be a power of 2
+#define JOB_DEQUE_CAPACITY 4096
+
+// --------------------------------------------------------
+// Counts the jobs still running in a group
+//  - Pass one to Run() and wait on it with Wait()
+// --------------------------------------------------------
+struct JobCounter {
+	std::atomic<int> Remaining{ 0 };
+
+	bool IsDone() { return Remaining.load(std::memory_order_acquire) == 0; }
+};
+
+// --------------------------------------------------------
+// A queued function and the counter it finishes
+// --------------------------------------------------------
+struct Job {
+	std::function<void()> Function;
+	JobCounter* Counter;
+};
+
+// --------------------------------------------------------
+// Chase-Lev work stealing deque
+//
+// - The owning thread pushes and pops at the bottom, and
+//    any other thread steals from the top, all without
+//    locks
+// - Fixed capacity, so Push() fails instead of growing
+// --------------------------------------------------------
+class JobDeque {
+private:
+	std::atomic<int64_t> top{ 0 };
+	std::atomic<int64_t> bottom{ 0 };
+	std::vector<std::atomic<Job*>> jobs = std::vector<std::atomic<Job*>>(JOB_DEQUE_CAPACITY);
+
+public:
+	//Owner only
+	bool Push(Job* job);
+	Job* Pop();
+
+	//Any thread
+	Job* Steal();
+};
+
+// --------------------------------------------------------
+// Work stealing job system shared by the whole engine
+//
+// - Each worker (and the main thread) has its own deque, and
+//    idle workers steal from the others
+// - Waiting on a counter runs other jobs instead of blocking,
+//    so jobs can wait on jobs without fibers
+// - Jobs that call into the immediate context go through
+//    RunOnMainThread(), as D3D11's immediate context isn't
+//    thread safe
+// --------------------------------------------------------
+class JobSystem
+{
+#pragma region Singleton
+public:
+	// Gets the one and only instance of this class
+	static JobSystem& GetInstance()
+	{
+		if (!instance)
+		{
+			instance = new JobSystem();
+		}
+
+		return *instance;
+	}
+
+	// Remove these functions (C++ 11 version)
+	JobSystem(JobSystem const&) = delete;
+	void operator=(JobSystem const&) = delete;
+
+private:
+	static JobSystem* instance;
+	JobSystem();
+#pragma endregion
+
+private:
+	//Deque 0 belongs to the main thread
+	std::vector<std::unique_ptr<JobDeque>> deques;
+	std::vector<std::thread> workers;
+	std::thread::id mainThreadId;
+
+	//Sleeping workers wake when a job is queued
+	std::mutex sleepMutex;
+	std::condition_variable jobQueued;
+	std::atomic<int> queuedJobs;
+	std::atomic<int> sleepingWorkers;
+	bool shuttingDown;
+
+	//Jobs that have to run on the main thread
+	std::mutex mainThreadMutex;
+	std::deque<Job*> mainThreadJobs;
+
+	//Stats
+	std::atomic<unsigned int> jobsRun;
+	std::atomic<unsigned int> jobsStolen;
+
+	//Jobs come and go every frame, so they're pooled
+	FixedBlockPool jobBlocks;
+
+	Job* CreateJob(std::function<void()>& function, JobCounter* counter);
+	void WorkerLoop(unsigned int index);
+	Job* FindJob(unsigned int index);
+	Job* TakeMainThreadJob();
+	void Execute(Job* job);
+	void WakeWorker();
+
+public:
+	~JobSystem();
+
+	//Starts the workers, and makes the calling thread the main thread
+	// - A thread count of -1 uses one less than the number of cores
+	void Initialize(int threadCount = -1);
+	void ShutDown();
+
+	//Queues a job on the calling thread's deque
+	// - Threads outside the job system run it inline
+	void Run(std::function<void()> function, JobCounter* counter = 0);
+
+	//Queues a job that only the main thread will run
+	void RunOnMainThread(std::function<void()> function, JobCounter* counter = 0);
+
+	//Runs other jobs until the counter reaches zero
+	void Wait(JobCounter& counter);
+
+	//Calls body(begin, end) over [0, count) in chunks of grainSize,
+	//and returns once every chunk has run
+	// - A grain size of 0 picks one that gives each thread a few chunks
+	void ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& body);
+
+	//Same, for lambdas, which are only referenced, so they can
+	//capture as much as they like without the std::function
+	//allocating to hold it
+	template<typename Body>
+	void ParallelFor(size_t count, size_t grainSize, const Body& body) {
+		const std::function<void(size_t begin, size_t end)> reference = [&body](size_t begin, size_t end) { body(begin, end); };
+		ParallelFor(count, grainSize, reference);
+	}
+
+	//Runs any main thread jobs that are waiting
+	void RunMainThreadJobs();
+
+	bool IsMainThread();
+	unsigned int GetThreadCount();
+
+	//Stats
+	unsigned int GetJobsRun();
+	unsigned int GetJobsStolen();
+};
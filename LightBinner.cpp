@@ -0,0 +1,348 @@
+#include "LightBinner.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <emmintrin.h> // SSE2
+#include <algorithm>
+#include <cmath>
+
+// Pads the light arrays so they can always be read 4 at a time.
+// Padding spheres sit impossibly far away with no radius, so
+// they never touch a cluster
+static const float PADDING_POSITION = 1e30f;
+
+static unsigned int RoundUpToFour(unsigned int count) {
+	return (count + 3) & ~3u;
+}
+
+void LightBinner::LightArrays::Clear() {
+	X.clear(); Y.clear(); Z.clear(); Radius.clear();
+	ApexX.clear(); ApexY.clear(); ApexZ.clear();
+	DirX.clear(); DirY.clear(); DirZ.clear();
+	CosAngle.clear(); SinAngle.clear(); Range.clear();
+	SpotMask.clear();
+}
+
+// --------------------------------------------------------
+// Pads the arrays with lights that can't reach anything
+// --------------------------------------------------------
+void LightBinner::LightArrays::Pad() {
+	unsigned int count = RoundUpToFour((unsigned int)X.size());
+
+	X.resize(count, PADDING_POSITION);
+	Y.resize(count, PADDING_POSITION);
+	Z.resize(count, PADDING_POSITION);
+	Radius.resize(count, 0.0f);
+	ApexX.resize(count, 0.0f);
+	ApexY.resize(count, 0.0f);
+	ApexZ.resize(count, 0.0f);
+	DirX.resize(count, 0.0f);
+	DirY.resize(count, 0.0f);
+	DirZ.resize(count, 0.0f);
+	CosAngle.resize(count, 0.0f);
+	SinAngle.resize(count, 0.0f);
+	Range.resize(count, 0.0f);
+	SpotMask.resize(count, 0);
+}
+
+void LightBinner::LightArrays::Set(unsigned int index, const BinnedLight& light) {
+	if (index >= X.size()) {
+		unsigned int count = index + 1;
+		X.resize(count); Y.resize(count); Z.resize(count); Radius.resize(count);
+		ApexX.resize(count); ApexY.resize(count); ApexZ.resize(count);
+		DirX.resize(count); DirY.resize(count); DirZ.resize(count);
+		CosAngle.resize(count); SinAngle.resize(count); Range.resize(count);
+		SpotMask.resize(count);
+	}
+
+	X[index] = light.Center[0];
+	Y[index] = light.Center[1];
+	Z[index] = light.Center[2];
+	Radius[index] = light.Radius;
+	ApexX[index] = light.Apex[0];
+	ApexY[index] = light.Apex[1];
+	ApexZ[index] = light.Apex[2];
+	DirX[index] = light.Direction[0];
+	DirY[index] = light.Direction[1];
+	DirZ[index] = light.Direction[2];
+	CosAngle[index] = light.CosAngle;
+	SinAngle[index] = light.SinAngle;
+	Range[index] = light.Range;
+	SpotMask[index] = light.IsSpot ? -1 : 0;
+}
+
+void LightBinner::LightArrays::Append(const LightArrays& from, unsigned int index) {
+	X.push_back(from.X[index]);
+	Y.push_back(from.Y[index]);
+	Z.push_back(from.Z[index]);
+	Radius.push_back(from.Radius[index]);
+	ApexX.push_back(from.ApexX[index]);
+	ApexY.push_back(from.ApexY[index]);
+	ApexZ.push_back(from.ApexZ[index]);
+	DirX.push_back(from.DirX[index]);
+	DirY.push_back(from.DirY[index]);
+	DirZ.push_back(from.DirZ[index]);
+	CosAngle.push_back(from.CosAngle[index]);
+	SinAngle.push_back(from.SinAngle[index]);
+	Range.push_back(from.Range[index]);
+	SpotMask.push_back(from.SpotMask[index]);
+}
+
+LightBinner::LightBinner() :
+	scaleX(0.0f),
+	scaleY(0.0f),
+	nearPlane(0.0f),
+	farPlane(0.0f),
+	maxLightsPerCluster(0) {
+	clusters.resize(CLUSTER_COUNT);
+	slices.resize(CLUSTER_COUNT_Z);
+}
+
+LightBinner::~LightBinner() {
+}
+
+// --------------------------------------------------------
+// Recalculates the view space bounds of each cluster
+//  - Each bound covers the slice of the tile's frustum
+//    between the slice's near and far depths
+// --------------------------------------------------------
+void LightBinner::SetProjection(float scaleX, float scaleY, float nearPlane, float farPlane) {
+	if (this->scaleX == scaleX &&
+		this->scaleY == scaleY &&
+		this->nearPlane == nearPlane &&
+		this->farPlane == farPlane) {
+		return;
+	}
+
+	this->scaleX = scaleX;
+	this->scaleY = scaleY;
+	this->nearPlane = nearPlane;
+	this->farPlane = farPlane;
+
+	//View space x = ndc x * depth / scaleX (same for y)
+	float invScaleX = 1.0f / scaleX;
+	float invScaleY = 1.0f / scaleY;
+
+	for (int z = 0; z < CLUSTER_COUNT_Z; z++) {
+		float sliceNear = nearPlane * powf(farPlane / nearPlane, (float)z / CLUSTER_COUNT_Z);
+		float sliceFar = nearPlane * powf(farPlane / nearPlane, (float)(z + 1) / CLUSTER_COUNT_Z);
+
+		for (int y = 0; y < CLUSTER_COUNT_Y; y++) {
+			//Tile rows start at the top of the screen
+			float ndcTop = 1.0f - 2.0f * y / CLUSTER_COUNT_Y;
+			float ndcBottom = 1.0f - 2.0f * (y + 1) / CLUSTER_COUNT_Y;
+
+			for (int x = 0; x < CLUSTER_COUNT_X; x++) {
+				float ndcLeft = -1.0f + 2.0f * x / CLUSTER_COUNT_X;
+				float ndcRight = -1.0f + 2.0f * (x + 1) / CLUSTER_COUNT_X;
+
+				//The extremes are always at the near or far depth
+				float xs[4] = { ndcLeft * sliceNear, ndcLeft * sliceFar, ndcRight * sliceNear, ndcRight * sliceFar };
+				float ys[4] = { ndcTop * sliceNear, ndcTop * sliceFar, ndcBottom * sliceNear, ndcBottom * sliceFar };
+
+				ClusterBounds& bounds = clusters[x + CLUSTER_COUNT_X * (y + CLUSTER_COUNT_Y * z)];
+				bounds.Min[0] = *std::min_element(xs, xs + 4) * invScaleX;
+				bounds.Min[1] = *std::min_element(ys, ys + 4) * invScaleY;
+				bounds.Min[2] = sliceNear;
+				bounds.Max[0] = *std::max_element(xs, xs + 4) * invScaleX;
+				bounds.Max[1] = *std::max_element(ys, ys + 4) * invScaleY;
+				bounds.Max[2] = sliceFar;
+
+				float lengthSquared = 0.0f;
+				for (int c = 0; c < 3; c++) {
+					float extent = (bounds.Max[c] - bounds.Min[c]) * 0.5f;
+					bounds.Center[c] = (bounds.Min[c] + bounds.Max[c]) * 0.5f;
+					lengthSquared += extent * extent;
+				}
+				bounds.Radius = sqrtf(lengthSquared);
+			}
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Finds the slices each light's depth range covers, then
+// bins every slice in parallel
+// --------------------------------------------------------
+void LightBinner::Bin(const BinnedLight* binnedLights, unsigned int count, unsigned int indexOffset, std::vector<ClusterRange>& ranges, std::vector<unsigned int>& indices) {
+	lights.Clear();
+	firstSlice.assign(RoundUpToFour(count), CLUSTER_COUNT_Z);
+	lastSlice.assign(RoundUpToFour(count), -1);
+
+	for (unsigned int i = 0; i < count; i++) {
+		const BinnedLight& light = binnedLights[i];
+		lights.Set(i, light);
+
+		//Lights entirely behind the camera or past the far plane stay empty
+		float minDepth = light.Center[2] - light.Radius;
+		float maxDepth = light.Center[2] + light.Radius;
+		if (maxDepth < nearPlane || minDepth > farPlane) {
+			continue;
+		}
+
+		firstSlice[i] = GetSlice(minDepth);
+		lastSlice[i] = GetSlice(maxDepth);
+	}
+
+	lights.Pad();
+	ranges.resize(CLUSTER_COUNT);
+
+	//One job per slice, as slices vary a lot in how many lights reach them
+	JobSystem::GetInstance().ParallelFor(CLUSTER_COUNT_Z, 1, [&](size_t begin, size_t end) {
+		for (size_t slice = begin; slice < end; slice++) {
+			BinSlice((int)slice, indexOffset, ranges.data());
+		}
+	});
+
+	//Stitch the per slice lists together
+	indices.clear();
+	maxLightsPerCluster = 0;
+
+	for (int z = 0; z < CLUSTER_COUNT_Z; z++) {
+		unsigned int sliceOffset = (unsigned int)indices.size();
+		ClusterRange* sliceRanges = &ranges[z * CLUSTER_COUNT_X * CLUSTER_COUNT_Y];
+
+		for (int i = 0; i < CLUSTER_COUNT_X * CLUSTER_COUNT_Y; i++) {
+			sliceRanges[i].Offset += sliceOffset;
+			maxLightsPerCluster = (std::max)(maxLightsPerCluster, sliceRanges[i].Count);
+		}
+
+		indices.insert(indices.end(), slices[z].Indices.begin(), slices[z].Indices.end());
+	}
+}
+
+// --------------------------------------------------------
+// Bins the lights for every tile of one depth slice
+//  - Offsets are relative to the slice until Bin()
+//    stitches the slices together
+// --------------------------------------------------------
+void LightBinner::BinSlice(int slice, unsigned int indexOffset, ClusterRange* ranges) {
+	PROFILE_SCOPE("Bin Slice");
+
+	SliceBins& bins = slices[slice];
+	bins.Indices.clear();
+	bins.Candidates.clear();
+	bins.CandidateLights.Clear();
+
+	//Find the lights that reach this slice, 4 at a time
+	__m128i sliceVector = _mm_set1_epi32(slice);
+	for (unsigned int i = 0; i < firstSlice.size(); i += 4) {
+		__m128i first = _mm_loadu_si128((const __m128i*)&firstSlice[i]);
+		__m128i last = _mm_loadu_si128((const __m128i*)&lastSlice[i]);
+
+		//first <= slice && last >= slice
+		__m128i outside = _mm_or_si128(_mm_cmpgt_epi32(first, sliceVector), _mm_cmplt_epi32(last, sliceVector));
+		int mask = ~_mm_movemask_ps(_mm_castsi128_ps(outside)) & 0xF;
+
+		for (int lane = 0; lane < 4; lane++) {
+			if (mask & (1 << lane)) {
+				bins.Candidates.push_back(i + lane);
+				bins.CandidateLights.Append(lights, i + lane);
+			}
+		}
+	}
+
+	LightArrays& candidates = bins.CandidateLights;
+	candidates.Pad();
+	unsigned int paddedCount = (unsigned int)candidates.X.size();
+
+	__m128 zero = _mm_setzero_ps();
+	int firstCluster = slice * CLUSTER_COUNT_X * CLUSTER_COUNT_Y;
+
+	for (int cluster = firstCluster; cluster < firstCluster + CLUSTER_COUNT_X * CLUSTER_COUNT_Y; cluster++) {
+		ClusterRange& range = ranges[cluster];
+		range.Offset = (unsigned int)bins.Indices.size();
+
+		const ClusterBounds& bounds = clusters[cluster];
+		__m128 minX = _mm_set1_ps(bounds.Min[0]);
+		__m128 minY = _mm_set1_ps(bounds.Min[1]);
+		__m128 minZ = _mm_set1_ps(bounds.Min[2]);
+		__m128 maxX = _mm_set1_ps(bounds.Max[0]);
+		__m128 maxY = _mm_set1_ps(bounds.Max[1]);
+		__m128 maxZ = _mm_set1_ps(bounds.Max[2]);
+
+		__m128 centerX = _mm_set1_ps(bounds.Center[0]);
+		__m128 centerY = _mm_set1_ps(bounds.Center[1]);
+		__m128 centerZ = _mm_set1_ps(bounds.Center[2]);
+		__m128 radius = _mm_set1_ps(bounds.Radius);
+
+		for (unsigned int i = 0; i < paddedCount; i += 4) {
+			//Sphere vs box: distance from the center to the closest
+			//point in the box must be within the radius
+			__m128 x = _mm_loadu_ps(&candidates.X[i]);
+			__m128 y = _mm_loadu_ps(&candidates.Y[i]);
+			__m128 z = _mm_loadu_ps(&candidates.Z[i]);
+			__m128 r = _mm_loadu_ps(&candidates.Radius[i]);
+
+			__m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minX, x), _mm_sub_ps(x, maxX)), zero);
+			__m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minY, y), _mm_sub_ps(y, maxY)), zero);
+			__m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minZ, z), _mm_sub_ps(z, maxZ)), zero);
+			__m128 distSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+			__m128 hit = _mm_cmple_ps(distSquared, _mm_mul_ps(r, r));
+
+			//Spot lights also test their cone against the cluster's
+			//bounding sphere (same test as LightCuller::ConeIntersectsSphere)
+			__m128 spot = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)&candidates.SpotMask[i]));
+			if (_mm_movemask_ps(_mm_and_ps(hit, spot))) {
+				__m128 toX = _mm_sub_ps(centerX, _mm_loadu_ps(&candidates.ApexX[i]));
+				__m128 toY = _mm_sub_ps(centerY, _mm_loadu_ps(&candidates.ApexY[i]));
+				__m128 toZ = _mm_sub_ps(centerZ, _mm_loadu_ps(&candidates.ApexZ[i]));
+
+				__m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(toX, toX), _mm_mul_ps(toY, toY)), _mm_mul_ps(toZ, toZ));
+				__m128 alongAxis = _mm_add_ps(_mm_add_ps(
+					_mm_mul_ps(toX, _mm_loadu_ps(&candidates.DirX[i])),
+					_mm_mul_ps(toY, _mm_loadu_ps(&candidates.DirY[i]))),
+					_mm_mul_ps(toZ, _mm_loadu_ps(&candidates.DirZ[i])));
+
+				__m128 offAxis = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(lengthSquared, _mm_mul_ps(alongAxis, alongAxis)), zero));
+				__m128 closestDistance = _mm_sub_ps(
+					_mm_mul_ps(_mm_loadu_ps(&candidates.CosAngle[i]), offAxis),
+					_mm_mul_ps(alongAxis, _mm_loadu_ps(&candidates.SinAngle[i])));
+
+				__m128 outsideAngle = _mm_cmpgt_ps(closestDistance, radius);
+				__m128 pastEnd = _mm_cmpgt_ps(alongAxis, _mm_add_ps(radius, _mm_loadu_ps(&candidates.Range[i])));
+				__m128 behindTip = _mm_cmplt_ps(alongAxis, _mm_sub_ps(zero, radius));
+
+				__m128 coneMiss = _mm_or_ps(_mm_or_ps(outsideAngle, pastEnd), behindTip);
+				hit = _mm_andnot_ps(_mm_and_ps(coneMiss, spot), hit);
+			}
+
+			int mask = _mm_movemask_ps(hit);
+
+			for (int lane = 0; lane < 4; lane++) {
+				if (mask & (1 << lane)) {
+					bins.Indices.push_back(indexOffset + bins.Candidates[i + lane]);
+				}
+			}
+		}
+
+		range.Count = (unsigned int)bins.Indices.size() - range.Offset;
+	}
+}
+
+const ClusterBounds& LightBinner::GetClusterBounds(unsigned int cluster) {
+	return clusters[cluster];
+}
+
+unsigned int LightBinner::GetMaxLightsPerCluster() {
+	return maxLightsPerCluster;
+}
+
+// --------------------------------------------------------
+// slice = log(depth / near) * CLUSTER_COUNT_Z / log(far / near)
+//  - The pixel shader finds its slice the same way, as
+//     log(depth) * GetDepthScale() + GetDepthBias()
+// --------------------------------------------------------
+int LightBinner::GetSlice(float depth) {
+	depth = (std::min)((std::max)(depth, nearPlane), farPlane);
+	return (std::min)((int)(logf(depth / nearPlane) * GetDepthScale()), CLUSTER_COUNT_Z - 1);
+}
+
+float LightBinner::GetDepthScale() {
+	return CLUSTER_COUNT_Z / logf(farPlane / nearPlane);
+}
+
+float LightBinner::GetDepthBias() {
+	return -logf(nearPlane) * GetDepthScale();
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <vector>
+
+// Size of the view space froxel grid
+//  - Must match the values in ShaderIncludes.hlsli
+#define CLUSTER_COUNT_X 16
+#define CLUSTER_COUNT_Y 9
+#define CLUSTER_COUNT_Z 24
+#define CLUSTER_COUNT (CLUSTER_COUNT_X * CLUSTER_COUNT_Y * CLUSTER_COUNT_Z)
+
+// Where a cluster's lights start in the index list, and how many there are
+struct ClusterRange {
+	unsigned int Offset;
+	unsigned int Count;
+};
+
+// --------------------------------------------------------
+// A point or spot light, already in view space
+//
+// - Center and Radius are the tightest sphere around the
+//    light, which for a spot light is the sphere around its
+//    cone, like LightVolume's Center and Radius
+// - Point lights leave the cone values unused
+// --------------------------------------------------------
+struct BinnedLight {
+	float Center[3];
+	float Radius;
+	float Apex[3];		// Spot light position
+	float Direction[3];	// Unit length, down the cone
+	float CosAngle;
+	float SinAngle;
+	float Range;
+	bool IsSpot;
+};
+
+// --------------------------------------------------------
+// View space bounds of one cluster
+// - Sphere is around the box, for the cone tests
+// --------------------------------------------------------
+struct ClusterBounds {
+	float Min[3];
+	float Max[3];
+	float Center[3];
+	float Radius;
+};
+
+// --------------------------------------------------------
+// Assigns view space lights to the froxel grid
+//
+// - The grid is 16x9 screen tiles, each split into depth
+//    slices that get exponentially thicker with distance
+// - Spot lights are binned by their cone, not their range
+// - Each depth slice is binned independently, so each slice
+//    is its own job in the job system, and each cluster
+//    tests four lights at a time with SSE
+// - Knows nothing of DirectXMath or the device, so it can
+//    be tested and timed anywhere
+// --------------------------------------------------------
+class LightBinner {
+private:
+	//Lights stored as separate arrays (padded to a multiple
+	//of 4) so SSE can test 4 at once
+	struct LightArrays {
+		std::vector<float> X, Y, Z, Radius;		// Bounding sphere
+		std::vector<float> ApexX, ApexY, ApexZ;	// Spot light cone
+		std::vector<float> DirX, DirY, DirZ;
+		std::vector<float> CosAngle, SinAngle, Range;
+		std::vector<int> SpotMask;				// All bits set for spot lights
+
+		void Clear();
+		void Pad();
+		void Set(unsigned int index, const BinnedLight& light);
+		void Append(const LightArrays& from, unsigned int index);
+	};
+
+	LightArrays lights;
+	std::vector<int> firstSlice;
+	std::vector<int> lastSlice;
+
+	//Bounds of every cluster, rebuilt when the projection changes
+	std::vector<ClusterBounds> clusters;
+	float scaleX;
+	float scaleY;
+	float nearPlane;
+	float farPlane;
+
+	//Per slice scratch space so threads never share writes
+	struct SliceBins {
+		std::vector<unsigned int> Indices;
+		std::vector<unsigned int> Candidates;
+		LightArrays CandidateLights;
+	};
+	std::vector<SliceBins> slices;
+
+	unsigned int maxLightsPerCluster;
+
+	void BinSlice(int slice, unsigned int indexOffset, ClusterRange* ranges);
+
+public:
+	LightBinner();
+	~LightBinner();
+
+	//Sets up the grid for a perspective projection
+	// - scaleX and scaleY are the projection matrix's _11 and _22
+	void SetProjection(float scaleX, float scaleY, float nearPlane, float farPlane);
+
+	//Bins the lights into the grid
+	// - Ranges gets CLUSTER_COUNT entries, in x, then y, then z order
+	// - Indices are each light's place in the array plus indexOffset
+	void Bin(const BinnedLight* lights, unsigned int count, unsigned int indexOffset, std::vector<ClusterRange>& ranges, std::vector<unsigned int>& indices);
+
+	const ClusterBounds& GetClusterBounds(unsigned int cluster);
+	unsigned int GetMaxLightsPerCluster();
+
+	//Which depth slice a view space depth falls in, clamped to the grid
+	int GetSlice(float depth);
+	float GetDepthScale();
+	float GetDepthBias();
+};
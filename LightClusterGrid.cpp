@@ -0,0 +1,254 @@
+#include "LightClusterGrid.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+// Moves a point, or turns a direction, stored as three floats
+static void TransformFloat3(const float value[3], FXMMATRIX matrix, bool isDirection, float result[3]) {
+	XMVECTOR v = XMVectorSet(value[0], value[1], value[2], 0.0f);
+	v = isDirection ? XMVector3TransformNormal(v, matrix) : XMVector3TransformCoord(v, matrix);
+	result[0] = XMVectorGetX(v);
+	result[1] = XMVectorGetY(v);
+	result[2] = XMVectorGetZ(v);
+}
+
+LightClusterGrid::LightClusterGrid(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context) :
+	device(device),
+	context(context),
+	lightCapacity(0),
+	lightIndexCapacity(0),
+	directionalLightCount(0),
+	binnedLightCount(0),
+	buildMilliseconds(0.0f) {
+
+	clusterRanges.resize(CLUSTER_COUNT);
+
+	//The cluster ranges never change size
+	CreateStructuredBuffer(sizeof(ClusterRange), CLUSTER_COUNT, clusterRangeBuffer, clusterRangeSRV);
+}
+
+LightClusterGrid::~LightClusterGrid() {
+}
+
+// --------------------------------------------------------
+// Bins the lights into the cluster grid for the given camera
+//  - Only point and spot lights are binned
+// --------------------------------------------------------
+void LightClusterGrid::Build(
+	const std::vector<Light>& lights,
+	DirectX::XMFLOAT4X4 view,
+	DirectX::XMFLOAT4X4 projection,
+	float nearPlane,
+	float farPlane) {
+	auto start = std::chrono::high_resolution_clock::now();
+
+	binner.SetProjection(projection._11, projection._22, nearPlane, farPlane);
+	PrepareLights(lights, view);
+
+	//Indices point into the GPU light buffer, after the directional lights
+	binner.Bin(viewLights.data(), binnedLightCount, directionalLightCount, clusterRanges, lightIndices);
+
+	auto end = std::chrono::high_resolution_clock::now();
+	buildMilliseconds = std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+// --------------------------------------------------------
+// Sorts the lights for the GPU and moves the binned ones
+// into view space
+// --------------------------------------------------------
+void LightClusterGrid::PrepareLights(const std::vector<Light>& lights, const DirectX::XMFLOAT4X4& view) {
+	sortedLights.clear();
+
+	for (const Light& light : lights) {
+		if (light.Type == LIGHT_TYPE_DIRECTIONAL) {
+			sortedLights.push_back(light);
+		}
+	}
+
+	directionalLightCount = (unsigned int)sortedLights.size();
+
+	for (const Light& light : lights) {
+		if (light.Type != LIGHT_TYPE_DIRECTIONAL) {
+			sortedLights.push_back(light);
+		}
+	}
+
+	binnedLightCount = (unsigned int)sortedLights.size() - directionalLightCount;
+
+	//The per entity culling works in world space
+	lightVolumes.resize(binnedLightCount);
+	for (unsigned int i = 0; i < binnedLightCount; i++) {
+		const Light& light = sortedLights[directionalLightCount + i];
+		lightVolumes[i] = light.Type == LIGHT_TYPE_SPOT ?
+			LightCuller::CreateSpotVolume(&light.Position.x, &light.Direction.x, light.Range, light.SpotFalloff) :
+			LightCuller::CreatePointVolume(&light.Position.x, light.Range);
+	}
+
+	culler.SetVolumes(lightVolumes.data(), binnedLightCount);
+	culler.ResetStats();
+	entityLightIndices.clear();
+
+	viewLights.resize(binnedLightCount);
+	XMMATRIX viewMatrix = XMLoadFloat4x4(&view);
+
+	for (unsigned int i = 0; i < binnedLightCount; i++) {
+		const LightVolume& volume = lightVolumes[i];
+
+		//Move the volume into view space, which keeps the radius as
+		//the view has no scale
+		BinnedLight& light = viewLights[i];
+		TransformFloat3(volume.Center, viewMatrix, false, light.Center);
+		TransformFloat3(volume.Position, viewMatrix, false, light.Apex);
+		TransformFloat3(volume.Direction, viewMatrix, true, light.Direction);
+		light.Radius = volume.Radius;
+		light.CosAngle = volume.CosAngle;
+		light.SinAngle = volume.SinAngle;
+		light.Range = volume.Range;
+		light.IsSpot = volume.IsSpot;
+	}
+}
+
+// --------------------------------------------------------
+// Copies the results of the last build to the GPU
+//  - The light and index buffers grow as needed
+// --------------------------------------------------------
+void LightClusterGrid::Upload() {
+	unsigned int lightCount = (std::max)((unsigned int)sortedLights.size(), 1u);
+	if (lightCount > lightCapacity) {
+		lightCapacity = (std::max)(lightCount, lightCapacity * 2);
+		CreateStructuredBuffer(sizeof(Light), lightCapacity, lightBuffer, lightSRV);
+	}
+
+	//Entity lists go after the cluster lists in the same buffer
+	lightIndices.insert(lightIndices.end(), entityLightIndices.begin(), entityLightIndices.end());
+
+	unsigned int indexCount = (std::max)((unsigned int)lightIndices.size(), 1u);
+	if (indexCount > lightIndexCapacity) {
+		lightIndexCapacity = (std::max)(indexCount, lightIndexCapacity * 2);
+		CreateStructuredBuffer(sizeof(unsigned int), lightIndexCapacity, lightIndexBuffer, lightIndexSRV);
+	}
+
+	UploadBuffer(lightBuffer, sortedLights.data(), sizeof(Light) * sortedLights.size());
+	UploadBuffer(clusterRangeBuffer, clusterRanges.data(), sizeof(ClusterRange) * clusterRanges.size());
+	UploadBuffer(lightIndexBuffer, lightIndices.data(), sizeof(unsigned int) * lightIndices.size());
+}
+
+// --------------------------------------------------------
+// Sends the buffers and the values needed to find a pixel's
+// cluster to a pixel shader
+// --------------------------------------------------------
+void LightClusterGrid::SetShaderData(std::shared_ptr<SimplePixelShader> ps, unsigned int screenWidth, unsigned int screenHeight) {
+	//slice = log(depth) * scale + bias, matching the binner
+	ps->SetInt("directionalLightCount", (int)directionalLightCount);
+	ps->SetFloat2("clusterScreenScale", XMFLOAT2((float)CLUSTER_COUNT_X / screenWidth, (float)CLUSTER_COUNT_Y / screenHeight));
+	ps->SetFloat("clusterDepthScale", binner.GetDepthScale());
+	ps->SetFloat("clusterDepthBias", binner.GetDepthBias());
+
+	ps->SetShaderResourceView("Lights", lightSRV);
+	ps->SetShaderResourceView("ClusterRanges", clusterRangeSRV);
+	ps->SetShaderResourceView("LightIndices", lightIndexSRV);
+}
+
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> LightClusterGrid::GetLightSRV() {
+	return lightSRV;
+}
+
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> LightClusterGrid::GetClusterRangeSRV() {
+	return clusterRangeSRV;
+}
+
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> LightClusterGrid::GetLightIndexSRV() {
+	return lightIndexSRV;
+}
+
+void LightClusterGrid::CreateStructuredBuffer(
+	unsigned int stride,
+	unsigned int count,
+	Microsoft::WRL::ComPtr<ID3D11Buffer>& buffer,
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>& srv) {
+	D3D11_BUFFER_DESC bufferDesc = {};
+	bufferDesc.ByteWidth = stride * count;
+	bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	bufferDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	bufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+	bufferDesc.StructureByteStride = stride;
+	device->CreateBuffer(&bufferDesc, 0, buffer.ReleaseAndGetAddressOf());
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+	srvDesc.Buffer.FirstElement = 0;
+	srvDesc.Buffer.NumElements = count;
+	device->CreateShaderResourceView(buffer.Get(), &srvDesc, srv.ReleaseAndGetAddressOf());
+}
+
+void LightClusterGrid::UploadBuffer(Microsoft::WRL::ComPtr<ID3D11Buffer> buffer, const void* data, size_t size) {
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	if (FAILED(context->Map(buffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+		return;
+	}
+
+	if (size > 0) {
+		memcpy(mapped.pData, data, size);
+	}
+
+	context->Unmap(buffer.Get(), 0);
+}
+
+float LightClusterGrid::GetBuildMilliseconds() {
+	return buildMilliseconds;
+}
+
+unsigned int LightClusterGrid::GetLightCount() {
+	return (unsigned int)sortedLights.size();
+}
+
+unsigned int LightClusterGrid::GetBinnedLightCount() {
+	return binnedLightCount;
+}
+
+// --------------------------------------------------------
+// Finds the binned lights that reach an entity and adds
+// them to the entity light lists
+//  - Returns where the entity's list will be once uploaded
+// --------------------------------------------------------
+ClusterRange LightClusterGrid::CullEntityLights(const DirectX::BoundingBox& worldBounds) {
+	ClusterRange range;
+	range.Offset = (unsigned int)(lightIndices.size() + entityLightIndices.size());
+	range.Count = culler.Cull(&worldBounds.Center.x, &worldBounds.Extents.x, entityLightIndices, directionalLightCount);
+	return range;
+}
+
+// --------------------------------------------------------
+// Sends an entity's light list to a pixel shader
+// --------------------------------------------------------
+void LightClusterGrid::SetEntityLights(std::shared_ptr<SimplePixelShader> ps, ClusterRange range) {
+	ps->SetInt("entityLightOffset", (int)range.Offset);
+	ps->SetInt("entityLightCount", (int)range.Count);
+}
+
+unsigned int LightClusterGrid::GetEntityLightTests() {
+	return culler.GetTestsRun();
+}
+
+unsigned int LightClusterGrid::GetEntityLightsCulled() {
+	return culler.GetLightsCulled();
+}
+
+unsigned int LightClusterGrid::GetLightIndexCount() {
+	return (unsigned int)lightIndices.size();
+}
+
+unsigned int LightClusterGrid::GetMaxLightsPerCluster() {
+	return binner.GetMaxLightsPerCluster();
+}
+
+unsigned int LightClusterGrid::GetThreadCount() {
+	return JobSystem::GetInstance().GetThreadCount();
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <d3d11.h>
+#include <DirectXMath.h>
+#include <wrl/client.h> // Used for ComPtr - a smart pointer for COM objects
+
+#include <memory>
+#include <vector>
+
+#include "Lights.h"
+#include "LightBinner.h"
+#include "LightCuller.h"
+#include "SimpleShader.h"
+
+// --------------------------------------------------------
+// Assigns lights to a 3D grid of view space clusters
+//
+// - The grid is 16x9 screen tiles, each split into depth
+//    slices that get exponentially thicker with distance
+// - Directional lights touch every pixel, so they are kept
+//    at the front of the light buffer instead of binned
+// - The binning itself is LightBinner's, which this feeds
+//    with the lights moved into view space
+// - The results go into structured buffers, so each pixel
+//    only loops over the lights in its own cluster
+// - Entities can also get their own culled light list, and
+//    pixels use whichever list is shorter
+// --------------------------------------------------------
+class LightClusterGrid {
+private:
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+
+	//GPU buffers
+	Microsoft::WRL::ComPtr<ID3D11Buffer> lightBuffer;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> lightSRV;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> clusterRangeBuffer;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> clusterRangeSRV;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> lightIndexBuffer;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> lightIndexSRV;
+	unsigned int lightCapacity;
+	unsigned int lightIndexCapacity;
+
+	//Results of the last build
+	std::vector<Light> sortedLights; // Directional lights first
+	unsigned int directionalLightCount;
+	std::vector<ClusterRange> clusterRanges;
+	std::vector<unsigned int> lightIndices;
+
+	//Point and spot lights in view space, binned by the binner
+	std::vector<BinnedLight> viewLights;
+	LightBinner binner;
+	unsigned int binnedLightCount;
+
+	//Per entity light lists, stored after the cluster lists
+	std::vector<LightVolume> lightVolumes; // World space, for the culler
+	LightCuller culler;
+	std::vector<unsigned int> entityLightIndices;
+
+	//Stats
+	float buildMilliseconds;
+
+	void PrepareLights(const std::vector<Light>& lights, const DirectX::XMFLOAT4X4& view);
+
+	void CreateStructuredBuffer(
+		unsigned int stride,
+		unsigned int count,
+		Microsoft::WRL::ComPtr<ID3D11Buffer>& buffer,
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>& srv);
+	void UploadBuffer(Microsoft::WRL::ComPtr<ID3D11Buffer> buffer, const void* data, size_t size);
+
+public:
+	LightClusterGrid(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context);
+	~LightClusterGrid();
+
+	void Build(
+		const std::vector<Light>& lights,
+		DirectX::XMFLOAT4X4 view,
+		DirectX::XMFLOAT4X4 projection,
+		float nearPlane,
+		float farPlane);
+	void Upload();
+	void SetShaderData(std::shared_ptr<SimplePixelShader> ps, unsigned int screenWidth, unsigned int screenHeight);
+
+	//Culls the binned lights against an entity's world bounds
+	// - Must be called between Build() and Upload()
+	ClusterRange CullEntityLights(const DirectX::BoundingBox& worldBounds);
+	void SetEntityLights(std::shared_ptr<SimplePixelShader> ps, ClusterRange range);
+
+	//The buffers SetShaderData() binds, for binding on other contexts
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> GetLightSRV();
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> GetClusterRangeSRV();
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> GetLightIndexSRV();
+
+	//Stats
+	float GetBuildMilliseconds();
+	unsigned int GetLightCount();
+	unsigned int GetBinnedLightCount();
+	unsigned int GetLightIndexCount();
+	unsigned int GetMaxLightsPerCluster();
+	unsigned int GetThreadCount();
+	unsigned int GetEntityLightTests();
+	unsigned int GetEntityLightsCulled();
+};
@@ -0,0 +1,142 @@
+#include "LightCuller.h"
+
+#include <algorithm>
+#include <cmath>
+
+LightCuller::LightCuller() :
+	testsRun(0),
+	lightsCulled(0) {
+}
+
+LightCuller::~LightCuller() {
+}
+
+// --------------------------------------------------------
+// A point light reaches the sphere of its range
+// --------------------------------------------------------
+LightVolume LightCuller::CreatePointVolume(const float position[3], float range) {
+	LightVolume volume = {};
+	for (int c = 0; c < 3; c++) {
+		volume.Center[c] = volume.Position[c] = position[c];
+	}
+	volume.Radius = volume.Range = range;
+	return volume;
+}
+
+// --------------------------------------------------------
+// Works out the space a spot light's cone reaches
+// --------------------------------------------------------
+LightVolume LightCuller::CreateSpotVolume(const float position[3], const float direction[3], float range, float spotFalloff) {
+	LightVolume volume = {};
+	volume.Range = range;
+	volume.IsSpot = true;
+
+	float length = sqrtf(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+	for (int c = 0; c < 3; c++) {
+		volume.Position[c] = position[c];
+		volume.Direction[c] = length > 0.0f ? direction[c] / length : 0.0f;
+	}
+
+	volume.CosAngle = GetSpotCosAngle(spotFalloff);
+	volume.SinAngle = sqrtf(1.0f - volume.CosAngle * volume.CosAngle);
+
+	//Wide cones are bounded by the circle at their end, narrow
+	//ones by the sphere touching their tip and both edges
+	float distance;
+	if (volume.CosAngle < 0.7071f) {
+		distance = range * volume.CosAngle;
+		volume.Radius = range * volume.SinAngle;
+	} else {
+		distance = range / (2.0f * volume.CosAngle);
+		volume.Radius = distance;
+	}
+
+	for (int c = 0; c < 3; c++) {
+		volume.Center[c] = position[c] + volume.Direction[c] * distance;
+	}
+	return volume;
+}
+
+// --------------------------------------------------------
+// Cosine of the angle where a spot light's falloff drops
+// below SPOT_LIGHT_CUTOFF
+//  - Matches pow(dot(-toLight, direction), SpotFalloff)
+//    in the pixel shader
+// --------------------------------------------------------
+float LightCuller::GetSpotCosAngle(float spotFalloff) {
+	if (spotFalloff <= 0.0f) {
+		return 0.0f;
+	}
+
+	return powf(SPOT_LIGHT_CUTOFF, 1.0f / spotFalloff);
+}
+
+// --------------------------------------------------------
+// Tests a spot light's cone against a sphere
+//  - Rejects spheres outside the cone's angle, past its end
+//    or behind its tip
+// --------------------------------------------------------
+bool LightCuller::ConeIntersectsSphere(const LightVolume& volume, const float center[3], float radius) {
+	float toSphere[3] = { center[0] - volume.Position[0], center[1] - volume.Position[1], center[2] - volume.Position[2] };
+	float lengthSquared = toSphere[0] * toSphere[0] + toSphere[1] * toSphere[1] + toSphere[2] * toSphere[2];
+	float alongAxis = toSphere[0] * volume.Direction[0] + toSphere[1] * volume.Direction[1] + toSphere[2] * volume.Direction[2];
+
+	float closestDistance = volume.CosAngle * sqrtf(fmaxf(lengthSquared - alongAxis * alongAxis, 0.0f)) - alongAxis * volume.SinAngle;
+
+	bool outsideAngle = closestDistance > radius;
+	bool pastEnd = alongAxis > radius + volume.Range;
+	bool behindTip = alongAxis < -radius;
+
+	return !(outsideAngle || pastEnd || behindTip);
+}
+
+void LightCuller::SetVolumes(const LightVolume* volumes, unsigned int count) {
+	this->volumes.assign(volumes, volumes + count);
+}
+
+// --------------------------------------------------------
+// Finds the lights that reach the given world space box
+//  - Each light's sphere is tested against the box, then
+//    spot cones against the sphere around the box
+// --------------------------------------------------------
+unsigned int LightCuller::Cull(const float center[3], const float extents[3], std::vector<unsigned int>& indices, unsigned int indexOffset) {
+	float boxRadius = sqrtf(extents[0] * extents[0] + extents[1] * extents[1] + extents[2] * extents[2]);
+
+	unsigned int added = 0;
+
+	for (unsigned int i = 0; i < (unsigned int)volumes.size(); i++) {
+		const LightVolume& volume = volumes[i];
+		testsRun++;
+
+		//Distance from the sphere's center to the closest point in the box
+		float distSquared = 0.0f;
+		for (int c = 0; c < 3; c++) {
+			float d = (std::max)(fabsf(volume.Center[c] - center[c]) - extents[c], 0.0f);
+			distSquared += d * d;
+		}
+
+		if (distSquared > volume.Radius * volume.Radius ||
+			(volume.IsSpot && !ConeIntersectsSphere(volume, center, boxRadius))) {
+			lightsCulled++;
+			continue;
+		}
+
+		indices.push_back(i + indexOffset);
+		added++;
+	}
+
+	return added;
+}
+
+void LightCuller::ResetStats() {
+	testsRun = 0;
+	lightsCulled = 0;
+}
+
+unsigned int LightCuller::GetTestsRun() {
+	return testsRun;
+}
+
+unsigned int LightCuller::GetLightsCulled() {
+	return lightsCulled;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+
+// Spot lights are treated as ending where their falloff drops below this
+#define SPOT_LIGHT_CUTOFF (1.0f / 256.0f)
+
+// --------------------------------------------------------
+// The space a point or spot light can reach
+//
+// - Center and Radius are the tightest sphere around the
+//    light, which for a spot light is the sphere around its
+//    cone
+// - Point lights leave the cone values unused
+// --------------------------------------------------------
+struct LightVolume {
+	float Center[3];
+	float Radius;
+	float Position[3];
+	float Direction[3];	// Unit length, down the cone
+	float Range;
+	float CosAngle;
+	float SinAngle;
+	bool IsSpot;
+};
+
+// --------------------------------------------------------
+// Finds which point and spot lights can reach a volume
+//
+// - Knows nothing of DirectXMath or the device, like
+//    LightBinner, so it can be tested and timed anywhere
+// - Spot lights are tested as cones, not just as spheres
+// --------------------------------------------------------
+class LightCuller {
+private:
+	std::vector<LightVolume> volumes;
+
+	//Stats
+	unsigned int testsRun;
+	unsigned int lightsCulled;
+
+public:
+	LightCuller();
+	~LightCuller();
+
+	static LightVolume CreatePointVolume(const float position[3], float range);
+	static LightVolume CreateSpotVolume(const float position[3], const float direction[3], float range, float spotFalloff);
+	static float GetSpotCosAngle(float spotFalloff);
+	static bool ConeIntersectsSphere(const LightVolume& volume, const float center[3], float radius);
+
+	//The lights to cull, in world space
+	void SetVolumes(const LightVolume* volumes, unsigned int count);
+
+	//Appends the index of each volume reaching the box, plus indexOffset
+	// - Returns how many were added
+	unsigned int Cull(const float center[3], const float extents[3], std::vector<unsigned int>& indices, unsigned int indexOffset = 0);
+
+	void ResetStats();
+	unsigned int GetTestsRun();
+	unsigned int GetLightsCulled();
+};
@@ -0,0 +1,143 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <codecvt>
+#include <locale>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile() :
+	file(INVALID_HANDLE_VALUE),
+	mapping(0),
+	view(0),
+	size(0) {
+}
+#else
+MappedFile::MappedFile() :
+	file(-1),
+	view(0),
+	size(0) {
+}
+#endif
+
+MappedFile::~MappedFile() {
+	Close();
+}
+
+bool MappedFile::IsOpen() const {
+#ifdef _WIN32
+	return file != INVALID_HANDLE_VALUE;
+#else
+	return file != -1;
+#endif
+}
+
+const uint8_t* MappedFile::GetData() const {
+	return view;
+}
+
+size_t MappedFile::GetSize() const {
+	return size;
+}
+
+#ifdef _WIN32
+bool MappedFile::Open(const std::wstring& path) {
+	Close();
+
+	file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, 0);
+	if (file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER fileSize = {};
+	if (!GetFileSizeEx(file, &fileSize)) {
+		Close();
+		return false;
+	}
+
+	//Mapping an empty file fails, and there's nothing to map anyway
+	size = (size_t)fileSize.QuadPart;
+	if (size == 0) return true;
+
+	mapping = CreateFileMappingW(file, 0, PAGE_READONLY, 0, 0, 0);
+	if (mapping) view = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!view) {
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void MappedFile::Close() {
+	if (view) UnmapViewOfFile(view);
+	if (mapping) CloseHandle(mapping);
+	if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+
+	view = 0;
+	mapping = 0;
+	file = INVALID_HANDLE_VALUE;
+	size = 0;
+}
+
+void MappedFile::Prefetch(const void* address, size_t byteCount) const {
+	if (!view || byteCount == 0) return;
+
+	WIN32_MEMORY_RANGE_ENTRY range = {};
+	range.VirtualAddress = (PVOID)address;
+	range.NumberOfBytes = byteCount;
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+#else
+bool MappedFile::Open(const std::wstring& path) {
+	Close();
+
+	std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
+	file = open(converter.to_bytes(path).c_str(), O_RDONLY);
+	if (file == -1) return false;
+
+	struct stat status = {};
+	if (fstat(file, &status) != 0) {
+		Close();
+		return false;
+	}
+
+	size = (size_t)status.st_size;
+	if (size == 0) return true;
+
+	void* address = mmap(0, size, PROT_READ, MAP_PRIVATE, file, 0);
+	if (address == MAP_FAILED) {
+		Close();
+		return false;
+	}
+
+	view = (const uint8_t*)address;
+	return true;
+}
+
+void MappedFile::Close() {
+	if (view) munmap((void*)view, size);
+	if (file != -1) close(file);
+
+	view = 0;
+	file = -1;
+	size = 0;
+}
+
+// --------------------------------------------------------
+// madvise() wants a page aligned start, so the range is
+// widened down to the page it starts in
+// --------------------------------------------------------
+void MappedFile::Prefetch(const void* address, size_t byteCount) const {
+	if (!view || byteCount == 0) return;
+
+	uintptr_t pageSize = (uintptr_t)sysconf(_SC_PAGESIZE);
+	uintptr_t start = (uintptr_t)address & ~(pageSize - 1);
+	madvise((void*)start, (uintptr_t)address + byteCount - start, MADV_WILLNEED);
+}
+#endif
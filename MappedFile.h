@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// --------------------------------------------------------
+// A whole file mapped read only into memory
+//
+// - Pages are read in by the OS as they're touched, so
+//    opening a large file costs next to nothing
+// - Windows maps through a file mapping object, and other
+//    platforms through mmap(), so code reading files this
+//    way needs no platform headers
+// --------------------------------------------------------
+class MappedFile {
+private:
+#ifdef _WIN32
+	//HANDLEs, without pulling Windows.h into every includer
+	void* file;
+	void* mapping;
+#else
+	int file;
+#endif
+	const uint8_t* view;
+	size_t size;
+
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(MappedFile const&) = delete;
+	void operator=(MappedFile const&) = delete;
+
+	//Maps the whole file, closing whatever was open
+	// - Empty files open, but have no data
+	bool Open(const std::wstring& path);
+	void Close();
+
+	bool IsOpen() const;
+	const uint8_t* GetData() const;
+	size_t GetSize() const;
+
+	//Hints that a range of the mapping is about to be read
+	// - Only a hint, so it's fine for the OS to ignore it
+	void Prefetch(const void* address, size_t byteCount) const;
+};
@@ -1,16 +1,29 @@
 #include "Material.h"
 
 Material::Material(DirectX::XMFLOAT4 tint, float roughness, std::shared_ptr<SimpleVertexShader> vs, std::shared_ptr<SimplePixelShader> ps) :
-colorTint(tint),
-roughness(roughness),
-vertexShader(vs),
-pixelShader(ps) {
+Material(MaterialTemplate::Get(vs, ps), tint, roughness) {
 
 }
 
+Material::Material(std::shared_ptr<MaterialTemplate> materialTemplate, DirectX::XMFLOAT4 tint, float roughness) :
+materialTemplate(materialTemplate),
+dirty(true),
+compiledVersion(0) {
+    SetColorTint(tint);
+    SetRoughness(roughness);
+}
+
 Material::~Material() {
 }
 
+// --------------------------------------------------------
+// Gets the pool materials are created from
+// --------------------------------------------------------
+ObjectPool<Material>& Material::GetPool() {
+	static ObjectPool<Material> pool(MemoryTag::Materials);
+	return pool;
+}
+
 // --------------------------------------------------------
 // Get the ColorTint
 // --------------------------------------------------------
@@ -26,14 +39,18 @@ float Material::GetRoughness() {
 // Gets the smart pointer to the Vertex Shader
 // --------------------------------------------------------
 std::shared_ptr<SimpleVertexShader> Material::GetVertexShader() {
-    return vertexShader;
+    return materialTemplate->GetVertexShader();
 }
 
 // --------------------------------------------------------
 // Gets the smart pointer to the Pixel Shader
 // --------------------------------------------------------
 std::shared_ptr<SimplePixelShader> Material::GetPixelShader() {
-    return pixelShader;
+    return materialTemplate->GetPixelShader();
+}
+
+std::shared_ptr<MaterialTemplate> Material::GetTemplate() {
+    return materialTemplate;
 }
 
 // --------------------------------------------------------
@@ -41,35 +58,106 @@ std::shared_ptr<SimplePixelShader> Material::GetPixelShader() {
 // --------------------------------------------------------
 void Material::SetColorTint(DirectX::XMFLOAT4 tint) {
     colorTint = DirectX::XMFLOAT4(tint);
+    desc.SetParameter("colorTint", &colorTint.x, sizeof(colorTint));
+    dirty = true;
 }
 
 void Material::SetRoughness(float roughness) {
     Material::roughness = roughness;
+    desc.SetParameter("roughness", &roughness, sizeof(roughness));
+    dirty = true;
 }
 
 // --------------------------------------------------------
 // Sets the Vertex Shader
+//  - Moves the material to the template for its new shaders
 // --------------------------------------------------------
 void Material::SetVertexShader(std::shared_ptr<SimpleVertexShader> vs) {
-    vertexShader = vs;
+    materialTemplate = MaterialTemplate::Get(vs, materialTemplate->GetPixelShader());
+    dirty = true;
 }
 
 // --------------------------------------------------------
 // Sets the Pixel Shader
 // --------------------------------------------------------
 void Material::SetPixelShader(std::shared_ptr<SimplePixelShader> ps) {
-    pixelShader = ps;
+    materialTemplate = MaterialTemplate::Get(materialTemplate->GetVertexShader(), ps);
+    dirty = true;
 }
 
 void Material::AddTextureSRV(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv) {
-    textureSRVs.insert({ name, srv });
+    AddTextureSRV(name, MaterialTemplate::WrapResource(srv));
 }
 
 void Material::AddSampler(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState) {
-    samplerOptions.insert({ name, samplerState });
+    AddSampler(name, MaterialTemplate::WrapResource(samplerState));
+}
+
+void Material::AddTextureSRV(std::string name, MaterialResource srv) {
+    desc.SetTexture(name, srv);
+    dirty = true;
+}
+
+void Material::AddSampler(std::string name, MaterialResource samplerState) {
+    desc.SetSampler(name, samplerState);
+    dirty = true;
+}
+
+const std::vector<std::pair<std::string, MaterialResource>>& Material::GetTextureSRVs() {
+    return desc.Textures;
+}
+
+const std::vector<std::pair<std::string, MaterialResource>>& Material::GetSamplers() {
+    return desc.Samplers;
+}
+
+const MaterialBindings& Material::GetBindings() {
+    if (dirty || compiledVersion != materialTemplate->GetVersion()) {
+        bindings = MaterialBindings::Compile(materialTemplate->GetLayout(), materialTemplate->GetDefaults(), desc);
+        compiledVersion = materialTemplate->GetVersion();
+        dirty = false;
+    }
+
+    return bindings;
+}
+
+bool Material::IsBound(const std::string& name) {
+    const MaterialDesc* sources[] = { &desc, &materialTemplate->GetDefaults() };
+    for (const MaterialDesc* source : sources) {
+        for (auto& texture : source->Textures) {
+            if (texture.first == name && texture.second) return true;
+        }
+
+        for (auto& sampler : source->Samplers) {
+            if (sampler.first == name && sampler.second) return true;
+        }
+    }
+
+    return false;
 }
 
-void Material::PrepareMaterial() {
-    for (auto& t : textureSRVs) { pixelShader->SetShaderResourceView(t.first.c_str(), t.second); }
-    for (auto& s : samplerOptions) { pixelShader->SetSamplerState(s.first.c_str(), s.second); }
+const ShaderVariant* Material::SelectVariant(const ShaderManifest& manifest, const std::string& shader, ShaderFeatureRequest features) {
+    const ShaderPermutationSet* set = manifest.FindShader(shader);
+    if (!set) return 0;
+
+    for (const ShaderKeyword& keyword : set->Keywords) {
+        if (keyword.Bindings.empty()) continue;
+
+        bool bound = true;
+        for (const std::string& binding : keyword.Bindings) {
+            bound = bound && IsBound(binding);
+        }
+
+        features.Values[keyword.Name] = bound ? 1 : 0;
+    }
+
+    return manifest.Select(shader, features);
+}
+
+void Material::PrepareMaterial(ID3D11DeviceContext* context) {
+    const MaterialBindings& compiled = GetBindings();
+    MaterialTemplate::Bind(compiled, context);
+
+    std::shared_ptr<SimplePixelShader> ps = materialTemplate->GetPixelShader();
+    if (ps) MaterialTemplate::WriteParameters(compiled, *ps);
 }
@@ -5,29 +5,47 @@
 #include <wrl/client.h> // Used for ComPtr - a smart pointer for COM objects
 
 #include "SimpleShader.h"
+#include "ObjectPool.h"
+#include "MaterialTemplate.h"
+#include "ShaderPermutation.h"
 
+// --------------------------------------------------------
+// An instance of a material template
+//
+// - Tint, roughness, textures and samplers go into a
+//    description, which is compiled against the template
+//    into a flat binding table the first time it's needed
+//    after a change, so drawing never looks up a name
+// - Materials with the same shaders share a template
+// --------------------------------------------------------
 class Material {
 private:
 	//Fields
 	DirectX::XMFLOAT4 colorTint;
 	float roughness;
-	std::shared_ptr<SimpleVertexShader> vertexShader;
-	std::shared_ptr<SimplePixelShader> pixelShader;
 
-	//Texture fields
-	std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> textureSRVs;
-	std::unordered_map <std::string, Microsoft::WRL::ComPtr<ID3D11SamplerState>> samplerOptions;
+	//Template fields
+	std::shared_ptr<MaterialTemplate> materialTemplate;
+	MaterialDesc desc;
+	MaterialBindings bindings;
+	bool dirty;
+	unsigned int compiledVersion; // Template version the bindings are from
 
 public:
 	//Constructor/Destructor
 	Material(DirectX::XMFLOAT4 tint, float roughness, std::shared_ptr<SimpleVertexShader> vs, std::shared_ptr<SimplePixelShader> ps);
+	Material(std::shared_ptr<MaterialTemplate> materialTemplate, DirectX::XMFLOAT4 tint, float roughness);
 	~Material();
 
+	//Pool every material should be created from
+	static ObjectPool<Material>& GetPool();
+
 	//Getters
 	DirectX::XMFLOAT4 GetColorTint();
 	float GetRoughness();
 	std::shared_ptr<SimpleVertexShader> GetVertexShader();
 	std::shared_ptr<SimplePixelShader> GetPixelShader();
+	std::shared_ptr<MaterialTemplate> GetTemplate();
 
 	//Setters
 	void SetColorTint(DirectX::XMFLOAT4 tint);
@@ -38,6 +56,29 @@ public:
 	void AddTextureSRV(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
 	void AddSampler(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
 
-	void PrepareMaterial();
+	//Shares a resource another material already wrapped
+	void AddTextureSRV(std::string name, MaterialResource srv);
+	void AddSampler(std::string name, MaterialResource samplerState);
+
+	//This material's own textures and samplers, not the template's
+	const std::vector<std::pair<std::string, MaterialResource>>& GetTextureSRVs();
+	const std::vector<std::pair<std::string, MaterialResource>>& GetSamplers();
+
+	//Compiled binding table, recompiled if anything changed
+	// - Not thread safe, so call it before recording in parallel
+	const MaterialBindings& GetBindings();
+
+	//Whether this material or its template sets a resource
+	bool IsBound(const std::string& name);
+
+	//Cheapest variant of a shader that supports this material
+	// - Keywords that bind resources come from what's bound here,
+	//    and the rest from the scene's features
+	// - Null when there's nothing better than the default shader
+	const ShaderVariant* SelectVariant(const ShaderManifest& manifest, const std::string& shader, ShaderFeatureRequest features);
+
+	//Binds the textures and samplers, and writes the parameters
+	// into the pixel shader's constant buffers
+	void PrepareMaterial(ID3D11DeviceContext* context);
 };
 
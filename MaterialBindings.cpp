@@ -0,0 +1,135 @@
+#include "MaterialBindings.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+void MaterialDesc::SetParameter(const std::string& name, const float* value, unsigned int size) {
+	MaterialParameter parameter = {};
+	parameter.Name = name;
+	parameter.Size = (std::min)(size, (unsigned int)MATERIAL_MAX_PARAMETER_SIZE);
+	memcpy(parameter.Value, value, parameter.Size);
+
+	for (MaterialParameter& existing : Parameters) {
+		if (existing.Name == name) {
+			existing = parameter;
+			return;
+		}
+	}
+
+	Parameters.push_back(parameter);
+}
+
+void MaterialDesc::SetTexture(const std::string& name, MaterialResource texture) {
+	for (auto& existing : Textures) {
+		if (existing.first == name) {
+			existing.second = texture;
+			return;
+		}
+	}
+
+	Textures.push_back({ name, texture });
+}
+
+void MaterialDesc::SetSampler(const std::string& name, MaterialResource sampler) {
+	for (auto& existing : Samplers) {
+		if (existing.first == name) {
+			existing.second = sampler;
+			return;
+		}
+	}
+
+	Samplers.push_back({ name, sampler });
+}
+
+// --------------------------------------------------------
+// Sorts a set of resources by register and splits it
+// into ranges wherever a register is skipped
+// --------------------------------------------------------
+static void BuildRanges(const std::map<unsigned int, void*>& slots, std::vector<void*>& resources, std::vector<MaterialBindRange>& ranges) {
+	//Maps are already in register order
+
+	for (auto& slot : slots) {
+		if (ranges.empty() || ranges.back().First + ranges.back().Count != slot.first) {
+			MaterialBindRange range = {};
+			range.First = slot.first;
+			range.Offset = (unsigned int)resources.size();
+			ranges.push_back(range);
+		}
+
+		resources.push_back(slot.second);
+		ranges.back().Count++;
+	}
+}
+
+// --------------------------------------------------------
+// Resolves every name in a description against a layout
+//  - The description wins over the defaults for a name
+//     both of them set
+//  - Parameters are packed in constant buffer order, so
+//     ones next to each other in the shader are one copy
+// --------------------------------------------------------
+MaterialBindings MaterialBindings::Compile(const MaterialLayout& layout, const MaterialDesc& defaults, const MaterialDesc& desc) {
+	MaterialBindings bindings;
+
+	//Textures, with the description's replacing the defaults'
+	std::map<unsigned int, void*> textureSlots;
+	for (const MaterialDesc* source : { &defaults, &desc }) {
+		for (auto& texture : source->Textures) {
+			auto slot = layout.Textures.find(texture.first);
+			if (slot == layout.Textures.end()) bindings.Unresolved.push_back(texture.first);
+			else textureSlots[slot->second] = texture.second.get();
+		}
+	}
+
+	std::map<unsigned int, void*> samplerSlots;
+	for (const MaterialDesc* source : { &defaults, &desc }) {
+		for (auto& sampler : source->Samplers) {
+			auto slot = layout.Samplers.find(sampler.first);
+			if (slot == layout.Samplers.end()) bindings.Unresolved.push_back(sampler.first);
+			else samplerSlots[slot->second] = sampler.second.get();
+		}
+	}
+
+	BuildRanges(textureSlots, bindings.Textures, bindings.TextureRanges);
+	BuildRanges(samplerSlots, bindings.Samplers, bindings.SamplerRanges);
+
+	//Parameters, keyed by where they go so they come out in order
+	std::map<std::pair<unsigned int, unsigned int>, std::pair<const MaterialParameter*, unsigned int>> parameters;
+	for (const MaterialDesc* source : { &defaults, &desc }) {
+		for (const MaterialParameter& parameter : source->Parameters) {
+			auto slot = layout.Parameters.find(parameter.Name);
+			if (slot == layout.Parameters.end()) {
+				bindings.Unresolved.push_back(parameter.Name);
+				continue;
+			}
+
+			//Never write past the variable
+			unsigned int size = (std::min)(parameter.Size, slot->second.Size);
+			parameters[std::make_pair(slot->second.Buffer, slot->second.ByteOffset)] = std::make_pair(&parameter, size);
+		}
+	}
+
+	for (auto& entry : parameters) {
+		unsigned int buffer = entry.first.first;
+		unsigned int byteOffset = entry.first.second;
+		const MaterialParameter* parameter = entry.second.first;
+		unsigned int size = entry.second.second;
+
+		//Carry on the last run if this one starts where it ends
+		std::vector<MaterialParameterRun>& runs = bindings.ParameterRuns;
+		if (runs.empty() || runs.back().Buffer != buffer || runs.back().ByteOffset + runs.back().Size != byteOffset) {
+			MaterialParameterRun run = {};
+			run.Buffer = buffer;
+			run.ByteOffset = byteOffset;
+			run.BlockOffset = (unsigned int)bindings.ParameterBlock.size();
+			runs.push_back(run);
+		}
+
+		const uint8_t* value = (const uint8_t*)parameter->Value;
+		bindings.ParameterBlock.insert(bindings.ParameterBlock.end(), value, value + size);
+		runs.back().Size += size;
+	}
+
+	return bindings;
+}
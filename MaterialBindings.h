@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Bytes in the biggest parameter a material can set (a float4)
+#define MATERIAL_MAX_PARAMETER_SIZE 16
+
+// --------------------------------------------------------
+// A texture or sampler a material binds, kept alive while
+// any description refers to it
+//  - Opaque here: whoever makes one decides what it points
+//     at and how it's released (see MaterialTemplate's
+//     WrapResource()), so compiling never sees the API
+// --------------------------------------------------------
+typedef std::shared_ptr<void> MaterialResource;
+
+// --------------------------------------------------------
+// Where a pixel shader keeps a material's values
+//  - Reflected from the shader by MaterialTemplate, or
+//    filled in by hand to compile materials without D3D
+// --------------------------------------------------------
+struct MaterialParameterSlot {
+	unsigned int Buffer;		// Constant buffer index
+	unsigned int ByteOffset;	// Within that buffer
+	unsigned int Size;
+};
+
+struct MaterialLayout {
+	std::unordered_map<std::string, unsigned int> Textures;	// Register of each SRV
+	std::unordered_map<std::string, unsigned int> Samplers;	// Register of each sampler
+	std::unordered_map<std::string, MaterialParameterSlot> Parameters;
+};
+
+// One named value for the parameter block
+struct MaterialParameter {
+	std::string Name;
+	float Value[4];
+	unsigned int Size;	// Bytes actually used
+};
+
+// --------------------------------------------------------
+// What a material sets, by name
+//  - Setting a name again replaces its value
+// --------------------------------------------------------
+struct MaterialDesc {
+	std::vector<MaterialParameter> Parameters;
+	std::vector<std::pair<std::string, MaterialResource>> Textures;
+	std::vector<std::pair<std::string, MaterialResource>> Samplers;
+
+	void SetParameter(const std::string& name, const float* value, unsigned int size);
+	void SetTexture(const std::string& name, MaterialResource texture);
+	void SetSampler(const std::string& name, MaterialResource sampler);
+};
+
+// Consecutive registers set with one call
+struct MaterialBindRange {
+	unsigned int First;		// Register
+	unsigned int Count;
+	unsigned int Offset;	// Into the flat array
+};
+
+// Part of the parameter block that's one memcpy
+struct MaterialParameterRun {
+	unsigned int Buffer;
+	unsigned int ByteOffset;	// In the constant buffer
+	unsigned int BlockOffset;	// In the parameter block
+	unsigned int Size;
+};
+
+// --------------------------------------------------------
+// A material resolved against its shader, ready to bind
+//
+// - Textures and samplers are flat arrays in register order,
+//    only split into ranges where the material leaves a
+//    register to someone else, so a material whose slots are
+//    packed together binds with one PSSetShaderResources and
+//    one PSSetSamplers
+// - Parameters are packed the same way into one block,
+//    copied into the constant buffer a run at a time
+// - Holds what the resources point at, not the resources,
+//    so whatever compiled it has to keep them alive
+// --------------------------------------------------------
+struct MaterialBindings {
+	std::vector<void*> Textures;
+	std::vector<MaterialBindRange> TextureRanges;
+	std::vector<void*> Samplers;
+	std::vector<MaterialBindRange> SamplerRanges;
+	std::vector<uint8_t> ParameterBlock;
+	std::vector<MaterialParameterRun> ParameterRuns;
+
+	//Names the shader doesn't have, which are skipped
+	std::vector<std::string> Unresolved;
+
+	//Resolves a description, over a set of defaults, against a layout
+	static MaterialBindings Compile(const MaterialLayout& layout, const MaterialDesc& defaults, const MaterialDesc& desc);
+};
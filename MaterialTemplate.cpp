@@ -0,0 +1,151 @@
+#include "MaterialTemplate.h"
+
+#include <cstring>
+#include <map>
+
+// Every live template, by its pair of shaders
+typedef std::map<std::pair<ISimpleShader*, ISimpleShader*>, std::weak_ptr<MaterialTemplate>> MaterialTemplateMap;
+static MaterialTemplateMap templates;
+
+MaterialTemplate::MaterialTemplate(std::shared_ptr<SimpleVertexShader> vs, std::shared_ptr<SimplePixelShader> ps) :
+	vertexShader(vs),
+	pixelShader(ps),
+	version(0) {
+	if (ps) layout = Reflect(*ps);
+}
+
+MaterialTemplate::~MaterialTemplate() {
+}
+
+// --------------------------------------------------------
+// Finds or makes the template for a pair of shaders
+//  - Templates are only kept alive by their materials, so
+//     one is made again if every material using it is gone
+// --------------------------------------------------------
+std::shared_ptr<MaterialTemplate> MaterialTemplate::Get(std::shared_ptr<SimpleVertexShader> vs, std::shared_ptr<SimplePixelShader> ps) {
+	std::weak_ptr<MaterialTemplate>& existing = templates[std::make_pair(vs.get(), ps.get())];
+	std::shared_ptr<MaterialTemplate> materialTemplate = existing.lock();
+
+	if (!materialTemplate) {
+		materialTemplate = std::make_shared<MaterialTemplate>(vs, ps);
+		existing = materialTemplate;
+	}
+
+	return materialTemplate;
+}
+
+// --------------------------------------------------------
+// Reflects a reloaded shader again for every template
+// using it, so materials recompile against its new layout
+// --------------------------------------------------------
+void MaterialTemplate::RefreshLayouts(ISimpleShader* shader) {
+	for (auto& entry : templates) {
+		std::shared_ptr<MaterialTemplate> materialTemplate = entry.second.lock();
+		if (!materialTemplate || materialTemplate->pixelShader.get() != shader) continue;
+
+		materialTemplate->layout = Reflect(*materialTemplate->pixelShader);
+		materialTemplate->version++;
+	}
+}
+
+MaterialLayout MaterialTemplate::Reflect(ISimpleShader& shader) {
+	MaterialLayout layout;
+
+	for (auto& srv : shader.GetShaderResourceViewTable()) {
+		layout.Textures[srv.first] = srv.second->BindIndex;
+	}
+
+	for (auto& sampler : shader.GetSamplerTable()) {
+		layout.Samplers[sampler.first] = sampler.second->BindIndex;
+	}
+
+	for (auto& variable : shader.GetVariableTable()) {
+		MaterialParameterSlot slot = {};
+		slot.Buffer = variable.second.ConstantBufferIndex;
+		slot.ByteOffset = variable.second.ByteOffset;
+		slot.Size = variable.second.Size;
+		layout.Parameters[variable.first] = slot;
+	}
+
+	return layout;
+}
+
+// --------------------------------------------------------
+// Sets each range with one call
+//  - Compiled resources are opaque, so they're turned back
+//     into views and samplers a range at a time
+// --------------------------------------------------------
+void MaterialTemplate::Bind(const MaterialBindings& bindings, ID3D11DeviceContext* context) {
+	ID3D11ShaderResourceView* views[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
+	for (const MaterialBindRange& range : bindings.TextureRanges) {
+		for (unsigned int i = 0; i < range.Count; i++) {
+			views[i] = static_cast<ID3D11ShaderResourceView*>(bindings.Textures[range.Offset + i]);
+		}
+		context->PSSetShaderResources(range.First, range.Count, views);
+	}
+
+	ID3D11SamplerState* samplers[D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT];
+	for (const MaterialBindRange& range : bindings.SamplerRanges) {
+		for (unsigned int i = 0; i < range.Count; i++) {
+			samplers[i] = static_cast<ID3D11SamplerState*>(bindings.Samplers[range.Offset + i]);
+		}
+		context->PSSetSamplers(range.First, range.Count, samplers);
+	}
+}
+
+void MaterialTemplate::WriteParameters(const MaterialBindings& bindings, ISimpleShader& shader) {
+	for (const MaterialParameterRun& run : bindings.ParameterRuns) {
+		const SimpleConstantBuffer* buffer = shader.GetBufferInfo(run.Buffer);
+		if (!buffer || run.ByteOffset + run.Size > buffer->Size) continue;
+
+		memcpy(buffer->LocalDataBuffer + run.ByteOffset, bindings.ParameterBlock.data() + run.BlockOffset, run.Size);
+	}
+}
+
+std::shared_ptr<SimpleVertexShader> MaterialTemplate::GetVertexShader() {
+	return vertexShader;
+}
+
+std::shared_ptr<SimplePixelShader> MaterialTemplate::GetPixelShader() {
+	return pixelShader;
+}
+
+const MaterialLayout& MaterialTemplate::GetLayout() {
+	return layout;
+}
+
+const MaterialDesc& MaterialTemplate::GetDefaults() {
+	return defaults;
+}
+
+unsigned int MaterialTemplate::GetVersion() {
+	return version;
+}
+
+void MaterialTemplate::SetParameter(const std::string& name, const float* value, unsigned int size) {
+	defaults.SetParameter(name, value, size);
+	version++;
+}
+
+// --------------------------------------------------------
+// Sets a shared resource
+//  - Setting the one already there is free, so callers can
+//     set these every time without recompiling materials
+// --------------------------------------------------------
+void MaterialTemplate::SetTexture(const std::string& name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv) {
+	for (auto& existing : defaults.Textures) {
+		if (existing.first == name && existing.second.get() == srv.Get()) return;
+	}
+
+	defaults.SetTexture(name, WrapResource(srv));
+	version++;
+}
+
+void MaterialTemplate::SetSampler(const std::string& name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState) {
+	for (auto& existing : defaults.Samplers) {
+		if (existing.first == name && existing.second.get() == samplerState.Get()) return;
+	}
+
+	defaults.SetSampler(name, WrapResource(samplerState));
+	version++;
+}
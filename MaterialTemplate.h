@@ -0,0 +1,70 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h> // Used for ComPtr - a smart pointer for COM objects
+
+#include <memory>
+#include <string>
+
+#include "MaterialBindings.h"
+#include "SimpleShader.h"
+
+// --------------------------------------------------------
+// What every material using a pair of shaders shares
+//
+// - The pixel shader is reflected once, into a layout that
+//    each material compiles its description against
+// - Defaults apply to any material that doesn't set the
+//    same name itself, so frame wide resources like the
+//    shadow map are set once per template
+// - Get() hands out one template per shader pair, so
+//    materials made the usual way share them automatically
+// --------------------------------------------------------
+class MaterialTemplate {
+private:
+	std::shared_ptr<SimpleVertexShader> vertexShader;
+	std::shared_ptr<SimplePixelShader> pixelShader;
+	MaterialLayout layout;
+	MaterialDesc defaults;
+	unsigned int version; // Bumped when the defaults change
+
+public:
+	MaterialTemplate(std::shared_ptr<SimpleVertexShader> vs, std::shared_ptr<SimplePixelShader> ps);
+	~MaterialTemplate();
+
+	//The shared template for a pair of shaders
+	// - Only called from the main thread
+	static std::shared_ptr<MaterialTemplate> Get(std::shared_ptr<SimpleVertexShader> vs, std::shared_ptr<SimplePixelShader> ps);
+
+	//Updates the templates using a pixel shader that was reloaded
+	static void RefreshLayouts(ISimpleShader* shader);
+
+	//Everything a shader can have set, by name
+	static MaterialLayout Reflect(ISimpleShader& shader);
+
+	//Sets compiled textures and samplers on the pixel shader stage
+	static void Bind(const MaterialBindings& bindings, ID3D11DeviceContext* context);
+
+	//Copies compiled parameters into a shader's local constant buffers
+	static void WriteParameters(const MaterialBindings& bindings, ISimpleShader& shader);
+
+	//Hands a view or sampler to a description, holding a reference
+	// until the last description using it lets go
+	template<typename T>
+	static MaterialResource WrapResource(Microsoft::WRL::ComPtr<T> resource) {
+		if (!resource) return MaterialResource();
+
+		resource->AddRef();
+		return MaterialResource(resource.Get(), [](void* wrapped) { static_cast<T*>(wrapped)->Release(); });
+	}
+
+	std::shared_ptr<SimpleVertexShader> GetVertexShader();
+	std::shared_ptr<SimplePixelShader> GetPixelShader();
+	const MaterialLayout& GetLayout();
+	const MaterialDesc& GetDefaults();
+	unsigned int GetVersion();
+
+	void SetParameter(const std::string& name, const float* value, unsigned int size);
+	void SetTexture(const std::string& name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
+	void SetSampler(const std::string& name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
+};
@@ -0,0 +1,196 @@
+#include "MemoryTracker.h"
+
+#include <cstdlib>
+#include <new>
+
+// Bytes in front of every tracked allocation
+//  - Keeps the memory after it 16 byte aligned, like malloc's
+#define MEMORY_HEADER_SIZE 16
+
+std::atomic<uint64_t> MemoryTracker::allocations[(int)MemoryTag::Count];
+std::atomic<uint64_t> MemoryTracker::frees[(int)MemoryTag::Count];
+std::atomic<uint64_t> MemoryTracker::allocatedBytes[(int)MemoryTag::Count];
+std::atomic<int64_t> MemoryTracker::liveBytes[(int)MemoryTag::Count];
+
+MemoryTagStats MemoryTracker::frameStats[(int)MemoryTag::Count];
+uint64_t MemoryTracker::frameAllocations = 0;
+unsigned int MemoryTracker::framesWithoutAllocations = 0;
+unsigned int MemoryTracker::longestRunWithoutAllocations = 0;
+
+namespace {
+	//Plain types only, so they're usable before anything's constructed
+	thread_local MemoryTag threadTag = MemoryTag::General;
+	thread_local uint64_t threadAllocations = 0;
+
+	struct MemoryHeader {
+		uint64_t Size;
+		MemoryTag Tag;
+	};
+
+	static_assert(sizeof(MemoryHeader) <= MEMORY_HEADER_SIZE, "Memory header doesn't fit");
+}
+
+MemoryTagScope::MemoryTagScope(MemoryTag tag) :
+	previous(MemoryTracker::GetThreadTag()) {
+	MemoryTracker::SetThreadTag(tag);
+}
+
+MemoryTagScope::~MemoryTagScope() {
+	MemoryTracker::SetThreadTag(previous);
+}
+
+void* MemoryTracker::Allocate(size_t size) {
+	uint8_t* memory = (uint8_t*)malloc(size + MEMORY_HEADER_SIZE);
+	if (!memory) return 0;
+
+	MemoryHeader* header = (MemoryHeader*)memory;
+	header->Size = size;
+	header->Tag = threadTag;
+
+	int tag = (int)threadTag;
+	allocations[tag].fetch_add(1, std::memory_order_relaxed);
+	allocatedBytes[tag].fetch_add(size, std::memory_order_relaxed);
+	liveBytes[tag].fetch_add((int64_t)size, std::memory_order_relaxed);
+	threadAllocations++;
+
+	return memory + MEMORY_HEADER_SIZE;
+}
+
+void MemoryTracker::Free(void* memory) {
+	if (!memory) return;
+
+	MemoryHeader* header = (MemoryHeader*)((uint8_t*)memory - MEMORY_HEADER_SIZE);
+
+	int tag = (int)header->Tag;
+	frees[tag].fetch_add(1, std::memory_order_relaxed);
+	liveBytes[tag].fetch_sub((int64_t)header->Size, std::memory_order_relaxed);
+
+	free(header);
+}
+
+MemoryTag MemoryTracker::GetThreadTag() {
+	return threadTag;
+}
+
+void MemoryTracker::SetThreadTag(MemoryTag tag) {
+	threadTag = tag;
+}
+
+uint64_t MemoryTracker::GetThreadAllocationCount() {
+	return threadAllocations;
+}
+
+// --------------------------------------------------------
+// Moves the frame's counts into the stats
+//  - Called once at the end of every frame, on the main thread
+// --------------------------------------------------------
+void MemoryTracker::EndFrame() {
+	frameAllocations = 0;
+
+	for (int i = 0; i < (int)MemoryTag::Count; i++) {
+		MemoryTagStats& stats = frameStats[i];
+		stats.Allocations = allocations[i].exchange(0, std::memory_order_relaxed);
+		stats.Frees = frees[i].exchange(0, std::memory_order_relaxed);
+		stats.AllocatedBytes = allocatedBytes[i].exchange(0, std::memory_order_relaxed);
+		stats.LiveBytes = liveBytes[i].load(std::memory_order_relaxed);
+
+		if (i != (int)MemoryTag::Tools) frameAllocations += stats.Allocations;
+	}
+
+	if (frameAllocations == 0) {
+		framesWithoutAllocations++;
+		if (framesWithoutAllocations > longestRunWithoutAllocations) longestRunWithoutAllocations = framesWithoutAllocations;
+	} else {
+		framesWithoutAllocations = 0;
+	}
+}
+
+const MemoryTagStats& MemoryTracker::GetFrameStats(MemoryTag tag) {
+	return frameStats[(int)tag];
+}
+
+uint64_t MemoryTracker::GetFrameAllocations() {
+	return frameAllocations;
+}
+
+unsigned int MemoryTracker::GetFramesWithoutAllocations() {
+	return framesWithoutAllocations;
+}
+
+unsigned int MemoryTracker::GetLongestRunWithoutAllocations() {
+	return longestRunWithoutAllocations;
+}
+
+int64_t MemoryTracker::GetLiveBytes() {
+	int64_t total = 0;
+	for (int i = 0; i < (int)MemoryTag::Count; i++) {
+		total += liveBytes[i].load(std::memory_order_relaxed);
+	}
+	return total;
+}
+
+const char* MemoryTracker::GetTagName(MemoryTag tag) {
+	switch (tag) {
+	case MemoryTag::General: return "General";
+	case MemoryTag::Frame: return "Frame Arena";
+	case MemoryTag::Entities: return "Entities";
+	case MemoryTag::Transforms: return "Transforms";
+	case MemoryTag::Materials: return "Materials";
+	case MemoryTag::Meshes: return "Meshes";
+	case MemoryTag::Shaders: return "Shaders";
+	case MemoryTag::Rendering: return "Rendering";
+	case MemoryTag::Jobs: return "Jobs";
+	case MemoryTag::Tools: return "Tools";
+	default: return "Unknown";
+	}
+}
+
+#ifdef MEMORY_TRACK_HEAP
+// --------------------------------------------------------
+// Global allocation functions, so everything the engine and
+// the standard library allocate goes through the tracker
+// --------------------------------------------------------
+void* operator new(size_t size) {
+	void* memory = MemoryTracker::Allocate(size ? size : 1);
+	if (!memory) throw std::bad_alloc();
+	return memory;
+}
+
+void* operator new[](size_t size) {
+	void* memory = MemoryTracker::Allocate(size ? size : 1);
+	if (!memory) throw std::bad_alloc();
+	return memory;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+	return MemoryTracker::Allocate(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+	return MemoryTracker::Allocate(size ? size : 1);
+}
+
+void operator delete(void* memory) noexcept {
+	MemoryTracker::Free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+	MemoryTracker::Free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+	MemoryTracker::Free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept {
+	MemoryTracker::Free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+	MemoryTracker::Free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+	MemoryTracker::Free(memory);
+}
+#endif
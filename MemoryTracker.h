@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Replaces the global operator new and delete so every heap
+// allocation is counted (comment out to leave them alone)
+//  - MEMORY_NO_TRACK_HEAP leaves them alone too, for builds
+//     like sanitizers that replace them themselves
+#ifndef MEMORY_NO_TRACK_HEAP
+#define MEMORY_TRACK_HEAP
+#endif
+
+// Counts the calling thread's allocations as a tag for the rest of the scope
+#define MEMORY_CONCAT_INNER(a, b) a##b
+#define MEMORY_CONCAT(a, b) MEMORY_CONCAT_INNER(a, b)
+#define MEMORY_TAG_SCOPE(tag) MemoryTagScope MEMORY_CONCAT(memoryTag, __LINE__)(tag)
+
+// --------------------------------------------------------
+// What an allocation was for
+//  - Tools covers the editor windows and anything they do,
+//    which isn't held to the no allocation rule
+// --------------------------------------------------------
+enum class MemoryTag : uint8_t {
+	General,
+	Frame,		// Frame arena blocks
+	Entities,
+	Transforms,
+	Materials,
+	Meshes,
+	Shaders,
+	Rendering,
+	Jobs,
+	Tools,
+	Count
+};
+
+// --------------------------------------------------------
+// One tag's heap use
+//  - Counts are for a single frame, live bytes are totals
+// --------------------------------------------------------
+struct MemoryTagStats {
+	uint64_t Allocations = 0;
+	uint64_t Frees = 0;
+	uint64_t AllocatedBytes = 0;
+	int64_t LiveBytes = 0;
+};
+
+// --------------------------------------------------------
+// Sets the calling thread's tag, and puts the old one back
+// when it goes out of scope
+// --------------------------------------------------------
+class MemoryTagScope {
+private:
+	MemoryTag previous;
+
+public:
+	MemoryTagScope(MemoryTag tag);
+	~MemoryTagScope();
+};
+
+// --------------------------------------------------------
+// Counts heap allocations by tag, per frame
+//
+// - Every allocation carries a small header with its size
+//    and tag, so frees are counted against the right tag
+//    even when another thread does them
+// - All static, as operator new can run before anything
+//    else is constructed
+// - EndFrame() moves the frame's counts into the stats
+//    and keeps a streak of frames the engine (everything
+//    but Tools) didn't allocate at all
+// --------------------------------------------------------
+class MemoryTracker {
+private:
+	static std::atomic<uint64_t> allocations[(int)MemoryTag::Count];
+	static std::atomic<uint64_t> frees[(int)MemoryTag::Count];
+	static std::atomic<uint64_t> allocatedBytes[(int)MemoryTag::Count];
+	static std::atomic<int64_t> liveBytes[(int)MemoryTag::Count];
+
+	static MemoryTagStats frameStats[(int)MemoryTag::Count];
+	static uint64_t frameAllocations;
+	static unsigned int framesWithoutAllocations;
+	static unsigned int longestRunWithoutAllocations;
+
+public:
+	//Tracked malloc and free, used by operator new and ImGui
+	static void* Allocate(size_t size);
+	static void Free(void* memory);
+
+	static MemoryTag GetThreadTag();
+	static void SetThreadTag(MemoryTag tag);
+
+	//Allocations made by the calling thread so far, for
+	//counting what a piece of code allocates
+	static uint64_t GetThreadAllocationCount();
+
+	//Closes out the frame's counts
+	static void EndFrame();
+
+	//Stats for the last finished frame
+	static const MemoryTagStats& GetFrameStats(MemoryTag tag);
+	static uint64_t GetFrameAllocations();	// Excludes Tools
+	static unsigned int GetFramesWithoutAllocations();
+	static unsigned int GetLongestRunWithoutAllocations();
+	static int64_t GetLiveBytes();
+
+	static const char* GetTagName(MemoryTag tag);
+};
@@ -5,40 +5,25 @@
 
 using namespace DirectX;
 
-void Mesh::CreateVertexBuffer(Vertex* vertices, int numVerts, Microsoft::WRL::ComPtr<ID3D11Device> device) {
-	// First, we need to describe the buffer we want Direct3D to make on the GPU
-	D3D11_BUFFER_DESC vbd = {};
-	vbd.Usage = D3D11_USAGE_IMMUTABLE;
-	vbd.ByteWidth = sizeof(Vertex) * numVerts;
-	vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	vbd.CPUAccessFlags = 0;
-	vbd.MiscFlags = 0;
-	vbd.StructureByteStride = 0;
-
-	// Create the proper struct to hold the initial vertex data
-	D3D11_SUBRESOURCE_DATA initialVertexData = {};
-	initialVertexData.pSysMem = vertices; // pSysMem = Pointer to System Memory
-
-	// Actually create the buffer on the GPU with the initial data
-	device->CreateBuffer(&vbd, &initialVertexData, vertexBuffer.GetAddressOf());
+void Mesh::CreateVertexBuffer(Vertex* vertices, int numVerts) {
+	// Vertices never change, so the buffer can be immutable
+	BufferDesc desc = {};
+	desc.Type = BufferType::Vertex;
+	desc.Usage = BufferUsage::Immutable;
+	desc.ByteWidth = sizeof(Vertex) * numVerts;
+
+	vertexData.assign(vertices, vertices + numVerts);
+	vertexBuffer = renderDevice->CreateBuffer(desc, vertices);
 }
 
-void Mesh::CreateIndexBuffer(unsigned int* indices, int numIndices, Microsoft::WRL::ComPtr<ID3D11Device> device) {
-	// Describe the buffer, as we did above, with two major differences
-	D3D11_BUFFER_DESC ibd = {};
-	ibd.Usage = D3D11_USAGE_IMMUTABLE;	// Will NEVER change
-	ibd.ByteWidth = sizeof(unsigned int) * numIndices;	// 3 = number of indices in the buffer
-	ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;	// Tells Direct3D this is an index buffer
-	ibd.CPUAccessFlags = 0;	// Note: We cannot access the data from C++ (this is good)
-	ibd.MiscFlags = 0;
-	ibd.StructureByteStride = 0;
-
-	// Specify the initial data for this buffer, similar to above
-	D3D11_SUBRESOURCE_DATA initialIndexData = {};
-	initialIndexData.pSysMem = indices; // pSysMem = Pointer to System Memory
-
-	// Actually create the buffer with the initial data
-	device->CreateBuffer(&ibd, &initialIndexData, indexBuffer.GetAddressOf());
+void Mesh::CreateIndexBuffer(unsigned int* indices, int numIndices) {
+	BufferDesc desc = {};
+	desc.Type = BufferType::Index;
+	desc.Usage = BufferUsage::Immutable;
+	desc.ByteWidth = sizeof(unsigned int) * numIndices;
+
+	indexData.assign(indices, indices + numIndices);
+	indexBuffer = renderDevice->CreateBuffer(desc, indices);
 }
 
 // --------------------------------------------------------
@@ -108,25 +93,44 @@ void Mesh::CalculateTangents(Vertex* vertices, int numVerts, unsigned int* indic
 	}
 }
 
+// --------------------------------------------------------
+// Calculates the local space bounding box of the vertices
+// --------------------------------------------------------
+void Mesh::CalculateBounds(Vertex* vertices, int numVerts) {
+	BoundingBox::CreateFromPoints(bounds, numVerts, &vertices[0].Position, sizeof(Vertex));
+}
+
+// --------------------------------------------------------
+// Builds the triangle tree from the CPU copies, once the
+// buffers have been made
+// --------------------------------------------------------
+void Mesh::CreateBvh() {
+	const float* positions = vertexData.empty() ? nullptr : &vertexData[0].Position.x;
+	const unsigned int* indices = indexData.empty() ? nullptr : &indexData[0];
+	bvh = std::make_shared<MeshBvh>(positions, sizeof(Vertex), indices, indexData.size());
+}
+
 Mesh::Mesh(
 	Vertex* vertices,
 	int numVerts,
 	unsigned int* indices,
 	int numIndices,
-	Microsoft::WRL::ComPtr<ID3D11Device> device,
-	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context)
-	: context(context) {
+	std::shared_ptr<RenderDevice> renderDevice)
+	: renderDevice(renderDevice),
+	numIndices(numIndices) {
 
 	CalculateTangents(vertices, numVerts, indices, numIndices);
+	CalculateBounds(vertices, numVerts);
 
-	CreateVertexBuffer(vertices, numVerts, device);
-	CreateIndexBuffer(indices, numIndices, device);
+	CreateVertexBuffer(vertices, numVerts);
+	CreateIndexBuffer(indices, numIndices);
+	CreateBvh();
 
 	meshTint = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
 	DirectX::XMStoreFloat4x4(&meshWorldMatrix, DirectX::XMMatrixIdentity());
 }
 
-Mesh::Mesh(const wchar_t* fileToLoad, Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context) : context(context) {
+Mesh::Mesh(const wchar_t* fileToLoad, std::shared_ptr<RenderDevice> renderDevice) : renderDevice(renderDevice) {
 	numIndices = 0;
 	meshTint = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
 	DirectX::XMStoreFloat4x4(&meshWorldMatrix, DirectX::XMMatrixIdentity());
@@ -153,7 +157,7 @@ Mesh::Mesh(const wchar_t* fileToLoad, Microsoft::WRL::ComPtr<ID3D11Device> devic
 	std::vector<DirectX::XMFLOAT3> normals;		// Normals from the file
 	std::vector<DirectX::XMFLOAT2> uvs;		// UVs from the file
 	std::vector<Vertex> verts;		// Verts we're assembling
-	std::vector<UINT> indices;		// Indices of these verts
+	std::vector<unsigned int> indices;		// Indices of these verts
 	int vertCounter = 0;			// Count of vertices
 	int indexCounter = 0;			// Count of indices
 	char chars[100];			// String for line reading
@@ -338,25 +342,29 @@ Mesh::Mesh(const wchar_t* fileToLoad, Microsoft::WRL::ComPtr<ID3D11Device> devic
 	numIndices = indexCounter;
 
 	CalculateTangents(&verts[0], vertCounter, &indices[0], numIndices);
+	CalculateBounds(&verts[0], vertCounter);
 
-	CreateVertexBuffer(&verts[0], vertCounter, device);
-	CreateIndexBuffer(&indices[0], indexCounter, device);
+	CreateVertexBuffer(&verts[0], vertCounter);
+	CreateIndexBuffer(&indices[0], indexCounter);
+	CreateBvh();
 }
 
 Mesh::~Mesh() {
+	renderDevice->DestroyBuffer(vertexBuffer);
+	renderDevice->DestroyBuffer(indexBuffer);
 }
 
 // --------------------------------------------------------
 // Gets the Vertex Buffer
 // --------------------------------------------------------
-Microsoft::WRL::ComPtr<ID3D11Buffer> Mesh::GetVertexBuffer() {
+BufferHandle Mesh::GetVertexBuffer() {
 	return vertexBuffer;
 }
 
 // --------------------------------------------------------
 // Gets the Index Buffer
 // --------------------------------------------------------
-Microsoft::WRL::ComPtr<ID3D11Buffer> Mesh::GetIndexBuffer() {
+BufferHandle Mesh::GetIndexBuffer() {
 	return indexBuffer;
 }
 
@@ -367,18 +375,48 @@ int Mesh::GetIndexCount() {
 	return numIndices;
 }
 
+// --------------------------------------------------------
+// Gets the local space bounding box of the mesh
+// --------------------------------------------------------
+BoundingBox Mesh::GetBounds() {
+	return bounds;
+}
+
+// --------------------------------------------------------
+// Gets the vertices, as they were put in the vertex buffer
+// --------------------------------------------------------
+const std::vector<Vertex>& Mesh::GetVertices() {
+	return vertexData;
+}
+
+// --------------------------------------------------------
+// Gets the indices, as they were put in the index buffer
+// --------------------------------------------------------
+const std::vector<unsigned int>& Mesh::GetIndices() {
+	return indexData;
+}
+
+// --------------------------------------------------------
+// Gets the mesh's triangles in a tree, in local space
+// --------------------------------------------------------
+std::shared_ptr<MeshBvh> Mesh::GetBvh() {
+	return bvh;
+}
+
 // --------------------------------------------------------
 // Draws the Mesh using the vertex and index buffers
 // --------------------------------------------------------
 void Mesh::Draw() {
-	// Draw geometries
-	UINT stride = sizeof(Vertex);
-	UINT offset = 0;
+	Draw(*renderDevice);
+}
 
+void Mesh::Draw(RenderDevice& drawDevice) {
 	// Set buffers in the input assembler (IA) stage
-	context->IASetVertexBuffers(0, 1, vertexBuffer.GetAddressOf(), &stride, &offset);
-	context->IASetIndexBuffer(indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+	//  - The device skips these if this mesh is already bound
+	drawDevice.SetTopology(PrimitiveTopology::TriangleList);
+	drawDevice.SetVertexBuffer(vertexBuffer, sizeof(Vertex));
+	drawDevice.SetIndexBuffer(indexBuffer);
 
-	// Tell Direct3D to draw
-	context->DrawIndexed(numIndices, 0, 0);
+	// Tell the device to draw
+	drawDevice.DrawIndexed(numIndices, 0, 0);
 }
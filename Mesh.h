@@ -1,26 +1,40 @@
 #pragma once
 
-#include <d3d11.h>
-#include <wrl/client.h>
+#include <DirectXCollision.h>
+#include <memory>
+#include <vector>
 
 #include "Vertex.h"
+#include "RenderDevice.h"
+#include "MeshBvh.h"
 
 class Mesh {
 private:
-	//Pointers for vertex buffer and index buffer
-	Microsoft::WRL::ComPtr<ID3D11Buffer> vertexBuffer;
-	Microsoft::WRL::ComPtr<ID3D11Buffer> indexBuffer;
+	//Handles for vertex buffer and index buffer
+	BufferHandle vertexBuffer;
+	BufferHandle indexBuffer;
 
-	//Pointer for draw commands
-	Microsoft::WRL::ComPtr<ID3D11DeviceContext>	context;
+	//Device that owns the buffers, and takes the draw commands
+	std::shared_ptr<RenderDevice> renderDevice;
 
 	//Number of indices in the index buffer
 	int numIndices;
 
+	//Local space bounds of the vertices
+	DirectX::BoundingBox bounds;
 
-	void CreateVertexBuffer(Vertex* vertices, int numVerts, Microsoft::WRL::ComPtr<ID3D11Device> device);
-	void CreateIndexBuffer(unsigned int* indices, int numIndices, Microsoft::WRL::ComPtr<ID3D11Device> device);
+	//CPU copies of the buffers' contents, for the software rasterizer
+	std::vector<Vertex> vertexData;
+	std::vector<unsigned int> indexData;
+
+	//Triangles in a tree, for casting rays against on the CPU
+	std::shared_ptr<MeshBvh> bvh;
+
+	void CreateVertexBuffer(Vertex* vertices, int numVerts);
+	void CreateIndexBuffer(unsigned int* indices, int numIndices);
 	void CalculateTangents(Vertex* vertices, int numVerts, unsigned int* indices, int numIndices);
+	void CalculateBounds(Vertex* vertices, int numVerts);
+	void CreateBvh();
 
 public:
 	//Constructor
@@ -29,20 +43,19 @@ public:
 		int numVerts,
 		unsigned int* indices,
 		int numIndices,
-		Microsoft::WRL::ComPtr<ID3D11Device> device,
-		Microsoft::WRL::ComPtr<ID3D11DeviceContext> context
+		std::shared_ptr<RenderDevice> renderDevice
 	);
 
-	Mesh(const wchar_t* fileToLoad, Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context);
+	Mesh(const wchar_t* fileToLoad, std::shared_ptr<RenderDevice> renderDevice);
 
 	//Destructor
 	~Mesh();
 
 	//Gets the Vertex Buffer
-	Microsoft::WRL::ComPtr<ID3D11Buffer> GetVertexBuffer();
+	BufferHandle GetVertexBuffer();
 
 	//Gets the Index Buffer
-	Microsoft::WRL::ComPtr<ID3D11Buffer> GetIndexBuffer();
+	BufferHandle GetIndexBuffer();
 
 	//Mesh Property Variables
 	DirectX::XMFLOAT4 meshTint;
@@ -51,7 +64,20 @@ public:
 	//Gets the number of indicies in the index buffer
 	int GetIndexCount();
 
+	//Gets the local space bounding box
+	DirectX::BoundingBox GetBounds();
+
+	//Gets the CPU copies of the vertices and indices
+	const std::vector<Vertex>& GetVertices();
+	const std::vector<unsigned int>& GetIndices();
+
+	//Gets the triangle tree, for picking and line of sight
+	std::shared_ptr<MeshBvh> GetBvh();
+
 	//Draws the mesh
 	void Draw();
+
+	//Draws the mesh with another device that shares its resources (like a deferred one)
+	void Draw(RenderDevice& drawDevice);
 };
 
@@ -0,0 +1,229 @@
+#include "MeshBvh.h"
+#include "MeshBvhKernels.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static float SurfaceArea(const SceneBvhBox& box) {
+	float x = box.Max[0] - box.Min[0];
+	float y = box.Max[1] - box.Min[1];
+	float z = box.Max[2] - box.Min[2];
+	return x * y + y * z + z * x;
+}
+
+// --------------------------------------------------------
+// Whether a triangle has no area to hit
+//  - Rounding leaves triangles that should have none, like a
+//     sphere's pole slivers, just enough that their hits land
+//     anywhere near them, so they're kept out of packets
+// --------------------------------------------------------
+static bool IsDegenerate(const float edge1[3], const float edge2[3]) {
+	float cross[3] = {
+		edge1[1] * edge2[2] - edge1[2] * edge2[1],
+		edge1[2] * edge2[0] - edge1[0] * edge2[2],
+		edge1[0] * edge2[1] - edge1[1] * edge2[0],
+	};
+	float crossSquared = cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2];
+	float edge1Squared = edge1[0] * edge1[0] + edge1[1] * edge1[1] + edge1[2] * edge1[2];
+	float edge2Squared = edge2[0] * edge2[0] + edge2[1] * edge2[1] + edge2[2] * edge2[2];
+	return crossSquared <= MESH_BVH_DEGENERATE_SINE * MESH_BVH_DEGENERATE_SINE * edge1Squared * edge2Squared;
+}
+
+// --------------------------------------------------------
+// Splits the triangles with SceneBvh's builder, packs each
+// leaf's triangles into a packet, and then collapses the
+// tree into four children a node
+//  - The builder takes boxes as centers and extents, so each
+//     triangle's box goes in that way
+//  - Each node takes its binary node's two children, then
+//     keeps swapping the biggest child that isn't a leaf for
+//     that child's own two until it has four
+// --------------------------------------------------------
+MeshBvh::MeshBvh(const float* positions, size_t stride, const unsigned int* indices, size_t indexCount) :
+	bounds(SceneBvhBox{ { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } }),
+	rootCount(0),
+	triangleCount(indexCount / 3),
+	depth(0),
+	buildMilliseconds(0.0) {
+
+	Clock::time_point start = Clock::now();
+
+	auto corner = [&](size_t index) {
+		return (const float*)((const char*)positions + indices[index] * stride);
+	};
+
+	BoundsStreams triangleBounds;
+	triangleBounds.Resize(triangleCount);
+	for (size_t t = 0; t < triangleCount; t++) {
+		const float* p0 = corner(t * 3);
+		const float* p1 = corner(t * 3 + 1);
+		const float* p2 = corner(t * 3 + 2);
+
+		float center[3], extents[3];
+		for (int a = 0; a < 3; a++) {
+			float low = (std::min)((std::min)(p0[a], p1[a]), p2[a]);
+			float high = (std::max)((std::max)(p0[a], p1[a]), p2[a]);
+			center[a] = (low + high) * 0.5f;
+			extents[a] = (high - low) * 0.5f;
+		}
+		triangleBounds.Set(t, center, extents);
+	}
+
+	std::vector<SceneBvhNode> binary;
+	std::vector<uint32_t> order;
+	SceneBvh::BuildTree(triangleBounds, MESH_BVH_PACKET_SIZE, binary, order);
+	if (binary.empty()) return;
+	bounds = binary[0].Bounds;
+
+	//Leaves keep their packet in place of their first triangle
+	for (SceneBvhNode& node : binary) {
+		if (node.Count == 0) continue;
+
+		MeshBvhPacket packet = {};
+		for (uint32_t lane = 0; lane < MESH_BVH_PACKET_SIZE; lane++) {
+			if (lane >= node.Count) {
+				packet.Triangles[lane] = UINT32_MAX;
+				continue;
+			}
+
+			uint32_t t = order[node.Index + lane];
+			const float* p0 = corner(t * 3);
+			const float* p1 = corner(t * 3 + 1);
+			const float* p2 = corner(t * 3 + 2);
+			packet.Triangles[lane] = t;
+
+			float edge1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			float edge2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			if (IsDegenerate(edge1, edge2)) continue;
+
+			for (int a = 0; a < 3; a++) {
+				packet.V0[a][lane] = p0[a];
+				packet.Edge1[a][lane] = edge1[a];
+				packet.Edge2[a][lane] = edge2[a];
+			}
+		}
+
+		node.Index = (uint32_t)packets.size();
+		packets.push_back(packet);
+	}
+
+	if (binary[0].Count > 0) {
+		rootCount = binary[0].Count;
+		buildMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		return;
+	}
+
+	struct Pending {
+		uint32_t Binary;
+		uint32_t Node;
+		uint32_t Level;
+	};
+
+	nodes.reserve(binary.size() / 2 + 1);
+	nodes.push_back(MeshBvhNode());
+	std::vector<Pending> open(1, Pending{ 0, 0, 0 });
+
+	while (!open.empty()) {
+		Pending pending = open.back();
+		open.pop_back();
+
+		uint32_t children[MESH_BVH_NODE_WIDTH] = { binary[pending.Binary].Index, binary[pending.Binary].Index + 1 };
+		uint32_t childCount = 2;
+		while (childCount < MESH_BVH_NODE_WIDTH) {
+			int biggest = -1;
+			float biggestArea = -1.0f;
+			for (uint32_t c = 0; c < childCount; c++) {
+				const SceneBvhNode& child = binary[children[c]];
+				if (child.Count == 0 && SurfaceArea(child.Bounds) > biggestArea) {
+					biggest = (int)c;
+					biggestArea = SurfaceArea(child.Bounds);
+				}
+			}
+			if (biggest < 0) break;
+
+			uint32_t opened = binary[children[biggest]].Index;
+			children[biggest] = opened;
+			children[childCount++] = opened + 1;
+		}
+
+		MeshBvhNode node = {};
+		node.ChildCount = childCount;
+		for (uint32_t c = 0; c < childCount; c++) {
+			const SceneBvhNode& child = binary[children[c]];
+			for (int a = 0; a < 3; a++) {
+				node.Min[a][c] = child.Bounds.Min[a];
+				node.Max[a][c] = child.Bounds.Max[a];
+			}
+
+			node.Counts[c] = child.Count;
+			if (child.Count > 0) {
+				node.Children[c] = child.Index;
+				continue;
+			}
+
+			node.Children[c] = (uint32_t)nodes.size();
+			nodes.push_back(MeshBvhNode());
+			open.push_back(Pending{ children[c], node.Children[c], pending.Level + 1 });
+			depth = (std::max)(depth, pending.Level + 1);
+		}
+		nodes[pending.Node] = node;
+	}
+
+	buildMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+bool MeshBvh::Raycast(const SceneBvhRay& ray, MeshBvhHit& hit) const {
+	return Raycast(ray, TransformBatch::GetPath(), hit);
+}
+
+bool MeshBvh::Raycast(const SceneBvhRay& ray, MathPath path, MeshBvhHit& hit) const {
+	//Paths this CPU can't run fall back to scalar
+	if (!TransformBatch::IsPathAvailable(path)) path = MathPath::Scalar;
+
+	switch (path) {
+#ifdef SIMD_LANES_SSE
+	case MathPath::SSE: return RaycastNodes<SSELanes, SSELanes>(nodes, packets, rootCount, depth, ray, hit);
+#endif
+#ifdef SIMD_LANES_X86
+	case MathPath::AVX2: return MeshBvhAVX2::RaycastNodes(nodes, packets, rootCount, depth, ray, hit);
+#endif
+#ifdef SIMD_LANES_NEON
+	case MathPath::NEON: return RaycastNodes<NEONLanes, NEONLanes>(nodes, packets, rootCount, depth, ray, hit);
+#endif
+	default: return RaycastNodes<ScalarLanes, ScalarLanes>(nodes, packets, rootCount, depth, ray, hit);
+	}
+}
+
+bool MeshBvh::RaycastAll(const SceneBvhRay& ray, MeshBvhHit& hit) const {
+	hit.Distance = ray.MaxDistance;
+	bool found = false;
+
+	for (const MeshBvhPacket& packet : packets) {
+		found |= IntersectPacket<ScalarLanes>(packet, MESH_BVH_PACKET_SIZE, ray, hit);
+	}
+
+	return found;
+}
+
+SceneBvhBox MeshBvh::GetBounds() const {
+	return bounds;
+}
+
+size_t MeshBvh::GetTriangleCount() const {
+	return triangleCount;
+}
+
+size_t MeshBvh::GetNodeCount() const {
+	return nodes.size();
+}
+
+size_t MeshBvh::GetPacketCount() const {
+	return packets.size();
+}
+
+double MeshBvh::GetBuildMilliseconds() const {
+	return buildMilliseconds;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "SceneBvh.h"
+#include "TransformBatch.h"
+
+// Triangles in each leaf, tested together as one packet
+#define MESH_BVH_PACKET_SIZE 8
+
+// Children of each node, whose boxes are tested together
+#define MESH_BVH_NODE_WIDTH 4
+
+// How far past a triangle's edges, in barycentric terms, a
+// ray still hits it, so triangles sharing an edge overlap
+// and rounding can't open a crack between them
+#define MESH_BVH_EDGE_TOLERANCE 1e-5f
+
+// Sine of the angle between a triangle's edges below which
+// it counts as having no area
+#define MESH_BVH_DEGENERATE_SINE 1e-5f
+
+// --------------------------------------------------------
+// One node of the tree, with its children's boxes stored
+// one array per component, so they load into SIMD lanes
+//  - Children are nodes, or packets when they have a count
+//  - Only the first ChildCount children are real
+// --------------------------------------------------------
+struct MeshBvhNode {
+	float Min[3][MESH_BVH_NODE_WIDTH];
+	float Max[3][MESH_BVH_NODE_WIDTH];
+	uint32_t Children[MESH_BVH_NODE_WIDTH];
+	uint32_t Counts[MESH_BVH_NODE_WIDTH];	// Triangles in a packet, 0 for nodes
+	uint32_t ChildCount;
+};
+
+// --------------------------------------------------------
+// A leaf's triangles, ready for Moller-Trumbore
+//  - Stored as each triangle's first corner and the edges
+//     out of it, one array per component, so a packet loads
+//     straight into SIMD lanes
+//  - Leaves with fewer triangles are padded with empty ones,
+//     which nothing can hit
+// --------------------------------------------------------
+struct MeshBvhPacket {
+	float V0[3][MESH_BVH_PACKET_SIZE];
+	float Edge1[3][MESH_BVH_PACKET_SIZE];	// V1 - V0
+	float Edge2[3][MESH_BVH_PACKET_SIZE];	// V2 - V0
+	uint32_t Triangles[MESH_BVH_PACKET_SIZE];
+};
+
+struct MeshBvhHit {
+	uint32_t Triangle;	// Its first index is at Triangle * 3
+	float Distance;		// Along the ray, in lengths of its direction
+	float U;			// Barycentric weight of its second corner
+	float V;			// And its third
+};
+
+// --------------------------------------------------------
+// Bounding volume hierarchy over a mesh's triangles, for
+// casting rays against it on the CPU
+//
+// - Built once when the mesh loads, in the mesh's local
+//    space, with the same binned SAH builder as SceneBvh,
+//    then collapsed from two children a node to four
+// - Rays walk it nearest child first and stop opening nodes
+//    beyond the nearest hit so far
+// - A node's four boxes are one SIMD test, and each leaf is
+//    one packet, tested as wide as the current
+//    TransformBatch path goes
+// - Hits count from either side, as picking and line of
+//    sight don't care which way a triangle faces
+// - Doesn't use DirectXMath, so it builds anywhere
+// --------------------------------------------------------
+class MeshBvh {
+private:
+	std::vector<MeshBvhNode> nodes;
+	std::vector<MeshBvhPacket> packets;
+	SceneBvhBox bounds;
+	uint32_t rootCount;	// Triangles when the root is a packet, as small meshes are just one
+	size_t triangleCount;
+	uint32_t depth;		// Levels below the root, for sizing a walk's stack
+	double buildMilliseconds;
+
+public:
+	//Positions are read as three floats every stride bytes,
+	//like the start of each Vertex
+	MeshBvh(const float* positions, size_t stride, const unsigned int* indices, size_t indexCount);
+
+	//Nearest triangle the ray hits within its MaxDistance
+	// - The ray is in the mesh's local space, and its direction
+	//    doesn't have to be unit length
+	bool Raycast(const SceneBvhRay& ray, MeshBvhHit& hit) const;
+	bool Raycast(const SceneBvhRay& ray, MathPath path, MeshBvhHit& hit) const;
+
+	//Same answer from testing every triangle, for checking
+	bool RaycastAll(const SceneBvhRay& ray, MeshBvhHit& hit) const;
+
+	//Box around every triangle, in local space
+	SceneBvhBox GetBounds() const;
+
+	//Stats
+	size_t GetTriangleCount() const;
+	size_t GetNodeCount() const;
+	size_t GetPacketCount() const;
+	double GetBuildMilliseconds() const;
+};
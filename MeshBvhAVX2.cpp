@@ -0,0 +1,20 @@
+#include "MeshBvhKernels.h"
+
+// --------------------------------------------------------
+// MeshBvh's walk with AVX2 packets
+//  - The only MeshBvh file built with AVX2 on (/arch:AVX2,
+//     or -mavx2 -mfma), and only called once the CPU's been
+//     checked
+// --------------------------------------------------------
+#ifdef SIMD_LANES_X86
+
+#ifndef SIMD_LANES_AVX2
+#error MeshBvhAVX2.cpp has to be built with AVX2 on
+#endif
+
+//AVX2 is twice as wide as a node, so boxes stay on SSE
+bool MeshBvhAVX2::RaycastNodes(const std::vector<MeshBvhNode>& nodes, const std::vector<MeshBvhPacket>& packets, uint32_t rootCount, uint32_t depth, const SceneBvhRay& ray, MeshBvhHit& hit) {
+	return ::RaycastNodes<SSELanes, AVX2Lanes>(nodes, packets, rootCount, depth, ray, hit);
+}
+
+#endif
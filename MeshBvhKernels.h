@@ -0,0 +1,206 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "MeshBvh.h"
+#include "SimdLanes.h"
+
+// --------------------------------------------------------
+// MeshBvh's ray kernels, shared by MeshBvh.cpp and
+// MeshBvhAVX2.cpp
+//  - Only MeshBvhAVX2.cpp is built with AVX2 on, so that's
+//     where the AVX2 walk is made
+//  - Everything here is static, so each file keeps its own
+// --------------------------------------------------------
+
+// --------------------------------------------------------
+// Moller-Trumbore against a packet, L::Width triangles at
+// a time, keeping the nearest hit closer than hit.Distance
+//  - The determinant is zero for rays parallel to a
+//     triangle and for the padding, which has no edges, so
+//     those lanes come out as NaN or fail the compares
+//  - Each path rounds differently (AVX2 builds fuse multiply
+//     adds), so a ray right on a shared edge can land just
+//     outside both triangles without the edge tolerance
+//  - Returns whether any lane beat the distance
+// --------------------------------------------------------
+template<typename L>
+static bool IntersectPacket(const MeshBvhPacket& packet, uint32_t count, const SceneBvhRay& ray, MeshBvhHit& hit) {
+	typedef typename L::Type F;
+	typedef typename L::Mask M;
+
+	F dx = L::Set(ray.Direction[0]);
+	F dy = L::Set(ray.Direction[1]);
+	F dz = L::Set(ray.Direction[2]);
+	F zero = L::Set(0.0f);
+	F one = L::Set(1.0f);
+	F low = L::Set(-MESH_BVH_EDGE_TOLERANCE);
+	F high = L::Set(1.0f + MESH_BVH_EDGE_TOLERANCE);
+	bool found = false;
+
+	for (uint32_t first = 0; first < count; first += (uint32_t)L::Width) {
+		F e1x = L::Load(&packet.Edge1[0][first]);
+		F e1y = L::Load(&packet.Edge1[1][first]);
+		F e1z = L::Load(&packet.Edge1[2][first]);
+		F e2x = L::Load(&packet.Edge2[0][first]);
+		F e2y = L::Load(&packet.Edge2[1][first]);
+		F e2z = L::Load(&packet.Edge2[2][first]);
+
+		//p = direction x edge 2, and the determinant is edge 1 . p
+		F px = L::Sub(L::Mul(dy, e2z), L::Mul(dz, e2y));
+		F py = L::Sub(L::Mul(dz, e2x), L::Mul(dx, e2z));
+		F pz = L::Sub(L::Mul(dx, e2y), L::Mul(dy, e2x));
+		F determinant = L::Add(L::Add(L::Mul(e1x, px), L::Mul(e1y, py)), L::Mul(e1z, pz));
+		F inverse = L::Div(one, determinant);
+
+		//From the first corner to the ray's origin
+		F tx = L::Sub(L::Set(ray.Origin[0]), L::Load(&packet.V0[0][first]));
+		F ty = L::Sub(L::Set(ray.Origin[1]), L::Load(&packet.V0[1][first]));
+		F tz = L::Sub(L::Set(ray.Origin[2]), L::Load(&packet.V0[2][first]));
+		F u = L::Mul(L::Add(L::Add(L::Mul(tx, px), L::Mul(ty, py)), L::Mul(tz, pz)), inverse);
+
+		//q = t x edge 1
+		F qx = L::Sub(L::Mul(ty, e1z), L::Mul(tz, e1y));
+		F qy = L::Sub(L::Mul(tz, e1x), L::Mul(tx, e1z));
+		F qz = L::Sub(L::Mul(tx, e1y), L::Mul(ty, e1x));
+		F v = L::Mul(L::Add(L::Add(L::Mul(dx, qx), L::Mul(dy, qy)), L::Mul(dz, qz)), inverse);
+		F distance = L::Mul(L::Add(L::Add(L::Mul(e2x, qx), L::Mul(e2y, qy)), L::Mul(e2z, qz)), inverse);
+
+		M inside = L::And(L::GreaterEqual(u, low), L::GreaterEqual(v, low));
+		inside = L::And(inside, L::LessEqual(L::Add(u, v), high));
+		M ahead = L::And(L::GreaterEqual(distance, zero), L::Less(distance, L::Set(hit.Distance)));
+		int bits = L::MaskBits(L::And(L::And(inside, ahead), L::Greater(L::Abs(determinant), zero)));
+		if (bits == 0) continue;
+
+		float distances[L::Width], us[L::Width], vs[L::Width];
+		L::Store(distances, distance);
+		L::Store(us, u);
+		L::Store(vs, v);
+
+		for (uint32_t lane = 0; lane < L::Width; lane++) {
+			if (!(bits & (1 << lane)) || distances[lane] >= hit.Distance) continue;
+
+			hit.Triangle = packet.Triangles[first + lane];
+			hit.Distance = distances[lane];
+			hit.U = us[lane];
+			hit.V = vs[lane];
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+// --------------------------------------------------------
+// Slab test of a ray against all of a node's children,
+// L::Width at a time
+//  - Gives each child's entry distance, and returns a bit
+//     for each child the ray enters before its MaxDistance
+//  - A ray lying in a slab's plane without moving across it
+//     gets a NaN there, which is kept as the first operand
+//     of each min and max so that slab is ignored, the way
+//     SceneBvh treats it
+// --------------------------------------------------------
+template<typename L>
+static int IntersectChildren(const MeshBvhNode& node, const SceneBvhRay& ray, const float inverseDirection[3], float distances[MESH_BVH_NODE_WIDTH]) {
+	typedef typename L::Type F;
+	int bits = 0;
+
+	for (size_t first = 0; first < MESH_BVH_NODE_WIDTH; first += L::Width) {
+		F enter = L::Set(0.0f);
+		F exit = L::Set(ray.MaxDistance);
+
+		for (int a = 0; a < 3; a++) {
+			F origin = L::Set(ray.Origin[a]);
+			F inverse = L::Set(inverseDirection[a]);
+			F t0 = L::Mul(L::Sub(L::Load(&node.Min[a][first]), origin), inverse);
+			F t1 = L::Mul(L::Sub(L::Load(&node.Max[a][first]), origin), inverse);
+
+			enter = L::Max(L::Min(t0, t1), enter);
+			exit = L::Min(L::Max(t0, t1), exit);
+		}
+
+		bits |= L::MaskBits(L::LessEqual(enter, exit)) << first;
+		L::Store(&distances[first], enter);
+	}
+
+	return bits & ((1 << node.ChildCount) - 1);
+}
+
+// --------------------------------------------------------
+// Walks the tree front to back, like SceneBvh::CastRay(),
+// with the nearest hit so far shortening the ray
+//  - Boxes are tested with N lanes, and triangles with P,
+//     as nodes are only four wide
+//  - Each step pops one entry and pushes at most four, so
+//     the stack never holds more than three per level plus
+//     four, and only unusually deep trees need the heap
+// --------------------------------------------------------
+template<typename N, typename P>
+static bool RaycastNodes(const std::vector<MeshBvhNode>& nodes, const std::vector<MeshBvhPacket>& packets, uint32_t rootCount, uint32_t depth, const SceneBvhRay& ray, MeshBvhHit& hit) {
+	hit.Distance = ray.MaxDistance;
+	if (rootCount > 0) return IntersectPacket<P>(packets[0], rootCount, ray, hit);
+	if (nodes.empty()) return false;
+
+	float inverseDirection[3] = { 1.0f / ray.Direction[0], 1.0f / ray.Direction[1], 1.0f / ray.Direction[2] };
+	SceneBvhRay clipped = ray;
+	bool found = false;
+
+	struct Entry {
+		uint32_t Index;
+		uint32_t Count;	// Triangles for a packet, 0 for a node
+		float Distance;
+	};
+	Entry localOpen[64];
+	std::vector<Entry> heapOpen;
+	Entry* open = localOpen;
+	if (depth * 3 + 4 > 64) {
+		heapOpen.resize(depth * 3 + 4);
+		open = &heapOpen[0];
+	}
+
+	size_t openCount = 0;
+	open[openCount++] = Entry{ 0, 0, 0.0f };
+
+	while (openCount > 0) {
+		Entry entry = open[--openCount];
+		if (entry.Distance > clipped.MaxDistance) continue;
+
+		if (entry.Count > 0) {
+			if (IntersectPacket<P>(packets[entry.Index], entry.Count, clipped, hit)) {
+				clipped.MaxDistance = hit.Distance;
+				found = true;
+			}
+			continue;
+		}
+
+		const MeshBvhNode& node = nodes[entry.Index];
+		float distances[MESH_BVH_NODE_WIDTH];
+		int bits = IntersectChildren<N>(node, clipped, inverseDirection, distances);
+
+		//Farthest first, so the nearest comes off the stack next
+		size_t first = openCount;
+		for (uint32_t c = 0; c < MESH_BVH_NODE_WIDTH; c++) {
+			if (!(bits & (1 << c))) continue;
+
+			Entry child = Entry{ node.Children[c], node.Counts[c], distances[c] };
+			size_t slot = openCount++;
+			for (; slot > first && open[slot - 1].Distance < child.Distance; slot--) open[slot] = open[slot - 1];
+			open[slot] = child;
+		}
+	}
+
+	return found;
+}
+
+#ifdef SIMD_LANES_X86
+// --------------------------------------------------------
+// The walk with AVX2 packets, from MeshBvhAVX2.cpp
+//  - Only call it once TransformBatch says the CPU runs AVX2
+// --------------------------------------------------------
+namespace MeshBvhAVX2 {
+	bool RaycastNodes(const std::vector<MeshBvhNode>& nodes, const std::vector<MeshBvhPacket>& packets, uint32_t rootCount, uint32_t depth, const SceneBvhRay& ray, MeshBvhHit& hit);
+}
+#endif
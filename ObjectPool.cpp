@@ -0,0 +1,88 @@
+#include "ObjectPool.h"
+
+// Blocks are aligned for anything DirectXMath might store
+#define OBJECT_POOL_ALIGNMENT 16
+
+FixedBlockPool::FixedBlockPool(MemoryTag tag, size_t blockSize, size_t blocksPerChunk) :
+	blockSize(0),
+	blocksPerChunk(blocksPerChunk ? blocksPerChunk : 1),
+	tag(tag),
+	freeList(0),
+	liveBlocks(0) {
+	if (blockSize) Fits(blockSize);
+}
+
+// --------------------------------------------------------
+// Frees the chunks, unless something is still using them
+//  - Pools are usually statics, so anything still alive at
+//    exit is leaked rather than left pointing at freed memory
+// --------------------------------------------------------
+FixedBlockPool::~FixedBlockPool() {
+	if (liveBlocks > 0) return;
+
+	for (uint8_t* chunk : chunks) {
+		MemoryTracker::Free(chunk);
+	}
+}
+
+bool FixedBlockPool::Fits(size_t size) {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (blockSize == 0) {
+		//Big enough for the free list's pointer, and aligned
+		size = size < sizeof(void*) ? sizeof(void*) : size;
+		blockSize = (size + OBJECT_POOL_ALIGNMENT - 1) & ~(size_t)(OBJECT_POOL_ALIGNMENT - 1);
+	}
+
+	return size <= blockSize;
+}
+
+// --------------------------------------------------------
+// Adds a chunk's blocks to the free list
+//  - Called with the lock held
+// --------------------------------------------------------
+void FixedBlockPool::AddChunk() {
+	MEMORY_TAG_SCOPE(tag);
+
+	uint8_t* chunk = (uint8_t*)MemoryTracker::Allocate(blockSize * blocksPerChunk);
+	chunks.push_back(chunk);
+
+	//Link them so the first block is handed out first
+	for (size_t i = blocksPerChunk; i > 0; i--) {
+		void* block = chunk + (i - 1) * blockSize;
+		*(void**)block = freeList;
+		freeList = block;
+	}
+}
+
+void* FixedBlockPool::Allocate() {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (!freeList) AddChunk();
+
+	void* block = freeList;
+	freeList = *(void**)block;
+	liveBlocks++;
+	return block;
+}
+
+void FixedBlockPool::Free(void* block) {
+	if (!block) return;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	*(void**)block = freeList;
+	freeList = block;
+	liveBlocks--;
+}
+
+size_t FixedBlockPool::GetBlockSize() {
+	return blockSize;
+}
+
+size_t FixedBlockPool::GetLiveCount() {
+	return liveBlocks;
+}
+
+size_t FixedBlockPool::GetCapacity() {
+	return chunks.size() * blocksPerChunk;
+}
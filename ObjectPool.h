@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "MemoryTracker.h"
+
+// Blocks in each chunk a pool allocates when it runs out
+#define OBJECT_POOL_CHUNK_SIZE 64
+
+// --------------------------------------------------------
+// Hands out fixed size blocks from chunks, with a free list
+//
+// - Freed blocks are reused before a new chunk is made, so
+//    creating and destroying objects at a steady rate never
+//    touches the heap
+// - A block size of 0 takes the size of the first request,
+//    which lets pools serve types whose size isn't known
+//    up front (like shared_ptr's control blocks)
+// - Thread safe
+// --------------------------------------------------------
+class FixedBlockPool {
+private:
+	size_t blockSize;
+	size_t blocksPerChunk;
+	MemoryTag tag;
+
+	std::mutex mutex;
+	std::vector<uint8_t*> chunks;
+	void* freeList;
+	size_t liveBlocks;
+
+	void AddChunk();
+
+public:
+	FixedBlockPool(MemoryTag tag, size_t blockSize = 0, size_t blocksPerChunk = OBJECT_POOL_CHUNK_SIZE);
+	~FixedBlockPool();
+
+	//Whether a request of this size can come from the pool
+	// - The first size asked about sets the block size
+	bool Fits(size_t size);
+
+	void* Allocate();
+	void Free(void* block);
+
+	size_t GetBlockSize();
+	size_t GetLiveCount();
+	size_t GetCapacity();
+};
+
+// --------------------------------------------------------
+// Standard library allocator on top of a block pool
+//  - Single objects come from the pool, anything else
+//    (arrays, or types too big for a block) from the heap
+// --------------------------------------------------------
+template<typename T>
+struct PoolAllocator {
+	typedef T value_type;
+
+	FixedBlockPool* Pool;
+
+	PoolAllocator(FixedBlockPool* pool) : Pool(pool) {}
+
+	template<typename U>
+	PoolAllocator(const PoolAllocator<U>& other) : Pool(other.Pool) {}
+
+	T* allocate(size_t count) {
+		if (count == 1 && Pool->Fits(sizeof(T))) return (T*)Pool->Allocate();
+		return (T*)::operator new(sizeof(T) * count);
+	}
+
+	void deallocate(T* memory, size_t count) {
+		if (count == 1 && Pool->Fits(sizeof(T))) Pool->Free(memory);
+		else ::operator delete(memory);
+	}
+};
+
+template<typename T, typename U>
+bool operator==(const PoolAllocator<T>& a, const PoolAllocator<U>& b) { return a.Pool == b.Pool; }
+
+template<typename T, typename U>
+bool operator!=(const PoolAllocator<T>& a, const PoolAllocator<U>& b) { return a.Pool != b.Pool; }
+
+// --------------------------------------------------------
+// Pool of shared objects of one type
+//  - Create() is make_shared, except the object and its
+//    control block live in one pooled block
+//  - The pool has to outlive everything it creates
+// --------------------------------------------------------
+template<typename T>
+class ObjectPool {
+private:
+	FixedBlockPool blocks;
+
+public:
+	ObjectPool(MemoryTag tag, size_t blocksPerChunk = OBJECT_POOL_CHUNK_SIZE) :
+		blocks(tag, 0, blocksPerChunk) {
+	}
+
+	template<typename... Args>
+	std::shared_ptr<T> Create(Args&&... args) {
+		return std::allocate_shared<T>(PoolAllocator<T>(&blocks), std::forward<Args>(args)...);
+	}
+
+	size_t GetLiveCount() { return blocks.GetLiveCount(); }
+	size_t GetCapacity() { return blocks.GetCapacity(); }
+	size_t GetBlockSize() { return blocks.GetBlockSize(); }
+};
@@ -0,0 +1,290 @@
+#include "ParallelDrawSubmitter.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+ParallelDrawSubmitter::ParallelDrawSubmitter(
+	Microsoft::WRL::ComPtr<ID3D11Device> device,
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context,
+	std::shared_ptr<D3D11RenderDevice> renderDevice) :
+	device(device),
+	context(context),
+	items(0),
+	frame(),
+	frameNumber(0),
+	recordMilliseconds(0.0f),
+	executeMilliseconds(0.0f),
+	driverCommandLists(false) {
+
+	//Without driver support the runtime emulates command lists,
+	//which still works, just with less to gain
+	D3D11_FEATURE_DATA_THREADING threading = {};
+	if (SUCCEEDED(device->CheckFeatureSupport(D3D11_FEATURE_THREADING, &threading, sizeof(threading)))) {
+		driverCommandLists = threading.DriverCommandLists != FALSE;
+	}
+
+	//One deferred context for each thread that can record at once
+	drawContexts.resize(JobSystem::GetInstance().GetThreadCount());
+	for (DrawContext& drawContext : drawContexts) {
+		device->CreateDeferredContext(0, drawContext.Context.GetAddressOf());
+		drawContext.Device = renderDevice->CreateDeferred(drawContext.Context);
+	}
+}
+
+ParallelDrawSubmitter::~ParallelDrawSubmitter() {
+}
+
+void ParallelDrawSubmitter::SetFrameShaderResource(const std::string& name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv) {
+	for (auto& frameSRV : frameSRVs) {
+		if (frameSRV.first == name) {
+			frameSRV.second = srv;
+			return;
+		}
+	}
+
+	frameSRVs.push_back({ name, srv });
+}
+
+// --------------------------------------------------------
+// Drops every context's staged constant buffers
+//  - Staging copies each buffer's size from the shader, so
+//     it's redone once a shader has been reloaded
+// --------------------------------------------------------
+void ParallelDrawSubmitter::InvalidateShaders() {
+	for (DrawContext& drawContext : drawContexts) {
+		drawContext.Shaders.clear();
+	}
+}
+
+// --------------------------------------------------------
+// Records every range, then plays the command lists back
+// on the immediate context in range order
+// --------------------------------------------------------
+void ParallelDrawSubmitter::Submit(const std::vector<DrawItem>& items, const DrawFrame& frame) {
+	auto recordStart = std::chrono::high_resolution_clock::now();
+
+	this->items = &items;
+	this->frame = frame;
+	frameNumber++;
+
+	DrawPartition::Split(items.size(), (unsigned int)drawContexts.size(), ranges);
+	for (size_t i = 0; i < ranges.size(); i++) {
+		drawContexts[i].Range = ranges[i];
+	}
+
+	//One job per range, each with its own context
+	JobSystem::GetInstance().ParallelFor(ranges.size(), 1, [this](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			RecordRange(drawContexts[i]);
+		}
+	});
+
+	auto executeStart = std::chrono::high_resolution_clock::now();
+
+	//Don't restore the immediate context's state after each list,
+	//as everything it needs is bound again below
+	for (size_t i = 0; i < ranges.size(); i++) {
+		context->ExecuteCommandList(drawContexts[i].CommandList.Get(), FALSE);
+		drawContexts[i].CommandList.Reset();
+	}
+
+	context->OMSetRenderTargets(1, &frame.RenderTarget, frame.DepthStencil);
+	context->RSSetViewports(1, &frame.Viewport);
+	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+	auto executeEnd = std::chrono::high_resolution_clock::now();
+	recordMilliseconds = std::chrono::duration<float, std::milli>(executeStart - recordStart).count();
+	executeMilliseconds = std::chrono::duration<float, std::milli>(executeEnd - executeStart).count();
+
+	this->items = 0;
+}
+
+// --------------------------------------------------------
+// Records one range of draws into its deferred context
+//  - Deferred contexts start each command list with the
+//    default state, so everything is bound from scratch
+// --------------------------------------------------------
+void ParallelDrawSubmitter::RecordRange(DrawContext& drawContext) {
+	PROFILE_SCOPE("Record Draws");
+
+	ID3D11DeviceContext* deferred = drawContext.Context.Get();
+	drawContext.Device->InvalidateState();
+
+	deferred->OMSetRenderTargets(1, &frame.RenderTarget, frame.DepthStencil);
+	deferred->RSSetViewports(1, &frame.Viewport);
+
+	SimpleVertexShader* currentVS = 0;
+	SimplePixelShader* currentPS = 0;
+	Material* currentMaterial = 0;
+
+	for (size_t i = drawContext.Range.Begin; i < drawContext.Range.End; i++) {
+		const DrawItem& item = (*items)[i];
+		SimpleVertexShader* vs = item.DrawMaterial->GetVertexShader().get();
+		SimplePixelShader* ps = item.DrawMaterial->GetPixelShader().get();
+
+		//Only bind what changed since the last draw
+		if (vs != currentVS) {
+			deferred->IASetInputLayout(vs->GetInputLayout().Get());
+			deferred->VSSetShader(vs->GetDirectXShader().Get(), 0, 0);
+			currentVS = vs;
+		}
+
+		if (ps != currentPS) {
+			deferred->PSSetShader(ps->GetDirectXShader().Get(), 0, 0);
+
+			for (auto& frameSRV : frameSRVs) {
+				const SimpleSRV* srvInfo = ps->GetShaderResourceViewInfo(frameSRV.first.c_str());
+				if (srvInfo) {
+					deferred->PSSetShaderResources(srvInfo->BindIndex, 1, frameSRV.second.GetAddressOf());
+				}
+			}
+
+			currentPS = ps;
+			currentMaterial = 0;
+		}
+
+		if (item.DrawMaterial != currentMaterial) {
+			MaterialTemplate::Bind(*item.Bindings, deferred);
+			currentMaterial = item.DrawMaterial;
+		}
+
+		//Same values Entity::Draw() sets, written into this context's copy
+		StagedShader& stagedVS = StageShader(drawContext, vs);
+		StageData(stagedVS, vs, "world", &item.World, sizeof(DirectX::XMFLOAT4X4));
+		StageData(stagedVS, vs, "view", &frame.View, sizeof(DirectX::XMFLOAT4X4));
+		StageData(stagedVS, vs, "projection", &frame.Projection, sizeof(DirectX::XMFLOAT4X4));
+		StageData(stagedVS, vs, "worldInvTranspose", &item.WorldInvTranspose, sizeof(DirectX::XMFLOAT4X4));
+
+		int lightOffset = (int)item.Lights.Offset;
+		int lightCount = (int)item.Lights.Count;
+
+		StagedShader& stagedPS = StageShader(drawContext, ps);
+		StageParameters(stagedPS, *item.Bindings);
+		StageData(stagedPS, ps, "time", &frame.TotalTime, sizeof(float));
+		StageData(stagedPS, ps, "cameraPosition", &frame.CameraPosition, sizeof(DirectX::XMFLOAT3));
+		StageData(stagedPS, ps, "entityLightOffset", &lightOffset, sizeof(int));
+		StageData(stagedPS, ps, "entityLightCount", &lightCount, sizeof(int));
+
+		UploadStaged(deferred, stagedVS);
+		for (StagedBuffer& buffer : stagedVS.Buffers) {
+			deferred->VSSetConstantBuffers(buffer.BindIndex, 1, buffer.Buffer.GetAddressOf());
+		}
+
+		UploadStaged(deferred, stagedPS);
+		for (StagedBuffer& buffer : stagedPS.Buffers) {
+			deferred->PSSetConstantBuffers(buffer.BindIndex, 1, buffer.Buffer.GetAddressOf());
+		}
+
+		item.DrawMesh->Draw(*drawContext.Device);
+	}
+
+	deferred->FinishCommandList(FALSE, drawContext.CommandList.ReleaseAndGetAddressOf());
+}
+
+// --------------------------------------------------------
+// Gets a context's staged copy of a shader's constant
+// buffers, copying the shader's values on first use each
+// frame so per frame values carry over
+// --------------------------------------------------------
+ParallelDrawSubmitter::StagedShader& ParallelDrawSubmitter::StageShader(DrawContext& drawContext, ISimpleShader* shader) {
+	StagedShader& staged = drawContext.Shaders[shader];
+
+	//Create this context's own GPU buffers the first time
+	if (staged.Buffers.empty()) {
+		for (unsigned int i = 0; i < shader->GetBufferCount(); i++) {
+			const SimpleConstantBuffer* info = shader->GetBufferInfo(i);
+
+			StagedBuffer buffer = {};
+			buffer.BindIndex = info->BindIndex;
+			buffer.Data.resize(info->Size);
+
+			D3D11_BUFFER_DESC desc = {};
+			desc.ByteWidth = info->Size;
+			desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+			desc.Usage = D3D11_USAGE_DYNAMIC;
+			desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+			device->CreateBuffer(&desc, 0, buffer.Buffer.GetAddressOf());
+
+			staged.Buffers.push_back(buffer);
+		}
+
+		staged.Frame = 0;
+	}
+
+	if (staged.Frame != frameNumber) {
+		for (unsigned int i = 0; i < staged.Buffers.size(); i++) {
+			memcpy(staged.Buffers[i].Data.data(), shader->GetBufferInfo(i)->LocalDataBuffer, staged.Buffers[i].Data.size());
+		}
+
+		staged.Frame = frameNumber;
+	}
+
+	return staged;
+}
+
+// --------------------------------------------------------
+// Writes a named variable into a staged copy
+//  - Variables the shader doesn't have are skipped, the
+//    same as SimpleShader's setters
+// --------------------------------------------------------
+void ParallelDrawSubmitter::StageData(StagedShader& staged, ISimpleShader* shader, const char* name, const void* data, unsigned int size) {
+	const SimpleShaderVariable* variable = shader->GetVariableInfo(name);
+	if (!variable || size > variable->Size) {
+		return;
+	}
+
+	memcpy(staged.Buffers[variable->ConstantBufferIndex].Data.data() + variable->ByteOffset, data, size);
+}
+
+// --------------------------------------------------------
+// Writes a material's parameter block into a staged copy
+//  - The staged buffers are in the shader's order, so the
+//    runs' buffer indices line up with them
+// --------------------------------------------------------
+void ParallelDrawSubmitter::StageParameters(StagedShader& staged, const MaterialBindings& bindings) {
+	for (const MaterialParameterRun& run : bindings.ParameterRuns) {
+		if (run.Buffer >= staged.Buffers.size()) continue;
+
+		std::vector<unsigned char>& data = staged.Buffers[run.Buffer].Data;
+		if (run.ByteOffset + run.Size > data.size()) continue;
+
+		memcpy(data.data() + run.ByteOffset, bindings.ParameterBlock.data() + run.BlockOffset, run.Size);
+	}
+}
+
+// --------------------------------------------------------
+// Copies a staged shader into its GPU buffers
+//  - Deferred contexts can only map with WRITE_DISCARD
+// --------------------------------------------------------
+void ParallelDrawSubmitter::UploadStaged(ID3D11DeviceContext* deferred, StagedShader& staged) {
+	for (StagedBuffer& buffer : staged.Buffers) {
+		D3D11_MAPPED_SUBRESOURCE mapped = {};
+		if (SUCCEEDED(deferred->Map(buffer.Buffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+			memcpy(mapped.pData, buffer.Data.data(), buffer.Data.size());
+			deferred->Unmap(buffer.Buffer.Get(), 0);
+		}
+	}
+}
+
+float ParallelDrawSubmitter::GetRecordMilliseconds() {
+	return recordMilliseconds;
+}
+
+float ParallelDrawSubmitter::GetExecuteMilliseconds() {
+	return executeMilliseconds;
+}
+
+unsigned int ParallelDrawSubmitter::GetCommandListCount() {
+	return (unsigned int)ranges.size();
+}
+
+unsigned int ParallelDrawSubmitter::GetThreadCount() {
+	return (unsigned int)drawContexts.size();
+}
+
+bool ParallelDrawSubmitter::HasDriverCommandLists() {
+	return driverCommandLists;
+}
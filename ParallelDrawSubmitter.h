@@ -0,0 +1,134 @@
+#pragma once
+
+#include <d3d11.h>
+#include <DirectXMath.h>
+#include <wrl/client.h> // Used for ComPtr - a smart pointer for COM objects
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Material.h"
+#include "Mesh.h"
+#include "LightClusterGrid.h"
+#include "D3D11RenderDevice.h"
+#include "DrawPartition.h"
+
+// --------------------------------------------------------
+// Everything needed to draw one entity, gathered on the
+// main thread so workers never touch the entity itself
+// --------------------------------------------------------
+struct DrawItem {
+	DirectX::XMFLOAT4X4 World;
+	DirectX::XMFLOAT4X4 WorldInvTranspose;
+	Material* DrawMaterial;
+	const MaterialBindings* Bindings; // Compiled up front, from DrawMaterial
+	Mesh* DrawMesh;
+	ClusterRange Lights;
+};
+
+// --------------------------------------------------------
+// Values shared by every draw in a frame
+// --------------------------------------------------------
+struct DrawFrame {
+	DirectX::XMFLOAT4X4 View;
+	DirectX::XMFLOAT4X4 Projection;
+	DirectX::XMFLOAT3 CameraPosition;
+	float TotalTime;
+	ID3D11RenderTargetView* RenderTarget;
+	ID3D11DepthStencilView* DepthStencil;
+	D3D11_VIEWPORT Viewport;
+};
+
+// --------------------------------------------------------
+// Records entity draws on several threads at once
+//
+// - The draw list is split into contiguous ranges, and each
+//    range is recorded into its own deferred context by its
+//    own job, so executing the command lists in range order
+//    keeps the original draw order
+// - SimpleShader keeps one copy of each constant buffer, so
+//    every context stages its own copy (and its own GPU
+//    buffers), starting from the shader's values each frame
+// - Per frame shader values must be set on the shaders
+//    before Submit(), and aren't changed by it
+// --------------------------------------------------------
+class ParallelDrawSubmitter {
+private:
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+
+	//One constant buffer's staged copy
+	struct StagedBuffer {
+		unsigned int BindIndex;
+		std::vector<unsigned char> Data;
+		Microsoft::WRL::ComPtr<ID3D11Buffer> Buffer;
+	};
+
+	//A context's copy of every constant buffer in one shader
+	struct StagedShader {
+		std::vector<StagedBuffer> Buffers;
+		unsigned int Frame; // Frame the data was last copied from the shader
+	};
+
+	//What one deferred context needs, only ever touched by
+	//whichever thread is recording its range
+	struct DrawContext {
+		Microsoft::WRL::ComPtr<ID3D11DeviceContext> Context;
+		std::shared_ptr<D3D11RenderDevice> Device; // Records meshes into Context
+		Microsoft::WRL::ComPtr<ID3D11CommandList> CommandList;
+		std::unordered_map<ISimpleShader*, StagedShader> Shaders;
+		DrawRange Range;
+	};
+
+	std::vector<DrawContext> drawContexts;
+	std::vector<DrawRange> ranges; // Refilled each frame, so it stops allocating
+
+	//This frame's work
+	const std::vector<DrawItem>* items;
+	DrawFrame frame;
+	unsigned int frameNumber;
+	std::vector<std::pair<std::string, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>>> frameSRVs;
+
+	//Stats
+	float recordMilliseconds;
+	float executeMilliseconds;
+	bool driverCommandLists;
+
+	void RecordRange(DrawContext& drawContext);
+
+	StagedShader& StageShader(DrawContext& drawContext, ISimpleShader* shader);
+	static void StageData(StagedShader& staged, ISimpleShader* shader, const char* name, const void* data, unsigned int size);
+	static void StageParameters(StagedShader& staged, const MaterialBindings& bindings);
+	static void UploadStaged(ID3D11DeviceContext* deferred, StagedShader& staged);
+
+public:
+	//Creates a deferred context for each job system thread, along
+	//with a render device sharing renderDevice's resources
+	ParallelDrawSubmitter(
+		Microsoft::WRL::ComPtr<ID3D11Device> device,
+		Microsoft::WRL::ComPtr<ID3D11DeviceContext> context,
+		std::shared_ptr<D3D11RenderDevice> renderDevice);
+	~ParallelDrawSubmitter();
+
+	//Binds an SRV by name in every pixel shader for the next Submit()
+	void SetFrameShaderResource(const std::string& name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
+
+	//Forgets what was staged for each shader, after shaders reload
+	// - Only between Submit() calls
+	void InvalidateShaders();
+
+	//Records the draws in parallel, then executes them in order
+	// - Leaves the frame's render target, viewport and triangle
+	//    list topology bound on the immediate context, but clears
+	//    the rest, so render devices using it must be invalidated
+	void Submit(const std::vector<DrawItem>& items, const DrawFrame& frame);
+
+	//Stats
+	float GetRecordMilliseconds();
+	float GetExecuteMilliseconds();
+	unsigned int GetCommandListCount();
+	unsigned int GetThreadCount();
+	bool HasDriverCommandLists();
+};
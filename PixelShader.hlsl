@@ -1,5 +1,29 @@
 #include "ShaderIncludes.hlsli"
 
+//Permutation keywords, compiled into variants by -buildshaders
+// - Left undefined, as in the project's own build, every
+//    feature is on so this is the full shader
+//@keyword NORMAL_MAP exact 0 1 binds NormalMap
+//@keyword PBR exact 0 1 binds RoughnessMap MetalnessMap
+//@keyword SHADOWS exact 0 1
+//@keyword SPOT_LIGHTS ordered 0 1
+//@keyword MAX_LOCAL_LIGHTS ordered 0 16 256
+#ifndef NORMAL_MAP
+#define NORMAL_MAP 1
+#endif
+#ifndef PBR
+#define PBR 1
+#endif
+#ifndef SHADOWS
+#define SHADOWS 1
+#endif
+#ifndef SPOT_LIGHTS
+#define SPOT_LIGHTS 1
+#endif
+#ifndef MAX_LOCAL_LIGHTS
+#define MAX_LOCAL_LIGHTS 0xFFFFFFFF
+#endif
+
 //Define Constant Buffer
 cbuffer ExternalData : register(b0) {
 	float4 colorTint;
@@ -7,7 +31,17 @@ cbuffer ExternalData : register(b0) {
 	float3 cameraPosition;
 	float3 ambient;
 
-	Light lights[5];
+	//Clustered lighting
+	// - Directional lights are at the front of the light buffer
+	// - Everything after them is looked up through the pixel's cluster
+	int directionalLightCount;
+	float2 clusterScreenScale;
+	float clusterDepthScale;
+	float clusterDepthBias;
+
+	//Lights culled against this entity's bounds, stored in LightIndices
+	int entityLightOffset;
+	int entityLightCount;
 }
 
 Texture2D Albedo : register(t0); // "t" registers for textures
@@ -18,6 +52,23 @@ Texture2D ShadowMap : register(t4);
 SamplerState BasicSampler : register(s0); // "s" registers for samplers
 SamplerComparisonState ShadowSampler : register(s1);
 
+StructuredBuffer<Light> Lights : register(t5);
+StructuredBuffer<uint2> ClusterRanges : register(t6); // Offset and count into LightIndices
+StructuredBuffer<uint> LightIndices : register(t7);
+
+// --------------------------------------------------------
+// Finds the cluster a pixel falls in
+//  - SV_POSITION.w is the pixel's view space depth
+// --------------------------------------------------------
+uint GetClusterIndex(float4 screenPosition) {
+	uint3 cluster;
+	cluster.xy = (uint2)(screenPosition.xy * clusterScreenScale);
+	cluster.z = (uint)max(log(screenPosition.w) * clusterDepthScale + clusterDepthBias, 0.0f);
+	cluster = min(cluster, uint3(CLUSTER_COUNT_X - 1, CLUSTER_COUNT_Y - 1, CLUSTER_COUNT_Z - 1));
+
+	return cluster.x + CLUSTER_COUNT_X * (cluster.y + CLUSTER_COUNT_Y * cluster.z);
+}
+
 // --------------------------------------------------------
 // The entry point (main method) for our pixel shader
 // 
@@ -31,6 +82,7 @@ float4 main(VertexToPixel input) : SV_TARGET
 {
 	float3 finalLight;
 
+#if SHADOWS
 	// Perform the perspective divide (divide by W) ourselves
 	input.shadowMapPos /= input.shadowMapPos.w;
 
@@ -46,11 +98,15 @@ float4 main(VertexToPixel input) : SV_TARGET
 		ShadowSampler,
 		shadowUV,
 		distToLight).r;
+#else
+	float shadowAmount = 1.0f;
+#endif
 
 	//Normalize the incoming normal
 	input.normal = normalize(input.normal);
 	//input.normal = normalize(input.tangent);
 
+#if NORMAL_MAP
 	//Handle normal mapping
 	float3 unpackedNormal = normalize(NormalMap.Sample(BasicSampler, input.uv).rgb * 2 - 1);
 	//input.normal = normalFromMap;
@@ -65,10 +121,17 @@ float4 main(VertexToPixel input) : SV_TARGET
 
 	//Multiply the normal map vector by the TBN
 	input.normal = mul(unpackedNormal, TBN);
+#endif
 
+#if PBR
 	//float specular = SurfaceTextureSpecular.Sample(BasicSampler, input.uv).r;
-	float roughness = RoughnessMap.Sample(BasicSampler, input.uv).r;
+	float surfaceRoughness = RoughnessMap.Sample(BasicSampler, input.uv).r;
 	float metalness = MetalnessMap.Sample(BasicSampler, input.uv).r;
+#else
+	//Without maps the material's own roughness is all there is
+	float surfaceRoughness = roughness;
+	float metalness = 0.0f;
+#endif
 
 	//Un-correct surface texture sample to adjust for gamma correction
 	float3 albedo = pow(Albedo.Sample(BasicSampler, input.uv).rgb, 2.2f);
@@ -82,36 +145,55 @@ float4 main(VertexToPixel input) : SV_TARGET
 	//Ensure ambient is 0 because it conflicts with PBR
 	/*ambient = float3(0, 0, 0);*/
 
-	float3 lightResult;
-	for (int i = 0; i < 5; i++) {
-		switch (lights[i].Type) {
-			case 0:
-				//float3 CalculateDirectionalLight(Light incomingLight, float3 normal, float4 surfaceColor, float3 cameraPos, float3 worldPos, float roughness, float metalness, float3 specularColor) {
-				lightResult += CalculateDirectionalLight(lights[i], input.normal, colorTint, cameraPosition, input.worldPosition, roughness, metalness, specularColor);
+	finalLight = float3(0, 0, 0);
 
-				// If this is the first light, apply the shadowing result
-				if (i == 0) {
-					lightResult *= shadowAmount;
-				}
+	//Directional lights reach every pixel
+	for (int i = 0; i < directionalLightCount; i++) {
+#if PBR
+		float3 lightResult = CalculateDirectionalLight(Lights[i], input.normal, colorTint, cameraPosition, input.worldPosition, surfaceRoughness, metalness, specularColor);
+#else
+		float3 lightResult = CalculateDirectionalLightPhong(Lights[i], input.normal, colorTint, cameraPosition, input.worldPosition, surfaceRoughness);
+#endif
 
-				break;
+		// If this is the first light, apply the shadowing result
+		if (i == 0) {
+			lightResult *= shadowAmount;
+		}
 
-			case 1:
-				lightResult += CalculatePointLight(lights[i], input.normal, colorTint, ambient, cameraPosition, input.worldPosition, roughness, specularColor);
+		finalLight += lightResult;
+	}
+
+#if MAX_LOCAL_LIGHTS > 0
+	//Everything else only loops over the lights in this pixel's cluster,
+	//or the entity's own list when that is shorter
+	uint2 lightRange = ClusterRanges[GetClusterIndex(input.screenPosition)];
+	if ((uint)entityLightCount < lightRange.y) {
+		lightRange = uint2(entityLightOffset, entityLightCount);
+	}
+
+	uint localLightCount = min(lightRange.y, (uint)MAX_LOCAL_LIGHTS);
+	for (uint j = 0; j < localLightCount; j++) {
+		Light light = Lights[LightIndices[lightRange.x + j]];
+
+#if SPOT_LIGHTS
+		switch (light.Type) {
+			case LIGHT_TYPE_POINT:
+				finalLight += CalculatePointLight(light, input.normal, colorTint, ambient, cameraPosition, input.worldPosition, surfaceRoughness, specularColor);
 				break;
 
-			case 2:
-				lightResult += float3(0, 0, 0);
+			case LIGHT_TYPE_SPOT:
+				finalLight += CalculateSpotLight(light, input.normal, colorTint, ambient, cameraPosition, input.worldPosition, surfaceRoughness, specularColor);
 				break;
 
 			default:
-				lightResult += float3(0, 0, 0);
 				break;
 		}
-
-		// Add this light's result to the total light for this pixel
-		finalLight += lightResult;
+#else
+		//Only built for scenes where every local light is a point light
+		finalLight += CalculatePointLight(light, input.normal, colorTint, ambient, cameraPosition, input.worldPosition, surfaceRoughness, specularColor);
+#endif
 	}
+#endif
 
 	finalLight *= albedo;
 
@@ -0,0 +1,58 @@
+// Must match MAX_BLUR_RADIUS in BlurKernel.h
+#define MAX_BLUR_RADIUS 10
+#define GROUP_SIZE 256
+
+cbuffer externalData : register(b0) {
+	int blurRadius;
+	int horizontal;		// 1 to blur along rows, 0 along columns
+	int2 textureSize;
+
+	// x = weight of the pixel at that distance from the center
+	float4 weights[MAX_BLUR_RADIUS + 1];
+}
+
+Texture2D<float4> Pixels : register(t0);
+RWTexture2D<unorm float4> Output : register(u0);
+
+// One line segment of pixels plus the apron on either side
+groupshared float4 tile[GROUP_SIZE + 2 * MAX_BLUR_RADIUS];
+
+// --------------------------------------------------------
+// One direction of a separable blur
+//
+// - Each group handles GROUP_SIZE pixels of a single row
+//    (or column), so dispatch ceil(length / GROUP_SIZE)
+//    groups in X and one group per line in Y
+// - Every texel is fetched once into groupshared memory
+//    and then shared by all the threads that need it
+// --------------------------------------------------------
+[numthreads(GROUP_SIZE, 1, 1)]
+void main(uint3 groupID : SV_GroupID, uint3 threadID : SV_GroupThreadID)
+{
+	int lineLength = horizontal ? textureSize.x : textureSize.y;
+	int lineIndex = groupID.y;
+	int start = groupID.x * GROUP_SIZE;
+
+	// Load the tile, clamping at the edges of the texture
+	for (int i = threadID.x; i < GROUP_SIZE + 2 * blurRadius; i += GROUP_SIZE) {
+		int p = clamp(start + i - blurRadius, 0, lineLength - 1);
+		int2 coord = horizontal ? int2(p, lineIndex) : int2(lineIndex, p);
+		tile[i] = Pixels[coord];
+	}
+
+	GroupMemoryBarrierWithGroupSync();
+
+	int pixel = start + threadID.x;
+	if (pixel >= lineLength)
+		return;
+
+	// Weighted sum of the neighbours on both sides
+	int center = threadID.x + blurRadius;
+	float4 total = tile[center] * weights[0].x;
+
+	for (int r = 1; r <= blurRadius; r++) {
+		total += (tile[center - r] + tile[center + r]) * weights[r].x;
+	}
+
+	Output[horizontal ? int2(pixel, lineIndex) : int2(lineIndex, pixel)] = total;
+}
@@ -1,7 +1,13 @@
+// Must match MAX_BLUR_TAPS in BlurKernel.h
+#define MAX_BLUR_TAPS 5
+
 cbuffer externalData : register(b0) {
-	int blurRadius;
-	float pixelWidth;
-	float pixelHeight;
+	float2 pixelStep;	// One pixel in the blur direction, in UV space
+	int tapCount;
+	float centerWeight;
+
+	// x = offset in pixels, y = weight
+	float4 taps[MAX_BLUR_TAPS];
 }
 
 struct VertexToPixel {
@@ -12,25 +18,24 @@ struct VertexToPixel {
 Texture2D Pixels : register(t0);
 SamplerState ClampSampler : register(s0);
 
+// --------------------------------------------------------
+// One direction of a separable blur
+//
+// - Run once horizontally and once vertically
+// - Each tap lands between two pixels, so the linear
+//    sampler blends both of them in a single fetch
+// - With no taps this is a straight copy
+// --------------------------------------------------------
 float4 main(VertexToPixel input) : SV_TARGET
 {
-	// Track the total color and number of samples
-	float4 total = 0;
-	int sampleCount = 0;
-
-	// Loop through the "box"
-	for (int x = -blurRadius; x <= blurRadius; x++) {
-		for (int y = -blurRadius; y <= blurRadius; y++) {
-			// Calculate the uv for this sample
-			float2 uv = input.uv;
-			uv += float2(x * pixelWidth, y * pixelHeight);
-
-			// Add this color to the running total
-			total += Pixels.Sample(ClampSampler, uv);
-			sampleCount++;
-		}
+	float4 total = Pixels.Sample(ClampSampler, input.uv) * centerWeight;
+
+	for (int i = 0; i < tapCount; i++) {
+		float2 offset = pixelStep * taps[i].x;
+
+		total += Pixels.Sample(ClampSampler, input.uv + offset) * taps[i].y;
+		total += Pixels.Sample(ClampSampler, input.uv - offset) * taps[i].y;
 	}
 
-	// Return the average
-	return total / sampleCount;
-}
\ No newline at end of file
+	return total;
+}
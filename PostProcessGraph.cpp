@@ -0,0 +1,125 @@
+#include "PostProcessGraph.h"
+
+PostProcessGraph::PostProcessGraph(Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, std::shared_ptr<RenderTargetPool> pool) :
+	context(context),
+	pool(pool) {
+}
+
+PostProcessGraph::~PostProcessGraph() {
+}
+
+// --------------------------------------------------------
+// Adds a pass to the end of the chain
+//  - Passes must be added after the passes they read from
+// --------------------------------------------------------
+void PostProcessGraph::AddPass(const PostProcessPass& pass) {
+	passes.push_back(pass);
+	schedule.AddPass(pass);
+}
+
+// --------------------------------------------------------
+// Removes every pass
+// --------------------------------------------------------
+void PostProcessGraph::Clear() {
+	passes.clear();
+	schedule.Clear();
+	outputs.clear();
+}
+
+// --------------------------------------------------------
+// Works out which passes run and how long each of their
+// outputs needs to live
+//  - Returns false if a pass reads something nothing wrote
+// --------------------------------------------------------
+bool PostProcessGraph::Compile() {
+	outputs.assign(passes.size(), 0);
+	return schedule.Compile();
+}
+
+// --------------------------------------------------------
+// Runs the compiled passes in order
+//  - scene is the target the 3D scene was rendered into
+// --------------------------------------------------------
+void PostProcessGraph::Execute(std::shared_ptr<PooledRenderTarget> scene, Microsoft::WRL::ComPtr<ID3D11RenderTargetView> backBufferRTV) {
+	if (!schedule.IsCompiled() && !Compile()) {
+		return;
+	}
+
+	//Kept between frames, so the inputs list keeps its memory
+	PostProcessPassResources& resources = passResources;
+
+	for (int passIndex : schedule.GetExecutionOrder()) {
+		PostProcessPass& pass = passes[passIndex];
+
+		//Gather the inputs
+		resources.Inputs.clear();
+		for (int writer : schedule.GetInputWriters(passIndex)) {
+			resources.Inputs.push_back(writer >= 0 ? outputs[writer] : scene);
+		}
+
+		//Grab the output from the pool, unless it's the screen
+		bool toBackBuffer = pass.Output == POST_PROCESS_BACK_BUFFER;
+		unsigned int width, height;
+		pool->ResolveSize(toBackBuffer ? RenderTargetDesc() : pass.OutputDesc, width, height);
+
+		if (toBackBuffer) {
+			resources.Output = 0;
+		} else {
+			resources.Output = pool->Acquire(pass.OutputDesc);
+			outputs[passIndex] = resources.Output;
+		}
+
+		resources.OutputWidth = width;
+		resources.OutputHeight = height;
+
+		//Bind the output for pixel shader passes
+		if (pass.Compute) {
+			context->OMSetRenderTargets(0, 0, 0);
+		} else {
+			ID3D11RenderTargetView* rtv = resources.Output ? resources.Output->RTV.Get() : backBufferRTV.Get();
+			context->OMSetRenderTargets(1, &rtv, 0);
+
+			D3D11_VIEWPORT viewport = {};
+			viewport.Width = (float)width;
+			viewport.Height = (float)height;
+			viewport.MaxDepth = 1.0f;
+			context->RSSetViewports(1, &viewport);
+		}
+
+		pass.Execute(resources);
+
+		//Hand back anything no later pass reads
+		for (int writer : schedule.GetReleasesAfter(passIndex)) {
+			pool->Release(outputs[writer]);
+			outputs[writer] = 0;
+		}
+	}
+
+	//Don't hold on to this frame's targets
+	resources.Inputs.clear();
+	resources.Output = 0;
+}
+
+// --------------------------------------------------------
+// Peak transient memory of the compiled graph at the given
+// screen size, from the schedule alone
+// --------------------------------------------------------
+size_t PostProcessGraph::CalculatePeakTransientBytes(unsigned int screenWidth, unsigned int screenHeight) {
+	if (!schedule.IsCompiled() && !Compile()) {
+		return 0;
+	}
+
+	return schedule.CalculatePeakTransientBytes(screenWidth, screenHeight);
+}
+
+unsigned int PostProcessGraph::GetPassCount() {
+	return (unsigned int)passes.size();
+}
+
+unsigned int PostProcessGraph::GetExecutedPassCount() {
+	return (unsigned int)schedule.GetExecutionOrder().size();
+}
+
+const PostProcessPass& PostProcessGraph::GetPass(unsigned int index) {
+	return passes[index];
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h> // Used for ComPtr - a smart pointer for COM objects
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "PostProcessSchedule.h"
+#include "RenderTargetPool.h"
+
+// --------------------------------------------------------
+// What a pass gets to work with when it runs
+//
+// - Inputs are in the order the pass declared them
+// - Output is null when the pass writes to the back buffer
+// --------------------------------------------------------
+struct PostProcessPassResources {
+	std::vector<std::shared_ptr<PooledRenderTarget>> Inputs;
+	std::shared_ptr<PooledRenderTarget> Output;
+	unsigned int OutputWidth = 0;
+	unsigned int OutputHeight = 0;
+};
+
+// --------------------------------------------------------
+// A single post process
+//
+// - Pixel shader passes have their output bound as the
+//    render target (and the viewport set) before Execute
+// - Compute passes get nothing bound and write the UAV of
+//    their output themselves
+// --------------------------------------------------------
+struct PostProcessPass : public PostProcessPassDesc {
+	std::function<void(PostProcessPassResources&)> Execute;
+
+	PostProcessPass() {}
+	PostProcessPass(const PostProcessPassDesc& desc) : PostProcessPassDesc(desc) {}
+};
+
+// --------------------------------------------------------
+// A chain of post processes that declare their inputs and
+// outputs by name
+//
+// - Which passes run and when their outputs are released
+//    is all worked out by PostProcessSchedule
+// - Execute() pulls each output from the render target
+//    pool and hands it back right after its last reader,
+//    so passes that don't overlap share textures
+// --------------------------------------------------------
+class PostProcessGraph {
+private:
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+	std::shared_ptr<RenderTargetPool> pool;
+
+	std::vector<PostProcessPass> passes;
+	PostProcessSchedule schedule;
+
+	//Pool targets each pass wrote, until their last reader is done
+	std::vector<std::shared_ptr<PooledRenderTarget>> outputs;
+	PostProcessPassResources passResources;
+
+public:
+	PostProcessGraph(Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, std::shared_ptr<RenderTargetPool> pool);
+	~PostProcessGraph();
+
+	void AddPass(const PostProcessPass& pass);
+	void Clear();
+
+	bool Compile();
+	void Execute(std::shared_ptr<PooledRenderTarget> scene, Microsoft::WRL::ComPtr<ID3D11RenderTargetView> backBufferRTV);
+
+	//Peak transient memory of the compiled graph at the given screen size
+	size_t CalculatePeakTransientBytes(unsigned int screenWidth, unsigned int screenHeight);
+
+	unsigned int GetPassCount();
+	unsigned int GetExecutedPassCount();
+	const PostProcessPass& GetPass(unsigned int index);
+};
@@ -0,0 +1,211 @@
+#include "PostProcessSchedule.h"
+
+PostProcessSchedule::PostProcessSchedule() : compiled(false) {
+}
+
+PostProcessSchedule::~PostProcessSchedule() {
+}
+
+// --------------------------------------------------------
+// Adds a pass to the end of the chain
+//  - Passes must be added after the passes they read from
+// --------------------------------------------------------
+void PostProcessSchedule::AddPass(const PostProcessPassDesc& pass) {
+	passes.push_back(pass);
+	compiled = false;
+}
+
+// --------------------------------------------------------
+// Removes every pass
+// --------------------------------------------------------
+void PostProcessSchedule::Clear() {
+	passes.clear();
+	executionOrder.clear();
+	inputWriters.clear();
+	releaseAfterPass.clear();
+	compiled = false;
+}
+
+// --------------------------------------------------------
+// Finds the most recent pass before the given one that
+// writes the named resource, or -1 if there isn't one
+// --------------------------------------------------------
+int PostProcessSchedule::FindWriter(const std::string& resource, int beforePass) {
+	for (int i = beforePass - 1; i >= 0; i--) {
+		if (passes[i].Output == resource) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+// --------------------------------------------------------
+// Works out which passes run and how long each of their
+// outputs needs to live
+// --------------------------------------------------------
+bool PostProcessSchedule::Compile() {
+	int passCount = (int)passes.size();
+
+	executionOrder.clear();
+	inputWriters.assign(passCount, std::vector<int>());
+	releaseAfterPass.assign(passCount, std::vector<int>());
+
+	//Resolve each input to the pass that wrote it
+	for (int i = 0; i < passCount; i++) {
+		for (const std::string& input : passes[i].Inputs) {
+			int writer = FindWriter(input, i);
+
+			if (writer == -1 && input != POST_PROCESS_SCENE) {
+				compiled = false;
+				return false;
+			}
+
+			inputWriters[i].push_back(writer);
+		}
+	}
+
+	//Walk backwards from the back buffer, keeping only the
+	//passes something downstream actually reads
+	std::vector<bool> needed(passCount, false);
+	for (int i = passCount - 1; i >= 0; i--) {
+		if (passes[i].Output == POST_PROCESS_BACK_BUFFER) {
+			needed[i] = true;
+		}
+
+		if (!needed[i]) {
+			continue;
+		}
+
+		for (int writer : inputWriters[i]) {
+			if (writer >= 0) {
+				needed[writer] = true;
+			}
+		}
+	}
+
+	//Each output is released after the last pass that reads it
+	std::vector<int> lastReader(passCount, -1);
+	for (int i = 0; i < passCount; i++) {
+		if (!needed[i]) {
+			continue;
+		}
+
+		executionOrder.push_back(i);
+
+		for (int writer : inputWriters[i]) {
+			if (writer >= 0) {
+				lastReader[writer] = i;
+			}
+		}
+	}
+
+	for (int i = 0; i < passCount; i++) {
+		if (lastReader[i] >= 0) {
+			releaseAfterPass[lastReader[i]].push_back(i);
+		}
+	}
+
+	compiled = true;
+	return true;
+}
+
+bool PostProcessSchedule::IsCompiled() {
+	return compiled;
+}
+
+const std::vector<int>& PostProcessSchedule::GetExecutionOrder() {
+	return executionOrder;
+}
+
+const std::vector<int>& PostProcessSchedule::GetInputWriters(unsigned int pass) {
+	return inputWriters[pass];
+}
+
+const std::vector<int>& PostProcessSchedule::GetReleasesAfter(unsigned int pass) {
+	return releaseAfterPass[pass];
+}
+
+// --------------------------------------------------------
+// Simulates the pool over the compiled passes to find how
+// much transient memory they need at their busiest
+// --------------------------------------------------------
+size_t PostProcessSchedule::CalculatePeakTransientBytes(unsigned int screenWidth, unsigned int screenHeight) {
+	if (!compiled && !Compile()) {
+		return 0;
+	}
+
+	struct SimulatedTarget {
+		unsigned int Width;
+		unsigned int Height;
+		TextureFormat Format;
+		bool UnorderedAccess;
+		bool InUse;
+	};
+
+	std::vector<SimulatedTarget> simulated;
+	std::vector<int> assigned(passes.size(), -1);
+	size_t peakBytes = 0;
+
+	for (int passIndex : executionOrder) {
+		PostProcessPassDesc& pass = passes[passIndex];
+
+		if (pass.Output != POST_PROCESS_BACK_BUFFER) {
+			unsigned int width, height;
+			ResolveSize(pass.OutputDesc, screenWidth, screenHeight, width, height);
+
+			//Reuse a free target, or "create" a new one
+			for (size_t i = 0; i < simulated.size(); i++) {
+				SimulatedTarget& t = simulated[i];
+				if (!t.InUse && t.Width == width && t.Height == height &&
+					t.Format == pass.OutputDesc.Format && t.UnorderedAccess == pass.OutputDesc.UnorderedAccess) {
+					t.InUse = true;
+					assigned[passIndex] = (int)i;
+					break;
+				}
+			}
+
+			if (assigned[passIndex] == -1) {
+				simulated.push_back({ width, height, pass.OutputDesc.Format, pass.OutputDesc.UnorderedAccess, true });
+				assigned[passIndex] = (int)simulated.size() - 1;
+				peakBytes += width * height * BytesPerPixel(pass.OutputDesc.Format);
+			}
+		}
+
+		for (int writer : releaseAfterPass[passIndex]) {
+			simulated[assigned[writer]].InUse = false;
+		}
+	}
+
+	return peakBytes;
+}
+
+unsigned int PostProcessSchedule::GetPassCount() {
+	return (unsigned int)passes.size();
+}
+
+const PostProcessPassDesc& PostProcessSchedule::GetPass(unsigned int index) {
+	return passes[index];
+}
+
+// --------------------------------------------------------
+// Converts a screen-relative description to a pixel size
+// --------------------------------------------------------
+void PostProcessSchedule::ResolveSize(const RenderTargetDesc& desc, unsigned int screenWidth, unsigned int screenHeight, unsigned int& width, unsigned int& height) {
+	width = (unsigned int)(screenWidth * desc.WidthScale);
+	height = (unsigned int)(screenHeight * desc.HeightScale);
+
+	if (width < 1) width = 1;
+	if (height < 1) height = 1;
+}
+
+// --------------------------------------------------------
+// Size of one pixel of the formats used for render targets
+// --------------------------------------------------------
+size_t PostProcessSchedule::BytesPerPixel(TextureFormat format) {
+	switch (format) {
+	case TextureFormat::RGBA16F:	return 8;
+	case TextureFormat::R32F:		return 4;
+	default:						return 4;
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "RenderDevice.h"
+
+// Names of the resources the graph doesn't own
+#define POST_PROCESS_SCENE "Scene"
+#define POST_PROCESS_BACK_BUFFER "BackBuffer"
+
+// --------------------------------------------------------
+// Describes a screen-relative render target
+//
+// - The size is a scale of the current screen size, so the
+//    same description stays valid across window resizes
+// --------------------------------------------------------
+struct RenderTargetDesc {
+	float WidthScale = 1.0f;
+	float HeightScale = 1.0f;
+	TextureFormat Format = TextureFormat::RGBA8;
+	bool UnorderedAccess = false;	// Also create a UAV for compute shaders
+};
+
+// --------------------------------------------------------
+// What a post process reads and writes, without the code
+// that runs it
+// --------------------------------------------------------
+struct PostProcessPassDesc {
+	std::string Name;
+	std::vector<std::string> Inputs;
+	std::string Output;
+	RenderTargetDesc OutputDesc;
+	bool Compute = false;
+};
+
+// --------------------------------------------------------
+// The device-free half of the post process graph
+//
+// - Compile() drops passes that don't contribute to the
+//    back buffer and works out when each intermediate
+//    target is last read
+// - Outputs are handed back after their last reader, and
+//    CalculatePeakTransientBytes() plays that against a pool
+//    that matches targets the way RenderTargetPool does
+// - Knows nothing about textures, so the scheduling and
+//    aliasing can be tested anywhere
+// --------------------------------------------------------
+class PostProcessSchedule {
+private:
+	std::vector<PostProcessPassDesc> passes;
+
+	//Results of compiling, indexed by pass
+	// - Inputs refer to the pass that wrote them (-1 is the scene)
+	// - Outputs are released after the pass that last reads them
+	std::vector<int> executionOrder;
+	std::vector<std::vector<int>> inputWriters;
+	std::vector<std::vector<int>> releaseAfterPass;
+	bool compiled;
+
+	int FindWriter(const std::string& resource, int beforePass);
+
+public:
+	PostProcessSchedule();
+	~PostProcessSchedule();
+
+	void AddPass(const PostProcessPassDesc& pass);
+	void Clear();
+
+	//Returns false if a pass reads something nothing wrote
+	bool Compile();
+	bool IsCompiled();
+
+	const std::vector<int>& GetExecutionOrder();
+	const std::vector<int>& GetInputWriters(unsigned int pass);
+	const std::vector<int>& GetReleasesAfter(unsigned int pass);
+
+	//Peak transient memory of the compiled passes at the given screen size
+	size_t CalculatePeakTransientBytes(unsigned int screenWidth, unsigned int screenHeight);
+
+	unsigned int GetPassCount();
+	const PostProcessPassDesc& GetPass(unsigned int index);
+
+	//Pixel size of a screen-relative target, at least 1x1
+	static void ResolveSize(const RenderTargetDesc& desc, unsigned int screenWidth, unsigned int screenHeight, unsigned int& width, unsigned int& height);
+	static size_t BytesPerPixel(TextureFormat format);
+};
@@ -0,0 +1,377 @@
+#include "Profiler.h"
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+
+// Singleton requirement
+Profiler* Profiler::instance;
+
+// Each thread finds its buffer without touching the profiler's lock
+static thread_local ProfileThreadBuffer* threadBuffer = 0;
+
+// Everything is timed relative to this, so nanoseconds fit easily
+static const std::chrono::steady_clock::time_point profilerEpoch = std::chrono::steady_clock::now();
+
+Profiler::Profiler() :
+	frameCount(0),
+	frameStart(0),
+	paused(false) {
+	history.resize(PROFILER_HISTORY_FRAMES);
+}
+
+Profiler::~Profiler() {
+}
+
+// --------------------------------------------------------
+// Nanoseconds since the profiler's epoch
+// --------------------------------------------------------
+uint64_t Profiler::Now() {
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - profilerEpoch).count();
+}
+
+// --------------------------------------------------------
+// Gets the calling thread's buffer, registering it on the
+// thread's first zone
+// --------------------------------------------------------
+ProfileThreadBuffer* Profiler::GetThreadBuffer() {
+	if (!threadBuffer) {
+		threadBuffer = RegisterBuffer(0);
+	}
+
+	return threadBuffer;
+}
+
+// --------------------------------------------------------
+// Adds a timeline, named after its index if no name is given
+// --------------------------------------------------------
+ProfileThreadBuffer* Profiler::RegisterBuffer(const char* name) {
+	std::lock_guard<std::mutex> lock(threadMutex);
+
+	std::shared_ptr<ProfileThreadBuffer> buffer = std::make_shared<ProfileThreadBuffer>();
+	buffer->Name = name ? name : "Thread " + std::to_string(threads.size());
+	buffer->Index = (uint32_t)threads.size();
+	threads.push_back(buffer);
+
+	return buffer.get();
+}
+
+// --------------------------------------------------------
+// Adds an event to a ring (producer side)
+//  - Returns false if the ring was full
+// --------------------------------------------------------
+bool Profiler::Push(ProfileThreadBuffer& buffer, const ProfileEvent& event) {
+	uint32_t write = buffer.WriteIndex.load(std::memory_order_relaxed);
+	uint32_t read = buffer.ReadIndex.load(std::memory_order_acquire);
+
+	if (write - read >= PROFILER_THREAD_CAPACITY) {
+		buffer.Dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	buffer.Events[write % PROFILER_THREAD_CAPACITY] = event;
+	buffer.WriteIndex.store(write + 1, std::memory_order_release);
+	return true;
+}
+
+// --------------------------------------------------------
+// Moves everything out of a ring (consumer side)
+// --------------------------------------------------------
+void Profiler::Drain(ProfileThreadBuffer& buffer, std::vector<ProfileEvent>& events) {
+	uint32_t read = buffer.ReadIndex.load(std::memory_order_relaxed);
+	uint32_t write = buffer.WriteIndex.load(std::memory_order_acquire);
+
+	for (; read != write; read++) {
+		events.push_back(buffer.Events[read % PROFILER_THREAD_CAPACITY]);
+	}
+
+	buffer.ReadIndex.store(read, std::memory_order_release);
+}
+
+void Profiler::BeginZone() {
+	GetThreadBuffer()->Depth++;
+}
+
+void Profiler::EndZone(const char* name, uint64_t start) {
+	uint64_t end = Now();
+
+	ProfileThreadBuffer* buffer = GetThreadBuffer();
+	buffer->Depth--;
+
+	Push(*buffer, { name, start, end, buffer->Depth, buffer->Index });
+}
+
+void Profiler::RecordZone(const char* name, uint64_t start, uint64_t end, uint32_t depth, const char* timelineName) {
+	ProfileThreadBuffer* timeline = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(threadMutex);
+		for (auto& buffer : threads) {
+			if (buffer->Name == timelineName) {
+				timeline = buffer.get();
+				break;
+			}
+		}
+	}
+
+	if (!timeline) {
+		timeline = RegisterBuffer(timelineName);
+	}
+
+	Push(*timeline, { name, start, end, depth, timeline->Index });
+}
+
+void Profiler::SetThreadName(const char* name) {
+	if (!threadBuffer) {
+		threadBuffer = RegisterBuffer(name);
+	}
+}
+
+void Profiler::BeginFrame() {
+	frameStart = Now();
+}
+
+// --------------------------------------------------------
+// Gathers every thread's zones into the frame history
+// --------------------------------------------------------
+void Profiler::EndFrame() {
+	uint64_t now = Now();
+
+	//Reuse the oldest frame's memory
+	ProfileFrame& frame = paused ? pausedFrame : history[frameCount % PROFILER_HISTORY_FRAMES];
+	frame.Start = frameStart;
+	frame.End = now;
+	frame.Events.clear();
+
+	{
+		std::lock_guard<std::mutex> lock(threadMutex);
+		for (auto& buffer : threads) {
+			Drain(*buffer, frame.Events);
+		}
+	}
+
+	CalculateTotals(frame);
+
+	if (!paused) {
+		frameCount++;
+	}
+
+	frameStart = now;
+}
+
+// --------------------------------------------------------
+// Adds up the time spent in each zone name
+//  - Keeps the order zones first started in, which is the
+//    order the stats are shown in
+// --------------------------------------------------------
+void Profiler::CalculateTotals(ProfileFrame& frame) {
+	frame.Totals.clear();
+
+	//Scratch memory for the sort, as this runs every frame
+	// - Ties fall back to the events' order, which keeps the
+	//    sort stable without stable_sort's heap buffer
+	FrameVector<const ProfileEvent*> ordered;
+	ordered.reserve(frame.Events.size());
+	for (const ProfileEvent& event : frame.Events) {
+		ordered.push_back(&event);
+	}
+
+	std::sort(ordered.begin(), ordered.end(), [](const ProfileEvent* a, const ProfileEvent* b) {
+		if (a->Thread != b->Thread) return a->Thread < b->Thread;
+		if (a->Start != b->Start) return a->Start < b->Start;
+		return a < b;
+	});
+
+	for (const ProfileEvent* event : ordered) {
+		float milliseconds = (event->End - event->Start) / 1000000.0f;
+
+		auto total = std::find_if(frame.Totals.begin(), frame.Totals.end(), [event](const ProfileZoneTotal& t) {
+			return t.Thread == event->Thread && strcmp(t.Name, event->Name) == 0;
+		});
+
+		if (total == frame.Totals.end()) {
+			frame.Totals.push_back({ event->Name, event->Depth, event->Thread, milliseconds });
+		} else {
+			total->Milliseconds += milliseconds;
+		}
+	}
+}
+
+void Profiler::SetPaused(bool paused) {
+	this->paused = paused;
+}
+
+bool Profiler::IsPaused() {
+	return paused;
+}
+
+unsigned int Profiler::GetFrameCount() {
+	return (std::min)(frameCount, (unsigned int)PROFILER_HISTORY_FRAMES);
+}
+
+const ProfileFrame& Profiler::GetFrame(unsigned int framesAgo) {
+	return history[(frameCount - 1 - framesAgo) % PROFILER_HISTORY_FRAMES];
+}
+
+// --------------------------------------------------------
+// Percentiles of each zone in the latest frame, across the
+// whole history
+//  - Frames where a zone didn't run count as 0 ms
+// --------------------------------------------------------
+std::vector<ProfileZoneStats> Profiler::GetZoneStats() {
+	std::vector<ProfileZoneStats> stats;
+	unsigned int frames = GetFrameCount();
+	if (frames == 0) {
+		return stats;
+	}
+
+	std::vector<float> durations;
+
+	for (const ProfileZoneTotal& latest : GetFrame(0).Totals) {
+		durations.assign(frames, 0.0f);
+
+		for (unsigned int i = 0; i < frames; i++) {
+			for (const ProfileZoneTotal& total : GetFrame(i).Totals) {
+				if (total.Thread == latest.Thread && strcmp(total.Name, latest.Name) == 0) {
+					durations[i] = total.Milliseconds;
+					break;
+				}
+			}
+		}
+
+		ProfileZoneStats zone = {};
+		zone.Name = latest.Name;
+		zone.Depth = latest.Depth;
+		zone.Thread = latest.Thread;
+		zone.Latest = latest.Milliseconds;
+
+		for (float duration : durations) {
+			zone.Average += duration;
+		}
+		zone.Average /= frames;
+
+		std::sort(durations.begin(), durations.end());
+		zone.Percentile50 = durations[(frames - 1) * 50 / 100];
+		zone.Percentile95 = durations[(frames - 1) * 95 / 100];
+		zone.Percentile99 = durations[(frames - 1) * 99 / 100];
+
+		stats.push_back(zone);
+	}
+
+	return stats;
+}
+
+std::vector<std::string> Profiler::GetThreadNames() {
+	std::lock_guard<std::mutex> lock(threadMutex);
+
+	std::vector<std::string> names;
+	for (auto& buffer : threads) {
+		names.push_back(buffer->Name);
+	}
+
+	return names;
+}
+
+unsigned int Profiler::GetDroppedZones() {
+	std::lock_guard<std::mutex> lock(threadMutex);
+
+	unsigned int dropped = 0;
+	for (auto& buffer : threads) {
+		dropped += buffer->Dropped.load(std::memory_order_relaxed);
+	}
+
+	return dropped;
+}
+
+// --------------------------------------------------------
+// Writes the frame history in the Chrome trace event format
+//  - Open the file in chrome://tracing or ui.perfetto.dev
+// --------------------------------------------------------
+bool Profiler::ExportChromeTrace(const std::string& path) {
+	std::ofstream file(path);
+	if (!file) {
+		return false;
+	}
+
+	auto writeString = [&file](const std::string& text) {
+		file << '"';
+		for (char c : text) {
+			if (c == '"' || c == '\\') {
+				file << '\\';
+			}
+			file << c;
+		}
+		file << '"';
+	};
+
+	file << "{\"traceEvents\":[\n";
+
+	//Name each timeline
+	std::vector<std::string> threadNames = GetThreadNames();
+	for (size_t i = 0; i < threadNames.size(); i++) {
+		file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << i << ",\"args\":{\"name\":";
+		writeString(threadNames[i]);
+		file << "}},\n";
+	}
+
+	//Oldest frame first, with one complete ("X") event per zone
+	bool first = true;
+	for (unsigned int i = GetFrameCount(); i > 0; i--) {
+		const ProfileFrame& frame = GetFrame(i - 1);
+
+		for (const ProfileEvent& event : frame.Events) {
+			if (!first) {
+				file << ",\n";
+			}
+			first = false;
+
+			file << "{\"name\":";
+			writeString(event.Name);
+			file << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.Thread
+				<< ",\"ts\":" << event.Start / 1000.0
+				<< ",\"dur\":" << (event.End - event.Start) / 1000.0 << "}";
+		}
+	}
+
+	file << "\n]}\n";
+	return true;
+}
+
+// --------------------------------------------------------
+// Records empty zones into a private ring to find what one
+// zone costs, in nanoseconds
+//  - Goes through the same thread lookup, clock reads and
+//    ring push as PROFILE_SCOPE, without touching the real
+//    history
+// --------------------------------------------------------
+double Profiler::MeasureZoneOverhead(unsigned int zoneCount) {
+	ProfileThreadBuffer scratch;
+	std::vector<ProfileEvent> drained;
+	drained.reserve(PROFILER_THREAD_CAPACITY);
+
+	uint64_t elapsed = 0;
+
+	for (unsigned int done = 0; done < zoneCount;) {
+		unsigned int batch = (std::min)(zoneCount - done, (unsigned int)PROFILER_THREAD_CAPACITY);
+
+		uint64_t start = Now();
+		for (unsigned int i = 0; i < batch; i++) {
+			ProfileThreadBuffer* buffer = GetThreadBuffer();
+			buffer->Depth++;
+			uint64_t zoneStart = Now();
+			buffer->Depth--;
+			Push(scratch, { "Overhead", zoneStart, Now(), buffer->Depth, buffer->Index });
+		}
+		elapsed += Now() - start;
+
+		//Empty the ring between batches so nothing is dropped
+		drained.clear();
+		Drain(scratch, drained);
+		done += batch;
+	}
+
+	return zoneCount > 0 ? (double)elapsed / zoneCount : 0.0;
+}
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Times the rest of the enclosing scope as a named zone
+//  - The name must outlive the profiler (a string literal)
+#define PROFILER_CONCAT_INNER(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileZone PROFILER_CONCAT(profileZone, __LINE__)(name)
+
+// Number of zones each thread can record between two EndFrame() calls
+#define PROFILER_THREAD_CAPACITY 4096
+// Number of frames kept for the percentiles and the trace export
+#define PROFILER_HISTORY_FRAMES 240
+
+// --------------------------------------------------------
+// One finished zone
+//  - Times are in nanoseconds since the profiler started
+// --------------------------------------------------------
+struct ProfileEvent {
+	const char* Name;
+	uint64_t Start;
+	uint64_t End;
+	uint32_t Depth;		// How many zones it was nested inside
+	uint32_t Thread;	// Index into the profiler's thread list
+};
+
+// --------------------------------------------------------
+// Total time spent in one zone name during a frame
+// --------------------------------------------------------
+struct ProfileZoneTotal {
+	const char* Name;
+	uint32_t Depth;
+	uint32_t Thread;
+	float Milliseconds;
+};
+
+// --------------------------------------------------------
+// Every zone that finished during one frame
+// --------------------------------------------------------
+struct ProfileFrame {
+	uint64_t Start = 0;
+	uint64_t End = 0;
+	std::vector<ProfileEvent> Events;
+	std::vector<ProfileZoneTotal> Totals;
+};
+
+// --------------------------------------------------------
+// Timing stats for one zone name across the frame history
+//  - Durations are the zone's total time per frame, in ms
+// --------------------------------------------------------
+struct ProfileZoneStats {
+	const char* Name;
+	uint32_t Depth;
+	uint32_t Thread;
+	float Latest;
+	float Average;
+	float Percentile50;
+	float Percentile95;
+	float Percentile99;
+};
+
+// --------------------------------------------------------
+// Zones recorded by a single thread
+//
+// - A single producer, single consumer ring: only the owning
+//    thread writes and only EndFrame() reads, so neither
+//    side ever takes a lock
+// - Zones that don't fit are dropped and counted
+// --------------------------------------------------------
+struct ProfileThreadBuffer {
+	std::string Name;
+	uint32_t Index = 0;
+	uint32_t Depth = 0; // Only touched by the owning thread
+
+	std::vector<ProfileEvent> Events = std::vector<ProfileEvent>(PROFILER_THREAD_CAPACITY);
+	std::atomic<uint32_t> WriteIndex{ 0 };
+	std::atomic<uint32_t> ReadIndex{ 0 };
+	std::atomic<uint32_t> Dropped{ 0 };
+};
+
+// --------------------------------------------------------
+// Hierarchical CPU profiler
+//
+// - Zones are recorded with PROFILE_SCOPE on any thread, and
+//    gathered into a frame at EndFrame() on the main thread
+// - Only uses the standard library, so it can be built and
+//    timed on any platform
+// --------------------------------------------------------
+class Profiler
+{
+#pragma region Singleton
+public:
+	// Gets the one and only instance of this class
+	static Profiler& GetInstance()
+	{
+		if (!instance)
+		{
+			instance = new Profiler();
+		}
+
+		return *instance;
+	}
+
+	// Remove these functions (C++ 11 version)
+	Profiler(Profiler const&) = delete;
+	void operator=(Profiler const&) = delete;
+
+private:
+	static Profiler* instance;
+	Profiler();
+#pragma endregion
+
+private:
+	std::mutex threadMutex; // Only taken when a thread records its first zone
+	std::vector<std::shared_ptr<ProfileThreadBuffer>> threads;
+
+	std::vector<ProfileFrame> history; // Ring of PROFILER_HISTORY_FRAMES
+	ProfileFrame pausedFrame; // Where frames go while paused
+	unsigned int frameCount;
+	uint64_t frameStart;
+	bool paused;
+
+	ProfileThreadBuffer* GetThreadBuffer();
+	ProfileThreadBuffer* RegisterBuffer(const char* name);
+	static bool Push(ProfileThreadBuffer& buffer, const ProfileEvent& event);
+	static void Drain(ProfileThreadBuffer& buffer, std::vector<ProfileEvent>& events);
+	static void CalculateTotals(ProfileFrame& frame);
+
+public:
+	~Profiler();
+
+	static uint64_t Now();
+
+	//Called by ProfileZone
+	void BeginZone();
+	void EndZone(const char* name, uint64_t start);
+
+	//Records a zone measured somewhere else (like on the GPU) under
+	//its own named timeline
+	// - Main thread only, as the timeline has a single writer
+	void RecordZone(const char* name, uint64_t start, uint64_t end, uint32_t depth, const char* timelineName);
+
+	//Names the calling thread in the flame graph and trace
+	// - Call before the thread records its first zone
+	void SetThreadName(const char* name);
+
+	void BeginFrame();
+	void EndFrame();
+
+	//While paused, frames are still drained but not kept
+	void SetPaused(bool paused);
+	bool IsPaused();
+
+	//0 is the latest frame
+	unsigned int GetFrameCount();
+	const ProfileFrame& GetFrame(unsigned int framesAgo);
+	std::vector<ProfileZoneStats> GetZoneStats();
+
+	std::vector<std::string> GetThreadNames();
+	unsigned int GetDroppedZones();
+
+	bool ExportChromeTrace(const std::string& path);
+
+	//Times empty zones to find the cost of recording one
+	double MeasureZoneOverhead(unsigned int zoneCount);
+};
+
+// --------------------------------------------------------
+// Times its own lifetime as a zone
+// --------------------------------------------------------
+class ProfileZone
+{
+private:
+	const char* name;
+	uint64_t start;
+
+public:
+	ProfileZone(const char* name) :
+		name(name)
+	{
+		Profiler::GetInstance().BeginZone();
+		start = Profiler::Now();
+	}
+
+	~ProfileZone()
+	{
+		Profiler::GetInstance().EndZone(name, start);
+	}
+};
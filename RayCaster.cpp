@@ -0,0 +1,223 @@
+#include "RayCaster.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+// --------------------------------------------------------
+// Moves a world space ray into an instance's local space
+//  - World matrices are affine with row vectors, so the
+//     inverse is the upper 3x3's inverse, applied after
+//     taking off the translation
+//  - The direction isn't renormalized, which keeps distances
+//     along it the same in both spaces
+//  - Returns false when a zero scale leaves no inverse
+// --------------------------------------------------------
+static bool ToLocalRay(const float* world, const SceneBvhRay& ray, float maxDistance, SceneBvhRay& local) {
+	float a = world[0], b = world[1], c = world[2];
+	float d = world[4], e = world[5], f = world[6];
+	float g = world[8], h = world[9], i = world[10];
+
+	float determinant = a * (e * i - f * h) - b * (d * i - f * g) + c * (d * h - e * g);
+	if (std::fabs(determinant) < 1e-20f) return false;
+	float s = 1.0f / determinant;
+
+	float inverse[3][3] = {
+		{ (e * i - f * h) * s, (c * h - b * i) * s, (b * f - c * e) * s },
+		{ (f * g - d * i) * s, (a * i - c * g) * s, (c * d - a * f) * s },
+		{ (d * h - e * g) * s, (b * g - a * h) * s, (a * e - b * d) * s }
+	};
+
+	float offset[3] = { ray.Origin[0] - world[12], ray.Origin[1] - world[13], ray.Origin[2] - world[14] };
+	for (int column = 0; column < 3; column++) {
+		local.Origin[column] = offset[0] * inverse[0][column] + offset[1] * inverse[1][column] + offset[2] * inverse[2][column];
+		local.Direction[column] = ray.Direction[0] * inverse[0][column] + ray.Direction[1] * inverse[1][column] + ray.Direction[2] * inverse[2][column];
+	}
+	local.MaxDistance = maxDistance;
+	return true;
+}
+
+bool RayCaster::Cast(const SceneBvh& broadphase, const RayCastInstance* instances, const SceneBvhRay& ray, MathPath path, RayCastHit& hit) {
+	hit.Instance = RAY_CAST_MISS;
+	hit.Distance = ray.MaxDistance;
+
+	return broadphase.CastRay(ray, [&](uint32_t item, float& maxDistance) {
+		const RayCastInstance& instance = instances[item];
+		SceneBvhRay local;
+		if (!instance.Mesh || !ToLocalRay(instance.World, ray, maxDistance, local)) return false;
+
+		MeshBvhHit meshHit;
+		if (!instance.Mesh->Raycast(local, path, meshHit)) return false;
+
+		hit = RayCastHit{ item, meshHit.Triangle, meshHit.Distance, meshHit.U, meshHit.V };
+		maxDistance = meshHit.Distance;
+		return true;
+	});
+}
+
+bool RayCaster::Cast(const SceneBvh& broadphase, const RayCastInstance* instances, const SceneBvhRay& ray, RayCastHit& hit) {
+	return Cast(broadphase, instances, ray, TransformBatch::GetPath(), hit);
+}
+
+size_t RayCaster::CastBatch(const SceneBvh& broadphase, const RayCastInstance* instances, const SceneBvhRay* rays, size_t count, MathPath path, RayCastHit* hits) {
+	std::atomic<size_t> hitCount(0);
+
+	JobSystem::GetInstance().ParallelFor(count, RAY_CASTER_GRAIN, [&](size_t begin, size_t end) {
+		size_t chunkHits = 0;
+		for (size_t r = begin; r < end; r++) {
+			if (Cast(broadphase, instances, rays[r], path, hits[r])) chunkHits++;
+		}
+		hitCount += chunkHits;
+	});
+
+	return hitCount;
+}
+
+size_t RayCaster::CastBatch(const SceneBvh& broadphase, const RayCastInstance* instances, const SceneBvhRay* rays, size_t count, RayCastHit* hits) {
+	return CastBatch(broadphase, instances, rays, count, TransformBatch::GetPath(), hits);
+}
+
+bool RayCaster::CastAll(const RayCastInstance* instances, size_t instanceCount, const SceneBvhRay& ray, RayCastHit& hit) {
+	hit.Instance = RAY_CAST_MISS;
+	hit.Distance = ray.MaxDistance;
+
+	for (size_t i = 0; i < instanceCount; i++) {
+		SceneBvhRay local;
+		if (!instances[i].Mesh || !ToLocalRay(instances[i].World, ray, hit.Distance, local)) continue;
+
+		MeshBvhHit meshHit;
+		if (instances[i].Mesh->RaycastAll(local, meshHit)) {
+			hit = RayCastHit{ (uint32_t)i, meshHit.Triangle, meshHit.Distance, meshHit.U, meshHit.V };
+		}
+	}
+
+	return hit.Instance != RAY_CAST_MISS;
+}
+
+// --------------------------------------------------------
+// Scatters the meshes around a cube, each scaled to about a
+// unit across and turned some random way, then fires rays
+// between random points inside it, like line of sight
+// checks between things in a level
+// --------------------------------------------------------
+RayCastMeasurement RayCaster::Measure(const std::vector<std::shared_ptr<MeshBvh>>& meshes, size_t instanceCount, unsigned int rayCount) {
+	RayCastMeasurement measurement;
+	measurement.Instances = instanceCount;
+	measurement.Rays = rayCount;
+	measurement.Path = TransformBatch::GetPathName(TransformBatch::GetPath());
+	if (meshes.empty() || instanceCount == 0 || rayCount == 0) return measurement;
+
+	std::mt19937 random(1234);
+	float size = std::cbrt((float)instanceCount) * 3.0f;
+	std::uniform_real_distribution<float> position(-size * 0.5f, size * 0.5f);
+	std::uniform_real_distribution<float> scale(0.5f, 1.5f);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	std::vector<float> worlds(instanceCount * 16);
+	std::vector<RayCastInstance> instances(instanceCount);
+	BoundsStreams bounds;
+	bounds.Resize(instanceCount);
+
+	for (size_t n = 0; n < instanceCount; n++) {
+		const MeshBvh& mesh = *meshes[n % meshes.size()];
+		SceneBvhBox box = mesh.GetBounds();
+		float largest = (std::max)((std::max)(box.Max[0] - box.Min[0], box.Max[1] - box.Min[1]), box.Max[2] - box.Min[2]);
+		float fit = largest > 0.0f ? 1.0f / largest : 1.0f;
+
+		//A random unit quaternion as a rotation matrix, with each
+		//row scaled separately
+		float q[4] = { unit(random), unit(random), unit(random), unit(random) };
+		float length = (std::max)(std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]), 0.001f);
+		float x = q[0] / length, y = q[1] / length, z = q[2] / length, w = q[3] / length;
+		float rows[3][3] = {
+			{ 1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + z * w), 2.0f * (x * z - y * w) },
+			{ 2.0f * (x * y - z * w), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + x * w) },
+			{ 2.0f * (x * z + y * w), 2.0f * (y * z - x * w), 1.0f - 2.0f * (x * x + y * y) }
+		};
+
+		float* world = &worlds[n * 16];
+		for (int r = 0; r < 3; r++) {
+			float rowScale = scale(random) * fit;
+			for (int c = 0; c < 3; c++) world[r * 4 + c] = rows[r][c] * rowScale;
+			world[r * 4 + 3] = 0.0f;
+		}
+		world[12] = position(random);
+		world[13] = position(random);
+		world[14] = position(random);
+		world[15] = 1.0f;
+
+		//The local box's center moved, and its extents spread over
+		//every axis the rotation turns them onto
+		float center[3], extents[3];
+		for (int c = 0; c < 3; c++) {
+			center[c] = world[12 + c];
+			extents[c] = 0.0f;
+			for (int r = 0; r < 3; r++) {
+				center[c] += (box.Min[r] + box.Max[r]) * 0.5f * world[r * 4 + c];
+				extents[c] += (box.Max[r] - box.Min[r]) * 0.5f * std::fabs(world[r * 4 + c]);
+			}
+		}
+		bounds.Set(n, center, extents);
+
+		instances[n] = RayCastInstance{ &mesh, world };
+		measurement.Triangles += mesh.GetTriangleCount();
+	}
+
+	SceneBvh broadphase;
+	broadphase.Build(bounds);
+
+	std::vector<SceneBvhRay> rays(rayCount);
+	for (unsigned int r = 0; r < rayCount; r++) {
+		float from[3] = { position(random), position(random), position(random) };
+		float to[3] = { position(random), position(random), position(random) };
+		float direction[3] = { to[0] - from[0], to[1] - from[1], to[2] - from[2] };
+		float distance = (std::max)(std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]), 0.001f);
+		rays[r] = SceneBvhRay{ { from[0], from[1], from[2] }, { direction[0] / distance, direction[1] / distance, direction[2] / distance }, distance };
+	}
+
+	std::vector<RayCastHit> hits(rayCount), scalarHits(rayCount), singleHits(rayCount);
+
+	Clock::time_point start = Clock::now();
+	measurement.Hits = (unsigned int)CastBatch(broadphase, &instances[0], &rays[0], rayCount, hits.data());
+	measurement.RaysPerSecond = rayCount / std::chrono::duration<double>(Clock::now() - start).count();
+
+	start = Clock::now();
+	for (unsigned int r = 0; r < rayCount; r++) Cast(broadphase, &instances[0], rays[r], singleHits[r]);
+	measurement.SingleThreadRaysPerSecond = rayCount / std::chrono::duration<double>(Clock::now() - start).count();
+
+	start = Clock::now();
+	CastBatch(broadphase, &instances[0], &rays[0], rayCount, MathPath::Scalar, scalarHits.data());
+	measurement.ScalarRaysPerSecond = rayCount / std::chrono::duration<double>(Clock::now() - start).count();
+
+	//Testing every triangle, for the speed up and to check the answers
+	// - Each of these rays tests the whole scene, so big scenes get
+	//    fewer of them
+	size_t checkBudget = (std::max)((size_t)1, (size_t)500000000 / (std::max)(measurement.Triangles, (size_t)1));
+	size_t checkCount = (std::min)((std::min)((size_t)rayCount, (size_t)32), checkBudget);
+	std::vector<RayCastHit> checkHits(checkCount);
+
+	start = Clock::now();
+	JobSystem::GetInstance().ParallelFor(checkCount, 1, [&](size_t begin, size_t end) {
+		for (size_t r = begin; r < end; r++) CastAll(&instances[0], instanceCount, rays[r], checkHits[r]);
+	});
+	measurement.BruteForceRaysPerSecond = checkCount / std::chrono::duration<double>(Clock::now() - start).count();
+
+	//Triangles sharing an edge can both claim a ray through it, so
+	//only whether something was hit and how far away it was count
+	auto matches = [](const RayCastHit& a, const RayCastHit& b) {
+		if ((a.Instance == RAY_CAST_MISS) != (b.Instance == RAY_CAST_MISS)) return false;
+		return a.Instance == RAY_CAST_MISS || std::fabs(a.Distance - b.Distance) <= 1e-4f * (std::max)(1.0f, a.Distance);
+	};
+
+	for (unsigned int r = 0; r < rayCount; r++) {
+		bool matched = matches(hits[r], scalarHits[r]) && matches(hits[r], singleHits[r]);
+		if (r < checkCount) matched &= matches(hits[r], checkHits[r]);
+		if (!matched) measurement.Mismatches++;
+	}
+
+	return measurement;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "MeshBvh.h"
+#include "SceneBvh.h"
+
+// Rays per job when a batch is split across threads
+#define RAY_CASTER_GRAIN 64
+
+// What a ray that hits nothing has as its instance
+#define RAY_CAST_MISS UINT32_MAX
+
+// --------------------------------------------------------
+// Something rays can hit, as a mesh's triangles and where
+// they are
+//  - Instances line up with the broadphase's items, so in
+//     the game they're the entities
+// --------------------------------------------------------
+struct RayCastInstance {
+	const MeshBvh* Mesh;	// Null for things rays go straight through
+	const float* World;		// Row major world matrix, like the entities' render matrices
+};
+
+struct RayCastHit {
+	uint32_t Instance;	// RAY_CAST_MISS when nothing was hit
+	uint32_t Triangle;
+	float Distance;		// Along the ray, so in world units when its direction is unit length
+	float U;			// Barycentric weights of the triangle's second and third corners
+	float V;
+};
+
+// --------------------------------------------------------
+// What RayCaster::Measure() found
+// --------------------------------------------------------
+struct RayCastMeasurement {
+	size_t Instances = 0;
+	size_t Triangles = 0;					// Across every instance
+	unsigned int Rays = 0;
+	const char* Path = "";					// Kernel the main timing used
+	double RaysPerSecond = 0.0;				// Batched over the job system
+	double SingleThreadRaysPerSecond = 0.0;	// One at a time on the calling thread
+	double ScalarRaysPerSecond = 0.0;		// Batched, with one triangle at a time
+	double BruteForceRaysPerSecond = 0.0;	// Every triangle of every instance
+	unsigned int Hits = 0;
+	unsigned int Mismatches = 0;			// Rays that didn't match the scalar kernel or brute force
+};
+
+// --------------------------------------------------------
+// Casts rays against meshes on the CPU, for picking and
+// line of sight
+//
+// - The scene BVH finds which instances' boxes a ray goes
+//    through, nearest first, and each of those gets the ray
+//    in its mesh's local space for the mesh's own BVH
+// - Every triangle hit shortens the ray, so boxes beyond the
+//    nearest hit so far are never opened
+// - Rays are moved into local space without normalizing,
+//    so distances stay in the ray's own units
+// - Doesn't use DirectXMath, so it builds anywhere, like a
+//    server with no GPU
+// --------------------------------------------------------
+class RayCaster {
+private:
+	static bool Cast(const SceneBvh& broadphase, const RayCastInstance* instances, const SceneBvhRay& ray, MathPath path, RayCastHit& hit);
+	static size_t CastBatch(const SceneBvh& broadphase, const RayCastInstance* instances, const SceneBvhRay* rays, size_t count, MathPath path, RayCastHit* hits);
+
+public:
+	//Nearest triangle along the ray, within its MaxDistance
+	// - The broadphase's items index the instances
+	static bool Cast(const SceneBvh& broadphase, const RayCastInstance* instances, const SceneBvhRay& ray, RayCastHit& hit);
+
+	//A hit for each ray, spread over the job system, and
+	//returns how many rays hit something
+	static size_t CastBatch(const SceneBvh& broadphase, const RayCastInstance* instances, const SceneBvhRay* rays, size_t count, RayCastHit* hits);
+
+	//Same as Cast(), but testing every triangle of every
+	//instance, for checking
+	static bool CastAll(const RayCastInstance* instances, size_t instanceCount, const SceneBvhRay& ray, RayCastHit& hit);
+
+	//Times casting random rays through a random scene of the
+	//meshes, and checks them against the scalar kernel and a
+	//sample against testing everything
+	static RayCastMeasurement Measure(const std::vector<std::shared_ptr<MeshBvh>>& meshes, size_t instanceCount, unsigned int rayCount);
+};
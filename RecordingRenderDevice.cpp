@@ -0,0 +1,213 @@
+#include "RecordingRenderDevice.h"
+
+using namespace CommandTrace;
+
+RecordingRenderDevice::RecordingRenderDevice(std::shared_ptr<RenderDevice> target) :
+	target(target),
+	recording(true),
+	nextId(1) {
+}
+
+RecordingRenderDevice::~RecordingRenderDevice() {
+}
+
+void RecordingRenderDevice::Record(RenderCommandType type, ShaderStage stage, uint32_t slot, uint32_t handle, uint32_t count, uint32_t start, int32_t baseVertex, const void* data) {
+	if (!recording && !observer) return;
+
+	RenderCommand command = {};
+	command.Type = type;
+	command.Stage = stage;
+	command.Slot = slot;
+	command.Handle = handle;
+	command.Count = count;
+	command.Start = start;
+	command.BaseVertex = baseVertex;
+
+	if (observer) observer->OnCommand(command, data);
+	if (recording) commands.push_back(command);
+}
+
+// --------------------------------------------------------
+// Resources come from the target when there is one, so
+// handles mean the same thing on both devices
+// --------------------------------------------------------
+BufferHandle RecordingRenderDevice::CreateBuffer(const BufferDesc& desc, const void* initialData) {
+	BufferHandle handle;
+	if (target) handle = target->CreateBuffer(desc, initialData);
+	else handle.Id = nextId++;
+
+	if (observer) observer->OnResourceCreated(RecordType::CreateBuffer, handle.Id, &desc, sizeof(desc), initialData, desc.ByteWidth);
+	return handle;
+}
+
+TextureHandle RecordingRenderDevice::CreateTexture(const TextureDesc& desc, const void* initialData, unsigned int rowPitch) {
+	TextureHandle handle;
+	if (target) handle = target->CreateTexture(desc, initialData, rowPitch);
+	else handle.Id = nextId++;
+
+	if (observer) {
+		TextureRecordDesc record = { desc, rowPitch };
+		observer->OnResourceCreated(RecordType::CreateTexture, handle.Id, &record, sizeof(record), initialData, (size_t)rowPitch * desc.Height);
+	}
+	return handle;
+}
+
+ShaderHandle RecordingRenderDevice::CreateShader(ShaderStage stage, const void* bytecode, size_t byteCount) {
+	ShaderHandle handle;
+	if (target) handle = target->CreateShader(stage, bytecode, byteCount);
+	else handle.Id = nextId++;
+
+	if (observer) observer->OnResourceCreated(RecordType::CreateShader, handle.Id, &stage, sizeof(stage), bytecode, byteCount);
+	return handle;
+}
+
+SamplerHandle RecordingRenderDevice::CreateSampler(const SamplerDesc& desc) {
+	SamplerHandle handle;
+	if (target) handle = target->CreateSampler(desc);
+	else handle.Id = nextId++;
+
+	if (observer) observer->OnResourceCreated(RecordType::CreateSampler, handle.Id, &desc, sizeof(desc), 0, 0);
+	return handle;
+}
+
+RasterizerHandle RecordingRenderDevice::CreateRasterizerState(const RasterizerDesc& desc) {
+	RasterizerHandle handle;
+	if (target) handle = target->CreateRasterizerState(desc);
+	else handle.Id = nextId++;
+
+	if (observer) observer->OnResourceCreated(RecordType::CreateRasterizerState, handle.Id, &desc, sizeof(desc), 0, 0);
+	return handle;
+}
+
+DepthStencilHandle RecordingRenderDevice::CreateDepthStencilState(const DepthStencilDesc& desc) {
+	DepthStencilHandle handle;
+	if (target) handle = target->CreateDepthStencilState(desc);
+	else handle.Id = nextId++;
+
+	if (observer) observer->OnResourceCreated(RecordType::CreateDepthStencilState, handle.Id, &desc, sizeof(desc), 0, 0);
+	return handle;
+}
+
+void RecordingRenderDevice::DestroyBuffer(BufferHandle buffer) {
+	if (observer) observer->OnResourceDestroyed(RecordType::DestroyBuffer, buffer.Id);
+	if (target) target->DestroyBuffer(buffer);
+}
+
+void RecordingRenderDevice::DestroyTexture(TextureHandle texture) {
+	if (observer) observer->OnResourceDestroyed(RecordType::DestroyTexture, texture.Id);
+	if (target) target->DestroyTexture(texture);
+}
+
+void RecordingRenderDevice::InvalidateState() {
+	RenderDevice::InvalidateState();
+	if (observer) observer->OnInvalidateState();
+	if (target) target->InvalidateState();
+}
+
+void RecordingRenderDevice::BeginFrame() {
+	RenderDevice::BeginFrame();
+	if (observer) observer->OnFrameBegin();
+	if (target) target->BeginFrame();
+}
+
+void RecordingRenderDevice::ApplyVertexBuffer(BufferHandle buffer, unsigned int stride) {
+	Record(RenderCommandType::SetVertexBuffer, ShaderStage::Vertex, 0, buffer.Id, stride);
+	if (target) target->SetVertexBuffer(buffer, stride);
+}
+
+void RecordingRenderDevice::ApplyIndexBuffer(BufferHandle buffer) {
+	Record(RenderCommandType::SetIndexBuffer, ShaderStage::Vertex, 0, buffer.Id, 0);
+	if (target) target->SetIndexBuffer(buffer);
+}
+
+void RecordingRenderDevice::ApplyConstantBuffer(ShaderStage stage, unsigned int slot, BufferHandle buffer) {
+	Record(RenderCommandType::SetConstantBuffer, stage, slot, buffer.Id, 0);
+	if (target) target->SetConstantBuffer(stage, slot, buffer);
+}
+
+void RecordingRenderDevice::ApplyShader(ShaderStage stage, ShaderHandle shader) {
+	Record(RenderCommandType::SetShader, stage, 0, shader.Id, 0);
+	if (target) target->SetShader(stage, shader);
+}
+
+void RecordingRenderDevice::ApplyTexture(ShaderStage stage, unsigned int slot, TextureHandle texture) {
+	Record(RenderCommandType::SetTexture, stage, slot, texture.Id, 0);
+	if (target) target->SetTexture(stage, slot, texture);
+}
+
+void RecordingRenderDevice::ApplySampler(ShaderStage stage, unsigned int slot, SamplerHandle sampler) {
+	Record(RenderCommandType::SetSampler, stage, slot, sampler.Id, 0);
+	if (target) target->SetSampler(stage, slot, sampler);
+}
+
+void RecordingRenderDevice::ApplyRasterizerState(RasterizerHandle state) {
+	Record(RenderCommandType::SetRasterizerState, ShaderStage::Vertex, 0, state.Id, 0);
+	if (target) target->SetRasterizerState(state);
+}
+
+void RecordingRenderDevice::ApplyDepthStencilState(DepthStencilHandle state) {
+	Record(RenderCommandType::SetDepthStencilState, ShaderStage::Pixel, 0, state.Id, 0);
+	if (target) target->SetDepthStencilState(state);
+}
+
+void RecordingRenderDevice::ApplyTopology(PrimitiveTopology topology) {
+	Record(RenderCommandType::SetTopology, ShaderStage::Vertex, 0, (uint32_t)topology, 0);
+	if (target) target->SetTopology(topology);
+}
+
+void RecordingRenderDevice::ApplyUpdateBuffer(BufferHandle buffer, const void* data, unsigned int byteWidth) {
+	Record(RenderCommandType::UpdateBuffer, ShaderStage::Vertex, 0, buffer.Id, byteWidth, 0, 0, data);
+	if (target) target->UpdateBuffer(buffer, data, byteWidth);
+}
+
+void RecordingRenderDevice::ApplyDraw(unsigned int vertexCount, unsigned int startVertex) {
+	Record(RenderCommandType::Draw, ShaderStage::Vertex, 0, 0, vertexCount, startVertex);
+	if (target) target->Draw(vertexCount, startVertex);
+}
+
+void RecordingRenderDevice::ApplyDrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex) {
+	Record(RenderCommandType::DrawIndexed, ShaderStage::Vertex, 0, 0, indexCount, startIndex, baseVertex);
+	if (target) target->DrawIndexed(indexCount, startIndex, baseVertex);
+}
+
+void RecordingRenderDevice::SetRecording(bool recording) {
+	this->recording = recording;
+}
+
+bool RecordingRenderDevice::IsRecording() {
+	return recording;
+}
+
+const std::vector<RenderCommand>& RecordingRenderDevice::GetCommands() {
+	return commands;
+}
+
+void RecordingRenderDevice::ClearCommands() {
+	commands.clear();
+}
+
+std::shared_ptr<RenderDevice> RecordingRenderDevice::GetTarget() {
+	return target;
+}
+
+void RecordingRenderDevice::SetObserver(std::shared_ptr<IRenderDeviceObserver> observer) {
+	this->observer = observer;
+}
+
+const char* RecordingRenderDevice::GetCommandName(RenderCommandType type) {
+	switch (type) {
+	case RenderCommandType::SetVertexBuffer: return "SetVertexBuffer";
+	case RenderCommandType::SetIndexBuffer: return "SetIndexBuffer";
+	case RenderCommandType::SetConstantBuffer: return "SetConstantBuffer";
+	case RenderCommandType::SetShader: return "SetShader";
+	case RenderCommandType::SetTexture: return "SetTexture";
+	case RenderCommandType::SetSampler: return "SetSampler";
+	case RenderCommandType::SetRasterizerState: return "SetRasterizerState";
+	case RenderCommandType::SetDepthStencilState: return "SetDepthStencilState";
+	case RenderCommandType::SetTopology: return "SetTopology";
+	case RenderCommandType::UpdateBuffer: return "UpdateBuffer";
+	case RenderCommandType::Draw: return "Draw";
+	case RenderCommandType::DrawIndexed: return "DrawIndexed";
+	default: return "Unknown";
+	}
+}
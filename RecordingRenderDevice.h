@@ -0,0 +1,126 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "CommandTrace.h"
+#include "RenderDevice.h"
+
+enum class RenderCommandType {
+	SetVertexBuffer,
+	SetIndexBuffer,
+	SetConstantBuffer,
+	SetShader,
+	SetTexture,
+	SetSampler,
+	SetRasterizerState,
+	SetDepthStencilState,
+	SetTopology,
+	UpdateBuffer,
+	Draw,
+	DrawIndexed
+};
+
+// --------------------------------------------------------
+// One command that reached a recording device
+//  - Only the fields the command type uses are filled in
+// --------------------------------------------------------
+struct RenderCommand {
+	RenderCommandType Type;
+	ShaderStage Stage;
+	uint32_t Slot;
+	uint32_t Handle;	// Id of the bound resource, or the topology
+	uint32_t Count;		// Stride, byte count, or vertex/index count
+	uint32_t Start;
+	int32_t BaseVertex;
+};
+
+// --------------------------------------------------------
+// Gets told everything that reaches a recording device,
+// recording or not, so tools like the command trace can
+// stream it
+// --------------------------------------------------------
+class IRenderDeviceObserver {
+public:
+	virtual ~IRenderDeviceObserver() {}
+	virtual void OnResourceCreated(CommandTrace::RecordType type, uint32_t id, const void* desc, size_t descSize, const void* data, size_t dataSize) = 0;
+	virtual void OnResourceDestroyed(CommandTrace::RecordType type, uint32_t id) = 0;
+	virtual void OnCommand(const RenderCommand& command, const void* data) = 0;
+	virtual void OnInvalidateState() = 0;
+	virtual void OnFrameBegin() = 0;
+};
+
+// --------------------------------------------------------
+// Render device that records the commands it's given
+//
+// - Without a target it's a null backend: resources are just
+//    Ids, and nothing is drawn, so scene code can run with no
+//    GPU or window
+// - With a target, every call is also passed along to it,
+//    so a real frame can be captured as it's drawn
+// - Commands are recorded after redundant binds are dropped,
+//    so the stream is what the backend actually sees
+// - An attached observer (like the trace capture) is told
+//    about everything, recording or not
+// - Doesn't need Direct3D itself, so it can be tested
+//    anywhere
+// --------------------------------------------------------
+class RecordingRenderDevice : public RenderDevice {
+private:
+	std::shared_ptr<RenderDevice> target;
+	std::vector<RenderCommand> commands;
+	bool recording;
+	std::shared_ptr<IRenderDeviceObserver> observer;
+
+	//Ids handed out when there's no target
+	uint32_t nextId;
+
+	void Record(RenderCommandType type, ShaderStage stage, uint32_t slot, uint32_t handle, uint32_t count, uint32_t start = 0, int32_t baseVertex = 0, const void* data = 0);
+
+protected:
+	void ApplyVertexBuffer(BufferHandle buffer, unsigned int stride) override;
+	void ApplyIndexBuffer(BufferHandle buffer) override;
+	void ApplyConstantBuffer(ShaderStage stage, unsigned int slot, BufferHandle buffer) override;
+	void ApplyShader(ShaderStage stage, ShaderHandle shader) override;
+	void ApplyTexture(ShaderStage stage, unsigned int slot, TextureHandle texture) override;
+	void ApplySampler(ShaderStage stage, unsigned int slot, SamplerHandle sampler) override;
+	void ApplyRasterizerState(RasterizerHandle state) override;
+	void ApplyDepthStencilState(DepthStencilHandle state) override;
+	void ApplyTopology(PrimitiveTopology topology) override;
+	void ApplyUpdateBuffer(BufferHandle buffer, const void* data, unsigned int byteWidth) override;
+	void ApplyDraw(unsigned int vertexCount, unsigned int startVertex) override;
+	void ApplyDrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex) override;
+
+public:
+	//A null target makes this a null backend
+	RecordingRenderDevice(std::shared_ptr<RenderDevice> target = 0);
+	~RecordingRenderDevice();
+
+	//Resources
+	BufferHandle CreateBuffer(const BufferDesc& desc, const void* initialData) override;
+	TextureHandle CreateTexture(const TextureDesc& desc, const void* initialData, unsigned int rowPitch) override;
+	ShaderHandle CreateShader(ShaderStage stage, const void* bytecode, size_t byteCount) override;
+	SamplerHandle CreateSampler(const SamplerDesc& desc) override;
+	RasterizerHandle CreateRasterizerState(const RasterizerDesc& desc) override;
+	DepthStencilHandle CreateDepthStencilState(const DepthStencilDesc& desc) override;
+	void DestroyBuffer(BufferHandle buffer) override;
+	void DestroyTexture(TextureHandle texture) override;
+
+	void InvalidateState() override;
+	void BeginFrame() override;
+
+	//Recording is on from the start
+	void SetRecording(bool recording);
+	bool IsRecording();
+
+	//Commands since the last clear
+	const std::vector<RenderCommand>& GetCommands();
+	void ClearCommands();
+
+	std::shared_ptr<RenderDevice> GetTarget();
+
+	//Attach before creating resources, so traces can include them
+	void SetObserver(std::shared_ptr<IRenderDeviceObserver> observer);
+
+	static const char* GetCommandName(RenderCommandType type);
+};
@@ -0,0 +1,159 @@
+#include "RenderDevice.h"
+
+// An Id no resource ever gets, for state that isn't known
+#define RENDER_DEVICE_UNKNOWN_ID 0xFFFFFFFF
+
+RenderDevice::RenderDevice() {
+	InvalidateState();
+}
+
+RenderDevice::~RenderDevice() {
+}
+
+bool RenderDevice::Changed(bool isDifferent) {
+	if (isDifferent) {
+		stats.StateChanges++;
+	}
+	else {
+		stats.RedundantStateChanges++;
+	}
+
+	return isDifferent;
+}
+
+void RenderDevice::UpdateBuffer(BufferHandle buffer, const void* data, unsigned int byteWidth) {
+	stats.BufferUpdates++;
+	stats.BytesUploaded += byteWidth;
+	ApplyUpdateBuffer(buffer, data, byteWidth);
+}
+
+void RenderDevice::SetVertexBuffer(BufferHandle buffer, unsigned int stride) {
+	if (!Changed(buffer != bound.VertexBuffer || stride != bound.VertexStride)) return;
+
+	bound.VertexBuffer = buffer;
+	bound.VertexStride = stride;
+	ApplyVertexBuffer(buffer, stride);
+}
+
+void RenderDevice::SetIndexBuffer(BufferHandle buffer) {
+	if (!Changed(buffer != bound.IndexBuffer)) return;
+
+	bound.IndexBuffer = buffer;
+	ApplyIndexBuffer(buffer);
+}
+
+void RenderDevice::SetConstantBuffer(ShaderStage stage, unsigned int slot, BufferHandle buffer) {
+	if (slot < RENDER_DEVICE_MAX_SLOTS) {
+		BufferHandle& current = bound.ConstantBuffers[(int)stage][slot];
+		if (!Changed(buffer != current)) return;
+		current = buffer;
+	}
+	else {
+		stats.StateChanges++;
+	}
+
+	ApplyConstantBuffer(stage, slot, buffer);
+}
+
+void RenderDevice::SetShader(ShaderStage stage, ShaderHandle shader) {
+	ShaderHandle& current = bound.Shaders[(int)stage];
+	if (!Changed(shader != current)) return;
+
+	current = shader;
+	ApplyShader(stage, shader);
+}
+
+void RenderDevice::SetTexture(ShaderStage stage, unsigned int slot, TextureHandle texture) {
+	if (slot < RENDER_DEVICE_MAX_SLOTS) {
+		TextureHandle& current = bound.Textures[(int)stage][slot];
+		if (!Changed(texture != current)) return;
+		current = texture;
+	}
+	else {
+		stats.StateChanges++;
+	}
+
+	ApplyTexture(stage, slot, texture);
+}
+
+void RenderDevice::SetSampler(ShaderStage stage, unsigned int slot, SamplerHandle sampler) {
+	if (slot < RENDER_DEVICE_MAX_SLOTS) {
+		SamplerHandle& current = bound.Samplers[(int)stage][slot];
+		if (!Changed(sampler != current)) return;
+		current = sampler;
+	}
+	else {
+		stats.StateChanges++;
+	}
+
+	ApplySampler(stage, slot, sampler);
+}
+
+void RenderDevice::SetRasterizerState(RasterizerHandle state) {
+	if (!Changed(state != bound.Rasterizer)) return;
+
+	bound.Rasterizer = state;
+	ApplyRasterizerState(state);
+}
+
+void RenderDevice::SetDepthStencilState(DepthStencilHandle state) {
+	if (!Changed(state != bound.DepthStencil)) return;
+
+	bound.DepthStencil = state;
+	ApplyDepthStencilState(state);
+}
+
+void RenderDevice::SetTopology(PrimitiveTopology topology) {
+	if (!Changed((int)topology != bound.Topology)) return;
+
+	bound.Topology = (int)topology;
+	ApplyTopology(topology);
+}
+
+void RenderDevice::Draw(unsigned int vertexCount, unsigned int startVertex) {
+	stats.DrawCalls++;
+	stats.Primitives += bound.Topology == (int)PrimitiveTopology::TriangleList ? vertexCount / 3 : vertexCount;
+	ApplyDraw(vertexCount, startVertex);
+}
+
+void RenderDevice::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex) {
+	stats.DrawCalls++;
+	stats.Primitives += bound.Topology == (int)PrimitiveTopology::TriangleList ? indexCount / 3 : indexCount;
+	ApplyDrawIndexed(indexCount, startIndex, baseVertex);
+}
+
+// --------------------------------------------------------
+// Marks every state as unknown
+// --------------------------------------------------------
+void RenderDevice::InvalidateState() {
+	bound.VertexBuffer.Id = RENDER_DEVICE_UNKNOWN_ID;
+	bound.VertexStride = 0;
+	bound.IndexBuffer.Id = RENDER_DEVICE_UNKNOWN_ID;
+	bound.Rasterizer.Id = RENDER_DEVICE_UNKNOWN_ID;
+	bound.DepthStencil.Id = RENDER_DEVICE_UNKNOWN_ID;
+	bound.Topology = -1;
+
+	for (int stage = 0; stage < (int)ShaderStage::Count; stage++) {
+		bound.Shaders[stage].Id = RENDER_DEVICE_UNKNOWN_ID;
+
+		for (int slot = 0; slot < RENDER_DEVICE_MAX_SLOTS; slot++) {
+			bound.ConstantBuffers[stage][slot].Id = RENDER_DEVICE_UNKNOWN_ID;
+			bound.Textures[stage][slot].Id = RENDER_DEVICE_UNKNOWN_ID;
+			bound.Samplers[stage][slot].Id = RENDER_DEVICE_UNKNOWN_ID;
+		}
+	}
+}
+
+void RenderDevice::BeginFrame() {
+	lastFrameStats = stats;
+	stats = RenderDeviceStats();
+	InvalidateState();
+}
+
+const RenderDeviceStats& RenderDevice::GetStats() {
+	return stats;
+}
+
+const RenderDeviceStats& RenderDevice::GetLastFrameStats() {
+	return lastFrameStats;
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Slots per stage the device tracks for redundant binds
+//  - Binds past this still go through, just unfiltered
+#define RENDER_DEVICE_MAX_SLOTS 16
+
+// Declares a typed handle to a device resource
+//  - An Id of 0 is "no resource", and unbinds the slot
+#define RENDER_HANDLE(name) \
+	struct name { \
+		uint32_t Id = 0; \
+		bool IsValid() const { return Id != 0; } \
+		bool operator==(const name& other) const { return Id == other.Id; } \
+		bool operator!=(const name& other) const { return Id != other.Id; } \
+	}
+
+RENDER_HANDLE(BufferHandle);
+RENDER_HANDLE(TextureHandle);
+RENDER_HANDLE(ShaderHandle);
+RENDER_HANDLE(SamplerHandle);
+RENDER_HANDLE(RasterizerHandle);
+RENDER_HANDLE(DepthStencilHandle);
+
+enum class BufferType { Vertex, Index, Constant };
+enum class BufferUsage { Immutable, Dynamic };
+enum class TextureFormat { RGBA8, RGBA16F, R32F };
+enum class ShaderStage { Vertex, Pixel, Compute, Count };
+enum class FilterMode { Point, Linear, Anisotropic };
+enum class AddressMode { Wrap, Clamp };
+enum class CullMode { None, Front, Back };
+enum class CompareFunc { Never, Less, LessEqual, Equal, Greater, Always };
+enum class PrimitiveTopology { TriangleList, TriangleStrip, LineList, PointList };
+
+struct BufferDesc {
+	BufferType Type;
+	BufferUsage Usage;
+	unsigned int ByteWidth;
+};
+
+struct TextureDesc {
+	unsigned int Width;
+	unsigned int Height;
+	TextureFormat Format;
+};
+
+struct SamplerDesc {
+	FilterMode Filter;
+	AddressMode Address;
+	unsigned int MaxAnisotropy;
+};
+
+struct RasterizerDesc {
+	CullMode Cull;
+	int DepthBias;
+	float SlopeScaledDepthBias;
+};
+
+struct DepthStencilDesc {
+	bool DepthEnable;
+	bool DepthWrite;
+	CompareFunc Func;
+};
+
+// --------------------------------------------------------
+// Counts of what a device was asked to do over one frame
+// --------------------------------------------------------
+struct RenderDeviceStats {
+	unsigned int DrawCalls = 0;
+	unsigned int Primitives = 0;
+	unsigned int StateChanges = 0;			// Binds that reached the backend
+	unsigned int RedundantStateChanges = 0;	// Binds dropped as already bound
+	unsigned int BufferUpdates = 0;
+	uint64_t BytesUploaded = 0;
+};
+
+// --------------------------------------------------------
+// Thin interface over the graphics API
+//
+// - Resources are created through the device and referred
+//    to by handles, so code using it needs no API headers
+// - Binds go through the base class first, which drops any
+//    that match what's already bound and keeps the stats,
+//    so every backend filters and counts the same way
+// - Code that binds state behind the device's back (like
+//    SimpleShader or ImGui) must be followed by a call to
+//    InvalidateState(), or binds may be wrongly dropped
+// --------------------------------------------------------
+class RenderDevice {
+private:
+	//What the device believes is bound
+	// - Invalidating fills every handle with an Id no resource has
+	struct BoundState {
+		BufferHandle VertexBuffer;
+		unsigned int VertexStride;
+		BufferHandle IndexBuffer;
+		ShaderHandle Shaders[(int)ShaderStage::Count];
+		BufferHandle ConstantBuffers[(int)ShaderStage::Count][RENDER_DEVICE_MAX_SLOTS];
+		TextureHandle Textures[(int)ShaderStage::Count][RENDER_DEVICE_MAX_SLOTS];
+		SamplerHandle Samplers[(int)ShaderStage::Count][RENDER_DEVICE_MAX_SLOTS];
+		RasterizerHandle Rasterizer;
+		DepthStencilHandle DepthStencil;
+		int Topology;	// -1 when unknown
+	};
+
+	BoundState bound;
+	RenderDeviceStats stats;
+	RenderDeviceStats lastFrameStats;
+
+	//Counts the bind, and returns whether it needs to reach the backend
+	bool Changed(bool isDifferent);
+
+protected:
+	RenderDevice();
+
+	//Backend versions of the binds and draws, only called for changes
+	virtual void ApplyVertexBuffer(BufferHandle buffer, unsigned int stride) = 0;
+	virtual void ApplyIndexBuffer(BufferHandle buffer) = 0;
+	virtual void ApplyConstantBuffer(ShaderStage stage, unsigned int slot, BufferHandle buffer) = 0;
+	virtual void ApplyShader(ShaderStage stage, ShaderHandle shader) = 0;
+	virtual void ApplyTexture(ShaderStage stage, unsigned int slot, TextureHandle texture) = 0;
+	virtual void ApplySampler(ShaderStage stage, unsigned int slot, SamplerHandle sampler) = 0;
+	virtual void ApplyRasterizerState(RasterizerHandle state) = 0;
+	virtual void ApplyDepthStencilState(DepthStencilHandle state) = 0;
+	virtual void ApplyTopology(PrimitiveTopology topology) = 0;
+	virtual void ApplyUpdateBuffer(BufferHandle buffer, const void* data, unsigned int byteWidth) = 0;
+	virtual void ApplyDraw(unsigned int vertexCount, unsigned int startVertex) = 0;
+	virtual void ApplyDrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex) = 0;
+
+public:
+	virtual ~RenderDevice();
+
+	//Resources
+	virtual BufferHandle CreateBuffer(const BufferDesc& desc, const void* initialData) = 0;
+	virtual TextureHandle CreateTexture(const TextureDesc& desc, const void* initialData, unsigned int rowPitch) = 0;
+	virtual ShaderHandle CreateShader(ShaderStage stage, const void* bytecode, size_t byteCount) = 0;
+	virtual SamplerHandle CreateSampler(const SamplerDesc& desc) = 0;
+	virtual RasterizerHandle CreateRasterizerState(const RasterizerDesc& desc) = 0;
+	virtual DepthStencilHandle CreateDepthStencilState(const DepthStencilDesc& desc) = 0;
+	virtual void DestroyBuffer(BufferHandle buffer) = 0;
+	virtual void DestroyTexture(TextureHandle texture) = 0;
+
+	//Replaces the whole contents of a dynamic buffer
+	void UpdateBuffer(BufferHandle buffer, const void* data, unsigned int byteWidth);
+
+	//State
+	void SetVertexBuffer(BufferHandle buffer, unsigned int stride);
+	void SetIndexBuffer(BufferHandle buffer);
+	void SetConstantBuffer(ShaderStage stage, unsigned int slot, BufferHandle buffer);
+	void SetShader(ShaderStage stage, ShaderHandle shader);
+	void SetTexture(ShaderStage stage, unsigned int slot, TextureHandle texture);
+	void SetSampler(ShaderStage stage, unsigned int slot, SamplerHandle sampler);
+	void SetRasterizerState(RasterizerHandle state);
+	void SetDepthStencilState(DepthStencilHandle state);
+	void SetTopology(PrimitiveTopology topology);
+
+	//Draws
+	void Draw(unsigned int vertexCount, unsigned int startVertex = 0);
+	void DrawIndexed(unsigned int indexCount, unsigned int startIndex = 0, int baseVertex = 0);
+
+	//Forgets what's bound, so the next bind of every state goes through
+	virtual void InvalidateState();
+
+	//Starts a new frame of stats, and invalidates the bound state
+	virtual void BeginFrame();
+
+	//Stats for the frame so far, and for the last whole frame
+	const RenderDeviceStats& GetStats();
+	const RenderDeviceStats& GetLastFrameStats();
+};
@@ -0,0 +1,163 @@
+#include "RenderTargetPool.h"
+
+// --------------------------------------------------------
+// Turns the device-free format into D3D11's
+// --------------------------------------------------------
+static DXGI_FORMAT ToDXGIFormat(TextureFormat format) {
+	switch (format) {
+	case TextureFormat::RGBA16F: return DXGI_FORMAT_R16G16B16A16_FLOAT;
+	case TextureFormat::R32F: return DXGI_FORMAT_R32_FLOAT;
+	default: return DXGI_FORMAT_R8G8B8A8_UNORM;
+	}
+}
+
+RenderTargetPool::RenderTargetPool(Microsoft::WRL::ComPtr<ID3D11Device> device, unsigned int screenWidth, unsigned int screenHeight) :
+	device(device),
+	screenWidth(screenWidth),
+	screenHeight(screenHeight),
+	frameIndex(0),
+	allocatedBytes(0),
+	peakAllocatedBytes(0),
+	texturesCreated(0) {
+}
+
+RenderTargetPool::~RenderTargetPool() {
+}
+
+// --------------------------------------------------------
+// Updates the size that screen-relative targets resolve to
+//  - Existing targets are left alone until they age out
+// --------------------------------------------------------
+void RenderTargetPool::SetScreenSize(unsigned int width, unsigned int height) {
+	screenWidth = width;
+	screenHeight = height;
+}
+
+// --------------------------------------------------------
+// Converts a screen-relative description to a pixel size
+// --------------------------------------------------------
+void RenderTargetPool::ResolveSize(const RenderTargetDesc& desc, unsigned int& width, unsigned int& height) {
+	PostProcessSchedule::ResolveSize(desc, screenWidth, screenHeight, width, height);
+}
+
+// --------------------------------------------------------
+// Hands out a free target matching the description, only
+// creating a new texture when none is available
+// --------------------------------------------------------
+std::shared_ptr<PooledRenderTarget> RenderTargetPool::Acquire(const RenderTargetDesc& desc) {
+	unsigned int width, height;
+	ResolveSize(desc, width, height);
+
+	for (auto& target : targets) {
+		if (!target->InUse &&
+			target->Width == width &&
+			target->Height == height &&
+			target->Format == desc.Format &&
+			target->UnorderedAccess == desc.UnorderedAccess) {
+			target->InUse = true;
+			target->LastUsedFrame = frameIndex;
+			return target;
+		}
+	}
+
+	std::shared_ptr<PooledRenderTarget> target = CreateTarget(width, height, desc.Format, desc.UnorderedAccess);
+	target->InUse = true;
+	target->LastUsedFrame = frameIndex;
+	targets.push_back(target);
+	return target;
+}
+
+// --------------------------------------------------------
+// Returns a target to the pool so a later pass can reuse it
+// --------------------------------------------------------
+void RenderTargetPool::Release(std::shared_ptr<PooledRenderTarget> target) {
+	if (target) {
+		target->InUse = false;
+	}
+}
+
+// --------------------------------------------------------
+// Advances the frame and frees any target that has sat
+// unused for too long (such as those from before a resize)
+// --------------------------------------------------------
+void RenderTargetPool::EndFrame(unsigned int maxUnusedFrames) {
+	for (size_t i = 0; i < targets.size();) {
+		std::shared_ptr<PooledRenderTarget>& target = targets[i];
+
+		if (!target->InUse && frameIndex - target->LastUsedFrame > maxUnusedFrames) {
+			allocatedBytes -= target->Width * target->Height * PostProcessSchedule::BytesPerPixel(target->Format);
+
+			//Swap and pop, since order doesn't matter
+			targets[i] = targets.back();
+			targets.pop_back();
+			continue;
+		}
+
+		i++;
+	}
+
+	frameIndex++;
+}
+
+// --------------------------------------------------------
+// Creates the texture and its views
+// --------------------------------------------------------
+std::shared_ptr<PooledRenderTarget> RenderTargetPool::CreateTarget(unsigned int width, unsigned int height, TextureFormat format, bool unorderedAccess) {
+	std::shared_ptr<PooledRenderTarget> target = std::make_shared<PooledRenderTarget>();
+	target->Width = width;
+	target->Height = height;
+	target->Format = format;
+	target->UnorderedAccess = unorderedAccess;
+
+	// Describe the texture we're creating
+	D3D11_TEXTURE2D_DESC textureDesc = {};
+	textureDesc.Width = width;
+	textureDesc.Height = height;
+	textureDesc.ArraySize = 1;
+	textureDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+	textureDesc.CPUAccessFlags = 0;
+	textureDesc.Format = ToDXGIFormat(format);
+	textureDesc.MipLevels = 1;
+	textureDesc.MiscFlags = 0;
+	textureDesc.SampleDesc.Count = 1;
+	textureDesc.SampleDesc.Quality = 0;
+	textureDesc.Usage = D3D11_USAGE_DEFAULT;
+
+	if (unorderedAccess) {
+		textureDesc.BindFlags |= D3D11_BIND_UNORDERED_ACCESS;
+	}
+
+	device->CreateTexture2D(&textureDesc, 0, target->Texture.GetAddressOf());
+
+	// Default views have access to the entire resource
+	device->CreateRenderTargetView(target->Texture.Get(), 0, target->RTV.GetAddressOf());
+	device->CreateShaderResourceView(target->Texture.Get(), 0, target->SRV.GetAddressOf());
+
+	if (unorderedAccess) {
+		device->CreateUnorderedAccessView(target->Texture.Get(), 0, target->UAV.GetAddressOf());
+	}
+
+	allocatedBytes += width * height * PostProcessSchedule::BytesPerPixel(format);
+	if (allocatedBytes > peakAllocatedBytes) {
+		peakAllocatedBytes = allocatedBytes;
+	}
+	texturesCreated++;
+
+	return target;
+}
+
+size_t RenderTargetPool::GetAllocatedBytes() {
+	return allocatedBytes;
+}
+
+size_t RenderTargetPool::GetPeakAllocatedBytes() {
+	return peakAllocatedBytes;
+}
+
+unsigned int RenderTargetPool::GetTextureCount() {
+	return (unsigned int)targets.size();
+}
+
+unsigned int RenderTargetPool::GetTexturesCreated() {
+	return texturesCreated;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h> // Used for ComPtr - a smart pointer for COM objects
+
+#include <memory>
+#include <vector>
+
+#include "PostProcessSchedule.h"
+
+// --------------------------------------------------------
+// A texture handed out by the pool, with every view the
+// post processes might need
+// --------------------------------------------------------
+struct PooledRenderTarget {
+	unsigned int Width = 0;
+	unsigned int Height = 0;
+	TextureFormat Format = TextureFormat::RGBA8;
+	bool UnorderedAccess = false;
+
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> Texture;
+	Microsoft::WRL::ComPtr<ID3D11RenderTargetView> RTV;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> SRV;
+	Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> UAV;
+
+	bool InUse = false;
+	unsigned int LastUsedFrame = 0;
+};
+
+// --------------------------------------------------------
+// Pool of transient render targets
+//
+// - Targets are matched by size, format and views, so two
+//    passes that never overlap share the same texture
+// - Resizing doesn't recreate anything. Targets for the old
+//    size simply stop matching and are freed once they have
+//    gone unused for a few frames
+// --------------------------------------------------------
+class RenderTargetPool {
+private:
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+
+	std::vector<std::shared_ptr<PooledRenderTarget>> targets;
+
+	unsigned int screenWidth;
+	unsigned int screenHeight;
+	unsigned int frameIndex;
+
+	size_t allocatedBytes;
+	size_t peakAllocatedBytes;
+	unsigned int texturesCreated;
+
+	std::shared_ptr<PooledRenderTarget> CreateTarget(unsigned int width, unsigned int height, TextureFormat format, bool unorderedAccess);
+
+public:
+	RenderTargetPool(Microsoft::WRL::ComPtr<ID3D11Device> device, unsigned int screenWidth, unsigned int screenHeight);
+	~RenderTargetPool();
+
+	void SetScreenSize(unsigned int width, unsigned int height);
+	void ResolveSize(const RenderTargetDesc& desc, unsigned int& width, unsigned int& height);
+
+	std::shared_ptr<PooledRenderTarget> Acquire(const RenderTargetDesc& desc);
+	void Release(std::shared_ptr<PooledRenderTarget> target);
+
+	//Frees targets that haven't been used in the given number of frames
+	void EndFrame(unsigned int maxUnusedFrames = 3);
+
+	size_t GetAllocatedBytes();
+	size_t GetPeakAllocatedBytes();
+	unsigned int GetTextureCount();
+	unsigned int GetTexturesCreated();
+};
@@ -0,0 +1,92 @@
+#include "RotationMath.h"
+
+#include <algorithm>
+#include <cmath>
+
+void RotationMath::FromPitchYawRoll(float pitch, float yaw, float roll, float q[4]) {
+	float sp = std::sin(pitch * 0.5f), cp = std::cos(pitch * 0.5f);
+	float sy = std::sin(yaw * 0.5f), cy = std::cos(yaw * 0.5f);
+	float sr = std::sin(roll * 0.5f), cr = std::cos(roll * 0.5f);
+
+	q[0] = sp * cy * cr + cp * sy * sr;
+	q[1] = cp * sy * cr - sp * cy * sr;
+	q[2] = cp * cy * sr - sp * sy * cr;
+	q[3] = cp * cy * cr + sp * sy * sr;
+}
+
+void RotationMath::FromAxisAngle(const float axis[3], float angle, float q[4]) {
+	float s = std::sin(angle * 0.5f);
+	q[0] = axis[0] * s;
+	q[1] = axis[1] * s;
+	q[2] = axis[2] * s;
+	q[3] = std::cos(angle * 0.5f);
+}
+
+// --------------------------------------------------------
+// The product b * a, so a's rotation happens first
+// --------------------------------------------------------
+void RotationMath::Multiply(const float a[4], const float b[4], float q[4]) {
+	float x = b[3] * a[0] + b[0] * a[3] + b[1] * a[2] - b[2] * a[1];
+	float y = b[3] * a[1] - b[0] * a[2] + b[1] * a[3] + b[2] * a[0];
+	float z = b[3] * a[2] + b[0] * a[1] - b[1] * a[0] + b[2] * a[3];
+	float w = b[3] * a[3] - b[0] * a[0] - b[1] * a[1] - b[2] * a[2];
+
+	q[0] = x;
+	q[1] = y;
+	q[2] = z;
+	q[3] = w;
+}
+
+float RotationMath::Length(const float q[4]) {
+	return std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+}
+
+void RotationMath::Normalize(float q[4]) {
+	float length = Length(q);
+	if (length <= 0.0f) return;
+
+	for (int i = 0; i < 4; i++) q[i] /= length;
+}
+
+void RotationMath::Rotate(float q[4], float pitch, float yaw, float roll) {
+	static const float worldUp[3] = { 0.0f, 1.0f, 0.0f };
+
+	float local[4], around[4];
+	FromPitchYawRoll(pitch, 0.0f, roll, local);
+	FromAxisAngle(worldUp, yaw, around);
+
+	Multiply(local, q, q);
+	Multiply(q, around, q);
+	Normalize(q);
+}
+
+void RotationMath::ToBasis(const float q[4], float right[3], float up[3], float forward[3]) {
+	float x = q[0], y = q[1], z = q[2], w = q[3];
+
+	right[0] = 1.0f - 2.0f * (y * y + z * z);
+	right[1] = 2.0f * (x * y + z * w);
+	right[2] = 2.0f * (x * z - y * w);
+
+	up[0] = 2.0f * (x * y - z * w);
+	up[1] = 1.0f - 2.0f * (x * x + z * z);
+	up[2] = 2.0f * (y * z + x * w);
+
+	forward[0] = 2.0f * (x * z + y * w);
+	forward[1] = 2.0f * (y * z - x * w);
+	forward[2] = 1.0f - 2.0f * (x * x + y * y);
+}
+
+float RotationMath::BasisError(const float right[3], const float up[3], const float forward[3]) {
+	const float* axes[3] = { right, up, forward };
+	float error = 0.0f;
+
+	for (int a = 0; a < 3; a++) {
+		const float* axis = axes[a];
+		const float* next = axes[(a + 1) % 3];
+		float length = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+		float dot = axis[0] * next[0] + axis[1] * next[1] + axis[2] * next[2];
+		error = (std::max)(error, (std::max)(std::fabs(length - 1.0f), std::fabs(dot)));
+	}
+
+	return error;
+}
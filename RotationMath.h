@@ -0,0 +1,37 @@
+#pragma once
+
+// --------------------------------------------------------
+// Quaternion math behind Transform's rotations, without
+// DirectXMath, so it can be tested anywhere
+//
+// - Quaternions are x, y, z, w, the same as an XMFLOAT4,
+//    and each function gives what its DirectXMath namesake
+//    does
+// - Bases are the rotation matrix's rows: right, up and
+//    forward
+// --------------------------------------------------------
+namespace RotationMath {
+	//XMQuaternionRotationRollPitchYaw(): roll, then pitch, then yaw
+	void FromPitchYawRoll(float pitch, float yaw, float roll, float q[4]);
+
+	//XMQuaternionRotationNormal(), for a unit axis
+	void FromAxisAngle(const float axis[3], float angle, float q[4]);
+
+	//XMQuaternionMultiply(): a's rotation, then b's
+	void Multiply(const float a[4], const float b[4], float q[4]);
+
+	float Length(const float q[4]);
+	void Normalize(float q[4]);
+
+	//Turns q the way Transform::Rotate() does
+	// - Pitch and roll around its own axes, yaw around the
+	//    world's up, then renormalized
+	void Rotate(float q[4], float pitch, float yaw, float roll);
+
+	//Rows of XMMatrixRotationQuaternion()
+	void ToBasis(const float q[4], float right[3], float up[3], float forward[3]);
+
+	//How far a basis is from orthonormal, as the largest of any
+	//axis' length off one and any two axes' dot product
+	float BasisError(const float right[3], const float up[3], const float forward[3]);
+}
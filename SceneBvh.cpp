@@ -0,0 +1,734 @@
+#include "SceneBvh.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static SceneBvhBox EmptyBox() {
+	SceneBvhBox box = { { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+	return box;
+}
+
+static void Grow(SceneBvhBox& box, const SceneBvhBox& other) {
+	for (int a = 0; a < 3; a++) {
+		box.Min[a] = (std::min)(box.Min[a], other.Min[a]);
+		box.Max[a] = (std::max)(box.Max[a], other.Max[a]);
+	}
+}
+
+//Half the surface area, which is all SAH needs as it only compares them
+static float SurfaceArea(const SceneBvhBox& box) {
+	float x = (std::max)(box.Max[0] - box.Min[0], 0.0f);
+	float y = (std::max)(box.Max[1] - box.Min[1], 0.0f);
+	float z = (std::max)(box.Max[2] - box.Min[2], 0.0f);
+	return x * y + y * z + z * x;
+}
+
+static SceneBvhBox GetItemBox(const BoundsStreams& bounds, size_t index) {
+	SceneBvhBox box = { {
+		bounds.CenterX[index] - bounds.ExtentX[index],
+		bounds.CenterY[index] - bounds.ExtentY[index],
+		bounds.CenterZ[index] - bounds.ExtentZ[index] }, {
+		bounds.CenterX[index] + bounds.ExtentX[index],
+		bounds.CenterY[index] + bounds.ExtentY[index],
+		bounds.CenterZ[index] + bounds.ExtentZ[index] } };
+	return box;
+}
+
+// --------------------------------------------------------
+// Which side of a frustum's planes a box is on
+//  - 0 is outside, 1 crosses at least one plane, and 2 is
+//     inside every plane
+// --------------------------------------------------------
+static int ClassifyBox(const SceneBvhFrustum& frustum, const SceneBvhBox& box) {
+	float center[3], extent[3];
+	for (int a = 0; a < 3; a++) {
+		center[a] = (box.Min[a] + box.Max[a]) * 0.5f;
+		extent[a] = (box.Max[a] - box.Min[a]) * 0.5f;
+	}
+
+	bool inside = true;
+	for (int p = 0; p < 6; p++) {
+		const float* plane = frustum.Planes[p];
+		float distance = plane[0] * center[0] + plane[1] * center[1] + plane[2] * center[2] + plane[3];
+		float radius = std::fabs(plane[0]) * extent[0] + std::fabs(plane[1]) * extent[1] + std::fabs(plane[2]) * extent[2];
+
+		if (distance + radius < 0.0f) return 0;
+		if (distance - radius < 0.0f) inside = false;
+	}
+
+	return inside ? 2 : 1;
+}
+
+static bool IntersectSphereBox(const SceneBvhSphere& sphere, const SceneBvhBox& box) {
+	float distanceSquared = 0.0f;
+	for (int a = 0; a < 3; a++) {
+		float closest = (std::max)(box.Min[a], (std::min)(sphere.Center[a], box.Max[a]));
+		float d = sphere.Center[a] - closest;
+		distanceSquared += d * d;
+	}
+
+	return distanceSquared <= sphere.Radius * sphere.Radius;
+}
+
+// --------------------------------------------------------
+// Runs a batch of queries over the job system
+//  - Each chunk of queries fills its own list, and then the
+//     lists are joined, moving each query's range along
+// --------------------------------------------------------
+template<typename Result, typename Query>
+static void RunBatch(size_t count, std::vector<Result>& results, std::vector<SceneBvhRange>& ranges, Query query) {
+	results.clear();
+	ranges.resize(count);
+	if (count == 0) return;
+
+	std::vector<std::vector<Result>> chunks((count + SCENE_BVH_QUERY_GRAIN - 1) / SCENE_BVH_QUERY_GRAIN);
+	JobSystem::GetInstance().ParallelFor(count, SCENE_BVH_QUERY_GRAIN, [&](size_t begin, size_t end) {
+		std::vector<Result>& chunk = chunks[begin / SCENE_BVH_QUERY_GRAIN];
+		for (size_t i = begin; i < end; i++) {
+			size_t first = chunk.size();
+			query(i, chunk);
+			ranges[i].Offset = (uint32_t)first;
+			ranges[i].Count = (uint32_t)(chunk.size() - first);
+		}
+	});
+
+	size_t total = 0;
+	for (auto& chunk : chunks) total += chunk.size();
+	results.reserve(total);
+
+	for (size_t c = 0; c < chunks.size(); c++) {
+		uint32_t offset = (uint32_t)results.size();
+		size_t end = (std::min)((c + 1) * SCENE_BVH_QUERY_GRAIN, count);
+		for (size_t i = c * SCENE_BVH_QUERY_GRAIN; i < end; i++) ranges[i].Offset += offset;
+
+		results.insert(results.end(), chunks[c].begin(), chunks[c].end());
+	}
+}
+
+SceneBvh::SceneBvh() :
+	treeItemCount(0),
+	itemCount(0),
+	leafCount(0),
+	depth(0),
+	builtCost(0.0f),
+	cost(0.0f),
+	rebuildCount(0),
+	buildMilliseconds(0.0),
+	refitMilliseconds(0.0) {
+}
+
+SceneBvh::~SceneBvh() {
+	//The rebuild finishes our counter
+	if (pendingBuild) JobSystem::GetInstance().Wait(rebuildCounter);
+}
+
+// --------------------------------------------------------
+// Splits the items top down, where binned SAH says is best
+//  - Centers are sorted into buckets along each axis, and
+//     the split between buckets with the least surface area
+//     times items on either side wins
+//  - Items with identical centers can't be bucketed, so
+//     they're just split in half
+//  - Each leaf's items end up side by side in the list
+// --------------------------------------------------------
+void SceneBvh::BuildTree(const BoundsStreams& bounds, size_t leafSize, std::vector<SceneBvhNode>& nodes, std::vector<uint32_t>& items) {
+	size_t count = bounds.GetCount();
+	nodes.clear();
+	items.resize(count);
+	if (count == 0) return;
+
+	//Each item's box and center travel with it as it's partitioned,
+	//so every level reads them in order
+	struct BuildItem {
+		SceneBvhBox Box;
+		float Center[3];
+		uint32_t Index;
+	};
+
+	std::vector<BuildItem> buildItems(count);
+	for (size_t i = 0; i < count; i++) {
+		buildItems[i].Box = GetItemBox(bounds, i);
+		buildItems[i].Center[0] = bounds.CenterX[i];
+		buildItems[i].Center[1] = bounds.CenterY[i];
+		buildItems[i].Center[2] = bounds.CenterZ[i];
+		buildItems[i].Index = (uint32_t)i;
+	}
+
+	struct Range {
+		uint32_t Node;
+		uint32_t First;
+		uint32_t Count;
+	};
+
+	nodes.reserve(count / leafSize * 2 + 1);
+	nodes.push_back(SceneBvhNode());
+	std::vector<Range> open(1, Range{ 0, 0, (uint32_t)count });
+
+	while (!open.empty()) {
+		Range range = open.back();
+		open.pop_back();
+
+		BuildItem* first = &buildItems[range.First];
+		BuildItem* last = first + range.Count;
+
+		SceneBvhBox box = EmptyBox();
+		SceneBvhBox centerBox = EmptyBox();
+		for (BuildItem* item = first; item != last; item++) {
+			Grow(box, item->Box);
+			for (int a = 0; a < 3; a++) {
+				centerBox.Min[a] = (std::min)(centerBox.Min[a], item->Center[a]);
+				centerBox.Max[a] = (std::max)(centerBox.Max[a], item->Center[a]);
+			}
+		}
+		nodes[range.Node].Bounds = box;
+
+		if (range.Count <= leafSize) {
+			nodes[range.Node].Index = range.First;
+			nodes[range.Node].Count = range.Count;
+			continue;
+		}
+
+		//Find the cheapest split between buckets on any axis
+		int bestAxis = -1;
+		int bestBin = 0;
+		float bestCost = FLT_MAX;
+		float binScale[3] = {};
+
+		for (int axis = 0; axis < 3; axis++) {
+			float extent = centerBox.Max[axis] - centerBox.Min[axis];
+			if (extent <= 0.0f) continue;
+			binScale[axis] = SCENE_BVH_BINS * 0.9999f / extent;
+
+			SceneBvhBox binBoxes[SCENE_BVH_BINS];
+			uint32_t binCounts[SCENE_BVH_BINS] = {};
+			for (int b = 0; b < SCENE_BVH_BINS; b++) binBoxes[b] = EmptyBox();
+
+			for (BuildItem* item = first; item != last; item++) {
+				int b = (std::min)((int)((item->Center[axis] - centerBox.Min[axis]) * binScale[axis]), SCENE_BVH_BINS - 1);
+				binCounts[b]++;
+				Grow(binBoxes[b], item->Box);
+			}
+
+			//Everything right of each split, swept from the far end
+			float rightAreas[SCENE_BVH_BINS] = {};
+			uint32_t rightCounts[SCENE_BVH_BINS] = {};
+			SceneBvhBox right = EmptyBox();
+			uint32_t rightCount = 0;
+			for (int b = SCENE_BVH_BINS - 1; b > 0; b--) {
+				Grow(right, binBoxes[b]);
+				rightCount += binCounts[b];
+				rightAreas[b] = SurfaceArea(right);
+				rightCounts[b] = rightCount;
+			}
+
+			SceneBvhBox left = EmptyBox();
+			uint32_t leftCount = 0;
+			for (int b = 0; b < SCENE_BVH_BINS - 1; b++) {
+				Grow(left, binBoxes[b]);
+				leftCount += binCounts[b];
+				if (leftCount == 0 || rightCounts[b + 1] == 0) continue;
+
+				float splitCost = SurfaceArea(left) * leftCount + rightAreas[b + 1] * rightCounts[b + 1];
+				if (splitCost < bestCost) {
+					bestCost = splitCost;
+					bestAxis = axis;
+					bestBin = b + 1;
+				}
+			}
+		}
+
+		uint32_t leftCount = range.Count / 2;
+		if (bestAxis >= 0) {
+			float minimum = centerBox.Min[bestAxis];
+			float scale = binScale[bestAxis];
+			BuildItem* middle = std::partition(first, last, [&](const BuildItem& item) {
+				return (std::min)((int)((item.Center[bestAxis] - minimum) * scale), SCENE_BVH_BINS - 1) < bestBin;
+			});
+			leftCount = (uint32_t)(middle - first);
+		}
+
+		uint32_t left = (uint32_t)nodes.size();
+		nodes[range.Node].Index = left;
+		nodes[range.Node].Count = 0;
+		nodes.push_back(SceneBvhNode());
+		nodes.push_back(SceneBvhNode());
+
+		open.push_back(Range{ left + 1, range.First + leftCount, range.Count - leftCount });
+		open.push_back(Range{ left, range.First, leftCount });
+	}
+
+	for (size_t i = 0; i < count; i++) items[i] = buildItems[i].Index;
+}
+
+// --------------------------------------------------------
+// Fits every node to the items' current boxes
+//  - Boxes are read in item order and written to their
+//     slots, then leaves are grown from their own run of
+//     slots, both spread over the job system
+//  - Parents are then grown from their children, walking
+//     backwards
+//  - The SAH cost comes out on the way: each node's area
+//     for visiting it, and a leaf's area again for each of
+//     its items, relative to the root
+// --------------------------------------------------------
+void SceneBvh::Refit(const BoundsStreams& bounds) {
+	itemBoxes.resize(itemCount);
+
+	JobSystem::GetInstance().ParallelFor(itemCount, SCENE_BVH_REFIT_GRAIN, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) itemBoxes[slots[i]] = GetItemBox(bounds, i);
+	});
+
+	JobSystem::GetInstance().ParallelFor(nodes.size(), SCENE_BVH_REFIT_GRAIN, [&](size_t begin, size_t end) {
+		for (size_t n = begin; n < end; n++) {
+			SceneBvhNode& node = nodes[n];
+			if (node.Count == 0) continue;
+
+			SceneBvhBox box = EmptyBox();
+			for (uint32_t slot = node.Index; slot < node.Index + node.Count; slot++) Grow(box, itemBoxes[slot]);
+			node.Bounds = box;
+		}
+	});
+
+	float areaSum = 0.0f;
+	leafCount = 0;
+	for (size_t n = nodes.size(); n-- > 0;) {
+		SceneBvhNode& node = nodes[n];
+		if (node.Count == 0) {
+			node.Bounds = nodes[node.Index].Bounds;
+			Grow(node.Bounds, nodes[node.Index + 1].Bounds);
+			areaSum += SurfaceArea(node.Bounds);
+		}
+		else {
+			areaSum += SurfaceArea(node.Bounds) * (1.0f + node.Count);
+			leafCount++;
+		}
+	}
+
+	float rootArea = nodes.empty() ? 0.0f : SurfaceArea(nodes[0].Bounds);
+	cost = rootArea > 0.0f ? areaSum / rootArea : 0.0f;
+}
+
+// --------------------------------------------------------
+// Levels below the root
+//  - Children always come after their parent, so one pass
+//     forward reaches each parent before its children
+// --------------------------------------------------------
+uint32_t SceneBvh::FindDepth(const std::vector<SceneBvhNode>& nodes) {
+	std::vector<uint32_t> levels(nodes.size());
+	uint32_t depth = 0;
+
+	for (size_t n = 0; n < nodes.size(); n++) {
+		if (nodes[n].Count > 0) continue;
+
+		uint32_t level = levels[n] + 1;
+		levels[nodes[n].Index] = levels[nodes[n].Index + 1] = level;
+		depth = (std::max)(depth, level);
+	}
+
+	return depth;
+}
+
+// --------------------------------------------------------
+// Lists each item's slot, the other way round from items,
+// with anything past the tree in a slot of its own
+// --------------------------------------------------------
+void SceneBvh::UpdateSlots() {
+	items.resize(itemCount);
+	slots.resize(itemCount);
+	for (size_t slot = treeItemCount; slot < itemCount; slot++) items[slot] = (uint32_t)slot;
+	for (size_t slot = 0; slot < itemCount; slot++) slots[items[slot]] = (uint32_t)slot;
+}
+
+void SceneBvh::Build(const BoundsStreams& bounds) {
+	Clock::time_point start = Clock::now();
+
+	BuildTree(bounds, SCENE_BVH_LEAF_SIZE, nodes, items);
+	depth = FindDepth(nodes);
+	treeItemCount = itemCount = bounds.GetCount();
+	UpdateSlots();
+	Refit(bounds);
+	builtCost = cost;
+
+	buildMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// --------------------------------------------------------
+// Copies the bounds and builds a new tree from them on a
+// worker, leaving the current tree to be refitted and
+// queried until it's done
+//  - Without any workers nothing would pick it up, so it's
+//     built right away instead
+// --------------------------------------------------------
+void SceneBvh::StartRebuild(const BoundsStreams& bounds) {
+	if (JobSystem::GetInstance().GetThreadCount() <= 1) {
+		Build(bounds);
+		rebuildCount++;
+		return;
+	}
+
+	pendingBuild = std::make_shared<PendingBuild>();
+	pendingBuild->Bounds = bounds;
+
+	std::shared_ptr<PendingBuild> build = pendingBuild;
+	JobSystem::GetInstance().Run([build]() {
+		Clock::time_point start = Clock::now();
+		BuildTree(build->Bounds, SCENE_BVH_LEAF_SIZE, build->Nodes, build->Items);
+		build->Depth = FindDepth(build->Nodes);
+		build->Milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}, &rebuildCounter);
+}
+
+void SceneBvh::Update(const BoundsStreams& bounds) {
+	size_t count = bounds.GetCount();
+	bool rebuilt = false;
+
+	//Swap in a finished rebuild, unless items it covers have since gone
+	if (pendingBuild && rebuildCounter.IsDone()) {
+		if (pendingBuild->Bounds.GetCount() <= count) {
+			nodes.swap(pendingBuild->Nodes);
+			items.swap(pendingBuild->Items);
+			depth = pendingBuild->Depth;
+			treeItemCount = pendingBuild->Bounds.GetCount();
+			buildMilliseconds = pendingBuild->Milliseconds;
+			rebuildCount++;
+			rebuilt = true;
+		}
+		pendingBuild.reset();
+	}
+
+	//Nothing to refit, or the tree holds items that are gone
+	if (treeItemCount == 0 || count < treeItemCount) {
+		Build(bounds);
+		return;
+	}
+
+	Clock::time_point start = Clock::now();
+
+	//Anything past the tree's items is checked one by one
+	if (rebuilt || count != itemCount) {
+		itemCount = count;
+		UpdateSlots();
+	}
+
+	Refit(bounds);
+	if (rebuilt) builtCost = cost;
+
+	refitMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	if (!pendingBuild && (count > treeItemCount || cost > builtCost * SCENE_BVH_REBUILD_RATIO)) {
+		StartRebuild(bounds);
+	}
+}
+
+template<typename Visit>
+void SceneBvh::VisitFrustum(const SceneBvhFrustum& frustum, Visit visit) const {
+	//Nodes to visit, with the top bit set once they're known to be inside
+	const uint32_t inside = 0x80000000u;
+	SceneBvhStack<uint32_t> open(depth);
+
+	if (!nodes.empty()) open.Push(0);
+	while (!open.IsEmpty()) {
+		uint32_t entry = open.Pop();
+
+		const SceneBvhNode& node = nodes[entry & ~inside];
+		bool nodeInside = (entry & inside) != 0;
+		if (!nodeInside) {
+			int side = ClassifyBox(frustum, node.Bounds);
+			if (side == 0) continue;
+			nodeInside = side == 2;
+		}
+
+		if (node.Count == 0) {
+			uint32_t flag = nodeInside ? inside : 0;
+			open.Push((node.Index + 1) | flag);
+			open.Push(node.Index | flag);
+			continue;
+		}
+
+		for (uint32_t slot = node.Index; slot < node.Index + node.Count; slot++) {
+			if (nodeInside || ClassifyBox(frustum, itemBoxes[slot]) != 0) visit(slot);
+		}
+	}
+
+	for (uint32_t slot = (uint32_t)treeItemCount; slot < itemCount; slot++) {
+		if (ClassifyBox(frustum, itemBoxes[slot]) != 0) visit(slot);
+	}
+}
+
+template<typename Test, typename Visit>
+void SceneBvh::VisitBoxes(Test test, Visit visit) const {
+	SceneBvhStack<uint32_t> open(depth);
+
+	if (!nodes.empty()) open.Push(0);
+	while (!open.IsEmpty()) {
+		const SceneBvhNode& node = nodes[open.Pop()];
+
+		float distance;
+		if (!test(node.Bounds, distance)) continue;
+
+		if (node.Count == 0) {
+			open.Push(node.Index + 1);
+			open.Push(node.Index);
+			continue;
+		}
+
+		for (uint32_t slot = node.Index; slot < node.Index + node.Count; slot++) {
+			if (test(itemBoxes[slot], distance)) visit(slot, distance);
+		}
+	}
+
+	for (uint32_t slot = (uint32_t)treeItemCount; slot < itemCount; slot++) {
+		float distance;
+		if (test(itemBoxes[slot], distance)) visit(slot, distance);
+	}
+}
+
+void SceneBvh::QueryFrustum(const SceneBvhFrustum& frustum, std::vector<uint32_t>& results) const {
+	VisitFrustum(frustum, [&](uint32_t slot) { results.push_back(items[slot]); });
+}
+
+void SceneBvh::QuerySphere(const SceneBvhSphere& sphere, std::vector<uint32_t>& results) const {
+	VisitBoxes(
+		[&](const SceneBvhBox& box, float&) { return IntersectSphereBox(sphere, box); },
+		[&](uint32_t slot, float) { results.push_back(items[slot]); });
+}
+
+void SceneBvh::QueryRay(const SceneBvhRay& ray, std::vector<SceneBvhHit>& results) const {
+	float inverseDirection[3] = { 1.0f / ray.Direction[0], 1.0f / ray.Direction[1], 1.0f / ray.Direction[2] };
+
+	size_t first = results.size();
+	VisitBoxes(
+		[&](const SceneBvhBox& box, float& distance) { return IntersectRay(ray, inverseDirection, box, distance); },
+		[&](uint32_t slot, float distance) { results.push_back(SceneBvhHit{ items[slot], distance }); });
+
+	std::sort(results.begin() + first, results.end(), [](const SceneBvhHit& a, const SceneBvhHit& b) {
+		return a.Distance < b.Distance || (a.Distance == b.Distance && a.Item < b.Item);
+	});
+}
+
+void SceneBvh::QueryFrustums(const SceneBvhFrustum* frustums, size_t count, SceneBvhResults& results) const {
+	RunBatch(count, results.Items, results.Ranges, [&](size_t i, std::vector<uint32_t>& out) { QueryFrustum(frustums[i], out); });
+}
+
+void SceneBvh::QuerySpheres(const SceneBvhSphere* spheres, size_t count, SceneBvhResults& results) const {
+	RunBatch(count, results.Items, results.Ranges, [&](size_t i, std::vector<uint32_t>& out) { QuerySphere(spheres[i], out); });
+}
+
+void SceneBvh::QueryRays(const SceneBvhRay* rays, size_t count, SceneBvhRayResults& results) const {
+	RunBatch(count, results.Hits, results.Ranges, [&](size_t i, std::vector<SceneBvhHit>& out) { QueryRay(rays[i], out); });
+}
+
+// --------------------------------------------------------
+// Pulls the clip planes out of a view projection matrix
+//  - With row vectors, clip space is the position times
+//     each column, so each plane is a sum of columns
+// --------------------------------------------------------
+SceneBvhFrustum SceneBvh::GetFrustum(const float viewProjection[16]) {
+	const float* m = viewProjection;
+	float columns[4][4];
+	for (int c = 0; c < 4; c++) {
+		for (int r = 0; r < 4; r++) columns[c][r] = m[r * 4 + c];
+	}
+
+	//Left, right, bottom, top, near and far
+	const int axes[6] = { 0, 0, 1, 1, 2, 2 };
+	const float signs[6] = { 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f };
+
+	SceneBvhFrustum frustum;
+	for (int p = 0; p < 6; p++) {
+		//Depth goes from 0 not -w, so the near plane is just z >= 0
+		float w = p == 4 ? 0.0f : 1.0f;
+		for (int i = 0; i < 4; i++) {
+			frustum.Planes[p][i] = columns[3][i] * w + columns[axes[p]][i] * signs[p];
+		}
+
+		float length = std::sqrt(frustum.Planes[p][0] * frustum.Planes[p][0] + frustum.Planes[p][1] * frustum.Planes[p][1] + frustum.Planes[p][2] * frustum.Planes[p][2]);
+		if (length > 0.0f) {
+			for (int i = 0; i < 4; i++) frustum.Planes[p][i] /= length;
+		}
+	}
+
+	return frustum;
+}
+
+// --------------------------------------------------------
+// Scatters boxes through a cube, about two units apart,
+// then times the tree against them
+//  - Frustums are boxes a tenth of the cube across, spheres
+//     a few units wide and rays a quarter of the cube long,
+//     all from the middle of the scene outwards
+//  - The first few queries of each kind are also answered
+//     by testing every item, and any difference counts as a
+//     mismatch
+// --------------------------------------------------------
+SceneBvhMeasurement SceneBvh::Measure(size_t itemCount, unsigned int queryCount) {
+	SceneBvhMeasurement measurement;
+	measurement.Items = itemCount;
+	measurement.Queries = queryCount;
+	if (itemCount == 0 || queryCount == 0) return measurement;
+
+	std::mt19937 random(1234);
+	float size = std::cbrt((float)itemCount) * 2.0f;
+	std::uniform_real_distribution<float> position(-size * 0.5f, size * 0.5f);
+	std::uniform_real_distribution<float> extent(0.1f, 1.0f);
+	std::uniform_real_distribution<float> jitter(-0.5f, 0.5f);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	BoundsStreams bounds;
+	bounds.Resize(itemCount);
+	for (size_t i = 0; i < itemCount; i++) {
+		float center[3] = { position(random), position(random), position(random) };
+		float extents[3] = { extent(random), extent(random), extent(random) };
+		bounds.Set(i, center, extents);
+	}
+
+	SceneBvh bvh;
+	bvh.Build(bounds);
+	measurement.BuildMilliseconds = bvh.GetBuildMilliseconds();
+
+	//Everything moves a little, like a frame of simulation
+	for (size_t i = 0; i < itemCount; i++) {
+		bounds.CenterX[i] += jitter(random);
+		bounds.CenterY[i] += jitter(random);
+		bounds.CenterZ[i] += jitter(random);
+	}
+
+	Clock::time_point start = Clock::now();
+	bvh.Refit(bounds);
+	measurement.RefitMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	measurement.RefitCostRatio = bvh.GetCostRatio();
+
+	std::vector<SceneBvhFrustum> frustums(queryCount);
+	std::vector<SceneBvhSphere> spheres(queryCount);
+	std::vector<SceneBvhRay> rays(queryCount);
+	std::uniform_real_distribution<float> inner(-size * 0.4f, size * 0.4f);
+	std::uniform_real_distribution<float> radius(1.0f, 4.0f);
+
+	for (unsigned int q = 0; q < queryCount; q++) {
+		float center[3] = { inner(random), inner(random), inner(random) };
+		float halfSize = size * 0.05f;
+
+		SceneBvhFrustum& frustum = frustums[q];
+		for (int p = 0; p < 6; p++) {
+			int axis = p / 2;
+			float sign = p % 2 == 0 ? 1.0f : -1.0f;
+			frustum.Planes[p][0] = frustum.Planes[p][1] = frustum.Planes[p][2] = 0.0f;
+			frustum.Planes[p][axis] = sign;
+			frustum.Planes[p][3] = halfSize - sign * center[axis];
+		}
+
+		spheres[q] = SceneBvhSphere{ { center[0], center[1], center[2] }, radius(random) };
+
+		float direction[3] = { unit(random), unit(random), unit(random) };
+		float length = (std::max)(std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]), 0.001f);
+		rays[q] = SceneBvhRay{ { center[0], center[1], center[2] }, { direction[0] / length, direction[1] / length, direction[2] / length }, size * 0.25f };
+	}
+
+	SceneBvhResults frustumResults, sphereResults;
+	SceneBvhRayResults rayResults;
+
+	start = Clock::now();
+	bvh.QueryFrustums(&frustums[0], queryCount, frustumResults);
+	measurement.FrustumQueriesPerSecond = queryCount / std::chrono::duration<double>(Clock::now() - start).count();
+
+	start = Clock::now();
+	bvh.QuerySpheres(&spheres[0], queryCount, sphereResults);
+	measurement.SphereQueriesPerSecond = queryCount / std::chrono::duration<double>(Clock::now() - start).count();
+
+	start = Clock::now();
+	bvh.QueryRays(&rays[0], queryCount, rayResults);
+	measurement.RayQueriesPerSecond = queryCount / std::chrono::duration<double>(Clock::now() - start).count();
+
+	//Testing every item, for the speed up and to check the answers
+	size_t checkCount = (std::min)((size_t)queryCount, (size_t)64);
+	std::vector<std::vector<uint32_t>> checkFrustums(checkCount), checkSpheres(checkCount), checkRays(checkCount);
+
+	start = Clock::now();
+	JobSystem::GetInstance().ParallelFor(checkCount, 1, [&](size_t begin, size_t end) {
+		for (size_t q = begin; q < end; q++) {
+			for (size_t i = 0; i < itemCount; i++) {
+				if (IntersectSphereBox(spheres[q], GetItemBox(bounds, i))) checkSpheres[q].push_back((uint32_t)i);
+			}
+		}
+	});
+	measurement.BruteForceQueriesPerSecond = checkCount / std::chrono::duration<double>(Clock::now() - start).count();
+
+	JobSystem::GetInstance().ParallelFor(checkCount, 1, [&](size_t begin, size_t end) {
+		for (size_t q = begin; q < end; q++) {
+			float inverseDirection[3] = { 1.0f / rays[q].Direction[0], 1.0f / rays[q].Direction[1], 1.0f / rays[q].Direction[2] };
+			for (size_t i = 0; i < itemCount; i++) {
+				SceneBvhBox box = GetItemBox(bounds, i);
+				float distance;
+				if (ClassifyBox(frustums[q], box) != 0) checkFrustums[q].push_back((uint32_t)i);
+				if (IntersectRay(rays[q], inverseDirection, box, distance)) checkRays[q].push_back((uint32_t)i);
+			}
+		}
+	});
+
+	auto matches = [](std::vector<uint32_t> found, const std::vector<uint32_t>& expected) {
+		std::sort(found.begin(), found.end());
+		return found == expected;
+	};
+
+	for (size_t q = 0; q < checkCount; q++) {
+		const SceneBvhRange& frustumRange = frustumResults.Ranges[q];
+		const SceneBvhRange& sphereRange = sphereResults.Ranges[q];
+		const SceneBvhRange& rayRange = rayResults.Ranges[q];
+
+		std::vector<uint32_t> rayItems;
+		for (uint32_t h = rayRange.Offset; h < rayRange.Offset + rayRange.Count; h++) rayItems.push_back(rayResults.Hits[h].Item);
+
+		auto frustumBegin = frustumResults.Items.begin() + frustumRange.Offset;
+		auto sphereBegin = sphereResults.Items.begin() + sphereRange.Offset;
+		if (!matches(std::vector<uint32_t>(frustumBegin, frustumBegin + frustumRange.Count), checkFrustums[q])) measurement.Mismatches++;
+		if (!matches(std::vector<uint32_t>(sphereBegin, sphereBegin + sphereRange.Count), checkSpheres[q])) measurement.Mismatches++;
+		if (!matches(rayItems, checkRays[q])) measurement.Mismatches++;
+	}
+
+	return measurement;
+}
+
+size_t SceneBvh::GetItemCount() const {
+	return itemCount;
+}
+
+size_t SceneBvh::GetUnindexedCount() const {
+	return itemCount - treeItemCount;
+}
+
+size_t SceneBvh::GetNodeCount() const {
+	return nodes.size();
+}
+
+size_t SceneBvh::GetLeafCount() const {
+	return leafCount;
+}
+
+uint32_t SceneBvh::GetDepth() const {
+	return depth;
+}
+
+float SceneBvh::GetCostRatio() const {
+	return builtCost > 0.0f ? cost / builtCost : 1.0f;
+}
+
+bool SceneBvh::IsRebuilding() const {
+	return pendingBuild != 0;
+}
+
+unsigned int SceneBvh::GetRebuildCount() const {
+	return rebuildCount;
+}
+
+double SceneBvh::GetBuildMilliseconds() const {
+	return buildMilliseconds;
+}
+
+double SceneBvh::GetRefitMilliseconds() const {
+	return refitMilliseconds;
+}
@@ -0,0 +1,346 @@
+#pragma once
+
+#include <cstddef>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "JobSystem.h"
+#include "TransformBatch.h"
+
+// Most items the builder leaves in one leaf
+#define SCENE_BVH_LEAF_SIZE 4
+
+// Buckets the builder sorts centers into, along each axis
+#define SCENE_BVH_BINS 16
+
+// Queries per job when a batch is split across threads
+#define SCENE_BVH_QUERY_GRAIN 64
+
+// Nodes per job when refitting
+#define SCENE_BVH_REFIT_GRAIN 4096
+
+// Entries a walk keeps on the stack, which covers any tree
+// less deep than this without touching the heap
+#define SCENE_BVH_STACK_SIZE 64
+
+// How much worse a refitted tree's SAH cost can get, against
+// when it was built, before it's rebuilt
+#define SCENE_BVH_REBUILD_RATIO 1.3f
+
+// --------------------------------------------------------
+// Axis aligned box, as its corners
+// --------------------------------------------------------
+struct SceneBvhBox {
+	float Min[3];
+	float Max[3];
+};
+
+// --------------------------------------------------------
+// One node of the tree
+//  - An internal node's two children sit next to each
+//     other, after it, so refitting backwards always sees
+//     children before their parent
+// --------------------------------------------------------
+struct SceneBvhNode {
+	SceneBvhBox Bounds;
+	uint32_t Index;	// First child, or first item slot for leaves
+	uint32_t Count;	// Items in a leaf, 0 for internal nodes
+};
+
+// Planes facing inward, as ax + by + cz + d >= 0 inside
+struct SceneBvhFrustum {
+	float Planes[6][4];
+};
+
+struct SceneBvhSphere {
+	float Center[3];
+	float Radius;
+};
+
+struct SceneBvhRay {
+	float Origin[3];
+	float Direction[3];
+	float MaxDistance;
+};
+
+// An item whose box a ray goes through, and where it goes in
+struct SceneBvhHit {
+	uint32_t Item;
+	float Distance;
+};
+
+// Where a query's results start in a batch's list, and how many there are
+struct SceneBvhRange {
+	uint32_t Offset;
+	uint32_t Count;
+};
+
+// --------------------------------------------------------
+// A batch's results, with every query's items in one list
+// --------------------------------------------------------
+struct SceneBvhResults {
+	std::vector<uint32_t> Items;
+	std::vector<SceneBvhRange> Ranges; // One per query
+};
+
+struct SceneBvhRayResults {
+	std::vector<SceneBvhHit> Hits; // Nearest first within each ray
+	std::vector<SceneBvhRange> Ranges;
+};
+
+// --------------------------------------------------------
+// Nodes a walk still has to open
+//  - Walks push both children and pop one, so they never
+//     hold more than one entry per level plus the root
+//  - Held on the stack, so queries made every frame don't
+//     allocate, unless the tree is too deep for it
+// --------------------------------------------------------
+template<typename T>
+class SceneBvhStack {
+private:
+	T local[SCENE_BVH_STACK_SIZE];
+	std::vector<T> heap;
+	T* entries;
+	size_t count;
+
+public:
+	explicit SceneBvhStack(uint32_t depth) :
+		entries(local),
+		count(0) {
+		if (depth + 1 > SCENE_BVH_STACK_SIZE) {
+			heap.resize(depth + 1);
+			entries = &heap[0];
+		}
+	}
+
+	void Push(const T& entry) { entries[count++] = entry; }
+	T Pop() { return entries[--count]; }
+	bool IsEmpty() const { return count == 0; }
+};
+
+// --------------------------------------------------------
+// What SceneBvh::Measure() found
+// --------------------------------------------------------
+struct SceneBvhMeasurement {
+	size_t Items = 0;
+	unsigned int Queries = 0;				// Of each kind
+	double BuildMilliseconds = 0.0;
+	double RefitMilliseconds = 0.0;			// After every item moved
+	float RefitCostRatio = 0.0f;			// SAH cost after the refit, against after the build
+	double FrustumQueriesPerSecond = 0.0;
+	double SphereQueriesPerSecond = 0.0;
+	double RayQueriesPerSecond = 0.0;
+	double BruteForceQueriesPerSecond = 0.0;	// Spheres, checking every item
+	unsigned int Mismatches = 0;			// Queries that didn't match checking every item
+};
+
+// --------------------------------------------------------
+// Dynamic bounding volume hierarchy over a list of boxes,
+// for asking what's near something without checking
+// everything
+//
+// - Items are indices into the bounds handed to Update(),
+//    which are the entities' world bounds in the game
+// - Built top down with binned SAH, and after that just
+//    refitted each update, as moving things rarely change
+//    which of them belong together
+// - Refits slowly make the tree worse, so once its SAH cost
+//    has grown too far it's rebuilt on a job system worker
+//    from a copy of the bounds, then swapped in and refitted
+//    to catch up on what moved in the meantime
+// - Items added since the last build are kept in a list
+//    every query also checks, until the next rebuild
+// - Queries come in batches, split across the job system,
+//    with each leaf's boxes stored next to each other
+// - Single queries don't allocate beyond their results, so
+//    the game can make them every frame
+// - Doesn't use DirectXMath, so it builds anywhere
+// --------------------------------------------------------
+class SceneBvh {
+private:
+	//The tree, and a copy of each item's box in leaf order
+	std::vector<SceneBvhNode> nodes;
+	std::vector<uint32_t> items;	// Item in each slot
+	std::vector<uint32_t> slots;	// Slot of each item
+	std::vector<SceneBvhBox> itemBoxes;
+	size_t treeItemCount;	// Items in the tree, the rest are checked one by one
+	size_t itemCount;
+	size_t leafCount;
+	uint32_t depth;			// Levels below the root, for sizing a walk's stack
+	float builtCost;		// SAH cost just after the tree was built
+	float cost;				// And after the latest refit
+
+	//Rebuild running on a worker
+	struct PendingBuild {
+		BoundsStreams Bounds;
+		std::vector<SceneBvhNode> Nodes;
+		std::vector<uint32_t> Items;
+		uint32_t Depth;
+		double Milliseconds;
+	};
+	std::shared_ptr<PendingBuild> pendingBuild;
+	JobCounter rebuildCounter;
+
+	//Stats
+	unsigned int rebuildCount;
+	double buildMilliseconds;
+	double refitMilliseconds;
+
+	void Refit(const BoundsStreams& bounds);
+	void UpdateSlots();
+	void StartRebuild(const BoundsStreams& bounds);
+	static uint32_t FindDepth(const std::vector<SceneBvhNode>& nodes);
+
+	//Calls visit(slot) for each item slot whose box passes
+	// - Whole subtrees inside every plane aren't tested further
+	template<typename Visit>
+	void VisitFrustum(const SceneBvhFrustum& frustum, Visit visit) const;
+	template<typename Test, typename Visit>
+	void VisitBoxes(Test test, Visit visit) const;
+
+public:
+	SceneBvh();
+	~SceneBvh();
+
+	//Builds from scratch, on the calling thread
+	void Build(const BoundsStreams& bounds);
+
+	//Catches the tree up with the bounds' latest values
+	// - Refits, swaps in a finished rebuild, and starts a new
+	//    one when the tree has got too slow
+	// - Fewer items than before means a build right away
+	void Update(const BoundsStreams& bounds);
+
+	//Batched queries
+	// - Items are in no particular order, apart from rays,
+	//    whose hits are sorted nearest first
+	void QueryFrustums(const SceneBvhFrustum* frustums, size_t count, SceneBvhResults& results) const;
+	void QuerySpheres(const SceneBvhSphere* spheres, size_t count, SceneBvhResults& results) const;
+	void QueryRays(const SceneBvhRay* rays, size_t count, SceneBvhRayResults& results) const;
+
+	//Single queries, on the calling thread
+	void QueryFrustum(const SceneBvhFrustum& frustum, std::vector<uint32_t>& results) const;
+	void QuerySphere(const SceneBvhSphere& sphere, std::vector<uint32_t>& results) const;
+	void QueryRay(const SceneBvhRay& ray, std::vector<SceneBvhHit>& results) const;
+
+	//Finds the nearest thing along a ray, when boxes aren't enough
+	// - Nodes are walked nearer child first, and narrowphase(item,
+	//    maxDistance) is called for each item whose box is hit
+	// - It returns true when it finds something within maxDistance,
+	//    and lowers maxDistance to it, which then prunes the rest
+	// - Returns whether anything was found
+	template<typename Narrowphase>
+	bool CastRay(const SceneBvhRay& ray, Narrowphase narrowphase) const;
+
+	//Slab test, giving how far along the ray it enters the box
+	static bool IntersectRay(const SceneBvhRay& ray, const float inverseDirection[3], const SceneBvhBox& box, float& distance);
+
+	//Planes of the volume a row major view projection matrix
+	//sees, with depth from 0 to 1 like D3D
+	static SceneBvhFrustum GetFrustum(const float viewProjection[16]);
+
+	//Builds a tree over the bounds without keeping it, for other
+	//trees to reuse, like each mesh's triangles
+	// - Items come out as the bounds' indices in leaf order, with
+	//    each leaf's run of them side by side
+	static void BuildTree(const BoundsStreams& bounds, size_t leafSize, std::vector<SceneBvhNode>& nodes, std::vector<uint32_t>& items);
+
+	//Times building, refitting and each kind of query over a
+	//random scene of the given size, and checks a sample of
+	//the queries against testing every item
+	static SceneBvhMeasurement Measure(size_t itemCount, unsigned int queryCount);
+
+	//Stats
+	size_t GetItemCount() const;
+	size_t GetUnindexedCount() const;	// Added since the last build
+	size_t GetNodeCount() const;
+	size_t GetLeafCount() const;
+	uint32_t GetDepth() const;
+	float GetCostRatio() const;			// Current SAH cost against just after building
+	bool IsRebuilding() const;
+	unsigned int GetRebuildCount() const;
+	double GetBuildMilliseconds() const;
+	double GetRefitMilliseconds() const;
+};
+
+// --------------------------------------------------------
+// Slab test
+//  - A ray starting inside enters at 0
+//  - Axes the ray doesn't move along have an infinite
+//     inverse, and the min/max order keeps any NaN from a
+//     ray lying on a face from counting as a hit or a miss
+// --------------------------------------------------------
+inline bool SceneBvh::IntersectRay(const SceneBvhRay& ray, const float inverseDirection[3], const SceneBvhBox& box, float& distance) {
+	float enter = 0.0f;
+	float exit = ray.MaxDistance;
+
+	for (int a = 0; a < 3; a++) {
+		float t0 = (box.Min[a] - ray.Origin[a]) * inverseDirection[a];
+		float t1 = (box.Max[a] - ray.Origin[a]) * inverseDirection[a];
+		if (t0 > t1) std::swap(t0, t1);
+
+		enter = (std::max)(enter, t0);
+		exit = (std::min)(exit, t1);
+	}
+
+	distance = enter;
+	return enter <= exit;
+}
+
+// --------------------------------------------------------
+// Walks the tree front to back, shortening the ray to each
+// hit the narrowphase finds
+//  - Children are pushed farther first, so the nearer one is
+//     opened next, and anything entered beyond the nearest
+//     hit so far is skipped when it comes off the stack
+//  - The narrowphase is a template parameter, so it's called
+//     directly rather than through a std::function
+// --------------------------------------------------------
+template<typename Narrowphase>
+bool SceneBvh::CastRay(const SceneBvhRay& ray, Narrowphase narrowphase) const {
+	float inverseDirection[3] = { 1.0f / ray.Direction[0], 1.0f / ray.Direction[1], 1.0f / ray.Direction[2] };
+	SceneBvhRay clipped = ray;
+	bool found = false;
+
+	auto testSlot = [&](uint32_t slot) {
+		float distance;
+		if (IntersectRay(clipped, inverseDirection, itemBoxes[slot], distance) && narrowphase(items[slot], clipped.MaxDistance)) found = true;
+	};
+
+	struct Entry {
+		uint32_t Node;
+		float Distance;
+	};
+	SceneBvhStack<Entry> open(depth);
+
+	float distance;
+	if (!nodes.empty() && IntersectRay(clipped, inverseDirection, nodes[0].Bounds, distance)) open.Push(Entry{ 0, distance });
+
+	while (!open.IsEmpty()) {
+		Entry entry = open.Pop();
+		if (entry.Distance > clipped.MaxDistance) continue;
+
+		const SceneBvhNode& node = nodes[entry.Node];
+		if (node.Count > 0) {
+			for (uint32_t slot = node.Index; slot < node.Index + node.Count; slot++) testSlot(slot);
+			continue;
+		}
+
+		float leftDistance, rightDistance;
+		bool left = IntersectRay(clipped, inverseDirection, nodes[node.Index].Bounds, leftDistance);
+		bool right = IntersectRay(clipped, inverseDirection, nodes[node.Index + 1].Bounds, rightDistance);
+
+		if (left && right) {
+			bool leftFirst = leftDistance <= rightDistance;
+			open.Push(leftFirst ? Entry{ node.Index + 1, rightDistance } : Entry{ node.Index, leftDistance });
+			open.Push(leftFirst ? Entry{ node.Index, leftDistance } : Entry{ node.Index + 1, rightDistance });
+		}
+		else if (left) open.Push(Entry{ node.Index, leftDistance });
+		else if (right) open.Push(Entry{ node.Index + 1, rightDistance });
+	}
+
+	for (uint32_t slot = (uint32_t)treeItemCount; slot < itemCount; slot++) testSlot(slot);
+	return found;
+}
@@ -0,0 +1,893 @@
+#include "SceneFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+
+#include "CommandTrace.h"
+
+// "SCNB" read as a little endian integer
+#define SCENE_BINARY_MAGIC 0x424E4353
+
+// Chunks start on this boundary, so every record is aligned
+// wherever the file is mapped
+#define SCENE_CHUNK_ALIGNMENT 16
+
+// Tokens on one line of a text scene
+#define SCENE_MAX_LINE_TOKENS 32
+
+static const float PI = 3.14159265359f;
+
+// Used when a scene has no environment chunk
+static const SceneEnvironment defaultEnvironment = {
+	{ 0.0f, 0.0f, 0.0f },
+	SCENE_NONE,
+	{ SCENE_NONE, SCENE_NONE, SCENE_NONE, SCENE_NONE, SCENE_NONE, SCENE_NONE }
+};
+
+// Size of each chunk's records, 1 for the strings
+static const size_t recordSizes[(int)SceneChunk::Count] = {
+	1,
+	sizeof(SceneAsset),
+	sizeof(SceneAsset),
+	sizeof(SceneMaterial),
+	sizeof(SceneMaterialTexture),
+	sizeof(SceneTransform),
+	sizeof(SceneRenderable),
+	sizeof(SceneLight),
+	sizeof(SceneCamera),
+	sizeof(SceneEnvironment)
+};
+
+static size_t AlignChunk(size_t offset) {
+	return (offset + SCENE_CHUNK_ALIGNMENT - 1) & ~(size_t)(SCENE_CHUNK_ALIGNMENT - 1);
+}
+
+SceneBuilder::SceneBuilder() {
+	environment = defaultEnvironment;
+
+	//Offset 0 is always the empty string
+	strings.push_back('\0');
+	stringOffsets[""] = 0;
+}
+
+// --------------------------------------------------------
+// Adds a string to the table, sharing repeats
+// --------------------------------------------------------
+uint32_t SceneBuilder::AddString(const std::string& text) {
+	auto existing = stringOffsets.find(text);
+	if (existing != stringOffsets.end()) return existing->second;
+
+	uint32_t offset = (uint32_t)strings.size();
+	strings.insert(strings.end(), text.begin(), text.end());
+	strings.push_back('\0');
+	stringOffsets[text] = offset;
+	return offset;
+}
+
+const char* SceneBuilder::GetString(uint32_t offset) const {
+	return offset < strings.size() ? &strings[offset] : "";
+}
+
+uint32_t SceneBuilder::AddTexture(const std::string& name, const std::string& path) {
+	if (textureNames.count(name)) return SCENE_NONE;
+
+	uint32_t index = (uint32_t)textures.size();
+	textures.push_back({ AddString(name), AddString(path) });
+	textureNames[name] = index;
+	return index;
+}
+
+uint32_t SceneBuilder::AddMesh(const std::string& name, const std::string& path) {
+	if (meshNames.count(name)) return SCENE_NONE;
+
+	uint32_t index = (uint32_t)meshes.size();
+	meshes.push_back({ AddString(name), AddString(path) });
+	meshNames[name] = index;
+	return index;
+}
+
+uint32_t SceneBuilder::AddMaterial(const std::string& name, const std::string& vertexShader, const std::string& pixelShader, const float tint[4], float roughness) {
+	if (materialNames.count(name)) return SCENE_NONE;
+
+	SceneMaterial material = {};
+	material.Name = AddString(name);
+	material.VertexShader = AddString(vertexShader);
+	material.PixelShader = AddString(pixelShader);
+	material.FirstTexture = (uint32_t)materialTextures.size();
+	material.TextureCount = 0;
+	material.Roughness = roughness;
+	for (int i = 0; i < 4; i++) material.Tint[i] = tint[i];
+
+	uint32_t index = (uint32_t)materials.size();
+	materials.push_back(material);
+	materialNames[name] = index;
+	return index;
+}
+
+bool SceneBuilder::AddMaterialTexture(const std::string& slot, uint32_t texture) {
+	if (materials.empty()) return false;
+
+	materialTextures.push_back({ AddString(slot), texture });
+	materials.back().TextureCount++;
+	return true;
+}
+
+void SceneBuilder::AddEntity(uint32_t mesh, uint32_t material, const SceneTransform& transform, uint32_t flags) {
+	transforms.push_back(transform);
+	renderables.push_back({ mesh, material, flags });
+}
+
+void SceneBuilder::AddLight(const SceneLight& light) {
+	lights.push_back(light);
+}
+
+void SceneBuilder::AddCamera(const SceneCamera& camera) {
+	cameras.push_back(camera);
+}
+
+void SceneBuilder::SetAmbientColor(const float color[3]) {
+	for (int i = 0; i < 3; i++) environment.AmbientColor[i] = color[i];
+}
+
+void SceneBuilder::SetSky(uint32_t mesh, const std::string faces[6]) {
+	environment.SkyMesh = mesh;
+	for (int i = 0; i < 6; i++) {
+		environment.SkyFaces[i] = AddString(faces[i]);
+	}
+}
+
+uint32_t SceneBuilder::FindTexture(const std::string& name) const {
+	auto found = textureNames.find(name);
+	return found == textureNames.end() ? SCENE_NONE : found->second;
+}
+
+uint32_t SceneBuilder::FindMesh(const std::string& name) const {
+	auto found = meshNames.find(name);
+	return found == meshNames.end() ? SCENE_NONE : found->second;
+}
+
+uint32_t SceneBuilder::FindMaterial(const std::string& name) const {
+	auto found = materialNames.find(name);
+	return found == materialNames.end() ? SCENE_NONE : found->second;
+}
+
+size_t SceneBuilder::GetEntityCount() const {
+	return transforms.size();
+}
+
+// --------------------------------------------------------
+// Lays the header, chunk table and each array out exactly
+// as they'll be read back
+// --------------------------------------------------------
+std::vector<uint8_t> SceneBuilder::Build() const {
+	const void* sources[(int)SceneChunk::Count] = {
+		strings.data(),
+		textures.data(),
+		meshes.data(),
+		materials.data(),
+		materialTextures.data(),
+		transforms.data(),
+		renderables.data(),
+		lights.data(),
+		cameras.data(),
+		&environment
+	};
+
+	size_t counts[(int)SceneChunk::Count] = {
+		strings.size(),
+		textures.size(),
+		meshes.size(),
+		materials.size(),
+		materialTextures.size(),
+		transforms.size(),
+		renderables.size(),
+		lights.size(),
+		cameras.size(),
+		1
+	};
+
+	//Work out where everything goes
+	SceneChunkHeader table[(int)SceneChunk::Count] = {};
+	size_t offset = sizeof(SceneFileHeader) + sizeof(table);
+	for (int i = 0; i < (int)SceneChunk::Count; i++) {
+		offset = AlignChunk(offset);
+		table[i].Type = (uint32_t)i;
+		table[i].Count = (uint32_t)counts[i];
+		table[i].Offset = offset;
+		table[i].Size = counts[i] * recordSizes[i];
+		offset += (size_t)table[i].Size;
+	}
+
+	std::vector<uint8_t> image(AlignChunk(offset), 0);
+
+	SceneFileHeader header = {};
+	header.Magic = SCENE_BINARY_MAGIC;
+	header.Version = SCENE_BINARY_VERSION;
+	header.ChunkCount = (uint32_t)SceneChunk::Count;
+	memcpy(image.data(), &header, sizeof(header));
+	memcpy(image.data() + sizeof(header), table, sizeof(table));
+
+	for (int i = 0; i < (int)SceneChunk::Count; i++) {
+		if (table[i].Size) memcpy(image.data() + table[i].Offset, sources[i], (size_t)table[i].Size);
+	}
+
+	return image;
+}
+
+// --------------------------------------------------------
+// Writes the scene back out in the authoring form
+//  - Angles go out in degrees, as they're written by hand
+// --------------------------------------------------------
+bool SceneBuilder::WriteText(const std::wstring& path) const {
+	std::ofstream out;
+	CommandTrace::OpenFile(out, path);
+	if (!out.is_open()) return false;
+
+	const float degrees = 180.0f / PI;
+	const char* lightTypes[] = { "directional", "point", "spot" };
+
+	out << "# Generated scene\n";
+	out << "ambient " << environment.AmbientColor[0] << " " << environment.AmbientColor[1] << " " << environment.AmbientColor[2] << "\n\n";
+
+	for (const SceneAsset& texture : textures) {
+		out << "texture " << GetString(texture.Name) << " \"" << GetString(texture.Path) << "\"\n";
+	}
+
+	for (const SceneAsset& mesh : meshes) {
+		out << "mesh " << GetString(mesh.Name) << " \"" << GetString(mesh.Path) << "\"\n";
+	}
+
+	for (const SceneMaterial& material : materials) {
+		out << "\nmaterial " << GetString(material.Name) << " "
+			<< GetString(material.VertexShader) << " " << GetString(material.PixelShader)
+			<< " tint " << material.Tint[0] << " " << material.Tint[1] << " " << material.Tint[2] << " " << material.Tint[3]
+			<< " roughness " << material.Roughness << "\n";
+
+		for (uint32_t i = 0; i < material.TextureCount; i++) {
+			const SceneMaterialTexture& map = materialTextures[material.FirstTexture + i];
+			out << "map " << GetString(map.Slot) << " " << GetString(textures[map.Texture].Name) << "\n";
+		}
+	}
+
+	if (environment.SkyMesh != SCENE_NONE) {
+		out << "\nsky " << GetString(meshes[environment.SkyMesh].Name);
+		for (int i = 0; i < 6; i++) {
+			out << " \"" << GetString(environment.SkyFaces[i]) << "\"";
+		}
+		out << "\n";
+	}
+
+	out << "\n";
+	for (const SceneLight& light : lights) {
+		out << "light " << lightTypes[light.Type]
+			<< " direction " << light.Direction[0] << " " << light.Direction[1] << " " << light.Direction[2]
+			<< " position " << light.Position[0] << " " << light.Position[1] << " " << light.Position[2]
+			<< " range " << light.Range
+			<< " falloff " << light.SpotFalloff
+			<< " color " << light.Color[0] << " " << light.Color[1] << " " << light.Color[2]
+			<< " intensity " << light.Intensity << "\n";
+	}
+
+	out << "\n";
+	for (const SceneCamera& camera : cameras) {
+		out << "camera position " << camera.Position[0] << " " << camera.Position[1] << " " << camera.Position[2]
+			<< " rotation " << camera.Rotation[0] * degrees << " " << camera.Rotation[1] * degrees << " " << camera.Rotation[2] * degrees
+			<< " moveSpeed " << camera.MoveSpeed
+			<< " rotationSpeed " << camera.RotationSpeed
+			<< " fov " << camera.FieldOfView * degrees << "\n";
+	}
+
+	out << "\n";
+	for (size_t i = 0; i < transforms.size(); i++) {
+		const SceneTransform& transform = transforms[i];
+		const SceneRenderable& renderable = renderables[i];
+
+		out << "entity " << GetString(meshes[renderable.Mesh].Name) << " " << GetString(materials[renderable.Material].Name)
+			<< " position " << transform.Position[0] << " " << transform.Position[1] << " " << transform.Position[2]
+			<< " rotation " << transform.Rotation[0] * degrees << " " << transform.Rotation[1] * degrees << " " << transform.Rotation[2] * degrees
+			<< " scale " << transform.Scale[0] << " " << transform.Scale[1] << " " << transform.Scale[2]
+			<< ((renderable.Flags & SCENE_ENTITY_STATIC) ? " static" : "") << "\n";
+	}
+
+	return out.good();
+}
+
+SceneFile::SceneFile() :
+	data(0),
+	dataSize(0) {
+	memset(chunks, 0, sizeof(chunks));
+}
+
+SceneFile::~SceneFile() {
+	Close();
+}
+
+// --------------------------------------------------------
+// Unmaps the file and forgets the image
+// --------------------------------------------------------
+void SceneFile::Close() {
+	mapped.Close();
+
+	image.clear();
+	image.shrink_to_fit();
+	data = 0;
+	dataSize = 0;
+	memset(chunks, 0, sizeof(chunks));
+}
+
+bool SceneFile::Load(const std::wstring& path) {
+	const std::wstring binaryExtension = L".scenebin";
+	bool binary = path.size() >= binaryExtension.size() &&
+		path.compare(path.size() - binaryExtension.size(), binaryExtension.size(), binaryExtension) == 0;
+
+	return binary ? LoadBinary(path) : LoadText(path);
+}
+
+// --------------------------------------------------------
+// Parses a text scene straight from a mapping, then
+// compiles it
+// --------------------------------------------------------
+bool SceneFile::LoadText(const std::wstring& path) {
+	Close();
+	error.clear();
+
+	MappedFile text;
+	if (!text.Open(path)) {
+		error = "Couldn't open the scene";
+		return false;
+	}
+
+	SceneBuilder builder;
+	if (!ParseText((const char*)text.GetData(), text.GetSize(), builder, error)) return false;
+
+	image = builder.Build();
+	if (!ReadImage(image.data(), image.size())) {
+		std::string reason = error;
+		Close();
+		error = reason;
+		return false;
+	}
+
+	return true;
+}
+
+// --------------------------------------------------------
+// Maps a compiled scene into memory
+//  - Nothing is read up front beyond the header and the
+//     small arrays, so the entities page in as they're used
+// --------------------------------------------------------
+bool SceneFile::LoadBinary(const std::wstring& path) {
+	Close();
+	error.clear();
+
+	if (!mapped.Open(path)) {
+		error = "Couldn't open the scene";
+		return false;
+	}
+
+	if (mapped.GetSize() < sizeof(SceneFileHeader)) {
+		Close();
+		error = "The scene is too small to be compiled";
+		return false;
+	}
+
+	if (!ReadImage(mapped.GetData(), mapped.GetSize())) {
+		std::string reason = error;
+		Close();
+		error = reason;
+		return false;
+	}
+
+	return true;
+}
+
+// --------------------------------------------------------
+// Checks the header and chunk table, and points each chunk
+// at its records
+//  - Everything but the per entity arrays is checked here,
+//     and those are left alone so they aren't all paged in
+// --------------------------------------------------------
+bool SceneFile::ReadImage(const uint8_t* data, size_t size) {
+	const SceneFileHeader* header = (const SceneFileHeader*)data;
+	if (size < sizeof(SceneFileHeader) || header->Magic != SCENE_BINARY_MAGIC) {
+		error = "Not a compiled scene";
+		return false;
+	}
+
+	if (header->Version != SCENE_BINARY_VERSION) {
+		error = "Compiled with a different version, recompile the scene";
+		return false;
+	}
+
+	if (header->ChunkCount > size / sizeof(SceneChunkHeader)) {
+		error = "Chunk table is corrupt";
+		return false;
+	}
+
+	const SceneChunkHeader* table = (const SceneChunkHeader*)(data + sizeof(SceneFileHeader));
+	if (sizeof(SceneFileHeader) + header->ChunkCount * sizeof(SceneChunkHeader) > size) {
+		error = "Chunk table is corrupt";
+		return false;
+	}
+
+	for (uint32_t i = 0; i < header->ChunkCount; i++) {
+		const SceneChunkHeader& chunk = table[i];
+
+		//Unknown chunks are from a newer tool, and are skipped
+		if (chunk.Type >= (uint32_t)SceneChunk::Count) continue;
+
+		if (chunk.Offset % SCENE_CHUNK_ALIGNMENT != 0 ||
+			chunk.Offset > size ||
+			chunk.Size > size - chunk.Offset ||
+			chunk.Size != (uint64_t)chunk.Count * recordSizes[chunk.Type]) {
+			error = "Chunk " + std::to_string(i) + " is corrupt";
+			return false;
+		}
+
+		chunks[chunk.Type] = &chunk;
+	}
+
+	this->data = data;
+	this->dataSize = size;
+
+	//Strings have to end in a terminator for GetString() to be safe
+	SceneArray<char> strings = GetChunk<char>(SceneChunk::Strings);
+	if (!strings.empty() && strings[strings.Count - 1] != '\0') {
+		error = "String table is corrupt";
+		return false;
+	}
+
+	//Cross references in the small arrays
+	SceneArray<SceneAsset> textures = GetTextures();
+	SceneArray<SceneMaterialTexture> materialTextures = GetMaterialTextures();
+	for (const SceneMaterial& material : GetMaterials()) {
+		if ((uint64_t)material.FirstTexture + material.TextureCount > materialTextures.Count) {
+			error = "Material textures are out of range";
+			return false;
+		}
+	}
+
+	for (const SceneMaterialTexture& map : materialTextures) {
+		if (map.Texture >= textures.Count) {
+			error = "Material texture is out of range";
+			return false;
+		}
+	}
+
+	const SceneEnvironment& environment = GetEnvironment();
+	if (environment.SkyMesh != SCENE_NONE && environment.SkyMesh >= GetMeshes().Count) {
+		error = "Sky mesh is out of range";
+		return false;
+	}
+
+	for (const SceneLight& light : GetLights()) {
+		if (light.Type < SCENE_LIGHT_DIRECTIONAL || light.Type > SCENE_LIGHT_SPOT) {
+			error = "Light has an unknown type";
+			return false;
+		}
+	}
+
+	if (GetTransforms().Count != GetRenderables().Count) {
+		error = "Entity arrays don't match";
+		return false;
+	}
+
+	return true;
+}
+
+template<typename T>
+SceneArray<T> SceneFile::GetChunk(SceneChunk type) const {
+	SceneArray<T> array;
+
+	const SceneChunkHeader* chunk = chunks[(int)type];
+	if (chunk && data) {
+		array.Data = (const T*)(data + chunk->Offset);
+		array.Count = chunk->Count;
+	}
+
+	return array;
+}
+
+bool SceneFile::WriteBinary(const std::wstring& path) const {
+	if (!data) return false;
+
+	std::ofstream out;
+	CommandTrace::OpenFile(out, path);
+	if (!out.is_open()) return false;
+
+	out.write((const char*)data, dataSize);
+	return out.good();
+}
+
+void SceneFile::Prefetch(size_t firstEntity, size_t count) const {
+	if (!IsMapped()) return;
+
+	SceneArray<SceneTransform> transforms = GetTransforms();
+	if (firstEntity >= transforms.Count) return;
+	count = (std::min)(count, transforms.Count - firstEntity);
+
+	mapped.Prefetch(transforms.Data + firstEntity, count * sizeof(SceneTransform));
+	mapped.Prefetch(GetRenderables().Data + firstEntity, count * sizeof(SceneRenderable));
+}
+
+bool SceneFile::IsMapped() const {
+	return mapped.GetData() != 0;
+}
+
+size_t SceneFile::GetByteSize() const {
+	return dataSize;
+}
+
+const std::string& SceneFile::GetError() const {
+	return error;
+}
+
+const char* SceneFile::GetString(uint32_t offset) const {
+	SceneArray<char> strings = GetChunk<char>(SceneChunk::Strings);
+	return offset < strings.Count ? &strings[offset] : "";
+}
+
+SceneArray<SceneAsset> SceneFile::GetTextures() const {
+	return GetChunk<SceneAsset>(SceneChunk::Textures);
+}
+
+SceneArray<SceneAsset> SceneFile::GetMeshes() const {
+	return GetChunk<SceneAsset>(SceneChunk::Meshes);
+}
+
+SceneArray<SceneMaterial> SceneFile::GetMaterials() const {
+	return GetChunk<SceneMaterial>(SceneChunk::Materials);
+}
+
+SceneArray<SceneMaterialTexture> SceneFile::GetMaterialTextures() const {
+	return GetChunk<SceneMaterialTexture>(SceneChunk::MaterialTextures);
+}
+
+SceneArray<SceneTransform> SceneFile::GetTransforms() const {
+	return GetChunk<SceneTransform>(SceneChunk::Transforms);
+}
+
+SceneArray<SceneRenderable> SceneFile::GetRenderables() const {
+	return GetChunk<SceneRenderable>(SceneChunk::Renderables);
+}
+
+SceneArray<SceneLight> SceneFile::GetLights() const {
+	return GetChunk<SceneLight>(SceneChunk::Lights);
+}
+
+SceneArray<SceneCamera> SceneFile::GetCameras() const {
+	return GetChunk<SceneCamera>(SceneChunk::Cameras);
+}
+
+const SceneEnvironment& SceneFile::GetEnvironment() const {
+	SceneArray<SceneEnvironment> environment = GetChunk<SceneEnvironment>(SceneChunk::Environment);
+	return environment.empty() ? defaultEnvironment : environment[0];
+}
+
+size_t SceneFile::GetEntityCount() const {
+	return GetTransforms().Count;
+}
+
+// --------------------------------------------------------
+// Times every step between a scene on disk and its entities
+//  - Every entity shares one mesh and material, and the
+//     scene's written with the same seed each time
+//  - Reading the entities copies each chunk's records out of
+//     the mapping, prefetching the next, as the game's
+//     streaming does, so it's what paging them in costs
+//     without creating any entities
+// --------------------------------------------------------
+SceneLoadTimings SceneFile::Measure(size_t entityCount, const std::wstring& textPath, const std::wstring& binaryPath) {
+	typedef std::chrono::high_resolution_clock Clock;
+
+	SceneBuilder builder;
+	const float white[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	builder.AddMesh("mesh", "../../Assets/Models/sphere.obj");
+	builder.AddMaterial("material", "VertexShader.cso", "PixelShader.cso", white, 0.5f);
+
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> angle(0.0f, 2.0f * PI);
+	std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+
+	for (size_t i = 0; i < entityCount; i++) {
+		SceneTransform transform = {};
+		for (int c = 0; c < 3; c++) transform.Position[c] = position(random);
+		for (int c = 0; c < 3; c++) transform.Rotation[c] = angle(random);
+		float size = scale(random);
+		for (int c = 0; c < 3; c++) transform.Scale[c] = size;
+		//A quarter are static, never the first, as the game spins it
+		builder.AddEntity(0, 0, transform, i % 4 == 3 ? SCENE_ENTITY_STATIC : 0);
+	}
+
+	SceneLoadTimings timings;
+	timings.EntityCount = entityCount;
+	if (!builder.WriteText(textPath)) {
+		timings.Error = "Couldn't write the text scene";
+		return timings;
+	}
+
+	//Text form, parsed and compiled
+	{
+		SceneFile text;
+		Clock::time_point start = Clock::now();
+		bool loaded = text.LoadText(textPath);
+		timings.TextParseMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		if (!loaded || !text.WriteBinary(binaryPath)) {
+			timings.Error = loaded ? "Couldn't write the binary scene" : text.GetError();
+			return timings;
+		}
+		timings.BinaryBytes = text.GetByteSize();
+	}
+
+	{
+		MappedFile text;
+		if (text.Open(textPath)) timings.TextBytes = text.GetSize();
+	}
+
+	//Binary form, mapped and then read a chunk at a time
+	SceneFile binary;
+	Clock::time_point start = Clock::now();
+	if (!binary.LoadBinary(binaryPath)) {
+		timings.Error = binary.GetError();
+		return timings;
+	}
+	timings.BinaryMapMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	std::vector<SceneTransform> transforms;
+	std::vector<SceneRenderable> renderables;
+	transforms.reserve(binary.GetEntityCount());
+	renderables.reserve(binary.GetEntityCount());
+
+	start = Clock::now();
+	for (size_t first = 0; first < binary.GetEntityCount(); first += SCENE_STREAM_CHUNK_SIZE) {
+		Clock::time_point chunkStart = Clock::now();
+
+		size_t count = (std::min)((size_t)SCENE_STREAM_CHUNK_SIZE, binary.GetEntityCount() - first);
+		binary.Prefetch(first + count, SCENE_STREAM_CHUNK_SIZE);
+		transforms.insert(transforms.end(), binary.GetTransforms().begin() + first, binary.GetTransforms().begin() + first + count);
+		renderables.insert(renderables.end(), binary.GetRenderables().begin() + first, binary.GetRenderables().begin() + first + count);
+
+		double chunkMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - chunkStart).count();
+		timings.LongestChunkMilliseconds = (std::max)(timings.LongestChunkMilliseconds, chunkMilliseconds);
+		timings.ChunkCount++;
+	}
+	timings.StreamMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	return timings;
+}
+
+// --------------------------------------------------------
+// Text scene parsing
+// --------------------------------------------------------
+
+// One line's tokens, pointing into the text
+struct SceneLine {
+	const char* Tokens[SCENE_MAX_LINE_TOKENS];
+	size_t Lengths[SCENE_MAX_LINE_TOKENS];
+	int Count;
+	int Number;
+
+	std::string Get(int index) const { return std::string(Tokens[index], Lengths[index]); }
+	bool Is(int index, const char* word) const { return strlen(word) == Lengths[index] && strncmp(Tokens[index], word, Lengths[index]) == 0; }
+};
+
+// --------------------------------------------------------
+// Splits a line on whitespace, keeping quoted runs together
+//  - Returns false if there are too many tokens
+// --------------------------------------------------------
+static bool TokenizeLine(const char* start, const char* end, SceneLine& line) {
+	line.Count = 0;
+
+	const char* c = start;
+	while (c < end) {
+		while (c < end && (*c == ' ' || *c == '\t' || *c == '\r')) c++;
+		if (c >= end || *c == '#') break;
+
+		if (line.Count == SCENE_MAX_LINE_TOKENS) return false;
+
+		const char* tokenStart = c;
+		if (*c == '"') {
+			tokenStart = ++c;
+			while (c < end && *c != '"') c++;
+			line.Tokens[line.Count] = tokenStart;
+			line.Lengths[line.Count] = c - tokenStart;
+			if (c < end) c++;
+		}
+		else {
+			while (c < end && *c != ' ' && *c != '\t' && *c != '\r') c++;
+			line.Tokens[line.Count] = tokenStart;
+			line.Lengths[line.Count] = c - tokenStart;
+		}
+
+		line.Count++;
+	}
+
+	return true;
+}
+
+static bool ReadFloat(const SceneLine& line, int index, float& value) {
+	if (index >= line.Count || line.Lengths[index] >= 32) return false;
+
+	char buffer[32];
+	memcpy(buffer, line.Tokens[index], line.Lengths[index]);
+	buffer[line.Lengths[index]] = '\0';
+
+	char* end = 0;
+	value = strtof(buffer, &end);
+	return end == buffer + line.Lengths[index];
+}
+
+// Reads count floats after the token at index
+static bool ReadFloats(const SceneLine& line, int index, float* values, int count) {
+	for (int i = 0; i < count; i++) {
+		if (!ReadFloat(line, index + 1 + i, values[i])) return false;
+	}
+	return true;
+}
+
+static bool LineError(const SceneLine& line, const std::string& message, std::string& error) {
+	error = "Line " + std::to_string(line.Number) + ": " + message;
+	return false;
+}
+
+// --------------------------------------------------------
+// Parses a scene's authoring form
+//
+// Each line is a keyword and its values, with # comments:
+//   ambient r g b
+//   texture <name> "<path>"
+//   mesh <name> "<path>"
+//   material <name> <vertex shader> <pixel shader> [tint r g b a] [roughness x]
+//   map <shader variable> <texture>      (adds to the last material)
+//   sky <mesh> "<right>" "<left>" "<up>" "<down>" "<front>" "<back>"
+//   light directional|point|spot [direction x y z] [position x y z]
+//     [range x] [falloff x] [color r g b] [intensity x]
+//   camera [position x y z] [rotation p y r] [moveSpeed x]
+//     [rotationSpeed x] [fov degrees]
+//   entity <mesh> <material> [position x y z] [rotation p y r]
+//     [scale x y z] [static]
+//
+// Rotations are in degrees, and paths are relative to the
+// executable like FixPath()'s
+// --------------------------------------------------------
+bool SceneFile::ParseText(const char* text, size_t length, SceneBuilder& builder, std::string& error) {
+	const float radians = PI / 180.0f;
+
+	SceneLine line = {};
+	const char* end = text + length;
+	const char* lineStart = text;
+
+	while (lineStart < end) {
+		const char* lineEnd = (const char*)memchr(lineStart, '\n', end - lineStart);
+		if (!lineEnd) lineEnd = end;
+
+		line.Number++;
+		if (!TokenizeLine(lineStart, lineEnd, line)) return LineError(line, "Too many values", error);
+		lineStart = lineEnd + 1;
+
+		if (line.Count == 0) continue;
+
+		if (line.Is(0, "ambient")) {
+			float color[3];
+			if (!ReadFloats(line, 0, color, 3)) return LineError(line, "Expected ambient r g b", error);
+			builder.SetAmbientColor(color);
+		}
+		else if (line.Is(0, "texture") || line.Is(0, "mesh")) {
+			if (line.Count != 3) return LineError(line, "Expected a name and a path", error);
+
+			bool isTexture = line.Is(0, "texture");
+			uint32_t index = isTexture ?
+				builder.AddTexture(line.Get(1), line.Get(2)) :
+				builder.AddMesh(line.Get(1), line.Get(2));
+			if (index == SCENE_NONE) return LineError(line, "'" + line.Get(1) + "' is already defined", error);
+		}
+		else if (line.Is(0, "material")) {
+			if (line.Count < 4) return LineError(line, "Expected a name and two shaders", error);
+
+			float tint[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+			float roughness = 0.0f;
+
+			for (int i = 4; i < line.Count; i++) {
+				if (line.Is(i, "tint") && ReadFloats(line, i, tint, 4)) i += 4;
+				else if (line.Is(i, "roughness") && ReadFloats(line, i, &roughness, 1)) i += 1;
+				else return LineError(line, "Unexpected '" + line.Get(i) + "'", error);
+			}
+
+			if (builder.AddMaterial(line.Get(1), line.Get(2), line.Get(3), tint, roughness) == SCENE_NONE) {
+				return LineError(line, "'" + line.Get(1) + "' is already defined", error);
+			}
+		}
+		else if (line.Is(0, "map")) {
+			if (line.Count != 3) return LineError(line, "Expected a shader variable and a texture", error);
+
+			uint32_t texture = builder.FindTexture(line.Get(2));
+			if (texture == SCENE_NONE) return LineError(line, "No texture named '" + line.Get(2) + "'", error);
+			if (!builder.AddMaterialTexture(line.Get(1), texture)) return LineError(line, "Map before any material", error);
+		}
+		else if (line.Is(0, "sky")) {
+			if (line.Count != 8) return LineError(line, "Expected a mesh and six faces", error);
+
+			uint32_t mesh = builder.FindMesh(line.Get(1));
+			if (mesh == SCENE_NONE) return LineError(line, "No mesh named '" + line.Get(1) + "'", error);
+
+			std::string faces[6];
+			for (int i = 0; i < 6; i++) faces[i] = line.Get(2 + i);
+			builder.SetSky(mesh, faces);
+		}
+		else if (line.Is(0, "light")) {
+			if (line.Count < 2) return LineError(line, "Expected a light type", error);
+
+			SceneLight light = {};
+			if (line.Is(1, "directional")) light.Type = SCENE_LIGHT_DIRECTIONAL;
+			else if (line.Is(1, "point")) light.Type = SCENE_LIGHT_POINT;
+			else if (line.Is(1, "spot")) light.Type = SCENE_LIGHT_SPOT;
+			else return LineError(line, "Unknown light type '" + line.Get(1) + "'", error);
+
+			for (int i = 2; i < line.Count; i++) {
+				if (line.Is(i, "direction") && ReadFloats(line, i, light.Direction, 3)) i += 3;
+				else if (line.Is(i, "position") && ReadFloats(line, i, light.Position, 3)) i += 3;
+				else if (line.Is(i, "color") && ReadFloats(line, i, light.Color, 3)) i += 3;
+				else if (line.Is(i, "range") && ReadFloats(line, i, &light.Range, 1)) i += 1;
+				else if (line.Is(i, "falloff") && ReadFloats(line, i, &light.SpotFalloff, 1)) i += 1;
+				else if (line.Is(i, "intensity") && ReadFloats(line, i, &light.Intensity, 1)) i += 1;
+				else return LineError(line, "Unexpected '" + line.Get(i) + "'", error);
+			}
+
+			builder.AddLight(light);
+		}
+		else if (line.Is(0, "camera")) {
+			SceneCamera camera = {};
+			camera.MoveSpeed = 5.0f;
+			camera.RotationSpeed = 0.01f;
+			camera.FieldOfView = 60.0f;
+
+			for (int i = 1; i < line.Count; i++) {
+				if (line.Is(i, "position") && ReadFloats(line, i, camera.Position, 3)) i += 3;
+				else if (line.Is(i, "rotation") && ReadFloats(line, i, camera.Rotation, 3)) i += 3;
+				else if (line.Is(i, "moveSpeed") && ReadFloats(line, i, &camera.MoveSpeed, 1)) i += 1;
+				else if (line.Is(i, "rotationSpeed") && ReadFloats(line, i, &camera.RotationSpeed, 1)) i += 1;
+				else if (line.Is(i, "fov") && ReadFloats(line, i, &camera.FieldOfView, 1)) i += 1;
+				else return LineError(line, "Unexpected '" + line.Get(i) + "'", error);
+			}
+
+			for (int c = 0; c < 3; c++) camera.Rotation[c] *= radians;
+			camera.FieldOfView *= radians;
+			builder.AddCamera(camera);
+		}
+		else if (line.Is(0, "entity")) {
+			if (line.Count < 3) return LineError(line, "Expected a mesh and a material", error);
+
+			uint32_t mesh = builder.FindMesh(line.Get(1));
+			if (mesh == SCENE_NONE) return LineError(line, "No mesh named '" + line.Get(1) + "'", error);
+
+			uint32_t material = builder.FindMaterial(line.Get(2));
+			if (material == SCENE_NONE) return LineError(line, "No material named '" + line.Get(2) + "'", error);
+
+			SceneTransform transform = {};
+			for (int c = 0; c < 3; c++) transform.Scale[c] = 1.0f;
+			uint32_t flags = 0;
+
+			for (int i = 3; i < line.Count; i++) {
+				if (line.Is(i, "position") && ReadFloats(line, i, transform.Position, 3)) i += 3;
+				else if (line.Is(i, "rotation") && ReadFloats(line, i, transform.Rotation, 3)) i += 3;
+				else if (line.Is(i, "scale") && ReadFloats(line, i, transform.Scale, 3)) i += 3;
+				else if (line.Is(i, "static")) flags |= SCENE_ENTITY_STATIC;
+				else return LineError(line, "Unexpected '" + line.Get(i) + "'", error);
+			}
+
+			for (int c = 0; c < 3; c++) transform.Rotation[c] *= radians;
+			builder.AddEntity(mesh, material, transform, flags);
+		}
+		else {
+			return LineError(line, "Unknown keyword '" + line.Get(0) + "'", error);
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,302 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MappedFile.h"
+
+// Bumped whenever a record or the layout changes, so old
+// compiled scenes are rejected rather than misread
+#define SCENE_BINARY_VERSION 1
+
+// Entities instantiated per streaming step
+#define SCENE_STREAM_CHUNK_SIZE 4096
+
+// Stands in for a missing asset index or string
+#define SCENE_NONE 0xFFFFFFFF
+
+// Renderable flags
+#define SCENE_ENTITY_STATIC 0x1
+
+// Light types, the same values as Lights.h's
+#define SCENE_LIGHT_DIRECTIONAL 0
+#define SCENE_LIGHT_POINT 1
+#define SCENE_LIGHT_SPOT 2
+
+// --------------------------------------------------------
+// The arrays a compiled scene is made of, in file order
+// --------------------------------------------------------
+enum class SceneChunk : uint32_t {
+	Strings,			// Null terminated, referenced by byte offset
+	Textures,			// SceneAsset
+	Meshes,				// SceneAsset
+	Materials,			// SceneMaterial
+	MaterialTextures,	// SceneMaterialTexture
+	Transforms,			// SceneTransform, one per entity
+	Renderables,		// SceneRenderable, one per entity
+	Lights,				// SceneLight
+	Cameras,			// SceneCamera
+	Environment,		// A single SceneEnvironment
+	Count
+};
+
+//Named file, for meshes and textures
+// - Both are string offsets, and paths are relative to the
+//    executable like everything passed to FixPath()
+struct SceneAsset {
+	uint32_t Name;
+	uint32_t Path;
+};
+
+struct SceneMaterial {
+	uint32_t Name;
+	uint32_t VertexShader;	// Compiled shader's file name
+	uint32_t PixelShader;
+	uint32_t FirstTexture;	// Range of the material textures
+	uint32_t TextureCount;
+	float Roughness;
+	uint32_t Padding[2];
+	float Tint[4];
+};
+
+//Texture bound to one of a material's shader variables
+struct SceneMaterialTexture {
+	uint32_t Slot;		// String offset of the variable's name
+	uint32_t Texture;	// Index into the textures
+};
+
+struct SceneTransform {
+	float Position[3];
+	float Rotation[3];	// Pitch, yaw and roll in radians
+	float Scale[3];
+};
+
+struct SceneRenderable {
+	uint32_t Mesh;
+	uint32_t Material;
+	uint32_t Flags;
+};
+
+//Laid out exactly like the shaders' Light, so the game can
+//copy them straight into its light buffer
+struct SceneLight {
+	int Type;
+	float Direction[3];
+	float Range;
+	float Position[3];
+	float Intensity;
+	float Color[3];
+	float SpotFalloff;
+	float Padding[3];
+};
+
+struct SceneCamera {
+	float Position[3];
+	float Rotation[3];
+	float MoveSpeed;
+	float RotationSpeed;
+	float FieldOfView;	// Radians
+};
+
+struct SceneEnvironment {
+	float AmbientColor[3];
+	uint32_t SkyMesh;		// SCENE_NONE for no sky
+	uint32_t SkyFaces[6];	// Right, left, up, down, front, back
+};
+
+// --------------------------------------------------------
+// Start of a compiled scene, followed by the chunk table
+// --------------------------------------------------------
+struct SceneFileHeader {
+	uint32_t Magic;
+	uint32_t Version;
+	uint32_t ChunkCount;
+	uint32_t Padding;
+};
+
+struct SceneChunkHeader {
+	uint32_t Type;
+	uint32_t Count;		// Records, or bytes for the strings
+	uint64_t Offset;	// From the start of the file, 16 byte aligned
+	uint64_t Size;
+};
+
+// --------------------------------------------------------
+// What SceneFile::Measure() found
+// --------------------------------------------------------
+struct SceneLoadTimings {
+	size_t EntityCount = 0;
+	size_t TextBytes = 0;
+	size_t BinaryBytes = 0;
+	double TextParseMilliseconds = 0.0;		// Parsing and compiling the text form
+	double BinaryMapMilliseconds = 0.0;		// Mapping and checking the binary form
+	double StreamMilliseconds = 0.0;		// Reading every entity's records from the mapping
+	double LongestChunkMilliseconds = 0.0;
+	unsigned int ChunkCount = 0;
+	std::string Error;						// Empty if every step worked
+};
+
+// --------------------------------------------------------
+// Read only view of one of a scene's arrays
+// --------------------------------------------------------
+template<typename T>
+struct SceneArray {
+	const T* Data = 0;
+	size_t Count = 0;
+
+	const T& operator[](size_t index) const { return Data[index]; }
+	const T* begin() const { return Data; }
+	const T* end() const { return Data + Count; }
+	bool empty() const { return Count == 0; }
+};
+
+// --------------------------------------------------------
+// Assembles a scene and compiles it to the binary layout
+//
+// - The text parser and generated scenes both go through
+//    this, so there's one place records are put together
+// - Textures, meshes and materials are referenced by name,
+//    which has to be added before anything refers to it
+// - A material's textures are the AddMaterialTexture()
+//    calls that follow it
+// --------------------------------------------------------
+class SceneBuilder {
+private:
+	std::vector<char> strings;
+	std::unordered_map<std::string, uint32_t> stringOffsets;
+
+	std::vector<SceneAsset> textures;
+	std::vector<SceneAsset> meshes;
+	std::vector<SceneMaterial> materials;
+	std::vector<SceneMaterialTexture> materialTextures;
+	std::vector<SceneTransform> transforms;
+	std::vector<SceneRenderable> renderables;
+	std::vector<SceneLight> lights;
+	std::vector<SceneCamera> cameras;
+	SceneEnvironment environment;
+
+	std::unordered_map<std::string, uint32_t> textureNames;
+	std::unordered_map<std::string, uint32_t> meshNames;
+	std::unordered_map<std::string, uint32_t> materialNames;
+
+	const char* GetString(uint32_t offset) const;
+
+public:
+	SceneBuilder();
+
+	uint32_t AddString(const std::string& text);
+
+	//Each returns the new index, or SCENE_NONE if the name's taken
+	uint32_t AddTexture(const std::string& name, const std::string& path);
+	uint32_t AddMesh(const std::string& name, const std::string& path);
+	uint32_t AddMaterial(const std::string& name, const std::string& vertexShader, const std::string& pixelShader, const float tint[4], float roughness);
+
+	//Returns false if there's no material yet to add it to
+	bool AddMaterialTexture(const std::string& slot, uint32_t texture);
+
+	void AddEntity(uint32_t mesh, uint32_t material, const SceneTransform& transform, uint32_t flags = 0);
+	void AddLight(const SceneLight& light);
+	void AddCamera(const SceneCamera& camera);
+	void SetAmbientColor(const float color[3]);
+	void SetSky(uint32_t mesh, const std::string faces[6]);
+
+	//SCENE_NONE when there's nothing by that name
+	uint32_t FindTexture(const std::string& name) const;
+	uint32_t FindMesh(const std::string& name) const;
+	uint32_t FindMaterial(const std::string& name) const;
+
+	size_t GetEntityCount() const;
+
+	//The compiled scene, exactly as it's written to disk
+	std::vector<uint8_t> Build() const;
+
+	//Writes the authoring form, for scenes made in code
+	bool WriteText(const std::wstring& path) const;
+};
+
+// --------------------------------------------------------
+// A loaded scene, read straight from its compiled form
+//
+// - Text scenes (.scene) are parsed and compiled in memory,
+//    and binary ones (.scenebin) are memory mapped, so both
+//    end up as the same image and every array is a view
+//    into it rather than a copy
+// - Entities are two parallel arrays (transforms and
+//    renderables), so instantiating a range of them reads
+//    contiguous memory, and the game streams them in a
+//    chunk at a time
+// - For a mapped file, Prefetch() asks the OS to page in a
+//    range of entities ahead of when they're needed
+// - Files are read through MappedFile, so parsing and
+//    compiling need no platform or math headers
+// --------------------------------------------------------
+class SceneFile {
+private:
+	//Image compiled from text, when the scene didn't come from a mapping
+	std::vector<uint8_t> image;
+
+	//Mapped binary file
+	MappedFile mapped;
+
+	//Whichever of the two the scene is in
+	const uint8_t* data;
+	size_t dataSize;
+	const SceneChunkHeader* chunks[(int)SceneChunk::Count];
+
+	std::string error;
+
+	bool ReadImage(const uint8_t* data, size_t size);
+	void Close();
+
+	template<typename T>
+	SceneArray<T> GetChunk(SceneChunk type) const;
+
+public:
+	SceneFile();
+	~SceneFile();
+
+	SceneFile(SceneFile const&) = delete;
+	void operator=(SceneFile const&) = delete;
+
+	//Picks text or binary from the extension
+	bool Load(const std::wstring& path);
+	bool LoadText(const std::wstring& path);
+	bool LoadBinary(const std::wstring& path);
+
+	//Parses the authoring form into a builder
+	// - On failure the error names the line
+	static bool ParseText(const char* text, size_t length, SceneBuilder& builder, std::string& error);
+
+	//Saves the compiled form of whatever's loaded
+	bool WriteBinary(const std::wstring& path) const;
+
+	//Hints that a range of entities is about to be read
+	void Prefetch(size_t firstEntity, size_t count) const;
+
+	bool IsMapped() const;
+	size_t GetByteSize() const;
+	const std::string& GetError() const;
+
+	//String at an offset from one of the records
+	// - Empty for SCENE_NONE or anything out of range
+	const char* GetString(uint32_t offset) const;
+
+	SceneArray<SceneAsset> GetTextures() const;
+	SceneArray<SceneAsset> GetMeshes() const;
+	SceneArray<SceneMaterial> GetMaterials() const;
+	SceneArray<SceneMaterialTexture> GetMaterialTextures() const;
+	SceneArray<SceneTransform> GetTransforms() const;
+	SceneArray<SceneRenderable> GetRenderables() const;
+	SceneArray<SceneLight> GetLights() const;
+	SceneArray<SceneCamera> GetCameras() const;
+	const SceneEnvironment& GetEnvironment() const;
+	size_t GetEntityCount() const;
+
+	//Times loading a random scene of the given size from its
+	//text form and from its binary form, written to the two
+	//paths, then reading every entity a chunk at a time
+	static SceneLoadTimings Measure(size_t entityCount, const std::wstring& textPath, const std::wstring& binaryPath);
+};
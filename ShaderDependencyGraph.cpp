@@ -0,0 +1,187 @@
+#include "ShaderDependencyGraph.h"
+
+#include <algorithm>
+#include <cctype>
+#include <unordered_set>
+
+std::string ShaderDependencyGraph::NormalizePath(const std::string& path) {
+	std::vector<std::string> parts;
+	std::string part;
+
+	//Splits on either slash, dropping "." and folding ".."
+	auto addPart = [&parts](std::string& part) {
+		if (part == "..") {
+			if (!parts.empty() && parts.back() != "..") parts.pop_back();
+			else parts.push_back(part);
+		}
+		else if (!part.empty() && part != ".") {
+			parts.push_back(part);
+		}
+		part.clear();
+	};
+
+	for (char c : path) {
+		if (c == '/' || c == '\\') addPart(part);
+		else part += (char)tolower((unsigned char)c);
+	}
+	addPart(part);
+
+	std::string normalized;
+	for (size_t i = 0; i < parts.size(); i++) {
+		if (i > 0) normalized += '/';
+		normalized += parts[i];
+	}
+
+	return normalized;
+}
+
+// --------------------------------------------------------
+// Finds #include "name" and #include <name> lines
+//  - Whole line comments are skipped, block comments aren't
+// --------------------------------------------------------
+std::vector<std::string> ShaderDependencyGraph::ParseIncludes(const char* text, size_t length) {
+	std::vector<std::string> names;
+
+	size_t start = 0;
+	while (start < length) {
+		size_t end = start;
+		while (end < length && text[end] != '\n') end++;
+
+		size_t i = start;
+		auto skipSpaces = [&]() { while (i < end && (text[i] == ' ' || text[i] == '\t')) i++; };
+
+		skipSpaces();
+		if (i < end && text[i] == '#') {
+			i++;
+			skipSpaces();
+
+			static const char include[] = "include";
+			size_t includeLength = sizeof(include) - 1;
+			if (end - i > includeLength && std::equal(include, include + includeLength, text + i)) {
+				i += includeLength;
+				skipSpaces();
+
+				if (i < end && (text[i] == '"' || text[i] == '<')) {
+					char close = text[i] == '"' ? '"' : '>';
+					size_t nameStart = ++i;
+					while (i < end && text[i] != close) i++;
+
+					if (i < end && i > nameStart) names.push_back(std::string(text + nameStart, i - nameStart));
+				}
+			}
+		}
+
+		start = end + 1;
+	}
+
+	return names;
+}
+
+void ShaderDependencyGraph::SetIncludes(const std::string& file, const std::vector<std::string>& names) {
+	std::string normalized = NormalizePath(file);
+
+	//Names are relative to the including file's folder
+	size_t slash = normalized.rfind('/');
+	std::string folder = slash == std::string::npos ? "" : normalized.substr(0, slash + 1);
+
+	std::vector<std::string>& resolved = includes[normalized];
+	resolved.clear();
+	for (const std::string& name : names) {
+		std::string path = NormalizePath(folder + name);
+		if (std::find(resolved.begin(), resolved.end(), path) == resolved.end()) resolved.push_back(path);
+	}
+}
+
+bool ShaderDependencyGraph::Contains(const std::string& file) const {
+	return includes.find(NormalizePath(file)) != includes.end();
+}
+
+std::vector<std::string> ShaderDependencyGraph::GetUnscannedFiles() const {
+	std::vector<std::string> unscanned;
+	for (auto& file : includes) {
+		for (const std::string& included : file.second) {
+			if (includes.find(included) == includes.end() &&
+				std::find(unscanned.begin(), unscanned.end(), included) == unscanned.end()) {
+				unscanned.push_back(included);
+			}
+		}
+	}
+
+	std::sort(unscanned.begin(), unscanned.end());
+	return unscanned;
+}
+
+std::vector<std::string> ShaderDependencyGraph::GetFiles() const {
+	std::vector<std::string> files;
+	for (auto& file : includes) files.push_back(file.first);
+
+	std::vector<std::string> unscanned = GetUnscannedFiles();
+	files.insert(files.end(), unscanned.begin(), unscanned.end());
+
+	std::sort(files.begin(), files.end());
+	return files;
+}
+
+// --------------------------------------------------------
+// Walks the includes backwards from a file
+//  - Include cycles are fine, as each file is only visited
+//     once
+// --------------------------------------------------------
+std::vector<std::string> ShaderDependencyGraph::GetDependents(const std::string& file) const {
+	std::unordered_map<std::string, std::vector<std::string>> includedBy;
+	for (auto& including : includes) {
+		for (const std::string& included : including.second) {
+			includedBy[included].push_back(including.first);
+		}
+	}
+
+	std::string start = NormalizePath(file);
+	std::vector<std::string> dependents;
+	std::unordered_set<std::string> visited;
+	std::vector<std::string> open(1, start);
+	visited.insert(start);
+
+	while (!open.empty()) {
+		std::string current = open.back();
+		open.pop_back();
+		dependents.push_back(current);
+
+		auto parents = includedBy.find(current);
+		if (parents == includedBy.end()) continue;
+
+		for (const std::string& parent : parents->second) {
+			if (visited.insert(parent).second) open.push_back(parent);
+		}
+	}
+
+	std::sort(dependents.begin(), dependents.end());
+	return dependents;
+}
+
+ChangeDebouncer::ChangeDebouncer(double delaySeconds) :
+	delay(delaySeconds) {
+}
+
+void ChangeDebouncer::Record(const std::string& file, double time) {
+	pending[file] = time;
+}
+
+std::vector<std::string> ChangeDebouncer::TakeReady(double time) {
+	std::vector<std::string> ready;
+	for (auto it = pending.begin(); it != pending.end();) {
+		if (time - it->second >= delay) {
+			ready.push_back(it->first);
+			it = pending.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+
+	std::sort(ready.begin(), ready.end());
+	return ready;
+}
+
+size_t ChangeDebouncer::GetPendingCount() const {
+	return pending.size();
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// --------------------------------------------------------
+// Which shader files include which
+//
+// - Paths are normalized (lower case, forward slashes, no
+//    "." or ".." parts) so the same file is always one key
+// - Includes resolve relative to the including file, the
+//    same way D3D's standard include handler does
+// - Asking what depends on an .hlsli walks the includes
+//    backwards, so a change to a shared header finds every
+//    shader that has to be rebuilt
+// --------------------------------------------------------
+class ShaderDependencyGraph {
+private:
+	std::unordered_map<std::string, std::vector<std::string>> includes; // File to what it includes
+
+public:
+	static std::string NormalizePath(const std::string& path);
+
+	//Names in the #include lines of a file, as written
+	static std::vector<std::string> ParseIncludes(const char* text, size_t length);
+
+	//Replaces what a file includes, resolving the names from
+	// ParseIncludes() against the file's own folder
+	void SetIncludes(const std::string& file, const std::vector<std::string>& names);
+
+	bool Contains(const std::string& file) const;
+
+	//Files something includes that haven't been read yet
+	std::vector<std::string> GetUnscannedFiles() const;
+
+	//Every file in the graph, included or including
+	std::vector<std::string> GetFiles() const;
+
+	//The file and everything that includes it, directly or not
+	std::vector<std::string> GetDependents(const std::string& file) const;
+};
+
+// --------------------------------------------------------
+// Holds file changes until they've been quiet for a while
+//
+// - Editors often save in several writes, and compiling a
+//    half written file just reports errors, so a file only
+//    comes out once it hasn't changed for the delay
+// - Times are seconds from whatever clock the caller uses
+// --------------------------------------------------------
+class ChangeDebouncer {
+private:
+	double delay;
+	std::unordered_map<std::string, double> pending; // Time of each file's latest change
+
+public:
+	ChangeDebouncer(double delaySeconds);
+
+	void Record(const std::string& file, double time);
+
+	//Files that have settled, sorted, and no longer pending
+	std::vector<std::string> TakeReady(double time);
+
+	size_t GetPendingCount() const;
+};
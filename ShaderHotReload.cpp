@@ -0,0 +1,246 @@
+#include "ShaderHotReload.h"
+#include "Helpers.h"
+#include "Profiler.h"
+
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <unordered_set>
+
+#pragma comment(lib, "d3dcompiler.lib")
+
+ShaderHotReload::ShaderHotReload(const std::wstring& sourceDirectory) :
+	sourceDirectory(sourceDirectory),
+	debouncer(SHADER_RELOAD_DEBOUNCE_SECONDS),
+	fileCount(0),
+	compileCount(0),
+	reloadCount(0) {
+	stopEvent = CreateEventW(0, TRUE, FALSE, 0);
+	watcher = std::thread(&ShaderHotReload::WatchLoop, this);
+}
+
+ShaderHotReload::~ShaderHotReload() {
+	SetEvent(stopEvent);
+	if (watcher.joinable()) watcher.join();
+	CloseHandle(stopEvent);
+}
+
+void ShaderHotReload::Watch(
+	std::shared_ptr<ISimpleShader> shader,
+	const std::string& source,
+	const std::string& profile,
+	const std::vector<std::pair<std::string, std::string>>& defines) {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	for (const Target& target : targets) {
+		if (target.Key == shader.get() && !target.Shader.expired()) return;
+	}
+
+	Target target;
+	target.Key = shader.get();
+	target.Shader = shader;
+	target.Source = ShaderDependencyGraph::NormalizePath(source);
+	target.Profile = profile;
+	target.Defines = defines;
+	targets.push_back(target);
+}
+
+// --------------------------------------------------------
+// The watcher thread
+//  - Wakes on a change notification for the folder, or
+//     every poll otherwise so debounced files come out
+//  - Write times decide what actually changed, since the
+//     notification doesn't say
+// --------------------------------------------------------
+void ShaderHotReload::WatchLoop() {
+	Profiler::GetInstance().SetThreadName("Shader Watcher");
+
+	typedef std::chrono::steady_clock Clock;
+	Clock::time_point start = Clock::now();
+
+	HANDLE change = FindFirstChangeNotificationW(
+		sourceDirectory.c_str(),
+		TRUE,
+		FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+
+	while (true) {
+		HANDLE handles[2] = { stopEvent, change };
+		DWORD handleCount = change == INVALID_HANDLE_VALUE ? 1 : 2;
+		DWORD wait = WaitForMultipleObjects(handleCount, handles, FALSE, SHADER_RELOAD_POLL_MS);
+		if (wait == WAIT_OBJECT_0) break;
+		if (wait == WAIT_OBJECT_0 + 1) FindNextChangeNotification(change);
+
+		double now = std::chrono::duration<double>(Clock::now() - start).count();
+
+		//Newly watched sources, and whatever they include
+		std::vector<std::string> sources;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			for (const Target& target : targets) sources.push_back(target.Source);
+		}
+
+		for (const std::string& source : sources) {
+			if (!graph.Contains(source)) ScanFile(source);
+		}
+
+		for (std::vector<std::string> unscanned = graph.GetUnscannedFiles(); !unscanned.empty(); unscanned = graph.GetUnscannedFiles()) {
+			for (const std::string& file : unscanned) ScanFile(file);
+		}
+
+		//Files are first seen as they are, so only later writes count
+		std::vector<std::string> files = graph.GetFiles();
+		fileCount = files.size();
+		for (const std::string& file : files) {
+			uint64_t writeTime = GetWriteTime(file);
+			auto known = writeTimes.find(file);
+
+			if (known == writeTimes.end()) {
+				writeTimes[file] = writeTime;
+			}
+			else if (known->second != writeTime) {
+				known->second = writeTime;
+				debouncer.Record(file, now);
+			}
+		}
+
+		//Settled files rebuild every shader that includes them
+		std::unordered_set<std::string> rebuild;
+		for (const std::string& file : debouncer.TakeReady(now)) {
+			ScanFile(file);
+
+			for (const std::string& dependent : graph.GetDependents(file)) {
+				rebuild.insert(dependent);
+			}
+		}
+
+		if (rebuild.empty()) continue;
+
+		std::vector<Target> toCompile;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			for (const Target& target : targets) {
+				if (rebuild.count(target.Source) && !target.Shader.expired()) toCompile.push_back(target);
+			}
+		}
+
+		for (const Target& target : toCompile) {
+			Compile(target);
+		}
+	}
+
+	if (change != INVALID_HANDLE_VALUE) FindCloseChangeNotification(change);
+}
+
+// --------------------------------------------------------
+// Reads a file's includes into the graph
+//  - A missing file is added with none, so it's not read
+//     again until it changes
+// --------------------------------------------------------
+void ShaderHotReload::ScanFile(const std::string& file) {
+	std::ifstream input(sourceDirectory + NarrowToWide(file), std::ios::binary);
+	std::string text;
+	if (input) text.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+
+	graph.SetIncludes(file, ShaderDependencyGraph::ParseIncludes(text.data(), text.size()));
+}
+
+uint64_t ShaderHotReload::GetWriteTime(const std::string& file) {
+	WIN32_FILE_ATTRIBUTE_DATA data = {};
+	if (!GetFileAttributesExW((sourceDirectory + NarrowToWide(file)).c_str(), GetFileExInfoStandard, &data)) {
+		return 0;
+	}
+
+	return ((uint64_t)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+}
+
+void ShaderHotReload::Compile(const Target& target) {
+	PROFILE_SCOPE("Compile Shader");
+
+	std::vector<D3D_SHADER_MACRO> macros;
+	for (auto& define : target.Defines) {
+		macros.push_back({ define.first.c_str(), define.second.c_str() });
+	}
+	macros.push_back({ 0, 0 });
+
+	//Matches what the project builds each configuration with
+#if defined(DEBUG) || defined(_DEBUG)
+	UINT flags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+#else
+	UINT flags = D3DCOMPILE_OPTIMIZATION_LEVEL3;
+#endif
+
+	Microsoft::WRL::ComPtr<ID3DBlob> blob;
+	Microsoft::WRL::ComPtr<ID3DBlob> errors;
+	HRESULT hr = D3DCompileFromFile(
+		(sourceDirectory + NarrowToWide(target.Source)).c_str(),
+		macros.data(),
+		D3D_COMPILE_STANDARD_FILE_INCLUDE,
+		"main",
+		target.Profile.c_str(),
+		flags,
+		0,
+		blob.GetAddressOf(),
+		errors.GetAddressOf());
+
+	compileCount++;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (FAILED(hr)) {
+		lastError = errors ? std::string((const char*)errors->GetBufferPointer(), errors->GetBufferSize()) : target.Source + ": couldn't compile";
+		return;
+	}
+
+	CompiledShader result;
+	result.Shader = target.Shader;
+	result.Blob = blob;
+	result.Source = target.Source;
+	compiled.push_back(result);
+	lastError.clear();
+}
+
+std::vector<ISimpleShader*> ShaderHotReload::ApplyPending() {
+	std::vector<CompiledShader> ready;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		ready.swap(compiled);
+	}
+
+	std::vector<ISimpleShader*> reloaded;
+	for (const CompiledShader& result : ready) {
+		std::shared_ptr<ISimpleShader> shader = result.Shader.lock();
+		if (!shader) continue;
+
+		if (shader->Reload(result.Blob)) {
+			reloaded.push_back(shader.get());
+			reloadCount++;
+		}
+		else {
+			std::lock_guard<std::mutex> lock(mutex);
+			lastError = result.Source + ": compiled, but couldn't create the shader";
+		}
+	}
+
+	return reloaded;
+}
+
+size_t ShaderHotReload::GetWatchedCount() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return targets.size();
+}
+
+size_t ShaderHotReload::GetFileCount() {
+	return fileCount;
+}
+
+unsigned int ShaderHotReload::GetCompileCount() {
+	return compileCount;
+}
+
+unsigned int ShaderHotReload::GetReloadCount() {
+	return reloadCount;
+}
+
+std::string ShaderHotReload::GetLastError() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return lastError;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <Windows.h>
+#include <d3d11.h>
+#include <wrl/client.h> // Used for ComPtr - a smart pointer for COM objects
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "SimpleShader.h"
+#include "ShaderDependencyGraph.h"
+
+// How often the watcher checks files when nothing wakes it sooner
+#define SHADER_RELOAD_POLL_MS 100
+
+// How long a file has to stop changing before it's compiled
+#define SHADER_RELOAD_DEBOUNCE_SECONDS 0.25
+
+// --------------------------------------------------------
+// Recompiles shaders when their source changes
+//
+// - A background thread watches the source folder, and
+//    follows each watched shader's #includes, so editing
+//    ShaderIncludes.hlsli rebuilds everything using it
+// - Changes are debounced, then compiled on that same
+//    thread with each shader's own profile and defines
+// - Nothing is swapped until ApplyPending(), which the
+//    game calls between frames; shaders are reloaded in
+//    place, so everything holding one picks up the new code
+//    and its variable values carry over
+// - A compile error leaves the old shader running and is
+//    kept for the inspector
+// --------------------------------------------------------
+class ShaderHotReload {
+private:
+	struct Target {
+		ISimpleShader* Key;
+		std::weak_ptr<ISimpleShader> Shader;
+		std::string Source;	// Normalized, relative to the source folder
+		std::string Profile;
+		std::vector<std::pair<std::string, std::string>> Defines;
+	};
+
+	struct CompiledShader {
+		std::weak_ptr<ISimpleShader> Shader;
+		Microsoft::WRL::ComPtr<ID3DBlob> Blob;
+		std::string Source;
+	};
+
+	std::wstring sourceDirectory;
+
+	//Shared with the watcher, under the mutex
+	std::mutex mutex;
+	std::vector<Target> targets;
+	std::vector<CompiledShader> compiled;
+	std::string lastError;
+
+	//Only touched by the watcher
+	ShaderDependencyGraph graph;
+	ChangeDebouncer debouncer;
+	std::unordered_map<std::string, uint64_t> writeTimes;
+
+	std::atomic<size_t> fileCount;
+	std::atomic<unsigned int> compileCount;
+	unsigned int reloadCount;
+
+	HANDLE stopEvent;
+	std::thread watcher;
+
+	void WatchLoop();
+	void ScanFile(const std::string& file);
+	uint64_t GetWriteTime(const std::string& file);
+	void Compile(const Target& target);
+
+public:
+	//Sources are found relative to the folder given
+	ShaderHotReload(const std::wstring& sourceDirectory);
+	~ShaderHotReload();
+
+	ShaderHotReload(ShaderHotReload const&) = delete;
+	void operator=(ShaderHotReload const&) = delete;
+
+	//Starts watching a shader's source
+	// - Defines are for variants, so they rebuild as themselves
+	void Watch(
+		std::shared_ptr<ISimpleShader> shader,
+		const std::string& source,
+		const std::string& profile,
+		const std::vector<std::pair<std::string, std::string>>& defines = std::vector<std::pair<std::string, std::string>>());
+
+	//Swaps in everything that finished compiling
+	// - Main thread only, between frames
+	// - Returns the shaders that changed, so cached
+	//    reflection can be refreshed
+	std::vector<ISimpleShader*> ApplyPending();
+
+	size_t GetWatchedCount();
+	size_t GetFileCount();
+	unsigned int GetCompileCount();
+	unsigned int GetReloadCount();
+	std::string GetLastError();
+};
@@ -7,6 +7,11 @@
 #define LIGHT_TYPE_SPOT 2
 #define MAX_SPECULAR_EXPONENT 256.0f
 
+// Size of the clustered lighting grid (must match LightBinner.h)
+#define CLUSTER_COUNT_X 16
+#define CLUSTER_COUNT_Y 9
+#define CLUSTER_COUNT_Z 24
+
 // The fresnel value for non-metals (dielectrics)
 // Page 9: "F0 of nonmetals is now a constant 0.04"
 // http://blog.selfshadow.com/publications/s2013-shading-course/karis/s2013_pbs_epic_notes_v2.pdf
@@ -50,15 +55,16 @@ struct VertexToPixel_Sky {
 };
 
 //Light struct
+// - Lights.h gets its Light from this, through ShaderStructs.h
 struct Light {
-	int Type : L_TYPE;
-	float3 Direction	: L_DIRECTION;
-	float Range : L_RANGE;
-	float3 Position		: L_POSITION;
-	float Intensity : L_INTENSITY;
-	float3 Color		: L_COLOR;
-	float SpotFalloff : L_FALLOFF;
-	float3 Padding		: L_PADDING;
+	int Type : L_TYPE;				// Which kind of light? 0, 1 or 2 (see Lights.h)
+	float3 Direction	: L_DIRECTION;	// Directional and Spot lights need a direction
+	float Range : L_RANGE;			// Point and Spot lights have a max range for attenuation
+	float3 Position		: L_POSITION;	// Point and Spot lights have a position in space
+	float Intensity : L_INTENSITY;	// All lights need an intensity
+	float3 Color		: L_COLOR;		// All lights need a color
+	float SpotFalloff : L_FALLOFF;	// Spot lights need a value to define their "cone" size
+	float3 Padding		: L_PADDING;	// Purposefully padding to hit the 16-byte boundary
 };
 
 //Pseudo-Random Function for noise
@@ -211,6 +217,21 @@ float3 CalculateDirectionalLight(Light incomingLight, float3 normal, float4 surf
 	return total;
 }
 
+//Calculate Directional Lighting without PBR
+// - For materials with only a roughness value and no maps
+float3 CalculateDirectionalLightPhong(Light incomingLight, float3 normal, float4 surfaceColor, float3 cameraPos, float3 worldPos, float roughness) {
+	float3 lightDirection = normalize(incomingLight.Direction);
+
+	float3 diffuse = Diffuse(normal, -lightDirection);
+
+	float3 V = normalize(cameraPos - worldPos);
+	float3 R = reflect(lightDirection, normal);
+	float spec = Specular(R, V, roughness);
+	spec *= any(diffuse);
+
+	return (diffuse * surfaceColor.xyz + spec) * incomingLight.Intensity * incomingLight.Color;
+}
+
 //Calculate Point Lighting
 float3 CalculatePointLight(Light incomingLight, float3 normal, float4 surfaceColor, float3 ambient, float3 cameraPos, float3 worldPos, float roughness, float specTex) {
 	float3 surfaceToLight = normalize(incomingLight.Position - worldPos);
@@ -232,4 +253,19 @@ float3 CalculatePointLight(Light incomingLight, float3 normal, float4 surfaceCol
 
 	return l * attenuation;
 }
+
+//Spot light cone falloff
+// - 1 along the light's direction, fading to 0 at 90 degrees
+// - Higher SpotFalloff values give a narrower cone
+float SpotTerm(Light light, float3 worldPos) {
+	float3 surfaceToLight = normalize(light.Position - worldPos);
+	float pixelAngle = saturate(dot(-surfaceToLight, normalize(light.Direction)));
+	return pow(pixelAngle, light.SpotFalloff);
+}
+
+//Calculate Spot Lighting
+// - A point light, cut down to the light's cone
+float3 CalculateSpotLight(Light incomingLight, float3 normal, float4 surfaceColor, float3 ambient, float3 cameraPos, float3 worldPos, float roughness, float specTex) {
+	return CalculatePointLight(incomingLight, normal, surfaceColor, ambient, cameraPos, worldPos, roughness, specTex) * SpotTerm(incomingLight, worldPos);
+}
 #endif
\ No newline at end of file
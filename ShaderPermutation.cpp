@@ -0,0 +1,408 @@
+#include "ShaderPermutation.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+// Prefix of a keyword declaration in shader source
+#define SHADER_KEYWORD_PREFIX "//@keyword"
+
+// --------------------------------------------------------
+// Splits a line on spaces and tabs
+// --------------------------------------------------------
+static std::vector<std::string> SplitTokens(const std::string& line) {
+	std::vector<std::string> tokens;
+	std::istringstream stream(line);
+	std::string token;
+	while (stream >> token) tokens.push_back(token);
+	return tokens;
+}
+
+// --------------------------------------------------------
+// Calls back with each line and its number
+//  - Handles both line endings
+// --------------------------------------------------------
+template<typename F>
+static bool ForEachLine(const char* text, size_t length, F callback) {
+	size_t start = 0;
+	int number = 1;
+	while (start < length) {
+		size_t end = start;
+		while (end < length && text[end] != '\n') end++;
+
+		size_t trimmed = end;
+		if (trimmed > start && text[trimmed - 1] == '\r') trimmed--;
+
+		if (!callback(std::string(text + start, trimmed - start), number)) return false;
+
+		start = end + 1;
+		number++;
+	}
+
+	return true;
+}
+
+static bool ParseInt(const std::string& token, int& value) {
+	char* end = 0;
+	long parsed = strtol(token.c_str(), &end, 0);
+	if (token.empty() || *end != '\0') return false;
+
+	value = (int)parsed;
+	return true;
+}
+
+static bool ParseUnsigned(const std::string& token, uint32_t& value) {
+	char* end = 0;
+	unsigned long parsed = strtoul(token.c_str(), &end, 0);
+	if (token.empty() || token[0] == '-' || *end != '\0') return false;
+
+	value = (uint32_t)parsed;
+	return true;
+}
+
+// --------------------------------------------------------
+// Reads a keyword from the tokens after "keyword"
+//  - NAME exact|ordered VALUE... [binds RESOURCE...]
+// --------------------------------------------------------
+static bool ParseKeyword(const std::vector<std::string>& tokens, size_t first, ShaderKeyword& keyword, std::string& error) {
+	if (tokens.size() < first + 3) {
+		error = "a keyword needs a name, exact or ordered, and a value";
+		return false;
+	}
+
+	keyword.Name = tokens[first];
+	if (tokens[first + 1] == "exact") keyword.Ordered = false;
+	else if (tokens[first + 1] == "ordered") keyword.Ordered = true;
+	else {
+		error = "expected exact or ordered after " + keyword.Name;
+		return false;
+	}
+
+	size_t i = first + 2;
+	for (; i < tokens.size() && tokens[i] != "binds"; i++) {
+		int value = 0;
+		if (!ParseInt(tokens[i], value)) {
+			error = "bad value " + tokens[i] + " for " + keyword.Name;
+			return false;
+		}
+
+		//Ordered keywords compare by value, so they have to go up
+		if (keyword.Ordered && !keyword.Values.empty() && value <= keyword.Values.back()) {
+			error = "ordered values for " + keyword.Name + " have to increase";
+			return false;
+		}
+
+		keyword.Values.push_back(value);
+	}
+
+	if (keyword.Values.empty()) {
+		error = keyword.Name + " has no values";
+		return false;
+	}
+
+	if (i < tokens.size()) {
+		keyword.Bindings.assign(tokens.begin() + i + 1, tokens.end());
+		if (keyword.Bindings.empty()) {
+			error = "binds needs at least one resource for " + keyword.Name;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// --------------------------------------------------------
+// Checks the keywords fit in a key once they're all added
+// --------------------------------------------------------
+static bool CheckKeywords(const std::vector<ShaderKeyword>& keywords, std::string& error) {
+	if (keywords.size() > SHADER_MAX_KEYWORDS) {
+		error = "too many keywords";
+		return false;
+	}
+
+	unsigned int bits = 0;
+	for (size_t i = 0; i < keywords.size(); i++) {
+		bits += keywords[i].GetBitCount();
+
+		for (size_t j = 0; j < i; j++) {
+			if (keywords[i].Name == keywords[j].Name) {
+				error = "keyword " + keywords[i].Name + " declared twice";
+				return false;
+			}
+		}
+	}
+
+	if (bits > 32) {
+		error = "keywords need more than 32 bits";
+		return false;
+	}
+
+	return true;
+}
+
+unsigned int ShaderKeyword::GetBitCount() const {
+	unsigned int bits = 0;
+	while ((size_t(1) << bits) < Values.size()) bits++;
+	return bits;
+}
+
+bool ShaderPermutationSet::Parse(const char* text, size_t length, ShaderPermutationSet& set, std::string& error) {
+	set.Keywords.clear();
+
+	bool parsed = ForEachLine(text, length, [&](const std::string& line, int number) {
+		size_t start = line.find_first_not_of(" \t");
+		if (start == std::string::npos || line.compare(start, sizeof(SHADER_KEYWORD_PREFIX) - 1, SHADER_KEYWORD_PREFIX) != 0) {
+			return true;
+		}
+
+		ShaderKeyword keyword;
+		if (!ParseKeyword(SplitTokens(line.substr(start)), 1, keyword, error)) {
+			error = "Line " + std::to_string(number) + ": " + error;
+			return false;
+		}
+
+		set.Keywords.push_back(keyword);
+		return true;
+	});
+
+	return parsed && CheckKeywords(set.Keywords, error);
+}
+
+uint32_t ShaderPermutationSet::GetVariantCount() const {
+	uint32_t count = 1;
+	for (const ShaderKeyword& keyword : Keywords) {
+		count *= (uint32_t)keyword.Values.size();
+	}
+
+	return count;
+}
+
+// --------------------------------------------------------
+// Counts through every combination of values, with the
+// first keyword changing fastest
+// --------------------------------------------------------
+ShaderPermutationKey ShaderPermutationSet::GetKey(uint32_t variant) const {
+	ShaderPermutationKey key = 0;
+	unsigned int shift = 0;
+
+	for (const ShaderKeyword& keyword : Keywords) {
+		uint32_t count = (uint32_t)keyword.Values.size();
+		key |= (variant % count) << shift;
+		variant /= count;
+		shift += keyword.GetBitCount();
+	}
+
+	return key;
+}
+
+int ShaderPermutationSet::GetValue(ShaderPermutationKey key, size_t keyword) const {
+	unsigned int shift = 0;
+	for (size_t i = 0; i < keyword; i++) {
+		shift += Keywords[i].GetBitCount();
+	}
+
+	const ShaderKeyword& found = Keywords[keyword];
+	uint32_t mask = (1u << found.GetBitCount()) - 1;
+	uint32_t index = (key >> shift) & mask;
+
+	//Keys from a stale manifest can point past the end
+	if (index >= found.Values.size()) index = (uint32_t)found.Values.size() - 1;
+
+	return found.Values[index];
+}
+
+std::vector<std::pair<std::string, std::string>> ShaderPermutationSet::GetDefines(ShaderPermutationKey key) const {
+	std::vector<std::pair<std::string, std::string>> defines;
+	for (size_t i = 0; i < Keywords.size(); i++) {
+		defines.push_back({ Keywords[i].Name, std::to_string(GetValue(key, i)) });
+	}
+
+	return defines;
+}
+
+bool ShaderPermutationSet::Matches(ShaderPermutationKey key, const ShaderFeatureRequest& request) const {
+	for (size_t i = 0; i < Keywords.size(); i++) {
+		const ShaderKeyword& keyword = Keywords[i];
+
+		auto requested = request.Values.find(keyword.Name);
+		int wanted = requested == request.Values.end() ? keyword.Values.front() : requested->second;
+		int value = GetValue(key, i);
+
+		if (keyword.Ordered ? value < wanted : value != wanted) return false;
+	}
+
+	return true;
+}
+
+// --------------------------------------------------------
+// 64 bit FNV-1a of the shader's name and defines
+// --------------------------------------------------------
+uint64_t ShaderPermutationSet::Hash(ShaderPermutationKey key) const {
+	uint64_t hash = 14695981039346656037ull;
+	auto add = [&hash](const std::string& text) {
+		for (char c : text) {
+			hash ^= (uint8_t)c;
+			hash *= 1099511628211ull;
+		}
+	};
+
+	add(Shader);
+	for (auto& define : GetDefines(key)) {
+		add(";" + define.first + "=" + define.second);
+	}
+
+	return hash;
+}
+
+std::string ShaderPermutationSet::GetVariantFile(ShaderPermutationKey key) const {
+	char hash[17];
+	snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)Hash(key));
+	return Shader + "_" + hash + ".cso";
+}
+
+bool ShaderManifest::Parse(const char* text, size_t length, std::string& error) {
+	Clear();
+
+	bool parsed = ForEachLine(text, length, [&](const std::string& line, int number) {
+		std::vector<std::string> tokens = SplitTokens(line);
+		if (tokens.empty() || tokens[0][0] == '#') return true;
+
+		std::string lineError;
+		if (tokens[0] == "shader" && tokens.size() == 4) {
+			ShaderPermutationSet set;
+			set.Shader = tokens[1];
+			set.Source = tokens[2];
+			set.Profile = tokens[3];
+			AddShader(set);
+		}
+		else if (tokens[0] == "keyword" && !shaders.empty()) {
+			ShaderKeyword keyword;
+			if (!ParseKeyword(tokens, 1, keyword, lineError)) {
+				error = "Line " + std::to_string(number) + ": " + lineError;
+				return false;
+			}
+
+			shaders.back().Keywords.push_back(keyword);
+		}
+		else if (tokens[0] == "variant" && tokens.size() == 4 && !shaders.empty()) {
+			uint32_t key = 0;
+			uint32_t cost = 0;
+			if (!ParseUnsigned(tokens[1], key) || !ParseUnsigned(tokens[3], cost)) {
+				error = "Line " + std::to_string(number) + ": bad variant";
+				return false;
+			}
+
+			ShaderVariant variant;
+			variant.Key = key;
+			variant.File = tokens[2];
+			variant.Cost = cost;
+			AddVariant(variant);
+		}
+		else {
+			error = "Line " + std::to_string(number) + ": unexpected " + tokens[0];
+			return false;
+		}
+
+		return true;
+	});
+
+	if (!parsed) return false;
+
+	for (const ShaderPermutationSet& set : shaders) {
+		if (!CheckKeywords(set.Keywords, error)) {
+			error = set.Shader + ": " + error;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+std::string ShaderManifest::Write() const {
+	std::ostringstream text;
+	text << "# Shader variants, written by -buildshaders\n";
+
+	for (size_t i = 0; i < shaders.size(); i++) {
+		const ShaderPermutationSet& set = shaders[i];
+		text << "\nshader " << set.Shader << " " << set.Source << " " << set.Profile << "\n";
+
+		for (const ShaderKeyword& keyword : set.Keywords) {
+			text << "keyword " << keyword.Name << (keyword.Ordered ? " ordered" : " exact");
+			for (int value : keyword.Values) text << " " << value;
+
+			if (!keyword.Bindings.empty()) {
+				text << " binds";
+				for (const std::string& binding : keyword.Bindings) text << " " << binding;
+			}
+
+			text << "\n";
+		}
+
+		for (const ShaderVariant& variant : variants[i]) {
+			text << "variant " << variant.Key << " " << variant.File << " " << variant.Cost << "\n";
+		}
+	}
+
+	return text.str();
+}
+
+void ShaderManifest::Clear() {
+	shaders.clear();
+	variants.clear();
+}
+
+void ShaderManifest::AddShader(const ShaderPermutationSet& set) {
+	shaders.push_back(set);
+	variants.emplace_back();
+}
+
+void ShaderManifest::AddVariant(const ShaderVariant& variant) {
+	if (!variants.empty()) variants.back().push_back(variant);
+}
+
+const ShaderPermutationSet* ShaderManifest::FindShader(const std::string& shader) const {
+	for (const ShaderPermutationSet& set : shaders) {
+		if (set.Shader == shader) return &set;
+	}
+
+	return 0;
+}
+
+const std::vector<ShaderVariant>* ShaderManifest::FindVariants(const std::string& shader) const {
+	for (size_t i = 0; i < shaders.size(); i++) {
+		if (shaders[i].Shader == shader) return &variants[i];
+	}
+
+	return 0;
+}
+
+size_t ShaderManifest::GetShaderCount() const {
+	return shaders.size();
+}
+
+size_t ShaderManifest::GetVariantCount() const {
+	size_t count = 0;
+	for (auto& shaderVariants : variants) count += shaderVariants.size();
+	return count;
+}
+
+// --------------------------------------------------------
+// Picks the lowest cost variant that supports the request
+//  - Ties go to the lower key, so the choice is stable
+// --------------------------------------------------------
+const ShaderVariant* ShaderManifest::Select(const std::string& shader, const ShaderFeatureRequest& request) const {
+	const ShaderPermutationSet* set = FindShader(shader);
+	const std::vector<ShaderVariant>* shaderVariants = FindVariants(shader);
+	if (!set || !shaderVariants) return 0;
+
+	const ShaderVariant* best = 0;
+	for (const ShaderVariant& variant : *shaderVariants) {
+		if (!set->Matches(variant.Key, request)) continue;
+
+		if (!best || variant.Cost < best->Cost || (variant.Cost == best->Cost && variant.Key < best->Key)) {
+			best = &variant;
+		}
+	}
+
+	return best;
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// File the variant builder writes next to the executable
+#define SHADER_MANIFEST_FILE "ShaderVariants.manifest"
+
+// Keywords a single shader can declare, so every key fits in 32 bits
+#define SHADER_MAX_KEYWORDS 16
+
+// Each keyword's value index, packed into as few bits as it needs
+typedef uint32_t ShaderPermutationKey;
+
+// --------------------------------------------------------
+// A feature a shader can be specialized on
+//
+// - Declared in the shader source with a comment, so fxc
+//   ignores it and the builder can still find it:
+//     //@keyword NORMAL_MAP exact 0 1 binds NormalMap
+// - Each value is a #define the variant is compiled with,
+//   cheapest first
+// - Exact keywords need the value asked for, while ordered
+//   ones can use any higher value instead
+// - A keyword that binds resources is turned on when the
+//   material has all of them, rather than by the scene
+// --------------------------------------------------------
+struct ShaderKeyword {
+	std::string Name;
+	std::vector<int> Values;
+	bool Ordered;
+	std::vector<std::string> Bindings;
+
+	unsigned int GetBitCount() const;
+};
+
+// --------------------------------------------------------
+// What a variant has to support
+//  - Keywords left out ask for their first value
+// --------------------------------------------------------
+struct ShaderFeatureRequest {
+	std::unordered_map<std::string, int> Values;
+};
+
+struct ShaderVariant {
+	ShaderPermutationKey Key;
+	std::string File;	// Compiled shader, relative to the manifest
+	uint32_t Cost;		// Instruction count, from reflection
+};
+
+// --------------------------------------------------------
+// A shader's keywords, and every combination of them
+// --------------------------------------------------------
+struct ShaderPermutationSet {
+	std::string Shader;		// Name variants are looked up by, like "PixelShader"
+	std::string Source;		// HLSL file
+	std::string Profile;	// Like "ps_5_0"
+	std::vector<ShaderKeyword> Keywords;
+
+	//Reads the //@keyword lines out of a shader's source
+	// - On failure the error names the line
+	static bool Parse(const char* text, size_t length, ShaderPermutationSet& set, std::string& error);
+
+	//Number of variants, and the key of each in turn
+	uint32_t GetVariantCount() const;
+	ShaderPermutationKey GetKey(uint32_t variant) const;
+
+	//Value of one keyword in a key
+	int GetValue(ShaderPermutationKey key, size_t keyword) const;
+
+	//Defines to compile a variant with, as name and value
+	std::vector<std::pair<std::string, std::string>> GetDefines(ShaderPermutationKey key) const;
+
+	//Whether a variant supports everything asked for
+	bool Matches(ShaderPermutationKey key, const ShaderFeatureRequest& request) const;
+
+	//Stable name for a variant's compiled file
+	// - Hashes the defines rather than the key, so changing the
+	//    keywords never reuses a stale file
+	uint64_t Hash(ShaderPermutationKey key) const;
+	std::string GetVariantFile(ShaderPermutationKey key) const;
+};
+
+// --------------------------------------------------------
+// Every variant the offline builder produced
+//
+// - A text file, one record per line:
+//     shader PixelShader PixelShader.hlsl ps_5_0
+//     keyword NORMAL_MAP exact 0 1 binds NormalMap
+//     variant 5 PixelShader_0123456789abcdef.cso 212
+// - Keywords and variants belong to the shader above them
+// - Shaders with no manifest entry just use their one
+//   precompiled .cso
+// --------------------------------------------------------
+class ShaderManifest {
+private:
+	std::vector<ShaderPermutationSet> shaders;
+	std::vector<std::vector<ShaderVariant>> variants; // Parallel to shaders
+
+public:
+	bool Parse(const char* text, size_t length, std::string& error);
+	std::string Write() const;
+
+	void Clear();
+	void AddShader(const ShaderPermutationSet& set);
+
+	//Adds to the last shader added
+	void AddVariant(const ShaderVariant& variant);
+
+	const ShaderPermutationSet* FindShader(const std::string& shader) const;
+	const std::vector<ShaderVariant>* FindVariants(const std::string& shader) const;
+	size_t GetShaderCount() const;
+	size_t GetVariantCount() const;
+
+	//Cheapest variant that supports the request
+	// - Null if the shader isn't in the manifest or nothing
+	//    built supports it, so the caller keeps the default
+	const ShaderVariant* Select(const std::string& shader, const ShaderFeatureRequest& request) const;
+};
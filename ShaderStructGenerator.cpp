@@ -0,0 +1,512 @@
+#include "ShaderStructGenerator.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <unordered_map>
+
+static bool IsIdentifierChar(char c) {
+	return isalnum((unsigned char)c) || c == '_';
+}
+
+static std::string Trim(const std::string& text) {
+	size_t start = 0;
+	size_t end = text.size();
+	while (start < end && isspace((unsigned char)text[start])) start++;
+	while (end > start && isspace((unsigned char)text[end - 1])) end--;
+	return text.substr(start, end - start);
+}
+
+static unsigned int AlignToRegister(unsigned int offset) {
+	return (offset + 15) & ~15u;
+}
+
+typedef std::unordered_map<std::string, std::string> ShaderDefines;
+
+// --------------------------------------------------------
+// Integer expressions in array sizes, like "MAX_RADIUS + 1"
+//  - Numbers, #defines, parentheses and + - * /
+//  - Defines expand as they're reached, up to a depth, so
+//     one defined in terms of itself just fails
+// --------------------------------------------------------
+class SizeExpression {
+private:
+	const std::string& text;
+	const ShaderDefines& defines;
+	size_t position;
+	int depth;
+
+	void SkipSpaces() {
+		while (position < text.size() && isspace((unsigned char)text[position])) position++;
+	}
+
+	bool Term(long& value) {
+		SkipSpaces();
+		if (position >= text.size()) return false;
+
+		if (text[position] == '(') {
+			position++;
+			if (!Sum(value)) return false;
+			SkipSpaces();
+			if (position >= text.size() || text[position] != ')') return false;
+			position++;
+			return true;
+		}
+
+		if (isdigit((unsigned char)text[position])) {
+			char* end = 0;
+			value = strtol(text.c_str() + position, &end, 10);
+			position = end - text.c_str();
+			return true;
+		}
+
+		size_t start = position;
+		while (position < text.size() && IsIdentifierChar(text[position])) position++;
+		auto define = defines.find(text.substr(start, position - start));
+		return position > start && define != defines.end() && Evaluate(define->second, defines, value, depth + 1);
+	}
+
+	bool Product(long& value) {
+		if (!Term(value)) return false;
+
+		for (SkipSpaces(); position < text.size() && (text[position] == '*' || text[position] == '/'); SkipSpaces()) {
+			char op = text[position++];
+			long right = 0;
+			if (!Term(right) || (op == '/' && right == 0)) return false;
+			value = op == '*' ? value * right : value / right;
+		}
+
+		return true;
+	}
+
+	bool Sum(long& value) {
+		if (!Product(value)) return false;
+
+		for (SkipSpaces(); position < text.size() && (text[position] == '+' || text[position] == '-'); SkipSpaces()) {
+			char op = text[position++];
+			long right = 0;
+			if (!Product(right)) return false;
+			value = op == '+' ? value + right : value - right;
+		}
+
+		return true;
+	}
+
+	SizeExpression(const std::string& text, const ShaderDefines& defines, int depth) :
+		text(text), defines(defines), position(0), depth(depth) {
+	}
+
+public:
+	static bool Evaluate(const std::string& text, const ShaderDefines& defines, long& value, int depth = 0) {
+		if (depth > 16) return false;
+
+		SizeExpression expression(text, defines, depth);
+		if (!expression.Sum(value)) return false;
+
+		expression.SkipSpaces();
+		return expression.position == text.size();
+	}
+};
+
+bool ShaderStructGenerator::ParseType(const std::string& name, ShaderField& field) {
+	field.Rows = 1;
+	field.Columns = 1;
+
+	if (name == "matrix") {
+		field.Type = ShaderScalarType::Float;
+		field.Rows = 4;
+		field.Columns = 4;
+		return true;
+	}
+
+	static const struct { const char* Name; ShaderScalarType Type; } scalars[] = {
+		{ "float", ShaderScalarType::Float },
+		{ "int", ShaderScalarType::Int },
+		{ "uint", ShaderScalarType::UInt },
+		{ "dword", ShaderScalarType::UInt },
+		{ "bool", ShaderScalarType::Bool },
+	};
+
+	for (auto& scalar : scalars) {
+		size_t length = strlen(scalar.Name);
+		if (name.compare(0, length, scalar.Name) != 0) continue;
+
+		//"float", "float3" or "float4x4"
+		std::string dimensions = name.substr(length);
+		field.Type = scalar.Type;
+
+		if (dimensions.empty()) return true;
+		if (dimensions.size() == 1 && dimensions[0] >= '1' && dimensions[0] <= '4') {
+			field.Columns = dimensions[0] - '0';
+			return true;
+		}
+		if (dimensions.size() == 3 && dimensions[1] == 'x' &&
+			dimensions[0] >= '1' && dimensions[0] <= '4' && dimensions[2] >= '1' && dimensions[2] <= '4') {
+			field.Rows = dimensions[0] - '0';
+			field.Columns = dimensions[2] - '0';
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// --------------------------------------------------------
+// HLSL packing
+//  - Constant buffers: a field moves to the next 16 byte
+//     register rather than cross into it, while arrays and
+//     matrices always start one and put each element (or
+//     each column, or row if row_major) in its own
+//  - The last element only takes the bytes it needs, so a
+//     following scalar can fill in behind it
+//  - Structured buffers: no gaps at all
+// --------------------------------------------------------
+void ShaderStructGenerator::Pack(ShaderStruct& layout) {
+	unsigned int offset = 0;
+
+	for (ShaderField& field : layout.Fields) {
+		unsigned int count = (std::max)(field.ArrayCount, 1u);
+
+		if (layout.Packing == ShaderPacking::Structured) {
+			field.Stride = 4 * field.Rows * field.Columns;
+			field.Offset = offset;
+			field.Size = field.Stride * count;
+			offset += field.Size;
+			continue;
+		}
+
+		bool matrix = field.Rows > 1;
+		unsigned int registers = matrix ? (field.RowMajor ? field.Rows : field.Columns) : 1;
+		unsigned int registerBytes = 4 * (matrix ? (field.RowMajor ? field.Columns : field.Rows) : field.Columns);
+		unsigned int elementSize = 16 * (registers - 1) + registerBytes;
+
+		if (matrix || field.ArrayCount > 0) {
+			offset = AlignToRegister(offset);
+			field.Stride = 16 * registers;
+			field.Size = field.Stride * (count - 1) + elementSize;
+		}
+		else {
+			if (offset / 16 != (offset + elementSize - 1) / 16) offset = AlignToRegister(offset);
+			field.Stride = elementSize;
+			field.Size = elementSize;
+		}
+
+		field.Offset = offset;
+		offset += field.Size;
+	}
+
+	layout.Size = layout.Packing == ShaderPacking::ConstantBuffer ? AlignToRegister(offset) : offset;
+}
+
+// --------------------------------------------------------
+// One declaration in a block, like "float4 taps[MAX_TAPS]"
+// --------------------------------------------------------
+static bool ParseField(
+	const std::string& declaration,
+	const ShaderDefines& defines,
+	ShaderField& field,
+	std::string& error) {
+	std::string text = declaration;
+
+	//Semantics and registers don't change the layout, but packoffset would
+	size_t colon = text.find(':');
+	if (colon != std::string::npos) {
+		if (text.find("packoffset", colon) != std::string::npos) {
+			error = "packoffset isn't supported: " + Trim(declaration);
+			return false;
+		}
+		text = text.substr(0, colon);
+	}
+
+	if (text.find(',') != std::string::npos) {
+		error = "Declare one field at a time: " + Trim(declaration);
+		return false;
+	}
+
+	//Array size
+	field.ArrayCount = 0;
+	size_t open = text.find('[');
+	if (open != std::string::npos) {
+		size_t close = text.find(']', open);
+		if (close == std::string::npos) {
+			error = "Unclosed array size: " + Trim(declaration);
+			return false;
+		}
+
+		std::string size = Trim(text.substr(open + 1, close - open - 1));
+		long count = 0;
+		if (!SizeExpression::Evaluate(size, defines, count) || count <= 0) {
+			error = "Unknown array size \"" + size + "\": " + Trim(declaration);
+			return false;
+		}
+
+		field.ArrayCount = (unsigned int)count;
+		text = text.substr(0, open);
+	}
+
+	std::istringstream words(text);
+	std::vector<std::string> tokens;
+	std::string token;
+	while (words >> token) tokens.push_back(token);
+
+	if (tokens.size() < 2) {
+		error = "Expected a type and a name: " + Trim(declaration);
+		return false;
+	}
+
+	field.RowMajor = false;
+	for (size_t i = 0; i + 2 < tokens.size(); i++) {
+		if (tokens[i] == "row_major") field.RowMajor = true;
+		else if (tokens[i] != "column_major" && tokens[i] != "precise") {
+			error = "Unsupported modifier \"" + tokens[i] + "\": " + Trim(declaration);
+			return false;
+		}
+	}
+
+	field.Name = tokens.back();
+	if (!ShaderStructGenerator::ParseType(tokens[tokens.size() - 2], field)) {
+		error = "Unsupported type \"" + tokens[tokens.size() - 2] + "\": " + Trim(declaration);
+		return false;
+	}
+
+	return true;
+}
+
+bool ShaderStructGenerator::Parse(const char* text, size_t length, const std::string& block, ShaderPacking packing, ShaderStruct& layout, std::string& error) {
+	//Block comments are blanked out, keeping lines where they were
+	std::string source(text, length);
+	for (size_t start = source.find("/*"); start != std::string::npos; start = source.find("/*", start)) {
+		size_t end = source.find("*/", start + 2);
+		end = end == std::string::npos ? source.size() : end + 2;
+		for (size_t i = start; i < end; i++) {
+			if (source[i] != '\n') source[i] = ' ';
+		}
+	}
+
+	//#defines, for array sizes
+	ShaderDefines defines;
+	std::istringstream lines(source);
+	std::string line;
+	while (std::getline(lines, line)) {
+		std::istringstream words(line);
+		std::string directive, name, value;
+		if (!(words >> directive >> name) || directive != "#define") continue;
+
+		std::getline(words, value);
+		size_t slashes = value.find("//");
+		if (slashes != std::string::npos) value = value.substr(0, slashes);
+		defines[name] = Trim(value);
+	}
+
+	//Finds "cbuffer Name" or "struct Name" as whole words
+	const char* keyword = packing == ShaderPacking::ConstantBuffer ? "cbuffer" : "struct";
+	size_t position = 0;
+	size_t open = std::string::npos;
+	while ((position = source.find(keyword, position)) != std::string::npos) {
+		size_t after = position + strlen(keyword);
+		bool wordStart = position == 0 || !IsIdentifierChar(source[position - 1]);
+		position = after;
+		if (!wordStart || after >= source.size() || IsIdentifierChar(source[after])) continue;
+
+		size_t nameStart = after;
+		while (nameStart < source.size() && isspace((unsigned char)source[nameStart])) nameStart++;
+		size_t nameEnd = nameStart;
+		while (nameEnd < source.size() && IsIdentifierChar(source[nameEnd])) nameEnd++;
+		if (source.substr(nameStart, nameEnd - nameStart) != block) continue;
+
+		open = source.find('{', nameEnd);
+		break;
+	}
+
+	if (open == std::string::npos) {
+		error = std::string("No ") + keyword + " " + block;
+		return false;
+	}
+
+	size_t close = source.find('}', open);
+	if (close == std::string::npos || source.find('{', open + 1) < close) {
+		error = block + " isn't closed, or has a nested block";
+		return false;
+	}
+
+	layout = ShaderStruct();
+	layout.Name = block;
+	layout.Packing = packing;
+
+	//Fields end at semicolons, and take the comment at the end of their line
+	std::istringstream body(source.substr(open + 1, close - open - 1));
+	std::string pending;
+	while (std::getline(body, line)) {
+		std::string comment;
+		size_t slashes = line.find("//");
+		if (slashes != std::string::npos) {
+			comment = Trim(line.substr(slashes + 2));
+			line = line.substr(0, slashes);
+		}
+
+		pending += line + " ";
+		for (size_t semicolon = pending.find(';'); semicolon != std::string::npos; semicolon = pending.find(';')) {
+			std::string declaration = pending.substr(0, semicolon);
+			pending = pending.substr(semicolon + 1);
+
+			ShaderField field = {};
+			if (!ParseField(declaration, defines, field, error)) return false;
+
+			field.Comment = comment;
+			layout.Fields.push_back(field);
+		}
+	}
+
+	if (!Trim(pending).empty()) {
+		error = "Missing ; after " + Trim(pending);
+		return false;
+	}
+
+	Pack(layout);
+	return true;
+}
+
+static std::string GetCppType(const ShaderField& field) {
+	if (field.Rows > 1) return "DirectX::XMFLOAT4X4";
+
+	static const char* floats[] = { "float", "DirectX::XMFLOAT2", "DirectX::XMFLOAT3", "DirectX::XMFLOAT4" };
+	static const char* ints[] = { "int", "DirectX::XMINT2", "DirectX::XMINT3", "DirectX::XMINT4" };
+	static const char* uints[] = { "unsigned int", "DirectX::XMUINT2", "DirectX::XMUINT3", "DirectX::XMUINT4" };
+
+	switch (field.Type) {
+	case ShaderScalarType::Float: return floats[field.Columns - 1];
+	case ShaderScalarType::UInt: return uints[field.Columns - 1];
+	default: return ints[field.Columns - 1]; // HLSL bools are 4 bytes
+	}
+}
+
+static std::string GetPadding(unsigned int bytes, unsigned int& paddingCount) {
+	std::ostringstream padding;
+	padding << "\tfloat padding" << paddingCount++;
+	if (bytes > 4) padding << "[" << bytes / 4 << "]";
+	padding << ";\n";
+	return padding.str();
+}
+
+bool ShaderStructGenerator::GenerateStruct(const ShaderStruct& layout, const ShaderStructSchema& schema, std::string& code, std::string& error) {
+	if (layout.Fields.empty()) {
+		error = schema.Block + " has no fields";
+		return false;
+	}
+
+	std::ostringstream fields;
+	std::ostringstream table;
+	std::ostringstream asserts;
+	unsigned int offset = 0;
+	unsigned int paddingCount = 0;
+
+	std::string mismatch = "\"" + schema.Struct + " doesn't match " + schema.Block + " in " + schema.Source + ", run with -generatestructs\"";
+
+	for (const ShaderField& field : layout.Fields) {
+		//C++ has no way to put a gap between array elements
+		bool matrix = field.Rows > 1;
+		unsigned int cppSize = 4 * (matrix ? 16 : field.Columns);
+		if (matrix && (field.Rows != 4 || field.Columns != 4)) {
+			error = schema.Block + "." + field.Name + ": only 4x4 matrices can be mirrored";
+			return false;
+		}
+		if (field.ArrayCount > 0 && field.Stride != cppSize) {
+			error = schema.Block + "." + field.Name + ": array elements have to be 16 bytes, like float4";
+			return false;
+		}
+
+		if (field.Offset > offset) fields << GetPadding(field.Offset - offset, paddingCount);
+
+		fields << "\t" << GetCppType(field) << " " << field.Name;
+		if (field.ArrayCount > 0) fields << "[" << field.ArrayCount << "]";
+		fields << ";";
+		if (!field.Comment.empty()) fields << "\t// " << field.Comment;
+		fields << "\n";
+
+		table << "\t\t\t{ \"" << field.Name << "\", " << field.Offset << ", " << field.Size << " },\n";
+		asserts << "static_assert(offsetof(" << schema.Struct << ", " << field.Name << ") == " << field.Offset << ", " << mismatch << ");\n";
+
+		offset = field.Offset + (std::max)(field.ArrayCount, 1u) * cppSize;
+	}
+
+	if (layout.Size > offset) fields << GetPadding(layout.Size - offset, paddingCount);
+
+	std::ostringstream output;
+	output << "// --------------------------------------------------------\n";
+	output << "// " << (layout.Packing == ShaderPacking::ConstantBuffer ? "cbuffer " : "struct ") << schema.Block << " in " << schema.Source << "\n";
+	output << "// --------------------------------------------------------\n";
+	output << "struct " << schema.Struct << " {\n";
+	output << fields.str();
+	output << "\n";
+	output << "\tstatic const char* GetBlockName() { return \"" << schema.Block << "\"; }\n";
+	output << "\n";
+	output << "\tstatic const ShaderFieldOffset* GetFields(unsigned int& count) {\n";
+	output << "\t\tstatic const ShaderFieldOffset fields[] = {\n";
+	output << table.str();
+	output << "\t\t};\n";
+	output << "\t\tcount = " << layout.Fields.size() << ";\n";
+	output << "\t\treturn fields;\n";
+	output << "\t}\n";
+	output << "};\n";
+	output << "\n";
+	output << "static_assert(sizeof(" << schema.Struct << ") == " << layout.Size << ", " << mismatch << ");\n";
+	output << asserts.str();
+
+	code = output.str();
+	return true;
+}
+
+std::string ShaderStructGenerator::GenerateHeader(const std::vector<std::string>& structs) {
+	std::string header =
+		"#pragma once\n"
+		"\n"
+		"// Generated from the shader sources by running with -generatestructs\n"
+		"//  - Edit the shaders and generate this again, rather than editing it\n"
+		"\n"
+		"#include <cstddef>\n"
+		"#include <DirectXMath.h>\n"
+		"\n"
+		"#include \"ShaderStructGenerator.h\"\n";
+
+	for (const std::string& code : structs) {
+		header += "\n" + code;
+	}
+
+	return header;
+}
+
+bool ShaderStructGenerator::Validate(
+	const ShaderFieldOffset* expected,
+	unsigned int expectedCount,
+	const std::vector<ShaderFieldOffset>& reflected,
+	std::string& error) {
+	std::ostringstream errors;
+
+	for (unsigned int i = 0; i < expectedCount; i++) {
+		auto match = std::find_if(reflected.begin(), reflected.end(),
+			[&](const ShaderFieldOffset& field) { return strcmp(field.Name, expected[i].Name) == 0; });
+
+		if (match == reflected.end()) {
+			errors << expected[i].Name << " isn't in the shader\n";
+		}
+		else if (match->Offset != expected[i].Offset || match->Size != expected[i].Size) {
+			errors << expected[i].Name << " is " << match->Size << " bytes at " << match->Offset <<
+				" in the shader, but " << expected[i].Size << " bytes at " << expected[i].Offset << " here\n";
+		}
+	}
+
+	for (const ShaderFieldOffset& field : reflected) {
+		bool known = false;
+		for (unsigned int i = 0; i < expectedCount && !known; i++) {
+			known = strcmp(field.Name, expected[i].Name) == 0;
+		}
+
+		if (!known) errors << field.Name << " is in the shader, but not here\n";
+	}
+
+	error = errors.str();
+	if (!error.empty()) error.pop_back();
+	return error.empty();
+}
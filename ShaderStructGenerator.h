@@ -0,0 +1,100 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Where ShaderStructGenerator writes, next to the shader sources
+#define SHADER_STRUCTS_FILE "ShaderStructs.h"
+
+// --------------------------------------------------------
+// One field of a generated struct, as the shader lays it out
+//  - Generated structs list these so the layout can be
+//     checked against reflection once a shader is loaded
+// --------------------------------------------------------
+struct ShaderFieldOffset {
+	const char* Name;
+	unsigned int Offset;
+	unsigned int Size;
+};
+
+enum class ShaderScalarType { Float, Int, UInt, Bool };
+
+// --------------------------------------------------------
+// How a block's fields are laid out
+//  - Constant buffers pack into 16 byte registers, which a
+//     field can't straddle, and start arrays and matrices
+//     on a new register
+//  - Structured buffers pack tightly, like C++
+// --------------------------------------------------------
+enum class ShaderPacking { ConstantBuffer, Structured };
+
+struct ShaderField {
+	std::string Name;
+	std::string Comment;	// Trailing comment in the source, if any
+	ShaderScalarType Type;
+	unsigned int Rows;		// 1 for scalars and vectors
+	unsigned int Columns;	// Components of a vector
+	bool RowMajor;
+	unsigned int ArrayCount; // 0 when it's not an array
+
+	//Filled in by Pack()
+	unsigned int Offset;
+	unsigned int Size;		// Up to the end of the last element
+	unsigned int Stride;	// Between array elements
+};
+
+struct ShaderStruct {
+	std::string Name;	// cbuffer or struct name in the shader
+	ShaderPacking Packing;
+	std::vector<ShaderField> Fields;
+	unsigned int Size;
+};
+
+// --------------------------------------------------------
+// What to generate: one block of one shader as a C++ struct
+// --------------------------------------------------------
+struct ShaderStructSchema {
+	std::string Source;	// HLSL file the block is in
+	std::string Block;	// cbuffer or struct name
+	ShaderPacking Packing;
+	std::string Struct;	// C++ name
+};
+
+// --------------------------------------------------------
+// Mirrors HLSL blocks as C++ structs
+//
+// - Reads a cbuffer or struct out of the shader source, so
+//    the shader stays the one place a layout is written
+// - Packs it with HLSL's rules and writes a struct with
+//    explicit padding, plus static_asserts on every offset,
+//    so a whole block uploads with a single memcpy
+// - Only handles what C++ can mirror directly: scalars,
+//    vectors, 4x4 matrices, and constant buffer arrays of
+//    16 byte elements
+// --------------------------------------------------------
+class ShaderStructGenerator {
+public:
+	//Reads a type name like "float3" or "int" or "matrix"
+	static bool ParseType(const std::string& name, ShaderField& field);
+
+	//Works out every field's offset and the block's size
+	static void Pack(ShaderStruct& layout);
+
+	//Finds and packs a block in a shader's source
+	// - Array sizes can be numbers or #defines from that source
+	static bool Parse(const char* text, size_t length, const std::string& block, ShaderPacking packing, ShaderStruct& layout, std::string& error);
+
+	//C++ for one block, or false if it can't be mirrored
+	static bool GenerateStruct(const ShaderStruct& layout, const ShaderStructSchema& schema, std::string& code, std::string& error);
+
+	//The whole header, around structs from GenerateStruct()
+	static std::string GenerateHeader(const std::vector<std::string>& structs);
+
+	//Compares a generated struct's fields with ones from reflection
+	// - Fields reflection has that the struct doesn't are errors too
+	static bool Validate(
+		const ShaderFieldOffset* expected,
+		unsigned int expectedCount,
+		const std::vector<ShaderFieldOffset>& reflected,
+		std::string& error);
+};
@@ -0,0 +1,264 @@
+#pragma once
+
+// Generated from the shader sources by running with -generatestructs
+//  - Edit the shaders and generate this again, rather than editing it
+
+#include <cstddef>
+#include <DirectXMath.h>
+
+#include "ShaderStructGenerator.h"
+
+// --------------------------------------------------------
+// struct Light in ShaderIncludes.hlsli
+// --------------------------------------------------------
+struct Light {
+	int Type;	// Which kind of light? 0, 1 or 2 (see Lights.h)
+	DirectX::XMFLOAT3 Direction;	// Directional and Spot lights need a direction
+	float Range;	// Point and Spot lights have a max range for attenuation
+	DirectX::XMFLOAT3 Position;	// Point and Spot lights have a position in space
+	float Intensity;	// All lights need an intensity
+	DirectX::XMFLOAT3 Color;	// All lights need a color
+	float SpotFalloff;	// Spot lights need a value to define their "cone" size
+	DirectX::XMFLOAT3 Padding;	// Purposefully padding to hit the 16-byte boundary
+
+	static const char* GetBlockName() { return "Light"; }
+
+	static const ShaderFieldOffset* GetFields(unsigned int& count) {
+		static const ShaderFieldOffset fields[] = {
+			{ "Type", 0, 4 },
+			{ "Direction", 4, 12 },
+			{ "Range", 16, 4 },
+			{ "Position", 20, 12 },
+			{ "Intensity", 32, 4 },
+			{ "Color", 36, 12 },
+			{ "SpotFalloff", 48, 4 },
+			{ "Padding", 52, 12 },
+		};
+		count = 8;
+		return fields;
+	}
+};
+
+static_assert(sizeof(Light) == 64, "Light doesn't match Light in ShaderIncludes.hlsli, run with -generatestructs");
+static_assert(offsetof(Light, Type) == 0, "Light doesn't match Light in ShaderIncludes.hlsli, run with -generatestructs");
+static_assert(offsetof(Light, Direction) == 4, "Light doesn't match Light in ShaderIncludes.hlsli, run with -generatestructs");
+static_assert(offsetof(Light, Range) == 16, "Light doesn't match Light in ShaderIncludes.hlsli, run with -generatestructs");
+static_assert(offsetof(Light, Position) == 20, "Light doesn't match Light in ShaderIncludes.hlsli, run with -generatestructs");
+static_assert(offsetof(Light, Intensity) == 32, "Light doesn't match Light in ShaderIncludes.hlsli, run with -generatestructs");
+static_assert(offsetof(Light, Color) == 36, "Light doesn't match Light in ShaderIncludes.hlsli, run with -generatestructs");
+static_assert(offsetof(Light, SpotFalloff) == 48, "Light doesn't match Light in ShaderIncludes.hlsli, run with -generatestructs");
+static_assert(offsetof(Light, Padding) == 52, "Light doesn't match Light in ShaderIncludes.hlsli, run with -generatestructs");
+
+// --------------------------------------------------------
+// cbuffer ExternalData in VertexShader.hlsl
+// --------------------------------------------------------
+struct VertexShaderConstants {
+	DirectX::XMFLOAT4X4 world;
+	DirectX::XMFLOAT4X4 view;
+	DirectX::XMFLOAT4X4 projection;
+	DirectX::XMFLOAT4X4 worldInvTranspose;
+	DirectX::XMFLOAT4X4 lightView;
+	DirectX::XMFLOAT4X4 lightProjection;
+
+	static const char* GetBlockName() { return "ExternalData"; }
+
+	static const ShaderFieldOffset* GetFields(unsigned int& count) {
+		static const ShaderFieldOffset fields[] = {
+			{ "world", 0, 64 },
+			{ "view", 64, 64 },
+			{ "projection", 128, 64 },
+			{ "worldInvTranspose", 192, 64 },
+			{ "lightView", 256, 64 },
+			{ "lightProjection", 320, 64 },
+		};
+		count = 6;
+		return fields;
+	}
+};
+
+static_assert(sizeof(VertexShaderConstants) == 384, "VertexShaderConstants doesn't match ExternalData in VertexShader.hlsl, run with -generatestructs");
+static_assert(offsetof(VertexShaderConstants, world) == 0, "VertexShaderConstants doesn't match ExternalData in VertexShader.hlsl, run with -generatestructs");
+static_assert(offsetof(VertexShaderConstants, view) == 64, "VertexShaderConstants doesn't match ExternalData in VertexShader.hlsl, run with -generatestructs");
+static_assert(offsetof(VertexShaderConstants, projection) == 128, "VertexShaderConstants doesn't match ExternalData in VertexShader.hlsl, run with -generatestructs");
+static_assert(offsetof(VertexShaderConstants, worldInvTranspose) == 192, "VertexShaderConstants doesn't match ExternalData in VertexShader.hlsl, run with -generatestructs");
+static_assert(offsetof(VertexShaderConstants, lightView) == 256, "VertexShaderConstants doesn't match ExternalData in VertexShader.hlsl, run with -generatestructs");
+static_assert(offsetof(VertexShaderConstants, lightProjection) == 320, "VertexShaderConstants doesn't match ExternalData in VertexShader.hlsl, run with -generatestructs");
+
+// --------------------------------------------------------
+// cbuffer ExternalData in PixelShader.hlsl
+// --------------------------------------------------------
+struct PixelShaderConstants {
+	DirectX::XMFLOAT4 colorTint;
+	float roughness;
+	DirectX::XMFLOAT3 cameraPosition;
+	DirectX::XMFLOAT3 ambient;
+	int directionalLightCount;
+	DirectX::XMFLOAT2 clusterScreenScale;
+	float clusterDepthScale;
+	float clusterDepthBias;
+	int entityLightOffset;
+	int entityLightCount;
+	float padding0[2];
+
+	static const char* GetBlockName() { return "ExternalData"; }
+
+	static const ShaderFieldOffset* GetFields(unsigned int& count) {
+		static const ShaderFieldOffset fields[] = {
+			{ "colorTint", 0, 16 },
+			{ "roughness", 16, 4 },
+			{ "cameraPosition", 20, 12 },
+			{ "ambient", 32, 12 },
+			{ "directionalLightCount", 44, 4 },
+			{ "clusterScreenScale", 48, 8 },
+			{ "clusterDepthScale", 56, 4 },
+			{ "clusterDepthBias", 60, 4 },
+			{ "entityLightOffset", 64, 4 },
+			{ "entityLightCount", 68, 4 },
+		};
+		count = 10;
+		return fields;
+	}
+};
+
+static_assert(sizeof(PixelShaderConstants) == 80, "PixelShaderConstants doesn't match ExternalData in PixelShader.hlsl, run with -generatestructs");
+static_assert(offsetof(PixelShaderConstants, colorTint) == 0, "PixelShaderConstants doesn't match ExternalData in PixelShader.hlsl, run with -generatestructs");
+static_assert(offsetof(PixelShaderConstants, roughness) == 16, "PixelShaderConstants doesn't match ExternalData in PixelShader.hlsl, run with -generatestructs");
+static_assert(offsetof(PixelShaderConstants, cameraPosition) == 20, "PixelShaderConstants doesn't match ExternalData in PixelShader.hlsl, run with -generatestructs");
+static_assert(offsetof(PixelShaderConstants, ambient) == 32, "PixelShaderConstants doesn't match ExternalData in PixelShader.hlsl, run with -generatestructs");
+static_assert(offsetof(PixelShaderConstants, directionalLightCount) == 44, "PixelShaderConstants doesn't match ExternalData in PixelShader.hlsl, run with -generatestructs");
+static_assert(offsetof(PixelShaderConstants, clusterScreenScale) == 48, "PixelShaderConstants doesn't match ExternalData in PixelShader.hlsl, run with -generatestructs");
+static_assert(offsetof(PixelShaderConstants, clusterDepthScale) == 56, "PixelShaderConstants doesn't match ExternalData in PixelShader.hlsl, run with -generatestructs");
+static_assert(offsetof(PixelShaderConstants, clusterDepthBias) == 60, "PixelShaderConstants doesn't match ExternalData in PixelShader.hlsl, run with -generatestructs");
+static_assert(offsetof(PixelShaderConstants, entityLightOffset) == 64, "PixelShaderConstants doesn't match ExternalData in PixelShader.hlsl, run with -generatestructs");
+static_assert(offsetof(PixelShaderConstants, entityLightCount) == 68, "PixelShaderConstants doesn't match ExternalData in PixelShader.hlsl, run with -generatestructs");
+
+// --------------------------------------------------------
+// cbuffer ExternalData in CustomPS.hlsl
+// --------------------------------------------------------
+struct CustomPSConstants {
+	DirectX::XMFLOAT4 colorTint;
+	float time;
+	float padding0[3];
+
+	static const char* GetBlockName() { return "ExternalData"; }
+
+	static const ShaderFieldOffset* GetFields(unsigned int& count) {
+		static const ShaderFieldOffset fields[] = {
+			{ "colorTint", 0, 16 },
+			{ "time", 16, 4 },
+		};
+		count = 2;
+		return fields;
+	}
+};
+
+static_assert(sizeof(CustomPSConstants) == 32, "CustomPSConstants doesn't match ExternalData in CustomPS.hlsl, run with -generatestructs");
+static_assert(offsetof(CustomPSConstants, colorTint) == 0, "CustomPSConstants doesn't match ExternalData in CustomPS.hlsl, run with -generatestructs");
+static_assert(offsetof(CustomPSConstants, time) == 16, "CustomPSConstants doesn't match ExternalData in CustomPS.hlsl, run with -generatestructs");
+
+// --------------------------------------------------------
+// cbuffer ExternalData in SkyVertexShader.hlsl
+// --------------------------------------------------------
+struct SkyVSConstants {
+	DirectX::XMFLOAT4X4 view;
+	DirectX::XMFLOAT4X4 projection;
+
+	static const char* GetBlockName() { return "ExternalData"; }
+
+	static const ShaderFieldOffset* GetFields(unsigned int& count) {
+		static const ShaderFieldOffset fields[] = {
+			{ "view", 0, 64 },
+			{ "projection", 64, 64 },
+		};
+		count = 2;
+		return fields;
+	}
+};
+
+static_assert(sizeof(SkyVSConstants) == 128, "SkyVSConstants doesn't match ExternalData in SkyVertexShader.hlsl, run with -generatestructs");
+static_assert(offsetof(SkyVSConstants, view) == 0, "SkyVSConstants doesn't match ExternalData in SkyVertexShader.hlsl, run with -generatestructs");
+static_assert(offsetof(SkyVSConstants, projection) == 64, "SkyVSConstants doesn't match ExternalData in SkyVertexShader.hlsl, run with -generatestructs");
+
+// --------------------------------------------------------
+// cbuffer externalData in ShadowMapVS.hlsl
+// --------------------------------------------------------
+struct ShadowMapVSConstants {
+	DirectX::XMFLOAT4X4 world;
+	DirectX::XMFLOAT4X4 view;
+	DirectX::XMFLOAT4X4 projection;
+
+	static const char* GetBlockName() { return "externalData"; }
+
+	static const ShaderFieldOffset* GetFields(unsigned int& count) {
+		static const ShaderFieldOffset fields[] = {
+			{ "world", 0, 64 },
+			{ "view", 64, 64 },
+			{ "projection", 128, 64 },
+		};
+		count = 3;
+		return fields;
+	}
+};
+
+static_assert(sizeof(ShadowMapVSConstants) == 192, "ShadowMapVSConstants doesn't match externalData in ShadowMapVS.hlsl, run with -generatestructs");
+static_assert(offsetof(ShadowMapVSConstants, world) == 0, "ShadowMapVSConstants doesn't match externalData in ShadowMapVS.hlsl, run with -generatestructs");
+static_assert(offsetof(ShadowMapVSConstants, view) == 64, "ShadowMapVSConstants doesn't match externalData in ShadowMapVS.hlsl, run with -generatestructs");
+static_assert(offsetof(ShadowMapVSConstants, projection) == 128, "ShadowMapVSConstants doesn't match externalData in ShadowMapVS.hlsl, run with -generatestructs");
+
+// --------------------------------------------------------
+// cbuffer externalData in PostProcessBlurPS.hlsl
+// --------------------------------------------------------
+struct BlurPSConstants {
+	DirectX::XMFLOAT2 pixelStep;	// One pixel in the blur direction, in UV space
+	int tapCount;
+	float centerWeight;
+	DirectX::XMFLOAT4 taps[5];
+
+	static const char* GetBlockName() { return "externalData"; }
+
+	static const ShaderFieldOffset* GetFields(unsigned int& count) {
+		static const ShaderFieldOffset fields[] = {
+			{ "pixelStep", 0, 8 },
+			{ "tapCount", 8, 4 },
+			{ "centerWeight", 12, 4 },
+			{ "taps", 16, 80 },
+		};
+		count = 4;
+		return fields;
+	}
+};
+
+static_assert(sizeof(BlurPSConstants) == 96, "BlurPSConstants doesn't match externalData in PostProcessBlurPS.hlsl, run with -generatestructs");
+static_assert(offsetof(BlurPSConstants, pixelStep) == 0, "BlurPSConstants doesn't match externalData in PostProcessBlurPS.hlsl, run with -generatestructs");
+static_assert(offsetof(BlurPSConstants, tapCount) == 8, "BlurPSConstants doesn't match externalData in PostProcessBlurPS.hlsl, run with -generatestructs");
+static_assert(offsetof(BlurPSConstants, centerWeight) == 12, "BlurPSConstants doesn't match externalData in PostProcessBlurPS.hlsl, run with -generatestructs");
+static_assert(offsetof(BlurPSConstants, taps) == 16, "BlurPSConstants doesn't match externalData in PostProcessBlurPS.hlsl, run with -generatestructs");
+
+// --------------------------------------------------------
+// cbuffer externalData in PostProcessBlurCS.hlsl
+// --------------------------------------------------------
+struct BlurCSConstants {
+	int blurRadius;
+	int horizontal;	// 1 to blur along rows, 0 along columns
+	DirectX::XMINT2 textureSize;
+	DirectX::XMFLOAT4 weights[11];
+
+	static const char* GetBlockName() { return "externalData"; }
+
+	static const ShaderFieldOffset* GetFields(unsigned int& count) {
+		static const ShaderFieldOffset fields[] = {
+			{ "blurRadius", 0, 4 },
+			{ "horizontal", 4, 4 },
+			{ "textureSize", 8, 8 },
+			{ "weights", 16, 176 },
+		};
+		count = 4;
+		return fields;
+	}
+};
+
+static_assert(sizeof(BlurCSConstants) == 192, "BlurCSConstants doesn't match externalData in PostProcessBlurCS.hlsl, run with -generatestructs");
+static_assert(offsetof(BlurCSConstants, blurRadius) == 0, "BlurCSConstants doesn't match externalData in PostProcessBlurCS.hlsl, run with -generatestructs");
+static_assert(offsetof(BlurCSConstants, horizontal) == 4, "BlurCSConstants doesn't match externalData in PostProcessBlurCS.hlsl, run with -generatestructs");
+static_assert(offsetof(BlurCSConstants, textureSize) == 8, "BlurCSConstants doesn't match externalData in PostProcessBlurCS.hlsl, run with -generatestructs");
+static_assert(offsetof(BlurCSConstants, weights) == 16, "BlurCSConstants doesn't match externalData in PostProcessBlurCS.hlsl, run with -generatestructs");
@@ -0,0 +1,119 @@
+#include "ShaderVariantBuilder.h"
+#include "JobSystem.h"
+
+#include <d3d11.h>
+#include <d3d11shader.h>
+#include <d3dcompiler.h>
+#include <wrl/client.h>
+#include <fstream>
+#include <iterator>
+
+#pragma comment(lib, "d3dcompiler.lib")
+
+// One variant's compile, filled in on a worker
+struct ShaderVariantResult {
+	ShaderVariant Variant;
+	std::string Error;
+};
+
+// --------------------------------------------------------
+// Compiles and writes one variant
+// --------------------------------------------------------
+static void CompileVariant(const std::wstring& sourcePath, const std::wstring& outputDirectory, const ShaderPermutationSet& set, ShaderPermutationKey key, ShaderVariantResult& result) {
+	//D3D wants the defines as a null terminated array of C strings
+	std::vector<std::pair<std::string, std::string>> defines = set.GetDefines(key);
+	std::vector<D3D_SHADER_MACRO> macros;
+	for (auto& define : defines) {
+		macros.push_back({ define.first.c_str(), define.second.c_str() });
+	}
+	macros.push_back({ 0, 0 });
+
+	Microsoft::WRL::ComPtr<ID3DBlob> blob;
+	Microsoft::WRL::ComPtr<ID3DBlob> errors;
+	HRESULT hr = D3DCompileFromFile(
+		sourcePath.c_str(),
+		macros.data(),
+		D3D_COMPILE_STANDARD_FILE_INCLUDE,
+		"main",
+		set.Profile.c_str(),
+		D3DCOMPILE_OPTIMIZATION_LEVEL3,
+		0,
+		blob.GetAddressOf(),
+		errors.GetAddressOf());
+
+	if (FAILED(hr)) {
+		result.Error = errors ? std::string((const char*)errors->GetBufferPointer(), errors->GetBufferSize()) : "couldn't compile";
+		return;
+	}
+
+	//Instruction count is what the selection treats as cost
+	Microsoft::WRL::ComPtr<ID3D11ShaderReflection> reflection;
+	D3D11_SHADER_DESC shaderDesc = {};
+	if (SUCCEEDED(D3DReflect(blob->GetBufferPointer(), blob->GetBufferSize(), IID_ID3D11ShaderReflection, (void**)reflection.GetAddressOf()))) {
+		reflection->GetDesc(&shaderDesc);
+	}
+
+	result.Variant.Key = key;
+	result.Variant.File = set.GetVariantFile(key);
+	result.Variant.Cost = shaderDesc.InstructionCount;
+
+	std::wstring outputPath = outputDirectory + std::wstring(result.Variant.File.begin(), result.Variant.File.end());
+	if (FAILED(D3DWriteBlobToFile(blob.Get(), outputPath.c_str(), TRUE))) {
+		result.Error = "couldn't write " + result.Variant.File;
+	}
+}
+
+bool ShaderVariantBuilder::Build(
+	const std::wstring& sourceDirectory,
+	const std::wstring& outputDirectory,
+	const std::vector<ShaderPermutationSet>& shaders,
+	ShaderManifest& manifest,
+	std::string& error) {
+
+	manifest.Clear();
+
+	for (const ShaderPermutationSet& shader : shaders) {
+		std::wstring sourcePath = sourceDirectory + std::wstring(shader.Source.begin(), shader.Source.end());
+
+		std::ifstream file(sourcePath, std::ios::binary);
+		if (!file) {
+			error = "Couldn't open " + shader.Source;
+			return false;
+		}
+
+		std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+		ShaderPermutationSet set = shader;
+		if (!ShaderPermutationSet::Parse(source.data(), source.size(), set, error)) {
+			error = shader.Source + ": " + error;
+			return false;
+		}
+
+		std::vector<ShaderVariantResult> results(set.GetVariantCount());
+		JobSystem::GetInstance().ParallelFor(results.size(), 1, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				CompileVariant(sourcePath, outputDirectory, set, set.GetKey((uint32_t)i), results[i]);
+			}
+		});
+
+		manifest.AddShader(set);
+		for (const ShaderVariantResult& result : results) {
+			if (!result.Error.empty()) {
+				error = shader.Source + ": " + result.Error;
+				return false;
+			}
+
+			manifest.AddVariant(result.Variant);
+		}
+	}
+
+	std::string text = manifest.Write();
+	std::wstring manifestName(SHADER_MANIFEST_FILE, SHADER_MANIFEST_FILE + sizeof(SHADER_MANIFEST_FILE) - 1);
+	std::ofstream output(outputDirectory + manifestName, std::ios::binary);
+	if (!output.write(text.data(), text.size())) {
+		error = "Couldn't write " SHADER_MANIFEST_FILE;
+		return false;
+	}
+
+	return true;
+}
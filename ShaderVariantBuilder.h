@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "ShaderPermutation.h"
+
+// --------------------------------------------------------
+// The offline half of the permutation system
+//
+// - Reads each shader's //@keyword lines, compiles every
+//   combination with those defines, and writes the .cso
+//   files and manifest the game selects from at runtime
+// - Variants compile on the job system, since each one is
+//   independent and there are a lot of them
+// - Run with -buildshaders, from the executable's folder so
+//   the sources are found the same way as the assets
+// --------------------------------------------------------
+class ShaderVariantBuilder {
+public:
+	//Each shader only needs its name, source file and profile set
+	// - Stops at the first variant that fails, with its compiler error
+	static bool Build(
+		const std::wstring& sourceDirectory,
+		const std::wstring& outputDirectory,
+		const std::vector<ShaderPermutationSet>& shaders,
+		ShaderManifest& manifest,
+		std::string& error);
+};
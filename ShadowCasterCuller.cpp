@@ -0,0 +1,123 @@
+#include "ShadowCasterCuller.h"
+
+#include <cmath>
+
+// Keeps the cross product axes from being trusted when two
+// box edges are nearly parallel and their cross is near zero
+static const float PARALLEL_EPSILON = 1e-6f;
+
+ShadowCasterCuller::ShadowCasterCuller() {
+	const float lightView[16] = {
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f,
+	};
+	SetLightVolume(lightView, 1.0f, 0.0f, 1.0f);
+	ClearReceivers();
+}
+
+// --------------------------------------------------------
+// Turns the ortho volume into a world space oriented box
+//  - With row vectors, world = (view - translation) times
+//     the transpose of the rotation, and each light space
+//     axis is a column of the rotation
+// --------------------------------------------------------
+void ShadowCasterCuller::SetLightVolume(const float lightView[16], float size, float nearPlane, float farPlane) {
+	const float viewCenter[3] = { 0.0f, 0.0f, (nearPlane + farPlane) * 0.5f };
+
+	for (int j = 0; j < 3; j++) {
+		volumeCenter[j] = 0.0f;
+		for (int k = 0; k < 3; k++) {
+			volumeCenter[j] += (viewCenter[k] - lightView[12 + k]) * lightView[j * 4 + k];
+			volumeAxes[k][j] = lightView[j * 4 + k];
+		}
+	}
+
+	volumeExtents[0] = size * 0.5f;
+	volumeExtents[1] = size * 0.5f;
+	volumeExtents[2] = (farPlane - nearPlane) * 0.5f;
+}
+
+void ShadowCasterCuller::SetReceivers(const SceneBvhFrustum& frustum, const float lightDirection[3], float distance) {
+	receivers = frustum;
+	for (int i = 0; i < 3; i++) extrusion[i] = lightDirection[i] * distance;
+	hasReceivers = true;
+}
+
+void ShadowCasterCuller::ClearReceivers() {
+	hasReceivers = false;
+}
+
+// --------------------------------------------------------
+// Tests the caster against the light's volume, then its
+// stretched box against the receivers
+//  - The volume test is the box against box separating axis
+//     test: the caster's three axes, the volume's three, and
+//     the nine crosses of one of each
+//  - The receiver test only rejects boxes fully behind one
+//     of the planes, which can keep a few that miss a corner
+// --------------------------------------------------------
+bool ShadowCasterCuller::IsVisible(const float center[3], const float extents[3]) const {
+	//Volume axes in the caster's frame, which is the world's
+	float r[3][3];
+	float absR[3][3];
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			r[i][j] = volumeAxes[j][i];
+			absR[i][j] = std::fabs(r[i][j]) + PARALLEL_EPSILON;
+		}
+	}
+
+	const float* a = extents;
+	const float* b = volumeExtents;
+	float t[3] = { volumeCenter[0] - center[0], volumeCenter[1] - center[1], volumeCenter[2] - center[2] };
+
+	//The caster's axes
+	for (int i = 0; i < 3; i++) {
+		float rb = b[0] * absR[i][0] + b[1] * absR[i][1] + b[2] * absR[i][2];
+		if (std::fabs(t[i]) > a[i] + rb) return false;
+	}
+
+	//The volume's axes
+	for (int j = 0; j < 3; j++) {
+		float ra = a[0] * absR[0][j] + a[1] * absR[1][j] + a[2] * absR[2][j];
+		float distance = t[0] * r[0][j] + t[1] * r[1][j] + t[2] * r[2][j];
+		if (std::fabs(distance) > ra + b[j]) return false;
+	}
+
+	//Caster axis i crossed with volume axis j
+	for (int i = 0; i < 3; i++) {
+		int i1 = (i + 1) % 3;
+		int i2 = (i + 2) % 3;
+		for (int j = 0; j < 3; j++) {
+			int j1 = (j + 1) % 3;
+			int j2 = (j + 2) % 3;
+			float ra = a[i1] * absR[i2][j] + a[i2] * absR[i1][j];
+			float rb = b[j1] * absR[i][j2] + b[j2] * absR[i][j1];
+			float distance = t[i2] * r[i1][j] - t[i1] * r[i2][j];
+			if (std::fabs(distance) > ra + rb) return false;
+		}
+	}
+
+	if (!hasReceivers) return true;
+
+	//The box merged with itself moved along the light
+	float min[3];
+	float max[3];
+	for (int i = 0; i < 3; i++) {
+		min[i] = center[i] - extents[i] + (extrusion[i] < 0.0f ? extrusion[i] : 0.0f);
+		max[i] = center[i] + extents[i] + (extrusion[i] > 0.0f ? extrusion[i] : 0.0f);
+	}
+
+	//Outside if the corner furthest along a plane's normal is still behind it
+	for (int p = 0; p < 6; p++) {
+		const float* plane = receivers.Planes[p];
+		float x = plane[0] >= 0.0f ? max[0] : min[0];
+		float y = plane[1] >= 0.0f ? max[1] : min[1];
+		float z = plane[2] >= 0.0f ? max[2] : min[2];
+		if (plane[0] * x + plane[1] * y + plane[2] * z + plane[3] < 0.0f) return false;
+	}
+
+	return true;
+}
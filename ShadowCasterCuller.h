@@ -0,0 +1,43 @@
+#pragma once
+
+#include "SceneBvh.h"
+
+// --------------------------------------------------------
+// Decides which shadow casters can cast a shadow anyone sees
+//
+// - The light's volume is the box its ortho projection
+//    covers, tested against each caster's box on all fifteen
+//    separating axes, so it's exact
+// - Receivers are the camera's frustum. A caster's box is
+//    stretched along the light direction before it's tested,
+//    so casters outside the view still shadow what's inside
+// - Knows nothing of DirectXMath, so it can be tested anywhere
+// --------------------------------------------------------
+class ShadowCasterCuller {
+private:
+	//The light's volume, as an oriented box in world space
+	float volumeCenter[3];
+	float volumeAxes[3][3];
+	float volumeExtents[3];
+
+	SceneBvhFrustum receivers;
+	float extrusion[3];
+	bool hasReceivers;
+
+public:
+	ShadowCasterCuller();
+
+	//Sets the box an ortho shadow map covers
+	// - lightView is a row major view matrix with no scale
+	// - size is the ortho projection's width and height
+	void SetLightVolume(const float lightView[16], float size, float nearPlane, float farPlane);
+
+	//Only keeps casters whose shadow reaches the frustum
+	// - lightDirection is unit length, and shadows are taken
+	//    to reach distance along it
+	void SetReceivers(const SceneBvhFrustum& frustum, const float lightDirection[3], float distance);
+	void ClearReceivers();
+
+	//Whether a caster with this world space box needs drawing
+	bool IsVisible(const float center[3], const float extents[3]) const;
+};
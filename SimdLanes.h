@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define SIMD_LANES_SSE
+#include <emmintrin.h>
+#endif
+
+// Every x86 build has the AVX2 kernel files, which are the only
+// ones built with AVX2 on, and runs them if the CPU has it
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SIMD_LANES_X86
+#endif
+
+// AVX2 lanes, in the files built with it
+#if defined(__AVX2__)
+#define SIMD_LANES_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(_M_ARM64) || defined(__aarch64__)
+#define SIMD_LANES_NEON
+#include <arm_neon.h>
+#endif
+
+// --------------------------------------------------------
+// Lanes for each instruction set
+//  - Kernels are written once against these, and each path
+//     is the same kernel with a different width
+//  - StoreRows() writes lane k of a, b, c and d as the four
+//     floats at out + k * stride, for turning lanes back
+//     into one matrix row per object
+//  - Comparisons give a Mask, which is false for NaNs like
+//     the scalar compare, and MaskBits() packs it into an
+//     int with lane k as bit k
+//  - They're in an unnamed namespace, so each file has its
+//     own copies, and the linker can't swap in ones built
+//     with AVX2 where the CPU might not have it
+// --------------------------------------------------------
+namespace {
+
+struct ScalarLanes {
+	typedef float Type;
+	static const size_t Width = 1;
+
+	static Type Load(const float* p) { return *p; }
+	static void Store(float* p, Type v) { *p = v; }
+	static Type Set(float f) { return f; }
+	static Type Add(Type a, Type b) { return a + b; }
+	static Type Sub(Type a, Type b) { return a - b; }
+	static Type Mul(Type a, Type b) { return a * b; }
+	static Type Div(Type a, Type b) { return a / b; }
+	static Type Sqrt(Type a) { return sqrtf(a); }
+	static Type Abs(Type a) { return fabsf(a); }
+	static Type SignOf(Type a) { return std::signbit(a) ? -1.0f : 1.0f; }
+	static Type Min(Type a, Type b) { return a < b ? a : b; }
+	static Type Max(Type a, Type b) { return a > b ? a : b; }
+
+	typedef bool Mask;
+	static Mask Less(Type a, Type b) { return a < b; }
+	static Mask LessEqual(Type a, Type b) { return a <= b; }
+	static Mask Greater(Type a, Type b) { return a > b; }
+	static Mask GreaterEqual(Type a, Type b) { return a >= b; }
+	static Mask And(Mask a, Mask b) { return a && b; }
+	static int MaskBits(Mask m) { return m ? 1 : 0; }
+
+	static void StoreRows(float* out, size_t, Type a, Type b, Type c, Type d) {
+		out[0] = a;
+		out[1] = b;
+		out[2] = c;
+		out[3] = d;
+	}
+};
+
+#ifdef SIMD_LANES_SSE
+struct SSELanes {
+	typedef __m128 Type;
+	static const size_t Width = 4;
+
+	static Type Load(const float* p) { return _mm_loadu_ps(p); }
+	static void Store(float* p, Type v) { _mm_storeu_ps(p, v); }
+	static Type Set(float f) { return _mm_set1_ps(f); }
+	static Type Add(Type a, Type b) { return _mm_add_ps(a, b); }
+	static Type Sub(Type a, Type b) { return _mm_sub_ps(a, b); }
+	static Type Mul(Type a, Type b) { return _mm_mul_ps(a, b); }
+	static Type Div(Type a, Type b) { return _mm_div_ps(a, b); }
+	static Type Sqrt(Type a) { return _mm_sqrt_ps(a); }
+	static Type Abs(Type a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+	static Type SignOf(Type a) { return _mm_or_ps(_mm_and_ps(a, _mm_set1_ps(-0.0f)), _mm_set1_ps(1.0f)); }
+	static Type Min(Type a, Type b) { return _mm_min_ps(a, b); }
+	static Type Max(Type a, Type b) { return _mm_max_ps(a, b); }
+
+	typedef __m128 Mask;
+	static Mask Less(Type a, Type b) { return _mm_cmplt_ps(a, b); }
+	static Mask LessEqual(Type a, Type b) { return _mm_cmple_ps(a, b); }
+	static Mask Greater(Type a, Type b) { return _mm_cmpgt_ps(a, b); }
+	static Mask GreaterEqual(Type a, Type b) { return _mm_cmpge_ps(a, b); }
+	static Mask And(Mask a, Mask b) { return _mm_and_ps(a, b); }
+	static int MaskBits(Mask m) { return _mm_movemask_ps(m); }
+
+	static void StoreRows(float* out, size_t stride, Type a, Type b, Type c, Type d) {
+		_MM_TRANSPOSE4_PS(a, b, c, d);
+		_mm_storeu_ps(out, a);
+		_mm_storeu_ps(out + stride, b);
+		_mm_storeu_ps(out + stride * 2, c);
+		_mm_storeu_ps(out + stride * 3, d);
+	}
+};
+#endif
+
+#ifdef SIMD_LANES_AVX2
+struct AVX2Lanes {
+	typedef __m256 Type;
+	static const size_t Width = 8;
+
+	static Type Load(const float* p) { return _mm256_loadu_ps(p); }
+	static void Store(float* p, Type v) { _mm256_storeu_ps(p, v); }
+	static Type Set(float f) { return _mm256_set1_ps(f); }
+	static Type Add(Type a, Type b) { return _mm256_add_ps(a, b); }
+	static Type Sub(Type a, Type b) { return _mm256_sub_ps(a, b); }
+	static Type Mul(Type a, Type b) { return _mm256_mul_ps(a, b); }
+	static Type Div(Type a, Type b) { return _mm256_div_ps(a, b); }
+	static Type Sqrt(Type a) { return _mm256_sqrt_ps(a); }
+	static Type Abs(Type a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+	static Type SignOf(Type a) { return _mm256_or_ps(_mm256_and_ps(a, _mm256_set1_ps(-0.0f)), _mm256_set1_ps(1.0f)); }
+	static Type Min(Type a, Type b) { return _mm256_min_ps(a, b); }
+	static Type Max(Type a, Type b) { return _mm256_max_ps(a, b); }
+
+	typedef __m256 Mask;
+	static Mask Less(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	static Mask LessEqual(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+	static Mask Greater(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+	static Mask GreaterEqual(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+	static Mask And(Mask a, Mask b) { return _mm256_and_ps(a, b); }
+	static int MaskBits(Mask m) { return _mm256_movemask_ps(m); }
+
+	//Each half is an SSE transpose
+	static void StoreRows(float* out, size_t stride, Type a, Type b, Type c, Type d) {
+		SSELanes::StoreRows(out, stride, _mm256_castps256_ps128(a), _mm256_castps256_ps128(b), _mm256_castps256_ps128(c), _mm256_castps256_ps128(d));
+		SSELanes::StoreRows(out + stride * 4, stride, _mm256_extractf128_ps(a, 1), _mm256_extractf128_ps(b, 1), _mm256_extractf128_ps(c, 1), _mm256_extractf128_ps(d, 1));
+	}
+};
+#endif
+
+#ifdef SIMD_LANES_NEON
+struct NEONLanes {
+	typedef float32x4_t Type;
+	static const size_t Width = 4;
+
+	static Type Load(const float* p) { return vld1q_f32(p); }
+	static void Store(float* p, Type v) { vst1q_f32(p, v); }
+	static Type Set(float f) { return vdupq_n_f32(f); }
+	static Type Add(Type a, Type b) { return vaddq_f32(a, b); }
+	static Type Sub(Type a, Type b) { return vsubq_f32(a, b); }
+	static Type Mul(Type a, Type b) { return vmulq_f32(a, b); }
+	static Type Div(Type a, Type b) { return vdivq_f32(a, b); }
+	static Type Sqrt(Type a) { return vsqrtq_f32(a); }
+	static Type Abs(Type a) { return vabsq_f32(a); }
+	static Type SignOf(Type a) {
+		uint32x4_t sign = vandq_u32(vreinterpretq_u32_f32(a), vdupq_n_u32(0x80000000u));
+		return vreinterpretq_f32_u32(vorrq_u32(sign, vreinterpretq_u32_f32(vdupq_n_f32(1.0f))));
+	}
+	static Type Min(Type a, Type b) { return vminq_f32(a, b); }
+	static Type Max(Type a, Type b) { return vmaxq_f32(a, b); }
+
+	typedef uint32x4_t Mask;
+	static Mask Less(Type a, Type b) { return vcltq_f32(a, b); }
+	static Mask LessEqual(Type a, Type b) { return vcleq_f32(a, b); }
+	static Mask Greater(Type a, Type b) { return vcgtq_f32(a, b); }
+	static Mask GreaterEqual(Type a, Type b) { return vcgeq_f32(a, b); }
+	static Mask And(Mask a, Mask b) { return vandq_u32(a, b); }
+	static int MaskBits(Mask m) {
+		const uint32_t laneBits[4] = { 1, 2, 4, 8 };
+		return (int)vaddvq_u32(vandq_u32(m, vld1q_u32(laneBits)));
+	}
+
+	static void StoreRows(float* out, size_t stride, Type a, Type b, Type c, Type d) {
+		float32x4x2_t ab = vtrnq_f32(a, b);
+		float32x4x2_t cd = vtrnq_f32(c, d);
+		vst1q_f32(out, vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0])));
+		vst1q_f32(out + stride, vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1])));
+		vst1q_f32(out + stride * 2, vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0])));
+		vst1q_f32(out + stride * 3, vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1])));
+	}
+};
+#endif
+
+}
@@ -3,6 +3,20 @@
 // Default error reporting state
 bool ISimpleShader::ReportErrors = false;
 bool ISimpleShader::ReportWarnings = false;
+ISimpleShaderObserver* ISimpleShader::Observer = 0;
+
+// --------------------------------------------------------
+// Helper for looking names up in the std::string keyed tables
+//  - Copies the name into a per-thread string that keeps its
+//    capacity, so setting a long-named variable every frame
+//    doesn't allocate a temporary string every time
+// --------------------------------------------------------
+static const std::string& LookupName(const char* name)
+{
+	static thread_local std::string lookupName;
+	lookupName.assign(name);
+	return lookupName;
+}
 
 // To enable error reporting, use either or both 
 // of the following lines somewhere in your program, 
@@ -54,6 +68,7 @@ void ISimpleShader::CleanUp()
 	if (constantBuffers)
 	{
 		delete[] constantBuffers;
+		constantBuffers = 0;
 		constantBufferCount = 0;
 	}
 
@@ -63,6 +78,10 @@ void ISimpleShader::CleanUp()
 	for (unsigned int i = 0; i < samplerStates.size(); i++)
 		delete samplerStates[i];
 
+	// Reloading cleans up more than once
+	shaderResourceViews.clear();
+	samplerStates.clear();
+
 	// Clean up tables
 	varTable.clear();
 	cbTable.clear();
@@ -94,10 +113,7 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 		return false;
 	}
 
-	// Create the shader - Calls an overloaded version of this abstract
-	// method in the appropriate child class
-	shaderValid = CreateShader(shaderBlob);
-	if (!shaderValid)
+	if (!LoadShaderBlob(shaderBlob))
 	{
 		if (ReportErrors)
 		{
@@ -109,6 +125,27 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 		return false;
 	}
 
+	return true;
+}
+
+// --------------------------------------------------------
+// Creates the shader from compiled code and builds the
+// variable table using shader reflection.
+//
+// blob - The compiled shader
+// 
+// Returns true if shader is created properly, false otherwise
+// --------------------------------------------------------
+bool ISimpleShader::LoadShaderBlob(Microsoft::WRL::ComPtr<ID3DBlob> blob)
+{
+	shaderBlob = blob;
+
+	// Create the shader - Calls an overloaded version of this abstract
+	// method in the appropriate child class
+	shaderValid = CreateShader(shaderBlob);
+	if (!shaderValid)
+		return false;
+
 	// Set up shader reflection to get information about
 	// this shader and its variables,  buffers, etc.
 	Microsoft::WRL::ComPtr<ID3D11ShaderReflection> refl;
@@ -233,6 +270,42 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 	return true;
 }
 
+// --------------------------------------------------------
+// Replaces the shader with newly compiled code, in place,
+// so everything holding this object picks it up
+//
+// blob - The new compiled shader, of the same type
+//
+// - Variables with the same name and size keep their values
+// - If the new code can't be used, the old shader is put
+//    back and false is returned
+// --------------------------------------------------------
+bool ISimpleShader::Reload(Microsoft::WRL::ComPtr<ID3DBlob> blob)
+{
+	// Save every variable's current value, by name
+	std::unordered_map<std::string, std::vector<unsigned char>> values;
+	for (auto& var : varTable)
+	{
+		unsigned char* data = constantBuffers[var.second.ConstantBufferIndex].LocalDataBuffer + var.second.ByteOffset;
+		values[var.first].assign(data, data + var.second.Size);
+	}
+
+	Microsoft::WRL::ComPtr<ID3DBlob> previousBlob = shaderBlob;
+	bool reloaded = LoadShaderBlob(blob);
+	if (!reloaded && previousBlob)
+		LoadShaderBlob(previousBlob);
+
+	// Put the values back wherever they still fit
+	for (auto& value : values)
+	{
+		SimpleShaderVariable* var = FindVariable(value.first.c_str(), (int)value.second.size());
+		if (var)
+			memcpy(constantBuffers[var->ConstantBufferIndex].LocalDataBuffer + var->ByteOffset, value.second.data(), value.second.size());
+	}
+
+	return reloaded;
+}
+
 // --------------------------------------------------------
 // Helper for looking up a variable by name and also
 // verifying that it is the requested size
@@ -240,11 +313,11 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 // name - the name of the variable to look for
 // size - the size of the variable (for verification), or -1 to bypass
 // --------------------------------------------------------
-SimpleShaderVariable* ISimpleShader::FindVariable(std::string name, int size)
+SimpleShaderVariable* ISimpleShader::FindVariable(const char* name, int size)
 {
 	// Look for the key
 	std::unordered_map<std::string, SimpleShaderVariable>::iterator result =
-		varTable.find(name);
+		varTable.find(LookupName(name));
 
 	// Did we find the key?
 	if (result == varTable.end())
@@ -264,11 +337,11 @@ SimpleShaderVariable* ISimpleShader::FindVariable(std::string name, int size)
 // --------------------------------------------------------
 // Helper for looking up a constant buffer by name
 // --------------------------------------------------------
-SimpleConstantBuffer* ISimpleShader::FindConstantBuffer(std::string name)
+SimpleConstantBuffer* ISimpleShader::FindConstantBuffer(const char* name)
 {
 	// Look for the key
 	std::unordered_map<std::string, SimpleConstantBuffer*>::iterator result =
-		cbTable.find(name);
+		cbTable.find(LookupName(name));
 
 	// Did we find the key?
 	if (result == cbTable.end())
@@ -333,6 +406,8 @@ void ISimpleShader::SetShader()
 	// Set the shader and any relevant constant buffers, which
 	// is an overloaded method in a subclass
 	SetShaderAndCBs();
+
+	if (Observer) Observer->OnShaderSet(this);
 }
 
 // --------------------------------------------------------
@@ -352,6 +427,8 @@ void ISimpleShader::CopyAllBufferData()
 		deviceContext->UpdateSubresource(
 			constantBuffers[i].ConstantBuffer.Get(), 0, 0,
 			constantBuffers[i].LocalDataBuffer, 0, 0);
+
+		if (Observer) Observer->OnBufferCopied(this, i);
 	}
 }
 
@@ -383,6 +460,8 @@ void ISimpleShader::CopyBufferData(unsigned int index)
 	deviceContext->UpdateSubresource(
 		cb->ConstantBuffer.Get(), 0, 0, 
 		cb->LocalDataBuffer, 0, 0);
+
+	if (Observer) Observer->OnBufferCopied(this, index);
 }
 
 // --------------------------------------------------------
@@ -392,7 +471,7 @@ void ISimpleShader::CopyBufferData(unsigned int index)
 //              Useful for updating more frequently-changing
 //              variables without having to re-copy all buffers.
 // --------------------------------------------------------
-void ISimpleShader::CopyBufferData(std::string bufferName)
+void ISimpleShader::CopyBufferData(const char* bufferName)
 {
 	// Ensure the shader is valid
 	if (!shaderValid) return;
@@ -405,6 +484,8 @@ void ISimpleShader::CopyBufferData(std::string bufferName)
 	deviceContext->UpdateSubresource(
 		cb->ConstantBuffer.Get(), 0, 0, 
 		cb->LocalDataBuffer, 0, 0);
+
+	if (Observer) Observer->OnBufferCopied(this, (unsigned int)(cb - this->constantBuffers));
 }
 
 
@@ -417,7 +498,7 @@ void ISimpleShader::CopyBufferData(std::string bufferName)
 //
 // Returns true if data is copied, false if variable doesn't exist
 // --------------------------------------------------------
-bool ISimpleShader::SetData(std::string name, const void* data, unsigned int size)
+bool ISimpleShader::SetData(const char* name, const void* data, unsigned int size)
 {
 	// Look for the variable and verify
 	SimpleShaderVariable* var = FindVariable(name, -1);
@@ -455,10 +536,37 @@ bool ISimpleShader::SetData(std::string name, const void* data, unsigned int siz
 	return true;
 }
 
+// --------------------------------------------------------
+// Sets a whole constant buffer at once
+//
+// bufferName - The name of the constant buffer
+// data - The data to set, laid out as the buffer is
+// size - The size of the data (this must be less than or equal to the buffer's size)
+//
+// Returns true if data is copied, false if the buffer doesn't exist
+// --------------------------------------------------------
+bool ISimpleShader::SetBufferData(const char* bufferName, const void* data, unsigned int size)
+{
+	SimpleConstantBuffer* cb = this->FindConstantBuffer(bufferName);
+	if (cb == 0 || size > cb->Size)
+	{
+		if (ReportWarnings)
+		{
+			LogWarning("SimpleShader::SetBufferData() - Constant buffer '");
+			Log(bufferName);
+			LogWarning("' not found, or smaller than the data being set.\n");
+		}
+		return false;
+	}
+
+	memcpy(cb->LocalDataBuffer, data, size);
+	return true;
+}
+
 // --------------------------------------------------------
 // Sets INTEGER data
 // --------------------------------------------------------
-bool ISimpleShader::SetInt(std::string name, int data)
+bool ISimpleShader::SetInt(const char* name, int data)
 {
 	return this->SetData(name, (void*)(&data), sizeof(int));
 }
@@ -466,7 +574,7 @@ bool ISimpleShader::SetInt(std::string name, int data)
 // --------------------------------------------------------
 // Sets a FLOAT variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat(std::string name, float data)
+bool ISimpleShader::SetFloat(const char* name, float data)
 {
 	return this->SetData(name, (void*)(&data), sizeof(float));
 }
@@ -474,7 +582,7 @@ bool ISimpleShader::SetFloat(std::string name, float data)
 // --------------------------------------------------------
 // Sets a FLOAT2 variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat2(std::string name, const float data[2])
+bool ISimpleShader::SetFloat2(const char* name, const float data[2])
 {
 	return this->SetData(name, (void*)data, sizeof(float) * 2);
 }
@@ -482,7 +590,7 @@ bool ISimpleShader::SetFloat2(std::string name, const float data[2])
 // --------------------------------------------------------
 // Sets a FLOAT2 variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat2(std::string name, const DirectX::XMFLOAT2 data)
+bool ISimpleShader::SetFloat2(const char* name, const DirectX::XMFLOAT2 data)
 {
 	return this->SetData(name, &data, sizeof(float) * 2);
 }
@@ -490,7 +598,7 @@ bool ISimpleShader::SetFloat2(std::string name, const DirectX::XMFLOAT2 data)
 // --------------------------------------------------------
 // Sets a FLOAT3 variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat3(std::string name, const float data[3])
+bool ISimpleShader::SetFloat3(const char* name, const float data[3])
 {
 	return this->SetData(name, (void*)data, sizeof(float) * 3);
 }
@@ -498,7 +606,7 @@ bool ISimpleShader::SetFloat3(std::string name, const float data[3])
 // --------------------------------------------------------
 // Sets a FLOAT3 variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat3(std::string name, const DirectX::XMFLOAT3 data)
+bool ISimpleShader::SetFloat3(const char* name, const DirectX::XMFLOAT3 data)
 {
 	return this->SetData(name, &data, sizeof(float) * 3);
 }
@@ -506,7 +614,7 @@ bool ISimpleShader::SetFloat3(std::string name, const DirectX::XMFLOAT3 data)
 // --------------------------------------------------------
 // Sets a FLOAT4 variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat4(std::string name, const float data[4])
+bool ISimpleShader::SetFloat4(const char* name, const float data[4])
 {
 	return this->SetData(name, (void*)data, sizeof(float) * 4);
 }
@@ -514,7 +622,7 @@ bool ISimpleShader::SetFloat4(std::string name, const float data[4])
 // --------------------------------------------------------
 // Sets a FLOAT4 variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat4(std::string name, const DirectX::XMFLOAT4 data)
+bool ISimpleShader::SetFloat4(const char* name, const DirectX::XMFLOAT4 data)
 {
 	return this->SetData(name, &data, sizeof(float) * 4);
 }
@@ -522,7 +630,7 @@ bool ISimpleShader::SetFloat4(std::string name, const DirectX::XMFLOAT4 data)
 // --------------------------------------------------------
 // Sets a MATRIX (4x4) variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetMatrix4x4(std::string name, const float data[16])
+bool ISimpleShader::SetMatrix4x4(const char* name, const float data[16])
 {
 	return this->SetData(name, (void*)data, sizeof(float) * 16);
 }
@@ -530,7 +638,7 @@ bool ISimpleShader::SetMatrix4x4(std::string name, const float data[16])
 // --------------------------------------------------------
 // Sets a MATRIX (4x4) variable by name in the local data buffer
 // --------------------------------------------------------
-bool ISimpleShader::SetMatrix4x4(std::string name, const DirectX::XMFLOAT4X4 data)
+bool ISimpleShader::SetMatrix4x4(const char* name, const DirectX::XMFLOAT4X4 data)
 {
 	return this->SetData(name, &data, sizeof(float) * 16);
 }
@@ -539,7 +647,7 @@ bool ISimpleShader::SetMatrix4x4(std::string name, const DirectX::XMFLOAT4X4 dat
 // Determines if the shader contains the specified
 // variable within one of its constant buffers
 // --------------------------------------------------------
-bool ISimpleShader::HasVariable(std::string name)
+bool ISimpleShader::HasVariable(const char* name)
 {
 	return FindVariable(name, -1) != 0;
 }
@@ -547,7 +655,7 @@ bool ISimpleShader::HasVariable(std::string name)
 // --------------------------------------------------------
 // Determines if the shader contains the specified SRV
 // --------------------------------------------------------
-bool ISimpleShader::HasShaderResourceView(std::string name)
+bool ISimpleShader::HasShaderResourceView(const char* name)
 {
 	return GetShaderResourceViewInfo(name) != 0;
 }
@@ -555,7 +663,7 @@ bool ISimpleShader::HasShaderResourceView(std::string name)
 // --------------------------------------------------------
 // Determines if the shader contains the specified sampler
 // --------------------------------------------------------
-bool ISimpleShader::HasSamplerState(std::string name)
+bool ISimpleShader::HasSamplerState(const char* name)
 {
 	return GetSamplerInfo(name) != 0;
 }
@@ -563,7 +671,7 @@ bool ISimpleShader::HasSamplerState(std::string name)
 // --------------------------------------------------------
 // Gets info about a shader variable, if it exists
 // --------------------------------------------------------
-const SimpleShaderVariable* ISimpleShader::GetVariableInfo(std::string name)
+const SimpleShaderVariable* ISimpleShader::GetVariableInfo(const char* name)
 {
 	return FindVariable(name, -1);
 }
@@ -573,11 +681,11 @@ const SimpleShaderVariable* ISimpleShader::GetVariableInfo(std::string name)
 //
 // name - the name of the SRV
 // --------------------------------------------------------
-const SimpleSRV* ISimpleShader::GetShaderResourceViewInfo(std::string name)
+const SimpleSRV* ISimpleShader::GetShaderResourceViewInfo(const char* name)
 {
 	// Look for the key
 	std::unordered_map<std::string, SimpleSRV*>::iterator result =
-		textureTable.find(name);
+		textureTable.find(LookupName(name));
 
 	// Did we find the key?
 	if (result == textureTable.end())
@@ -608,11 +716,11 @@ const SimpleSRV* ISimpleShader::GetShaderResourceViewInfo(unsigned int index)
 // 
 // name - the name of the sampler
 // --------------------------------------------------------
-const SimpleSampler* ISimpleShader::GetSamplerInfo(std::string name)
+const SimpleSampler* ISimpleShader::GetSamplerInfo(const char* name)
 {
 	// Look for the key
 	std::unordered_map<std::string, SimpleSampler*>::iterator result =
-		samplerTable.find(name);
+		samplerTable.find(LookupName(name));
 
 	// Did we find the key?
 	if (result == samplerTable.end())
@@ -661,7 +769,7 @@ unsigned int ISimpleShader::GetBufferSize(unsigned int index)
 // Gets info about a particular constant buffer 
 // by name, if it exists
 // --------------------------------------------------------
-const SimpleConstantBuffer * ISimpleShader::GetBufferInfo(std::string name)
+const SimpleConstantBuffer * ISimpleShader::GetBufferInfo(const char* name)
 {
 	return FindConstantBuffer(name);
 }
@@ -784,19 +892,22 @@ bool SimpleVertexShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlo
 	refl->GetDesc(&shaderDesc);
 
 	// Read input layout description from shader info
-	std::vector<D3D11_INPUT_ELEMENT_DESC> inputLayoutDesc;
-	for (unsigned int i = 0; i< shaderDesc.InputParameters; i++)
+	// (A vertex shader can't have more inputs than the input
+	// assembler has elements, so this never needs the heap)
+	D3D11_INPUT_ELEMENT_DESC inputLayoutDesc[D3D11_IA_VERTEX_INPUT_STRUCTURE_ELEMENT_COUNT];
+	unsigned int inputElementCount = 0;
+	for (unsigned int i = 0; i < shaderDesc.InputParameters && i < D3D11_IA_VERTEX_INPUT_STRUCTURE_ELEMENT_COUNT; i++)
 	{
 		D3D11_SIGNATURE_PARAMETER_DESC paramDesc;
 		refl->GetInputParameterDesc(i, &paramDesc);
 
 		// Check the semantic name for "_PER_INSTANCE"
-		std::string perInstanceStr = "_PER_INSTANCE";
-		std::string sem = paramDesc.SemanticName;
-		int lenDiff = (int)sem.size() - (int)perInstanceStr.size();
+		const char* perInstanceStr = "_PER_INSTANCE";
+		size_t perInstanceLen = strlen(perInstanceStr);
+		size_t semLen = strlen(paramDesc.SemanticName);
 		bool isPerInstance = 
-			lenDiff >= 0 &&
-			sem.compare(lenDiff, perInstanceStr.size(), perInstanceStr) == 0;
+			semLen >= perInstanceLen &&
+			strcmp(paramDesc.SemanticName + semLen - perInstanceLen, perInstanceStr) == 0;
 
 		// Fill out input element desc
 		D3D11_INPUT_ELEMENT_DESC elementDesc = {};
@@ -844,13 +955,13 @@ bool SimpleVertexShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlo
 		}
 
 		// Save element desc
-		inputLayoutDesc.push_back(elementDesc);
+		inputLayoutDesc[inputElementCount++] = elementDesc;
 	}
 
 	// Try to create Input Layout
 	HRESULT hr = device->CreateInputLayout(
-		&inputLayoutDesc[0], 
-		(unsigned int)inputLayoutDesc.size(), 
+		inputLayoutDesc, 
+		inputElementCount, 
 		shaderBlob->GetBufferPointer(), 
 		shaderBlob->GetBufferSize(),
 		inputLayout.GetAddressOf());
@@ -895,7 +1006,7 @@ void SimpleVertexShader::SetShaderAndCBs()
 //
 // Returns true if a texture of the given name was found, false otherwise
 // --------------------------------------------------------
-bool SimpleVertexShader::SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
+bool SimpleVertexShader::SetShaderResourceView(const char* name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
 {
 	// Look for the variable and verify
 	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
@@ -925,7 +1036,7 @@ bool SimpleVertexShader::SetShaderResourceView(std::string name, Microsoft::WRL:
 //
 // Returns true if a sampler of the given name was found, false otherwise
 // --------------------------------------------------------
-bool SimpleVertexShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState)
+bool SimpleVertexShader::SetSamplerState(const char* name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState)
 {
 	// Look for the variable and verify
 	const SimpleSampler* sampInfo = GetSamplerInfo(name);
@@ -1037,7 +1148,7 @@ void SimplePixelShader::SetShaderAndCBs()
 //
 // Returns true if a texture of the given name was found, false otherwise
 // --------------------------------------------------------
-bool SimplePixelShader::SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
+bool SimplePixelShader::SetShaderResourceView(const char* name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
 {
 	// Look for the variable and verify
 	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
@@ -1067,7 +1178,7 @@ bool SimplePixelShader::SetShaderResourceView(std::string name, Microsoft::WRL::
 //
 // Returns true if a sampler of the given name was found, false otherwise
 // --------------------------------------------------------
-bool SimplePixelShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState)
+bool SimplePixelShader::SetSamplerState(const char* name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState)
 {
 	// Look for the variable and verify
 	const SimpleSampler* sampInfo = GetSamplerInfo(name);
@@ -1181,7 +1292,7 @@ void SimpleDomainShader::SetShaderAndCBs()
 //
 // Returns true if a texture of the given name was found, false otherwise
 // --------------------------------------------------------
-bool SimpleDomainShader::SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
+bool SimpleDomainShader::SetShaderResourceView(const char* name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
 {
 	// Look for the variable and verify
 	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
@@ -1211,7 +1322,7 @@ bool SimpleDomainShader::SetShaderResourceView(std::string name, Microsoft::WRL:
 //
 // Returns true if a sampler of the given name was found, false otherwise
 // --------------------------------------------------------
-bool SimpleDomainShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState)
+bool SimpleDomainShader::SetSamplerState(const char* name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState)
 {
 	// Look for the variable and verify
 	const SimpleSampler* sampInfo = GetSamplerInfo(name);
@@ -1324,7 +1435,7 @@ void SimpleHullShader::SetShaderAndCBs()
 //
 // Returns true if a texture of the given name was found, false otherwise
 // --------------------------------------------------------
-bool SimpleHullShader::SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
+bool SimpleHullShader::SetShaderResourceView(const char* name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
 {
 	// Look for the variable and verify
 	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
@@ -1354,7 +1465,7 @@ bool SimpleHullShader::SetShaderResourceView(std::string name, Microsoft::WRL::C
 //
 // Returns true if a sampler of the given name was found, false otherwise
 // --------------------------------------------------------
-bool SimpleHullShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState)
+bool SimpleHullShader::SetSamplerState(const char* name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState)
 {
 	// Look for the variable and verify
 	const SimpleSampler* sampInfo = GetSamplerInfo(name);
@@ -1598,7 +1709,7 @@ void SimpleGeometryShader::SetShaderAndCBs()
 //
 // Returns true if a texture of the given name was found, false otherwise
 // --------------------------------------------------------
-bool SimpleGeometryShader::SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
+bool SimpleGeometryShader::SetShaderResourceView(const char* name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
 {
 	// Look for the variable and verify
 	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
@@ -1628,7 +1739,7 @@ bool SimpleGeometryShader::SetShaderResourceView(std::string name, Microsoft::WR
 //
 // Returns true if a sampler of the given name was found, false otherwise
 // --------------------------------------------------------
-bool SimpleGeometryShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState)
+bool SimpleGeometryShader::SetSamplerState(const char* name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState)
 {
 	// Look for the variable and verify
 	const SimpleSampler* sampInfo = GetSamplerInfo(name);
@@ -1856,7 +1967,7 @@ void SimpleComputeShader::DispatchByThreads(unsigned int threadsX, unsigned int
 // --------------------------------------------------------
 // Determines if this shader has the specified UAV
 // --------------------------------------------------------
-bool SimpleComputeShader::HasUnorderedAccessView(std::string name)
+bool SimpleComputeShader::HasUnorderedAccessView(const char* name)
 {
 	return GetUnorderedAccessViewIndex(name) != -1;
 }
@@ -1869,7 +1980,7 @@ bool SimpleComputeShader::HasUnorderedAccessView(std::string name)
 //
 // Returns true if a texture of the given name was found, false otherwise
 // --------------------------------------------------------
-bool SimpleComputeShader::SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
+bool SimpleComputeShader::SetShaderResourceView(const char* name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
 {
 	// Look for the variable and verify
 	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
@@ -1899,7 +2010,7 @@ bool SimpleComputeShader::SetShaderResourceView(std::string name, Microsoft::WRL
 //
 // Returns true if a sampler of the given name was found, false otherwise
 // --------------------------------------------------------
-bool SimpleComputeShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState)
+bool SimpleComputeShader::SetSamplerState(const char* name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState)
 {
 	// Look for the variable and verify
 	const SimpleSampler* sampInfo = GetSamplerInfo(name);
@@ -1930,7 +2041,7 @@ bool SimpleComputeShader::SetSamplerState(std::string name, Microsoft::WRL::ComP
 //
 // Returns true if a UAV of the given name was found, false otherwise
 // --------------------------------------------------------
-bool SimpleComputeShader::SetUnorderedAccessView(std::string name, Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> uav, unsigned int appendConsumeOffset)
+bool SimpleComputeShader::SetUnorderedAccessView(const char* name, Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> uav, unsigned int appendConsumeOffset)
 {
 	// Look for the variable and verify
 	unsigned int bindIndex = GetUnorderedAccessViewIndex(name);
@@ -1955,11 +2066,11 @@ bool SimpleComputeShader::SetUnorderedAccessView(std::string name, Microsoft::WR
 // --------------------------------------------------------
 // Gets the index of the specified UAV (or -1)
 // --------------------------------------------------------
-int SimpleComputeShader::GetUnorderedAccessViewIndex(std::string name)
+int SimpleComputeShader::GetUnorderedAccessViewIndex(const char* name)
 {
 	// Look for the key
 	std::unordered_map<std::string, unsigned int>::iterator result =
-		uavTable.find(name);
+		uavTable.find(LookupName(name));
 
 	// Did we find the key?
 	if (result == uavTable.end())
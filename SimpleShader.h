@@ -57,6 +57,21 @@ struct SimpleSampler
 	unsigned int BindIndex; // The register of the Sampler
 };
 
+class ISimpleShader;
+
+// --------------------------------------------------------
+// Gets told when shaders are set and their constant buffers
+// are copied, so tools like the command trace can see them
+//  - Called on whatever thread uses the shader
+// --------------------------------------------------------
+class ISimpleShaderObserver
+{
+public:
+	virtual ~ISimpleShaderObserver() {}
+	virtual void OnShaderSet(ISimpleShader* shader) = 0;
+	virtual void OnBufferCopied(ISimpleShader* shader, unsigned int index) = 0;
+};
+
 // --------------------------------------------------------
 // Base abstract class for simplifying shader handling
 // --------------------------------------------------------
@@ -73,55 +88,67 @@ public:
 	void SetShader();
 	void CopyAllBufferData();
 	void CopyBufferData(unsigned int index);
-	void CopyBufferData(std::string bufferName);
+	void CopyBufferData(const char* bufferName);
 
 	// Sets arbitrary shader data
-	bool SetData(std::string name, const void* data, unsigned int size);
-
-	bool SetInt(std::string name, int data);
-	bool SetFloat(std::string name, float data);
-	bool SetFloat2(std::string name, const float data[2]);
-	bool SetFloat2(std::string name, const DirectX::XMFLOAT2 data);
-	bool SetFloat3(std::string name, const float data[3]);
-	bool SetFloat3(std::string name, const DirectX::XMFLOAT3 data);
-	bool SetFloat4(std::string name, const float data[4]);
-	bool SetFloat4(std::string name, const DirectX::XMFLOAT4 data);
-	bool SetMatrix4x4(std::string name, const float data[16]);
-	bool SetMatrix4x4(std::string name, const DirectX::XMFLOAT4X4 data);
+	bool SetData(const char* name, const void* data, unsigned int size);
+	bool SetBufferData(const char* bufferName, const void* data, unsigned int size);
+
+	bool SetInt(const char* name, int data);
+	bool SetFloat(const char* name, float data);
+	bool SetFloat2(const char* name, const float data[2]);
+	bool SetFloat2(const char* name, const DirectX::XMFLOAT2 data);
+	bool SetFloat3(const char* name, const float data[3]);
+	bool SetFloat3(const char* name, const DirectX::XMFLOAT3 data);
+	bool SetFloat4(const char* name, const float data[4]);
+	bool SetFloat4(const char* name, const DirectX::XMFLOAT4 data);
+	bool SetMatrix4x4(const char* name, const float data[16]);
+	bool SetMatrix4x4(const char* name, const DirectX::XMFLOAT4X4 data);
 
 	// Setting shader resources
-	virtual bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv) = 0;
-	virtual bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState) = 0;
+	virtual bool SetShaderResourceView(const char* name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv) = 0;
+	virtual bool SetSamplerState(const char* name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState) = 0;
 
 	// Simple resource checking
-	bool HasVariable(std::string name);
-	bool HasShaderResourceView(std::string name);
-	bool HasSamplerState(std::string name);
+	bool HasVariable(const char* name);
+	bool HasShaderResourceView(const char* name);
+	bool HasSamplerState(const char* name);
 
 	// Getting data about variables and resources
-	const SimpleShaderVariable* GetVariableInfo(std::string name);
+	const SimpleShaderVariable* GetVariableInfo(const char* name);
 	
-	const SimpleSRV* GetShaderResourceViewInfo(std::string name);
+	const SimpleSRV* GetShaderResourceViewInfo(const char* name);
 	const SimpleSRV* GetShaderResourceViewInfo(unsigned int index);
 	size_t GetShaderResourceViewCount() { return textureTable.size(); }
 	
-	const SimpleSampler* GetSamplerInfo(std::string name);
+	const SimpleSampler* GetSamplerInfo(const char* name);
 	const SimpleSampler* GetSamplerInfo(unsigned int index);
 	size_t GetSamplerCount() { return samplerTable.size(); }
 
+	// Everything reflected, by name, for building binding tables
+	const std::unordered_map<std::string, SimpleShaderVariable>& GetVariableTable() { return varTable; }
+	const std::unordered_map<std::string, SimpleSRV*>& GetShaderResourceViewTable() { return textureTable; }
+	const std::unordered_map<std::string, SimpleSampler*>& GetSamplerTable() { return samplerTable; }
+
 	// Get data about constant buffers
 	unsigned int GetBufferCount();
 	unsigned int GetBufferSize(unsigned int index);
-	const SimpleConstantBuffer* GetBufferInfo(std::string name);
+	const SimpleConstantBuffer* GetBufferInfo(const char* name);
 	const SimpleConstantBuffer* GetBufferInfo(unsigned int index);
 	
 	// Misc getters
 	Microsoft::WRL::ComPtr<ID3DBlob> GetShaderBlob() { return shaderBlob; }
 
+	// Swapping in recompiled code, keeping variable values
+	bool Reload(Microsoft::WRL::ComPtr<ID3DBlob> blob);
+
 	// Error reporting
 	static bool ReportErrors;
 	static bool ReportWarnings;
 
+	// Optional observer of every shader's sets and copies
+	static ISimpleShaderObserver* Observer;
+
 protected:
 	
 	bool shaderValid;
@@ -143,6 +170,7 @@ protected:
 
 	// Initialization method
 	bool LoadShaderFile(LPCWSTR shaderFile);
+	bool LoadShaderBlob(Microsoft::WRL::ComPtr<ID3DBlob> blob);
 
 	// Pure virtual functions for dealing with shader types
 	virtual bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob) = 0;
@@ -151,8 +179,8 @@ protected:
 	virtual void CleanUp();
 
 	// Helpers for finding data by name
-	SimpleShaderVariable* FindVariable(std::string name, int size);
-	SimpleConstantBuffer* FindConstantBuffer(std::string name);
+	SimpleShaderVariable* FindVariable(const char* name, int size);
+	SimpleConstantBuffer* FindConstantBuffer(const char* name);
 
 	// Error logging
 	void Log(std::string message, WORD color);
@@ -178,8 +206,8 @@ public:
 	Microsoft::WRL::ComPtr<ID3D11InputLayout> GetInputLayout() { return inputLayout; }
 	bool GetPerInstanceCompatible() { return perInstanceCompatible; }
 
-	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
-	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
+	bool SetShaderResourceView(const char* name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
+	bool SetSamplerState(const char* name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
 
 protected:
 	bool perInstanceCompatible;
@@ -201,8 +229,8 @@ public:
 	~SimplePixelShader();
 	Microsoft::WRL::ComPtr<ID3D11PixelShader> GetDirectXShader() { return shader; }
 
-	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
-	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
+	bool SetShaderResourceView(const char* name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
+	bool SetSamplerState(const char* name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
 
 protected:
 	Microsoft::WRL::ComPtr<ID3D11PixelShader> shader;
@@ -221,8 +249,8 @@ public:
 	~SimpleDomainShader();
 	Microsoft::WRL::ComPtr<ID3D11DomainShader> GetDirectXShader() { return shader; }
 
-	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
-	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
+	bool SetShaderResourceView(const char* name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
+	bool SetSamplerState(const char* name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
 
 protected:
 	Microsoft::WRL::ComPtr<ID3D11DomainShader> shader;
@@ -241,8 +269,8 @@ public:
 	~SimpleHullShader();
 	Microsoft::WRL::ComPtr<ID3D11HullShader> GetDirectXShader() { return shader; }
 
-	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
-	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
+	bool SetShaderResourceView(const char* name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
+	bool SetSamplerState(const char* name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
 
 protected:
 	Microsoft::WRL::ComPtr<ID3D11HullShader> shader;
@@ -261,8 +289,8 @@ public:
 	~SimpleGeometryShader();
 	Microsoft::WRL::ComPtr<ID3D11GeometryShader> GetDirectXShader() { return shader; }
 
-	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
-	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
+	bool SetShaderResourceView(const char* name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
+	bool SetSamplerState(const char* name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
 
 	bool CreateCompatibleStreamOutBuffer(Microsoft::WRL::ComPtr<ID3D11Buffer> buffer, int vertexCount);
 
@@ -300,13 +328,13 @@ public:
 	void DispatchByGroups(unsigned int groupsX, unsigned int groupsY, unsigned int groupsZ);
 	void DispatchByThreads(unsigned int threadsX, unsigned int threadsY, unsigned int threadsZ);
 
-	bool HasUnorderedAccessView(std::string name);
+	bool HasUnorderedAccessView(const char* name);
 
-	bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
-	bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
-	bool SetUnorderedAccessView(std::string name, Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> uav, unsigned int appendConsumeOffset = -1);
+	bool SetShaderResourceView(const char* name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
+	bool SetSamplerState(const char* name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState);
+	bool SetUnorderedAccessView(const char* name, Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> uav, unsigned int appendConsumeOffset = -1);
 
-	int GetUnorderedAccessViewIndex(std::string name);
+	int GetUnorderedAccessViewIndex(const char* name);
 
 protected:
 	Microsoft::WRL::ComPtr<ID3D11ComputeShader> shader;
@@ -0,0 +1,46 @@
+#include "SoftwareCoverage.h"
+
+#include <algorithm>
+#include <cmath>
+
+bool SoftwareCoverage::Setup(const float* x, const float* y, const float* z, int width, int height, CoverageTriangle& triangle) {
+	float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	if (!(area > 0.0f)) return false;
+
+	triangle.MinX = (std::max)((int)std::floor((std::min)({ x[0], x[1], x[2] })), 0);
+	triangle.MinY = (std::max)((int)std::floor((std::min)({ y[0], y[1], y[2] })), 0);
+	triangle.MaxX = (std::min)((int)std::ceil((std::max)({ x[0], x[1], x[2] })), width - 1);
+	triangle.MaxY = (std::min)((int)std::ceil((std::max)({ y[0], y[1], y[2] })), height - 1);
+	if (triangle.MinX > triangle.MaxX || triangle.MinY > triangle.MaxY) return false;
+
+	//Each edge function is the area of the triangle the pixel
+	//makes with that edge
+	float invArea = 1.0f / area;
+	for (int i = 0; i < 3; i++) {
+		int j = (i + 1) % 3;
+		int k = (i + 2) % 3;
+		triangle.EdgeA[i] = -(y[k] - y[j]) * invArea;
+		triangle.EdgeB[i] = (x[k] - x[j]) * invArea;
+		triangle.EdgeC[i] = -(triangle.EdgeA[i] * x[j] + triangle.EdgeB[i] * y[j]);
+		triangle.Z[i] = z[i];
+	}
+
+	triangle.MinZ = (std::min)({ z[0], z[1], z[2] });
+	return true;
+}
+
+// --------------------------------------------------------
+// Checks the rectangle's corner that's furthest inside each
+// edge, so it's only rejected when entirely outside one
+// --------------------------------------------------------
+bool SoftwareCoverage::TouchesRect(const CoverageTriangle& triangle, float left, float top, float right, float bottom) {
+	for (int e = 0; e < 3; e++) {
+		float best =
+			triangle.EdgeA[e] * (triangle.EdgeA[e] > 0 ? right : left) +
+			triangle.EdgeB[e] * (triangle.EdgeB[e] > 0 ? bottom : top) +
+			triangle.EdgeC[e];
+		if (!(best >= 0.0f)) return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <emmintrin.h> // SSE2
+
+// --------------------------------------------------------
+// A triangle's coverage and depth on screen
+//  - Edge i is opposite corner i, and the edge functions are
+//     scaled by 1/area, so at a pixel they're its barycentrics
+//  - Bounds are whole pixels, already clamped to the screen
+// --------------------------------------------------------
+struct CoverageTriangle {
+	float EdgeA[3];
+	float EdgeB[3];
+	float EdgeC[3];
+	float Z[3];
+	float MinZ;
+	int MinX, MinY, MaxX, MaxY;
+};
+
+// --------------------------------------------------------
+// Which pixels a screen space triangle covers, for the
+// software rasterizer
+//
+// - A pixel is covered when its center is inside or on
+//    every edge, so edges shared by two triangles are drawn
+//    by both, and never by neither
+// - Clockwise on screen is front facing, matching D3D's
+//    default, and everything else is culled
+// - Tests four pixels of a row at a time with SSE
+// - Knows nothing of DirectXMath or meshes, so it can be
+//    tested against a reference anywhere
+// --------------------------------------------------------
+class SoftwareCoverage {
+private:
+	__m128 edgeA[3];
+	__m128 edgeB[3];
+	__m128 edgeC[3];
+	__m128 minX;
+	__m128 maxX;
+
+public:
+	//Sets up a triangle from its corners in pixels, with y down
+	// - Returns false when it's back facing, has no area, or
+	//    misses the screen
+	static bool Setup(const float* x, const float* y, const float* z, int width, int height, CoverageTriangle& triangle);
+
+	//Whether the triangle might cover a pixel center in the
+	//rectangle, given by its first and last pixel centers
+	// - Never false for a rectangle with covered pixels, but
+	//    can be true for one without
+	static bool TouchesRect(const CoverageTriangle& triangle, float left, float top, float right, float bottom);
+
+	//The triangle's edges spread across SIMD lanes
+	explicit SoftwareCoverage(const CoverageTriangle& triangle) {
+		for (int e = 0; e < 3; e++) {
+			edgeA[e] = _mm_set1_ps(triangle.EdgeA[e]);
+			edgeB[e] = _mm_set1_ps(triangle.EdgeB[e]);
+			edgeC[e] = _mm_set1_ps(triangle.EdgeC[e]);
+		}
+		minX = _mm_set1_ps((float)triangle.MinX);
+		maxX = _mm_set1_ps((float)triangle.MaxX + 1.0f);
+	}
+
+	//Tests pixels x to x + 3 of row y, returning a lane mask of
+	//the covered ones and every lane's barycentrics
+	// - Defined here so the raster loop can inline it
+	__m128 TestQuad(int x, int y, __m128* barycentrics) const {
+		const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+		__m128 px = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+		__m128 py = _mm_set1_ps(y + 0.5f);
+
+		__m128 inside = _mm_and_ps(_mm_cmpge_ps(px, minX), _mm_cmplt_ps(px, maxX));
+		for (int e = 0; e < 3; e++) {
+			barycentrics[e] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(edgeA[e], px), _mm_mul_ps(edgeB[e], py)), edgeC[e]);
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(barycentrics[e], _mm_setzero_ps()));
+		}
+
+		return inside;
+	}
+};
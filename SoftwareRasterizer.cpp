@@ -0,0 +1,568 @@
+#include "SoftwareRasterizer.h"
+#include "SoftwareShading.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <emmintrin.h> // SSE2
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+
+using namespace DirectX;
+
+// Triangles each binning job takes, at the least
+#define SOFTWARE_MIN_CHUNK_TRIANGLES 256
+
+SoftwareRasterizer::SoftwareRasterizer(int width, int height) :
+	items(0),
+	frame(0) {
+	Resize(width, height);
+}
+
+SoftwareRasterizer::~SoftwareRasterizer() {
+}
+
+// --------------------------------------------------------
+// Sizes the buffers, padded out to whole tiles so blocks
+// never need bounds checks
+// --------------------------------------------------------
+void SoftwareRasterizer::Resize(int width, int height) {
+	this->width = (std::max)(width, 1);
+	this->height = (std::max)(height, 1);
+
+	tilesX = (this->width + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+	tilesY = (this->height + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+	stride = tilesX * SOFTWARE_TILE_SIZE;
+	paddedHeight = tilesY * SOFTWARE_TILE_SIZE;
+
+	colorBuffer.assign((size_t)stride * paddedHeight, 0);
+	depthBuffer.assign((size_t)stride * paddedHeight, 1.0f);
+	blockMaxDepth.assign((size_t)(stride / SOFTWARE_BLOCK_SIZE) * (paddedHeight / SOFTWARE_BLOCK_SIZE), 1.0f);
+}
+
+void SoftwareRasterizer::Render(const std::vector<SoftwareDrawItem>& items, const SoftwareFrame& frame) {
+	PROFILE_SCOPE("Software Render");
+
+	JobSystem& jobSystem = JobSystem::GetInstance();
+	this->items = &items;
+	this->frame = &frame;
+	stats = SoftwareRasterStats();
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	//Clear
+	uint32_t clear =
+		(uint32_t)((std::min)((std::max)(frame.ClearColor.x, 0.0f), 1.0f) * 255.0f + 0.5f) |
+		(uint32_t)((std::min)((std::max)(frame.ClearColor.y, 0.0f), 1.0f) * 255.0f + 0.5f) << 8 |
+		(uint32_t)((std::min)((std::max)(frame.ClearColor.z, 0.0f), 1.0f) * 255.0f + 0.5f) << 16 |
+		0xFF000000;
+	std::fill(colorBuffer.begin(), colorBuffer.end(), clear);
+	std::fill(depthBuffer.begin(), depthBuffer.end(), 1.0f);
+	std::fill(blockMaxDepth.begin(), blockMaxDepth.end(), 1.0f);
+
+	//Vertex stage, a job per draw
+	clipVertices.resize(items.size());
+	drawTriangleStart.assign(items.size() + 1, 0);
+	for (size_t i = 0; i < items.size(); i++) {
+		drawTriangleStart[i + 1] = drawTriangleStart[i] + items[i].DrawMesh->GetIndices().size() / 3;
+	}
+	stats.TrianglesIn = (unsigned int)drawTriangleStart.back();
+
+	jobSystem.ParallelFor(items.size(), 1, [this](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) TransformVertices(i);
+	});
+
+	auto vertexEnd = std::chrono::high_resolution_clock::now();
+
+	//Clip, set up and bin, a job per chunk of triangles
+	size_t triangleCount = drawTriangleStart.back();
+	size_t chunkCount = (std::min)(
+		(std::max)(triangleCount / SOFTWARE_MIN_CHUNK_TRIANGLES, (size_t)1),
+		(size_t)jobSystem.GetThreadCount() * 4);
+
+	chunks.resize(chunkCount);
+	for (size_t i = 0; i < chunkCount; i++) {
+		chunks[i].Begin = triangleCount * i / chunkCount;
+		chunks[i].End = triangleCount * (i + 1) / chunkCount;
+	}
+
+	jobSystem.ParallelFor(chunkCount, 1, [this](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) BinTriangles(chunks[i]);
+	});
+
+	auto binEnd = std::chrono::high_resolution_clock::now();
+
+	//Rasterize and shade, a job per tile
+	size_t tileCount = (size_t)tilesX * tilesY;
+	std::vector<uint64_t> tested(tileCount), shaded(tileCount), skipped(tileCount);
+
+	jobSystem.ParallelFor(tileCount, 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			RasterizeTile((int)(i % tilesX), (int)(i / tilesX), tested[i], shaded[i], skipped[i]);
+		}
+	});
+
+	auto rasterEnd = std::chrono::high_resolution_clock::now();
+
+	//Gather the stats
+	for (size_t i = 0; i < tileCount; i++) {
+		stats.PixelsTested += tested[i];
+		stats.PixelsShaded += shaded[i];
+		stats.BlocksSkipped += skipped[i];
+	}
+
+	for (TriangleChunk& chunk : chunks) {
+		stats.TrianglesCulled += chunk.Culled;
+		stats.TrianglesClipped += chunk.Clipped;
+		for (std::vector<uint32_t>& bin : chunk.Bins) stats.TileBins += (unsigned int)bin.size();
+	}
+
+	stats.VertexMilliseconds = std::chrono::duration<float, std::milli>(vertexEnd - start).count();
+	stats.BinMilliseconds = std::chrono::duration<float, std::milli>(binEnd - vertexEnd).count();
+	stats.RasterMilliseconds = std::chrono::duration<float, std::milli>(rasterEnd - binEnd).count();
+	stats.TotalMilliseconds = std::chrono::duration<float, std::milli>(rasterEnd - start).count();
+
+	double seconds = (std::max)(stats.TotalMilliseconds / 1000.0, 1e-9);
+	stats.TrianglesPerSecond = stats.TrianglesIn / seconds;
+	stats.PixelsPerSecond = stats.PixelsShaded / seconds;
+
+	this->items = 0;
+	this->frame = 0;
+}
+
+SoftwareRasterStats SoftwareRasterizer::Benchmark(const std::vector<SoftwareDrawItem>& items, const SoftwareFrame& frame, int iterations) {
+	iterations = (std::max)(iterations, 1);
+
+	SoftwareRasterStats total;
+	for (int i = 0; i < iterations; i++) {
+		Render(items, frame);
+		total.VertexMilliseconds += stats.VertexMilliseconds;
+		total.BinMilliseconds += stats.BinMilliseconds;
+		total.RasterMilliseconds += stats.RasterMilliseconds;
+		total.TotalMilliseconds += stats.TotalMilliseconds;
+	}
+
+	//Counts are the same every time, so keep the last run's
+	SoftwareRasterStats result = stats;
+	result.VertexMilliseconds = total.VertexMilliseconds / iterations;
+	result.BinMilliseconds = total.BinMilliseconds / iterations;
+	result.RasterMilliseconds = total.RasterMilliseconds / iterations;
+	result.TotalMilliseconds = total.TotalMilliseconds / iterations;
+
+	double seconds = (std::max)(total.TotalMilliseconds / 1000.0, 1e-9);
+	result.TrianglesPerSecond = (double)stats.TrianglesIn * iterations / seconds;
+	result.PixelsPerSecond = (double)stats.PixelsShaded * iterations / seconds;
+
+	stats = result;
+	return result;
+}
+
+// --------------------------------------------------------
+// Same transforms as VertexShader.hlsl, which multiplies
+// by the transposed matrices from the other side
+// --------------------------------------------------------
+void SoftwareRasterizer::TransformVertices(size_t draw) {
+	const SoftwareDrawItem& item = (*items)[draw];
+	const std::vector<Vertex>& vertices = item.DrawMesh->GetVertices();
+
+	XMMATRIX world = XMLoadFloat4x4(&item.World);
+	XMMATRIX worldInvTranspose = XMLoadFloat4x4(&item.WorldInvTranspose);
+	XMMATRIX wvp = world * XMLoadFloat4x4(&frame->View) * XMLoadFloat4x4(&frame->Projection);
+
+	std::vector<ClipVertex>& output = clipVertices[draw];
+	output.resize(vertices.size());
+
+	for (size_t i = 0; i < vertices.size(); i++) {
+		XMVECTOR position = XMLoadFloat3(&vertices[i].Position);
+		XMStoreFloat4(&output[i].Position, XMVector3Transform(position, wvp));
+		XMStoreFloat3(&output[i].WorldPosition, XMVector3Transform(position, world));
+		XMStoreFloat3(&output[i].Normal, XMVector3TransformNormal(XMLoadFloat3(&vertices[i].Normal), worldInvTranspose));
+	}
+}
+
+// --------------------------------------------------------
+// Clips a chunk's triangles to the near plane, then sets up
+// and bins whatever is left
+// --------------------------------------------------------
+void SoftwareRasterizer::BinTriangles(TriangleChunk& chunk) {
+	PROFILE_SCOPE("Bin Triangles");
+
+	chunk.Triangles.clear();
+	chunk.Bins.resize((size_t)tilesX * tilesY);
+	for (std::vector<uint32_t>& bin : chunk.Bins) bin.clear();
+	chunk.Culled = 0;
+	chunk.Clipped = 0;
+
+	//Find the draw the chunk starts in
+	size_t draw = std::upper_bound(drawTriangleStart.begin(), drawTriangleStart.end(), chunk.Begin) - drawTriangleStart.begin() - 1;
+
+	for (size_t t = chunk.Begin; t < chunk.End; t++) {
+		while (t >= drawTriangleStart[draw + 1]) draw++;
+
+		const std::vector<unsigned int>& indices = (*items)[draw].DrawMesh->GetIndices();
+		const std::vector<ClipVertex>& vertices = clipVertices[draw];
+		size_t first = (t - drawTriangleStart[draw]) * 3;
+
+		ClipVertex triangle[3] = {
+			vertices[indices[first]],
+			vertices[indices[first + 1]],
+			vertices[indices[first + 2]]
+		};
+
+		//Entirely outside one side of the frustum
+		bool outside = false;
+		for (int axis = 0; axis < 3 && !outside; axis++) {
+			bool allBelow = true, allAbove = true;
+			for (int v = 0; v < 3; v++) {
+				const float* p = &triangle[v].Position.x;
+				allBelow &= p[axis] < (axis == 2 ? 0.0f : -p[3]);
+				allAbove &= p[axis] > p[3];
+			}
+			outside = allBelow || allAbove;
+		}
+
+		if (outside) {
+			chunk.Culled++;
+			continue;
+		}
+
+		//Entirely in front of the near plane (z >= 0 in D3D clip space)
+		bool inFront[3];
+		int inFrontCount = 0;
+		for (int v = 0; v < 3; v++) {
+			inFront[v] = triangle[v].Position.z >= 0.0f;
+			inFrontCount += inFront[v] ? 1 : 0;
+		}
+
+		if (inFrontCount == 3) {
+			SetupTriangle(chunk, triangle, (uint32_t)draw);
+			continue;
+		}
+
+		//Crosses the near plane, so cut it down to a polygon
+		//of up to four vertices and fan it into triangles
+		chunk.Clipped++;
+
+		ClipVertex polygon[4];
+		int polygonCount = 0;
+		for (int v = 0; v < 3; v++) {
+			const ClipVertex& a = triangle[v];
+			const ClipVertex& b = triangle[(v + 1) % 3];
+
+			if (inFront[v]) polygon[polygonCount++] = a;
+
+			if (inFront[v] != inFront[(v + 1) % 3]) {
+				float s = a.Position.z / (a.Position.z - b.Position.z);
+
+				ClipVertex& clipped = polygon[polygonCount++];
+				XMStoreFloat4(&clipped.Position, XMVectorLerp(XMLoadFloat4(&a.Position), XMLoadFloat4(&b.Position), s));
+				XMStoreFloat3(&clipped.WorldPosition, XMVectorLerp(XMLoadFloat3(&a.WorldPosition), XMLoadFloat3(&b.WorldPosition), s));
+				XMStoreFloat3(&clipped.Normal, XMVectorLerp(XMLoadFloat3(&a.Normal), XMLoadFloat3(&b.Normal), s));
+			}
+		}
+
+		for (int v = 1; v + 1 < polygonCount; v++) {
+			ClipVertex fan[3] = { polygon[0], polygon[v], polygon[v + 1] };
+			SetupTriangle(chunk, fan, (uint32_t)draw);
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Projects a triangle to the screen, culls it if it's back
+// facing or tiny, and adds it to every tile it touches
+// --------------------------------------------------------
+void SoftwareRasterizer::SetupTriangle(TriangleChunk& chunk, const ClipVertex* vertices, uint32_t draw) {
+	RasterTriangle triangle = {};
+	float x[3], y[3], z[3];
+
+	for (int v = 0; v < 3; v++) {
+		float invW = 1.0f / vertices[v].Position.w;
+		x[v] = (vertices[v].Position.x * invW * 0.5f + 0.5f) * width;
+		y[v] = (0.5f - vertices[v].Position.y * invW * 0.5f) * height;
+		z[v] = vertices[v].Position.z * invW;
+		triangle.InvW[v] = invW;
+		XMStoreFloat3(&triangle.WorldOverW[v], XMLoadFloat3(&vertices[v].WorldPosition) * invW);
+		XMStoreFloat3(&triangle.NormalOverW[v], XMLoadFloat3(&vertices[v].Normal) * invW);
+	}
+
+	if (!SoftwareCoverage::Setup(x, y, z, width, height, triangle)) {
+		chunk.Culled++;
+		return;
+	}
+
+	triangle.Draw = draw;
+
+	uint32_t index = (uint32_t)chunk.Triangles.size();
+	chunk.Triangles.push_back(triangle);
+
+	//Bin into the tiles the bounds overlap, skipping any tile
+	//that's entirely outside one of the edges
+	for (int ty = triangle.MinY / SOFTWARE_TILE_SIZE; ty <= triangle.MaxY / SOFTWARE_TILE_SIZE; ty++) {
+		for (int tx = triangle.MinX / SOFTWARE_TILE_SIZE; tx <= triangle.MaxX / SOFTWARE_TILE_SIZE; tx++) {
+			float left = tx * SOFTWARE_TILE_SIZE + 0.5f;
+			float top = ty * SOFTWARE_TILE_SIZE + 0.5f;
+			float right = left + SOFTWARE_TILE_SIZE - 1;
+			float bottom = top + SOFTWARE_TILE_SIZE - 1;
+
+			if (SoftwareCoverage::TouchesRect(triangle, left, top, right, bottom)) chunk.Bins[(size_t)ty * tilesX + tx].push_back(index);
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Draws every triangle binned to a tile, in submission order
+// --------------------------------------------------------
+void SoftwareRasterizer::RasterizeTile(int tileX, int tileY, uint64_t& pixelsTested, uint64_t& pixelsShaded, uint64_t& blocksSkipped) {
+	int tileLeft = tileX * SOFTWARE_TILE_SIZE;
+	int tileTop = tileY * SOFTWARE_TILE_SIZE;
+	int tileRight = tileLeft + SOFTWARE_TILE_SIZE - 1;
+	int tileBottom = tileTop + SOFTWARE_TILE_SIZE - 1;
+	size_t tile = (size_t)tileY * tilesX + tileX;
+	int blocksPerRow = stride / SOFTWARE_BLOCK_SIZE;
+
+	pixelsTested = 0;
+	pixelsShaded = 0;
+	blocksSkipped = 0;
+
+	for (TriangleChunk& chunk : chunks) {
+		for (uint32_t index : chunk.Bins[tile]) {
+			const RasterTriangle& triangle = chunk.Triangles[index];
+
+			int firstBlockX = (std::max)(triangle.MinX, tileLeft) / SOFTWARE_BLOCK_SIZE;
+			int firstBlockY = (std::max)(triangle.MinY, tileTop) / SOFTWARE_BLOCK_SIZE;
+			int lastBlockX = (std::min)(triangle.MaxX, tileRight) / SOFTWARE_BLOCK_SIZE;
+			int lastBlockY = (std::min)(triangle.MaxY, tileBottom) / SOFTWARE_BLOCK_SIZE;
+
+			for (int by = firstBlockY; by <= lastBlockY; by++) {
+				for (int bx = firstBlockX; bx <= lastBlockX; bx++) {
+					//Nothing in the block is nearer than the whole triangle
+					float& blockDepth = blockMaxDepth[(size_t)by * blocksPerRow + bx];
+					if (triangle.MinZ >= blockDepth) {
+						blocksSkipped++;
+						continue;
+					}
+
+					//Block is entirely outside an edge
+					float left = bx * SOFTWARE_BLOCK_SIZE + 0.5f;
+					float top = by * SOFTWARE_BLOCK_SIZE + 0.5f;
+					float right = left + SOFTWARE_BLOCK_SIZE - 1;
+					float bottom = top + SOFTWARE_BLOCK_SIZE - 1;
+					if (!SoftwareCoverage::TouchesRect(triangle, left, top, right, bottom)) continue;
+
+					if (!RasterizeBlock(triangle, bx * SOFTWARE_BLOCK_SIZE, by * SOFTWARE_BLOCK_SIZE, pixelsTested, pixelsShaded)) continue;
+
+					//Something was written, so refresh the block's farthest depth
+					__m128 farthest = _mm_setzero_ps();
+					for (int row = 0; row < SOFTWARE_BLOCK_SIZE; row++) {
+						const float* depthRow = &depthBuffer[(size_t)(by * SOFTWARE_BLOCK_SIZE + row) * stride + bx * SOFTWARE_BLOCK_SIZE];
+						farthest = _mm_max_ps(farthest, _mm_max_ps(_mm_loadu_ps(depthRow), _mm_loadu_ps(depthRow + 4)));
+					}
+					farthest = _mm_max_ps(farthest, _mm_shuffle_ps(farthest, farthest, _MM_SHUFFLE(2, 3, 0, 1)));
+					farthest = _mm_max_ps(farthest, _mm_shuffle_ps(farthest, farthest, _MM_SHUFFLE(1, 0, 3, 2)));
+					blockDepth = _mm_cvtss_f32(farthest);
+				}
+			}
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Tests and shades one 8x8 block, four pixels at a time
+//  - Returns whether any pixel was written
+// --------------------------------------------------------
+bool SoftwareRasterizer::RasterizeBlock(const RasterTriangle& triangle, int blockX, int blockY, uint64_t& pixelsTested, uint64_t& pixelsShaded) {
+	SoftwareCoverage coverage(triangle);
+
+	__m128 z0 = _mm_set1_ps(triangle.Z[0]);
+	__m128 z1 = _mm_set1_ps(triangle.Z[1]);
+	__m128 z2 = _mm_set1_ps(triangle.Z[2]);
+
+	int firstRow = (std::max)(blockY, triangle.MinY);
+	int lastRow = (std::min)(blockY + SOFTWARE_BLOCK_SIZE - 1, triangle.MaxY);
+	bool wrote = false;
+
+	for (int y = firstRow; y <= lastRow; y++) {
+		for (int x = blockX; x < blockX + SOFTWARE_BLOCK_SIZE; x += 4) {
+			//Barycentrics, straight from the scaled edge functions
+			__m128 b[3];
+			__m128 inside = coverage.TestQuad(x, y, b);
+
+			if (_mm_movemask_ps(inside) == 0) continue;
+
+			//Screen space depth is linear, so no perspective correction
+			__m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(b[0], z0), _mm_mul_ps(b[1], z1)), _mm_mul_ps(b[2], z2));
+
+			float* depth = &depthBuffer[(size_t)y * stride + x];
+			__m128 currentDepth = _mm_loadu_ps(depth);
+			__m128 pass = _mm_and_ps(inside, _mm_cmplt_ps(z, currentDepth));
+
+			//Bits set in each four bit lane mask
+			static const int laneCounts[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+			int mask = _mm_movemask_ps(pass);
+			pixelsTested += laneCounts[_mm_movemask_ps(inside)];
+			if (mask == 0) continue;
+
+			_mm_storeu_ps(depth, _mm_or_ps(_mm_and_ps(pass, z), _mm_andnot_ps(pass, currentDepth)));
+
+			alignas(16) float b0[4], b1[4], b2[4];
+			_mm_store_ps(b0, b[0]);
+			_mm_store_ps(b1, b[1]);
+			_mm_store_ps(b2, b[2]);
+
+			uint32_t* color = &colorBuffer[(size_t)y * stride + x];
+			for (int lane = 0; lane < 4; lane++) {
+				if (mask & (1 << lane)) {
+					color[lane] = ShadePixel(triangle, b0[lane], b1[lane], b2[lane]);
+					pixelsShaded++;
+				}
+			}
+
+			wrote = true;
+		}
+	}
+
+	return wrote;
+}
+
+// --------------------------------------------------------
+// Interpolates the attributes perspective correct, then
+// lights the pixel the way PixelShader.hlsl does
+// --------------------------------------------------------
+uint32_t SoftwareRasterizer::ShadePixel(const RasterTriangle& triangle, float b0, float b1, float b2) {
+	const SoftwareDrawItem& item = (*items)[triangle.Draw];
+
+	float w = 1.0f / (b0 * triangle.InvW[0] + b1 * triangle.InvW[1] + b2 * triangle.InvW[2]);
+
+	XMVECTOR worldPosition = (
+		XMLoadFloat3(&triangle.WorldOverW[0]) * b0 +
+		XMLoadFloat3(&triangle.WorldOverW[1]) * b1 +
+		XMLoadFloat3(&triangle.WorldOverW[2]) * b2) * w;
+
+	XMVECTOR normal = XMVector3Normalize(
+		XMLoadFloat3(&triangle.NormalOverW[0]) * b0 +
+		XMLoadFloat3(&triangle.NormalOverW[1]) * b1 +
+		XMLoadFloat3(&triangle.NormalOverW[2]) * b2);
+
+	XMVECTOR colorTint = XMLoadFloat4(&item.ColorTint);
+	XMVECTOR cameraPosition = XMLoadFloat3(&frame->CameraPosition);
+	XMVECTOR ambient = XMLoadFloat3(&frame->Ambient);
+
+	//No metalness map, so everything is a non-metal
+	float metalness = 0.0f;
+	float specularColor = SOFTWARE_F0_NON_METAL;
+
+	XMVECTOR finalLight = XMVectorZero();
+	for (const Light& light : frame->Lights) {
+		switch (light.Type) {
+		case LIGHT_TYPE_DIRECTIONAL:
+			finalLight += SoftwareShading::CalculateDirectionalLight(light, normal, colorTint, cameraPosition, worldPosition, item.Roughness, metalness);
+			break;
+		case LIGHT_TYPE_POINT:
+			finalLight += SoftwareShading::CalculatePointLight(light, normal, colorTint, ambient, cameraPosition, worldPosition, item.Roughness, specularColor);
+			break;
+		case LIGHT_TYPE_SPOT:
+			finalLight += SoftwareShading::CalculateSpotLight(light, normal, colorTint, ambient, cameraPosition, worldPosition, item.Roughness, specularColor);
+			break;
+		default:
+			break;
+		}
+	}
+
+	//Back to gamma space, then to bytes
+	XMFLOAT3 result;
+	XMStoreFloat3(&result, XMVectorSaturate(XMVectorPow(XMVectorMax(finalLight, XMVectorZero()), XMVectorReplicate(1.0f / 2.2f))));
+
+	return
+		(uint32_t)(result.x * 255.0f + 0.5f) |
+		(uint32_t)(result.y * 255.0f + 0.5f) << 8 |
+		(uint32_t)(result.z * 255.0f + 0.5f) << 16 |
+		0xFF000000;
+}
+
+int SoftwareRasterizer::GetWidth() {
+	return width;
+}
+
+int SoftwareRasterizer::GetHeight() {
+	return height;
+}
+
+std::vector<uint32_t> SoftwareRasterizer::GetImage() {
+	std::vector<uint32_t> image((size_t)width * height);
+	for (int y = 0; y < height; y++) {
+		std::copy(
+			colorBuffer.begin() + (size_t)y * stride,
+			colorBuffer.begin() + (size_t)y * stride + width,
+			image.begin() + (size_t)y * width);
+	}
+
+	return image;
+}
+
+// --------------------------------------------------------
+// Writes the image as an uncompressed, bottom up BMP
+// --------------------------------------------------------
+bool SoftwareRasterizer::SaveImage(const std::wstring& path) {
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open()) return false;
+
+	uint32_t rowBytes = ((uint32_t)width * 3 + 3) & ~3u;
+	uint32_t imageBytes = rowBytes * height;
+
+	unsigned char header[54] = { 'B', 'M' };
+	auto write32 = [&header](int offset, uint32_t value) {
+		for (int i = 0; i < 4; i++) header[offset + i] = (unsigned char)(value >> (i * 8));
+	};
+	write32(2, 54 + imageBytes);	// File size
+	write32(10, 54);				// Pixel data offset
+	write32(14, 40);				// Info header size
+	write32(18, (uint32_t)width);
+	write32(22, (uint32_t)height);
+	header[26] = 1;					// Planes
+	header[28] = 24;				// Bits per pixel
+	write32(34, imageBytes);
+	file.write((const char*)header, sizeof(header));
+
+	std::vector<unsigned char> row(rowBytes, 0);
+	for (int y = height - 1; y >= 0; y--) {
+		for (int x = 0; x < width; x++) {
+			uint32_t pixel = colorBuffer[(size_t)y * stride + x];
+			row[x * 3 + 0] = (unsigned char)(pixel >> 16);	// B
+			row[x * 3 + 1] = (unsigned char)(pixel >> 8);	// G
+			row[x * 3 + 2] = (unsigned char)pixel;			// R
+		}
+		file.write((const char*)row.data(), rowBytes);
+	}
+
+	return file.good();
+}
+
+const SoftwareRasterStats& SoftwareRasterizer::GetStats() {
+	return stats;
+}
+
+SoftwareImageDiff SoftwareRasterizer::Compare(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b, int tolerance) {
+	SoftwareImageDiff diff;
+	diff.SizesMatch = a.size() == b.size() && !a.empty();
+	if (!diff.SizesMatch) return diff;
+
+	uint64_t totalError = 0;
+	for (size_t i = 0; i < a.size(); i++) {
+		int pixelError = 0;
+		for (int channel = 0; channel < 3; channel++) {
+			int error = std::abs((int)((a[i] >> (channel * 8)) & 0xFF) - (int)((b[i] >> (channel * 8)) & 0xFF));
+			pixelError = (std::max)(pixelError, error);
+			totalError += error;
+		}
+
+		diff.MaxError = (std::max)(diff.MaxError, pixelError);
+		if (pixelError > tolerance) diff.PixelsOverTolerance++;
+	}
+
+	diff.MeanError = (double)totalError / (a.size() * 3);
+	return diff;
+}
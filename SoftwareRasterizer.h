@@ -0,0 +1,169 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Mesh.h"
+#include "Lights.h"
+#include "SoftwareCoverage.h"
+
+// Screen tiles each raster job owns, in pixels
+//  - Must be a multiple of the block size
+#define SOFTWARE_TILE_SIZE 64
+// Blocks that keep their own farthest depth for early rejection
+#define SOFTWARE_BLOCK_SIZE 8
+
+// --------------------------------------------------------
+// One mesh to draw, with the values PixelShader.hlsl gets
+// --------------------------------------------------------
+struct SoftwareDrawItem {
+	Mesh* DrawMesh;
+	DirectX::XMFLOAT4X4 World;
+	DirectX::XMFLOAT4X4 WorldInvTranspose;
+	DirectX::XMFLOAT4 ColorTint;
+	float Roughness;
+};
+
+// --------------------------------------------------------
+// Values shared by every draw in a frame
+// --------------------------------------------------------
+struct SoftwareFrame {
+	DirectX::XMFLOAT4X4 View;
+	DirectX::XMFLOAT4X4 Projection;
+	DirectX::XMFLOAT3 CameraPosition;
+	DirectX::XMFLOAT3 Ambient;
+	DirectX::XMFLOAT3 ClearColor;
+	std::vector<Light> Lights;
+};
+
+// --------------------------------------------------------
+// What the last render did, and how fast
+// --------------------------------------------------------
+struct SoftwareRasterStats {
+	unsigned int TrianglesIn = 0;
+	unsigned int TrianglesCulled = 0;	// Back facing, off screen or clipped away
+	unsigned int TrianglesClipped = 0;	// Crossed the near plane and were split
+	unsigned int TileBins = 0;			// Triangle entries across all tiles
+	uint64_t PixelsTested = 0;
+	uint64_t PixelsShaded = 0;
+	uint64_t BlocksSkipped = 0;			// Rejected by the blocks' farthest depth
+	float VertexMilliseconds = 0.0f;
+	float BinMilliseconds = 0.0f;
+	float RasterMilliseconds = 0.0f;
+	float TotalMilliseconds = 0.0f;
+	double TrianglesPerSecond = 0.0;
+	double PixelsPerSecond = 0.0;
+};
+
+// --------------------------------------------------------
+// How far apart two images are
+// --------------------------------------------------------
+struct SoftwareImageDiff {
+	bool SizesMatch = false;
+	int MaxError = 0;				// Largest difference in any channel, 0-255
+	double MeanError = 0.0;			// Average difference per channel
+	unsigned int PixelsOverTolerance = 0;
+};
+
+// --------------------------------------------------------
+// Multithreaded tile based CPU renderer, as a reference for
+// the GPU and a fallback where there isn't one
+//
+// - Vertices are transformed one job per draw, then triangles
+//    are clipped to the near plane, set up and binned into
+//    screen tiles by a job per chunk of triangles
+// - Each tile is then rasterized by its own job, visiting the
+//    chunks in order, so results don't depend on timing
+// - Coverage and depth are tested four pixels at a time with
+//    SoftwareCoverage's SSE edge functions, and each 8x8
+//    block keeps its farthest depth so hidden triangles skip
+//    whole blocks
+// - Attributes are interpolated perspective correct, and
+//    shaded with the C++ copy of the HLSL lighting
+// - Textures, normal maps and shadows aren't sampled, so
+//    albedo is white and roughness comes from the material
+// --------------------------------------------------------
+class SoftwareRasterizer {
+private:
+	//A vertex after the vertex stage
+	struct ClipVertex {
+		DirectX::XMFLOAT4 Position; // Clip space
+		DirectX::XMFLOAT3 WorldPosition;
+		DirectX::XMFLOAT3 Normal;
+	};
+
+	//A screen space triangle, ready to rasterize
+	// - Attributes are pre-divided by w for perspective correction
+	struct RasterTriangle : CoverageTriangle {
+		float InvW[3];
+		DirectX::XMFLOAT3 WorldOverW[3];
+		DirectX::XMFLOAT3 NormalOverW[3];
+		uint32_t Draw;
+	};
+
+	//Everything one binning job produced
+	struct TriangleChunk {
+		size_t Begin, End; // Range in the flattened triangle list
+		std::vector<RasterTriangle> Triangles;
+		std::vector<std::vector<uint32_t>> Bins; // Triangle indices, per tile
+		unsigned int Culled;
+		unsigned int Clipped;
+	};
+
+	int width;
+	int height;
+	int stride;			// Buffer width, padded to whole tiles
+	int paddedHeight;
+	int tilesX;
+	int tilesY;
+
+	std::vector<uint32_t> colorBuffer; // RGBA8, red in the low byte
+	std::vector<float> depthBuffer;
+	std::vector<float> blockMaxDepth;
+
+	//This frame's work
+	const std::vector<SoftwareDrawItem>* items;
+	const SoftwareFrame* frame;
+	std::vector<std::vector<ClipVertex>> clipVertices; // Per draw
+	std::vector<size_t> drawTriangleStart;				// Prefix sums of triangle counts
+	std::vector<TriangleChunk> chunks;
+
+	SoftwareRasterStats stats;
+
+	void TransformVertices(size_t draw);
+	void BinTriangles(TriangleChunk& chunk);
+	void SetupTriangle(TriangleChunk& chunk, const ClipVertex* vertices, uint32_t draw);
+	void RasterizeTile(int tileX, int tileY, uint64_t& pixelsTested, uint64_t& pixelsShaded, uint64_t& blocksSkipped);
+	bool RasterizeBlock(const RasterTriangle& triangle, int blockX, int blockY, uint64_t& pixelsTested, uint64_t& pixelsShaded);
+	uint32_t ShadePixel(const RasterTriangle& triangle, float b0, float b1, float b2);
+
+public:
+	SoftwareRasterizer(int width, int height);
+	~SoftwareRasterizer();
+
+	void Resize(int width, int height);
+
+	//Renders the draws into the color and depth buffers
+	void Render(const std::vector<SoftwareDrawItem>& items, const SoftwareFrame& frame);
+
+	//Renders the same frame several times and reports the
+	//averaged stats, with throughput over all of them
+	SoftwareRasterStats Benchmark(const std::vector<SoftwareDrawItem>& items, const SoftwareFrame& frame, int iterations);
+
+	int GetWidth();
+	int GetHeight();
+
+	//Tightly packed RGBA8 copy of the color buffer
+	std::vector<uint32_t> GetImage();
+
+	//Writes the color buffer as a 24 bit BMP
+	bool SaveImage(const std::wstring& path);
+
+	const SoftwareRasterStats& GetStats();
+
+	//Compares two tightly packed RGBA8 images
+	static SoftwareImageDiff Compare(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b, int tolerance);
+};
@@ -0,0 +1,124 @@
+#include "SoftwareShading.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace {
+	const float PI = 3.14159265359f;
+
+	float Saturate(float value) {
+		return (std::min)((std::max)(value, 0.0f), 1.0f);
+	}
+}
+
+//N dot L Diffuse Lighting Equation
+float SoftwareShading::Diffuse(FXMVECTOR normal, FXMVECTOR dirToLight) {
+	return Saturate(XMVectorGetX(XMVector3Dot(normal, dirToLight)));
+}
+
+//Phong Specular Calculation
+float SoftwareShading::Specular(FXMVECTOR R, FXMVECTOR V, float roughness) {
+	if (roughness > 0.05f) {
+		float specExponent = (1.0f - roughness) * SOFTWARE_MAX_SPECULAR_EXPONENT;
+		return std::pow(Saturate(XMVectorGetX(XMVector3Dot(R, V))), specExponent);
+	}
+	else {
+		return 0.0f;
+	}
+}
+
+//Attenuation Calculation
+float SoftwareShading::Attenuate(const Light& light, FXMVECTOR worldPos) {
+	float dist = XMVectorGetX(XMVector3Length(XMLoadFloat3(&light.Position) - worldPos));
+	float att = Saturate(1.0f - (dist * dist / (light.Range * light.Range)));
+	return att * att;
+}
+
+// Normal Distribution Function: GGX (Trowbridge-Reitz)
+float SoftwareShading::D_GGX(FXMVECTOR n, FXMVECTOR h, float roughness) {
+	float NdotH = Saturate(XMVectorGetX(XMVector3Dot(n, h)));
+	float NdotH2 = NdotH * NdotH;
+	float a = roughness * roughness;
+	float a2 = (std::max)(a * a, SOFTWARE_MIN_ROUGHNESS); // Applied after remap!
+
+	float denomToSquare = NdotH2 * (a2 - 1) + 1;
+	return a2 / (PI * denomToSquare * denomToSquare);
+}
+
+// Fresnel term - Schlick approx.
+XMVECTOR SoftwareShading::F_Schlick(FXMVECTOR v, FXMVECTOR h, FXMVECTOR f0) {
+	float VdotH = Saturate(XMVectorGetX(XMVector3Dot(v, h)));
+	return f0 + (XMVectorReplicate(1.0f) - f0) * std::pow(1 - VdotH, 5.0f);
+}
+
+// Geometric Shadowing - Schlick-GGX
+//  - Leaves out the NdotV numerator, as MicrofacetBRDF() does
+float SoftwareShading::G_SchlickGGX(FXMVECTOR n, FXMVECTOR v, float roughness) {
+	float k = std::pow(roughness + 1, 2.0f) / 8.0f;
+	float NdotV = Saturate(XMVectorGetX(XMVector3Dot(n, v)));
+	return 1 / (NdotV * (1 - k) + k);
+}
+
+// Cook-Torrance Microfacet BRDF (Specular)
+XMVECTOR SoftwareShading::MicrofacetBRDF(FXMVECTOR n, FXMVECTOR l, FXMVECTOR v, float roughness, XMVECTOR* F_out) {
+	XMVECTOR h = XMVector3Normalize(v + l);
+
+	float D = D_GGX(n, h, roughness);
+	XMVECTOR F = F_Schlick(v, h, XMVectorReplicate(SOFTWARE_F0_NON_METAL));
+	float G = G_SchlickGGX(n, v, roughness) * G_SchlickGGX(n, l, roughness);
+
+	*F_out = F;
+
+	XMVECTOR specularResult = (D * F * G) / 4;
+	return specularResult * (std::max)(XMVectorGetX(XMVector3Dot(n, l)), 0.0f);
+}
+
+//Spot light cone falloff
+float SoftwareShading::SpotTerm(const Light& light, FXMVECTOR worldPos) {
+	XMVECTOR surfaceToLight = XMVector3Normalize(XMLoadFloat3(&light.Position) - worldPos);
+	float pixelAngle = Saturate(XMVectorGetX(XMVector3Dot(-surfaceToLight, XMVector3Normalize(XMLoadFloat3(&light.Direction)))));
+	return std::pow(pixelAngle, light.SpotFalloff);
+}
+
+//Calculate Directional Lighting
+XMVECTOR SoftwareShading::CalculateDirectionalLight(const Light& light, FXMVECTOR normal, FXMVECTOR surfaceColor, FXMVECTOR cameraPos, GXMVECTOR worldPos, float roughness, float metalness) {
+	XMVECTOR toLight = XMVector3Normalize(-XMVector3Normalize(XMLoadFloat3(&light.Direction)));
+
+	//Lambert diffuse BRDF
+	float diffuse = Diffuse(normal, toLight);
+
+	XMVECTOR V = XMVector3Normalize(cameraPos - worldPos);
+	XMVECTOR F;
+
+	//PBR specular BRDF
+	XMVECTOR spec = MicrofacetBRDF(normal, toLight, V, roughness, &F);
+
+	//Diffuse with energy conservation, including cutting diffuse for metals
+	XMVECTOR balancedDiff = diffuse * (XMVectorReplicate(1.0f) - F) * (1 - metalness);
+
+	return (balancedDiff * surfaceColor + spec) * light.Intensity * XMLoadFloat3(&light.Color);
+}
+
+//Calculate Point Lighting
+XMVECTOR SoftwareShading::CalculatePointLight(const Light& light, FXMVECTOR normal, FXMVECTOR surfaceColor, FXMVECTOR ambient, GXMVECTOR cameraPos, HXMVECTOR worldPos, float roughness, float specTex) {
+	XMVECTOR surfaceToLight = XMVector3Normalize(XMLoadFloat3(&light.Position) - worldPos);
+	XMVECTOR lightDirection = XMVector3Normalize(-surfaceToLight);
+
+	float diffuse = Diffuse(normal, surfaceToLight);
+	XMVECTOR finalColor = (diffuse * XMLoadFloat3(&light.Color) * surfaceColor) + (ambient * surfaceColor);
+
+	XMVECTOR V = XMVector3Normalize(cameraPos - worldPos);
+	XMVECTOR R = XMVector3Reflect(lightDirection, normal);
+	float spec = Specular(R, V, roughness) * specTex;
+	spec *= diffuse != 0.0f ? 1.0f : 0.0f;
+
+	XMVECTOR l = surfaceColor * (finalColor + XMVectorReplicate(spec));
+	return l * Attenuate(light, worldPos);
+}
+
+//Calculate Spot Lighting
+XMVECTOR SoftwareShading::CalculateSpotLight(const Light& light, FXMVECTOR normal, FXMVECTOR surfaceColor, FXMVECTOR ambient, GXMVECTOR cameraPos, HXMVECTOR worldPos, float roughness, float specTex) {
+	return CalculatePointLight(light, normal, surfaceColor, ambient, cameraPos, worldPos, roughness, specTex) * SpotTerm(light, worldPos);
+}
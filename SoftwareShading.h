@@ -0,0 +1,33 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include "Lights.h"
+
+// Must match the values in ShaderIncludes.hlsli
+#define SOFTWARE_MAX_SPECULAR_EXPONENT 256.0f
+#define SOFTWARE_F0_NON_METAL 0.04f
+#define SOFTWARE_MIN_ROUGHNESS 0.0000001f
+
+// --------------------------------------------------------
+// C++ versions of the lighting functions in
+// ShaderIncludes.hlsli, for the software rasterizer
+//
+// - Each one follows its HLSL counterpart line for line,
+//    quirks included, so CPU and GPU images can be diffed
+// - Changes to the HLSL versions need to be made here too
+// --------------------------------------------------------
+namespace SoftwareShading {
+	float Diffuse(DirectX::FXMVECTOR normal, DirectX::FXMVECTOR dirToLight);
+	float Specular(DirectX::FXMVECTOR R, DirectX::FXMVECTOR V, float roughness);
+	float Attenuate(const Light& light, DirectX::FXMVECTOR worldPos);
+	float D_GGX(DirectX::FXMVECTOR n, DirectX::FXMVECTOR h, float roughness);
+	DirectX::XMVECTOR F_Schlick(DirectX::FXMVECTOR v, DirectX::FXMVECTOR h, DirectX::FXMVECTOR f0);
+	float G_SchlickGGX(DirectX::FXMVECTOR n, DirectX::FXMVECTOR v, float roughness);
+	DirectX::XMVECTOR MicrofacetBRDF(DirectX::FXMVECTOR n, DirectX::FXMVECTOR l, DirectX::FXMVECTOR v, float roughness, DirectX::XMVECTOR* F_out);
+	float SpotTerm(const Light& light, DirectX::FXMVECTOR worldPos);
+
+	DirectX::XMVECTOR CalculateDirectionalLight(const Light& light, DirectX::FXMVECTOR normal, DirectX::FXMVECTOR surfaceColor, DirectX::FXMVECTOR cameraPos, DirectX::GXMVECTOR worldPos, float roughness, float metalness);
+	DirectX::XMVECTOR CalculatePointLight(const Light& light, DirectX::FXMVECTOR normal, DirectX::FXMVECTOR surfaceColor, DirectX::FXMVECTOR ambient, DirectX::GXMVECTOR cameraPos, DirectX::HXMVECTOR worldPos, float roughness, float specTex);
+	DirectX::XMVECTOR CalculateSpotLight(const Light& light, DirectX::FXMVECTOR normal, DirectX::FXMVECTOR surfaceColor, DirectX::FXMVECTOR ambient, DirectX::GXMVECTOR cameraPos, DirectX::HXMVECTOR worldPos, float roughness, float specTex);
+}
@@ -0,0 +1,369 @@
+#include "TraceReplayer.h"
+#include "RecordingRenderDevice.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+
+using namespace CommandTrace;
+
+namespace {
+	//Reads values out of a payload, failing once it runs dry
+	struct PayloadReader {
+		const uint8_t* Data;
+		uint32_t Size;
+		uint32_t Offset;
+
+		template<typename T>
+		bool Read(T& value) {
+			if (Size - Offset < sizeof(T)) return false;
+			memcpy(&value, Data + Offset, sizeof(T));
+			Offset += sizeof(T);
+			return true;
+		}
+
+		const uint8_t* Take(uint32_t count) {
+			if (Size - Offset < count) return 0;
+			const uint8_t* taken = Data + Offset;
+			Offset += count;
+			return taken;
+		}
+	};
+
+	//Reads the parts every creation record shares
+	// - Data is null when the resource had no initial data
+	template<typename Desc>
+	bool ReadCreation(PayloadReader& reader, uint32_t& id, Desc& desc, const uint8_t*& data, uint32_t& dataSize) {
+		uint32_t descSize;
+		if (!reader.Read(id) || !reader.Read(descSize) || descSize != sizeof(Desc)) return false;
+		if (!reader.Read(desc) || !reader.Read(dataSize)) return false;
+
+		data = reader.Take(dataSize);
+		if (!data) return false;
+		if (dataSize == 0) data = 0;
+		return true;
+	}
+}
+
+bool TraceReplayer::Load(const std::wstring& path) {
+	std::ifstream file;
+	OpenFile(file, path);
+	if (!file.is_open()) {
+		trace.clear();
+		error = "Couldn't open the trace";
+		return false;
+	}
+
+	std::vector<uint8_t> bytes;
+	file.seekg(0, std::ios::end);
+	bytes.resize((size_t)file.tellg());
+	file.seekg(0);
+	file.read((char*)bytes.data(), bytes.size());
+
+	return Load(std::move(bytes));
+}
+
+bool TraceReplayer::Load(std::vector<uint8_t> bytes) {
+	trace = std::move(bytes);
+	error.clear();
+
+	uint32_t header[2] = {};
+	if (trace.size() >= sizeof(header)) memcpy(header, trace.data(), sizeof(header));
+
+	if (header[0] != COMMAND_TRACE_MAGIC) error = "Not a command trace";
+	else if (header[1] != COMMAND_TRACE_VERSION) error = "Trace is from a different version";
+
+	if (!error.empty()) {
+		trace.clear();
+		return false;
+	}
+
+	return true;
+}
+
+bool TraceReplayer::IsLoaded() {
+	return !trace.empty();
+}
+
+size_t TraceReplayer::GetSize() {
+	return trace.size();
+}
+
+const std::string& TraceReplayer::GetError() {
+	return error;
+}
+
+template<typename T>
+T TraceReplayer::Find(const std::unordered_map<uint32_t, T>& handles, uint32_t id, TraceReplayStats& stats) {
+	//Id 0 is an unbind, which needs no mapping
+	if (id == 0) return T();
+
+	auto found = handles.find(id);
+	if (found != handles.end()) return found->second;
+
+	stats.UnresolvedHandles++;
+	return T();
+}
+
+// --------------------------------------------------------
+// Replays every record, timing each frame from one
+// FrameBegin to the next
+// --------------------------------------------------------
+TraceReplayStats TraceReplayer::Replay(RenderDevice& device) {
+	TraceReplayStats stats;
+	error.clear();
+	if (trace.empty()) {
+		error = "No trace loaded";
+		return stats;
+	}
+
+	//Whatever was bound before isn't known to the trace
+	device.InvalidateState();
+
+	auto start = std::chrono::high_resolution_clock::now();
+	auto frameStart = start;
+	bool inFrame = false;
+
+	//Adds the frame that just finished to the totals
+	auto endFrame = [&](const RenderDeviceStats& frame, std::chrono::high_resolution_clock::time_point now) {
+		float milliseconds = std::chrono::duration<float, std::milli>(now - frameStart).count();
+		stats.MaxFrameMilliseconds = (std::max)(stats.MaxFrameMilliseconds, milliseconds);
+		stats.DeviceTotals.DrawCalls += frame.DrawCalls;
+		stats.DeviceTotals.Primitives += frame.Primitives;
+		stats.DeviceTotals.StateChanges += frame.StateChanges;
+		stats.DeviceTotals.RedundantStateChanges += frame.RedundantStateChanges;
+		stats.DeviceTotals.BufferUpdates += frame.BufferUpdates;
+		stats.DeviceTotals.BytesUploaded += frame.BytesUploaded;
+	};
+
+	size_t offset = 2 * sizeof(uint32_t);
+	while (offset < trace.size()) {
+		if (trace.size() - offset < RecordHeaderSize) {
+			error = "Trace ends partway through a record";
+			break;
+		}
+
+		RecordType type = (RecordType)trace[offset];
+		uint32_t size;
+		memcpy(&size, &trace[offset + 1], sizeof(size));
+		offset += RecordHeaderSize;
+
+		if (trace.size() - offset < size || type >= RecordType::Count) {
+			error = "Trace has a damaged record";
+			break;
+		}
+
+		if (type == RecordType::FrameBegin) {
+			auto now = std::chrono::high_resolution_clock::now();
+			device.BeginFrame();
+			if (inFrame) endFrame(device.GetLastFrameStats(), now);
+
+			frameStart = now;
+			inFrame = true;
+			stats.Frames++;
+		}
+		else if (!ReplayRecord(device, type, &trace[offset], size, stats)) {
+			error = std::string("Couldn't read a ") + GetRecordName(type) + " record";
+			break;
+		}
+
+		offset += size;
+		stats.Records++;
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	if (inFrame) endFrame(device.GetStats(), end);
+
+	stats.TotalMilliseconds = std::chrono::duration<float, std::milli>(end - start).count();
+	stats.AverageFrameMilliseconds = stats.Frames ? stats.TotalMilliseconds / stats.Frames : 0.0f;
+	stats.Completed = error.empty();
+
+	ReleaseAll(device);
+	device.InvalidateState();
+	return stats;
+}
+
+bool TraceReplayer::ReplayRecord(RenderDevice& device, RecordType type, const uint8_t* payload, uint32_t size, TraceReplayStats& stats) {
+	PayloadReader reader = { payload, size, 0 };
+	uint32_t id;
+	const uint8_t* data;
+	uint32_t dataSize;
+
+	switch (type) {
+	case RecordType::CreateBuffer: {
+		BufferDesc desc;
+		if (!ReadCreation(reader, id, desc, data, dataSize)) return false;
+		buffers[id] = device.CreateBuffer(desc, data);
+		stats.ResourcesCreated++;
+		return true;
+	}
+	case RecordType::CreateTexture: {
+		TextureRecordDesc desc;
+		if (!ReadCreation(reader, id, desc, data, dataSize)) return false;
+		textures[id] = device.CreateTexture(desc.Desc, data, desc.RowPitch);
+		stats.ResourcesCreated++;
+		return true;
+	}
+	case RecordType::CreateShader: {
+		ShaderStage stage;
+		if (!ReadCreation(reader, id, stage, data, dataSize)) return false;
+		shaders[id] = device.CreateShader(stage, data, dataSize);
+		stats.ResourcesCreated++;
+		return true;
+	}
+	case RecordType::CreateSampler: {
+		SamplerDesc desc;
+		if (!ReadCreation(reader, id, desc, data, dataSize)) return false;
+		samplers[id] = device.CreateSampler(desc);
+		stats.ResourcesCreated++;
+		return true;
+	}
+	case RecordType::CreateRasterizerState: {
+		RasterizerDesc desc;
+		if (!ReadCreation(reader, id, desc, data, dataSize)) return false;
+		rasterizerStates[id] = device.CreateRasterizerState(desc);
+		stats.ResourcesCreated++;
+		return true;
+	}
+	case RecordType::CreateDepthStencilState: {
+		DepthStencilDesc desc;
+		if (!ReadCreation(reader, id, desc, data, dataSize)) return false;
+		depthStencilStates[id] = device.CreateDepthStencilState(desc);
+		stats.ResourcesCreated++;
+		return true;
+	}
+	case RecordType::DestroyBuffer: {
+		if (!reader.Read(id)) return false;
+		device.DestroyBuffer(Find(buffers, id, stats));
+		buffers.erase(id);
+		return true;
+	}
+	case RecordType::DestroyTexture: {
+		if (!reader.Read(id)) return false;
+		device.DestroyTexture(Find(textures, id, stats));
+		textures.erase(id);
+		return true;
+	}
+	case RecordType::Command: {
+		RenderCommand command;
+		if (!reader.Read(command)) return false;
+		stats.Commands++;
+
+		switch (command.Type) {
+		case RenderCommandType::SetVertexBuffer: device.SetVertexBuffer(Find(buffers, command.Handle, stats), command.Count); break;
+		case RenderCommandType::SetIndexBuffer: device.SetIndexBuffer(Find(buffers, command.Handle, stats)); break;
+		case RenderCommandType::SetConstantBuffer: device.SetConstantBuffer(command.Stage, command.Slot, Find(buffers, command.Handle, stats)); break;
+		case RenderCommandType::SetShader: device.SetShader(command.Stage, Find(shaders, command.Handle, stats)); break;
+		case RenderCommandType::SetTexture: device.SetTexture(command.Stage, command.Slot, Find(textures, command.Handle, stats)); break;
+		case RenderCommandType::SetSampler: device.SetSampler(command.Stage, command.Slot, Find(samplers, command.Handle, stats)); break;
+		case RenderCommandType::SetRasterizerState: device.SetRasterizerState(Find(rasterizerStates, command.Handle, stats)); break;
+		case RenderCommandType::SetDepthStencilState: device.SetDepthStencilState(Find(depthStencilStates, command.Handle, stats)); break;
+		case RenderCommandType::SetTopology: device.SetTopology((PrimitiveTopology)command.Handle); break;
+		case RenderCommandType::Draw: device.Draw(command.Count, command.Start); break;
+		case RenderCommandType::DrawIndexed: device.DrawIndexed(command.Count, command.Start, command.BaseVertex); break;
+		case RenderCommandType::UpdateBuffer: {
+			data = reader.Take(command.Count);
+			if (!data) return false;
+			device.UpdateBuffer(Find(buffers, command.Handle, stats), data, command.Count);
+			break;
+		}
+		default:
+			return false;
+		}
+		return true;
+	}
+	case RecordType::InvalidateState:
+		device.InvalidateState();
+		return true;
+	case RecordType::SimpleShader: {
+		uint32_t stage, bytecodeSize, bufferCount;
+		if (!reader.Read(id) || !reader.Read(stage) || !reader.Read(bytecodeSize)) return false;
+
+		const uint8_t* bytecode = reader.Take(bytecodeSize);
+		if (!bytecode || !reader.Read(bufferCount)) return false;
+
+		ReplayShader& shader = simpleShaders[id];
+		shader.Stage = (ShaderStage)stage;
+		shader.Shader = device.CreateShader(shader.Stage, bytecode, bytecodeSize);
+		stats.ResourcesCreated++;
+
+		//A dynamic buffer stands in for each constant buffer
+		for (uint32_t i = 0; i < bufferCount; i++) {
+			uint32_t layout[2];
+			if (!reader.Read(layout)) return false;
+
+			BufferDesc desc = {};
+			desc.Type = BufferType::Constant;
+			desc.Usage = BufferUsage::Dynamic;
+			desc.ByteWidth = layout[0];
+
+			shader.Buffers.push_back(device.CreateBuffer(desc, 0));
+			shader.Slots.push_back(layout[1]);
+			shader.Contents.push_back(std::vector<uint8_t>(layout[0], 0));
+			stats.ResourcesCreated++;
+		}
+		return true;
+	}
+	case RecordType::SetSimpleShader: {
+		if (!reader.Read(id)) return false;
+
+		auto found = simpleShaders.find(id);
+		if (found == simpleShaders.end()) {
+			stats.UnresolvedHandles++;
+			return true;
+		}
+
+		//SimpleShader binds its buffers along with the shader
+		ReplayShader& shader = found->second;
+		device.SetShader(shader.Stage, shader.Shader);
+		for (size_t i = 0; i < shader.Buffers.size(); i++) {
+			device.SetConstantBuffer(shader.Stage, shader.Slots[i], shader.Buffers[i]);
+		}
+		return true;
+	}
+	case RecordType::CopySimpleBuffer: {
+		uint32_t index;
+		if (!reader.Read(id) || !reader.Read(index)) return false;
+		uint32_t encodingOffset = reader.Offset;
+
+		auto found = simpleShaders.find(id);
+		if (found == simpleShaders.end() || index >= found->second.Buffers.size()) {
+			stats.UnresolvedHandles++;
+			return true;
+		}
+
+		//The device's buffer can't change size, so neither can the copies
+		std::vector<uint8_t>& contents = found->second.Contents[index];
+		size_t bufferSize = contents.size();
+		if (!DecodeBufferCopy(payload + encodingOffset, size - encodingOffset, contents) || contents.size() != bufferSize) return false;
+
+		device.UpdateBuffer(found->second.Buffers[index], contents.data(), (unsigned int)contents.size());
+		stats.BufferCopies++;
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+// --------------------------------------------------------
+// Destroys what the replay created
+//  - The device can only destroy buffers and textures, so
+//     other resources live as long as the device does
+// --------------------------------------------------------
+void TraceReplayer::ReleaseAll(RenderDevice& device) {
+	for (auto& buffer : buffers) device.DestroyBuffer(buffer.second);
+	for (auto& texture : textures) device.DestroyTexture(texture.second);
+	for (auto& shader : simpleShaders) {
+		for (BufferHandle buffer : shader.second.Buffers) device.DestroyBuffer(buffer);
+	}
+
+	buffers.clear();
+	textures.clear();
+	shaders.clear();
+	samplers.clear();
+	rasterizerStates.clear();
+	depthStencilStates.clear();
+	simpleShaders.clear();
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "CommandTrace.h"
+#include "RenderDevice.h"
+
+// --------------------------------------------------------
+// What one replay of a trace did, and how long it took
+// --------------------------------------------------------
+struct TraceReplayStats {
+	bool Completed = false;
+	unsigned int Frames = 0;
+	unsigned int Records = 0;
+	unsigned int ResourcesCreated = 0;
+	unsigned int Commands = 0;
+	unsigned int BufferCopies = 0;
+	unsigned int UnresolvedHandles = 0;	// Ids the trace never created
+	float TotalMilliseconds = 0.0f;
+	float AverageFrameMilliseconds = 0.0f;
+	float MaxFrameMilliseconds = 0.0f;
+	RenderDeviceStats DeviceTotals;		// Summed over every frame
+};
+
+// --------------------------------------------------------
+// Plays a command trace back against any render device
+//
+// - Against a null RecordingRenderDevice it measures the
+//    CPU cost of the stream and its counts, with no GPU
+// - Against a D3D11RenderDevice it re-submits the frames
+//    for real, though into whatever targets are bound
+// - Every resource the trace creates is created on the
+//    device, and destroyed again when the replay ends, so
+//    a trace can be replayed as many times as needed
+// - SimpleShaders become device shaders, with a dynamic
+//    buffer per constant buffer that the copies update
+// - Only Load() touches the disk, so traces built in memory
+//    replay the same way
+// --------------------------------------------------------
+class TraceReplayer {
+private:
+	//A SimpleShader from the trace, as replayed on the device
+	struct ReplayShader {
+		ShaderHandle Shader;
+		ShaderStage Stage;
+		std::vector<BufferHandle> Buffers;
+		std::vector<uint32_t> Slots;
+		std::vector<std::vector<uint8_t>> Contents;
+	};
+
+	std::vector<uint8_t> trace;
+	std::string error;
+
+	//Trace Ids to this replay's handles
+	std::unordered_map<uint32_t, BufferHandle> buffers;
+	std::unordered_map<uint32_t, TextureHandle> textures;
+	std::unordered_map<uint32_t, ShaderHandle> shaders;
+	std::unordered_map<uint32_t, SamplerHandle> samplers;
+	std::unordered_map<uint32_t, RasterizerHandle> rasterizerStates;
+	std::unordered_map<uint32_t, DepthStencilHandle> depthStencilStates;
+	std::unordered_map<uint32_t, ReplayShader> simpleShaders;
+
+	template<typename T>
+	T Find(const std::unordered_map<uint32_t, T>& handles, uint32_t id, TraceReplayStats& stats);
+
+	bool ReplayRecord(RenderDevice& device, CommandTrace::RecordType type, const uint8_t* payload, uint32_t size, TraceReplayStats& stats);
+	void ReleaseAll(RenderDevice& device);
+
+public:
+	//Reads a whole trace into memory, and checks its header
+	bool Load(const std::wstring& path);
+
+	//Takes a trace that's already in memory, like one a test
+	//built, and checks its header
+	bool Load(std::vector<uint8_t> bytes);
+	bool IsLoaded();
+	size_t GetSize();
+
+	//Why the last load or replay failed
+	const std::string& GetError();
+
+	TraceReplayStats Replay(RenderDevice& device);
+};
@@ -0,0 +1,132 @@
+#include "TraceWriter.h"
+#include "CommandTrace.h"
+
+#include <algorithm>
+
+TraceWriter::TraceWriter() :
+	open(false),
+	stopping(false),
+	bytesQueued(0),
+	bytesWritten(0),
+	peakQueuedBlocks(0),
+	failed(false) {
+}
+
+TraceWriter::~TraceWriter() {
+	Close();
+}
+
+bool TraceWriter::Open(const std::wstring& path) {
+	Close();
+
+	CommandTrace::OpenFile(file, path);
+	if (!file.is_open()) return false;
+
+	open = true;
+	stopping = false;
+	failed = false;
+	bytesQueued = 0;
+	bytesWritten = 0;
+	peakQueuedBlocks = 0;
+	current.clear();
+	current.reserve(TRACE_WRITER_BLOCK_SIZE);
+
+	thread = std::thread(&TraceWriter::WriterLoop, this);
+	return true;
+}
+
+void TraceWriter::Close() {
+	if (!open) return;
+
+	Flush();
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	blockQueued.notify_one();
+	thread.join();
+
+	file.close();
+	open = false;
+}
+
+bool TraceWriter::IsOpen() {
+	return open;
+}
+
+void TraceWriter::Write(const void* data, size_t size) {
+	if (!open) return;
+
+	const uint8_t* bytes = (const uint8_t*)data;
+	current.insert(current.end(), bytes, bytes + size);
+	bytesQueued += size;
+
+	if (current.size() >= TRACE_WRITER_BLOCK_SIZE) Flush();
+}
+
+void TraceWriter::Flush() {
+	if (!open || current.empty()) return;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queue.push_back(std::move(current));
+		peakQueuedBlocks = (std::max)(peakQueuedBlocks, queue.size());
+
+		//Reuse a written block if there is one
+		if (!freeBlocks.empty()) {
+			current = std::move(freeBlocks.back());
+			freeBlocks.pop_back();
+		}
+		else {
+			current = std::vector<uint8_t>();
+			current.reserve(TRACE_WRITER_BLOCK_SIZE);
+		}
+	}
+	current.clear();
+
+	blockQueued.notify_one();
+}
+
+// --------------------------------------------------------
+// Writes queued blocks until closed, and the queue is empty
+// --------------------------------------------------------
+void TraceWriter::WriterLoop() {
+	std::vector<uint8_t> block;
+
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			blockQueued.wait(lock, [this]() { return stopping || !queue.empty(); });
+			if (queue.empty()) return;
+
+			block = std::move(queue.front());
+			queue.pop_front();
+		}
+
+		file.write((const char*)block.data(), block.size());
+		if (!file.good()) failed = true;
+		bytesWritten += block.size();
+
+		block.clear();
+		std::lock_guard<std::mutex> lock(mutex);
+		freeBlocks.push_back(std::move(block));
+		block = std::vector<uint8_t>();
+	}
+}
+
+uint64_t TraceWriter::GetBytesQueued() {
+	return bytesQueued;
+}
+
+uint64_t TraceWriter::GetBytesWritten() {
+	return bytesWritten;
+}
+
+size_t TraceWriter::GetPeakQueuedBlocks() {
+	return peakQueuedBlocks;
+}
+
+bool TraceWriter::HasFailed() {
+	return failed;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Bytes gathered before a block is handed to the writer thread
+#define TRACE_WRITER_BLOCK_SIZE (1 << 20)
+
+// --------------------------------------------------------
+// Streams bytes to a file from a background thread
+//
+// - Writes are appended to the current block, and full
+//    blocks are queued for the writer thread, so the
+//    caller never waits on the disk
+// - Written blocks go back on a free list, so a steady
+//    stream stops allocating once it's warmed up
+// - Only one thread may call Write() at a time
+// --------------------------------------------------------
+class TraceWriter {
+private:
+	std::ofstream file;
+	std::thread thread;
+	bool open;
+
+	//Blocks waiting on the writer thread, and spares
+	std::mutex mutex;
+	std::condition_variable blockQueued;
+	std::deque<std::vector<uint8_t>> queue;
+	std::vector<std::vector<uint8_t>> freeBlocks;
+	bool stopping;
+
+	//Block being filled by the caller
+	std::vector<uint8_t> current;
+
+	//Stats
+	uint64_t bytesQueued;
+	std::atomic<uint64_t> bytesWritten;
+	size_t peakQueuedBlocks;
+	std::atomic<bool> failed;
+
+	void WriterLoop();
+
+public:
+	TraceWriter();
+	~TraceWriter();
+
+	//Starts a new file and the thread that writes it
+	bool Open(const std::wstring& path);
+
+	//Writes whatever is left, then stops the thread
+	void Close();
+	bool IsOpen();
+
+	void Write(const void* data, size_t size);
+
+	//Hands the current block to the writer thread early
+	void Flush();
+
+	uint64_t GetBytesQueued();
+	uint64_t GetBytesWritten();
+	size_t GetPeakQueuedBlocks();
+
+	//Whether the disk refused a write since opening
+	bool HasFailed();
+};
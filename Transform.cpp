@@ -1,35 +1,82 @@
 #include "Transform.h"
+#include "RotationMath.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+std::atomic<unsigned int> Transform::staticChangeCount(0);
+
+// --------------------------------------------------------
+// Gets the pool transforms are created from
+// --------------------------------------------------------
+ObjectPool<Transform>& Transform::GetPool() {
+	static ObjectPool<Transform> pool(MemoryTag::Transforms);
+	return pool;
+}
+
 // --------------------------------------------------------
 // Updates the world and world inverse transpose matrices
 // --------------------------------------------------------
 void Transform::UpdateMatrices() {
-    //Create matrices for translation, scale, and rotation
-    DirectX::XMMATRIX translation = DirectX::XMMatrixTranslationFromVector(DirectX::XMLoadFloat3(&position));
+    CalculateMatrices(
+        DirectX::XMLoadFloat3(&position),
+        DirectX::XMLoadFloat4(&rotation),
+        DirectX::XMLoadFloat3(&scale),
+        world,
+        worldInverseTranspose);
+}
 
-    DirectX::XMMATRIX rotation = DirectX::XMMatrixRotationRollPitchYawFromVector(DirectX::XMLoadFloat3(&this->rotation));
-        
-    DirectX::XMMATRIX scale = DirectX::XMMatrixScalingFromVector(DirectX::XMLoadFloat3(&this->scale));
+// --------------------------------------------------------
+// Points right, up and forward along the rotation
+//  - They're the rotation matrix's rows, which is cheaper
+//     than rotating each axis by the quaternion
+// --------------------------------------------------------
+void Transform::UpdateBasis() {
+    RotationMath::ToBasis(&rotation.x, &right.x, &up.x, &forward.x);
+}
+
+// --------------------------------------------------------
+// Builds a world matrix and its inverse transpose from a
+// position, rotation quaternion and scale
+// --------------------------------------------------------
+void Transform::CalculateMatrices(
+    DirectX::FXMVECTOR position,
+    DirectX::FXMVECTOR rotation,
+    DirectX::FXMVECTOR scale,
+    DirectX::XMFLOAT4X4& world,
+    DirectX::XMFLOAT4X4& worldInverseTranspose) {
+    //Create matrices for translation, scale, and rotation
+    DirectX::XMMATRIX translationMatrix = DirectX::XMMatrixTranslationFromVector(position);
+    DirectX::XMMATRIX rotationMatrix = DirectX::XMMatrixRotationQuaternion(rotation);
+    DirectX::XMMATRIX scaleMatrix = DirectX::XMMatrixScalingFromVector(scale);
 
     //Apply the transformation matrices
-    DirectX::XMMATRIX world = scale * rotation * translation;
+    DirectX::XMMATRIX worldMatrix = scaleMatrix * rotationMatrix * translationMatrix;
 
     //Sore the final matrix and its inverse transpose as a 4x4 float
-    DirectX::XMStoreFloat4x4(&this->world, world);
-    DirectX::XMStoreFloat4x4(&this->worldInverseTranspose,
-        DirectX::XMMatrixInverse(0, DirectX::XMMatrixTranspose(world)));
+    DirectX::XMStoreFloat4x4(&world, worldMatrix);
+    DirectX::XMStoreFloat4x4(&worldInverseTranspose,
+        DirectX::XMMatrixInverse(0, DirectX::XMMatrixTranspose(worldMatrix)));
 }
 
 Transform::Transform() {
     position = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
     scale = DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f);
-    rotation = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+    rotation = DirectX::XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
 
     right = DirectX::XMFLOAT3(1.0f, 0.0f, 0.0f);
     up = DirectX::XMFLOAT3(0.0f, 1.0f, 0.0f);
     forward = DirectX::XMFLOAT3(0.0f, 0.0f, 1.0f);
 
+    isStatic = false;
+
     DirectX::XMStoreFloat4x4(&world, DirectX::XMMatrixIdentity());
     DirectX::XMStoreFloat4x4(&worldInverseTranspose, DirectX::XMMatrixIdentity());
+
+    SavePreviousState();
+    Interpolate(1.0f);
 }
 
 Transform::~Transform() {
@@ -40,6 +87,8 @@ Transform::~Transform() {
 // --------------------------------------------------------
 void Transform::SetPosition(float x, float y, float z) {
     position = DirectX::XMFLOAT3(x, y, z);
+    previousPosition = position;
+    Changed();
 }
 
 // --------------------------------------------------------
@@ -47,20 +96,34 @@ void Transform::SetPosition(float x, float y, float z) {
 // --------------------------------------------------------
 void Transform::SetPosition(DirectX::XMFLOAT3 position) {
     this->position = DirectX::XMFLOAT3(position);
+    previousPosition = this->position;
+    Changed();
 }
 
 // -----------------------------------------------------------------
 // Sets the rotation using the provided pitch, yaw, and roll params
 // -----------------------------------------------------------------
 void Transform::SetRotation(float pitch, float yaw, float roll) {
-    rotation = DirectX::XMFLOAT3(pitch, yaw, roll);
+    DirectX::XMFLOAT4 quaternion;
+    DirectX::XMStoreFloat4(&quaternion, DirectX::XMQuaternionRotationRollPitchYaw(pitch, yaw, roll));
+    SetRotation(quaternion);
 }
 
 // --------------------------------------------------------
-// Sets the rotation using the provided rotation
+// Sets the rotation using the provided pitch, yaw and roll
 // --------------------------------------------------------
 void Transform::SetRotation(DirectX::XMFLOAT3 rotation) {
-    this->rotation = DirectX::XMFLOAT3(rotation);
+    SetRotation(rotation.x, rotation.y, rotation.z);
+}
+
+// --------------------------------------------------------
+// Sets the rotation using the provided quaternion
+// --------------------------------------------------------
+void Transform::SetRotation(DirectX::XMFLOAT4 quaternion) {
+    DirectX::XMStoreFloat4(&rotation, DirectX::XMQuaternionNormalize(DirectX::XMLoadFloat4(&quaternion)));
+    previousRotation = rotation;
+    UpdateBasis();
+    Changed();
 }
 
 // --------------------------------------------------------
@@ -68,6 +131,8 @@ void Transform::SetRotation(DirectX::XMFLOAT3 rotation) {
 // --------------------------------------------------------
 void Transform::SetScale(float x, float y, float z) {
     scale = DirectX::XMFLOAT3(x, y, z);
+    previousScale = scale;
+    Changed();
 }
 
 // --------------------------------------------------------
@@ -75,6 +140,8 @@ void Transform::SetScale(float x, float y, float z) {
 // --------------------------------------------------------
 void Transform::SetScale(DirectX::XMFLOAT3 scale) {
     this->scale = DirectX::XMFLOAT3(scale);
+    previousScale = this->scale;
+    Changed();
 }
 
 // --------------------------------------------------------
@@ -85,12 +152,38 @@ DirectX::XMFLOAT3 Transform::GetPosition() {
 }
 
 // --------------------------------------------------------
-// Gets the rotation
+// Gets the rotation as a quaternion
 // --------------------------------------------------------
-DirectX::XMFLOAT3 Transform::GetPitchYawRoll() {
+DirectX::XMFLOAT4 Transform::GetRotation() {
     return rotation;
 }
 
+// --------------------------------------------------------
+// Works out pitch, yaw and roll angles for the rotation
+//  - The matrix is roll, then pitch, then yaw, so pitch
+//     comes straight out of the forward row's height
+//  - Looking straight up or down leaves roll and yaw on
+//     the same axis, so it all goes to yaw
+//  - Angles that have gone past a half turn come back
+//     wrapped, so these are for showing, not accumulating
+// --------------------------------------------------------
+DirectX::XMFLOAT3 Transform::GetPitchYawRoll() {
+    DirectX::XMFLOAT4X4 matrix;
+    DirectX::XMStoreFloat4x4(&matrix, DirectX::XMMatrixRotationQuaternion(DirectX::XMLoadFloat4(&rotation)));
+
+    float sinPitch = (std::max)(-1.0f, (std::min)(1.0f, -matrix._32));
+    float pitch = std::asin(sinPitch);
+
+    if (std::fabs(sinPitch) > 0.9999f) {
+        return DirectX::XMFLOAT3(pitch, std::atan2(-matrix._13, matrix._11), 0.0f);
+    }
+
+    return DirectX::XMFLOAT3(
+        pitch,
+        std::atan2(matrix._31, matrix._33),
+        std::atan2(matrix._12, matrix._22));
+}
+
 // --------------------------------------------------------
 // Gets the scale
 // --------------------------------------------------------
@@ -126,6 +219,29 @@ DirectX::XMFLOAT3 Transform::GetForward() {
     return forward;
 }
 
+bool Transform::IsStatic() {
+    return isStatic;
+}
+
+void Transform::SetStatic(bool isStatic) {
+    this->isStatic = isStatic;
+}
+
+unsigned int Transform::GetStaticChangeCount() {
+    return staticChangeCount;
+}
+
+// --------------------------------------------------------
+// Counts a change to a static transform
+//  - Only static ones touch the shared counter, so moving
+//     everything else costs nothing extra
+// --------------------------------------------------------
+void Transform::Changed() {
+    if (isStatic) {
+        staticChangeCount++;
+    }
+}
+
 // -------------------------------------------------------------
 // Translates the position with the provided x, y, and z params
 // -------------------------------------------------------------
@@ -144,16 +260,20 @@ void Transform::MoveAbsolute(DirectX::XMFLOAT3 offset) {
             DirectX::XMLoadFloat3(&offset)
         )
     );
+    Changed();
 }
 
+// --------------------------------------------------------
+// Translates along right, up and forward
+// --------------------------------------------------------
 void Transform::MoveRelative(float x, float y, float z) {
-    DirectX::XMFLOAT3 input(x, y, z);
-    DirectX::XMVECTOR direction = DirectX::XMLoadFloat3(&input);
-    DirectX::XMVECTOR quaternion = DirectX::XMQuaternionRotationRollPitchYaw(rotation.x, rotation.y, rotation.z);
-    DirectX::XMVECTOR rotated = DirectX::XMVector3Rotate(direction, quaternion);
+    DirectX::XMVECTOR offset = DirectX::XMVectorScale(DirectX::XMLoadFloat3(&right), x);
+    offset = DirectX::XMVectorMultiplyAdd(DirectX::XMVectorReplicate(y), DirectX::XMLoadFloat3(&up), offset);
+    offset = DirectX::XMVectorMultiplyAdd(DirectX::XMVectorReplicate(z), DirectX::XMLoadFloat3(&forward), offset);
 
     DirectX::XMVECTOR pos = DirectX::XMLoadFloat3(&position);
-    DirectX::XMStoreFloat3(&position, DirectX::XMVectorAdd(pos, rotated));
+    DirectX::XMStoreFloat3(&position, DirectX::XMVectorAdd(pos, offset));
+    Changed();
 }
 
 // --------------------------------------------------------
@@ -164,28 +284,19 @@ void Transform::Rotate(float pitch, float yaw, float roll) {
 }
 
 // --------------------------------------------------------
-// Rotates with the provided rotation
+// Rotates with the provided pitch, yaw and roll
+//  - Pitch and roll turn around the transform's own axes,
+//     and yaw around the world's up, which is what adding
+//     to the Euler angles used to do
+//  - The result is renormalized every time, so thousands
+//     of small turns don't drift away from unit length
+//  - The math is in RotationMath, where it's tested
 // --------------------------------------------------------
 void Transform::Rotate(DirectX::XMFLOAT3 rotation) {
-    //Update the rotation
-    DirectX::XMStoreFloat3(
-        &this->rotation, 
-        DirectX::XMVectorAdd(
-            DirectX::XMLoadFloat3(&this->rotation), 
-            DirectX::XMLoadFloat3(&rotation)
-        )
-    );
-
-    //Update right, up, and forward relative to transform
-    DirectX::XMVECTOR worldRight = DirectX::XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f);
-    DirectX::XMVECTOR worldUp = DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
-    DirectX::XMVECTOR worldForward = DirectX::XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
+    RotationMath::Rotate(&this->rotation.x, rotation.x, rotation.y, rotation.z);
 
-    DirectX::XMVECTOR quaternion = DirectX::XMQuaternionRotationRollPitchYaw(this->rotation.x, this->rotation.y, this->rotation.z);
-
-    DirectX::XMStoreFloat3(&this->right, DirectX::XMVector3Rotate(worldRight, quaternion));
-    DirectX::XMStoreFloat3(&this->up, DirectX::XMVector3Rotate(worldUp, quaternion));
-    DirectX::XMStoreFloat3(&this->forward, DirectX::XMVector3Rotate(worldForward, quaternion));
+    UpdateBasis();
+    Changed();
 }
 
 // --------------------------------------------------------
@@ -206,4 +317,146 @@ void Transform::Scale(DirectX::XMFLOAT3 scale) {
             DirectX::XMLoadFloat3(&scale)
         )
     );
+    Changed();
+}
+
+// --------------------------------------------------------
+// Remembers the current state as the one to interpolate
+// from, before a fixed step moves the transform
+// --------------------------------------------------------
+void Transform::SavePreviousState() {
+    previousPosition = position;
+    previousScale = scale;
+    previousRotation = rotation;
+}
+
+// --------------------------------------------------------
+// Builds the render matrices part way from the previous
+// state to the current one
+//  - Rotations are slerped as quaternions, so angles that
+//    have wrapped around still take the short way
+// --------------------------------------------------------
+void Transform::Interpolate(float alpha) {
+    CalculateMatrices(
+        DirectX::XMVectorLerp(DirectX::XMLoadFloat3(&previousPosition), DirectX::XMLoadFloat3(&position), alpha),
+        DirectX::XMQuaternionSlerp(DirectX::XMLoadFloat4(&previousRotation), DirectX::XMLoadFloat4(&rotation), alpha),
+        DirectX::XMVectorLerp(DirectX::XMLoadFloat3(&previousScale), DirectX::XMLoadFloat3(&scale), alpha),
+        renderWorld,
+        renderWorldInverseTranspose);
+}
+
+DirectX::XMFLOAT4X4 Transform::GetRenderWorldMatrix() {
+    return renderWorld;
+}
+
+DirectX::XMFLOAT4X4 Transform::GetRenderWorldInverseTransposeMatrix() {
+    return renderWorldInverseTranspose;
+}
+
+// --------------------------------------------------------
+// Gets the current state
+// --------------------------------------------------------
+void Transform::GetState(DirectX::XMFLOAT3& position, DirectX::XMFLOAT4& rotation, DirectX::XMFLOAT3& scale) {
+    position = this->position;
+    rotation = this->rotation;
+    scale = this->scale;
+}
+
+// --------------------------------------------------------
+// Gets the state saved before the latest fixed step
+// --------------------------------------------------------
+void Transform::GetPreviousState(DirectX::XMFLOAT3& position, DirectX::XMFLOAT4& rotation, DirectX::XMFLOAT3& scale) {
+    position = previousPosition;
+    rotation = previousRotation;
+    scale = previousScale;
+}
+
+// --------------------------------------------------------
+// Takes render matrices built outside, in place of calling
+// Interpolate()
+// --------------------------------------------------------
+void Transform::SetRenderMatrices(const DirectX::XMFLOAT4X4& world, const DirectX::XMFLOAT4X4& worldInverseTranspose) {
+    renderWorld = world;
+    renderWorldInverseTranspose = worldInverseTranspose;
+}
+
+// --------------------------------------------------------
+// Times a run of mouse sized turns and moves, then checks
+// how well the rotation held up over them
+//  - The Euler version is what Rotate() and MoveRelative()
+//     used to be, converting the angles on every call
+//  - Without roll, adding Euler angles and composing the
+//     quaternion are the same rotation, so their forward
+//     vectors should stay together however long it runs
+// --------------------------------------------------------
+RotationMeasurement Transform::MeasureRotations(unsigned int rotations) {
+    RotationMeasurement measurement;
+    measurement.Rotations = rotations;
+    if (rotations == 0) return measurement;
+
+    //The same turns every run
+    std::vector<DirectX::XMFLOAT3> turns(rotations);
+    for (unsigned int i = 0; i < rotations; i++) {
+        turns[i] = DirectX::XMFLOAT3(0.01f * std::sin(i * 0.37f), 0.02f * std::cos(i * 0.11f), 0.0f);
+    }
+
+    DirectX::XMFLOAT3 step(0.0f, 0.0f, 0.01f);
+
+    //Quaternion, as the camera turns and moves
+    Transform transform;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (unsigned int i = 0; i < rotations; i++) {
+        transform.Rotate(turns[i]);
+        transform.MoveRelative(step.x, step.y, step.z);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    measurement.QuaternionNanoseconds = std::chrono::duration<double, std::nano>(end - start).count() / rotations;
+
+    //Euler angles, converted for the basis and again for the move
+    DirectX::XMFLOAT3 angles(0.0f, 0.0f, 0.0f);
+    DirectX::XMFLOAT3 eulerPosition(0.0f, 0.0f, 0.0f);
+    DirectX::XMFLOAT3 eulerBasis[3];
+    start = std::chrono::high_resolution_clock::now();
+    for (unsigned int i = 0; i < rotations; i++) {
+        DirectX::XMStoreFloat3(&angles, DirectX::XMVectorAdd(DirectX::XMLoadFloat3(&angles), DirectX::XMLoadFloat3(&turns[i])));
+
+        DirectX::XMVECTOR quaternion = DirectX::XMQuaternionRotationRollPitchYawFromVector(DirectX::XMLoadFloat3(&angles));
+        DirectX::XMStoreFloat3(&eulerBasis[0], DirectX::XMVector3Rotate(DirectX::XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f), quaternion));
+        DirectX::XMStoreFloat3(&eulerBasis[1], DirectX::XMVector3Rotate(DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f), quaternion));
+        DirectX::XMStoreFloat3(&eulerBasis[2], DirectX::XMVector3Rotate(DirectX::XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), quaternion));
+
+        DirectX::XMVECTOR moveQuaternion = DirectX::XMQuaternionRotationRollPitchYawFromVector(DirectX::XMLoadFloat3(&angles));
+        DirectX::XMVECTOR moved = DirectX::XMVector3Rotate(DirectX::XMLoadFloat3(&step), moveQuaternion);
+        DirectX::XMStoreFloat3(&eulerPosition, DirectX::XMVectorAdd(DirectX::XMLoadFloat3(&eulerPosition), moved));
+    }
+    end = std::chrono::high_resolution_clock::now();
+    measurement.EulerNanoseconds = std::chrono::duration<double, std::nano>(end - start).count() / rotations;
+
+    //Both ran the same turns, so they should end up looking and standing in the same place
+    measurement.MaxEulerDifference = (std::max)(
+        DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&transform.forward), DirectX::XMLoadFloat3(&eulerBasis[2])))),
+        DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&transform.position), DirectX::XMLoadFloat3(&eulerPosition)))));
+
+    //Check after every turn, with a second transform tumbling through roll as well
+    Transform camera;
+    Transform tumbling;
+    angles = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+    for (unsigned int i = 0; i < rotations; i++) {
+        camera.Rotate(turns[i]);
+        tumbling.Rotate(turns[i].x, turns[i].y, 0.015f * std::sin(i * 0.23f));
+
+        DirectX::XMStoreFloat3(&angles, DirectX::XMVectorAdd(DirectX::XMLoadFloat3(&angles), DirectX::XMLoadFloat3(&turns[i])));
+        DirectX::XMVECTOR eulerForward = DirectX::XMVector3Rotate(
+            DirectX::XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f),
+            DirectX::XMQuaternionRotationRollPitchYawFromVector(DirectX::XMLoadFloat3(&angles)));
+        measurement.MaxEulerDifference = (std::max)(measurement.MaxEulerDifference,
+            DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&camera.forward), eulerForward))));
+
+        float norm = RotationMath::Length(&tumbling.rotation.x);
+        measurement.MaxNormError = (std::max)(measurement.MaxNormError, std::fabs(norm - 1.0f));
+        measurement.MaxBasisError = (std::max)(measurement.MaxBasisError,
+            RotationMath::BasisError(&tumbling.right.x, &tumbling.up.x, &tumbling.forward.x));
+    }
+
+    return measurement;
 }
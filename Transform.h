@@ -1,13 +1,41 @@
 #pragma once
 
+#include <atomic>
 #include <DirectXMath.h>
 
+#include "ObjectPool.h"
+
+// --------------------------------------------------------
+// What Transform::MeasureRotations() found
+// --------------------------------------------------------
+struct RotationMeasurement {
+	unsigned int Rotations = 0;
+	double QuaternionNanoseconds = 0.0;	// Per Rotate() and MoveRelative() pair
+	double EulerNanoseconds = 0.0;		// The same pair done the old way, through Euler angles
+	float MaxNormError = 0.0f;			// How far the quaternion got from unit length
+	float MaxBasisError = 0.0f;			// How far right, up and forward got from orthonormal
+	float MaxEulerDifference = 0.0f;	// Forward against the Euler angles' forward, without roll
+};
+
+// --------------------------------------------------------
+// Position, rotation and scale of something in the world
+//
+// - Rotations are stored as a unit quaternion, and Rotate()
+//    composes onto it, so nothing is converted from Euler
+//    angles per frame
+// - Right, up and forward are kept in step with the
+//    rotation, so moving relative to it is just adding them
+// - Euler angles are still taken by the setters, and given
+//    back by GetPitchYawRoll() for the inspector
+// - Static transforms count every change made to them, so
+//    anything cached from where they were knows to redo it
+// --------------------------------------------------------
 class Transform {
 private:
 	//Fields
 	DirectX::XMFLOAT3 position;
 	DirectX::XMFLOAT3 scale;
-	DirectX::XMFLOAT3 rotation;
+	DirectX::XMFLOAT4 rotation; // Unit quaternion
 	DirectX::XMFLOAT4X4 world;
 	DirectX::XMFLOAT4X4 worldInverseTranspose;
 
@@ -15,25 +43,53 @@ private:
 	DirectX::XMFLOAT3 up;
 	DirectX::XMFLOAT3 forward;
 
+	//State at the start of the latest fixed step
+	DirectX::XMFLOAT3 previousPosition;
+	DirectX::XMFLOAT3 previousScale;
+	DirectX::XMFLOAT4 previousRotation;
+
+	//Matrices blended between the previous and current state
+	DirectX::XMFLOAT4X4 renderWorld;
+	DirectX::XMFLOAT4X4 renderWorldInverseTranspose;
+
+	//Static transforms aren't meant to move, but if one does,
+	//it's counted
+	bool isStatic;
+	static std::atomic<unsigned int> staticChangeCount;
+
 	//Helpers
+	void Changed();
 	void UpdateMatrices();
+	void UpdateBasis();
+	static void CalculateMatrices(
+		DirectX::FXMVECTOR position,
+		DirectX::FXMVECTOR rotation,
+		DirectX::FXMVECTOR scale,
+		DirectX::XMFLOAT4X4& world,
+		DirectX::XMFLOAT4X4& worldInverseTranspose);
 
 public:
 	//Constructor & Destructor
 	Transform();
 	~Transform();
 
+	//Pool every transform should be created from
+	static ObjectPool<Transform>& GetPool();
+
 	//Setters
+	// - These teleport, so the change isn't interpolated
 	void SetPosition(float x, float y, float z);
 	void SetPosition(DirectX::XMFLOAT3 position);
 	void SetRotation(float pitch, float yaw, float roll);
 	void SetRotation(DirectX::XMFLOAT3 rotation);
+	void SetRotation(DirectX::XMFLOAT4 quaternion);
 	void SetScale(float x, float y, float z);
 	void SetScale(DirectX::XMFLOAT3 scale);
 
 	//Getters
 	DirectX::XMFLOAT3 GetPosition();
-	DirectX::XMFLOAT3 GetPitchYawRoll();
+	DirectX::XMFLOAT4 GetRotation();
+	DirectX::XMFLOAT3 GetPitchYawRoll(); // Converts, so meant for the inspector
 	DirectX::XMFLOAT3 GetScale();
 	DirectX::XMFLOAT4X4 GetWorldMatrix();
 	DirectX::XMFLOAT4X4 GetWorldInverseTransposeMatrix();
@@ -42,6 +98,14 @@ public:
 	DirectX::XMFLOAT3 GetUp();
 	DirectX::XMFLOAT3 GetForward();
 
+	//Static
+	bool IsStatic();
+	void SetStatic(bool isStatic);
+
+	//Changes to any static transform so far, for telling when
+	//their cached shadows are stale
+	static unsigned int GetStaticChangeCount();
+
 	//Transformers
 	void MoveAbsolute(float x, float y, float z);
 	void MoveAbsolute(DirectX::XMFLOAT3 offset);
@@ -51,5 +115,25 @@ public:
 	void Scale(float x, float y, float z);
 	void Scale(DirectX::XMFLOAT3 scale);
 
+	//Fixed timestep interpolation
+	// - Save the state before each fixed step changes it, then
+	//    render with the matrices from Interpolate()
+	void SavePreviousState();
+	void Interpolate(float alpha);
+	DirectX::XMFLOAT4X4 GetRenderWorldMatrix();
+	DirectX::XMFLOAT4X4 GetRenderWorldInverseTransposeMatrix();
+
+	//Batched interpolation
+	// - TransformBatch can blend and build the render matrices
+	//    for many transforms at once, from these states, and
+	//    hand the results back
+	void GetState(DirectX::XMFLOAT3& position, DirectX::XMFLOAT4& rotation, DirectX::XMFLOAT3& scale);
+	void GetPreviousState(DirectX::XMFLOAT3& position, DirectX::XMFLOAT4& rotation, DirectX::XMFLOAT3& scale);
+	void SetRenderMatrices(const DirectX::XMFLOAT4X4& world, const DirectX::XMFLOAT4X4& worldInverseTranspose);
+
+	//Times Rotate() and MoveRelative() against the Euler angle
+	// version, and checks how far many small rotations drift
+	static RotationMeasurement MeasureRotations(unsigned int rotations);
+
 };
 
@@ -0,0 +1,169 @@
+#include "TransformBatch.h"
+#include "TransformBatchKernels.h"
+
+#include <cmath>
+
+#if defined(SIMD_LANES_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+void TransformStreams::Resize(size_t count) {
+	for (std::vector<float>* stream : { &PositionX, &PositionY, &PositionZ, &RotationX, &RotationY, &RotationZ, &RotationW, &ScaleX, &ScaleY, &ScaleZ }) {
+		stream->resize(count);
+	}
+}
+
+size_t TransformStreams::GetCount() const {
+	return PositionX.size();
+}
+
+void TransformStreams::Set(size_t index, const float position[3], const float rotation[4], const float scale[3]) {
+	PositionX[index] = position[0];
+	PositionY[index] = position[1];
+	PositionZ[index] = position[2];
+	RotationX[index] = rotation[0];
+	RotationY[index] = rotation[1];
+	RotationZ[index] = rotation[2];
+	RotationW[index] = rotation[3];
+	ScaleX[index] = scale[0];
+	ScaleY[index] = scale[1];
+	ScaleZ[index] = scale[2];
+}
+
+void BoundsStreams::Resize(size_t count) {
+	for (std::vector<float>* stream : { &CenterX, &CenterY, &CenterZ, &ExtentX, &ExtentY, &ExtentZ }) {
+		stream->resize(count);
+	}
+}
+
+size_t BoundsStreams::GetCount() const {
+	return CenterX.size();
+}
+
+void BoundsStreams::Set(size_t index, const float center[3], const float extents[3]) {
+	CenterX[index] = center[0];
+	CenterY[index] = center[1];
+	CenterZ[index] = center[2];
+	ExtentX[index] = extents[0];
+	ExtentY[index] = extents[1];
+	ExtentZ[index] = extents[2];
+}
+
+// --------------------------------------------------------
+// Whether this CPU, and the OS, can run the AVX2 kernels
+//  - They're built allowing FMA as well, so that's needed too
+//  - The OS has to save the wide registers on a thread
+//     switch, which XGETBV reports
+// --------------------------------------------------------
+static bool CpuHasAVX2() {
+#if defined(SIMD_LANES_X86) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) return false;
+
+	__cpuid(info, 1);
+	bool fma = (info[2] & (1 << 12)) != 0;
+	bool osSavesRegisters = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if (!fma || !osSavesRegisters || !avx || (_xgetbv(0) & 0x6) != 0x6) return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#elif defined(SIMD_LANES_X86)
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+	return false;
+#endif
+}
+
+// --------------------------------------------------------
+// Asks the CPU once, the first time anything wants a path
+// --------------------------------------------------------
+static bool HasAVX2() {
+	static const bool hasAVX2 = CpuHasAVX2();
+	return hasAVX2;
+}
+
+static MathPath currentPath = TransformBatch::GetBestPath();
+
+bool TransformBatch::IsPathAvailable(MathPath path) {
+	switch (path) {
+	case MathPath::Scalar: return true;
+#ifdef SIMD_LANES_SSE
+	case MathPath::SSE: return true;
+#endif
+#ifdef SIMD_LANES_X86
+	case MathPath::AVX2: return HasAVX2();
+#endif
+#ifdef SIMD_LANES_NEON
+	case MathPath::NEON: return true;
+#endif
+	default: return false;
+	}
+}
+
+MathPath TransformBatch::GetBestPath() {
+	const MathPath widestFirst[] = { MathPath::AVX2, MathPath::SSE, MathPath::NEON };
+	for (MathPath path : widestFirst) {
+		if (IsPathAvailable(path)) return path;
+	}
+
+	return MathPath::Scalar;
+}
+
+const char* TransformBatch::GetPathName(MathPath path) {
+	switch (path) {
+	case MathPath::Scalar: return "Scalar";
+	case MathPath::SSE: return "SSE";
+	case MathPath::AVX2: return "AVX2";
+	case MathPath::NEON: return "NEON";
+	default: return "Unknown";
+	}
+}
+
+MathPath TransformBatch::GetPath() {
+	return currentPath;
+}
+
+void TransformBatch::SetPath(MathPath path) {
+	if (IsPathAvailable(path)) currentPath = path;
+}
+
+void TransformBatch::Blend(const TransformStreams& previous, const TransformStreams& current, float alpha, TransformStreams& blended, size_t first, size_t count) {
+	size_t end = first + count;
+
+	switch (currentPath) {
+#ifdef SIMD_LANES_SSE
+	case MathPath::SSE: first = BlendGroups<SSELanes>(previous, current, alpha, blended, first, end); break;
+#endif
+#ifdef SIMD_LANES_X86
+	case MathPath::AVX2: first = TransformBatchAVX2::BlendGroups(previous, current, alpha, blended, first, end); break;
+#endif
+#ifdef SIMD_LANES_NEON
+	case MathPath::NEON: first = BlendGroups<NEONLanes>(previous, current, alpha, blended, first, end); break;
+#endif
+	default: break;
+	}
+
+	BlendGroups<ScalarLanes>(previous, current, alpha, blended, first, end);
+}
+
+void TransformBatch::Compute(const TransformBatchInput& input, const TransformBatchOutput& output, size_t first, size_t count) {
+	size_t end = first + count;
+
+	switch (currentPath) {
+#ifdef SIMD_LANES_SSE
+	case MathPath::SSE: first = ComputeGroups<SSELanes>(input, output, first, end); break;
+#endif
+#ifdef SIMD_LANES_X86
+	case MathPath::AVX2: first = TransformBatchAVX2::ComputeGroups(input, output, first, end); break;
+#endif
+#ifdef SIMD_LANES_NEON
+	case MathPath::NEON: first = ComputeGroups<NEONLanes>(input, output, first, end); break;
+#endif
+	default: break;
+	}
+
+	ComputeGroups<ScalarLanes>(input, output, first, end);
+}
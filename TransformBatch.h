@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Transforms per job when a batch is split across threads
+#define TRANSFORM_BATCH_GRAIN 1024
+
+// --------------------------------------------------------
+// Which instructions the batch kernels run with
+//  - SSE is there on every x86 build, AVX2 on x86 CPUs that
+//     have it, and NEON on ARM64
+//  - Scalar runs the same kernel one lane at a time, and is
+//     what the others are checked against
+// --------------------------------------------------------
+enum class MathPath { Scalar, SSE, AVX2, NEON, Count };
+
+// --------------------------------------------------------
+// Positions, rotations and scales, one array per component
+//  - Rotations are unit quaternions
+// --------------------------------------------------------
+struct TransformStreams {
+	std::vector<float> PositionX, PositionY, PositionZ;
+	std::vector<float> RotationX, RotationY, RotationZ, RotationW;
+	std::vector<float> ScaleX, ScaleY, ScaleZ;
+
+	void Resize(size_t count);
+	size_t GetCount() const;
+	void Set(size_t index, const float position[3], const float rotation[4], const float scale[3]);
+};
+
+// --------------------------------------------------------
+// Axis aligned boxes, as a center and half extents
+// --------------------------------------------------------
+struct BoundsStreams {
+	std::vector<float> CenterX, CenterY, CenterZ;
+	std::vector<float> ExtentX, ExtentY, ExtentZ;
+
+	void Resize(size_t count);
+	size_t GetCount() const;
+	void Set(size_t index, const float center[3], const float extents[3]);
+};
+
+struct TransformBatchInput {
+	const TransformStreams* Transforms;
+	const BoundsStreams* LocalBounds;	// Or null, for no bounds
+	const float* View;					// Row major 4x4 the bounds go into, or null for world space
+};
+
+// --------------------------------------------------------
+// Where results go, each optional
+//  - Matrices are row major 4x4s, 16 floats per transform,
+//     the same layout as an XMFLOAT4X4
+// --------------------------------------------------------
+struct TransformBatchOutput {
+	float* World;
+	float* WorldInverseTranspose;
+	BoundsStreams* Bounds;
+};
+
+// --------------------------------------------------------
+// Transform math for many objects per call
+//
+// - Reads structure-of-arrays streams, so each SIMD lane is
+//    a different object and nothing is shuffled to load
+// - Matrices are built straight from the quaternion, and
+//    the inverse transpose uses the rotation being
+//    orthonormal rather than a general inverse
+// - Bounds are transformed with the absolute matrix, like
+//    DirectX::BoundingBox::Transform, optionally on into a
+//    view's space
+// - Doesn't use DirectXMath, so it builds anywhere
+// --------------------------------------------------------
+class TransformBatch {
+public:
+	//Whether this build, on this CPU, can run the path
+	// - The CPU is asked once, the first time it's needed
+	static bool IsPathAvailable(MathPath path);
+
+	//Widest path this CPU runs, which GetPath() starts as
+	static MathPath GetBestPath();
+	static const char* GetPathName(MathPath path);
+
+	//Path every batch call uses
+	// - Unavailable paths are ignored
+	static MathPath GetPath();
+	static void SetPath(MathPath path);
+
+	//Moves each transform part way from previous to current
+	// - Positions and scales lerp, rotations take the short
+	//    way round and are renormalized
+	static void Blend(const TransformStreams& previous, const TransformStreams& current, float alpha, TransformStreams& blended, size_t first, size_t count);
+
+	//Builds the matrices and bounds asked for
+	static void Compute(const TransformBatchInput& input, const TransformBatchOutput& output, size_t first, size_t count);
+};
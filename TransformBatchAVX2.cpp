@@ -0,0 +1,23 @@
+#include "TransformBatchKernels.h"
+
+// --------------------------------------------------------
+// TransformBatch's kernels with AVX2 lanes
+//  - The only TransformBatch file built with AVX2 on
+//     (/arch:AVX2, or -mavx2 -mfma), and only called once
+//     the CPU's been checked
+// --------------------------------------------------------
+#ifdef SIMD_LANES_X86
+
+#ifndef SIMD_LANES_AVX2
+#error TransformBatchAVX2.cpp has to be built with AVX2 on
+#endif
+
+size_t TransformBatchAVX2::BlendGroups(const TransformStreams& previous, const TransformStreams& current, float alpha, TransformStreams& blended, size_t first, size_t end) {
+	return ::BlendGroups<AVX2Lanes>(previous, current, alpha, blended, first, end);
+}
+
+size_t TransformBatchAVX2::ComputeGroups(const TransformBatchInput& input, const TransformBatchOutput& output, size_t first, size_t end) {
+	return ::ComputeGroups<AVX2Lanes>(input, output, first, end);
+}
+
+#endif
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <cstddef>
+
+#include "SimdLanes.h"
+#include "TransformBatch.h"
+
+// --------------------------------------------------------
+// TransformBatch's kernels, shared by TransformBatch.cpp and
+// TransformBatchAVX2.cpp
+//  - Only TransformBatchAVX2.cpp is built with AVX2 on, so
+//     that's where the AVX2 versions are made, and the rest
+//     of the program never runs an AVX2 instruction unless
+//     the CPU has it
+//  - Everything here is static, so each file keeps its own
+// --------------------------------------------------------
+
+// --------------------------------------------------------
+// Writes 16 lanes of matrix elements out as one row major
+// matrix per object
+// --------------------------------------------------------
+template<typename L>
+static void StoreMatrices(const typename L::Type elements[16], float* matrices) {
+	for (int row = 0; row < 4; row++) {
+		L::StoreRows(matrices + row * 4, 16, elements[row * 4], elements[row * 4 + 1], elements[row * 4 + 2], elements[row * 4 + 3]);
+	}
+}
+
+template<typename L>
+static void BlendLanes(const TransformStreams& previous, const TransformStreams& current, float alpha, TransformStreams& blended, size_t i) {
+	typedef typename L::Type F;
+	F t = L::Set(alpha);
+
+	auto lerp = [&](const std::vector<float>& a, const std::vector<float>& b, std::vector<float>& out) {
+		F from = L::Load(&a[i]);
+		L::Store(&out[i], L::Add(from, L::Mul(L::Sub(L::Load(&b[i]), from), t)));
+	};
+
+	lerp(previous.PositionX, current.PositionX, blended.PositionX);
+	lerp(previous.PositionY, current.PositionY, blended.PositionY);
+	lerp(previous.PositionZ, current.PositionZ, blended.PositionZ);
+	lerp(previous.ScaleX, current.ScaleX, blended.ScaleX);
+	lerp(previous.ScaleY, current.ScaleY, blended.ScaleY);
+	lerp(previous.ScaleZ, current.ScaleZ, blended.ScaleZ);
+
+	//q and -q are the same rotation, so flip the target to the near one
+	F ax = L::Load(&previous.RotationX[i]), ay = L::Load(&previous.RotationY[i]);
+	F az = L::Load(&previous.RotationZ[i]), aw = L::Load(&previous.RotationW[i]);
+	F bx = L::Load(&current.RotationX[i]), by = L::Load(&current.RotationY[i]);
+	F bz = L::Load(&current.RotationZ[i]), bw = L::Load(&current.RotationW[i]);
+
+	F dot = L::Add(L::Add(L::Mul(ax, bx), L::Mul(ay, by)), L::Add(L::Mul(az, bz), L::Mul(aw, bw)));
+	F sign = L::SignOf(dot);
+
+	F qx = L::Add(ax, L::Mul(L::Sub(L::Mul(bx, sign), ax), t));
+	F qy = L::Add(ay, L::Mul(L::Sub(L::Mul(by, sign), ay), t));
+	F qz = L::Add(az, L::Mul(L::Sub(L::Mul(bz, sign), az), t));
+	F qw = L::Add(aw, L::Mul(L::Sub(L::Mul(bw, sign), aw), t));
+
+	F length = L::Sqrt(L::Add(L::Add(L::Mul(qx, qx), L::Mul(qy, qy)), L::Add(L::Mul(qz, qz), L::Mul(qw, qw))));
+	L::Store(&blended.RotationX[i], L::Div(qx, length));
+	L::Store(&blended.RotationY[i], L::Div(qy, length));
+	L::Store(&blended.RotationZ[i], L::Div(qz, length));
+	L::Store(&blended.RotationW[i], L::Div(qw, length));
+}
+
+// --------------------------------------------------------
+// world = scale * rotation * translation, as DirectXMath
+// builds it, so row i is the rotation's row i scaled by
+// scale i, with the position underneath
+//  - The inverse transpose of that has row i as rotation
+//     row i over scale i, and the inverse translation in
+//     the last column
+// --------------------------------------------------------
+template<typename L>
+static void ComputeLanes(const TransformBatchInput& input, const TransformBatchOutput& output, size_t i) {
+	typedef typename L::Type F;
+	const TransformStreams& transforms = *input.Transforms;
+
+	F zero = L::Set(0.0f);
+	F one = L::Set(1.0f);
+	F two = L::Set(2.0f);
+
+	F px = L::Load(&transforms.PositionX[i]), py = L::Load(&transforms.PositionY[i]), pz = L::Load(&transforms.PositionZ[i]);
+	F qx = L::Load(&transforms.RotationX[i]), qy = L::Load(&transforms.RotationY[i]);
+	F qz = L::Load(&transforms.RotationZ[i]), qw = L::Load(&transforms.RotationW[i]);
+	F sx = L::Load(&transforms.ScaleX[i]), sy = L::Load(&transforms.ScaleY[i]), sz = L::Load(&transforms.ScaleZ[i]);
+
+	F xx = L::Mul(qx, qx), yy = L::Mul(qy, qy), zz = L::Mul(qz, qz);
+	F xy = L::Mul(qx, qy), xz = L::Mul(qx, qz), yz = L::Mul(qy, qz);
+	F wx = L::Mul(qw, qx), wy = L::Mul(qw, qy), wz = L::Mul(qw, qz);
+
+	F r[3][3] = {
+		{ L::Sub(one, L::Mul(two, L::Add(yy, zz))), L::Mul(two, L::Add(xy, wz)), L::Mul(two, L::Sub(xz, wy)) },
+		{ L::Mul(two, L::Sub(xy, wz)), L::Sub(one, L::Mul(two, L::Add(xx, zz))), L::Mul(two, L::Add(yz, wx)) },
+		{ L::Mul(two, L::Add(xz, wy)), L::Mul(two, L::Sub(yz, wx)), L::Sub(one, L::Mul(two, L::Add(xx, yy))) },
+	};
+	F scale[3] = { sx, sy, sz };
+	F position[3] = { px, py, pz };
+
+	F world[16];
+	for (int row = 0; row < 3; row++) {
+		for (int column = 0; column < 3; column++) world[row * 4 + column] = L::Mul(r[row][column], scale[row]);
+		world[row * 4 + 3] = zero;
+	}
+	world[12] = px;
+	world[13] = py;
+	world[14] = pz;
+	world[15] = one;
+
+	if (output.World) StoreMatrices<L>(world, output.World + i * 16);
+
+	if (output.WorldInverseTranspose) {
+		F inverseTranspose[16];
+		for (int row = 0; row < 3; row++) {
+			F inverseScale = L::Div(one, scale[row]);
+			F moved = zero;
+			for (int column = 0; column < 3; column++) {
+				inverseTranspose[row * 4 + column] = L::Mul(r[row][column], inverseScale);
+				moved = L::Add(moved, L::Mul(position[column], r[row][column]));
+			}
+			inverseTranspose[row * 4 + 3] = L::Sub(zero, L::Mul(moved, inverseScale));
+		}
+		inverseTranspose[12] = zero;
+		inverseTranspose[13] = zero;
+		inverseTranspose[14] = zero;
+		inverseTranspose[15] = one;
+
+		StoreMatrices<L>(inverseTranspose, output.WorldInverseTranspose + i * 16);
+	}
+
+	if (output.Bounds && input.LocalBounds) {
+		//Rows 0-2 are the axes, row 3 the translation
+		F m[4][3];
+		for (int row = 0; row < 4; row++) {
+			for (int column = 0; column < 3; column++) m[row][column] = world[row * 4 + column];
+		}
+
+		//On into view space, if there's a view
+		if (input.View) {
+			const float* view = input.View;
+			F viewed[4][3];
+			for (int row = 0; row < 4; row++) {
+				for (int column = 0; column < 3; column++) {
+					F sum = row == 3 ? L::Set(view[12 + column]) : zero;
+					for (int k = 0; k < 3; k++) sum = L::Add(sum, L::Mul(m[row][k], L::Set(view[k * 4 + column])));
+					viewed[row][column] = sum;
+				}
+			}
+
+			for (int row = 0; row < 4; row++) {
+				for (int column = 0; column < 3; column++) m[row][column] = viewed[row][column];
+			}
+		}
+
+		const BoundsStreams& local = *input.LocalBounds;
+		F center[3] = { L::Load(&local.CenterX[i]), L::Load(&local.CenterY[i]), L::Load(&local.CenterZ[i]) };
+		F extents[3] = { L::Load(&local.ExtentX[i]), L::Load(&local.ExtentY[i]), L::Load(&local.ExtentZ[i]) };
+
+		F newCenter[3];
+		F newExtents[3];
+		for (int column = 0; column < 3; column++) {
+			newCenter[column] = m[3][column];
+			newExtents[column] = zero;
+			for (int k = 0; k < 3; k++) {
+				newCenter[column] = L::Add(newCenter[column], L::Mul(center[k], m[k][column]));
+				newExtents[column] = L::Add(newExtents[column], L::Mul(extents[k], L::Abs(m[k][column])));
+			}
+		}
+
+		BoundsStreams& bounds = *output.Bounds;
+		L::Store(&bounds.CenterX[i], newCenter[0]);
+		L::Store(&bounds.CenterY[i], newCenter[1]);
+		L::Store(&bounds.CenterZ[i], newCenter[2]);
+		L::Store(&bounds.ExtentX[i], newExtents[0]);
+		L::Store(&bounds.ExtentY[i], newExtents[1]);
+		L::Store(&bounds.ExtentZ[i], newExtents[2]);
+	}
+}
+
+// --------------------------------------------------------
+// Runs whole groups of lanes from first, and returns where
+// the scalar tail starts
+// --------------------------------------------------------
+template<typename L>
+static size_t BlendGroups(const TransformStreams& previous, const TransformStreams& current, float alpha, TransformStreams& blended, size_t first, size_t end) {
+	for (; first + L::Width <= end; first += L::Width) BlendLanes<L>(previous, current, alpha, blended, first);
+	return first;
+}
+
+template<typename L>
+static size_t ComputeGroups(const TransformBatchInput& input, const TransformBatchOutput& output, size_t first, size_t end) {
+	for (; first + L::Width <= end; first += L::Width) ComputeLanes<L>(input, output, first);
+	return first;
+}
+
+#ifdef SIMD_LANES_X86
+// --------------------------------------------------------
+// The AVX2 groups, from TransformBatchAVX2.cpp
+//  - Only call these once TransformBatch has checked the
+//     CPU runs AVX2
+// --------------------------------------------------------
+namespace TransformBatchAVX2 {
+	size_t BlendGroups(const TransformStreams& previous, const TransformStreams& current, float alpha, TransformStreams& blended, size_t first, size_t end);
+	size_t ComputeGroups(const TransformBatchInput& input, const TransformBatchOutput& output, size_t first, size_t end);
+}
+#endif
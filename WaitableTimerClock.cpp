@@ -0,0 +1,52 @@
+#include "WaitableTimerClock.h"
+
+// Older SDKs don't define this yet
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+WaitableTimerClock::WaitableTimerClock() {
+	__int64 perfFreq = 0;
+	QueryPerformanceFrequency((LARGE_INTEGER*)&perfFreq);
+	perfCounterSeconds = 1.0 / (double)perfFreq;
+
+	//Fall back to a regular timer where high resolution isn't supported
+	timer = CreateWaitableTimerExW(0, 0, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+	highResolution = timer != 0;
+	if (!timer) {
+		timer = CreateWaitableTimerExW(0, 0, 0, TIMER_ALL_ACCESS);
+	}
+}
+
+WaitableTimerClock::~WaitableTimerClock() {
+	if (timer) CloseHandle(timer);
+}
+
+double WaitableTimerClock::Now() {
+	__int64 now = 0;
+	QueryPerformanceCounter((LARGE_INTEGER*)&now);
+	return now * perfCounterSeconds;
+}
+
+void WaitableTimerClock::Sleep(double seconds) {
+	if (seconds <= 0.0) return;
+
+	//Negative due times are relative, in 100ns units
+	LARGE_INTEGER dueTime = {};
+	dueTime.QuadPart = -(LONGLONG)(seconds * 10000000.0);
+
+	if (timer && SetWaitableTimer(timer, &dueTime, 0, 0, 0, FALSE)) {
+		WaitForSingleObject(timer, INFINITE);
+	}
+	else {
+		::Sleep((DWORD)(seconds * 1000.0));
+	}
+}
+
+void WaitableTimerClock::Spin() {
+	YieldProcessor();
+}
+
+bool WaitableTimerClock::IsHighResolution() {
+	return highResolution;
+}
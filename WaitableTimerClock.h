@@ -0,0 +1,29 @@
+#pragma once
+
+#include <Windows.h>
+
+#include "FramePacer.h"
+
+// --------------------------------------------------------
+// Frame clock backed by QueryPerformanceCounter and a
+// waitable timer
+//  - Asks for a high resolution timer where the OS has one
+//    (Windows 10 1803+), which wakes within a fraction of a
+//    millisecond instead of on the ~1-15ms scheduler tick
+// --------------------------------------------------------
+class WaitableTimerClock : public FrameClock {
+private:
+	HANDLE timer;
+	bool highResolution;
+	double perfCounterSeconds;
+
+public:
+	WaitableTimerClock();
+	~WaitableTimerClock();
+
+	double Now() override;
+	void Sleep(double seconds) override;
+	void Spin() override;
+
+	bool IsHighResolution();
+};
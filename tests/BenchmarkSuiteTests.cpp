@@ -0,0 +1,204 @@
+#include "Test.h"
+
+#include <sstream>
+#include <string>
+
+#include "../BenchmarkSuite.h"
+
+static BenchmarkSceneDesc MakeScene(const char* name, int warmup, int frames) {
+	BenchmarkSceneDesc scene;
+	scene.Name = name;
+	scene.EntityCount = 10;
+	scene.HierarchyDepth = 3;
+	scene.MeshCount = 2;
+	scene.MaterialCount = 3;
+	scene.MeshDetail = 4;
+	scene.WarmupFrames = warmup;
+	scene.FrameCount = frames;
+	return scene;
+}
+
+// Lines in some text, which all end in a newline
+static size_t CountLines(const std::string& text) {
+	size_t lines = 0;
+	for (char c : text) if (c == '\n') lines++;
+	return lines;
+}
+
+// --------------------------------------------------------
+// Warmup frames run but aren't kept, the suite moves on
+// after each scene's frames, and stops after the last
+// --------------------------------------------------------
+TEST(BenchmarkSuiteRunsScenes) {
+	BenchmarkSuite suite;
+	suite.AddScene(MakeScene("First", 2, 3));
+	suite.AddScene(MakeScene("Second", 0, 4));
+	CHECK(!suite.IsRunning());
+
+	suite.Start();
+	CHECK(suite.IsRunning());
+	CHECK(!suite.IsSceneLoaded());
+	CHECK_EQUAL(suite.GetCurrentScene()->Name, std::string("First"));
+
+	BenchmarkSceneData data;
+	suite.LoadScene(data);
+	CHECK(suite.IsSceneLoaded());
+
+	unsigned int scenesFinished = 0;
+	for (int frame = 0; frame < 9; frame++) {
+		CHECK_EQUAL(suite.IsWarmingUp(), suite.GetCurrentScene()->Name == "First" && frame < 2);
+
+		BenchmarkFrameSample sample;
+		sample.FrameMilliseconds = (float)(frame + 1);
+		sample.Device.DrawCalls = frame * 10;
+		if (suite.EndFrame(sample)) {
+			scenesFinished++;
+			CHECK(!suite.IsSceneLoaded());
+		}
+		CHECK_EQUAL(suite.IsRunning(), frame < 8);
+	}
+	CHECK_EQUAL(scenesFinished, 2u);
+
+	const std::vector<BenchmarkSceneResult>& results = suite.GetResults();
+	CHECK_EQUAL(results.size(), (size_t)2);
+	CHECK_EQUAL(results[0].Samples.size(), (size_t)3);
+	CHECK_EQUAL(results[1].Samples.size(), (size_t)4);
+
+	//The first scene kept frames 3 to 5, numbered from zero
+	CHECK_EQUAL(results[0].Samples[0].Frame, 0u);
+	CHECK_EQUAL(results[0].Samples[0].FrameMilliseconds, 3.0f);
+	CHECK_NEAR(results[0].AverageFrameMilliseconds, 4.0f, 1e-5f);
+	CHECK_EQUAL(results[0].MaxFrameMilliseconds, 5.0f);
+	CHECK_NEAR(results[0].AverageDrawCalls, 30.0, 1e-9);
+
+	//Nothing happens once it's stopped
+	BenchmarkFrameSample sample;
+	CHECK(!suite.EndFrame(sample));
+	CHECK(suite.GetCurrentScene() == 0);
+}
+
+// --------------------------------------------------------
+// Percentiles round up to the next sample, so the median of
+// 1 to 100 is 50 and the 99th is 99
+// --------------------------------------------------------
+TEST(BenchmarkSuiteSummary) {
+	BenchmarkSuite suite;
+	suite.AddScene(MakeScene("Summary", 0, 100));
+	suite.Start();
+
+	for (int frame = 0; frame < 100; frame++) {
+		//Out of order, so the sort matters
+		BenchmarkFrameSample sample;
+		sample.FrameMilliseconds = (float)((frame * 37) % 100 + 1);
+		sample.WorkingSetBytes = frame == 40 ? 4096 : 1024;
+		suite.EndFrame(sample);
+	}
+
+	const BenchmarkSceneResult& result = suite.GetResults()[0];
+	CHECK_NEAR(result.AverageFrameMilliseconds, 50.5f, 1e-4f);
+	CHECK_EQUAL(result.MedianFrameMilliseconds, 50.0f);
+	CHECK_EQUAL(result.P95FrameMilliseconds, 95.0f);
+	CHECK_EQUAL(result.P99FrameMilliseconds, 99.0f);
+	CHECK_EQUAL(result.MaxFrameMilliseconds, 100.0f);
+	CHECK_EQUAL(result.PeakWorkingSetBytes, (uint64_t)4096);
+
+	//A run cut short still gets its summary
+	suite.Start();
+	for (int frame = 0; frame < 10; frame++) {
+		BenchmarkFrameSample sample;
+		sample.FrameMilliseconds = 2.0f;
+		suite.EndFrame(sample);
+	}
+	suite.Stop();
+	CHECK(!suite.IsRunning());
+	CHECK_EQUAL(suite.GetResults()[0].Samples.size(), (size_t)10);
+	CHECK_EQUAL(suite.GetResults()[0].AverageFrameMilliseconds, 2.0f);
+}
+
+// --------------------------------------------------------
+// Generated meshes, materials and poses are the same every
+// run, and parent chains are laid out root first
+// --------------------------------------------------------
+TEST(BenchmarkSuiteScene) {
+	BenchmarkSuite suite;
+	suite.AddScene(MakeScene("Scene", 0, 2));
+	suite.Start();
+
+	BenchmarkSceneData data;
+	suite.LoadScene(data);
+	CHECK_EQUAL(data.Meshes.size(), (size_t)2);
+	CHECK_EQUAL(data.Materials.size(), (size_t)3);
+	CHECK_EQUAL(data.EntityMeshes.size(), (size_t)10);
+	CHECK_EQUAL(data.EntityMeshes[3], 1u);
+	CHECK_EQUAL(data.EntityMaterials[5], 2u);
+
+	//Rings step up by half the detail, with twice as many segments
+	const BenchmarkMeshData& second = data.Meshes[1];
+	CHECK_EQUAL(second.Positions.size(), (size_t)(7 * 13 * 3));
+	CHECK_EQUAL(second.UVs.size(), (size_t)(7 * 13 * 2));
+	CHECK_EQUAL(second.Indices.size(), (size_t)(6 * 12 * 6));
+	for (size_t i = 0; i < second.Positions.size(); i += 3) {
+		float length = std::sqrt(second.Positions[i] * second.Positions[i] + second.Positions[i + 1] * second.Positions[i + 1] + second.Positions[i + 2] * second.Positions[i + 2]);
+		CHECK_NEAR(length, 0.5f, 1e-5f);
+		CHECK_NEAR(second.Normals[i + 1], second.Positions[i + 1] * 2.0f, 1e-5f);
+	}
+
+	BenchmarkSceneData again;
+	suite.LoadScene(again);
+	for (size_t i = 0; i < data.Materials.size(); i++) {
+		CHECK_EQUAL(data.Materials[i].Color[0], again.Materials[i].Color[0]);
+		CHECK_EQUAL(data.Materials[i].Roughness, again.Materials[i].Roughness);
+	}
+
+	std::vector<BenchmarkEntityPose> poses;
+	suite.PoseEntities(poses);
+	CHECK_EQUAL(poses.size(), (size_t)10);
+
+	//Roots sit at full size on the grid, and children shrink
+	CHECK_EQUAL(poses[0].Scale, 1.0f);
+	CHECK_EQUAL(poses[0].Position[1], 0.5f);
+	CHECK_NEAR(poses[1].Scale, 0.9f, 1e-6f);
+	CHECK_NEAR(poses[2].Scale, 0.81f, 1e-6f);
+	CHECK_EQUAL(poses[3].Scale, 1.0f);
+	CHECK_NEAR(poses[3].Position[0] - poses[0].Position[0], 3.0f, 1e-5f);
+
+	//The camera looks at the middle of the scene, from outside it
+	BenchmarkCameraPose camera = suite.PoseCamera();
+	float distance = std::sqrt(camera.Position[0] * camera.Position[0] + camera.Position[2] * camera.Position[2]);
+	CHECK(distance > 6.0f);
+	CHECK(camera.Pitch > 0.0f);
+
+	//Poses move on with the frame
+	BenchmarkFrameSample sample;
+	suite.EndFrame(sample);
+	std::vector<BenchmarkEntityPose> next;
+	suite.PoseEntities(next);
+	CHECK(next[1].Yaw != poses[1].Yaw);
+}
+
+// --------------------------------------------------------
+// Each scene's summary goes in the JSON, and every measured
+// frame gets a row in the CSV
+// --------------------------------------------------------
+TEST(BenchmarkSuiteWrite) {
+	BenchmarkSuite suite;
+	suite.AddScene(MakeScene("Quote \"Me\"", 1, 3));
+	suite.AddScene(MakeScene("Plain", 0, 2));
+	suite.Start();
+	while (suite.IsRunning()) {
+		BenchmarkFrameSample sample;
+		sample.Device.DrawCalls = 7;
+		suite.EndFrame(sample);
+	}
+
+	std::ostringstream json;
+	CHECK(suite.WriteJson(json));
+	CHECK(json.str().find("\"name\": \"Quote \\\"Me\\\"\"") != std::string::npos);
+	CHECK(json.str().find("\"name\": \"Plain\"") != std::string::npos);
+	CHECK(json.str().find("\"averageDrawCalls\": 7") != std::string::npos);
+
+	std::ostringstream csv;
+	CHECK(suite.WriteCsv(csv));
+	CHECK_EQUAL(CountLines(csv.str()), (size_t)(1 + 3 + 2));
+	CHECK(csv.str().find("\"Plain\",1,") != std::string::npos);
+}
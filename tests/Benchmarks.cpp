@@ -0,0 +1,436 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "../BenchmarkSuite.h"
+#include "../JobSystem.h"
+#include "../LightBinner.h"
+#include "../LightCuller.h"
+#include "../Profiler.h"
+#include "../RayCaster.h"
+#include "../RecordingRenderDevice.h"
+#include "../SceneBvh.h"
+#include "../SceneFile.h"
+#include "TestMeshes.h"
+
+typedef std::chrono::high_resolution_clock Clock;
+
+// --------------------------------------------------------
+// Thread counts to scale over, from one up to a few more
+// than the machine has, as the main thread helps too
+// --------------------------------------------------------
+static std::vector<int> GetThreadCounts() {
+	int cores = (int)(std::max)(std::thread::hardware_concurrency(), 1u);
+
+	std::vector<int> counts;
+	for (int threads = 1; threads < cores; threads *= 2) counts.push_back(threads);
+	counts.push_back(cores);
+	if (cores < 4) counts.push_back(4);
+	return counts;
+}
+
+// --------------------------------------------------------
+// Best of a few runs, in milliseconds
+// --------------------------------------------------------
+template<typename Body>
+static double Time(int runs, Body body) {
+	double best = 1e30;
+	for (int run = 0; run < runs; run++) {
+		Clock::time_point start = Clock::now();
+		body();
+		best = (std::min)(best, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+	}
+	return best;
+}
+
+// --------------------------------------------------------
+// Clustered light binning, for thousands of point and spot
+// lights scattered through the view frustum
+// --------------------------------------------------------
+static void BenchmarkLightBinning() {
+	printf("Light binning (%dx%dx%d clusters)\n", CLUSTER_COUNT_X, CLUSTER_COUNT_Y, CLUSTER_COUNT_Z);
+	printf("%8s %8s %10s %12s\n", "Lights", "Threads", "ms", "Indices");
+
+	LightBinner binner;
+	binner.SetProjection(9.0f / 16.0f, 1.0f, 0.1f, 100.0f);
+
+	for (unsigned int lightCount : { 1024u, 4096u, 16384u }) {
+		std::mt19937 random(lightCount);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		std::uniform_real_distribution<float> depth(0.5f, 100.0f);
+		std::uniform_real_distribution<float> radius(0.5f, 4.0f);
+
+		//Inside the frustum, a quarter of them spot lights
+		std::vector<BinnedLight> lights(lightCount);
+		for (unsigned int i = 0; i < lightCount; i++) {
+			BinnedLight& light = lights[i];
+			float z = depth(random);
+			light.Center[0] = light.Apex[0] = unit(random) * z * 16.0f / 9.0f;
+			light.Center[1] = light.Apex[1] = unit(random) * z;
+			light.Center[2] = light.Apex[2] = z;
+			light.Radius = light.Range = radius(random);
+
+			light.IsSpot = i % 4 == 0;
+			light.Direction[0] = 0.0f;
+			light.Direction[1] = -1.0f;
+			light.Direction[2] = 0.0f;
+			light.CosAngle = cosf(0.5f);
+			light.SinAngle = sinf(0.5f);
+		}
+
+		std::vector<ClusterRange> ranges;
+		std::vector<unsigned int> indices;
+
+		for (int threads : GetThreadCounts()) {
+			JobSystem::GetInstance().Initialize(threads - 1);
+			double ms = Time(10, [&]() { binner.Bin(lights.data(), lightCount, 0, ranges, indices); });
+			JobSystem::GetInstance().ShutDown();
+
+			printf("%8u %8d %10.3f %12zu\n", lightCount, threads, ms, indices.size());
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Per entity light culling, for a scene's worth of boxes
+// against hundreds of point and spot lights
+// --------------------------------------------------------
+static void BenchmarkLightCulling() {
+	printf("Per entity light culling\n");
+	printf("%8s %8s %10s %12s %12s\n", "Lights", "Entities", "ms", "Indices", "Culled");
+
+	const unsigned int entityCount = 10000;
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> across(-50.0f, 50.0f);
+	std::uniform_real_distribution<float> size(0.25f, 2.0f);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	std::vector<float> centers(entityCount * 3);
+	std::vector<float> extents(entityCount * 3);
+	for (unsigned int i = 0; i < entityCount * 3; i++) {
+		centers[i] = across(random);
+		extents[i] = size(random);
+	}
+
+	for (unsigned int lightCount : { 64u, 256u, 1024u }) {
+		//A quarter of them spot lights
+		std::vector<LightVolume> volumes(lightCount);
+		for (unsigned int i = 0; i < lightCount; i++) {
+			float position[3] = { across(random), across(random), across(random) };
+			if (i % 4 == 0) {
+				float direction[3] = { unit(random), unit(random) - 1.0f, unit(random) };
+				volumes[i] = LightCuller::CreateSpotVolume(position, direction, size(random) * 8.0f, 16.0f);
+			} else {
+				volumes[i] = LightCuller::CreatePointVolume(position, size(random) * 4.0f);
+			}
+		}
+
+		LightCuller culler;
+		culler.SetVolumes(volumes.data(), lightCount);
+
+		std::vector<unsigned int> indices;
+		double ms = Time(10, [&]() {
+			indices.clear();
+			culler.ResetStats();
+			for (unsigned int i = 0; i < entityCount; i++) {
+				culler.Cull(&centers[i * 3], &extents[i * 3], indices);
+			}
+		});
+
+		printf("%8u %8u %10.3f %12zu %12u\n", lightCount, entityCount, ms, indices.size(), culler.GetLightsCulled());
+	}
+}
+
+// --------------------------------------------------------
+// How the job system scales, for work that splits evenly
+// and for jobs so small only the overhead is left
+//  - Speed up is against the one thread run of each row,
+//     and steals are across all of a row's runs
+// --------------------------------------------------------
+static void BenchmarkJobSystem() {
+	printf("Job system scaling\n");
+	printf("%-16s %8s %8s %10s %8s %10s\n", "Work", "Grain", "Threads", "ms", "Speedup", "Stolen");
+
+	//Enough math per item that splitting it up should pay off
+	const size_t itemCount = 1 << 20;
+	std::vector<float> items(itemCount);
+	auto work = [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			float x = (float)i;
+			for (int step = 0; step < 16; step++) x = sqrtf(x * 1.5f + 1.0f);
+			items[i] = x;
+		}
+	};
+
+	for (size_t grain : { (size_t)256, (size_t)4096, (size_t)65536 }) {
+		double baseline = 0.0;
+		for (int threads : GetThreadCounts()) {
+			JobSystem& jobs = JobSystem::GetInstance();
+			jobs.Initialize(threads - 1);
+			unsigned int stolen = jobs.GetJobsStolen();
+			double ms = Time(5, [&]() { jobs.ParallelFor(itemCount, grain, work); });
+			stolen = jobs.GetJobsStolen() - stolen;
+			jobs.ShutDown();
+
+			if (threads == 1) baseline = ms;
+			printf("%-16s %8zu %8d %10.3f %7.2fx %10u\n", "ParallelFor", grain, threads, ms, baseline / ms, stolen);
+		}
+	}
+
+	//Empty jobs, each waited on as one batch
+	const int jobCount = 20000;
+	double baseline = 0.0;
+	for (int threads : GetThreadCounts()) {
+		JobSystem& jobs = JobSystem::GetInstance();
+		jobs.Initialize(threads - 1);
+		unsigned int stolen = jobs.GetJobsStolen();
+		double ms = Time(5, [&]() {
+			JobCounter counter;
+			for (int i = 0; i < jobCount; i++) jobs.Run([]() {}, &counter);
+			jobs.Wait(counter);
+		});
+		stolen = jobs.GetJobsStolen() - stolen;
+		jobs.ShutDown();
+
+		if (threads == 1) baseline = ms;
+		printf("%-16s %8d %8d %10.3f %7.2fx %10u\n", "Empty jobs", 1, threads, ms, baseline / ms, stolen);
+	}
+}
+
+// --------------------------------------------------------
+// What one PROFILE_SCOPE costs, on the calling thread and
+// on every thread at once, as workers record zones too
+// --------------------------------------------------------
+static void BenchmarkProfilerZones() {
+	printf("Profiler zone overhead\n");
+	printf("%8s %12s %10s\n", "Threads", "Zones", "ns/zone");
+
+	const unsigned int zoneCount = 1000000;
+	for (int threads : GetThreadCounts()) {
+		std::vector<double> nanoseconds(threads);
+		std::vector<std::thread> workers;
+		for (int i = 1; i < threads; i++) {
+			workers.emplace_back([&nanoseconds, i]() { nanoseconds[i] = Profiler::GetInstance().MeasureZoneOverhead(zoneCount); });
+		}
+		nanoseconds[0] = Profiler::GetInstance().MeasureZoneOverhead(zoneCount);
+		for (std::thread& worker : workers) worker.join();
+
+		double average = 0.0;
+		for (double ns : nanoseconds) average += ns / threads;
+		printf("%8d %12u %10.2f\n", threads, zoneCount, average);
+	}
+}
+
+// --------------------------------------------------------
+// Building, refitting and querying the scene BVH, up to a
+// million entities, over every thread
+// --------------------------------------------------------
+static void BenchmarkSceneBvh() {
+	printf("Scene BVH (10000 queries of each kind)\n");
+	printf("%8s %10s %10s %6s %12s %12s %12s %12s %10s\n", "Items", "Build ms", "Refit ms", "Cost", "Frustums/s", "Spheres/s", "Rays/s", "Every item/s", "Mismatches");
+
+	JobSystem::GetInstance().Initialize();
+	for (size_t itemCount : { (size_t)10000, (size_t)100000, (size_t)1000000 }) {
+		SceneBvhMeasurement m = SceneBvh::Measure(itemCount, 10000);
+		printf("%8zu %10.2f %10.2f %5.2fx %12.0f %12.0f %12.0f %12.1f %10u\n",
+			m.Items, m.BuildMilliseconds, m.RefitMilliseconds, m.RefitCostRatio,
+			m.FrustumQueriesPerSecond, m.SphereQueriesPerSecond, m.RayQueriesPerSecond, m.BruteForceQueriesPerSecond, m.Mismatches);
+	}
+	JobSystem::GetInstance().ShutDown();
+}
+
+// --------------------------------------------------------
+// Casting rays through copies of two generated spheres, a
+// detailed one and a coarse one, over every thread
+// --------------------------------------------------------
+static void BenchmarkRayCasts() {
+	std::vector<std::shared_ptr<MeshBvh>> meshes = { MakeSphereBvh(32, 64, 1.0f), MakeSphereBvh(8, 16, 1.0f) };
+
+	printf("Ray casting (100000 rays)\n");
+	printf("%10s %12s %8s %12s %12s %12s %12s %8s %10s\n", "Instances", "Triangles", "Path", "Rays/s", "1 thread/s", "Scalar/s", "Every tri/s", "Hits", "Mismatches");
+
+	JobSystem::GetInstance().Initialize();
+	for (size_t instanceCount : { (size_t)10000, (size_t)100000 }) {
+		RayCastMeasurement m = RayCaster::Measure(meshes, instanceCount, 100000);
+		printf("%10zu %12zu %8s %12.0f %12.0f %12.0f %12.2f %8u %10u\n",
+			m.Instances, m.Triangles, m.Path, m.RaysPerSecond, m.SingleThreadRaysPerSecond,
+			m.ScalarRaysPerSecond, m.BruteForceRaysPerSecond, m.Hits, m.Mismatches);
+	}
+	JobSystem::GetInstance().ShutDown();
+}
+
+// --------------------------------------------------------
+// The game's benchmark scenes, submitted to the null device
+// the way the game draws them, without a window or a GPU
+//  - Each entity gets its world matrix uploaded and one
+//     indexed draw, and each material its own constant buffer,
+//     so draw counts and state changes match the game's
+//  - Lights aren't drawn, so scenes only differ in entities,
+//     meshes, materials and hierarchy here
+//  - Results go to BenchmarkResults.json and .csv in the
+//     working directory, like the game's next to its exe
+// --------------------------------------------------------
+static void BenchmarkSuiteScenes() {
+	BenchmarkSuite suite;
+	suite.AddDefaultScenes();
+
+	RecordingRenderDevice device;
+	device.SetRecording(false);
+
+	BufferHandle objectBuffer = device.CreateBuffer(BufferDesc{ BufferType::Constant, BufferUsage::Dynamic, sizeof(float) * 16 }, 0);
+	std::vector<BufferHandle> vertexBuffers;
+	std::vector<BufferHandle> indexBuffers;
+	std::vector<unsigned int> indexCounts;
+	std::vector<BufferHandle> materialBuffers;
+
+	BenchmarkSceneData data;
+	std::vector<BenchmarkEntityPose> poses;
+	std::vector<float> vertices;
+
+	suite.Start();
+	Clock::time_point frameStart = Clock::now();
+	while (suite.IsRunning()) {
+		if (!suite.IsSceneLoaded()) {
+			for (BufferHandle buffer : vertexBuffers) device.DestroyBuffer(buffer);
+			for (BufferHandle buffer : indexBuffers) device.DestroyBuffer(buffer);
+			for (BufferHandle buffer : materialBuffers) device.DestroyBuffer(buffer);
+			vertexBuffers.clear();
+			indexBuffers.clear();
+			indexCounts.clear();
+			materialBuffers.clear();
+
+			suite.LoadScene(data);
+
+			//Interleaved like the game's vertices, position, normal then UV
+			for (const BenchmarkMeshData& mesh : data.Meshes) {
+				size_t vertexCount = mesh.Positions.size() / 3;
+				vertices.clear();
+				for (size_t i = 0; i < vertexCount; i++) {
+					vertices.insert(vertices.end(), &mesh.Positions[i * 3], &mesh.Positions[i * 3] + 3);
+					vertices.insert(vertices.end(), &mesh.Normals[i * 3], &mesh.Normals[i * 3] + 3);
+					vertices.insert(vertices.end(), &mesh.UVs[i * 2], &mesh.UVs[i * 2] + 2);
+				}
+
+				vertexBuffers.push_back(device.CreateBuffer(BufferDesc{ BufferType::Vertex, BufferUsage::Immutable, (unsigned int)(vertices.size() * sizeof(float)) }, vertices.data()));
+				indexBuffers.push_back(device.CreateBuffer(BufferDesc{ BufferType::Index, BufferUsage::Immutable, (unsigned int)(mesh.Indices.size() * sizeof(unsigned int)) }, mesh.Indices.data()));
+				indexCounts.push_back((unsigned int)mesh.Indices.size());
+			}
+
+			for (const BenchmarkMaterialDesc& material : data.Materials) {
+				materialBuffers.push_back(device.CreateBuffer(BufferDesc{ BufferType::Constant, BufferUsage::Immutable, sizeof(material) }, &material));
+			}
+		}
+
+		Clock::time_point updateStart = Clock::now();
+		suite.PoseEntities(poses);
+		suite.PoseCamera();
+
+		Clock::time_point drawStart = Clock::now();
+		device.BeginFrame();
+		device.SetTopology(PrimitiveTopology::TriangleList);
+		device.SetConstantBuffer(ShaderStage::Vertex, 0, objectBuffer);
+		for (size_t i = 0; i < poses.size(); i++) {
+			//Row major scale, then yaw, then translation
+			const BenchmarkEntityPose& pose = poses[i];
+			float c = cosf(pose.Yaw) * pose.Scale;
+			float s = sinf(pose.Yaw) * pose.Scale;
+			const float world[16] = {
+				c, 0.0f, -s, 0.0f,
+				0.0f, pose.Scale, 0.0f, 0.0f,
+				s, 0.0f, c, 0.0f,
+				pose.Position[0], pose.Position[1], pose.Position[2], 1.0f,
+			};
+			device.UpdateBuffer(objectBuffer, world, sizeof(world));
+
+			unsigned int mesh = data.EntityMeshes[i];
+			device.SetVertexBuffer(vertexBuffers[mesh], sizeof(float) * 8);
+			device.SetIndexBuffer(indexBuffers[mesh]);
+			device.SetConstantBuffer(ShaderStage::Pixel, 0, materialBuffers[data.EntityMaterials[i]]);
+			device.DrawIndexed(indexCounts[mesh]);
+		}
+
+		Clock::time_point now = Clock::now();
+		BenchmarkFrameSample sample;
+		sample.FrameMilliseconds = std::chrono::duration<float, std::milli>(now - frameStart).count();
+		sample.UpdateMilliseconds = std::chrono::duration<float, std::milli>(drawStart - updateStart).count();
+		sample.DrawMilliseconds = std::chrono::duration<float, std::milli>(now - drawStart).count();
+		sample.Device = device.GetStats();
+		frameStart = now;
+
+		suite.EndFrame(sample);
+	}
+
+	printf("Benchmark suite (null device)\n");
+	printf("%-16s %8s %10s %10s %10s %10s %10s %12s\n", "Scene", "Frames", "Avg ms", "P99 ms", "Update ms", "Draw ms", "Draws", "Changes");
+	for (const BenchmarkSceneResult& result : suite.GetResults()) {
+		printf("%-16s %8zu %10.3f %10.3f %10.3f %10.3f %10.0f %12.0f\n",
+			result.Scene.Name.c_str(), result.Samples.size(), result.AverageFrameMilliseconds, result.P99FrameMilliseconds,
+			result.AverageUpdateMilliseconds, result.AverageDrawMilliseconds, result.AverageDrawCalls, result.AverageStateChanges);
+	}
+
+	std::ofstream json("BenchmarkResults.json");
+	std::ofstream csv("BenchmarkResults.csv");
+	bool written = json.is_open() && suite.WriteJson(json) && csv.is_open() && suite.WriteCsv(csv);
+	printf("%s BenchmarkResults.json and BenchmarkResults.csv\n", written ? "Wrote" : "Couldn't write");
+}
+
+// --------------------------------------------------------
+// Loading a generated scene from its text and binary forms,
+// written to the working directory
+// --------------------------------------------------------
+static void BenchmarkSceneLoad() {
+	printf("Scene loading\n");
+	printf("%8s %10s %10s %10s %10s %10s %8s %12s\n", "Entities", "Text MB", "Parse ms", "Binary MB", "Map ms", "Stream ms", "Chunks", "Longest ms");
+
+	for (size_t entityCount : { (size_t)10000, (size_t)100000 }) {
+		SceneLoadTimings t = SceneFile::Measure(entityCount, L"SceneLoadTest.scene", L"SceneLoadTest.scenebin");
+		if (!t.Error.empty()) {
+			printf("%8zu %s\n", entityCount, t.Error.c_str());
+			continue;
+		}
+
+		printf("%8zu %10.2f %10.2f %10.2f %10.3f %10.2f %8u %12.3f\n",
+			t.EntityCount, t.TextBytes / (1024.0 * 1024.0), t.TextParseMilliseconds,
+			t.BinaryBytes / (1024.0 * 1024.0), t.BinaryMapMilliseconds,
+			t.StreamMilliseconds, t.ChunkCount, t.LongestChunkMilliseconds);
+	}
+}
+
+struct Benchmark {
+	const char* Name;
+	void (*Run)();
+};
+
+static const Benchmark benchmarks[] = {
+	{ "BenchmarkSuite", BenchmarkSuiteScenes },
+	{ "JobSystem", BenchmarkJobSystem },
+	{ "LightBinning", BenchmarkLightBinning },
+	{ "LightCulling", BenchmarkLightCulling },
+	{ "ProfilerZones", BenchmarkProfilerZones },
+	{ "RayCasts", BenchmarkRayCasts },
+	{ "SceneBvh", BenchmarkSceneBvh },
+	{ "SceneLoad", BenchmarkSceneLoad },
+};
+
+// --------------------------------------------------------
+// Runs every benchmark whose name starts with the first
+// argument, or all of them
+// --------------------------------------------------------
+int main(int argc, char** argv) {
+	setvbuf(stdout, 0, _IONBF, 0);
+	const char* prefix = argc > 1 ? argv[1] : "";
+
+	for (const Benchmark& benchmark : benchmarks) {
+		if (strncmp(benchmark.Name, prefix, strlen(prefix)) != 0) continue;
+		benchmark.Run();
+		printf("\n");
+	}
+
+	return 0;
+}
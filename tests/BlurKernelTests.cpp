@@ -0,0 +1,125 @@
+#include "Test.h"
+
+#include <random>
+
+#include "../BlurReference.h"
+
+// Bilinear taps land between pixels, so they're exact up to
+// float rounding
+#define BLUR_TOLERANCE 1e-5f
+
+// --------------------------------------------------------
+// Random image with sizes that aren't multiples of the
+// compute shader's 256 pixel segments
+// --------------------------------------------------------
+static std::vector<float> MakeImage(int width, int height) {
+	std::mt19937 random(42);
+	std::uniform_real_distribution<float> value(0.0f, 1.0f);
+
+	std::vector<float> pixels(width * height);
+	for (float& p : pixels) p = value(random);
+	return pixels;
+}
+
+static float MaxDifference(const std::vector<float>& a, const std::vector<float>& b) {
+	float largest = 0.0f;
+	for (size_t i = 0; i < a.size(); i++) {
+		largest = (std::max)(largest, std::fabs(a[i] - b[i]));
+	}
+	return largest;
+}
+
+// --------------------------------------------------------
+// Both separable paths, horizontal then vertical, against
+// the full 2D filter for every radius the inspector allows
+// --------------------------------------------------------
+static void CheckSeparablePaths(BlurType type) {
+	const int width = 300;
+	const int height = 37;
+	std::vector<float> pixels = MakeImage(width, height);
+
+	for (int radius = 0; radius <= MAX_BLUR_RADIUS; radius++) {
+		BlurKernel kernel(type, radius);
+
+		std::vector<float> reference;
+		BlurReference::Filter(type, radius, pixels, width, height, reference);
+
+		std::vector<float> horizontal, result;
+		BlurReference::PixelShaderPass(kernel, pixels, width, height, true, horizontal);
+		BlurReference::PixelShaderPass(kernel, horizontal, width, height, false, result);
+		CHECK(MaxDifference(result, reference) <= BLUR_TOLERANCE);
+
+		BlurReference::ComputePass(kernel, pixels, width, height, true, horizontal);
+		BlurReference::ComputePass(kernel, horizontal, width, height, false, result);
+		CHECK(MaxDifference(result, reference) <= BLUR_TOLERANCE);
+	}
+}
+
+TEST(BlurKernelBoxMatchesReference) {
+	CheckSeparablePaths(BlurType::Box);
+}
+
+TEST(BlurKernelGaussianMatchesReference) {
+	CheckSeparablePaths(BlurType::Gaussian);
+}
+
+// --------------------------------------------------------
+// Every pixel's weights add up to one, whichever path
+// --------------------------------------------------------
+TEST(BlurKernelWeightsSumToOne) {
+	for (int type = 0; type < 2; type++) {
+		for (int radius = 0; radius <= MAX_BLUR_RADIUS; radius++) {
+			BlurKernel kernel((BlurType)type, radius);
+
+			float discrete = kernel.GetWeight(0);
+			for (int r = 1; r <= radius; r++) discrete += 2.0f * kernel.GetWeight(r);
+			CHECK_NEAR(discrete, 1.0f, 1e-6f);
+
+			float linear = kernel.GetCenterWeight();
+			const float* taps = kernel.GetLinearTaps();
+			for (int i = 0; i < kernel.GetLinearTapCount(); i++) linear += 2.0f * taps[i * 4 + 1];
+			CHECK_NEAR(linear, 1.0f, 1e-6f);
+
+			//Half as many fetches, rounded up
+			CHECK_EQUAL(kernel.GetLinearTapCount(), (radius + 1) / 2);
+		}
+	}
+}
+
+// --------------------------------------------------------
+// The "Copy To Screen" pass draws with an empty box kernel,
+// which has to leave every pixel exactly as it was
+// --------------------------------------------------------
+TEST(BlurKernelRadiusZeroCopies) {
+	const int width = 19;
+	const int height = 7;
+	std::vector<float> pixels = MakeImage(width, height);
+
+	BlurKernel kernel(BlurType::Box, 0);
+	CHECK_EQUAL(kernel.GetRadius(), 0);
+	CHECK_EQUAL(kernel.GetLinearTapCount(), 0);
+	CHECK_EQUAL(kernel.GetCenterWeight(), 1.0f);
+
+	float weights[(MAX_BLUR_RADIUS + 1) * 4];
+	kernel.GetWeights(weights);
+	CHECK_EQUAL(weights[0], 1.0f);
+	for (int i = 1; i < (MAX_BLUR_RADIUS + 1) * 4; i++) CHECK_EQUAL(weights[i], 0.0f);
+
+	const float* taps = kernel.GetLinearTaps();
+	for (int i = 0; i < MAX_BLUR_TAPS * 4; i++) CHECK_EQUAL(taps[i], 0.0f);
+
+	std::vector<float> copied;
+	BlurReference::PixelShaderPass(kernel, pixels, width, height, true, copied);
+	CHECK(copied == pixels);
+	BlurReference::ComputePass(kernel, pixels, width, height, false, copied);
+	CHECK(copied == pixels);
+}
+
+// --------------------------------------------------------
+// Radii outside what the shaders handle are clamped
+// --------------------------------------------------------
+TEST(BlurKernelClampsRadius) {
+	CHECK_EQUAL(BlurKernel(BlurType::Gaussian, -3).GetRadius(), 0);
+	CHECK_EQUAL(BlurKernel(BlurType::Gaussian, MAX_BLUR_RADIUS + 5).GetRadius(), MAX_BLUR_RADIUS);
+	CHECK_EQUAL(BlurKernel(BlurType::Box, MAX_BLUR_RADIUS + 5).GetLinearTapCount(), MAX_BLUR_TAPS);
+}
@@ -0,0 +1,286 @@
+#include "Test.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "../CommandTrace.h"
+#include "../RecordingRenderDevice.h"
+#include "../TraceReplayer.h"
+#include "../TraceWriter.h"
+
+using namespace CommandTrace;
+
+#define TEST_BUFFER_SIZE 64
+
+// --------------------------------------------------------
+// Keeps what each buffer update uploaded
+// --------------------------------------------------------
+class UploadObserver : public IRenderDeviceObserver {
+public:
+	std::vector<std::vector<uint8_t>> Uploads;
+
+	void OnResourceCreated(RecordType, uint32_t, const void*, size_t, const void*, size_t) override {}
+	void OnResourceDestroyed(RecordType, uint32_t) override {}
+	void OnInvalidateState() override {}
+	void OnFrameBegin() override {}
+
+	void OnCommand(const RenderCommand& command, const void* data) override {
+		if (command.Type != RenderCommandType::UpdateBuffer) return;
+		const uint8_t* bytes = (const uint8_t*)data;
+		Uploads.push_back(std::vector<uint8_t>(bytes, bytes + command.Count));
+	}
+};
+
+// --------------------------------------------------------
+// A cbuffer's worth of bytes, different for each seed
+// --------------------------------------------------------
+static std::vector<uint8_t> MakeContents(uint32_t size, uint8_t seed) {
+	std::vector<uint8_t> contents(size);
+	for (uint32_t i = 0; i < size; i++) contents[i] = (uint8_t)(i * 7 + seed);
+	return contents;
+}
+
+// --------------------------------------------------------
+// Encodes a copy against the last one, decodes it on top of
+// what the replay side had, and checks they match
+// --------------------------------------------------------
+static BufferEncoding RoundTrip(std::vector<uint8_t>& last, std::vector<uint8_t>& replayed, const std::vector<uint8_t>& current, size_t& encodedSize) {
+	std::vector<uint8_t> encoded;
+	BufferEncoding encoding = EncodeBufferCopy(last, current.data(), (uint32_t)current.size(), encoded);
+	encodedSize = encoded.size();
+
+	CHECK_EQUAL((BufferEncoding)encoded[0], encoding);
+	CHECK(DecodeBufferCopy(encoded.data(), encoded.size(), replayed));
+	CHECK(replayed == current);
+
+	last = current;
+	return encoding;
+}
+
+TEST(CommandTraceBufferCopies) {
+	std::vector<uint8_t> last, replayed;
+	size_t encodedSize;
+
+	//First copy has nothing to be a delta against
+	std::vector<uint8_t> current = MakeContents(TEST_BUFFER_SIZE, 1);
+	CHECK(RoundTrip(last, replayed, current, encodedSize) == BufferEncoding::Full);
+	CHECK_EQUAL(encodedSize, (size_t)1 + TEST_BUFFER_SIZE);
+
+	//Unchanged is an empty delta
+	CHECK(RoundTrip(last, replayed, current, encodedSize) == BufferEncoding::Delta);
+	CHECK_EQUAL(encodedSize, (size_t)1);
+
+	//Two runs, of one word and two words
+	current[8] ^= 0xFF;
+	current[36] ^= 0xFF;
+	current[43] ^= 0xFF;
+	CHECK(RoundTrip(last, replayed, current, encodedSize) == BufferEncoding::Delta);
+	CHECK_EQUAL(encodedSize, (size_t)1 + (4 + 4) + (4 + 8));
+
+	//A new size, like a shader reloaded with a bigger cbuffer
+	current = MakeContents(TEST_BUFFER_SIZE + 16, 2);
+	CHECK(RoundTrip(last, replayed, current, encodedSize) == BufferEncoding::Full);
+	CHECK_EQUAL(replayed.size(), (size_t)TEST_BUFFER_SIZE + 16);
+
+	//Then deltas against the new size
+	current[0] ^= 0xFF;
+	CHECK(RoundTrip(last, replayed, current, encodedSize) == BufferEncoding::Delta);
+
+	//Everything changed costs more as a delta
+	current = MakeContents(TEST_BUFFER_SIZE + 16, 3);
+	CHECK(RoundTrip(last, replayed, current, encodedSize) == BufferEncoding::Full);
+}
+
+TEST(CommandTraceDamagedCopies) {
+	std::vector<uint8_t> last = MakeContents(TEST_BUFFER_SIZE, 1);
+	std::vector<uint8_t> current = last;
+	current[20] ^= 0xFF;
+
+	std::vector<uint8_t> encoded;
+	CHECK(EncodeBufferCopy(last, current.data(), TEST_BUFFER_SIZE, encoded) == BufferEncoding::Delta);
+
+	//Nothing to apply a delta to
+	std::vector<uint8_t> empty;
+	CHECK(!DecodeBufferCopy(encoded.data(), encoded.size(), empty));
+
+	//Cut off partway through a run
+	std::vector<uint8_t> replayed = last;
+	CHECK(!DecodeBufferCopy(encoded.data(), encoded.size() - 1, replayed));
+
+	//A run past the end of the buffer
+	std::vector<uint8_t> small(8, 0);
+	CHECK(!DecodeBufferCopy(encoded.data(), encoded.size(), small));
+
+	//No encoding byte, or one that doesn't exist
+	CHECK(!DecodeBufferCopy(encoded.data(), 0, replayed));
+	uint8_t unknown = 7;
+	CHECK(!DecodeBufferCopy(&unknown, 1, replayed));
+}
+
+// --------------------------------------------------------
+// Builds traces in memory, the way the capture writes them
+// --------------------------------------------------------
+static void AppendBytes(std::vector<uint8_t>& output, const void* data, size_t size) {
+	output.insert(output.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+}
+
+template<typename T>
+static void AppendValue(std::vector<uint8_t>& output, const T& value) {
+	AppendBytes(output, &value, sizeof(value));
+}
+
+static void AppendRecord(std::vector<uint8_t>& trace, RecordType type, const std::vector<uint8_t>& payload) {
+	trace.push_back((uint8_t)type);
+	AppendValue(trace, (uint32_t)payload.size());
+	AppendBytes(trace, payload.data(), payload.size());
+}
+
+static std::vector<uint8_t> StartTrace() {
+	std::vector<uint8_t> trace;
+	uint32_t header[2] = { COMMAND_TRACE_MAGIC, COMMAND_TRACE_VERSION };
+	AppendBytes(trace, header, sizeof(header));
+
+	//One vertex shader with one cbuffer in slot 0
+	std::vector<uint8_t> shader;
+	uint32_t bytecode = 0xC0DE;
+	AppendValue(shader, (uint32_t)1);
+	AppendValue(shader, (uint32_t)ShaderStage::Vertex);
+	AppendValue(shader, (uint32_t)sizeof(bytecode));
+	AppendValue(shader, bytecode);
+	AppendValue(shader, (uint32_t)1);
+	uint32_t layout[2] = { TEST_BUFFER_SIZE, 0 };
+	AppendValue(shader, layout);
+	AppendRecord(trace, RecordType::SimpleShader, shader);
+
+	AppendRecord(trace, RecordType::FrameBegin, std::vector<uint8_t>(4, 0));
+
+	std::vector<uint8_t> set;
+	AppendValue(set, (uint32_t)1);
+	AppendRecord(trace, RecordType::SetSimpleShader, set);
+	return trace;
+}
+
+static void AppendCopy(std::vector<uint8_t>& trace, std::vector<uint8_t>& last, const std::vector<uint8_t>& current) {
+	std::vector<uint8_t> copy;
+	AppendValue(copy, (uint32_t)1);
+	AppendValue(copy, (uint32_t)0);
+	EncodeBufferCopy(last, current.data(), (uint32_t)current.size(), copy);
+	AppendRecord(trace, RecordType::CopySimpleBuffer, copy);
+	last = current;
+}
+
+// --------------------------------------------------------
+// Copies written the way the capture does come back out of
+// a replay byte for byte
+// --------------------------------------------------------
+static std::vector<std::vector<uint8_t>> ExpectedUploads(std::vector<uint8_t>& trace) {
+	std::vector<uint8_t> last;
+	std::vector<std::vector<uint8_t>> uploads;
+
+	std::vector<uint8_t> current = MakeContents(TEST_BUFFER_SIZE, 1);
+	AppendCopy(trace, last, current);
+	uploads.push_back(current);
+
+	AppendCopy(trace, last, current);
+	uploads.push_back(current);
+
+	AppendRecord(trace, RecordType::FrameBegin, std::vector<uint8_t>(4, 0));
+	current[4] ^= 0xFF;
+	current[60] ^= 0xFF;
+	AppendCopy(trace, last, current);
+	uploads.push_back(current);
+
+	return uploads;
+}
+
+static void CheckReplay(TraceReplayer& replayer, const std::vector<std::vector<uint8_t>>& expected) {
+	std::shared_ptr<UploadObserver> observer = std::make_shared<UploadObserver>();
+	RecordingRenderDevice device;
+	device.SetObserver(observer);
+
+	TraceReplayStats stats = replayer.Replay(device);
+	CHECK(stats.Completed);
+	CHECK_EQUAL(stats.Frames, 2u);
+	CHECK_EQUAL(stats.BufferCopies, 3u);
+	CHECK_EQUAL(stats.UnresolvedHandles, 0u);
+	CHECK(observer->Uploads == expected);
+}
+
+TEST(CommandTraceReplayCopies) {
+	std::vector<uint8_t> trace = StartTrace();
+	std::vector<std::vector<uint8_t>> expected = ExpectedUploads(trace);
+
+	TraceReplayer replayer;
+	CHECK(replayer.Load(trace));
+	CheckReplay(replayer, expected);
+
+	//Replays can be run again, from the start
+	CheckReplay(replayer, expected);
+}
+
+// --------------------------------------------------------
+// The replay's buffers can't change size, so a copy that
+// does stops it with an error
+// --------------------------------------------------------
+TEST(CommandTraceReplaySizeChange) {
+	std::vector<uint8_t> trace = StartTrace();
+	std::vector<uint8_t> last;
+	AppendCopy(trace, last, MakeContents(TEST_BUFFER_SIZE, 1));
+	AppendCopy(trace, last, MakeContents(TEST_BUFFER_SIZE + 16, 2));
+
+	TraceReplayer replayer;
+	CHECK(replayer.Load(trace));
+
+	RecordingRenderDevice device;
+	TraceReplayStats stats = replayer.Replay(device);
+	CHECK(!stats.Completed);
+	CHECK_EQUAL(stats.BufferCopies, 1u);
+	CHECK(!replayer.GetError().empty());
+}
+
+TEST(CommandTraceBadHeaders) {
+	TraceReplayer replayer;
+	CHECK(!replayer.Load(std::vector<uint8_t>(3, 0)));
+	CHECK(!replayer.IsLoaded());
+
+	std::vector<uint8_t> trace = StartTrace();
+	trace[4]++;
+	CHECK(!replayer.Load(trace));
+
+	//Records cut short
+	trace = StartTrace();
+	trace.pop_back();
+	CHECK(replayer.Load(trace));
+	RecordingRenderDevice device;
+	CHECK(!replayer.Replay(device).Completed);
+}
+
+// --------------------------------------------------------
+// Through the writer's thread to disk, and back in
+// --------------------------------------------------------
+TEST(CommandTraceFileRoundTrip) {
+	std::vector<uint8_t> trace = StartTrace();
+	std::vector<std::vector<uint8_t>> expected = ExpectedUploads(trace);
+
+	const wchar_t* path = L"CommandTraceFileRoundTrip.dxtrace";
+	TraceWriter writer;
+	CHECK(writer.Open(path));
+
+	//In small pieces, as the capture writes record by record
+	for (size_t offset = 0; offset < trace.size(); offset += 7) {
+		writer.Write(&trace[offset], (std::min)((size_t)7, trace.size() - offset));
+	}
+	writer.Close();
+	CHECK(!writer.HasFailed());
+	CHECK_EQUAL(writer.GetBytesWritten(), (uint64_t)trace.size());
+
+	TraceReplayer replayer;
+	CHECK(replayer.Load(std::wstring(path)));
+	CHECK_EQUAL(replayer.GetSize(), trace.size());
+	CheckReplay(replayer, expected);
+
+	std::remove("CommandTraceFileRoundTrip.dxtrace");
+}
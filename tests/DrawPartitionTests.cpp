@@ -0,0 +1,48 @@
+#include "Test.h"
+
+#include <vector>
+
+#include "../DrawPartition.h"
+
+// --------------------------------------------------------
+// Ranges cover every draw once, in order, and differ in
+// size by at most one
+// --------------------------------------------------------
+TEST(DrawPartitionCoversEveryDraw) {
+	std::vector<DrawRange> ranges;
+	size_t drawCounts[] = { 1, 15, 16, 17, 100, 1000, 1001 };
+	unsigned int rangeCounts[] = { 1, 2, 3, 8 };
+
+	for (size_t draws : drawCounts) {
+		for (unsigned int rangeCount : rangeCounts) {
+			DrawPartition::Split(draws, rangeCount, ranges);
+			CHECK(!ranges.empty());
+			CHECK(ranges.size() <= rangeCount);
+
+			size_t next = 0;
+			size_t smallest = draws, largest = 0;
+			for (const DrawRange& range : ranges) {
+				CHECK_EQUAL(range.Begin, next);
+				CHECK(range.End > range.Begin);
+				smallest = (std::min)(smallest, range.End - range.Begin);
+				largest = (std::max)(largest, range.End - range.Begin);
+				next = range.End;
+			}
+			CHECK_EQUAL(next, draws);
+			CHECK(largest - smallest <= 1);
+
+			//Only one range is allowed to be short, when there
+			//aren't enough draws for two
+			if (ranges.size() > 1) CHECK(smallest >= PARALLEL_DRAW_MIN_DRAWS);
+		}
+	}
+}
+
+TEST(DrawPartitionEmpty) {
+	std::vector<DrawRange> ranges = { { 0, 4 } };
+	DrawPartition::Split(0, 4, ranges);
+	CHECK(ranges.empty());
+
+	DrawPartition::Split(100, 0, ranges);
+	CHECK(ranges.empty());
+}
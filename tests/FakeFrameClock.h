@@ -0,0 +1,39 @@
+#pragma once
+
+#include "../FramePacer.h"
+
+// --------------------------------------------------------
+// A pretend clock for testing the frame pacer
+//
+// - Time only moves when the test says so, or when the
+//    pacer sleeps or spins on it
+// - Sleeps wake SleepLateness after they were asked to,
+//    like an OS sleep rounded up to the scheduler's tick
+// - Each spin moves SpinSeconds along, standing in for the
+//    time a busy wait loop takes
+// --------------------------------------------------------
+class FakeFrameClock : public FrameClock {
+public:
+	double Time = 1.0;
+	double SleepLateness = 0.0;
+	double SpinSeconds = 0.00001;
+
+	unsigned int Sleeps = 0;
+	unsigned int Spins = 0;
+	double SleptSeconds = 0.0;
+
+	double Now() override {
+		return Time;
+	}
+
+	void Sleep(double seconds) override {
+		Sleeps++;
+		SleptSeconds += seconds;
+		Time += seconds + SleepLateness;
+	}
+
+	void Spin() override {
+		Spins++;
+		Time += SpinSeconds;
+	}
+};
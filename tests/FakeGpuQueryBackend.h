@@ -0,0 +1,89 @@
+#pragma once
+
+#include <vector>
+
+#include "../GpuQueryBackend.h"
+
+// --------------------------------------------------------
+// A pretend GPU for testing the profiler
+//
+// - Ending a timestamp stamps it with Ticks, which the test
+//    moves along itself
+// - Nothing is ready until Complete() says the GPU caught
+//    up, like queries still sitting in the command buffer
+// - Counts reads, so tests can see a frame was only tried
+//    once and never waited on
+// --------------------------------------------------------
+class FakeGpuQueryBackend : public GpuQueryBackend {
+private:
+	struct Query {
+		GpuQueryType Type;
+		uint64_t Value;
+		bool Disjoint;
+		bool Ended;
+		bool Ready;
+	};
+
+	std::vector<Query> queries;
+
+	Query* Find(GpuQueryHandle handle) {
+		return (handle.Id == 0 || handle.Id > queries.size()) ? 0 : &queries[handle.Id - 1];
+	}
+
+public:
+	uint64_t Ticks = 0;
+	uint64_t Frequency = 1000000;	// Microsecond ticks
+	bool NextDisjoint = false;		// Whether disjoint queries ended now report a disjoint clock
+	unsigned int Reads = 0;
+
+	GpuQueryHandle CreateQuery(GpuQueryType type) override {
+		queries.push_back(Query{ type, 0, false, false, false });
+		GpuQueryHandle handle;
+		handle.Id = (uint32_t)queries.size();
+		return handle;
+	}
+
+	void Begin(GpuQueryHandle handle) override {
+		if (Query* query = Find(handle)) {
+			query->Ended = false;
+			query->Ready = false;
+		}
+	}
+
+	void End(GpuQueryHandle handle) override {
+		if (Query* query = Find(handle)) {
+			query->Value = Ticks;
+			query->Disjoint = NextDisjoint;
+			query->Ended = true;
+			query->Ready = false;
+		}
+	}
+
+	//Makes every query ended so far readable
+	void Complete() {
+		for (Query& query : queries) {
+			if (query.Ended) query.Ready = true;
+		}
+	}
+
+	bool GetTimestamp(GpuQueryHandle handle, uint64_t& ticks) override {
+		Reads++;
+		Query* query = Find(handle);
+		if (!query || query->Type != GpuQueryType::Timestamp || !query->Ready) return false;
+		ticks = query->Value;
+		return true;
+	}
+
+	bool GetDisjoint(GpuQueryHandle handle, uint64_t& frequency, bool& disjoint) override {
+		Reads++;
+		Query* query = Find(handle);
+		if (!query || query->Type != GpuQueryType::TimestampDisjoint || !query->Ready) return false;
+		frequency = Frequency;
+		disjoint = query->Disjoint;
+		return true;
+	}
+
+	unsigned int GetQueryCount() {
+		return (unsigned int)queries.size();
+	}
+};
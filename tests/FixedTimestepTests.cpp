@@ -0,0 +1,128 @@
+#include "Test.h"
+
+#include "../FixedTimestep.h"
+
+// --------------------------------------------------------
+// Runs a frame the way DXCore::Run() does, stepping as
+// many times as asked
+// --------------------------------------------------------
+static unsigned int RunFrame(FixedTimestep& timestep, double deltaSeconds) {
+	unsigned int steps = timestep.Advance(deltaSeconds);
+	for (unsigned int i = 0; i < steps; i++) timestep.StepFinished();
+	return steps;
+}
+
+// --------------------------------------------------------
+// Every bit of frame time ends up simulated, waiting in the
+// accumulator as the alpha, or dropped
+// --------------------------------------------------------
+static void CheckAccounting(FixedTimestep& timestep, double totalSeconds) {
+	double waiting = timestep.GetAlpha() * timestep.GetStepSeconds();
+	CHECK_NEAR(timestep.GetSimulationTime() + waiting + timestep.GetDroppedSeconds(), totalSeconds, 1e-9);
+	CHECK(timestep.GetAlpha() >= 0.0f && timestep.GetAlpha() <= 1.0f);
+}
+
+// --------------------------------------------------------
+// A faster display than the simulation steps most frames
+// zero times, and the steps add up to the time that passed
+// --------------------------------------------------------
+TEST(FixedTimestepFasterDisplay) {
+	FixedTimestep timestep(1.0 / 60.0, 5);
+	double total = 0.0;
+	unsigned int steps = 0;
+	unsigned int idleFrames = 0;
+
+	for (int frame = 0; frame < 144; frame++) {
+		unsigned int frameSteps = RunFrame(timestep, 1.0 / 144.0);
+		CHECK(frameSteps <= 1);
+		if (frameSteps == 0) idleFrames++;
+
+		steps += frameSteps;
+		total += 1.0 / 144.0;
+		CheckAccounting(timestep, total);
+	}
+
+	//A second of frames is 60 steps, give or take the last one
+	//rounding under
+	CHECK(steps == 59 || steps == 60);
+	CHECK_EQUAL(idleFrames, 144 - steps);
+	CHECK_NEAR(timestep.GetDroppedSeconds(), 0.0, 1e-12);
+}
+
+// --------------------------------------------------------
+// A slower display steps more than once a frame, and the
+// alpha follows the leftover time
+// --------------------------------------------------------
+TEST(FixedTimestepSlowerDisplay) {
+	FixedTimestep timestep(0.01, 5);
+
+	CHECK_EQUAL(RunFrame(timestep, 0.025), 2u);
+	CHECK_EQUAL(timestep.GetLastStepCount(), 2u);
+	CHECK_NEAR(timestep.GetAlpha(), 0.5, 1e-5);
+
+	CHECK_EQUAL(RunFrame(timestep, 0.025), 3u);
+	CHECK_NEAR(timestep.GetAlpha(), 0.0, 1e-5);
+	CHECK_NEAR(timestep.GetSimulationTime(), 0.05, 1e-12);
+
+	CheckAccounting(timestep, 0.05);
+}
+
+// --------------------------------------------------------
+// A hitch only runs maxSteps, drops whole steps past that,
+// and keeps the partial step so the alpha doesn't jump
+// --------------------------------------------------------
+TEST(FixedTimestepHitch) {
+	FixedTimestep timestep(0.01, 4);
+	RunFrame(timestep, 0.003);
+
+	CHECK_EQUAL(RunFrame(timestep, 1.0), 4u);
+	CHECK_NEAR(timestep.GetSimulationTime(), 0.04, 1e-12);
+	CHECK_NEAR(timestep.GetAlpha(), 0.3, 1e-4);
+	CHECK_NEAR(timestep.GetDroppedSeconds(), 0.96, 1e-9);
+	CheckAccounting(timestep, 1.003);
+
+	//Then carries on as normal
+	CHECK_EQUAL(RunFrame(timestep, 0.01), 1u);
+	CheckAccounting(timestep, 1.013);
+}
+
+// --------------------------------------------------------
+// Clocks can go backwards across a hitch or a debugger
+// break, which shouldn't take time off the accumulator
+// --------------------------------------------------------
+TEST(FixedTimestepNegativeDelta) {
+	FixedTimestep timestep(0.01, 5);
+	RunFrame(timestep, 0.005);
+
+	CHECK_EQUAL(RunFrame(timestep, -1.0), 0u);
+	CHECK_NEAR(timestep.GetAlpha(), 0.5, 1e-5);
+	CheckAccounting(timestep, 0.005);
+}
+
+TEST(FixedTimestepLimits) {
+	FixedTimestep timestep;
+
+	timestep.SetStepSeconds(0.0);
+	CHECK(timestep.GetStepSeconds() > 0.0);
+
+	timestep.SetMaxSteps(0);
+	CHECK_EQUAL(timestep.GetMaxSteps(), 1u);
+	CHECK_EQUAL(RunFrame(timestep, 1.0), 1u);
+}
+
+// --------------------------------------------------------
+// The constructor clamps like the setters, so a zero step
+// can't divide by zero and a zero step limit still steps
+// --------------------------------------------------------
+TEST(FixedTimestepConstructorLimits) {
+	FixedTimestep timestep(0.0, 0);
+
+	CHECK_EQUAL(timestep.GetStepSeconds(), 0.0001);
+	CHECK_EQUAL(timestep.GetMaxSteps(), 1u);
+	CHECK_EQUAL(RunFrame(timestep, 1.0), 1u);
+	CHECK(timestep.GetAlpha() >= 0.0f && timestep.GetAlpha() <= 1.0f);
+
+	FixedTimestep defaults;
+	CHECK_NEAR(defaults.GetStepSeconds(), 1.0 / 60.0, 1e-12);
+	CHECK_EQUAL(defaults.GetMaxSteps(), 5u);
+}
@@ -0,0 +1,165 @@
+#include "Test.h"
+
+#include <vector>
+
+#include "../FramePacer.h"
+#include "FakeFrameClock.h"
+
+// --------------------------------------------------------
+// Runs frames that each take the given work time before
+// waiting, and returns when each frame started
+// --------------------------------------------------------
+static std::vector<double> RunFrames(FramePacer& pacer, FakeFrameClock& clock, int count, double workSeconds) {
+	std::vector<double> starts;
+	for (int i = 0; i < count; i++) {
+		clock.Time += workSeconds;
+		pacer.Wait();
+		starts.push_back(clock.Time);
+	}
+	return starts;
+}
+
+// --------------------------------------------------------
+// Frames with time to spare start exactly a frame apart,
+// sleeping most of the wait and spinning only the tail
+// --------------------------------------------------------
+TEST(FramePacerSteadyFrames) {
+	FakeFrameClock clock;
+	FramePacer pacer(&clock, 0.002);
+	pacer.SetTargetFrameRate(60.0);
+
+	std::vector<double> starts = RunFrames(pacer, clock, 120, 0.005);
+
+	for (size_t i = 1; i < starts.size(); i++) {
+		CHECK_NEAR(starts[i] - starts[i - 1], 1.0 / 60.0, 2e-5);
+	}
+
+	//Deadlines step by exactly a frame, so they don't drift
+	CHECK_NEAR(starts.back() - starts.front(), 119.0 / 60.0, 2e-5);
+
+	CHECK_EQUAL(pacer.GetMissedDeadlines(), 0u);
+	CHECK_NEAR(pacer.GetAverageFrameTime(), 1000.0 / 60.0, 0.01);
+	CHECK(pacer.GetJitter() < 0.01f);
+	CHECK(pacer.GetMaxDeviation() < 0.02f);
+	CHECK(pacer.GetAverageWakeError() < 0.02f);
+
+	//Every frame but the first slept, and spun about 2ms
+	CHECK_EQUAL(clock.Sleeps, 119u);
+	CHECK_NEAR(clock.Spins / 119.0, 0.002 / clock.SpinSeconds, 2.0);
+}
+
+// --------------------------------------------------------
+// Sleeps waking late are covered by the spin, as long as
+// they're less late than the spin's head start
+// --------------------------------------------------------
+TEST(FramePacerLateSleeps) {
+	FakeFrameClock clock;
+	clock.SleepLateness = 0.0015;
+	FramePacer pacer(&clock, 0.002);
+	pacer.SetTargetFrameRate(100.0);
+
+	std::vector<double> starts = RunFrames(pacer, clock, 50, 0.003);
+	for (size_t i = 1; i < starts.size(); i++) {
+		CHECK_NEAR(starts[i] - starts[i - 1], 0.01, 2e-5);
+	}
+	CHECK(pacer.GetAverageWakeError() < 0.02f);
+
+	//Later than that, and every frame wakes late, but by the
+	//same amount, so the spacing still holds
+	clock.SleepLateness = 0.003;
+	starts = RunFrames(pacer, clock, 200, 0.003);
+	for (size_t i = 2; i < starts.size(); i++) {
+		CHECK_NEAR(starts[i] - starts[i - 1], 0.01, 2e-5);
+	}
+	CHECK_NEAR(pacer.GetAverageWakeError(), 1.0, 0.05);
+	CHECK_EQUAL(pacer.GetMissedDeadlines(), 0u);
+}
+
+// --------------------------------------------------------
+// A frame that overruns a little misses its deadline, and
+// the next one catches back up to the original schedule
+// --------------------------------------------------------
+TEST(FramePacerMissedDeadline) {
+	FakeFrameClock clock;
+	FramePacer pacer(&clock, 0.002);
+	pacer.SetTargetFrameRate(50.0);
+
+	std::vector<double> starts = RunFrames(pacer, clock, 10, 0.005);
+
+	clock.Time += 0.025;
+	pacer.Wait();
+	CHECK_EQUAL(pacer.GetMissedDeadlines(), 1u);
+	CHECK_NEAR(clock.Time - starts.back(), 0.025, 1e-9);
+
+	std::vector<double> after = RunFrames(pacer, clock, 5, 0.005);
+	CHECK_NEAR(after[0] - starts.back(), 0.04, 2e-5);
+	CHECK_NEAR(after[4] - starts.back(), 0.12, 2e-5);
+	CHECK_EQUAL(pacer.GetMissedDeadlines(), 1u);
+}
+
+// --------------------------------------------------------
+// A frame more than a whole frame late starts the schedule
+// over, rather than rushing frames out to catch up
+// --------------------------------------------------------
+TEST(FramePacerLongHitch) {
+	FakeFrameClock clock;
+	FramePacer pacer(&clock, 0.002);
+	pacer.SetTargetFrameRate(50.0);
+
+	RunFrames(pacer, clock, 10, 0.005);
+
+	clock.Time += 0.1;
+	pacer.Wait();
+	double hitchEnd = clock.Time;
+	CHECK_EQUAL(pacer.GetMissedDeadlines(), 1u);
+
+	std::vector<double> after = RunFrames(pacer, clock, 3, 0.001);
+	CHECK_NEAR(after[0] - hitchEnd, 0.02, 2e-5);
+	CHECK_NEAR(after[2] - hitchEnd, 0.06, 2e-5);
+	CHECK_EQUAL(pacer.GetMissedDeadlines(), 1u);
+}
+
+// --------------------------------------------------------
+// Without a limit it never waits, but still keeps stats,
+// measured against the average frame
+// --------------------------------------------------------
+TEST(FramePacerUnlimited) {
+	FakeFrameClock clock;
+	FramePacer pacer(&clock, 0.002);
+	pacer.SetTargetFrameRate(0.0);
+	CHECK_EQUAL(pacer.GetTargetFrameRate(), 0.0);
+
+	for (int i = 0; i < 11; i++) {
+		clock.Time += i % 2 ? 0.012 : 0.008;
+		pacer.Wait();
+	}
+
+	CHECK_EQUAL(clock.Sleeps, 0u);
+	CHECK_EQUAL(clock.Spins, 0u);
+	CHECK_EQUAL(pacer.GetHistoryCount(), 10);
+	CHECK_NEAR(pacer.GetAverageFrameTime(), 10.0, 1e-3);
+	CHECK_NEAR(pacer.GetMaxDeviation(), 2.0, 1e-3);
+	CHECK(pacer.GetJitter() > 2.0f);
+}
+
+// --------------------------------------------------------
+// The history is a ring, oldest at the offset once full
+// --------------------------------------------------------
+TEST(FramePacerHistory) {
+	FakeFrameClock clock;
+	FramePacer pacer(&clock, 0.002);
+
+	//Frame n takes n ms, counting from the first interval
+	pacer.Wait();
+	for (int i = 1; i <= FRAME_PACER_HISTORY + 10; i++) {
+		clock.Time += i * 0.001;
+		pacer.Wait();
+	}
+
+	CHECK_EQUAL(pacer.GetHistoryCount(), FRAME_PACER_HISTORY);
+	CHECK_EQUAL(pacer.GetHistoryOffset(), 10);
+
+	const std::vector<float>& history = pacer.GetFrameTimeHistory();
+	CHECK_NEAR(history[pacer.GetHistoryOffset()], 11.0, 1e-3);
+	CHECK_NEAR(history[(pacer.GetHistoryOffset() + FRAME_PACER_HISTORY - 1) % FRAME_PACER_HISTORY], FRAME_PACER_HISTORY + 10, 1e-2);
+}
@@ -0,0 +1,160 @@
+#include "Test.h"
+
+#include <cstring>
+
+#include "../GpuProfiler.h"
+#include "FakeGpuQueryBackend.h"
+
+// --------------------------------------------------------
+// Draws a frame with an outer scope that takes longer each
+// frame and a fixed inner scope, in microsecond ticks
+//  - Frame n's outer scope takes (n + 1) * 100 ticks, so
+//     results show which frame they came from
+// --------------------------------------------------------
+static void DrawFrame(GpuProfiler& profiler, FakeGpuQueryBackend& gpu, unsigned int frame) {
+	profiler.BeginFrame();
+	gpu.Ticks += 10;
+
+	int outer = profiler.BeginScope("Outer");
+	int inner = profiler.BeginScope("Inner");
+	gpu.Ticks += 50;
+	profiler.EndScope(inner);
+	gpu.Ticks += (frame + 1) * 100 - 50;
+	profiler.EndScope(outer);
+
+	gpu.Ticks += 10;
+	profiler.EndFrame();
+}
+
+static float OuterMilliseconds(unsigned int frame) {
+	return (frame + 1) * 0.1f;
+}
+
+// --------------------------------------------------------
+// Each BeginFrame() reads back the frame that last used the
+// same queries, GPU_PROFILER_FRAME_LATENCY frames earlier,
+// and the ring keeps reusing the same queries
+// --------------------------------------------------------
+TEST(GpuProfilerRingWraps) {
+	std::shared_ptr<FakeGpuQueryBackend> gpu = std::make_shared<FakeGpuQueryBackend>();
+	GpuProfiler profiler(gpu);
+
+	unsigned int queriesAfterFirstLap = 0;
+	for (unsigned int frame = 0; frame < GPU_PROFILER_FRAME_LATENCY * 3; frame++) {
+		DrawFrame(profiler, *gpu, frame);
+		gpu->Complete();
+
+		if (frame < GPU_PROFILER_FRAME_LATENCY) {
+			//Nothing has come back yet
+			CHECK(profiler.GetResults().empty());
+			queriesAfterFirstLap = gpu->GetQueryCount();
+			continue;
+		}
+
+		//Read back at this frame's BeginFrame()
+		unsigned int readFrame = frame - GPU_PROFILER_FRAME_LATENCY;
+		const std::vector<GpuScopeResult>& results = profiler.GetResults();
+		CHECK_EQUAL(results.size(), (size_t)2);
+		if (results.size() == 2) {
+			CHECK(strcmp(results[0].Name, "Outer") == 0);
+			CHECK_EQUAL(results[0].Depth, 0u);
+			CHECK_NEAR(results[0].Milliseconds, OuterMilliseconds(readFrame), 1e-5f);
+			CHECK(strcmp(results[1].Name, "Inner") == 0);
+			CHECK_EQUAL(results[1].Depth, 1u);
+			CHECK_NEAR(results[1].Milliseconds, 0.05f, 1e-5f);
+		}
+		CHECK_NEAR(profiler.GetFrameMilliseconds(), OuterMilliseconds(readFrame) + 0.02f, 1e-5f);
+	}
+
+	//3 frame queries plus 2 per scope, made once per slot
+	CHECK_EQUAL(queriesAfterFirstLap, (unsigned int)(GPU_PROFILER_FRAME_LATENCY * (3 + 2 * 2)));
+	CHECK_EQUAL(gpu->GetQueryCount(), queriesAfterFirstLap);
+	CHECK_EQUAL(profiler.GetFramesSkipped(), 0u);
+}
+
+// --------------------------------------------------------
+// A frame the GPU hasn't finished is skipped rather than
+// waited on, and the last good results stay up
+// --------------------------------------------------------
+TEST(GpuProfilerSkipsNotReady) {
+	std::shared_ptr<FakeGpuQueryBackend> gpu = std::make_shared<FakeGpuQueryBackend>();
+	GpuProfiler profiler(gpu);
+
+	//A lap the GPU keeps up with, then one it doesn't
+	unsigned int frame = 0;
+	for (; frame < GPU_PROFILER_FRAME_LATENCY; frame++) {
+		DrawFrame(profiler, *gpu, frame);
+		gpu->Complete();
+	}
+	for (; frame < GPU_PROFILER_FRAME_LATENCY * 2; frame++) {
+		DrawFrame(profiler, *gpu, frame);
+	}
+
+	//Each slot read back once as usual
+	CHECK_EQUAL(profiler.GetFramesSkipped(), 0u);
+	CHECK_NEAR(profiler.GetResults()[0].Milliseconds, OuterMilliseconds(GPU_PROFILER_FRAME_LATENCY - 1), 1e-5f);
+
+	//None of the second lap is ready, so each slot gives up
+	//after one read and keeps the old results
+	for (unsigned int i = 0; i < GPU_PROFILER_FRAME_LATENCY; i++, frame++) {
+		unsigned int readsBefore = gpu->Reads;
+		DrawFrame(profiler, *gpu, frame);
+		CHECK_EQUAL(gpu->Reads, readsBefore + 1);
+		CHECK_EQUAL(profiler.GetFramesSkipped(), i + 1);
+		CHECK_NEAR(profiler.GetResults()[0].Milliseconds, OuterMilliseconds(GPU_PROFILER_FRAME_LATENCY - 1), 1e-5f);
+	}
+
+	//Skipped frames aren't tried again, and once the GPU
+	//catches up the latest lap reads back normally
+	gpu->Complete();
+	unsigned int readFrame = frame - GPU_PROFILER_FRAME_LATENCY;
+	DrawFrame(profiler, *gpu, frame);
+	CHECK_EQUAL(profiler.GetFramesSkipped(), GPU_PROFILER_FRAME_LATENCY);
+	CHECK_NEAR(profiler.GetResults()[0].Milliseconds, OuterMilliseconds(readFrame), 1e-5f);
+}
+
+// --------------------------------------------------------
+// Frames where the GPU's clock changed can't be trusted, so
+// they're dropped even though every query is ready
+// --------------------------------------------------------
+TEST(GpuProfilerSkipsDisjoint) {
+	std::shared_ptr<FakeGpuQueryBackend> gpu = std::make_shared<FakeGpuQueryBackend>();
+	GpuProfiler profiler(gpu);
+
+	for (unsigned int frame = 0; frame < GPU_PROFILER_FRAME_LATENCY * 3; frame++) {
+		//Every other frame of the second lap is disjoint
+		gpu->NextDisjoint = frame >= GPU_PROFILER_FRAME_LATENCY && frame < GPU_PROFILER_FRAME_LATENCY * 2 && frame % 2 == 1;
+		DrawFrame(profiler, *gpu, frame);
+		gpu->Complete();
+
+		if (frame < GPU_PROFILER_FRAME_LATENCY * 2) continue;
+
+		//Disjoint frames leave the previous frame's results
+		unsigned int readFrame = frame - GPU_PROFILER_FRAME_LATENCY;
+		unsigned int shownFrame = (readFrame % 2 == 1 && readFrame < GPU_PROFILER_FRAME_LATENCY * 2) ? readFrame - 1 : readFrame;
+		CHECK_NEAR(profiler.GetResults()[0].Milliseconds, OuterMilliseconds(shownFrame), 1e-5f);
+	}
+
+	CHECK_EQUAL(profiler.GetFramesSkipped(), GPU_PROFILER_FRAME_LATENCY / 2);
+}
+
+// --------------------------------------------------------
+// Scopes outside a frame, or past the per frame limit, are
+// ignored without unbalancing the rest
+// --------------------------------------------------------
+TEST(GpuProfilerScopeLimits) {
+	std::shared_ptr<FakeGpuQueryBackend> gpu = std::make_shared<FakeGpuQueryBackend>();
+	GpuProfiler profiler(gpu);
+
+	CHECK_EQUAL(profiler.BeginScope("Outside"), -1);
+	profiler.EndScope(-1);
+
+	profiler.BeginFrame();
+	for (int i = 0; i < GPU_PROFILER_MAX_SCOPES; i++) {
+		int scope = profiler.BeginScope("Scope");
+		CHECK_EQUAL(scope, i);
+		profiler.EndScope(scope);
+	}
+	CHECK_EQUAL(profiler.BeginScope("One Too Many"), -1);
+	profiler.EndFrame();
+}
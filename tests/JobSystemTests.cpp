@@ -0,0 +1,194 @@
+#include "Test.h"
+
+#include <atomic>
+#include <thread>
+
+#include "../JobSystem.h"
+
+// Workers on top of the main thread, more than this machine
+// may have cores, so threads get swapped out mid-operation
+#define STRESS_WORKERS 7
+
+// --------------------------------------------------------
+// The owner pushes and pops while thieves steal, and every
+// job has to come out exactly once
+//  - Pushing in bursts keeps the deque near empty, where the
+//     owner and thieves race for the last job
+// --------------------------------------------------------
+TEST(JobSystemDequeStress) {
+	const int jobCount = 200000;
+	const int thiefCount = 4;
+
+	std::vector<Job> jobs(jobCount);
+	std::vector<std::atomic<int>> taken(jobCount);
+	for (std::atomic<int>& t : taken) t.store(0);
+
+	JobDeque deque;
+	std::atomic<bool> done(false);
+	std::atomic<int> stolen(0);
+
+	auto take = [&](Job* job) {
+		taken[job - jobs.data()].fetch_add(1, std::memory_order_relaxed);
+	};
+
+	std::vector<std::thread> thieves;
+	for (int i = 0; i < thiefCount; i++) {
+		thieves.push_back(std::thread([&]() {
+			while (!done.load()) {
+				if (Job* job = deque.Steal()) {
+					take(job);
+					stolen.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+		}));
+	}
+
+	int pushed = 0;
+	while (pushed < jobCount) {
+		int burst = (pushed / 7) % 5 + 1;
+		for (int i = 0; i < burst && pushed < jobCount; i++) {
+			if (deque.Push(&jobs[pushed])) pushed++;
+		}
+
+		if (Job* job = deque.Pop()) take(job);
+	}
+
+	while (Job* job = deque.Pop()) take(job);
+
+	done.store(true);
+	for (std::thread& thief : thieves) thief.join();
+
+	int wrong = 0;
+	for (std::atomic<int>& t : taken) {
+		if (t.load() != 1) wrong++;
+	}
+	CHECK_EQUAL(wrong, 0);
+	CHECK(deque.Pop() == 0);
+	CHECK(deque.Steal() == 0);
+}
+
+// --------------------------------------------------------
+// A full deque refuses pushes instead of overwriting
+// --------------------------------------------------------
+TEST(JobSystemDequeCapacity) {
+	std::vector<Job> jobs(JOB_DEQUE_CAPACITY + 1);
+	JobDeque deque;
+
+	for (int i = 0; i < JOB_DEQUE_CAPACITY; i++) CHECK(deque.Push(&jobs[i]));
+	CHECK(!deque.Push(&jobs[JOB_DEQUE_CAPACITY]));
+
+	//Thieves take the oldest, the owner the newest
+	CHECK(deque.Steal() == &jobs[0]);
+	CHECK(deque.Pop() == &jobs[JOB_DEQUE_CAPACITY - 1]);
+	CHECK(deque.Push(&jobs[JOB_DEQUE_CAPACITY]));
+}
+
+// --------------------------------------------------------
+// Parallel fors inside parallel fors, so waiting threads
+// have to help with other jobs rather than block
+// --------------------------------------------------------
+TEST(JobSystemParallelForStress) {
+	JobSystem& jobs = JobSystem::GetInstance();
+	jobs.Initialize(STRESS_WORKERS);
+
+	for (int round = 0; round < 20; round++) {
+		const size_t outer = 64;
+		const size_t inner = 1000;
+		std::vector<std::atomic<int>> visits(outer * inner);
+		for (std::atomic<int>& v : visits) v.store(0);
+
+		jobs.ParallelFor(outer, 1 + round % 3, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				jobs.ParallelFor(inner, 1 + round * 7, [&, i](size_t innerBegin, size_t innerEnd) {
+					for (size_t j = innerBegin; j < innerEnd; j++) {
+						visits[i * inner + j].fetch_add(1, std::memory_order_relaxed);
+					}
+				});
+			}
+		});
+
+		int wrong = 0;
+		for (std::atomic<int>& v : visits) {
+			if (v.load() != 1) wrong++;
+		}
+		CHECK_EQUAL(wrong, 0);
+	}
+
+	//Grain sizes of zero and past the count
+	std::atomic<size_t> sum(0);
+	jobs.ParallelFor(1000, 0, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) sum += i;
+	});
+	jobs.ParallelFor(10, 100, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) sum += i;
+	});
+	CHECK_EQUAL(sum.load(), (size_t)(999 * 1000 / 2 + 45));
+
+	jobs.ShutDown();
+}
+
+// --------------------------------------------------------
+// Counters only finish once every job counted on them has,
+// including jobs those jobs queued
+// --------------------------------------------------------
+TEST(JobSystemCounters) {
+	JobSystem& jobs = JobSystem::GetInstance();
+	jobs.Initialize(STRESS_WORKERS);
+
+	std::atomic<int> finished(0);
+	JobCounter counter;
+	for (int i = 0; i < 500; i++) {
+		jobs.Run([&]() {
+			JobCounter children;
+			for (int c = 0; c < 4; c++) {
+				jobs.Run([&]() { finished.fetch_add(1); }, &children);
+			}
+			jobs.Wait(children);
+			finished.fetch_add(1);
+		}, &counter);
+	}
+	jobs.Wait(counter);
+
+	CHECK(counter.IsDone());
+	CHECK_EQUAL(finished.load(), 500 * 5);
+
+	//Threads outside the job system run jobs straight away
+	std::atomic<int> inline_(0);
+	std::thread outside([&]() {
+		JobCounter outsideCounter;
+		jobs.Run([&]() { inline_.fetch_add(1); }, &outsideCounter);
+		inline_.fetch_add(outsideCounter.IsDone() ? 10 : 0);
+	});
+	outside.join();
+	CHECK_EQUAL(inline_.load(), 11);
+
+	jobs.ShutDown();
+}
+
+// --------------------------------------------------------
+// Jobs that need the main thread get run by it while it
+// waits, even when queued from workers
+// --------------------------------------------------------
+TEST(JobSystemMainThreadJobs) {
+	JobSystem& jobs = JobSystem::GetInstance();
+	jobs.Initialize(STRESS_WORKERS);
+
+	std::atomic<int> onMain(0);
+	std::atomic<int> offMain(0);
+	JobCounter counter;
+	for (int i = 0; i < 200; i++) {
+		jobs.Run([&]() {
+			JobCounter mainCounter;
+			jobs.RunOnMainThread([&]() {
+				(jobs.IsMainThread() ? onMain : offMain).fetch_add(1);
+			}, &mainCounter);
+			jobs.Wait(mainCounter);
+		}, &counter);
+	}
+	jobs.Wait(counter);
+
+	CHECK_EQUAL(onMain.load(), 200);
+	CHECK_EQUAL(offMain.load(), 0);
+
+	jobs.ShutDown();
+}
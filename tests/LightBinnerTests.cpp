@@ -0,0 +1,254 @@
+#include "Test.h"
+
+#include <algorithm>
+#include <random>
+
+#include "../JobSystem.h"
+#include "../LightBinner.h"
+
+// A 16:9 camera with a 90 degree vertical field of view
+#define TEST_SCALE_Y 1.0f
+#define TEST_SCALE_X (TEST_SCALE_Y * 9.0f / 16.0f)
+#define TEST_NEAR 0.1f
+#define TEST_FAR 100.0f
+
+static BinnedLight MakePointLight(float x, float y, float z, float radius) {
+	BinnedLight light = {};
+	light.Center[0] = light.Apex[0] = x;
+	light.Center[1] = light.Apex[1] = y;
+	light.Center[2] = light.Apex[2] = z;
+	light.Radius = radius;
+	light.Range = radius;
+	return light;
+}
+
+// --------------------------------------------------------
+// A spot light with its bounds around the whole cone, the
+// way LightCuller::CreateSpotVolume() builds them
+// --------------------------------------------------------
+static BinnedLight MakeSpotLight(const float apex[3], const float direction[3], float range, float angle) {
+	BinnedLight light = {};
+	light.IsSpot = true;
+	light.Range = range;
+	light.CosAngle = cosf(angle);
+	light.SinAngle = sinf(angle);
+
+	float length = sqrtf(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+	for (int c = 0; c < 3; c++) {
+		light.Apex[c] = apex[c];
+		light.Direction[c] = direction[c] / length;
+	}
+
+	//Narrow cones fit a sphere through the rim, wide ones one
+	//around the rim's circle
+	if (light.CosAngle >= 0.70710678f) {
+		float radius = range / (2.0f * light.CosAngle);
+		for (int c = 0; c < 3; c++) light.Center[c] = apex[c] + light.Direction[c] * radius;
+		light.Radius = radius;
+	} else {
+		for (int c = 0; c < 3; c++) light.Center[c] = apex[c] + light.Direction[c] * range * light.CosAngle;
+		light.Radius = range * light.SinAngle;
+	}
+	return light;
+}
+
+// --------------------------------------------------------
+// One light against one cluster, a scalar copy of what the
+// binner does four at a time
+// --------------------------------------------------------
+static bool Touches(const ClusterBounds& cluster, const BinnedLight& light) {
+	float distSquared = 0.0f;
+	for (int c = 0; c < 3; c++) {
+		float d = (std::max)((std::max)(cluster.Min[c] - light.Center[c], light.Center[c] - cluster.Max[c]), 0.0f);
+		distSquared += d * d;
+	}
+	if (!(distSquared <= light.Radius * light.Radius)) return false;
+	if (!light.IsSpot) return true;
+
+	float to[3] = { cluster.Center[0] - light.Apex[0], cluster.Center[1] - light.Apex[1], cluster.Center[2] - light.Apex[2] };
+	float lengthSquared = to[0] * to[0] + to[1] * to[1] + to[2] * to[2];
+	float alongAxis = to[0] * light.Direction[0] + to[1] * light.Direction[1] + to[2] * light.Direction[2];
+	float offAxis = sqrtf((std::max)(lengthSquared - alongAxis * alongAxis, 0.0f));
+	float closestDistance = light.CosAngle * offAxis - alongAxis * light.SinAngle;
+
+	return !(closestDistance > cluster.Radius || alongAxis > cluster.Radius + light.Range || alongAxis < -cluster.Radius);
+}
+
+static std::vector<unsigned int> ClusterLights(const std::vector<ClusterRange>& ranges, const std::vector<unsigned int>& indices, unsigned int cluster) {
+	std::vector<unsigned int> lights(indices.begin() + ranges[cluster].Offset, indices.begin() + ranges[cluster].Offset + ranges[cluster].Count);
+	std::sort(lights.begin(), lights.end());
+	return lights;
+}
+
+// --------------------------------------------------------
+// Thousands of random point and spot lights, binned over
+// the job system, against testing every light against
+// every cluster one at a time
+// --------------------------------------------------------
+TEST(LightBinnerMatchesBruteForce) {
+	JobSystem::GetInstance().Initialize(3);
+
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> across(-60.0f, 60.0f);
+	std::uniform_real_distribution<float> depth(-10.0f, 110.0f);
+	std::uniform_real_distribution<float> size(0.5f, 8.0f);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> angle(0.1f, 1.2f);
+
+	std::vector<BinnedLight> lights;
+	for (int i = 0; i < 4000; i++) {
+		float position[3] = { across(random), across(random) * 0.6f, depth(random) };
+		if (i % 3 == 0) {
+			float direction[3] = { unit(random), unit(random), unit(random) + 0.01f };
+			lights.push_back(MakeSpotLight(position, direction, size(random) * 2.0f, angle(random)));
+		} else {
+			lights.push_back(MakePointLight(position[0], position[1], position[2], size(random)));
+		}
+	}
+
+	LightBinner binner;
+	binner.SetProjection(TEST_SCALE_X, TEST_SCALE_Y, TEST_NEAR, TEST_FAR);
+
+	const unsigned int indexOffset = 3;
+	std::vector<ClusterRange> ranges;
+	std::vector<unsigned int> indices;
+	binner.Bin(lights.data(), (unsigned int)lights.size(), indexOffset, ranges, indices);
+	CHECK_EQUAL(ranges.size(), (size_t)CLUSTER_COUNT);
+
+	unsigned int mismatches = 0;
+	unsigned int expectedTotal = 0;
+	unsigned int largest = 0;
+	for (unsigned int cluster = 0; cluster < CLUSTER_COUNT; cluster++) {
+		const ClusterBounds& bounds = binner.GetClusterBounds(cluster);
+
+		std::vector<unsigned int> expected;
+		for (unsigned int i = 0; i < lights.size(); i++) {
+			if (Touches(bounds, lights[i])) expected.push_back(indexOffset + i);
+		}
+
+		if (ClusterLights(ranges, indices, cluster) != expected) mismatches++;
+		expectedTotal += (unsigned int)expected.size();
+		largest = (std::max)(largest, (unsigned int)expected.size());
+	}
+
+	CHECK_EQUAL(mismatches, 0u);
+	CHECK_EQUAL(indices.size(), (size_t)expectedTotal);
+	CHECK_EQUAL(binner.GetMaxLightsPerCluster(), largest);
+	CHECK(expectedTotal > 0);
+
+	//Binning again with the same lights gives the same lists
+	std::vector<ClusterRange> againRanges;
+	std::vector<unsigned int> againIndices;
+	binner.Bin(lights.data(), (unsigned int)lights.size(), indexOffset, againRanges, againIndices);
+	CHECK(againIndices == indices);
+
+	JobSystem::GetInstance().ShutDown();
+}
+
+// --------------------------------------------------------
+// Slices get exponentially thicker, and the grid covers the
+// view frustum between the near and far planes
+// --------------------------------------------------------
+TEST(LightBinnerClusterBounds) {
+	LightBinner binner;
+	binner.SetProjection(TEST_SCALE_X, TEST_SCALE_Y, TEST_NEAR, TEST_FAR);
+
+	const ClusterBounds& nearest = binner.GetClusterBounds(0);
+	const ClusterBounds& farthest = binner.GetClusterBounds(CLUSTER_COUNT - 1);
+	CHECK_NEAR(nearest.Min[2], TEST_NEAR, 1e-6f);
+	CHECK_NEAR(farthest.Max[2], TEST_FAR, 1e-3f);
+
+	//Every slice is the same ratio deeper than the last
+	float ratio = powf(TEST_FAR / TEST_NEAR, 1.0f / CLUSTER_COUNT_Z);
+	for (int z = 0; z < CLUSTER_COUNT_Z; z++) {
+		const ClusterBounds& bounds = binner.GetClusterBounds(z * CLUSTER_COUNT_X * CLUSTER_COUNT_Y);
+		CHECK_NEAR(bounds.Max[2] / bounds.Min[2], ratio, 1e-4f);
+
+		//Depths in the middle of the slice land in it
+		CHECK_EQUAL(binner.GetSlice(sqrtf(bounds.Min[2] * bounds.Max[2])), z);
+	}
+
+	//Tile 0 is the top left of the screen, reaching the edge
+	//of the frustum at the far end of the slice
+	const ClusterBounds& topLeft = binner.GetClusterBounds(CLUSTER_COUNT_X * CLUSTER_COUNT_Y * (CLUSTER_COUNT_Z - 1));
+	CHECK_NEAR(topLeft.Min[0], -farthest.Max[2] / TEST_SCALE_X, 1e-2f);
+	CHECK_NEAR(topLeft.Max[1], farthest.Max[2] / TEST_SCALE_Y, 1e-2f);
+
+	//Depths outside the grid clamp to its ends
+	CHECK_EQUAL(binner.GetSlice(0.0f), 0);
+	CHECK_EQUAL(binner.GetSlice(TEST_FAR * 10.0f), CLUSTER_COUNT_Z - 1);
+}
+
+// --------------------------------------------------------
+// Lights behind the camera or past the far plane reach no
+// cluster, and one around the camera reaches the nearest
+// slice everywhere on screen
+// --------------------------------------------------------
+TEST(LightBinnerCullsOutsideGrid) {
+	JobSystem::GetInstance().Initialize(3);
+
+	LightBinner binner;
+	binner.SetProjection(TEST_SCALE_X, TEST_SCALE_Y, TEST_NEAR, TEST_FAR);
+
+	BinnedLight lights[3] = {
+		MakePointLight(0.0f, 0.0f, -5.0f, 2.0f),
+		MakePointLight(0.0f, 0.0f, TEST_FAR + 5.0f, 2.0f),
+		MakePointLight(0.0f, 0.0f, 0.0f, 1.0f)
+	};
+
+	std::vector<ClusterRange> ranges;
+	std::vector<unsigned int> indices;
+	binner.Bin(lights, 3, 0, ranges, indices);
+
+	CHECK(std::find(indices.begin(), indices.end(), 0u) == indices.end());
+	CHECK(std::find(indices.begin(), indices.end(), 1u) == indices.end());
+
+	for (unsigned int tile = 0; tile < CLUSTER_COUNT_X * CLUSTER_COUNT_Y; tile++) {
+		CHECK(ClusterLights(ranges, indices, tile) == std::vector<unsigned int>({ 2 }));
+	}
+
+	//Past its radius it's gone
+	CHECK(ClusterLights(ranges, indices, CLUSTER_COUNT - 1).empty());
+
+	JobSystem::GetInstance().ShutDown();
+}
+
+// --------------------------------------------------------
+// A narrow spot light's bounding sphere covers clusters its
+// cone doesn't, and those are left out
+// --------------------------------------------------------
+TEST(LightBinnerSpotLightUsesCone) {
+	JobSystem::GetInstance().Initialize(3);
+
+	LightBinner binner;
+	binner.SetProjection(TEST_SCALE_X, TEST_SCALE_Y, TEST_NEAR, TEST_FAR);
+
+	//Straight down the view direction from the camera
+	float apex[3] = { 0.0f, 0.0f, 0.0f };
+	float forward[3] = { 0.0f, 0.0f, 1.0f };
+	BinnedLight spot = MakeSpotLight(apex, forward, 50.0f, 0.05f);
+
+	std::vector<ClusterRange> ranges;
+	std::vector<unsigned int> indices;
+	binner.Bin(&spot, 1, 0, ranges, indices);
+
+	unsigned int sphereClusters = 0;
+	for (unsigned int cluster = 0; cluster < CLUSTER_COUNT; cluster++) {
+		const ClusterBounds& bounds = binner.GetClusterBounds(cluster);
+		BinnedLight sphere = spot;
+		sphere.IsSpot = false;
+		if (Touches(bounds, sphere)) sphereClusters++;
+
+		//The corners of the screen are well outside the cone
+		int x = cluster % CLUSTER_COUNT_X;
+		int y = (cluster / CLUSTER_COUNT_X) % CLUSTER_COUNT_Y;
+		if ((x == 0 || x == CLUSTER_COUNT_X - 1) && (y == 0 || y == CLUSTER_COUNT_Y - 1)) {
+			CHECK_EQUAL(ranges[cluster].Count, 0u);
+		}
+	}
+
+	CHECK(indices.size() > 0);
+	CHECK(indices.size() < sphereClusters);
+
+	JobSystem::GetInstance().ShutDown();
+}
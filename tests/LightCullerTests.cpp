@@ -0,0 +1,168 @@
+#include "Test.h"
+
+#include <algorithm>
+
+#include "../LightBinner.h"
+#include "../LightCuller.h"
+
+// Falloff whose cone ends at the given half angle
+static float GetFalloff(float angle) {
+	return logf(SPOT_LIGHT_CUTOFF) / logf(cosf(angle));
+}
+
+static BinnedLight ToBinnedLight(const LightVolume& volume) {
+	BinnedLight light = {};
+	for (int c = 0; c < 3; c++) {
+		light.Center[c] = volume.Center[c];
+		light.Apex[c] = volume.Position[c];
+		light.Direction[c] = volume.Direction[c];
+	}
+	light.Radius = volume.Radius;
+	light.CosAngle = volume.CosAngle;
+	light.SinAngle = volume.SinAngle;
+	light.Range = volume.Range;
+	light.IsSpot = volume.IsSpot;
+	return light;
+}
+
+static bool Reaches(LightCuller& culler, const float center[3], const float extents[3]) {
+	std::vector<unsigned int> indices;
+	return culler.Cull(center, extents, indices) == 1 && indices[0] == 0;
+}
+
+// --------------------------------------------------------
+// Spot volumes fit around their cones, and the cone angle
+// comes back out of the falloff
+// --------------------------------------------------------
+TEST(LightCullerSpotVolume) {
+	const float position[3] = { 1.0f, 2.0f, 3.0f };
+	const float direction[3] = { 0.0f, 0.0f, 2.0f };
+
+	for (float angle : { 0.2f, 0.7f, 1.2f }) {
+		LightVolume volume = LightCuller::CreateSpotVolume(position, direction, 10.0f, GetFalloff(angle));
+		CHECK(volume.IsSpot);
+		CHECK_NEAR(volume.CosAngle, cosf(angle), 1e-4f);
+		CHECK_NEAR(volume.Direction[2], 1.0f, 1e-6f);
+
+		//The tip, and the rim where the cone ends
+		float rim[3] = { position[0] + sinf(angle) * 10.0f, position[1], position[2] + cosf(angle) * 10.0f };
+		for (const float* point : { position, (const float*)rim }) {
+			float distSquared = 0.0f;
+			for (int c = 0; c < 3; c++) distSquared += (point[c] - volume.Center[c]) * (point[c] - volume.Center[c]);
+			CHECK(sqrtf(distSquared) <= volume.Radius + 1e-4f);
+		}
+	}
+
+	LightVolume point = LightCuller::CreatePointVolume(position, 4.0f);
+	CHECK(!point.IsSpot);
+	CHECK_EQUAL(point.Radius, 4.0f);
+	CHECK_EQUAL(point.Center[2], 3.0f);
+}
+
+// --------------------------------------------------------
+// A narrow cone down +z from the origin, against small boxes
+// just inside and just outside its edge, past its end and
+// behind its tip
+// --------------------------------------------------------
+TEST(LightCullerSpotCone) {
+	const float angle = 0.3f;
+	const float position[3] = { 0.0f, 0.0f, 0.0f };
+	const float direction[3] = { 0.0f, 0.0f, 1.0f };
+	LightVolume volume = LightCuller::CreateSpotVolume(position, direction, 10.0f, GetFalloff(angle));
+
+	LightCuller culler;
+	culler.SetVolumes(&volume, 1);
+
+	const float extents[3] = { 0.1f, 0.1f, 0.1f };
+	const float edge = tanf(angle) * 5.0f;
+	const float inside[3] = { edge - 0.2f, 0.0f, 5.0f };
+	const float straddling[3] = { edge, 0.0f, 5.0f };
+	const float outside[3] = { edge + 0.3f, 0.0f, 5.0f };
+	const float pastEnd[3] = { 0.0f, 0.0f, 10.3f };
+	const float behind[3] = { 0.0f, 0.0f, -0.3f };
+
+	CHECK(Reaches(culler, inside, extents));
+	CHECK(Reaches(culler, straddling, extents));
+	CHECK(!Reaches(culler, outside, extents));
+	CHECK(!Reaches(culler, pastEnd, extents));
+	CHECK(!Reaches(culler, behind, extents));
+
+	//The box's sphere is tested, so a big enough box reaches in
+	const float bigExtents[3] = { 0.5f, 0.5f, 0.5f };
+	CHECK(Reaches(culler, outside, bigExtents));
+
+	CHECK_EQUAL(culler.GetTestsRun(), 6u);
+	CHECK_EQUAL(culler.GetLightsCulled(), 3u);
+}
+
+// --------------------------------------------------------
+// Spot cones aimed straight down the edges and corners
+// between clusters
+//  - Every cluster on both sides of the edge gets the light,
+//     and the culler agrees with the binner about every
+//     cluster in the grid
+// --------------------------------------------------------
+TEST(LightCullerSpotsStraddlingClusters) {
+	LightBinner binner;
+	binner.SetProjection(9.0f / 16.0f, 1.0f, 0.1f, 100.0f);
+
+	const int tileX = CLUSTER_COUNT_X / 2;
+	const int tileY = CLUSTER_COUNT_Y / 2;
+	const int slice = 12;
+	const ClusterBounds& cluster = binner.GetClusterBounds(tileX + tileY * CLUSTER_COUNT_X + slice * CLUSTER_COUNT_X * CLUSTER_COUNT_Y);
+	float depth = (cluster.Min[2] + cluster.Max[2]) * 0.5f;
+
+	//Where the cluster's tile meets the next one over, and the corner it shares with three
+	// - Tile edges are planes through the eye, so the lights sit on them
+	float edgeX = cluster.Max[0] * depth / cluster.Max[2];
+	float edgeY = cluster.Max[1] * depth / cluster.Max[2];
+
+	//Whichever row is above this one
+	const ClusterBounds& other = binner.GetClusterBounds(tileX + (tileY + 1) * CLUSTER_COUNT_X + slice * CLUSTER_COUNT_X * CLUSTER_COUNT_Y);
+	int nextY = other.Max[1] > cluster.Max[1] ? tileY + 1 : tileY - 1;
+	float edges[2][3] = {
+		{ edgeX, (cluster.Min[1] + cluster.Max[1]) * 0.5f * depth / cluster.Max[2], depth },
+		{ edgeX, edgeY, depth },
+	};
+
+	for (const float* target : edges) {
+		//From a little nearer than the cluster, looking straight through the target
+		float length = sqrtf(target[0] * target[0] + target[1] * target[1] + target[2] * target[2]);
+		float direction[3] = { target[0] / length, target[1] / length, target[2] / length };
+		float apex[3] = { target[0] - direction[0] * 2.0f, target[1] - direction[1] * 2.0f, target[2] - direction[2] * 2.0f };
+
+		LightVolume volume = LightCuller::CreateSpotVolume(apex, direction, 4.0f, GetFalloff(0.05f));
+		BinnedLight light = ToBinnedLight(volume);
+
+		std::vector<ClusterRange> ranges;
+		std::vector<unsigned int> indices;
+		binner.Bin(&light, 1, 0, ranges, indices);
+
+		LightCuller culler;
+		culler.SetVolumes(&volume, 1);
+
+		unsigned int mismatches = 0;
+		std::vector<bool> binned(CLUSTER_COUNT);
+		for (unsigned int i = 0; i < CLUSTER_COUNT; i++) {
+			const ClusterBounds& bounds = binner.GetClusterBounds(i);
+			float center[3];
+			float extents[3];
+			for (int c = 0; c < 3; c++) {
+				center[c] = (bounds.Min[c] + bounds.Max[c]) * 0.5f;
+				extents[c] = (bounds.Max[c] - bounds.Min[c]) * 0.5f;
+			}
+
+			binned[i] = ranges[i].Count == 1;
+			if (Reaches(culler, center, extents) != binned[i]) mismatches++;
+		}
+		CHECK_EQUAL(mismatches, 0u);
+
+		//Both sides of the edge, and all four tiles round the corner
+		int lastY = target[1] == edgeY ? nextY : tileY;
+		for (int y = (std::min)(tileY, lastY); y <= (std::max)(tileY, lastY); y++) {
+			for (int x = tileX; x <= tileX + 1; x++) {
+				CHECK(binned[x + y * CLUSTER_COUNT_X + slice * CLUSTER_COUNT_X * CLUSTER_COUNT_Y]);
+			}
+		}
+	}
+}
@@ -0,0 +1,213 @@
+#include "Test.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include "../MaterialBindings.h"
+
+// Stands in for a texture or sampler, which is never looked at
+static MaterialResource MakeResource(int* value) {
+	return MaterialResource(value, [](void*) {});
+}
+
+static MaterialParameterSlot MakeSlot(unsigned int buffer, unsigned int byteOffset, unsigned int size) {
+	MaterialParameterSlot slot = {};
+	slot.Buffer = buffer;
+	slot.ByteOffset = byteOffset;
+	slot.Size = size;
+	return slot;
+}
+
+static bool IsUnresolved(const MaterialBindings& bindings, const std::string& name) {
+	return std::find(bindings.Unresolved.begin(), bindings.Unresolved.end(), name) != bindings.Unresolved.end();
+}
+
+// --------------------------------------------------------
+// Setting a name twice keeps the later value, and values
+// bigger than a float4 are cut down to one
+// --------------------------------------------------------
+TEST(MaterialBindingsDescReplaces) {
+	int first = 0;
+	int second = 0;
+	MaterialDesc desc;
+	desc.SetTexture("albedo", MakeResource(&first));
+	desc.SetTexture("albedo", MakeResource(&second));
+	CHECK_EQUAL(desc.Textures.size(), (size_t)1);
+	CHECK(desc.Textures[0].second.get() == &second);
+
+	const float big[6] = { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f };
+	desc.SetParameter("tint", big, sizeof(big));
+	desc.SetParameter("tint", big + 1, sizeof(float) * 2);
+	CHECK_EQUAL(desc.Parameters.size(), (size_t)1);
+	CHECK_EQUAL(desc.Parameters[0].Size, 8u);
+	CHECK_EQUAL(desc.Parameters[0].Value[0], 2.0f);
+
+	desc.SetParameter("big", big, sizeof(big));
+	CHECK_EQUAL(desc.Parameters[1].Size, (unsigned int)MATERIAL_MAX_PARAMETER_SIZE);
+}
+
+// --------------------------------------------------------
+// A material's own values win over its template's defaults,
+// and defaults fill in whatever it leaves out
+// --------------------------------------------------------
+TEST(MaterialBindingsOverrides) {
+	MaterialLayout layout;
+	layout.Textures["albedo"] = 0;
+	layout.Textures["shadowMap"] = 1;
+	layout.Samplers["basic"] = 0;
+	layout.Parameters["roughness"] = MakeSlot(0, 0, 4);
+
+	int defaultAlbedo = 0;
+	int shadowMap = 0;
+	int defaultSampler = 0;
+	MaterialDesc defaults;
+	defaults.SetTexture("albedo", MakeResource(&defaultAlbedo));
+	defaults.SetTexture("shadowMap", MakeResource(&shadowMap));
+	defaults.SetSampler("basic", MakeResource(&defaultSampler));
+	const float defaultRoughness = 0.5f;
+	defaults.SetParameter("roughness", &defaultRoughness, sizeof(float));
+
+	int albedo = 0;
+	MaterialDesc desc;
+	desc.SetTexture("albedo", MakeResource(&albedo));
+	const float roughness = 0.25f;
+	desc.SetParameter("roughness", &roughness, sizeof(float));
+
+	MaterialBindings bindings = MaterialBindings::Compile(layout, defaults, desc);
+	CHECK_EQUAL(bindings.Textures.size(), (size_t)2);
+	CHECK(bindings.Textures[0] == &albedo);
+	CHECK(bindings.Textures[1] == &shadowMap);
+	CHECK_EQUAL(bindings.Samplers.size(), (size_t)1);
+	CHECK(bindings.Samplers[0] == &defaultSampler);
+
+	CHECK_EQUAL(bindings.ParameterBlock.size(), sizeof(float));
+	float compiled = 0.0f;
+	memcpy(&compiled, bindings.ParameterBlock.data(), sizeof(float));
+	CHECK_EQUAL(compiled, roughness);
+	CHECK(bindings.Unresolved.empty());
+}
+
+// --------------------------------------------------------
+// Registers next to each other are one range, and a range
+// ends wherever the material leaves a register out
+// --------------------------------------------------------
+TEST(MaterialBindingsRanges) {
+	MaterialLayout layout;
+	layout.Textures["t0"] = 0;
+	layout.Textures["t1"] = 1;
+	layout.Textures["t2"] = 2;
+	layout.Textures["t4"] = 4;
+	layout.Textures["t7"] = 7;
+	layout.Samplers["s0"] = 0;
+	layout.Samplers["s1"] = 1;
+
+	//Set out of order, with t2 left to someone else
+	int resources[5] = {};
+	MaterialDesc desc;
+	desc.SetTexture("t7", MakeResource(&resources[4]));
+	desc.SetTexture("t1", MakeResource(&resources[1]));
+	desc.SetTexture("t4", MakeResource(&resources[3]));
+	desc.SetTexture("t0", MakeResource(&resources[0]));
+	desc.SetSampler("s1", MakeResource(&resources[1]));
+	desc.SetSampler("s0", MakeResource(&resources[0]));
+
+	MaterialBindings bindings = MaterialBindings::Compile(layout, MaterialDesc(), desc);
+	CHECK_EQUAL(bindings.TextureRanges.size(), (size_t)3);
+	CHECK_EQUAL(bindings.TextureRanges[0].First, 0u);
+	CHECK_EQUAL(bindings.TextureRanges[0].Count, 2u);
+	CHECK_EQUAL(bindings.TextureRanges[1].First, 4u);
+	CHECK_EQUAL(bindings.TextureRanges[1].Count, 1u);
+	CHECK_EQUAL(bindings.TextureRanges[1].Offset, 2u);
+	CHECK_EQUAL(bindings.TextureRanges[2].First, 7u);
+	CHECK_EQUAL(bindings.TextureRanges[2].Offset, 3u);
+
+	//Flat array in register order
+	CHECK(bindings.Textures[0] == &resources[0]);
+	CHECK(bindings.Textures[1] == &resources[1]);
+	CHECK(bindings.Textures[2] == &resources[3]);
+	CHECK(bindings.Textures[3] == &resources[4]);
+
+	CHECK_EQUAL(bindings.SamplerRanges.size(), (size_t)1);
+	CHECK_EQUAL(bindings.SamplerRanges[0].Count, 2u);
+}
+
+// --------------------------------------------------------
+// Parameters next to each other in a constant buffer are
+// one copy, gaps and other buffers start new ones, and a
+// value never runs past its variable
+// --------------------------------------------------------
+TEST(MaterialBindingsParameterRuns) {
+	MaterialLayout layout;
+	layout.Parameters["colorTint"] = MakeSlot(0, 0, 16);
+	layout.Parameters["roughness"] = MakeSlot(0, 16, 4);
+	layout.Parameters["metalness"] = MakeSlot(0, 20, 4);
+	layout.Parameters["emissive"] = MakeSlot(0, 32, 12);
+	layout.Parameters["uvScale"] = MakeSlot(1, 0, 8);
+
+	const float values[4] = { 1.0f, 2.0f, 3.0f, 4.0f };
+	MaterialDesc desc;
+	desc.SetParameter("uvScale", values, sizeof(float) * 2);
+	desc.SetParameter("emissive", values, sizeof(values));
+	desc.SetParameter("metalness", values + 3, sizeof(float));
+	desc.SetParameter("roughness", values + 2, sizeof(float));
+	desc.SetParameter("colorTint", values, sizeof(values));
+
+	MaterialBindings bindings = MaterialBindings::Compile(layout, MaterialDesc(), desc);
+	CHECK_EQUAL(bindings.ParameterRuns.size(), (size_t)3);
+
+	const MaterialParameterRun& packed = bindings.ParameterRuns[0];
+	CHECK_EQUAL(packed.Buffer, 0u);
+	CHECK_EQUAL(packed.ByteOffset, 0u);
+	CHECK_EQUAL(packed.Size, 24u);
+
+	//The float4 is cut down to the float3 it's going into
+	const MaterialParameterRun& emissive = bindings.ParameterRuns[1];
+	CHECK_EQUAL(emissive.ByteOffset, 32u);
+	CHECK_EQUAL(emissive.BlockOffset, 24u);
+	CHECK_EQUAL(emissive.Size, 12u);
+
+	const MaterialParameterRun& uvScale = bindings.ParameterRuns[2];
+	CHECK_EQUAL(uvScale.Buffer, 1u);
+	CHECK_EQUAL(uvScale.BlockOffset, 36u);
+	CHECK_EQUAL(bindings.ParameterBlock.size(), (size_t)44);
+
+	float block[11];
+	memcpy(block, bindings.ParameterBlock.data(), sizeof(block));
+	CHECK_EQUAL(block[3], 4.0f);
+	CHECK_EQUAL(block[4], 3.0f);
+	CHECK_EQUAL(block[5], 4.0f);
+	CHECK_EQUAL(block[8], 3.0f);
+	CHECK_EQUAL(block[10], 2.0f);
+}
+
+// --------------------------------------------------------
+// Names the shader doesn't have are skipped and listed,
+// from the defaults as well as the material
+// --------------------------------------------------------
+TEST(MaterialBindingsUnresolved) {
+	MaterialLayout layout;
+	layout.Textures["albedo"] = 0;
+	layout.Parameters["roughness"] = MakeSlot(0, 0, 4);
+
+	int resource = 0;
+	MaterialDesc defaults;
+	defaults.SetTexture("shadowMap", MakeResource(&resource));
+
+	MaterialDesc desc;
+	desc.SetTexture("albedo", MakeResource(&resource));
+	desc.SetSampler("basic", MakeResource(&resource));
+	const float value = 1.0f;
+	desc.SetParameter("metalness", &value, sizeof(float));
+
+	MaterialBindings bindings = MaterialBindings::Compile(layout, defaults, desc);
+	CHECK_EQUAL(bindings.Unresolved.size(), (size_t)3);
+	CHECK(IsUnresolved(bindings, "shadowMap"));
+	CHECK(IsUnresolved(bindings, "basic"));
+	CHECK(IsUnresolved(bindings, "metalness"));
+	CHECK(!IsUnresolved(bindings, "albedo"));
+
+	CHECK_EQUAL(bindings.Textures.size(), (size_t)1);
+	CHECK(bindings.Samplers.empty());
+	CHECK(bindings.ParameterRuns.empty());
+}
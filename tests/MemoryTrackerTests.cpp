@@ -0,0 +1,155 @@
+#include "Test.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "../DrawPartition.h"
+#include "../FrameArena.h"
+#include "../JobSystem.h"
+#include "../LightBinner.h"
+#include "../MemoryTracker.h"
+#include "../Profiler.h"
+#include "../RecordingRenderDevice.h"
+
+// Only means anything when operator new is counted, which
+// sanitizer builds leave out
+#ifdef MEMORY_TRACK_HEAP
+
+#define FRAME_DRAWS 2000
+#define FRAME_LIGHTS 64
+#define FRAME_WORKERS 3
+
+// Enough to fill every slot of the profiler's history once
+#define WARM_UP_FRAMES (PROFILER_HISTORY_FRAMES + 8)
+#define MEASURED_FRAMES 16
+
+// --------------------------------------------------------
+// The parts of a frame that don't need Direct3D, run the
+// way the game runs them
+//  - Everything that grows is kept between frames, like the
+//     game's members, so only the first frames allocate
+// --------------------------------------------------------
+struct SteadyFrame {
+	RecordingRenderDevice Device;
+	BufferHandle Buffers[4];
+	LightBinner Binner;
+	std::vector<BinnedLight> Lights;
+	std::vector<ClusterRange> Ranges;
+	std::vector<unsigned int> Indices;
+	std::vector<DrawRange> DrawRanges;
+	std::vector<float> Transforms;
+
+	SteadyFrame() : Lights(FRAME_LIGHTS), Transforms(FRAME_DRAWS * 16, 1.0f) {
+		for (BufferHandle& buffer : Buffers) {
+			buffer = Device.CreateBuffer(BufferDesc{ BufferType::Constant, BufferUsage::Dynamic, 64 }, 0);
+		}
+
+		Binner.SetProjection(0.5625f, 1.0f, 0.1f, 100.0f);
+		for (unsigned int i = 0; i < FRAME_LIGHTS; i++) {
+			BinnedLight& light = Lights[i];
+			light = {};
+			light.Center[0] = light.Apex[0] = (float)(i % 8) - 4.0f;
+			light.Center[1] = light.Apex[1] = (float)(i / 8) - 4.0f;
+			light.Center[2] = light.Apex[2] = 5.0f + (float)i;
+			light.Radius = light.Range = 3.0f;
+		}
+	}
+
+	void Run() {
+		Profiler::GetInstance().BeginFrame();
+
+		{
+			PROFILE_SCOPE("Update");
+			JobSystem::GetInstance().ParallelFor(FRAME_DRAWS, 0, [&](size_t begin, size_t end) {
+				PROFILE_SCOPE("Transforms");
+				for (size_t i = begin; i < end; i++) Transforms[i * 16 + 12] += 0.01f;
+			});
+		}
+
+		{
+			PROFILE_SCOPE("Lights");
+			Binner.Bin(Lights.data(), FRAME_LIGHTS, 0, Ranges, Indices);
+		}
+
+		{
+			PROFILE_SCOPE("Draw");
+			FrameVector<uint32_t> order;
+			order.reserve(FRAME_DRAWS);
+			for (uint32_t i = 0; i < FRAME_DRAWS; i++) order.push_back(FRAME_DRAWS - 1 - i);
+
+			DrawPartition::Split(order.size(), FRAME_WORKERS, DrawRanges);
+			std::atomic<size_t> drawn(0);
+			JobSystem::GetInstance().ParallelFor(DrawRanges.size(), 1, [&](size_t begin, size_t end) {
+				for (size_t r = begin; r < end; r++) drawn += DrawRanges[r].End - DrawRanges[r].Begin;
+			});
+			CHECK_EQUAL(drawn.load(), (size_t)FRAME_DRAWS);
+
+			Device.BeginFrame();
+			Device.ClearCommands();
+			Device.SetTopology(PrimitiveTopology::TriangleList);
+			for (uint32_t i = 0; i < 256; i++) {
+				Device.SetConstantBuffer(ShaderStage::Vertex, 0, Buffers[order[i] % 4]);
+				Device.Draw(3);
+			}
+		}
+
+		Profiler::GetInstance().EndFrame();
+		FrameArena::GetInstance().Reset();
+	}
+};
+
+// --------------------------------------------------------
+// The tracker sees a plain new on this thread
+// --------------------------------------------------------
+TEST(MemoryTrackerCountsAllocations) {
+	uint64_t before = MemoryTracker::GetThreadAllocationCount();
+	std::unique_ptr<int> value(new int(4));
+	CHECK_EQUAL(MemoryTracker::GetThreadAllocationCount() - before, (uint64_t)1);
+
+	MemoryTracker::EndFrame();
+	std::vector<int> grown(100);
+	MemoryTracker::EndFrame();
+	CHECK(MemoryTracker::GetFrameAllocations() >= 1);
+	CHECK_EQUAL(MemoryTracker::GetFramesWithoutAllocations(), 0u);
+}
+
+// --------------------------------------------------------
+// Refilling a kept vector with no more ranges than last
+// time doesn't allocate
+// --------------------------------------------------------
+TEST(MemoryTrackerDrawPartitionReuse) {
+	std::vector<DrawRange> ranges;
+	DrawPartition::Split(10000, 8, ranges);
+
+	uint64_t before = MemoryTracker::GetThreadAllocationCount();
+	for (size_t draws = 0; draws < 10000; draws += 97) {
+		DrawPartition::Split(draws, 8, ranges);
+	}
+	CHECK_EQUAL(MemoryTracker::GetThreadAllocationCount() - before, (uint64_t)0);
+}
+
+// --------------------------------------------------------
+// Once warmed up, a whole frame on every thread makes no
+// heap allocations at all
+// --------------------------------------------------------
+TEST(MemoryTrackerSteadyStateFrame) {
+	JobSystem::GetInstance().Initialize(FRAME_WORKERS);
+	SteadyFrame frame;
+
+	for (int i = 0; i < WARM_UP_FRAMES; i++) frame.Run();
+
+	for (int i = 0; i < MEASURED_FRAMES; i++) {
+		MemoryTracker::EndFrame();
+		uint64_t before = MemoryTracker::GetThreadAllocationCount();
+		frame.Run();
+		uint64_t threadAllocations = MemoryTracker::GetThreadAllocationCount() - before;
+		MemoryTracker::EndFrame();
+
+		CHECK_EQUAL(threadAllocations, (uint64_t)0);
+		CHECK_EQUAL(MemoryTracker::GetFrameAllocations(), (uint64_t)0);
+	}
+	CHECK(MemoryTracker::GetFramesWithoutAllocations() >= 1);
+}
+
+#endif
@@ -0,0 +1,133 @@
+#include "Test.h"
+
+#include "../BlurKernel.h"
+#include "../PostProcessSchedule.h"
+
+static PostProcessPassDesc MakePass(const char* name, std::vector<std::string> inputs, const char* output) {
+	PostProcessPassDesc pass;
+	pass.Name = name;
+	pass.Inputs = inputs;
+	pass.Output = output;
+	return pass;
+}
+
+static size_t ScreenBytes(unsigned int width, unsigned int height) {
+	return (size_t)width * height * PostProcessSchedule::BytesPerPixel(TextureFormat::RGBA8);
+}
+
+// --------------------------------------------------------
+// Each output goes back to the pool after the last pass that
+// reads it, not after the pass that wrote it
+// --------------------------------------------------------
+TEST(PostProcessScheduleReleasesAfterLastReader) {
+	PostProcessSchedule schedule;
+	schedule.AddPass(MakePass("A", { POST_PROCESS_SCENE }, "A"));
+	schedule.AddPass(MakePass("B", { "A" }, "B"));
+	schedule.AddPass(MakePass("C", { "B" }, "C"));
+	schedule.AddPass(MakePass("Combine", { "A", "C" }, POST_PROCESS_BACK_BUFFER));
+	CHECK(schedule.Compile());
+
+	CHECK(schedule.GetExecutionOrder() == std::vector<int>({ 0, 1, 2, 3 }));
+	CHECK(schedule.GetInputWriters(0) == std::vector<int>({ -1 }));
+	CHECK(schedule.GetInputWriters(3) == std::vector<int>({ 0, 2 }));
+
+	//A is read again by Combine, so it outlives B and C
+	CHECK(schedule.GetReleasesAfter(0).empty());
+	CHECK(schedule.GetReleasesAfter(1).empty());
+	CHECK(schedule.GetReleasesAfter(2) == std::vector<int>({ 1 }));
+	CHECK(schedule.GetReleasesAfter(3) == std::vector<int>({ 0, 2 }));
+
+	//C is written while B is still being read and A is still
+	//waiting for Combine, so three targets are live at once
+	CHECK_EQUAL(schedule.CalculatePeakTransientBytes(64, 32), 3 * ScreenBytes(64, 32));
+}
+
+// --------------------------------------------------------
+// A straight chain only ever needs two targets, as each
+// output is free once the next pass has read it
+// --------------------------------------------------------
+TEST(PostProcessScheduleAliasesChain) {
+	PostProcessSchedule schedule;
+	schedule.AddPass(MakePass("A", { POST_PROCESS_SCENE }, "A"));
+	schedule.AddPass(MakePass("B", { "A" }, "B"));
+	schedule.AddPass(MakePass("C", { "B" }, "C"));
+	schedule.AddPass(MakePass("D", { "C" }, "D"));
+	schedule.AddPass(MakePass("Present", { "D" }, POST_PROCESS_BACK_BUFFER));
+	CHECK(schedule.Compile());
+
+	for (unsigned int i = 1; i < schedule.GetPassCount(); i++) {
+		CHECK(schedule.GetReleasesAfter(i) == std::vector<int>({ (int)i - 1 }));
+	}
+	CHECK_EQUAL(schedule.CalculatePeakTransientBytes(64, 32), 2 * ScreenBytes(64, 32));
+
+	//Targets only alias when they match, so a half size
+	//target in the middle can't share with the others
+	schedule.Clear();
+	PostProcessPassDesc half = MakePass("Half", { "A" }, "Half");
+	half.OutputDesc.WidthScale = 0.5f;
+	half.OutputDesc.HeightScale = 0.5f;
+	schedule.AddPass(MakePass("A", { POST_PROCESS_SCENE }, "A"));
+	schedule.AddPass(half);
+	schedule.AddPass(MakePass("B", { "Half" }, "B"));
+	schedule.AddPass(MakePass("Present", { "B" }, POST_PROCESS_BACK_BUFFER));
+	CHECK_EQUAL(schedule.CalculatePeakTransientBytes(64, 32), ScreenBytes(64, 32) + ScreenBytes(32, 16));
+}
+
+// --------------------------------------------------------
+// Passes nothing reads on the way to the back buffer are
+// dropped, along with their memory
+// --------------------------------------------------------
+TEST(PostProcessScheduleDropsUnusedPasses) {
+	PostProcessSchedule schedule;
+	schedule.AddPass(MakePass("A", { POST_PROCESS_SCENE }, "A"));
+	schedule.AddPass(MakePass("Debug", { "A" }, "Debug"));
+	schedule.AddPass(MakePass("Present", { "A" }, POST_PROCESS_BACK_BUFFER));
+	CHECK(schedule.Compile());
+
+	CHECK(schedule.GetExecutionOrder() == std::vector<int>({ 0, 2 }));
+	CHECK(schedule.GetReleasesAfter(2) == std::vector<int>({ 0 }));
+	CHECK_EQUAL(schedule.CalculatePeakTransientBytes(64, 32), ScreenBytes(64, 32));
+}
+
+TEST(PostProcessScheduleRejectsMissingInput) {
+	PostProcessSchedule schedule;
+	schedule.AddPass(MakePass("Present", { "Nothing" }, POST_PROCESS_BACK_BUFFER));
+	CHECK(!schedule.Compile());
+	CHECK(!schedule.IsCompiled());
+	CHECK_EQUAL(schedule.CalculatePeakTransientBytes(64, 32), (size_t)0);
+
+	//Reading a later pass's output is just as missing
+	schedule.Clear();
+	schedule.AddPass(MakePass("Present", { "A" }, POST_PROCESS_BACK_BUFFER));
+	schedule.AddPass(MakePass("A", { POST_PROCESS_SCENE }, "A"));
+	CHECK(!schedule.Compile());
+}
+
+// --------------------------------------------------------
+// The blur the game actually runs
+//  - The pixel shader path needs one intermediate target
+//  - The compute path can't write to the back buffer, and
+//    its vertical pass writes while still reading the
+//    horizontal result, so it needs two
+// --------------------------------------------------------
+TEST(PostProcessScheduleBlurGraphPeakBytes) {
+	const unsigned int width = 1280;
+	const unsigned int height = 720;
+
+	PostProcessSchedule pixelShader;
+	for (const PostProcessPassDesc& pass : BlurKernel::DeclarePasses(false)) pixelShader.AddPass(pass);
+	CHECK(pixelShader.Compile());
+	CHECK_EQUAL(pixelShader.GetExecutionOrder().size(), (size_t)2);
+	CHECK_EQUAL(pixelShader.CalculatePeakTransientBytes(width, height), ScreenBytes(width, height));
+
+	PostProcessSchedule compute;
+	for (const PostProcessPassDesc& pass : BlurKernel::DeclarePasses(true)) compute.AddPass(pass);
+	CHECK(compute.Compile());
+	CHECK_EQUAL(compute.GetExecutionOrder().size(), (size_t)3);
+	CHECK(compute.GetReleasesAfter(1) == std::vector<int>({ 0 }));
+	CHECK(compute.GetReleasesAfter(2) == std::vector<int>({ 1 }));
+	CHECK_EQUAL(compute.CalculatePeakTransientBytes(width, height), 2 * ScreenBytes(width, height));
+
+	//Resizing only changes the sizes, not the aliasing
+	CHECK_EQUAL(compute.CalculatePeakTransientBytes(1, 1), 2 * ScreenBytes(1, 1));
+}
@@ -0,0 +1,169 @@
+#include "Test.h"
+
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "../Profiler.h"
+
+// Events in a frame with the given name, on one timeline
+static unsigned int CountEvents(const ProfileFrame& frame, const char* name, uint32_t thread) {
+	unsigned int count = 0;
+	for (const ProfileEvent& event : frame.Events) {
+		if (event.Thread == thread && strcmp(event.Name, name) == 0) count++;
+	}
+	return count;
+}
+
+static uint32_t FindThread(const char* name) {
+	std::vector<std::string> names = Profiler::GetInstance().GetThreadNames();
+	for (uint32_t i = 0; i < names.size(); i++) {
+		if (names[i] == name) return i;
+	}
+	return UINT32_MAX;
+}
+
+// --------------------------------------------------------
+// Zones from the main thread and a worker both end up in
+// the frame, with their nesting, and draining empties the
+// rings so the next frame starts clean
+//  - The profiler is shared by every test in the process, so
+//     anything left over is flushed by an EndFrame() first
+// --------------------------------------------------------
+TEST(ProfilerDrainsEveryThread) {
+	Profiler& profiler = Profiler::GetInstance();
+	profiler.SetPaused(false);
+	profiler.EndFrame();
+
+	profiler.BeginFrame();
+	{
+		PROFILE_SCOPE("Profiler Test Outer");
+		PROFILE_SCOPE("Profiler Test Inner");
+	}
+
+	std::thread worker([]() {
+		Profiler::GetInstance().SetThreadName("Profiler Test Worker");
+		for (int i = 0; i < 3; i++) {
+			PROFILE_SCOPE("Profiler Test Job");
+		}
+	});
+	worker.join();
+
+	profiler.EndFrame();
+
+	uint32_t workerThread = FindThread("Profiler Test Worker");
+	CHECK(workerThread != UINT32_MAX);
+
+	const ProfileFrame& frame = profiler.GetFrame(0);
+	CHECK_EQUAL(CountEvents(frame, "Profiler Test Job", workerThread), 3u);
+
+	uint32_t mainThread = UINT32_MAX;
+	for (const ProfileEvent& event : frame.Events) {
+		if (strcmp(event.Name, "Profiler Test Outer") == 0) {
+			mainThread = event.Thread;
+			CHECK_EQUAL(event.Depth, 0u);
+		} else if (strcmp(event.Name, "Profiler Test Inner") == 0) {
+			CHECK_EQUAL(event.Depth, 1u);
+		}
+		CHECK(event.Start <= event.End);
+	}
+	CHECK(mainThread != UINT32_MAX);
+	CHECK(mainThread != workerThread);
+	CHECK_EQUAL(CountEvents(frame, "Profiler Test Inner", mainThread), 1u);
+
+	//The worker's three jobs add up to one total
+	unsigned int jobTotals = 0;
+	for (const ProfileZoneTotal& total : frame.Totals) {
+		if (strcmp(total.Name, "Profiler Test Job") == 0) jobTotals++;
+	}
+	CHECK_EQUAL(jobTotals, 1u);
+
+	//Nothing is drained twice
+	profiler.BeginFrame();
+	profiler.EndFrame();
+	CHECK_EQUAL(CountEvents(profiler.GetFrame(0), "Profiler Test Job", workerThread), 0u);
+	CHECK_EQUAL(CountEvents(profiler.GetFrame(0), "Profiler Test Outer", mainThread), 0u);
+}
+
+// --------------------------------------------------------
+// A ring that fills up between frames drops the newest
+// zones and counts them, and takes zones again once drained
+// --------------------------------------------------------
+TEST(ProfilerDropsOnOverflow) {
+	Profiler& profiler = Profiler::GetInstance();
+	profiler.SetPaused(false);
+	profiler.EndFrame();
+
+	const unsigned int extra = 25;
+	unsigned int dropped = profiler.GetDroppedZones();
+
+	profiler.BeginFrame();
+	for (unsigned int i = 0; i < PROFILER_THREAD_CAPACITY + extra; i++) {
+		PROFILE_SCOPE("Profiler Test Flood");
+	}
+	profiler.EndFrame();
+
+	CHECK_EQUAL(profiler.GetDroppedZones() - dropped, extra);
+	CHECK_EQUAL(profiler.GetFrame(0).Events.size(), (size_t)PROFILER_THREAD_CAPACITY);
+
+	profiler.BeginFrame();
+	{
+		PROFILE_SCOPE("Profiler Test Flood");
+	}
+	profiler.EndFrame();
+
+	CHECK_EQUAL(profiler.GetDroppedZones() - dropped, extra);
+	CHECK_EQUAL(profiler.GetFrame(0).Events.size(), (size_t)1);
+}
+
+// --------------------------------------------------------
+// A zone taking 1 to 240 ms over a full history, on its own
+// timeline, gives exact percentiles
+//  - Percentiles pick the sorted duration at
+//     (frames - 1) * percent / 100
+// --------------------------------------------------------
+TEST(ProfilerPercentiles) {
+	Profiler& profiler = Profiler::GetInstance();
+	profiler.SetPaused(false);
+
+	const uint64_t millisecond = 1000000;
+	for (unsigned int frame = 0; frame < PROFILER_HISTORY_FRAMES; frame++) {
+		//Out of order, so the sort matters
+		uint64_t duration = ((frame * 97) % PROFILER_HISTORY_FRAMES + 1) * millisecond;
+
+		profiler.BeginFrame();
+		profiler.RecordZone("Profiler Test Pass", 0, duration, 0, "Profiler Test Timeline");
+		profiler.EndFrame();
+	}
+
+	uint32_t timeline = FindThread("Profiler Test Timeline");
+	const ProfileZoneStats* pass = 0;
+	std::vector<ProfileZoneStats> stats = profiler.GetZoneStats();
+	for (const ProfileZoneStats& zone : stats) {
+		if (zone.Thread == timeline && strcmp(zone.Name, "Profiler Test Pass") == 0) pass = &zone;
+	}
+
+	CHECK(pass != 0);
+	if (!pass) return;
+
+	float latest = (float)(((PROFILER_HISTORY_FRAMES - 1) * 97) % PROFILER_HISTORY_FRAMES + 1);
+	CHECK_NEAR(pass->Latest, latest, 1e-3f);
+	CHECK_NEAR(pass->Average, (PROFILER_HISTORY_FRAMES + 1) * 0.5f, 1e-3f);
+	CHECK_NEAR(pass->Percentile50, (PROFILER_HISTORY_FRAMES - 1) * 50 / 100 + 1, 1e-3f);
+	CHECK_NEAR(pass->Percentile95, (PROFILER_HISTORY_FRAMES - 1) * 95 / 100 + 1, 1e-3f);
+	CHECK_NEAR(pass->Percentile99, (PROFILER_HISTORY_FRAMES - 1) * 99 / 100 + 1, 1e-3f);
+
+	//Frames without the zone count as zero
+	profiler.BeginFrame();
+	profiler.RecordZone("Profiler Test Pass", 0, millisecond, 0, "Profiler Test Timeline");
+	profiler.RecordZone("Profiler Test Rare", 0, millisecond, 0, "Profiler Test Timeline");
+	profiler.EndFrame();
+
+	stats = profiler.GetZoneStats();
+	for (const ProfileZoneStats& zone : stats) {
+		if (zone.Thread == timeline && strcmp(zone.Name, "Profiler Test Rare") == 0) {
+			CHECK_NEAR(zone.Average, 1.0f / PROFILER_HISTORY_FRAMES, 1e-6f);
+			CHECK_EQUAL(zone.Percentile99, 0.0f);
+		}
+	}
+}
@@ -0,0 +1,236 @@
+#include "Test.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "../JobSystem.h"
+#include "../RayCaster.h"
+#include "TestMeshes.h"
+
+#define RAY_CASTER_TEST_INSTANCES 500
+#define RAY_CASTER_TEST_RAYS 500
+
+// --------------------------------------------------------
+// Instances of a few meshes, turned and stretched some
+// random way around a cube, with the broadphase over them
+// --------------------------------------------------------
+struct RayCastScene {
+	std::vector<std::shared_ptr<MeshBvh>> Meshes;
+	std::vector<float> Worlds;
+	std::vector<RayCastInstance> Instances;
+	SceneBvh Broadphase;
+	float Size;
+
+	RayCastScene(size_t count, unsigned int seed) :
+		Meshes({ MakeSphereBvh(16, 32, 0.5f), MakeSphereBvh(8, 16, 0.5f) }),
+		Worlds(count * 16),
+		Instances(count),
+		Size(std::cbrt((float)count) * 3.0f) {
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<float> position(-Size * 0.5f, Size * 0.5f);
+		std::uniform_real_distribution<float> scale(0.5f, 1.5f);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+		BoundsStreams bounds;
+		bounds.Resize(count);
+		for (size_t n = 0; n < count; n++) {
+			float q[4] = { unit(random), unit(random), unit(random), unit(random) };
+			float length = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+			float x = q[0] / length, y = q[1] / length, z = q[2] / length, w = q[3] / length;
+			float rows[3][3] = {
+				{ 1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + z * w), 2.0f * (x * z - y * w) },
+				{ 2.0f * (x * y - z * w), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + x * w) },
+				{ 2.0f * (x * z + y * w), 2.0f * (y * z - x * w), 1.0f - 2.0f * (x * x + y * y) }
+			};
+
+			float* world = &Worlds[n * 16];
+			for (int r = 0; r < 3; r++) {
+				float rowScale = scale(random);
+				for (int c = 0; c < 3; c++) world[r * 4 + c] = rows[r][c] * rowScale;
+				world[r * 4 + 3] = 0.0f;
+			}
+			world[12] = position(random);
+			world[13] = position(random);
+			world[14] = position(random);
+			world[15] = 1.0f;
+
+			//Spheres are centered, so only the extents need turning
+			const MeshBvh& mesh = *Meshes[n % Meshes.size()];
+			SceneBvhBox box = mesh.GetBounds();
+			float center[3] = { world[12], world[13], world[14] };
+			float extents[3] = {};
+			for (int c = 0; c < 3; c++) {
+				for (int r = 0; r < 3; r++) extents[c] += (box.Max[r] - box.Min[r]) * 0.5f * std::fabs(world[r * 4 + c]);
+			}
+			bounds.Set(n, center, extents);
+
+			Instances[n] = RayCastInstance{ &mesh, world };
+		}
+
+		//One thing rays go straight through
+		if (count > 1) Instances[count / 2].Mesh = 0;
+
+		Broadphase.Build(bounds);
+	}
+};
+
+// Rays between random points in the scene, like line of sight checks
+static std::vector<SceneBvhRay> MakeRays(const RayCastScene& scene, unsigned int seed) {
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> position(-scene.Size * 0.5f, scene.Size * 0.5f);
+
+	std::vector<SceneBvhRay> rays(RAY_CASTER_TEST_RAYS);
+	for (SceneBvhRay& ray : rays) {
+		float from[3] = { position(random), position(random), position(random) };
+		float to[3] = { position(random), position(random), position(random) };
+		float direction[3] = { to[0] - from[0], to[1] - from[1], to[2] - from[2] };
+		float distance = std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+		ray = SceneBvhRay{ { from[0], from[1], from[2] }, { direction[0] / distance, direction[1] / distance, direction[2] / distance }, distance };
+	}
+	return rays;
+}
+
+// Same hit or miss, at the same distance
+//  - Triangles sharing an edge can both claim a ray through
+//     it, so which triangle doesn't count
+static bool SameHit(const RayCastHit& a, const RayCastHit& b) {
+	if ((a.Instance == RAY_CAST_MISS) != (b.Instance == RAY_CAST_MISS)) return false;
+	return a.Instance == RAY_CAST_MISS || std::fabs(a.Distance - b.Distance) <= 1e-4f * (std::max)(1.0f, a.Distance);
+}
+
+// Every path this CPU can run
+static std::vector<MathPath> GetPaths() {
+	std::vector<MathPath> paths;
+	for (int i = 0; i < (int)MathPath::Count; i++) {
+		if (TransformBatch::IsPathAvailable((MathPath)i)) paths.push_back((MathPath)i);
+	}
+	return paths;
+}
+
+// --------------------------------------------------------
+// Single and batched casts through the broadphase and the
+// meshes' four wide trees match testing every triangle of
+// every instance, on the scalar path and the widest ones
+// --------------------------------------------------------
+TEST(RayCasterMatchesCastAll) {
+	JobSystem::GetInstance().Initialize(3);
+	RayCastScene scene(RAY_CASTER_TEST_INSTANCES, 1);
+	std::vector<SceneBvhRay> rays = MakeRays(scene, 2);
+
+	std::vector<RayCastHit> expected(rays.size());
+	size_t expectedHits = 0;
+	for (size_t r = 0; r < rays.size(); r++) {
+		if (RayCaster::CastAll(scene.Instances.data(), scene.Instances.size(), rays[r], expected[r])) expectedHits++;
+	}
+
+	//Random rays across the scene mostly hit something, but not all
+	CHECK(expectedHits > rays.size() / 4);
+	CHECK(expectedHits < rays.size());
+
+	MathPath best = TransformBatch::GetPath();
+	for (MathPath path : GetPaths()) {
+		TransformBatch::SetPath(path);
+
+		unsigned int mismatches = 0;
+		for (size_t r = 0; r < rays.size(); r++) {
+			RayCastHit hit;
+			bool found = RayCaster::Cast(scene.Broadphase, scene.Instances.data(), rays[r], hit);
+			if (found != (hit.Instance != RAY_CAST_MISS) || !SameHit(hit, expected[r])) mismatches++;
+		}
+		CHECK_EQUAL(mismatches, 0u);
+
+		std::vector<RayCastHit> hits(rays.size());
+		size_t hitCount = RayCaster::CastBatch(scene.Broadphase, scene.Instances.data(), rays.data(), rays.size(), hits.data());
+		CHECK_EQUAL(hitCount, expectedHits);
+
+		mismatches = 0;
+		for (size_t r = 0; r < rays.size(); r++) {
+			if (!SameHit(hits[r], expected[r])) mismatches++;
+		}
+		CHECK_EQUAL(mismatches, 0u);
+	}
+	TransformBatch::SetPath(best);
+
+	JobSystem::GetInstance().ShutDown();
+}
+
+// --------------------------------------------------------
+// Rays aimed straight at the edges and corners between a
+// sphere's triangles hit its near side on every path
+//  - Paths round differently, so without the edge tolerance
+//     a ray can fall between both triangles on one path and
+//     go on to hit the far side
+//  - The pole rows' slivers, with rounding for area, would
+//     catch rays that pass near them when tested one by one
+// --------------------------------------------------------
+TEST(RayCasterHitsSharedEdges) {
+	RayCastScene scene(1, 3);
+	const RayCastInstance& instance = scene.Instances[0];
+	const float* world = instance.World;
+
+	//The sphere's grid points, and halfway between neighbours
+	const unsigned int rings = 16, segments = 32;
+	std::vector<SceneBvhRay> rays;
+	for (unsigned int ring = 1; ring < rings * 2; ring++) {
+		float theta = 3.14159265f * ring / (rings * 2);
+		for (unsigned int segment = 0; segment < segments * 2; segment++) {
+			float phi = 6.28318531f * segment / (segments * 2);
+			float local[3] = { 0.5f * sinf(theta) * cosf(phi), 0.5f * cosf(theta), 0.5f * sinf(theta) * sinf(phi) };
+
+			float target[3], outside[3];
+			for (int c = 0; c < 3; c++) {
+				target[c] = world[12 + c];
+				outside[c] = world[12 + c];
+				for (int r = 0; r < 3; r++) {
+					target[c] += local[r] * world[r * 4 + c];
+					outside[c] += local[r] * 4.0f * world[r * 4 + c];
+				}
+			}
+
+			float direction[3] = { target[0] - outside[0], target[1] - outside[1], target[2] - outside[2] };
+			float distance = std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+			rays.push_back(SceneBvhRay{ { outside[0], outside[1], outside[2] }, { direction[0] / distance, direction[1] / distance, direction[2] / distance }, distance * 4.0f });
+		}
+	}
+
+	MathPath best = TransformBatch::GetPath();
+	for (MathPath path : GetPaths()) {
+		TransformBatch::SetPath(path);
+
+		unsigned int misses = 0;
+		unsigned int mismatches = 0;
+		for (const SceneBvhRay& ray : rays) {
+			RayCastHit hit, expected;
+			RayCaster::CastAll(scene.Instances.data(), 1, ray, expected);
+			if (!RayCaster::Cast(scene.Broadphase, scene.Instances.data(), ray, hit)) misses++;
+			else if (!SameHit(hit, expected)) mismatches++;
+		}
+		CHECK_EQUAL(misses, 0u);
+		CHECK_EQUAL(mismatches, 0u);
+	}
+	TransformBatch::SetPath(best);
+}
+
+// --------------------------------------------------------
+// Measure's own checks agree, and a ray that starts inside
+// something still finds its far side
+// --------------------------------------------------------
+TEST(RayCasterMeasure) {
+	JobSystem::GetInstance().Initialize(3);
+	std::vector<std::shared_ptr<MeshBvh>> meshes = { MakeSphereBvh(8, 16, 1.0f) };
+	RayCastMeasurement measurement = RayCaster::Measure(meshes, 2000, 2000);
+	CHECK_EQUAL(measurement.Instances, (size_t)2000);
+	CHECK(measurement.Hits > 0u);
+	CHECK_EQUAL(measurement.Mismatches, 0u);
+
+	RayCastScene scene(1, 4);
+	SceneBvhRay ray = { { scene.Worlds[12], scene.Worlds[13], scene.Worlds[14] }, { 0.0f, 1.0f, 0.0f }, 100.0f };
+	RayCastHit hit;
+	CHECK(RayCaster::Cast(scene.Broadphase, scene.Instances.data(), ray, hit));
+	CHECK_EQUAL(hit.Instance, 0u);
+	CHECK(hit.Distance > 0.2f && hit.Distance < 0.8f);
+
+	JobSystem::GetInstance().ShutDown();
+}
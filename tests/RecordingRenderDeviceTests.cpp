@@ -0,0 +1,196 @@
+#include "Test.h"
+
+#include <memory>
+#include <vector>
+
+#include "../RecordingRenderDevice.h"
+
+// --------------------------------------------------------
+// Keeps the commands an observer is told about
+// --------------------------------------------------------
+class CountingObserver : public IRenderDeviceObserver {
+public:
+	std::vector<RenderCommand> Commands;
+	unsigned int ResourcesCreated = 0;
+	unsigned int ResourcesDestroyed = 0;
+	unsigned int Invalidates = 0;
+	unsigned int Frames = 0;
+
+	void OnResourceCreated(CommandTrace::RecordType, uint32_t, const void*, size_t, const void*, size_t) override { ResourcesCreated++; }
+	void OnResourceDestroyed(CommandTrace::RecordType, uint32_t) override { ResourcesDestroyed++; }
+	void OnCommand(const RenderCommand& command, const void*) override { Commands.push_back(command); }
+	void OnInvalidateState() override { Invalidates++; }
+	void OnFrameBegin() override { Frames++; }
+};
+
+static BufferHandle CreateConstantBuffer(RenderDevice& device) {
+	return device.CreateBuffer(BufferDesc{ BufferType::Constant, BufferUsage::Dynamic, 64 }, 0);
+}
+
+// --------------------------------------------------------
+// Binding what's already bound is dropped before it reaches
+// the backend, and counted as redundant
+// --------------------------------------------------------
+TEST(RecordingRenderDeviceRedundantBinds) {
+	RecordingRenderDevice device;
+	BufferHandle a = CreateConstantBuffer(device);
+	BufferHandle b = CreateConstantBuffer(device);
+	CHECK(a.IsValid() && b.IsValid() && a != b);
+
+	device.SetConstantBuffer(ShaderStage::Vertex, 0, a);
+	device.SetConstantBuffer(ShaderStage::Vertex, 0, a);
+	device.SetConstantBuffer(ShaderStage::Vertex, 0, b);
+	device.SetConstantBuffer(ShaderStage::Vertex, 0, b);
+
+	//Same buffer, but another slot or stage, is a change
+	device.SetConstantBuffer(ShaderStage::Vertex, 1, b);
+	device.SetConstantBuffer(ShaderStage::Pixel, 0, b);
+
+	device.SetTopology(PrimitiveTopology::TriangleList);
+	device.SetTopology(PrimitiveTopology::TriangleList);
+
+	const std::vector<RenderCommand>& commands = device.GetCommands();
+	CHECK_EQUAL(commands.size(), (size_t)5);
+	CHECK(commands[0].Type == RenderCommandType::SetConstantBuffer && commands[0].Handle == a.Id);
+	CHECK(commands[1].Type == RenderCommandType::SetConstantBuffer && commands[1].Handle == b.Id);
+	CHECK(commands[2].Slot == 1);
+	CHECK(commands[3].Stage == ShaderStage::Pixel);
+	CHECK(commands[4].Type == RenderCommandType::SetTopology);
+
+	CHECK_EQUAL(device.GetStats().StateChanges, 5u);
+	CHECK_EQUAL(device.GetStats().RedundantStateChanges, 3u);
+}
+
+// --------------------------------------------------------
+// A vertex buffer with a new stride is a change, even when
+// it's the same buffer
+// --------------------------------------------------------
+TEST(RecordingRenderDeviceVertexStride) {
+	RecordingRenderDevice device;
+	BufferHandle buffer = device.CreateBuffer(BufferDesc{ BufferType::Vertex, BufferUsage::Immutable, 1024 }, 0);
+
+	device.SetVertexBuffer(buffer, 32);
+	device.SetVertexBuffer(buffer, 32);
+	device.SetVertexBuffer(buffer, 48);
+
+	const std::vector<RenderCommand>& commands = device.GetCommands();
+	CHECK_EQUAL(commands.size(), (size_t)2);
+	CHECK_EQUAL(commands[1].Count, 48u);
+	CHECK_EQUAL(device.GetStats().RedundantStateChanges, 1u);
+}
+
+// --------------------------------------------------------
+// Forgetting the bound state lets every bind through once,
+// and unbinding (handle 0) is a bind like any other
+// --------------------------------------------------------
+TEST(RecordingRenderDeviceInvalidate) {
+	RecordingRenderDevice device;
+	ShaderHandle shader = device.CreateShader(ShaderStage::Pixel, 0, 0);
+
+	device.SetShader(ShaderStage::Pixel, shader);
+	device.InvalidateState();
+	device.SetShader(ShaderStage::Pixel, shader);
+	device.SetShader(ShaderStage::Pixel, shader);
+
+	device.SetTexture(ShaderStage::Pixel, 0, TextureHandle());
+	device.SetTexture(ShaderStage::Pixel, 0, TextureHandle());
+
+	CHECK_EQUAL(device.GetCommands().size(), (size_t)3);
+	CHECK_EQUAL(device.GetCommands()[2].Handle, 0u);
+	CHECK_EQUAL(device.GetStats().RedundantStateChanges, 2u);
+
+	//A new frame invalidates too, and starts the stats over
+	device.BeginFrame();
+	device.SetShader(ShaderStage::Pixel, shader);
+	CHECK_EQUAL(device.GetCommands().size(), (size_t)4);
+	CHECK_EQUAL(device.GetStats().StateChanges, 1u);
+	CHECK_EQUAL(device.GetLastFrameStats().StateChanges, 3u);
+	CHECK_EQUAL(device.GetLastFrameStats().RedundantStateChanges, 2u);
+}
+
+// --------------------------------------------------------
+// Slots past the ones tracked always go through
+// --------------------------------------------------------
+TEST(RecordingRenderDeviceUntrackedSlots) {
+	RecordingRenderDevice device;
+	SamplerHandle sampler = device.CreateSampler(SamplerDesc{ FilterMode::Linear, AddressMode::Wrap, 1 });
+
+	device.SetSampler(ShaderStage::Pixel, RENDER_DEVICE_MAX_SLOTS, sampler);
+	device.SetSampler(ShaderStage::Pixel, RENDER_DEVICE_MAX_SLOTS, sampler);
+
+	CHECK_EQUAL(device.GetCommands().size(), (size_t)2);
+	CHECK_EQUAL(device.GetStats().StateChanges, 2u);
+	CHECK_EQUAL(device.GetStats().RedundantStateChanges, 0u);
+}
+
+// --------------------------------------------------------
+// Draws and buffer updates are never filtered, and count
+// primitives by the bound topology
+// --------------------------------------------------------
+TEST(RecordingRenderDeviceDraws) {
+	RecordingRenderDevice device;
+	BufferHandle buffer = CreateConstantBuffer(device);
+	float data[16] = {};
+
+	device.UpdateBuffer(buffer, data, sizeof(data));
+	device.UpdateBuffer(buffer, data, sizeof(data));
+	device.SetTopology(PrimitiveTopology::TriangleList);
+	device.DrawIndexed(36);
+	device.DrawIndexed(36);
+	device.SetTopology(PrimitiveTopology::LineList);
+	device.Draw(10, 4);
+
+	const RenderDeviceStats& stats = device.GetStats();
+	CHECK_EQUAL(stats.BufferUpdates, 2u);
+	CHECK_EQUAL(stats.BytesUploaded, (uint64_t)sizeof(data) * 2);
+	CHECK_EQUAL(stats.DrawCalls, 3u);
+	CHECK_EQUAL(stats.Primitives, 12u + 12u + 10u);
+
+	const std::vector<RenderCommand>& commands = device.GetCommands();
+	CHECK_EQUAL(commands.size(), (size_t)7);
+	CHECK(commands.back().Type == RenderCommandType::Draw);
+	CHECK_EQUAL(commands.back().Count, 10u);
+	CHECK_EQUAL(commands.back().Start, 4u);
+}
+
+// --------------------------------------------------------
+// Wrapping a target passes along only what got through the
+// filter, with the target's own handles
+// --------------------------------------------------------
+TEST(RecordingRenderDeviceTarget) {
+	std::shared_ptr<RecordingRenderDevice> target = std::make_shared<RecordingRenderDevice>();
+	RecordingRenderDevice device(target);
+
+	BufferHandle buffer = CreateConstantBuffer(device);
+	device.SetConstantBuffer(ShaderStage::Compute, 2, buffer);
+	device.SetConstantBuffer(ShaderStage::Compute, 2, buffer);
+	device.Draw(3);
+
+	CHECK_EQUAL(target->GetCommands().size(), (size_t)2);
+	CHECK_EQUAL(target->GetCommands()[0].Handle, buffer.Id);
+	CHECK_EQUAL(target->GetStats().RedundantStateChanges, 0u);
+	CHECK_EQUAL(device.GetStats().RedundantStateChanges, 1u);
+}
+
+// --------------------------------------------------------
+// An observer sees the filtered stream even with recording
+// off, along with resources and frames
+// --------------------------------------------------------
+TEST(RecordingRenderDeviceObserver) {
+	std::shared_ptr<CountingObserver> observer = std::make_shared<CountingObserver>();
+	RecordingRenderDevice device;
+	device.SetObserver(observer);
+	device.SetRecording(false);
+
+	BufferHandle buffer = CreateConstantBuffer(device);
+	device.BeginFrame();
+	device.SetIndexBuffer(buffer);
+	device.SetIndexBuffer(buffer);
+	device.DestroyBuffer(buffer);
+
+	CHECK(device.GetCommands().empty());
+	CHECK_EQUAL(observer->Commands.size(), (size_t)1);
+	CHECK_EQUAL(observer->ResourcesCreated, 1u);
+	CHECK_EQUAL(observer->ResourcesDestroyed, 1u);
+	CHECK_EQUAL(observer->Frames, 1u);
+}
@@ -0,0 +1,143 @@
+#include "Test.h"
+
+#include <cmath>
+
+#include "../RotationMath.h"
+
+#define TEST_PI 3.14159265f
+
+static void CheckVectorNear(const float a[3], float x, float y, float z, float tolerance) {
+	CHECK_NEAR(a[0], x, tolerance);
+	CHECK_NEAR(a[1], y, tolerance);
+	CHECK_NEAR(a[2], z, tolerance);
+}
+
+// --------------------------------------------------------
+// Quarter turns move forward where DirectX's left handed
+// axes say they should
+// --------------------------------------------------------
+TEST(RotationMathQuarterTurns) {
+	float q[4], right[3], up[3], forward[3];
+
+	RotationMath::FromPitchYawRoll(0.0f, TEST_PI * 0.5f, 0.0f, q);
+	RotationMath::ToBasis(q, right, up, forward);
+	CheckVectorNear(forward, 1.0f, 0.0f, 0.0f, 1e-6f);
+	CheckVectorNear(right, 0.0f, 0.0f, -1.0f, 1e-6f);
+
+	//Positive pitch looks down
+	RotationMath::FromPitchYawRoll(TEST_PI * 0.5f, 0.0f, 0.0f, q);
+	RotationMath::ToBasis(q, right, up, forward);
+	CheckVectorNear(forward, 0.0f, -1.0f, 0.0f, 1e-6f);
+	CheckVectorNear(up, 0.0f, 0.0f, 1.0f, 1e-6f);
+
+	RotationMath::FromPitchYawRoll(0.0f, 0.0f, TEST_PI * 0.5f, q);
+	RotationMath::ToBasis(q, right, up, forward);
+	CheckVectorNear(right, 0.0f, 1.0f, 0.0f, 1e-6f);
+	CheckVectorNear(forward, 0.0f, 0.0f, 1.0f, 1e-6f);
+}
+
+// --------------------------------------------------------
+// Pitch, yaw and roll together are roll, then pitch, then
+// yaw, each around a world axis
+// --------------------------------------------------------
+TEST(RotationMathPitchYawRollOrder) {
+	const float xAxis[3] = { 1.0f, 0.0f, 0.0f };
+	const float yAxis[3] = { 0.0f, 1.0f, 0.0f };
+	const float zAxis[3] = { 0.0f, 0.0f, 1.0f };
+
+	float pitch[4], yaw[4], roll[4], composed[4], direct[4];
+	RotationMath::FromAxisAngle(xAxis, 0.7f, pitch);
+	RotationMath::FromAxisAngle(yAxis, -1.3f, yaw);
+	RotationMath::FromAxisAngle(zAxis, 0.4f, roll);
+	RotationMath::Multiply(roll, pitch, composed);
+	RotationMath::Multiply(composed, yaw, composed);
+
+	RotationMath::FromPitchYawRoll(0.7f, -1.3f, 0.4f, direct);
+	for (int i = 0; i < 4; i++) CHECK_NEAR(direct[i], composed[i], 1e-6f);
+	CHECK_NEAR(RotationMath::Length(direct), 1.0f, 1e-6f);
+}
+
+// --------------------------------------------------------
+// Yaw turns around the world's up, so however far a camera
+// has pitched, yawing never tips its right off level
+// --------------------------------------------------------
+TEST(RotationMathYawStaysLevel) {
+	float q[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	float right[3], up[3], forward[3];
+
+	RotationMath::Rotate(q, 0.6f, 0.0f, 0.0f);
+	for (int i = 0; i < 1000; i++) {
+		RotationMath::Rotate(q, 0.0f, 0.013f, 0.0f);
+		RotationMath::ToBasis(q, right, up, forward);
+		CHECK_NEAR(right[1], 0.0f, 1e-5f);
+		CHECK_NEAR(forward[1], -sinf(0.6f), 1e-4f);
+	}
+}
+
+// --------------------------------------------------------
+// Pitch turns around the transform's own right, so after a
+// quarter yaw it tilts forward along x instead of z
+// --------------------------------------------------------
+TEST(RotationMathPitchIsLocal) {
+	float q[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	float right[3], up[3], forward[3];
+
+	RotationMath::Rotate(q, 0.0f, TEST_PI * 0.5f, 0.0f);
+	RotationMath::Rotate(q, 0.5f, 0.0f, 0.0f);
+	RotationMath::ToBasis(q, right, up, forward);
+
+	CheckVectorNear(right, 0.0f, 0.0f, -1.0f, 1e-6f);
+	CheckVectorNear(forward, cosf(0.5f), -sinf(0.5f), 0.0f, 1e-6f);
+}
+
+// --------------------------------------------------------
+// The turns Transform::MeasureRotations() tumbles through,
+// checked after every one: the quaternion stays unit length
+// and the basis stays orthonormal
+// --------------------------------------------------------
+TEST(RotationMathNoDrift) {
+	const unsigned int rotations = 100000;
+	float q[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	float right[3], up[3], forward[3];
+	float maxNormError = 0.0f;
+	float maxBasisError = 0.0f;
+
+	for (unsigned int i = 0; i < rotations; i++) {
+		RotationMath::Rotate(q, 0.01f * std::sin(i * 0.37f), 0.02f * std::cos(i * 0.11f), 0.015f * std::sin(i * 0.23f));
+		RotationMath::ToBasis(q, right, up, forward);
+
+		maxNormError = (std::max)(maxNormError, std::fabs(RotationMath::Length(q) - 1.0f));
+		maxBasisError = (std::max)(maxBasisError, RotationMath::BasisError(right, up, forward));
+	}
+
+	CHECK(maxNormError < 1e-5f);
+	CHECK(maxBasisError < 1e-5f);
+}
+
+// --------------------------------------------------------
+// Without renormalizing, the same turns do drift, which is
+// what the test above would catch
+// --------------------------------------------------------
+TEST(RotationMathDriftWithoutNormalizing) {
+	float q[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	for (unsigned int i = 0; i < 100000; i++) {
+		float turn[4];
+		RotationMath::FromPitchYawRoll(0.01f * std::sin(i * 0.37f), 0.02f * std::cos(i * 0.11f), 0.015f * std::sin(i * 0.23f), turn);
+		RotationMath::Multiply(q, turn, q);
+	}
+
+	CHECK(std::fabs(RotationMath::Length(q) - 1.0f) > 1e-5f);
+}
+
+TEST(RotationMathBasisError) {
+	const float right[3] = { 1.0f, 0.0f, 0.0f };
+	const float up[3] = { 0.0f, 1.0f, 0.0f };
+	const float forward[3] = { 0.0f, 0.0f, 1.0f };
+	CHECK_EQUAL(RotationMath::BasisError(right, up, forward), 0.0f);
+
+	const float longUp[3] = { 0.0f, 1.01f, 0.0f };
+	CHECK_NEAR(RotationMath::BasisError(right, longUp, forward), 0.01f, 1e-6f);
+
+	const float leaningUp[3] = { 0.6f, 0.8f, 0.0f };
+	CHECK_NEAR(RotationMath::BasisError(right, leaningUp, forward), 0.6f, 1e-6f);
+}
@@ -0,0 +1,338 @@
+#include "Test.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "../JobSystem.h"
+#include "../MemoryTracker.h"
+#include "../SceneBvh.h"
+
+#define SCENE_BVH_TEST_ITEMS 2000
+#define SCENE_BVH_TEST_QUERIES 200
+#define SCENE_BVH_TEST_SIZE 100.0f
+
+// Random boxes, a few units across, spread through a cube
+static void MakeBounds(size_t count, unsigned int seed, BoundsStreams& bounds) {
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> position(-SCENE_BVH_TEST_SIZE * 0.5f, SCENE_BVH_TEST_SIZE * 0.5f);
+	std::uniform_real_distribution<float> extent(0.1f, 2.0f);
+
+	bounds.Resize(count);
+	for (size_t i = 0; i < count; i++) {
+		float center[3] = { position(random), position(random), position(random) };
+		float extents[3] = { extent(random), extent(random), extent(random) };
+		bounds.Set(i, center, extents);
+	}
+}
+
+static SceneBvhBox GetBox(const BoundsStreams& bounds, size_t i) {
+	SceneBvhBox box = { {
+		bounds.CenterX[i] - bounds.ExtentX[i], bounds.CenterY[i] - bounds.ExtentY[i], bounds.CenterZ[i] - bounds.ExtentZ[i] }, {
+		bounds.CenterX[i] + bounds.ExtentX[i], bounds.CenterY[i] + bounds.ExtentY[i], bounds.CenterZ[i] + bounds.ExtentZ[i] } };
+	return box;
+}
+
+// A box from min to max, as six planes facing in
+static SceneBvhFrustum MakeBoxFrustum(const float min[3], const float max[3]) {
+	SceneBvhFrustum frustum = {};
+	for (int axis = 0; axis < 3; axis++) {
+		frustum.Planes[axis * 2][axis] = 1.0f;
+		frustum.Planes[axis * 2][3] = -min[axis];
+		frustum.Planes[axis * 2 + 1][axis] = -1.0f;
+		frustum.Planes[axis * 2 + 1][3] = max[axis];
+	}
+	return frustum;
+}
+
+// --------------------------------------------------------
+// Random queries, with the answer from checking every item
+//  - Frustums are boxes, so being inside them is just the
+//     boxes overlapping
+// --------------------------------------------------------
+struct BruteForce {
+	std::vector<SceneBvhFrustum> Frustums;
+	std::vector<SceneBvhSphere> Spheres;
+	std::vector<SceneBvhRay> Rays;
+	std::vector<std::vector<uint32_t>> FrustumItems;
+	std::vector<std::vector<uint32_t>> SphereItems;
+	std::vector<std::vector<uint32_t>> RayItems;
+	std::vector<float> Nearest; // Where each ray first enters a box
+
+	BruteForce(const BoundsStreams& bounds, unsigned int seed) {
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<float> position(-SCENE_BVH_TEST_SIZE * 0.5f, SCENE_BVH_TEST_SIZE * 0.5f);
+		std::uniform_real_distribution<float> size(1.0f, 10.0f);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+		for (unsigned int q = 0; q < SCENE_BVH_TEST_QUERIES; q++) {
+			float center[3] = { position(random), position(random), position(random) };
+			float min[3], max[3];
+			for (int a = 0; a < 3; a++) {
+				float half = size(random);
+				min[a] = center[a] - half;
+				max[a] = center[a] + half;
+			}
+			Frustums.push_back(MakeBoxFrustum(min, max));
+			Spheres.push_back(SceneBvhSphere{ { center[0], center[1], center[2] }, size(random) });
+
+			float direction[3] = { unit(random), unit(random), unit(random) };
+			float length = std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+			Rays.push_back(SceneBvhRay{ { center[0], center[1], center[2] }, { direction[0] / length, direction[1] / length, direction[2] / length }, SCENE_BVH_TEST_SIZE * 0.5f });
+
+			FrustumItems.emplace_back();
+			SphereItems.emplace_back();
+			RayItems.emplace_back();
+			Nearest.push_back(FLT_MAX);
+
+			const SceneBvhRay& ray = Rays.back();
+			float inverseDirection[3] = { 1.0f / ray.Direction[0], 1.0f / ray.Direction[1], 1.0f / ray.Direction[2] };
+			for (size_t i = 0; i < bounds.GetCount(); i++) {
+				SceneBvhBox box = GetBox(bounds, i);
+
+				bool overlaps = true;
+				float distanceSquared = 0.0f;
+				for (int a = 0; a < 3; a++) {
+					overlaps = overlaps && box.Min[a] <= max[a] && box.Max[a] >= min[a];
+					float closest = (std::max)(box.Min[a], (std::min)(center[a], box.Max[a]));
+					distanceSquared += (center[a] - closest) * (center[a] - closest);
+				}
+				if (overlaps) FrustumItems.back().push_back((uint32_t)i);
+				if (distanceSquared <= Spheres.back().Radius * Spheres.back().Radius) SphereItems.back().push_back((uint32_t)i);
+
+				float distance;
+				if (SceneBvh::IntersectRay(ray, inverseDirection, box, distance)) {
+					RayItems.back().push_back((uint32_t)i);
+					Nearest.back() = (std::min)(Nearest.back(), distance);
+				}
+			}
+		}
+	}
+};
+
+static bool SameItems(std::vector<uint32_t> found, const std::vector<uint32_t>& expected) {
+	std::sort(found.begin(), found.end());
+	return found == expected;
+}
+
+// Queries that don't give the same items as checking everything
+static unsigned int CountMismatches(const SceneBvh& bvh, const BruteForce& expected) {
+	unsigned int mismatches = 0;
+	for (size_t q = 0; q < expected.Frustums.size(); q++) {
+		std::vector<uint32_t> frustumItems, sphereItems;
+		bvh.QueryFrustum(expected.Frustums[q], frustumItems);
+		bvh.QuerySphere(expected.Spheres[q], sphereItems);
+		if (!SameItems(frustumItems, expected.FrustumItems[q])) mismatches++;
+		if (!SameItems(sphereItems, expected.SphereItems[q])) mismatches++;
+
+		std::vector<SceneBvhHit> hits;
+		bvh.QueryRay(expected.Rays[q], hits);
+		std::vector<uint32_t> rayItems;
+		for (size_t h = 0; h < hits.size(); h++) {
+			rayItems.push_back(hits[h].Item);
+			if (h > 0 && hits[h].Distance < hits[h - 1].Distance) mismatches++;
+		}
+		if (!SameItems(rayItems, expected.RayItems[q])) mismatches++;
+	}
+	return mismatches;
+}
+
+// --------------------------------------------------------
+// Single and batched queries find exactly what checking
+// every item does
+// --------------------------------------------------------
+TEST(SceneBvhQueries) {
+	JobSystem::GetInstance().Initialize(3);
+
+	BoundsStreams bounds;
+	MakeBounds(SCENE_BVH_TEST_ITEMS, 1, bounds);
+	SceneBvh bvh;
+	bvh.Build(bounds);
+	CHECK_EQUAL(bvh.GetItemCount(), (size_t)SCENE_BVH_TEST_ITEMS);
+	CHECK(bvh.GetDepth() > 0u);
+
+	BruteForce expected(bounds, 2);
+	CHECK_EQUAL(CountMismatches(bvh, expected), 0u);
+
+	SceneBvhResults frustumResults, sphereResults;
+	SceneBvhRayResults rayResults;
+	bvh.QueryFrustums(&expected.Frustums[0], expected.Frustums.size(), frustumResults);
+	bvh.QuerySpheres(&expected.Spheres[0], expected.Spheres.size(), sphereResults);
+	bvh.QueryRays(&expected.Rays[0], expected.Rays.size(), rayResults);
+
+	unsigned int mismatches = 0;
+	for (size_t q = 0; q < expected.Frustums.size(); q++) {
+		const SceneBvhRange& frustum = frustumResults.Ranges[q];
+		const SceneBvhRange& sphere = sphereResults.Ranges[q];
+		const SceneBvhRange& ray = rayResults.Ranges[q];
+
+		std::vector<uint32_t> rayItems;
+		for (uint32_t h = ray.Offset; h < ray.Offset + ray.Count; h++) rayItems.push_back(rayResults.Hits[h].Item);
+
+		if (!SameItems(std::vector<uint32_t>(frustumResults.Items.begin() + frustum.Offset, frustumResults.Items.begin() + frustum.Offset + frustum.Count), expected.FrustumItems[q])) mismatches++;
+		if (!SameItems(std::vector<uint32_t>(sphereResults.Items.begin() + sphere.Offset, sphereResults.Items.begin() + sphere.Offset + sphere.Count), expected.SphereItems[q])) mismatches++;
+		if (!SameItems(rayItems, expected.RayItems[q])) mismatches++;
+	}
+	CHECK_EQUAL(mismatches, 0u);
+
+	JobSystem::GetInstance().ShutDown();
+}
+
+// --------------------------------------------------------
+// CastRay finds the nearest item the narrowphase accepts,
+// and never offers one past the nearest hit so far
+// --------------------------------------------------------
+TEST(SceneBvhCastRay) {
+	BoundsStreams bounds;
+	MakeBounds(SCENE_BVH_TEST_ITEMS, 3, bounds);
+	SceneBvh bvh;
+	bvh.Build(bounds);
+	BruteForce expected(bounds, 4);
+
+	unsigned int mismatches = 0;
+	unsigned int beyondNearest = 0;
+	unsigned int hits = 0;
+	for (size_t q = 0; q < expected.Rays.size(); q++) {
+		const SceneBvhRay& ray = expected.Rays[q];
+		float inverseDirection[3] = { 1.0f / ray.Direction[0], 1.0f / ray.Direction[1], 1.0f / ray.Direction[2] };
+
+		//Boxes count as hits where the ray enters them
+		uint32_t nearest = UINT32_MAX;
+		bool found = bvh.CastRay(ray, [&](uint32_t item, float& maxDistance) {
+			float distance;
+			SceneBvhRay clipped = ray;
+			clipped.MaxDistance = FLT_MAX;
+			SceneBvh::IntersectRay(clipped, inverseDirection, GetBox(bounds, item), distance);
+			if (distance > maxDistance) {
+				beyondNearest++;
+				return false;
+			}
+
+			maxDistance = distance;
+			nearest = item;
+			return true;
+		});
+
+		if (found != !expected.RayItems[q].empty()) mismatches++;
+		if (!found) continue;
+
+		hits++;
+		float distance;
+		SceneBvh::IntersectRay(ray, inverseDirection, GetBox(bounds, nearest), distance);
+		if (distance != expected.Nearest[q]) mismatches++;
+	}
+	CHECK_EQUAL(mismatches, 0u);
+	CHECK_EQUAL(beyondNearest, 0u);
+	CHECK(hits > 0u);
+
+	//Nothing accepted means nothing found
+	CHECK(!bvh.CastRay(expected.Rays[0], [](uint32_t, float&) { return false; }));
+}
+
+// --------------------------------------------------------
+// Added items are found before the background rebuild takes
+// them in, and after it, and removing items rebuilds at once
+// --------------------------------------------------------
+TEST(SceneBvhUpdate) {
+	JobSystem::GetInstance().Initialize(3);
+
+	//The tree waits for any rebuild it started, so it goes before the workers
+	{
+		BoundsStreams bounds;
+		MakeBounds(SCENE_BVH_TEST_ITEMS, 5, bounds);
+		SceneBvh bvh;
+		bvh.Build(bounds);
+
+		//More items, checked one by one until the rebuild lands
+		MakeBounds(SCENE_BVH_TEST_ITEMS + 300, 5, bounds);
+		bvh.Update(bounds);
+		CHECK_EQUAL(bvh.GetItemCount(), (size_t)(SCENE_BVH_TEST_ITEMS + 300));
+		CHECK_EQUAL(bvh.GetUnindexedCount(), (size_t)300);
+		CHECK(bvh.IsRebuilding());
+		CHECK_EQUAL(CountMismatches(bvh, BruteForce(bounds, 6)), 0u);
+
+		unsigned int rebuilds = bvh.GetRebuildCount();
+		while (bvh.GetRebuildCount() == rebuilds) {
+			std::this_thread::yield();
+			bvh.Update(bounds);
+		}
+		CHECK(!bvh.IsRebuilding());
+		CHECK_EQUAL(bvh.GetUnindexedCount(), (size_t)0);
+		CHECK_EQUAL(CountMismatches(bvh, BruteForce(bounds, 7)), 0u);
+
+		//Everything moves, so the tree is refitted
+		MakeBounds(SCENE_BVH_TEST_ITEMS + 300, 8, bounds);
+		bvh.Update(bounds);
+		CHECK_EQUAL(CountMismatches(bvh, BruteForce(bounds, 9)), 0u);
+
+		//Fewer items
+		MakeBounds(SCENE_BVH_TEST_ITEMS / 2, 10, bounds);
+		bvh.Update(bounds);
+		CHECK_EQUAL(bvh.GetItemCount(), (size_t)(SCENE_BVH_TEST_ITEMS / 2));
+		CHECK_EQUAL(bvh.GetUnindexedCount(), (size_t)0);
+		CHECK_EQUAL(CountMismatches(bvh, BruteForce(bounds, 11)), 0u);
+	}
+
+	JobSystem::GetInstance().ShutDown();
+}
+
+// --------------------------------------------------------
+// A walk's stack holds one entry per level plus the root,
+// moving to the heap for trees deeper than it keeps inline
+// --------------------------------------------------------
+TEST(SceneBvhStackOverflowsToHeap) {
+	for (uint32_t depth : { 0u, (uint32_t)SCENE_BVH_STACK_SIZE - 1, (uint32_t)SCENE_BVH_STACK_SIZE * 3 }) {
+		SceneBvhStack<uint32_t> stack(depth);
+		CHECK(stack.IsEmpty());
+
+		for (uint32_t i = 0; i <= depth; i++) stack.Push(i * 7);
+
+		bool inOrder = true;
+		for (uint32_t i = depth + 1; i-- > 0;) inOrder = inOrder && stack.Pop() == i * 7;
+		CHECK(inOrder);
+		CHECK(stack.IsEmpty());
+	}
+}
+
+#ifdef MEMORY_TRACK_HEAP
+
+// --------------------------------------------------------
+// Walking the tree doesn't touch the heap, so a query made
+// every frame into a kept list doesn't either
+// --------------------------------------------------------
+TEST(SceneBvhQueriesDontAllocate) {
+	BoundsStreams bounds;
+	MakeBounds(SCENE_BVH_TEST_ITEMS, 12, bounds);
+	SceneBvh bvh;
+	bvh.Build(bounds);
+	CHECK(bvh.GetDepth() < (uint32_t)SCENE_BVH_STACK_SIZE);
+
+	const float min[3] = { -20.0f, -20.0f, -20.0f };
+	const float max[3] = { 20.0f, 20.0f, 20.0f };
+	SceneBvhFrustum frustum = MakeBoxFrustum(min, max);
+	SceneBvhRay ray = { { -60.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, 120.0f };
+
+	std::vector<uint32_t> items;
+	bvh.QueryFrustum(frustum, items);
+
+	uint64_t before = MemoryTracker::GetThreadAllocationCount();
+	for (int frame = 0; frame < 10; frame++) {
+		items.clear();
+		bvh.QueryFrustum(frustum, items);
+
+		//More captured than a std::function keeps inline
+		uint32_t nearest = UINT32_MAX;
+		float offsets[4] = {};
+		bvh.CastRay(ray, [&nearest, &offsets, &bounds, &frame](uint32_t item, float& maxDistance) {
+			nearest = item;
+			maxDistance = (std::max)(maxDistance * 0.9f, offsets[frame % 4] + bounds.ExtentX[item]);
+			return true;
+		});
+	}
+	CHECK_EQUAL(MemoryTracker::GetThreadAllocationCount() - before, (uint64_t)0);
+}
+
+#endif
@@ -0,0 +1,273 @@
+#include "Test.h"
+
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include "../SceneFile.h"
+
+// Where the tests write their scenes, in the working directory
+static const char* TEXT_PATH = "SceneFileTest.scene";
+static const wchar_t* TEXT_PATH_WIDE = L"SceneFileTest.scene";
+static const char* BINARY_PATH = "SceneFileTest.scenebin";
+static const wchar_t* BINARY_PATH_WIDE = L"SceneFileTest.scenebin";
+
+static const char* FULL_SCENE =
+	"# Everything the format has\n"
+	"ambient 0.1 0.2 0.3\n"
+	"texture bricks \"Textures/Bricks Color.png\"\n"
+	"texture bricksNormal \"Textures/bricks_normal.png\"\n"
+	"mesh cube \"Models/cube.obj\"\n"
+	"mesh sphere \"Models/sphere.obj\"\n"
+	"\n"
+	"material wall VertexShader.cso NormalMapPS.cso tint 1 0.5 0.25 1 roughness 0.75\n"
+	"map SurfaceTexture bricks\n"
+	"map NormalMap bricksNormal\n"
+	"material plain VertexShader.cso PixelShader.cso\n"
+	"\n"
+	"sky cube \"right.png\" \"left.png\" \"up.png\" \"down.png\" \"front.png\" \"back.png\"\n"
+	"light directional direction 0 -1 0 color 1 1 1 intensity 2\n"
+	"light spot position 1 2 3 direction 0 0 1 range 10 falloff 25\n"
+	"camera position 0 1 -5 rotation 90 0 0 fov 45\n"
+	"entity cube wall position 1 2 3 rotation 0 180 0 scale 2 2 2 static\n"
+	"entity sphere plain   # Defaults for everything else\n";
+
+static bool WriteFile(const char* path, const void* data, size_t size) {
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	out.write((const char*)data, size);
+	return out.good();
+}
+
+static bool Parse(const char* text, SceneBuilder& builder, std::string& error) {
+	return SceneFile::ParseText(text, strlen(text), builder, error);
+}
+
+// --------------------------------------------------------
+// Every keyword, read back from the compiled scene
+// --------------------------------------------------------
+TEST(SceneFileParse) {
+	CHECK(WriteFile(TEXT_PATH, FULL_SCENE, strlen(FULL_SCENE)));
+
+	SceneFile scene;
+	CHECK(scene.LoadText(TEXT_PATH_WIDE));
+	CHECK(scene.GetError().empty());
+	CHECK(!scene.IsMapped());
+
+	CHECK_EQUAL(scene.GetEnvironment().AmbientColor[2], 0.3f);
+
+	CHECK_EQUAL(scene.GetTextures().Count, (size_t)2);
+	CHECK_EQUAL(std::string(scene.GetString(scene.GetTextures()[0].Path)), std::string("Textures/Bricks Color.png"));
+
+	SceneArray<SceneMaterial> materials = scene.GetMaterials();
+	CHECK_EQUAL(materials.Count, (size_t)2);
+	CHECK_EQUAL(materials[0].Tint[1], 0.5f);
+	CHECK_EQUAL(materials[0].Roughness, 0.75f);
+	CHECK_EQUAL(materials[0].TextureCount, 2u);
+	CHECK_EQUAL(materials[1].TextureCount, 0u);
+	CHECK_EQUAL(materials[1].Tint[0], 1.0f);
+	CHECK_EQUAL(std::string(scene.GetString(materials[1].PixelShader)), std::string("PixelShader.cso"));
+
+	SceneArray<SceneMaterialTexture> maps = scene.GetMaterialTextures();
+	CHECK_EQUAL(std::string(scene.GetString(maps[1].Slot)), std::string("NormalMap"));
+	CHECK_EQUAL(maps[1].Texture, 1u);
+
+	const SceneEnvironment& environment = scene.GetEnvironment();
+	CHECK_EQUAL(environment.SkyMesh, 0u);
+	CHECK_EQUAL(std::string(scene.GetString(environment.SkyFaces[5])), std::string("back.png"));
+
+	SceneArray<SceneLight> lights = scene.GetLights();
+	CHECK_EQUAL(lights.Count, (size_t)2);
+	CHECK_EQUAL(lights[0].Type, SCENE_LIGHT_DIRECTIONAL);
+	CHECK_EQUAL(lights[0].Intensity, 2.0f);
+	CHECK_EQUAL(lights[1].Type, SCENE_LIGHT_SPOT);
+	CHECK_EQUAL(lights[1].Position[1], 2.0f);
+	CHECK_EQUAL(lights[1].SpotFalloff, 25.0f);
+
+	//Degrees in the text, radians once loaded
+	SceneArray<SceneCamera> cameras = scene.GetCameras();
+	CHECK_EQUAL(cameras.Count, (size_t)1);
+	CHECK_NEAR(cameras[0].Rotation[0], 3.14159265f / 2.0f, 1e-5f);
+	CHECK_NEAR(cameras[0].FieldOfView, 3.14159265f / 4.0f, 1e-5f);
+	CHECK_EQUAL(cameras[0].MoveSpeed, 5.0f);
+
+	CHECK_EQUAL(scene.GetEntityCount(), (size_t)2);
+	SceneArray<SceneTransform> transforms = scene.GetTransforms();
+	SceneArray<SceneRenderable> renderables = scene.GetRenderables();
+	CHECK_NEAR(transforms[0].Rotation[1], 3.14159265f, 1e-5f);
+	CHECK_EQUAL(transforms[0].Scale[2], 2.0f);
+	CHECK_EQUAL(renderables[0].Flags, (uint32_t)SCENE_ENTITY_STATIC);
+	CHECK_EQUAL(transforms[1].Scale[0], 1.0f);
+	CHECK_EQUAL(renderables[1].Mesh, 1u);
+	CHECK_EQUAL(renderables[1].Material, 1u);
+	CHECK_EQUAL(renderables[1].Flags, 0u);
+}
+
+// --------------------------------------------------------
+// Malformed lines and references to things that aren't
+// defined (yet) fail, naming the line
+// --------------------------------------------------------
+TEST(SceneFileParseErrors) {
+	struct BadScene {
+		const char* Text;
+		const char* Error;
+	};
+
+	const char* header =
+		"mesh cube \"cube.obj\"\n"
+		"texture bricks \"bricks.png\"\n"
+		"material plain VertexShader.cso PixelShader.cso\n";
+
+	const BadScene scenes[] = {
+		{ "fog 1 2 3\n", "Line 4: Unknown keyword 'fog'" },
+		{ "ambient 1 x 0\n", "Line 4: Expected ambient r g b" },
+		{ "ambient 1 1\n", "Line 4: Expected ambient r g b" },
+		{ "mesh cube \"other.obj\"\n", "Line 4: 'cube' is already defined" },
+		{ "material plain VertexShader.cso PixelShader.cso\n", "Line 4: 'plain' is already defined" },
+		{ "texture lonely\n", "Line 4: Expected a name and a path" },
+		{ "material wall VertexShader.cso PixelShader.cso shine 2\n", "Line 4: Unexpected 'shine'" },
+		{ "material wall VertexShader.cso PixelShader.cso tint 1 1 1\n", "Line 4: Unexpected 'tint'" },
+		{ "map SurfaceTexture stone\n", "Line 4: No texture named 'stone'" },
+		{ "sky sphere a b c d e f\n", "Line 4: No mesh named 'sphere'" },
+		{ "sky cube a b c\n", "Line 4: Expected a mesh and six faces" },
+		{ "light area\n", "Line 4: Unknown light type 'area'" },
+		{ "light point range\n", "Line 4: Unexpected 'range'" },
+		{ "camera zoom 2\n", "Line 4: Unexpected 'zoom'" },
+		{ "entity sphere plain\n", "Line 4: No mesh named 'sphere'" },
+		{ "entity cube wall\n", "Line 4: No material named 'wall'" },
+		{ "entity cube\n", "Line 4: Expected a mesh and a material" },
+		{ "entity cube plain scale 1 1\n", "Line 4: Unexpected 'scale'" },
+		{ "\n# Fine\nentity cube plain\nentity cube plain flying\n", "Line 7: Unexpected 'flying'" },
+		{ "entity cube plain 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20 21 22 23 24 25 26 27 28 29 30\n", "Line 4: Too many values" },
+	};
+
+	for (const BadScene& bad : scenes) {
+		SceneBuilder builder;
+		std::string error;
+		CHECK(!Parse((std::string(header) + bad.Text).c_str(), builder, error));
+		CHECK_EQUAL(error, std::string(bad.Error));
+		if (error != bad.Error) printf("  got \"%s\"\n", error.c_str());
+	}
+
+	//References have to come after what they refer to
+	SceneBuilder builder;
+	std::string error;
+	CHECK(!Parse("map SurfaceTexture bricks\ntexture bricks \"bricks.png\"\n", builder, error));
+	CHECK_EQUAL(error, std::string("Line 1: No texture named 'bricks'"));
+
+	SceneBuilder noMaterial;
+	CHECK(!Parse("texture bricks \"bricks.png\"\nmap SurfaceTexture bricks\n", noMaterial, error));
+	CHECK_EQUAL(error, std::string("Line 2: Map before any material"));
+
+	//Comments, blank lines, tabs and Windows line endings are all fine
+	SceneBuilder fine;
+	CHECK(Parse("# Comment\r\n\r\n\tmesh cube \"cube.obj\" # Trailing\r\n", fine, error));
+	CHECK_EQUAL(fine.FindMesh("cube"), 0u);
+	CHECK_EQUAL(fine.FindMesh("sphere"), (uint32_t)SCENE_NONE);
+}
+
+// --------------------------------------------------------
+// Text out, text in, binary out and binary in, with nothing
+// lost along the way
+// --------------------------------------------------------
+TEST(SceneFileRoundTrip) {
+	SceneBuilder builder;
+	std::string error;
+	CHECK(Parse(FULL_SCENE, builder, error));
+	CHECK(builder.WriteText(TEXT_PATH_WIDE));
+
+	SceneFile text;
+	CHECK(text.Load(TEXT_PATH_WIDE));
+	CHECK(text.WriteBinary(BINARY_PATH_WIDE));
+
+	SceneFile binary;
+	CHECK(binary.Load(BINARY_PATH_WIDE));
+	CHECK(binary.IsMapped());
+	CHECK_EQUAL(binary.GetByteSize(), text.GetByteSize());
+
+	//Compiled from the same records, so the images match exactly
+	std::vector<uint8_t> image = builder.Build();
+	CHECK_EQUAL(binary.GetByteSize(), image.size());
+	CHECK_EQUAL(binary.GetEntityCount(), (size_t)2);
+	CHECK_EQUAL(binary.GetLights()[1].Range, 10.0f);
+	CHECK_NEAR(binary.GetTransforms()[0].Rotation[1], 3.14159265f, 1e-5f);
+	CHECK_EQUAL(binary.GetRenderables()[0].Flags, (uint32_t)SCENE_ENTITY_STATIC);
+	CHECK_EQUAL(std::string(binary.GetString(binary.GetTextures()[0].Path)), std::string("Textures/Bricks Color.png"));
+	CHECK_EQUAL(std::string(binary.GetString(SCENE_NONE)), std::string(""));
+
+	//Only a hint, so past the end is fine
+	binary.Prefetch(0, SCENE_STREAM_CHUNK_SIZE);
+	binary.Prefetch(5, 1);
+}
+
+// --------------------------------------------------------
+// Compiled scenes that are cut short, from elsewhere, or
+// point outside themselves are rejected
+// --------------------------------------------------------
+TEST(SceneFileCorrupt) {
+	SceneBuilder builder;
+	std::string error;
+	CHECK(Parse(FULL_SCENE, builder, error));
+	const std::vector<uint8_t> image = builder.Build();
+
+	SceneFileHeader header;
+	memcpy(&header, image.data(), sizeof(header));
+	const size_t tableOffset = sizeof(SceneFileHeader);
+
+	//Loads, then fails with the given error
+	auto expectError = [](const std::vector<uint8_t>& bytes, const char* expected) {
+		CHECK(WriteFile(BINARY_PATH, bytes.data(), bytes.size()));
+		SceneFile scene;
+		CHECK(!scene.LoadBinary(BINARY_PATH_WIDE));
+		CHECK_EQUAL(scene.GetError(), std::string(expected));
+		CHECK(!scene.IsMapped());
+		CHECK_EQUAL(scene.GetEntityCount(), (size_t)0);
+	};
+
+	expectError(std::vector<uint8_t>(image.begin(), image.begin() + 8), "The scene is too small to be compiled");
+
+	std::vector<uint8_t> bytes = image;
+	bytes[0] = 'X';
+	expectError(bytes, "Not a compiled scene");
+
+	bytes = image;
+	bytes[4]++;
+	expectError(bytes, "Compiled with a different version, recompile the scene");
+
+	//Cut off partway through the entities
+	SceneChunkHeader transforms;
+	memcpy(&transforms, image.data() + tableOffset + (int)SceneChunk::Transforms * sizeof(SceneChunkHeader), sizeof(transforms));
+	bytes.assign(image.begin(), image.begin() + (size_t)transforms.Offset + 4);
+	expectError(bytes, ("Chunk " + std::to_string((int)SceneChunk::Transforms) + " is corrupt").c_str());
+
+	//A material's texture that isn't there
+	SceneChunkHeader materialTextures;
+	memcpy(&materialTextures, image.data() + tableOffset + (int)SceneChunk::MaterialTextures * sizeof(SceneChunkHeader), sizeof(materialTextures));
+	bytes = image;
+	SceneMaterialTexture map;
+	memcpy(&map, bytes.data() + materialTextures.Offset, sizeof(map));
+	map.Texture = 7;
+	memcpy(bytes.data() + materialTextures.Offset, &map, sizeof(map));
+	expectError(bytes, "Material texture is out of range");
+
+	//A light of a type the shaders don't have
+	SceneChunkHeader lights;
+	memcpy(&lights, image.data() + tableOffset + (int)SceneChunk::Lights * sizeof(SceneChunkHeader), sizeof(lights));
+	bytes = image;
+	int type = 9;
+	memcpy(bytes.data() + lights.Offset, &type, sizeof(type));
+	expectError(bytes, "Light has an unknown type");
+
+	//Missing files don't open at all
+	SceneFile missing;
+	CHECK(!missing.Load(L"SceneFileTestMissing.scenebin"));
+	CHECK_EQUAL(missing.GetError(), std::string("Couldn't open the scene"));
+	CHECK(!missing.Load(L"SceneFileTestMissing.scene"));
+	CHECK_EQUAL(missing.GetError(), std::string("Couldn't open the scene"));
+
+	//And the original still loads
+	CHECK(WriteFile(BINARY_PATH, image.data(), image.size()));
+	SceneFile scene;
+	CHECK(scene.LoadBinary(BINARY_PATH_WIDE));
+	CHECK_EQUAL(scene.GetEntityCount(), (size_t)2);
+	CHECK_EQUAL(header.ChunkCount, (uint32_t)SceneChunk::Count);
+}
@@ -0,0 +1,139 @@
+#include "Test.h"
+
+#include <string>
+#include <vector>
+
+#include "../ShaderDependencyGraph.h"
+
+typedef std::vector<std::string> Files;
+
+static void SetText(ShaderDependencyGraph& graph, const std::string& file, const std::string& text) {
+	graph.SetIncludes(file, ShaderDependencyGraph::ParseIncludes(text.c_str(), text.size()));
+}
+
+TEST(ShaderDependencyGraphNormalizePath) {
+	CHECK(ShaderDependencyGraph::NormalizePath("Shaders\\Lighting.HLSLI") == "shaders/lighting.hlsli");
+	CHECK(ShaderDependencyGraph::NormalizePath("./a/./b//c.hlsl") == "a/b/c.hlsl");
+	CHECK(ShaderDependencyGraph::NormalizePath("a/b/../c.hlsl") == "a/c.hlsl");
+	CHECK(ShaderDependencyGraph::NormalizePath("../../a.hlsl") == "../../a.hlsl");
+	CHECK(ShaderDependencyGraph::NormalizePath("a/../../b.hlsl") == "../b.hlsl");
+}
+
+// --------------------------------------------------------
+// Both kinds of include are found, with or without spaces
+// after the #, and commented out ones aren't
+// --------------------------------------------------------
+TEST(ShaderDependencyGraphParseIncludes) {
+	std::string text =
+		"#include \"Lighting.hlsli\"\n"
+		"  #  include <Common/Math.hlsli>\r\n"
+		"// #include \"Commented.hlsli\"\n"
+		"#define INCLUDE_NOTHING\n"
+		"#include \"\"\n"
+		"#include \"Unclosed.hlsli\n"
+		"float4 main() : SV_TARGET { return 0; }\n"
+		"#include \"Last.hlsli\"";
+
+	Files names = ShaderDependencyGraph::ParseIncludes(text.c_str(), text.size());
+	CHECK(names == Files({ "Lighting.hlsli", "Common/Math.hlsli", "Last.hlsli" }));
+}
+
+// --------------------------------------------------------
+// A header shared through a diamond finds each shader once,
+// and resolves relative to each including file's folder
+// --------------------------------------------------------
+TEST(ShaderDependencyGraphDependents) {
+	ShaderDependencyGraph graph;
+	SetText(graph, "Shaders/PixelShader.hlsl", "#include \"Lighting.hlsli\"\n#include \"Common/Math.hlsli\"\n");
+	SetText(graph, "Shaders/VertexShader.hlsl", "#include \"Common/Math.hlsli\"\n");
+	SetText(graph, "Shaders/SkyPixelShader.hlsl", "#include \"Sky.hlsli\"\n");
+	SetText(graph, "Shaders/Lighting.hlsli", "#include \"Common/Math.hlsli\"\n");
+	SetText(graph, "Shaders/Common/Math.hlsli", "#include \"../Constants.hlsli\"\n");
+
+	CHECK(graph.GetDependents("shaders/common/math.hlsli") == Files({
+		"shaders/common/math.hlsli", "shaders/lighting.hlsli", "shaders/pixelshader.hlsl", "shaders/vertexshader.hlsl" }));
+	CHECK(graph.GetDependents("Shaders\\Constants.hlsli") == Files({
+		"shaders/common/math.hlsli", "shaders/constants.hlsli", "shaders/lighting.hlsli",
+		"shaders/pixelshader.hlsl", "shaders/vertexshader.hlsl" }));
+	CHECK(graph.GetDependents("Shaders/Lighting.hlsli") == Files({ "shaders/lighting.hlsli", "shaders/pixelshader.hlsl" }));
+
+	//Nothing includes a shader, and unknown files are just themselves
+	CHECK(graph.GetDependents("Shaders/SkyPixelShader.hlsl") == Files({ "shaders/skypixelshader.hlsl" }));
+	CHECK(graph.GetDependents("Shaders/Missing.hlsli") == Files({ "shaders/missing.hlsli" }));
+
+	CHECK(graph.GetUnscannedFiles() == Files({ "shaders/constants.hlsli", "shaders/sky.hlsli" }));
+	CHECK_EQUAL(graph.GetFiles().size(), (size_t)7);
+}
+
+// --------------------------------------------------------
+// Headers including each other still finish, with every
+// file in the cycle depending on every other
+// --------------------------------------------------------
+TEST(ShaderDependencyGraphCycles) {
+	ShaderDependencyGraph graph;
+	SetText(graph, "A.hlsli", "#include \"B.hlsli\"\n");
+	SetText(graph, "B.hlsli", "#include \"C.hlsli\"\n");
+	SetText(graph, "C.hlsli", "#include \"A.hlsli\"\n#include \"C.hlsli\"\n");
+	SetText(graph, "Shader.hlsl", "#include \"B.hlsli\"\n");
+
+	Files all = { "a.hlsli", "b.hlsli", "c.hlsli", "shader.hlsl" };
+	CHECK(graph.GetDependents("A.hlsli") == all);
+	CHECK(graph.GetDependents("C.hlsli") == all);
+	CHECK(graph.GetDependents("Shader.hlsl") == Files({ "shader.hlsl" }));
+}
+
+// --------------------------------------------------------
+// Rescanning a file replaces what it includes, so an include
+// that was taken out stops making it a dependent
+// --------------------------------------------------------
+TEST(ShaderDependencyGraphRescan) {
+	ShaderDependencyGraph graph;
+	SetText(graph, "Shader.hlsl", "#include \"Old.hlsli\"\n#include \"Old.hlsli\"\n");
+	CHECK(graph.Contains("shader.HLSL"));
+	CHECK(!graph.Contains("Old.hlsli"));
+	CHECK(graph.GetDependents("Old.hlsli") == Files({ "old.hlsli", "shader.hlsl" }));
+
+	SetText(graph, "Shader.hlsl", "#include \"New.hlsli\"\n");
+	CHECK(graph.GetDependents("Old.hlsli") == Files({ "old.hlsli" }));
+	CHECK(graph.GetDependents("New.hlsli") == Files({ "new.hlsli", "shader.hlsl" }));
+	CHECK(graph.GetUnscannedFiles() == Files({ "new.hlsli" }));
+}
+
+// --------------------------------------------------------
+// A file comes out once it's been quiet for the delay, and
+// each new change starts the wait again
+// --------------------------------------------------------
+TEST(ShaderDependencyGraphDebouncerWaits) {
+	ChangeDebouncer debouncer(0.25);
+	debouncer.Record("a.hlsl", 1.0);
+	CHECK(debouncer.TakeReady(1.1).empty());
+
+	//An editor's second write pushes it back
+	debouncer.Record("a.hlsl", 1.2);
+	CHECK(debouncer.TakeReady(1.3).empty());
+	CHECK_EQUAL(debouncer.GetPendingCount(), (size_t)1);
+
+	CHECK(debouncer.TakeReady(1.5) == Files({ "a.hlsl" }));
+	CHECK_EQUAL(debouncer.GetPendingCount(), (size_t)0);
+
+	//Taken files don't come out again
+	CHECK(debouncer.TakeReady(10.0).empty());
+}
+
+TEST(ShaderDependencyGraphDebouncerSeveralFiles) {
+	ChangeDebouncer debouncer(0.5);
+	debouncer.Record("c.hlsl", 0.0);
+	debouncer.Record("a.hlsl", 0.1);
+	debouncer.Record("b.hlsl", 0.4);
+	CHECK_EQUAL(debouncer.GetPendingCount(), (size_t)3);
+
+	//Sorted, and only the settled ones
+	CHECK(debouncer.TakeReady(0.6) == Files({ "a.hlsl", "c.hlsl" }));
+	CHECK_EQUAL(debouncer.GetPendingCount(), (size_t)1);
+	CHECK(debouncer.TakeReady(0.9) == Files({ "b.hlsl" }));
+
+	//No delay lets everything straight through
+	ChangeDebouncer immediate(0.0);
+	immediate.Record("x.hlsl", 2.0);
+	CHECK(immediate.TakeReady(2.0) == Files({ "x.hlsl" }));
+}
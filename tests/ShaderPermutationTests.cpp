@@ -0,0 +1,237 @@
+#include "Test.h"
+
+#include <cstring>
+#include <set>
+#include <string>
+
+#include "../ShaderPermutation.h"
+
+static const char* source =
+	"// A shader with three keywords\r\n"
+	"  //@keyword NORMAL_MAP exact 0 1 binds NormalMap\r\n"
+	"//@keyword QUALITY ordered 0 1 2\n"
+	"\t//@keyword SHADOWS exact 0 1\n"
+	"float4 main() : SV_TARGET { return 0; }\n";
+
+static ShaderPermutationSet MakeSet() {
+	ShaderPermutationSet set;
+	set.Shader = "PixelShader";
+	set.Source = "PixelShader.hlsl";
+	set.Profile = "ps_5_0";
+
+	std::string error;
+	ShaderPermutationSet::Parse(source, strlen(source), set, error);
+	return set;
+}
+
+static ShaderVariant MakeVariant(ShaderPermutationKey key, uint32_t cost) {
+	ShaderVariant variant;
+	variant.Key = key;
+	variant.File = "Variant" + std::to_string(key) + ".cso";
+	variant.Cost = cost;
+	return variant;
+}
+
+static bool Parses(const char* text, std::string& error) {
+	ShaderManifest manifest;
+	return manifest.Parse(text, strlen(text), error);
+}
+
+// --------------------------------------------------------
+// Keywords come out of the source's comments, and every
+// variant's key gives back its own values
+//  - Keys count through the values with the first keyword
+//     changing fastest, and pack into 1 + 2 + 1 bits
+// --------------------------------------------------------
+TEST(ShaderPermutationKeys) {
+	ShaderPermutationSet set;
+	std::string error;
+	CHECK(ShaderPermutationSet::Parse(source, strlen(source), set, error));
+	CHECK_EQUAL(set.Keywords.size(), (size_t)3);
+	CHECK(!set.Keywords[0].Ordered);
+	CHECK(set.Keywords[1].Ordered);
+	CHECK_EQUAL(set.Keywords[0].Bindings.size(), (size_t)1);
+	CHECK_EQUAL(set.Keywords[0].Bindings[0], std::string("NormalMap"));
+	CHECK_EQUAL(set.Keywords[1].GetBitCount(), 2u);
+	CHECK_EQUAL(set.GetVariantCount(), 12u);
+
+	std::set<ShaderPermutationKey> keys;
+	for (uint32_t variant = 0; variant < set.GetVariantCount(); variant++) {
+		ShaderPermutationKey key = set.GetKey(variant);
+		CHECK(key < 16u);
+		keys.insert(key);
+
+		CHECK_EQUAL(set.GetValue(key, 0), (int)(variant % 2));
+		CHECK_EQUAL(set.GetValue(key, 1), (int)(variant / 2 % 3));
+		CHECK_EQUAL(set.GetValue(key, 2), (int)(variant / 6));
+	}
+	CHECK_EQUAL(keys.size(), (size_t)12);
+
+	//A key past the last value reads as the last value
+	CHECK_EQUAL(set.GetValue(3u << 1, 1), 2);
+
+	std::vector<std::pair<std::string, std::string>> defines = set.GetDefines(5);
+	CHECK_EQUAL(defines.size(), (size_t)3);
+	CHECK_EQUAL(defines[1].first, std::string("QUALITY"));
+	CHECK_EQUAL(defines[1].second, std::string("2"));
+}
+
+// --------------------------------------------------------
+// Exact keywords need the value asked for, ordered ones
+// take anything at least as high, and keywords left out of
+// the request want their first value
+// --------------------------------------------------------
+TEST(ShaderPermutationMatches) {
+	ShaderPermutationSet set = MakeSet();
+
+	//NORMAL_MAP 1, QUALITY 1, SHADOWS 0
+	ShaderPermutationKey key = 1 | (1 << 1);
+
+	ShaderFeatureRequest request;
+	request.Values["NORMAL_MAP"] = 1;
+	request.Values["QUALITY"] = 1;
+	CHECK(set.Matches(key, request));
+
+	request.Values["QUALITY"] = 0;
+	CHECK(set.Matches(key, request));
+
+	request.Values["QUALITY"] = 2;
+	CHECK(!set.Matches(key, request));
+
+	request.Values["QUALITY"] = 1;
+	request.Values["NORMAL_MAP"] = 0;
+	CHECK(!set.Matches(key, request));
+
+	request.Values["NORMAL_MAP"] = 1;
+	request.Values["SHADOWS"] = 1;
+	CHECK(!set.Matches(key, request));
+
+	ShaderFeatureRequest empty;
+	CHECK(!set.Matches(key, empty));
+	CHECK(set.Matches(0, empty));
+}
+
+// --------------------------------------------------------
+// The cheapest variant that supports a request wins, with
+// ties going to the lower key whatever order they're in
+// --------------------------------------------------------
+TEST(ShaderPermutationSelect) {
+	ShaderManifest manifest;
+	manifest.AddShader(MakeSet());
+	manifest.AddVariant(MakeVariant(4, 300));	// QUALITY 2
+	manifest.AddVariant(MakeVariant(3, 200));	// NORMAL_MAP 1, QUALITY 1
+	manifest.AddVariant(MakeVariant(2, 150));	// QUALITY 1
+	manifest.AddVariant(MakeVariant(0, 100));
+	manifest.AddVariant(MakeVariant(10, 150));	// QUALITY 1, SHADOWS 1
+
+	ShaderFeatureRequest request;
+	const ShaderVariant* selected = manifest.Select("PixelShader", request);
+	CHECK(selected != 0);
+	if (selected) CHECK_EQUAL(selected->Key, 0u);
+
+	//Both quality 1 and 2 do, and 1 is cheaper
+	request.Values["QUALITY"] = 1;
+	selected = manifest.Select("PixelShader", request);
+	CHECK(selected != 0);
+	if (selected) CHECK_EQUAL(selected->Key, 2u);
+
+	request.Values["NORMAL_MAP"] = 1;
+	selected = manifest.Select("PixelShader", request);
+	CHECK(selected != 0);
+	if (selected) CHECK_EQUAL(selected->Cost, 200u);
+
+	//Nothing built has shadows and a normal map
+	request.Values["SHADOWS"] = 1;
+	CHECK(manifest.Select("PixelShader", request) == 0);
+	CHECK(manifest.Select("VertexShader", request) == 0);
+
+	//Same cost, so the lower key, added after the higher one
+	manifest.AddVariant(MakeVariant(5, 300));
+	manifest.AddVariant(MakeVariant(11, 120));	// NORMAL_MAP 1, QUALITY 1, SHADOWS 1
+	manifest.AddVariant(MakeVariant(9, 120));	// NORMAL_MAP 1, SHADOWS 1
+	request.Values["QUALITY"] = 0;
+	selected = manifest.Select("PixelShader", request);
+	CHECK(selected != 0);
+	if (selected) CHECK_EQUAL(selected->Key, 9u);
+}
+
+// --------------------------------------------------------
+// A written manifest reads back the same, and bad lines
+// name themselves
+// --------------------------------------------------------
+TEST(ShaderPermutationManifest) {
+	ShaderManifest manifest;
+	manifest.AddShader(MakeSet());
+	manifest.AddVariant(MakeVariant(0, 100));
+	manifest.AddVariant(MakeVariant(5, 250));
+
+	ShaderPermutationSet other;
+	other.Shader = "SkyShader";
+	other.Source = "SkyShader.hlsl";
+	other.Profile = "ps_5_0";
+	manifest.AddShader(other);
+
+	std::string text = manifest.Write();
+	ShaderManifest read;
+	std::string error;
+	CHECK(read.Parse(text.c_str(), text.size(), error));
+	CHECK_EQUAL(read.GetShaderCount(), (size_t)2);
+	CHECK_EQUAL(read.GetVariantCount(), (size_t)2);
+	CHECK_EQUAL(read.Write(), text);
+
+	const ShaderPermutationSet* set = read.FindShader("PixelShader");
+	CHECK(set != 0);
+	if (set) {
+		CHECK_EQUAL(set->Profile, std::string("ps_5_0"));
+		CHECK_EQUAL(set->Keywords.size(), (size_t)3);
+		CHECK(set->Keywords[1].Ordered);
+		CHECK_EQUAL(set->Keywords[0].Bindings[0], std::string("NormalMap"));
+	}
+	CHECK_EQUAL((*read.FindVariants("PixelShader"))[1].File, std::string("Variant5.cso"));
+	CHECK(read.FindVariants("SkyShader")->empty());
+
+	//Each bad line, after a good first one
+	CHECK(!Parses("shader A A.hlsl ps_5_0\nkeyword X sometimes 0 1\n", error));
+	CHECK(error.find("Line 2") == 0);
+	CHECK(!Parses("shader A A.hlsl ps_5_0\nkeyword X ordered 1 0\n", error));
+	CHECK(!Parses("shader A A.hlsl ps_5_0\nkeyword X exact 0 1 binds\n", error));
+	CHECK(!Parses("shader A A.hlsl ps_5_0\nvariant -1 A.cso 10\n", error));
+	CHECK(!Parses("shader A A.hlsl ps_5_0\nvariant 1 A.cso many\n", error));
+	CHECK(!Parses("shader A A.hlsl\n", error));
+	CHECK(!Parses("keyword X exact 0 1\n", error));
+	CHECK(!Parses("shader A A.hlsl ps_5_0\nkeyword X exact 0 1\nkeyword X exact 0 1\n", error));
+	CHECK(error.find("A: ") == 0);
+
+	//A failed parse leaves nothing behind
+	CHECK(!read.Parse("shader A A.hlsl\n", 16, error));
+	CHECK_EQUAL(read.GetShaderCount(), (size_t)0);
+}
+
+// --------------------------------------------------------
+// Variant files are named after the defines, so the same
+// defines always give the same file and anything else a
+// different one
+//  - The value is FNV-1a of
+//     "PixelShader;NORMAL_MAP=1;QUALITY=2;SHADOWS=0"
+// --------------------------------------------------------
+TEST(ShaderPermutationHash) {
+	ShaderPermutationSet set = MakeSet();
+	ShaderPermutationKey key = 1 | (2 << 1);
+	CHECK_EQUAL(set.Hash(key), (uint64_t)0xcae227ec73d94aa5ull);
+	CHECK_EQUAL(set.GetVariantFile(key), std::string("PixelShader_cae227ec73d94aa5.cso"));
+
+	std::set<uint64_t> hashes;
+	for (uint32_t variant = 0; variant < set.GetVariantCount(); variant++) {
+		hashes.insert(set.Hash(set.GetKey(variant)));
+	}
+	CHECK_EQUAL(hashes.size(), (size_t)12);
+
+	//Same key, but the keyword's value changed
+	ShaderPermutationSet changed = set;
+	changed.Keywords[1].Values[2] = 3;
+	CHECK(changed.Hash(key) != set.Hash(key));
+
+	changed = set;
+	changed.Shader = "OtherShader";
+	CHECK(changed.Hash(key) != set.Hash(key));
+}
@@ -0,0 +1,223 @@
+#include "Test.h"
+
+#include <string>
+#include <vector>
+
+#include "../ShaderStructGenerator.h"
+
+// --------------------------------------------------------
+// Parses a block that's expected to be fine
+// --------------------------------------------------------
+static ShaderStruct ParseBlock(const std::string& source, const std::string& block, ShaderPacking packing) {
+	ShaderStruct layout;
+	std::string error;
+	bool parsed = ShaderStructGenerator::Parse(source.c_str(), source.size(), block, packing, layout, error);
+	CHECK(parsed);
+	if (!parsed) printf("  %s\n", error.c_str());
+	return layout;
+}
+
+static std::string ParseError(const std::string& source, const std::string& block, ShaderPacking packing) {
+	ShaderStruct layout;
+	std::string error;
+	CHECK(!ShaderStructGenerator::Parse(source.c_str(), source.size(), block, packing, layout, error));
+	return error;
+}
+
+static void CheckField(const ShaderStruct& layout, size_t index, const char* name, unsigned int offset, unsigned int size) {
+	CHECK(index < layout.Fields.size());
+	if (index >= layout.Fields.size()) return;
+
+	const ShaderField& field = layout.Fields[index];
+	CHECK(field.Name == name);
+	CHECK_EQUAL(field.Offset, offset);
+	CHECK_EQUAL(field.Size, size);
+}
+
+TEST(ShaderStructGeneratorParseType) {
+	ShaderField field = {};
+	CHECK(ShaderStructGenerator::ParseType("float3", field));
+	CHECK(field.Type == ShaderScalarType::Float && field.Rows == 1 && field.Columns == 3);
+	CHECK(ShaderStructGenerator::ParseType("uint2", field));
+	CHECK(field.Type == ShaderScalarType::UInt && field.Columns == 2);
+	CHECK(ShaderStructGenerator::ParseType("float3x4", field));
+	CHECK(field.Rows == 3 && field.Columns == 4);
+	CHECK(ShaderStructGenerator::ParseType("matrix", field));
+	CHECK(field.Rows == 4 && field.Columns == 4);
+	CHECK(ShaderStructGenerator::ParseType("bool", field));
+	CHECK(field.Type == ShaderScalarType::Bool);
+
+	CHECK(!ShaderStructGenerator::ParseType("float5", field));
+	CHECK(!ShaderStructGenerator::ParseType("half4", field));
+	CHECK(!ShaderStructGenerator::ParseType("float4x", field));
+}
+
+// --------------------------------------------------------
+// Fields share a register until the next one would cross
+// its 16 byte boundary
+// --------------------------------------------------------
+TEST(ShaderStructGeneratorRegisterBoundaries) {
+	ShaderStruct layout = ParseBlock(
+		"cbuffer Data : register(b0) {\n"
+		"	float a;\n"
+		"	float3 b;	// Fills the rest of a's register\n"
+		"	float3 c;\n"
+		"	float2 d;	// Would cross, so moves on\n"
+		"	float e;\n"
+		"	float4 f;	// Would cross, so moves on\n"
+		"	int2 g;\n"
+		"	bool h;\n"
+		"};\n", "Data", ShaderPacking::ConstantBuffer);
+
+	CHECK_EQUAL(layout.Fields.size(), (size_t)8);
+	CheckField(layout, 0, "a", 0, 4);
+	CheckField(layout, 1, "b", 4, 12);
+	CheckField(layout, 2, "c", 16, 12);
+	CheckField(layout, 3, "d", 32, 8);
+	CheckField(layout, 4, "e", 40, 4);
+	CheckField(layout, 5, "f", 48, 16);
+	CheckField(layout, 6, "g", 64, 8);
+	CheckField(layout, 7, "h", 72, 4);
+	CHECK_EQUAL(layout.Size, 80u);
+	CHECK(layout.Fields[1].Comment == "Fills the rest of a's register");
+}
+
+// --------------------------------------------------------
+// Arrays start a register and put each element in its own,
+// but the last one only takes what it needs
+// --------------------------------------------------------
+TEST(ShaderStructGeneratorArrays) {
+	ShaderStruct layout = ParseBlock(
+		"#define TAP_COUNT (RADIUS * 2 + 1)\n"
+		"#define RADIUS 2 // Either side\n"
+		"cbuffer Blur {\n"
+		"	float scalar;\n"
+		"	float weights[3];\n"
+		"	float behind;		// Packs into the last weight's register\n"
+		"	float2 offsets[TAP_COUNT];\n"
+		"	float4 colors[2];\n"
+		"};\n", "Blur", ShaderPacking::ConstantBuffer);
+
+	CheckField(layout, 0, "scalar", 0, 4);
+	CheckField(layout, 1, "weights", 16, 16 * 2 + 4);
+	CHECK_EQUAL(layout.Fields[1].Stride, 16u);
+	CHECK_EQUAL(layout.Fields[1].ArrayCount, 3u);
+	CheckField(layout, 2, "behind", 52, 4);
+	CheckField(layout, 3, "offsets", 64, 16 * 4 + 8);
+	CHECK_EQUAL(layout.Fields[3].ArrayCount, 5u);
+	CheckField(layout, 4, "colors", 144, 32);
+	CHECK_EQUAL(layout.Size, 176u);
+}
+
+// --------------------------------------------------------
+// Matrices start a register, with a register per column, or
+// per row when row_major
+// --------------------------------------------------------
+TEST(ShaderStructGeneratorMatrices) {
+	ShaderStruct layout = ParseBlock(
+		"cbuffer Matrices {\n"
+		"	float first;\n"
+		"	float4x4 world;\n"
+		"	float3x4 columns;	// Four registers of three\n"
+		"	float tail;			// Behind the last column\n"
+		"	row_major float3x4 rows;\n"
+		"	matrix more[2];\n"
+		"};\n", "Matrices", ShaderPacking::ConstantBuffer);
+
+	CheckField(layout, 0, "first", 0, 4);
+	CheckField(layout, 1, "world", 16, 64);
+	CheckField(layout, 2, "columns", 80, 16 * 3 + 12);
+	CheckField(layout, 3, "tail", 140, 4);
+	CheckField(layout, 4, "rows", 144, 48);
+	CHECK(layout.Fields[4].RowMajor);
+	CheckField(layout, 5, "more", 192, 128);
+	CHECK_EQUAL(layout.Fields[5].Stride, 64u);
+	CHECK_EQUAL(layout.Size, 320u);
+}
+
+TEST(ShaderStructGeneratorStructuredIsTight) {
+	ShaderStruct layout = ParseBlock(
+		"struct Particle {\n"
+		"	float3 position : POSITION;\n"
+		"	float age;\n"
+		"	float2 size;\n"
+		"	float3 velocity;\n"
+		"	uint flags;\n"
+		"};\n", "Particle", ShaderPacking::Structured);
+
+	CheckField(layout, 0, "position", 0, 12);
+	CheckField(layout, 1, "age", 12, 4);
+	CheckField(layout, 2, "size", 16, 8);
+	CheckField(layout, 3, "velocity", 24, 12);
+	CheckField(layout, 4, "flags", 36, 4);
+	CHECK_EQUAL(layout.Size, 40u);
+}
+
+// --------------------------------------------------------
+// The right block is found among others, past comments and
+// names that only start the same
+// --------------------------------------------------------
+TEST(ShaderStructGeneratorFindsBlock) {
+	ShaderStruct layout = ParseBlock(
+		"/* cbuffer Data { float wrong; }; */\n"
+		"cbuffer DataExtra { float4 wrong; };\n"
+		"mycbuffer Data { float4 wrong; };\n"
+		"cbuffer Data\n"
+		"{\n"
+		"	float right;\n"
+		"};\n", "Data", ShaderPacking::ConstantBuffer);
+
+	CHECK_EQUAL(layout.Fields.size(), (size_t)1);
+	CheckField(layout, 0, "right", 0, 4);
+}
+
+TEST(ShaderStructGeneratorParseErrors) {
+	CHECK(ParseError("cbuffer A { float4 x; };", "B", ShaderPacking::ConstantBuffer).find("No cbuffer B") != std::string::npos);
+	CHECK(ParseError("cbuffer A { float4 x : packoffset(c0); };", "A", ShaderPacking::ConstantBuffer).find("packoffset") != std::string::npos);
+	CHECK(ParseError("cbuffer A { float x, y; };", "A", ShaderPacking::ConstantBuffer).find("one field") != std::string::npos);
+	CHECK(ParseError("cbuffer A { float x[COUNT]; };", "A", ShaderPacking::ConstantBuffer).find("COUNT") != std::string::npos);
+	CHECK(ParseError("#define LOOP LOOP\ncbuffer A { float x[LOOP]; };", "A", ShaderPacking::ConstantBuffer).find("LOOP") != std::string::npos);
+	CHECK(ParseError("cbuffer A { half x; };", "A", ShaderPacking::ConstantBuffer).find("half") != std::string::npos);
+	CHECK(ParseError("cbuffer A { float x };", "A", ShaderPacking::ConstantBuffer).find("Missing ;") != std::string::npos);
+	CHECK(ParseError("struct A { struct B { float x; } b; };", "A", ShaderPacking::Structured).find("nested") != std::string::npos);
+}
+
+// --------------------------------------------------------
+// Gaps become padding, and layouts C++ can't mirror are
+// refused rather than generated wrong
+// --------------------------------------------------------
+TEST(ShaderStructGeneratorGenerate) {
+	ShaderStructSchema schema = { "Test.hlsl", "Data", ShaderPacking::ConstantBuffer, "TestConstants" };
+	std::string code, error;
+
+	ShaderStruct padded = ParseBlock("cbuffer Data { float a; float4 b; float2 c; };", "Data", ShaderPacking::ConstantBuffer);
+	CHECK(ShaderStructGenerator::GenerateStruct(padded, schema, code, error));
+	CHECK(code.find("\tfloat a;\n\tfloat padding0[3];\n\tDirectX::XMFLOAT4 b;\n\tDirectX::XMFLOAT2 c;\n\tfloat padding1[2];\n") != std::string::npos);
+	CHECK(code.find("static_assert(sizeof(TestConstants) == 48") != std::string::npos);
+	CHECK(code.find("{ \"b\", 16, 16 }") != std::string::npos);
+
+	ShaderStruct scalarArray = ParseBlock("cbuffer Data { float weights[4]; };", "Data", ShaderPacking::ConstantBuffer);
+	CHECK(!ShaderStructGenerator::GenerateStruct(scalarArray, schema, code, error));
+	CHECK(error.find("16 bytes") != std::string::npos);
+
+	ShaderStruct smallMatrix = ParseBlock("cbuffer Data { float3x3 rotation; };", "Data", ShaderPacking::ConstantBuffer);
+	CHECK(!ShaderStructGenerator::GenerateStruct(smallMatrix, schema, code, error));
+	CHECK(error.find("4x4") != std::string::npos);
+}
+
+TEST(ShaderStructGeneratorValidate) {
+	const ShaderFieldOffset expected[] = { { "a", 0, 4 }, { "b", 16, 16 } };
+	std::string error;
+
+	CHECK(ShaderStructGenerator::Validate(expected, 2, { { "b", 16, 16 }, { "a", 0, 4 } }, error));
+	CHECK(error.empty());
+
+	CHECK(!ShaderStructGenerator::Validate(expected, 2, { { "a", 0, 4 }, { "b", 4, 16 } }, error));
+	CHECK(error.find("b is 16 bytes at 4") != std::string::npos);
+
+	CHECK(!ShaderStructGenerator::Validate(expected, 2, { { "a", 0, 4 }, { "b", 16, 16 }, { "c", 32, 4 } }, error));
+	CHECK(error.find("c is in the shader") != std::string::npos);
+
+	CHECK(!ShaderStructGenerator::Validate(expected, 2, { { "a", 0, 4 } }, error));
+	CHECK(error.find("b isn't in the shader") != std::string::npos);
+}
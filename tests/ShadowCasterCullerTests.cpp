@@ -0,0 +1,136 @@
+#include "Test.h"
+
+#include "../ShadowCasterCuller.h"
+
+// --------------------------------------------------------
+// Row major view matrix for a light at position, with its
+// axes given in world space
+//  - Rows of the rotation are the axes' components, and the
+//     translation puts the position at the origin
+// --------------------------------------------------------
+static void MakeLightView(const float position[3], const float right[3], const float up[3], const float forward[3], float view[16]) {
+	const float* axes[3] = { right, up, forward };
+	for (int k = 0; k < 3; k++) {
+		for (int j = 0; j < 3; j++) view[j * 4 + k] = axes[k][j];
+		view[k * 4 + 3] = 0.0f;
+		view[12 + k] = -(position[0] * axes[k][0] + position[1] * axes[k][1] + position[2] * axes[k][2]);
+	}
+	view[15] = 1.0f;
+}
+
+// A box from x, y and z between min and max
+static SceneBvhFrustum MakeBoxFrustum(const float min[3], const float max[3]) {
+	SceneBvhFrustum frustum = {};
+	for (int axis = 0; axis < 3; axis++) {
+		frustum.Planes[axis * 2][axis] = 1.0f;
+		frustum.Planes[axis * 2][3] = -min[axis];
+		frustum.Planes[axis * 2 + 1][axis] = -1.0f;
+		frustum.Planes[axis * 2 + 1][3] = max[axis];
+	}
+	return frustum;
+}
+
+// --------------------------------------------------------
+// A light looking down world z from the origin covers a box
+// in front of it, size wide and from near to far deep
+// --------------------------------------------------------
+TEST(ShadowCasterCullerAlignedVolume) {
+	const float position[3] = { 0.0f, 0.0f, 0.0f };
+	const float right[3] = { 1.0f, 0.0f, 0.0f };
+	const float up[3] = { 0.0f, 1.0f, 0.0f };
+	const float forward[3] = { 0.0f, 0.0f, 1.0f };
+	float view[16];
+	MakeLightView(position, right, up, forward, view);
+
+	ShadowCasterCuller culler;
+	culler.SetLightVolume(view, 4.0f, 1.0f, 10.0f);
+
+	const float extents[3] = { 0.5f, 0.5f, 0.5f };
+	const float inside[3] = { 0.0f, 0.0f, 5.0f };
+	const float straddling[3] = { 2.4f, 0.0f, 5.0f };
+	const float beside[3] = { 2.6f, 0.0f, 5.0f };
+	const float behind[3] = { 0.0f, 0.0f, 0.4f };
+	const float beyond[3] = { 0.0f, 0.0f, 10.6f };
+
+	CHECK(culler.IsVisible(inside, extents));
+	CHECK(culler.IsVisible(straddling, extents));
+	CHECK(!culler.IsVisible(beside, extents));
+	CHECK(!culler.IsVisible(behind, extents));
+	CHECK(!culler.IsVisible(beyond, extents));
+}
+
+// --------------------------------------------------------
+// A light turned 45 degrees, away from the origin
+//  - The corner box is inside the volume's world space
+//     bounding box but well outside the volume itself, so
+//     only the exact test culls it
+// --------------------------------------------------------
+TEST(ShadowCasterCullerRotatedVolume) {
+	const float s = 0.70710678f;
+	const float position[3] = { -s * 2.0f, 3.0f, -s * 2.0f };
+	const float right[3] = { s, 0.0f, -s };
+	const float up[3] = { 0.0f, 1.0f, 0.0f };
+	const float forward[3] = { s, 0.0f, s };
+	float view[16];
+	MakeLightView(position, right, up, forward, view);
+
+	ShadowCasterCuller culler;
+	culler.SetLightVolume(view, 2.0f, 0.0f, 14.0f);
+
+	const float extents[3] = { 0.1f, 0.1f, 0.1f };
+	const float onAxis[3] = { s * 5.0f, 3.0f, s * 5.0f };
+	const float nearEdge[3] = { s * 5.0f + 0.6f, 3.0f, s * 5.0f - 0.6f };
+	const float corner[3] = { 4.0f, 3.0f, 0.0f };
+	const float below[3] = { s * 5.0f, 1.5f, s * 5.0f };
+
+	CHECK(culler.IsVisible(onAxis, extents));
+	CHECK(culler.IsVisible(nearEdge, extents));
+	CHECK(!culler.IsVisible(corner, extents));
+	CHECK(!culler.IsVisible(below, extents));
+
+	//A big enough box reaches it from the corner
+	const float bigExtents[3] = { 1.5f, 0.1f, 1.5f };
+	CHECK(culler.IsVisible(corner, bigExtents));
+}
+
+// --------------------------------------------------------
+// A light shining straight down onto a box shaped view
+//  - Casters above the view shadow it, even though they're
+//     outside it, while ones beside or under it can't
+// --------------------------------------------------------
+TEST(ShadowCasterCullerReceivers) {
+	const float position[3] = { 0.0f, 50.0f, 0.0f };
+	const float right[3] = { 1.0f, 0.0f, 0.0f };
+	const float up[3] = { 0.0f, 0.0f, 1.0f };
+	const float forward[3] = { 0.0f, -1.0f, 0.0f };
+	float view[16];
+	MakeLightView(position, right, up, forward, view);
+
+	ShadowCasterCuller culler;
+	culler.SetLightVolume(view, 100.0f, 0.0f, 100.0f);
+
+	const float viewMin[3] = { -1.0f, -1.0f, 0.0f };
+	const float viewMax[3] = { 1.0f, 1.0f, 10.0f };
+	const float down[3] = { 0.0f, -1.0f, 0.0f };
+	culler.SetReceivers(MakeBoxFrustum(viewMin, viewMax), down, 100.0f);
+
+	const float extents[3] = { 0.5f, 0.5f, 0.5f };
+	const float inside[3] = { 0.0f, 0.0f, 5.0f };
+	const float above[3] = { 0.0f, 20.0f, 5.0f };
+	const float aboveBeside[3] = { 5.0f, 20.0f, 5.0f };
+	const float below[3] = { 0.0f, -20.0f, 5.0f };
+
+	CHECK(culler.IsVisible(inside, extents));
+	CHECK(culler.IsVisible(above, extents));
+	CHECK(!culler.IsVisible(aboveBeside, extents));
+	CHECK(!culler.IsVisible(below, extents));
+
+	//Too short a shadow doesn't reach
+	culler.SetReceivers(MakeBoxFrustum(viewMin, viewMax), down, 10.0f);
+	CHECK(!culler.IsVisible(above, extents));
+
+	//Without receivers only the light's volume matters
+	culler.ClearReceivers();
+	CHECK(culler.IsVisible(below, extents));
+	CHECK(culler.IsVisible(aboveBeside, extents));
+}
@@ -0,0 +1,246 @@
+#include "Test.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "../SoftwareCoverage.h"
+
+// Pixels whose centers are closer than this to an edge, in
+// pixels, may go either way between float and double
+#define COVERAGE_EDGE_SLACK 1e-3
+
+// --------------------------------------------------------
+// Whether a pixel center is inside the triangle, worked out
+// from scratch in double precision
+//  - Also gives how far the center is from the nearest edge
+// --------------------------------------------------------
+static bool ReferenceCovers(const float* x, const float* y, int px, int py, double& edgeDistance) {
+	double cx = px + 0.5, cy = py + 0.5;
+	double area = ((double)x[1] - x[0]) * ((double)y[2] - y[0]) - ((double)x[2] - x[0]) * ((double)y[1] - y[0]);
+
+	bool inside = true;
+	edgeDistance = 1e30;
+	for (int i = 0; i < 3; i++) {
+		int j = (i + 1) % 3;
+		int k = (i + 2) % 3;
+		double ex = (double)x[k] - x[j], ey = (double)y[k] - y[j];
+		double edge = (ex * (cy - y[j]) - ey * (cx - x[j])) / area;
+
+		inside &= edge >= 0.0;
+		edgeDistance = (std::min)(edgeDistance, std::fabs(edge * area) / std::sqrt(ex * ex + ey * ey));
+	}
+
+	return inside;
+}
+
+// --------------------------------------------------------
+// Adds one to every pixel the triangle covers, the way the
+// rasterizer walks it, and checks the barycentrics and
+// depth at each one
+// --------------------------------------------------------
+static bool Rasterize(const float* x, const float* y, const float* z, int width, int height, std::vector<int>& coverage) {
+	CoverageTriangle triangle;
+	if (!SoftwareCoverage::Setup(x, y, z, width, height, triangle)) return false;
+
+	CHECK(triangle.MinX >= 0 && triangle.MaxX < width);
+	CHECK(triangle.MinY >= 0 && triangle.MaxY < height);
+
+	SoftwareCoverage quads(triangle);
+	for (int py = triangle.MinY; py <= triangle.MaxY; py++) {
+		for (int px = triangle.MinX & ~3; px <= triangle.MaxX; px += 4) {
+			__m128 b[3];
+			int mask = _mm_movemask_ps(quads.TestQuad(px, py, b));
+
+			alignas(16) float b0[4], b1[4], b2[4];
+			_mm_store_ps(b0, b[0]);
+			_mm_store_ps(b1, b[1]);
+			_mm_store_ps(b2, b[2]);
+
+			for (int lane = 0; lane < 4; lane++) {
+				if (!(mask & (1 << lane))) continue;
+				coverage[(size_t)py * width + px + lane]++;
+
+				CHECK_NEAR(b0[lane] + b1[lane] + b2[lane], 1.0, 1e-4);
+				float depth = b0[lane] * z[0] + b1[lane] * z[1] + b2[lane] * z[2];
+				CHECK(depth >= triangle.MinZ - 1e-4f);
+				CHECK(depth <= (std::max)({ z[0], z[1], z[2] }) + 1e-4f);
+			}
+		}
+	}
+
+	return true;
+}
+
+// --------------------------------------------------------
+// Random clockwise triangle, some of them hanging off the
+// screen
+// --------------------------------------------------------
+static void RandomTriangle(std::mt19937& random, int width, int height, float* x, float* y, float* z) {
+	std::uniform_real_distribution<float> across(-0.2f * width, 1.2f * width);
+	std::uniform_real_distribution<float> down(-0.2f * height, 1.2f * height);
+	std::uniform_real_distribution<float> depth(0.0f, 1.0f);
+
+	for (int v = 0; v < 3; v++) {
+		x[v] = across(random);
+		y[v] = down(random);
+		z[v] = depth(random);
+	}
+
+	float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	if (area < 0.0f) {
+		std::swap(x[1], x[2]);
+		std::swap(y[1], y[2]);
+		std::swap(z[1], z[2]);
+	}
+}
+
+// --------------------------------------------------------
+// Every pixel matches the reference, apart from centers
+// right on an edge
+// --------------------------------------------------------
+TEST(SoftwareCoverageMatchesReference) {
+	const int width = 67, height = 45;
+	std::mt19937 random(38);
+
+	int drawn = 0, covered = 0, wrong = 0;
+	for (int t = 0; t < 400; t++) {
+		float x[3], y[3], z[3];
+		RandomTriangle(random, width, height, x, y, z);
+
+		std::vector<int> coverage((size_t)width * height, 0);
+		if (Rasterize(x, y, z, width, height, coverage)) drawn++;
+
+		for (int py = 0; py < height; py++) {
+			for (int px = 0; px < width; px++) {
+				double edgeDistance;
+				bool expected = ReferenceCovers(x, y, px, py, edgeDistance);
+				int got = coverage[(size_t)py * width + px];
+
+				CHECK(got <= 1);
+				if (expected) covered++;
+				if ((got == 1) != expected && edgeDistance > COVERAGE_EDGE_SLACK) wrong++;
+			}
+		}
+	}
+
+	CHECK_EQUAL(wrong, 0);
+	CHECK(drawn > 300);
+	CHECK(covered > 10000);
+}
+
+// --------------------------------------------------------
+// A mesh covering the screen leaves no pixel out, and only
+// draws twice along shared edges
+// --------------------------------------------------------
+TEST(SoftwareCoverageWatertight) {
+	const int width = 64, height = 48;
+	const int cellsX = 7, cellsY = 5;
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> jitter(-0.35f, 0.35f);
+
+	//Grid corners, jittered inside, with the outer ones on the screen's edges
+	std::vector<float> cornerX((cellsX + 1) * (cellsY + 1)), cornerY(cornerX.size());
+	for (int cy = 0; cy <= cellsY; cy++) {
+		for (int cx = 0; cx <= cellsX; cx++) {
+			bool insideX = cx > 0 && cx < cellsX, insideY = cy > 0 && cy < cellsY;
+			cornerX[cy * (cellsX + 1) + cx] = (cx + (insideX ? jitter(random) : 0.0f)) * width / cellsX;
+			cornerY[cy * (cellsX + 1) + cx] = (cy + (insideY ? jitter(random) : 0.0f)) * height / cellsY;
+		}
+	}
+
+	std::vector<int> coverage((size_t)width * height, 0);
+	for (int cy = 0; cy < cellsY; cy++) {
+		for (int cx = 0; cx < cellsX; cx++) {
+			int a = cy * (cellsX + 1) + cx, b = a + 1, c = a + cellsX + 1, d = c + 1;
+
+			//Clockwise on screen, with y down
+			int triangles[2][3] = { { a, b, d }, { a, d, c } };
+			for (int (&corners)[3] : triangles) {
+				float x[3], y[3], z[3] = { 0.5f, 0.5f, 0.5f };
+				for (int v = 0; v < 3; v++) {
+					x[v] = cornerX[corners[v]];
+					y[v] = cornerY[corners[v]];
+				}
+				CHECK(Rasterize(x, y, z, width, height, coverage));
+			}
+		}
+	}
+
+	int gaps = 0, overdrawn = 0;
+	for (int count : coverage) {
+		if (count == 0) gaps++;
+		if (count > 1) overdrawn++;
+	}
+
+	CHECK_EQUAL(gaps, 0);
+	CHECK(overdrawn < width * height / 100);
+}
+
+// --------------------------------------------------------
+// Back facing, empty and off screen triangles are culled,
+// and bounds are clamped to the screen
+// --------------------------------------------------------
+TEST(SoftwareCoverageCulling) {
+	float z[3] = { 0.1f, 0.2f, 0.3f };
+	CoverageTriangle triangle;
+
+	float clockwiseX[3] = { 10.0f, 30.0f, 10.0f }, clockwiseY[3] = { 10.0f, 10.0f, 30.0f };
+	CHECK(SoftwareCoverage::Setup(clockwiseX, clockwiseY, z, 64, 64, triangle));
+	CHECK_EQUAL(triangle.MinX, 10);
+	CHECK_EQUAL(triangle.MaxY, 30);
+	CHECK_NEAR(triangle.MinZ, 0.1f, 1e-7);
+
+	float backX[3] = { 10.0f, 10.0f, 30.0f }, backY[3] = { 10.0f, 30.0f, 10.0f };
+	CHECK(!SoftwareCoverage::Setup(backX, backY, z, 64, 64, triangle));
+
+	float lineX[3] = { 0.0f, 10.0f, 20.0f }, lineY[3] = { 0.0f, 10.0f, 20.0f };
+	CHECK(!SoftwareCoverage::Setup(lineX, lineY, z, 64, 64, triangle));
+
+	float offX[3] = { 70.0f, 90.0f, 70.0f }, offY[3] = { 10.0f, 10.0f, 30.0f };
+	CHECK(!SoftwareCoverage::Setup(offX, offY, z, 64, 64, triangle));
+
+	float bigX[3] = { -100.0f, 200.0f, -100.0f }, bigY[3] = { -100.0f, -100.0f, 200.0f };
+	CHECK(SoftwareCoverage::Setup(bigX, bigY, z, 64, 48, triangle));
+	CHECK_EQUAL(triangle.MinX, 0);
+	CHECK_EQUAL(triangle.MinY, 0);
+	CHECK_EQUAL(triangle.MaxX, 63);
+	CHECK_EQUAL(triangle.MaxY, 47);
+}
+
+// --------------------------------------------------------
+// The tile and block test never throws away a rectangle
+// with covered pixels in it
+// --------------------------------------------------------
+TEST(SoftwareCoverageTouchesRect) {
+	const int width = 64, height = 64, block = 8;
+	std::mt19937 random(1);
+
+	int rejected = 0, wrong = 0;
+	for (int t = 0; t < 200; t++) {
+		float x[3], y[3], z[3];
+		RandomTriangle(random, width, height, x, y, z);
+
+		std::vector<int> coverage((size_t)width * height, 0);
+		CoverageTriangle triangle;
+		if (!SoftwareCoverage::Setup(x, y, z, width, height, triangle)) continue;
+		Rasterize(x, y, z, width, height, coverage);
+
+		for (int by = 0; by < height; by += block) {
+			for (int bx = 0; bx < width; bx += block) {
+				bool any = false;
+				for (int py = by; py < by + block; py++) {
+					for (int px = bx; px < bx + block; px++) any |= coverage[(size_t)py * width + px] > 0;
+				}
+
+				bool touches = SoftwareCoverage::TouchesRect(triangle, bx + 0.5f, by + 0.5f, bx + block - 0.5f, by + block - 0.5f);
+				if (any && !touches) wrong++;
+				if (!touches) rejected++;
+			}
+		}
+	}
+
+	CHECK_EQUAL(wrong, 0);
+	CHECK(rejected > 0);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+// --------------------------------------------------------
+// Just enough of a test framework for the platform neutral
+// parts of the engine
+//
+// - TEST(Name) registers a function, and the runner picks
+//    them by the start of their names, so each module's
+//    tests share a prefix and get their own CTest entry
+// - Failed checks print where they were and carry on, so
+//    one run shows everything that's wrong
+// --------------------------------------------------------
+struct TestCase {
+	const char* Name;
+	void (*Run)();
+};
+
+std::vector<TestCase>& GetTestCases();
+void ReportFailure(const char* file, int line, const char* expression);
+
+struct TestRegistration {
+	TestRegistration(const char* name, void (*run)()) {
+		GetTestCases().push_back(TestCase{ name, run });
+	}
+};
+
+#define TEST(name) \
+	static void name(); \
+	static TestRegistration name##Registration(#name, name); \
+	static void name()
+
+#define CHECK(expression) \
+	do { if (!(expression)) ReportFailure(__FILE__, __LINE__, #expression); } while (0)
+
+#define CHECK_EQUAL(a, b) CHECK((a) == (b))
+
+#define CHECK_NEAR(a, b, tolerance) CHECK(std::fabs((double)(a) - (double)(b)) <= (double)(tolerance))
@@ -0,0 +1,39 @@
+#include "Test.h"
+
+#include <cstring>
+
+static int failures = 0;
+
+std::vector<TestCase>& GetTestCases() {
+	static std::vector<TestCase> cases;
+	return cases;
+}
+
+void ReportFailure(const char* file, int line, const char* expression) {
+	printf("  %s(%d): CHECK(%s) failed\n", file, line, expression);
+	failures++;
+}
+
+// --------------------------------------------------------
+// Runs every test whose name starts with the first argument,
+// or every test with no argument
+// --------------------------------------------------------
+int main(int argc, char** argv) {
+	setvbuf(stdout, 0, _IONBF, 0);
+	const char* prefix = argc > 1 ? argv[1] : "";
+
+	int run = 0;
+	int failed = 0;
+	for (const TestCase& test : GetTestCases()) {
+		if (strncmp(test.Name, prefix, strlen(prefix)) != 0) continue;
+
+		int before = failures;
+		printf("%s\n", test.Name);
+		test.Run();
+		run++;
+		if (failures != before) failed++;
+	}
+
+	printf("%d tests, %d failed\n", run, failed);
+	return (run == 0 || failed > 0) ? 1 : 0;
+}
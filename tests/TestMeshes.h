@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "../MeshBvh.h"
+
+// --------------------------------------------------------
+// A UV sphere's triangles, for casting rays at without
+// loading any model files
+//  - Rings go from pole to pole, so the first and last rows
+//     of triangles each have a corner squashed to a point
+// --------------------------------------------------------
+inline std::shared_ptr<MeshBvh> MakeSphereBvh(unsigned int rings, unsigned int segments, float radius) {
+	std::vector<float> positions;
+	for (unsigned int ring = 0; ring <= rings; ring++) {
+		float theta = 3.14159265f * ring / rings;
+		for (unsigned int segment = 0; segment <= segments; segment++) {
+			float phi = 6.28318531f * segment / segments;
+			positions.push_back(radius * sinf(theta) * cosf(phi));
+			positions.push_back(radius * cosf(theta));
+			positions.push_back(radius * sinf(theta) * sinf(phi));
+		}
+	}
+
+	std::vector<unsigned int> indices;
+	for (unsigned int ring = 0; ring < rings; ring++) {
+		for (unsigned int segment = 0; segment < segments; segment++) {
+			unsigned int a = ring * (segments + 1) + segment;
+			unsigned int b = a + segments + 1;
+			unsigned int quad[6] = { a, b, a + 1, a + 1, b, b + 1 };
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+
+	return std::make_shared<MeshBvh>(positions.data(), sizeof(float) * 3, indices.data(), indices.size());
+}
@@ -0,0 +1,149 @@
+#include "Test.h"
+
+#include <random>
+#include <vector>
+
+#include "../MeshBvh.h"
+#include "../TransformBatch.h"
+
+#define TEST_TRANSFORMS 37	// Not a multiple of any width, so every path has a tail
+
+// --------------------------------------------------------
+// Random transforms and boxes, with unit quaternions
+// --------------------------------------------------------
+static void MakeStreams(unsigned int seed, TransformStreams& transforms, BoundsStreams& bounds) {
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> scale(0.25f, 4.0f);
+
+	transforms.Resize(TEST_TRANSFORMS);
+	bounds.Resize(TEST_TRANSFORMS);
+	for (size_t i = 0; i < TEST_TRANSFORMS; i++) {
+		float q[4] = { unit(random), unit(random), unit(random), unit(random) };
+		float length = sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+		for (float& c : q) c /= length;
+
+		float p[3] = { position(random), position(random), position(random) };
+		float s[3] = { scale(random), scale(random), scale(random) };
+		transforms.Set(i, p, q, s);
+
+		float center[3] = { unit(random), unit(random), unit(random) };
+		float extents[3] = { scale(random), scale(random), scale(random) };
+		bounds.Set(i, center, extents);
+	}
+}
+
+static void CheckStreamsNear(const std::vector<float>& a, const std::vector<float>& b, float tolerance) {
+	CHECK_EQUAL(a.size(), b.size());
+	for (size_t i = 0; i < a.size() && i < b.size(); i++) {
+		CHECK_NEAR(a[i], b[i], tolerance * (std::max)(1.0f, fabsf(a[i])));
+	}
+}
+
+// --------------------------------------------------------
+// The path starts as the widest one the CPU runs, and paths
+// it can't run are refused
+// --------------------------------------------------------
+TEST(TransformBatchDetectedPath) {
+	MathPath best = TransformBatch::GetBestPath();
+	CHECK(TransformBatch::IsPathAvailable(best));
+	CHECK(TransformBatch::GetPath() == best);
+	CHECK(TransformBatch::IsPathAvailable(MathPath::Scalar));
+	if (TransformBatch::IsPathAvailable(MathPath::AVX2)) CHECK(best == MathPath::AVX2);
+
+	for (int i = 0; i < (int)MathPath::Count; i++) {
+		TransformBatch::SetPath((MathPath)i);
+		CHECK(TransformBatch::GetPath() == (TransformBatch::IsPathAvailable((MathPath)i) ? (MathPath)i : MathPath::Scalar));
+		TransformBatch::SetPath(MathPath::Scalar);
+	}
+
+	TransformBatch::SetPath(best);
+}
+
+// --------------------------------------------------------
+// Every path this CPU runs builds the same matrices, bounds
+// and blends as the scalar kernel
+// --------------------------------------------------------
+TEST(TransformBatchPathsMatchScalar) {
+	TransformStreams previous, current, expectedBlend, blended;
+	BoundsStreams local, expectedBounds, bounds;
+	MakeStreams(1, previous, local);
+	MakeStreams(2, current, local);
+	expectedBlend.Resize(TEST_TRANSFORMS);
+	blended.Resize(TEST_TRANSFORMS);
+	expectedBounds.Resize(TEST_TRANSFORMS);
+	bounds.Resize(TEST_TRANSFORMS);
+
+	const float view[16] = {
+		0.0f, 0.0f, 1.0f, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		-1.0f, 0.0f, 0.0f, 0.0f,
+		3.0f, -2.0f, 10.0f, 1.0f
+	};
+
+	std::vector<float> expectedWorld(TEST_TRANSFORMS * 16), world(TEST_TRANSFORMS * 16);
+	std::vector<float> expectedInverse(TEST_TRANSFORMS * 16), inverse(TEST_TRANSFORMS * 16);
+	TransformBatchInput input = { &current, &local, view };
+
+	MathPath best = TransformBatch::GetBestPath();
+	TransformBatch::SetPath(MathPath::Scalar);
+	TransformBatch::Blend(previous, current, 0.3f, expectedBlend, 0, TEST_TRANSFORMS);
+	TransformBatch::Compute(input, TransformBatchOutput{ expectedWorld.data(), expectedInverse.data(), &expectedBounds }, 0, TEST_TRANSFORMS);
+
+	for (int i = 0; i < (int)MathPath::Count; i++) {
+		MathPath path = (MathPath)i;
+		if (path == MathPath::Scalar || !TransformBatch::IsPathAvailable(path)) continue;
+
+		TransformBatch::SetPath(path);
+		TransformBatch::Blend(previous, current, 0.3f, blended, 0, TEST_TRANSFORMS);
+		TransformBatch::Compute(input, TransformBatchOutput{ world.data(), inverse.data(), &bounds }, 0, TEST_TRANSFORMS);
+
+		CheckStreamsNear(expectedBlend.PositionX, blended.PositionX, 1e-5f);
+		CheckStreamsNear(expectedBlend.RotationW, blended.RotationW, 1e-5f);
+		CheckStreamsNear(expectedBlend.ScaleZ, blended.ScaleZ, 1e-5f);
+		CheckStreamsNear(expectedWorld, world, 1e-5f);
+		CheckStreamsNear(expectedInverse, inverse, 1e-5f);
+		CheckStreamsNear(expectedBounds.CenterX, bounds.CenterX, 1e-5f);
+		CheckStreamsNear(expectedBounds.ExtentZ, bounds.ExtentZ, 1e-5f);
+	}
+
+	TransformBatch::SetPath(best);
+}
+
+// --------------------------------------------------------
+// Mesh rays hit the same triangles on every path, including
+// the AVX2 walk from its own file
+// --------------------------------------------------------
+TEST(TransformBatchRaycastPathsMatch) {
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> corner(-5.0f, 5.0f);
+
+	std::vector<float> positions(300 * 3);
+	for (float& p : positions) p = corner(random);
+	std::vector<unsigned int> indices(300);
+	for (unsigned int i = 0; i < 300; i++) indices[i] = i;
+	MeshBvh mesh(positions.data(), sizeof(float) * 3, indices.data(), indices.size());
+
+	unsigned int hits = 0;
+	for (int r = 0; r < 200; r++) {
+		float from[3] = { corner(random) * 2.0f, corner(random) * 2.0f, corner(random) * 2.0f };
+		float to[3] = { corner(random), corner(random), corner(random) };
+		float direction[3] = { to[0] - from[0], to[1] - from[1], to[2] - from[2] };
+		float length = sqrtf(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+		SceneBvhRay ray = { { from[0], from[1], from[2] }, { direction[0] / length, direction[1] / length, direction[2] / length }, 100.0f };
+
+		MeshBvhHit expected;
+		bool hit = mesh.RaycastAll(ray, expected);
+		if (hit) hits++;
+
+		for (int i = 0; i < (int)MathPath::Count; i++) {
+			MeshBvhHit pathHit;
+			CHECK_EQUAL(mesh.Raycast(ray, (MathPath)i, pathHit), hit);
+			if (hit) CHECK_NEAR(pathHit.Distance, expected.Distance, 1e-4f);
+		}
+	}
+
+	//Rays aim into the soup, so most should hit something
+	CHECK(hits > 100);
+}